@@ -0,0 +1,616 @@
+#include "MiloBenchmark.h"
+#include "milo/assets/models/loaders/AssimpModelLoader.h"
+#include "milo/assets/models/loaders/GltfModelLoader.h"
+#include "milo/math/BoundingVolumeFitting.h"
+#include <spdlog/sinks/basic_file_sink.h>
+#define JSON_USE_IMPLICIT_CONVERSIONS 0
+#include <json.hpp>
+#include <random>
+#include <cstring>
+#include <iostream>
+
+namespace milo {
+
+	using BenchmarkClock = std::chrono::high_resolution_clock;
+
+	static const char* STAGE_NAMES[] = {
+		"camera",
+		"lightEnvironment",
+		"shadowCascades",
+		"transforms",
+		"culling",
+		"collectDrawCommands",
+		"sortDrawCommands",
+		"prepareFrame"
+	};
+
+	static const float SCENE_HALF_EXTENT = 200.0f;
+
+	static inline double elapsedMillis(const TimePoint& start) {
+		return std::chrono::duration<double, std::milli>(BenchmarkClock::now() - start).count();
+	}
+
+	static inline double percentile(const ArrayList<double>& sortedSamples, double p) {
+		if(sortedSamples.empty()) return 0;
+		size_t index = (size_t)(p * (double)(sortedSamples.size() - 1) + 0.5);
+		return sortedSamples[std::min(index, sortedSamples.size() - 1)];
+	}
+
+	static void writeStats(nlohmann::json& s, ArrayList<double> samples) {
+
+		std::sort(samples.begin(), samples.end());
+
+		double sum = 0;
+		for(double sample : samples) sum += sample;
+
+		s["iterations"] = samples.size();
+		s["minMs"] = samples.empty() ? 0 : samples.front();
+		s["meanMs"] = samples.empty() ? 0 : sum / (double)samples.size();
+		s["p50Ms"] = percentile(samples, 0.50);
+		s["p90Ms"] = percentile(samples, 0.90);
+		s["p99Ms"] = percentile(samples, 0.99);
+		s["maxMs"] = samples.empty() ? 0 : samples.back();
+	}
+
+	MiloBenchmark::MiloBenchmark(BenchmarkConfig config) : m_Config(std::move(config)) {
+		for(uint32_t i = 0;i < StageCount;++i) {
+			m_Stages[i].name = STAGE_NAMES[i];
+			m_Stages[i].samples.reserve(m_Config.iterations);
+		}
+	}
+
+	MiloBenchmark::~MiloBenchmark() {
+		destroyScene();
+	}
+
+	String MiloBenchmark::run() {
+
+		Profiler::setEnabled(m_Config.profile);
+
+		checkAxisAlignedBoundingBoxes();
+
+		if(m_Config.logging) return runLogging();
+		if(!m_Config.model.empty()) return runModelImport();
+		// The editor camera is not available without a window
+		setSimulationState(SimulationState::Play);
+
+		createScene();
+
+		Log::info("Running {} warmup iterations and {} measured iterations over {} entities...",
+				  m_Config.warmupIterations, m_Config.iterations, m_Config.entities);
+
+		for(uint32_t i = 0;i < m_Config.warmupIterations;++i) {
+			runIteration(false);
+		}
+
+		for(uint32_t i = 0;i < m_Config.iterations;++i) {
+			runIteration(true);
+		}
+
+		return results();
+	}
+
+	void MiloBenchmark::createScene() {
+
+		m_Scene = SceneManager::activeScene();
+
+		std::mt19937 random(m_Config.seed);
+		std::uniform_real_distribution<float> position(-SCENE_HALF_EXTENT, SCENE_HALF_EXTENT);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		const uint32_t meshCount = std::max(m_Config.meshes, 1u);
+		m_Meshes.reserve(meshCount);
+		for(uint32_t i = 0;i < meshCount;++i) {
+			Mesh* mesh = new Mesh(str("BenchmarkMesh") + str(i));
+			auto* sphere = new BoundingSphere();
+			sphere->radius = 0.5f + unit(random) * 2.0f;
+			mesh->m_BoundingVolume = sphere;
+			m_Meshes.push_back(mesh);
+		}
+
+		const uint32_t materialCount = std::max(m_Config.materials, 1u);
+		m_Materials.reserve(materialCount);
+		for(uint32_t i = 0;i < materialCount;++i) {
+			String name = str("BenchmarkMaterial") + str(i);
+			m_Materials.push_back(new Material(name, name + ".mat"));
+		}
+
+		Entity cameraEntity = m_Scene->createEntity("Camera");
+		cameraEntity.getComponent<Transform>().translation({0, 20, SCENE_HALF_EXTENT});
+		Camera& camera = cameraEntity.addComponent<Camera>();
+		Size viewport = m_Scene->viewportSize();
+		camera.viewport({0, 0, (float)viewport.width, (float)viewport.height});
+		m_Scene->setMainCamera(cameraEntity.id());
+
+		Entity sun = m_Scene->createEntity("Sun");
+		DirectionalLight& dirLight = sun.addComponent<DirectionalLight>();
+		dirLight.direction = normalize(Vector3(-0.3f, -1.0f, -0.2f));
+
+		for(uint32_t i = 0;i < m_Config.pointLights;++i) {
+			Entity light = m_Scene->createEntity("PointLight");
+			light.getComponent<Transform>().translation({position(random), position(random) * 0.1f, position(random)});
+			PointLight& pointLight = light.addComponent<PointLight>();
+			pointLight.color = {unit(random), unit(random), unit(random), 1.0f};
+		}
+
+		const uint32_t depth = std::max(m_Config.hierarchyDepth, 1u);
+		EntityId parent = NULL_ENTITY;
+
+		for(uint32_t i = 0;i < m_Config.entities;++i) {
+
+			Entity entity = m_Scene->createEntity("Entity");
+
+			Transform& transform = entity.getComponent<Transform>();
+			if(i % depth == 0) {
+				transform.translation({position(random), position(random) * 0.1f, position(random)});
+			} else {
+				// Children are placed relative to their parents
+				transform.translation({unit(random), unit(random), unit(random)});
+				m_Scene->find(parent).addChild(entity.id());
+			}
+			transform.rotate(radians(unit(random) * 360.0f), {0, 1, 0});
+
+			MeshView meshView{m_Meshes[i % meshCount], m_Materials[(i / meshCount) % materialCount], true, i % 4 != 0};
+			entity.addComponent<MeshView>(meshView);
+
+			parent = entity.id();
+		}
+
+		m_ModelMatrices.resize(m_Config.entities);
+		m_ModelMeshes.resize(m_Config.entities);
+	}
+
+	void MiloBenchmark::destroyScene() {
+
+		// Entities are released along with the scene when the SceneManager shuts down
+		m_Scene = nullptr;
+
+		for(Mesh*& mesh : m_Meshes) DELETE_PTR(mesh);
+		m_Meshes.clear();
+
+		for(Material*& material : m_Materials) DELETE_PTR(material);
+		m_Materials.clear();
+	}
+
+	void MiloBenchmark::runIteration(bool record) {
+
+		FrameArena::beginFrame();
+
+		Array<double, StageCount> times{};
+		TimePoint start;
+
+		start = BenchmarkClock::now();
+		WorldRenderer::getCameraInfo(m_Scene, m_FrameData.camera);
+		times[CameraStage] = elapsedMillis(start);
+
+		start = BenchmarkClock::now();
+		WorldRenderer::generateLightEnvironment(m_Scene, m_FrameData);
+		times[LightEnvironmentStage] = elapsedMillis(start);
+
+		start = BenchmarkClock::now();
+		WorldRenderer::calculateShadowCascades(m_FrameData);
+		times[ShadowCascadesStage] = elapsedMillis(start);
+
+		// Transforms and culling are measured on their own, since collectDrawCommands interleaves them
+		auto components = m_Scene->group<Transform, MeshView>();
+
+		start = BenchmarkClock::now();
+		{
+			size_t index = 0;
+			for(EntityId entityId : components) {
+				m_ModelMatrices[index] = components.get<Transform>(entityId).modelMatrix();
+				m_ModelMeshes[index] = components.get<MeshView>(entityId).mesh;
+				++index;
+			}
+		}
+		times[TransformsStage] = elapsedMillis(start);
+
+		start = BenchmarkClock::now();
+		{
+			uint64_t visible = 0;
+			const Plane* planes = m_FrameData.camera.frustum.plane;
+			for(size_t i = 0;i < m_ModelMatrices.size();++i) {
+				if(m_ModelMeshes[i]->boundingVolume().isVisible(m_ModelMatrices[i], planes, 6)) ++visible;
+			}
+			m_VisibleCount = visible;
+		}
+		times[CullingStage] = elapsedMillis(start);
+
+		start = BenchmarkClock::now();
+		WorldRenderer::collectDrawCommands(m_Scene, m_FrameData);
+		times[CollectDrawCommandsStage] = elapsedMillis(start);
+
+		start = BenchmarkClock::now();
+		WorldRenderer::sortDrawCommands(m_FrameData);
+		times[SortDrawCommandsStage] = elapsedMillis(start);
+
+		start = BenchmarkClock::now();
+		WorldRenderer::prepareFrame(m_Scene, m_FrameData);
+		times[PrepareFrameStage] = elapsedMillis(start);
+
+		if(!record) return;
+
+		for(uint32_t i = 0;i < StageCount;++i) {
+			m_Stages[i].samples.push_back(times[i]);
+		}
+	}
+
+	String MiloBenchmark::results() const {
+
+		nlohmann::json json;
+
+		json["benchmark"] = "render_preparation";
+
+		nlohmann::json& config = json["config"];
+		config["entities"] = m_Config.entities;
+		config["pointLights"] = m_Config.pointLights;
+		config["hierarchyDepth"] = m_Config.hierarchyDepth;
+		config["materials"] = m_Config.materials;
+		config["meshes"] = m_Config.meshes;
+		config["warmupIterations"] = m_Config.warmupIterations;
+		config["iterations"] = m_Config.iterations;
+		config["seed"] = m_Config.seed;
+		config["profile"] = m_Config.profile;
+
+		nlohmann::json& stages = json["stages"];
+		for(const BenchmarkStage& stage : m_Stages) {
+			writeStats(stages[stage.name], stage.samples);
+		}
+
+		nlohmann::json& frame = json["frame"];
+		frame["drawCommands"] = m_FrameData.drawCommands.size();
+		frame["shadowDrawCommands"] = m_FrameData.shadowDrawCommands.size();
+		frame["pointLights"] = m_FrameData.lights.pointLights.size();
+		frame["visibleEntities"] = m_VisibleCount;
+		frame["frameArenaHighWaterMark"] = FrameArena::current().highWaterMark();
+
+		return json.dump(4);
+	}
+
+	// Checks the fitted volumes against a brute force pass over the vertices. Throws if any of them is wrong
+	static void checkBoundingVolumes(const Mesh* mesh, const PositionStream& positions) {
+
+		const AABB aabb = BoundingVolumeFitting::aabb(positions);
+		const OBB obb = BoundingVolumeFitting::obb(positions);
+		const BoundingSphere sphere = BoundingVolumeFitting::sphere(positions);
+
+		VertexList vertices(mesh->vertices(), mesh->indices());
+		if(vertices.size() == 0) return;
+
+		Vector3 vmin = vertices[0].position;
+		Vector3 vmax = vertices[0].position;
+		for(uint32_t i = 1;i < vertices.size();++i) {
+			vmin = glm::min(vmin, vertices[i].position);
+			vmax = glm::max(vmax, vertices[i].position);
+		}
+
+		if(aabb.center != (vmin + vmax) * 0.5f || aabb.size != (vmax - vmin) * 0.5f) {
+			throw MILO_RUNTIME_EXCEPTION(str("Wrong AABB for mesh ") + mesh->name());
+		}
+
+		const Vector3 extent = vmax - vmin;
+		const float epsilon = 1e-4f * (1.0f + std::max(extent.x, std::max(extent.y, extent.z)));
+
+		for(uint32_t i = 0;i < vertices.size();++i) {
+
+			const Vector3 p = vertices[i].position;
+
+			if(length(p - sphere.center) > sphere.radius + epsilon) {
+				throw MILO_RUNTIME_EXCEPTION(str("Vertex outside of the bounding sphere of mesh ") + mesh->name());
+			}
+
+			const Vector3 d = p - obb.center;
+			if(fabs(dot(d, obb.xAxis)) > obb.size.x * 0.5f + epsilon
+			   || fabs(dot(d, obb.yAxis)) > obb.size.y * 0.5f + epsilon
+			   || fabs(dot(d, obb.zAxis)) > obb.size.z * 0.5f + epsilon) {
+				throw MILO_RUNTIME_EXCEPTION(str("Vertex outside of the OBB of mesh ") + mesh->name());
+			}
+		}
+	}
+
+	void MiloBenchmark::checkAxisAlignedBoundingBoxes() {
+
+		struct AABBCase {
+			const char* name;
+			ArrayList<Vector3> positions;
+			Vector3 min;
+			Vector3 max;
+		};
+
+		ArrayList<AABBCase> cases;
+
+		cases.push_back({"AllNegative", {{-5, -3, -10}, {-1, -7, -2}, {-4, -1, -8}}, {-5, -7, -10}, {-1, -1, -2}});
+		cases.push_back({"SinglePoint", {{3, -2, 5}}, {3, -2, 5}, {3, -2, 5}});
+		cases.push_back({"Empty", {}, {0, 0, 0}, {0, 0, 0}});
+
+		// Vertex counts that leave a remainder after the vector lanes and after the parallel chunks,
+		// with the extremes placed in that remainder
+		for(uint32_t count : {13u, 2u * 32u * 1024u + 13u}) {
+			AABBCase c{count < 1024 ? "Remainder" : "ChunkedRemainder"};
+			c.positions.resize(count);
+			for(uint32_t i = 0;i < count;++i) {
+				const float t = (float)(i % 7) * 0.25f;
+				c.positions[i] = {t - 1.0f, 0.5f - t, t};
+			}
+			c.positions[count - 2] = {-20, 30, -40};
+			c.positions[count - 1] = {10, -50, 60};
+			c.min = {-20, -50, -40};
+			c.max = {10, 30, 60};
+			cases.push_back(std::move(c));
+		}
+
+		for(const AABBCase& c : cases) {
+
+			Mesh mesh(str("AABBCheck") + c.name);
+			mesh.m_Vertices.resize(c.positions.size());
+			for(size_t i = 0;i < c.positions.size();++i) {
+				mesh.m_Vertices[i].position = c.positions[i];
+			}
+
+			const AABB aabb = AABB::of(&mesh);
+
+			if(aabb.center != (c.min + c.max) * 0.5f || aabb.size != (c.max - c.min) * 0.5f) {
+				throw MILO_RUNTIME_EXCEPTION(str("Wrong AABB for check ") + c.name);
+			}
+		}
+	}
+
+	String MiloBenchmark::runModelImport() {
+
+		struct ModelImporter {
+			const char* name;
+			Function<ArrayList<Mesh*>> import;
+			ArrayList<double> samples;
+			uint64_t meshes{0};
+			uint64_t vertices{0};
+			uint64_t indices{0};
+		};
+
+		const String& file = m_Config.model;
+
+		ModelImporter importers[] = {
+			{"assimp", [&]() {return AssimpModelLoader().importMeshes(file);}},
+			{"gltf", [&]() {return GltfModelLoader().importMeshes(file);}}
+		};
+
+		// Bounding volume fitting of the imported meshes, the part of the import that is not done by the loaders
+		ArrayList<double> boundsSamples;
+
+		Log::info("Importing {} {} times ({} warmup) with each loader...", file, m_Config.iterations, m_Config.warmupIterations);
+
+		for(uint32_t i = 0;i < m_Config.warmupIterations + m_Config.iterations;++i) {
+			// Interleaved, so both see the same state of the file cache
+			for(ModelImporter& importer : importers) {
+
+				TimePoint start = BenchmarkClock::now();
+				ArrayList<Mesh*> meshes = importer.import();
+				const double time = elapsedMillis(start);
+
+				if(i >= m_Config.warmupIterations) importer.samples.push_back(time);
+
+				if(&importer == &importers[0]) {
+					start = BenchmarkClock::now();
+					for(Mesh* mesh : meshes) {
+						BoundingVolumeFitting::obb(PositionStream::of(mesh->m_Vertices, mesh->m_Indices));
+					}
+					if(i >= m_Config.warmupIterations) boundsSamples.push_back(elapsedMillis(start));
+					if(i == 0) {
+						for(Mesh* mesh : meshes) {
+							checkBoundingVolumes(mesh, PositionStream::of(mesh->m_Vertices, mesh->m_Indices));
+						}
+					}
+				}
+
+				importer.meshes = meshes.size();
+				importer.vertices = 0;
+				importer.indices = 0;
+				for(Mesh* mesh : meshes) {
+					importer.vertices += mesh->m_Vertices.size();
+					importer.indices += mesh->m_Indices.size();
+					DELETE_PTR(mesh);
+				}
+			}
+		}
+
+		nlohmann::json json;
+
+		json["benchmark"] = "model_import";
+
+		nlohmann::json& config = json["config"];
+		config["model"] = file;
+		config["warmupIterations"] = m_Config.warmupIterations;
+		config["iterations"] = m_Config.iterations;
+
+		for(const ModelImporter& importer : importers) {
+			writeStats(json["stages"][importer.name], importer.samples);
+			nlohmann::json& output = json["output"][importer.name];
+			output["meshes"] = importer.meshes;
+			output["vertices"] = importer.vertices;
+			output["indices"] = importer.indices;
+		}
+
+		writeStats(json["stages"]["bounds"], boundsSamples);
+
+		const double assimpMean = json["stages"]["assimp"]["meanMs"].get<double>();
+		const double gltfMean = json["stages"]["gltf"]["meanMs"].get<double>();
+		json["speedup"] = gltfMean > 0 ? assimpMean / gltfMean : 0;
+
+		return json.dump(4);
+	}
+
+	String MiloBenchmark::runLogging() {
+
+		struct LoggingMode {
+			const char* name;
+			bool async;
+			Log::OverflowPolicy policy;
+			bool binary;
+			ArrayList<double> samples;
+			double totalMs{0};
+			uint64_t dropped{0};
+		};
+
+		LoggingMode modes[] = {
+			{"sync", false, Log::OverflowPolicy::Block, false},
+			{"asyncDrop", true, Log::OverflowPolicy::Drop, false},
+			{"asyncBlock", true, Log::OverflowPolicy::Block, false},
+			{"asyncBlockBinary", true, Log::OverflowPolicy::Block, true}
+		};
+
+		const String textFile = "milo_bench_log.txt";
+		const String binaryFile = "milo_bench_log.mlog";
+		const uint32_t threadCount = std::max(m_Config.logThreads, 1u);
+		const uint32_t messagesPerThread = m_Config.logMessages / threadCount;
+
+		Log::info("Logging {} messages from {} threads in each mode, output is written to {}...",
+				  messagesPerThread * threadCount, threadCount, textFile);
+
+		const ArrayList<spdlog::sink_ptr> sinks = Log::s_Logger->sinks();
+		Log::s_Logger->sinks() = {std::make_shared<spdlog::sinks::basic_file_sink_mt>(textFile, true)};
+
+		for(LoggingMode& mode : modes) {
+
+			if(mode.binary) Log::openBinaryLog(binaryFile);
+			if(mode.async) Log::startAsync(Log::DEFAULT_ASYNC_CAPACITY, mode.policy);
+
+			ArrayList<ArrayList<double>> threadSamples(threadCount);
+			ArrayList<Thread> threads;
+
+			const TimePoint start = BenchmarkClock::now();
+
+			for(uint32_t t = 0;t < threadCount;++t) {
+				threads.emplace_back([&, t]() {
+					ArrayList<double>& samples = threadSamples[t];
+					samples.reserve(messagesPerThread);
+					for(uint32_t i = 0;i < messagesPerThread;++i) {
+						const TimePoint callStart = BenchmarkClock::now();
+						Log::info("Entity {} of thread {} moved to ({}, {}, {}) in {} ms", i, t, i * 0.5f, t * 2.0f, -1.0f, 16.6);
+						samples.push_back(elapsedMillis(callStart));
+					}
+				});
+			}
+			for(Thread& thread : threads) thread.join();
+
+			mode.totalMs = elapsedMillis(start);
+			mode.dropped = Log::droppedCount();
+
+			Log::stopAsync();
+			Log::closeBinaryLog();
+			Log::flush();
+
+			for(ArrayList<double>& samples : threadSamples) {
+				mode.samples.insert(mode.samples.end(), samples.begin(), samples.end());
+			}
+		}
+
+		Log::s_Logger->sinks() = sinks;
+
+		nlohmann::json json;
+
+		json["benchmark"] = "logging";
+
+		nlohmann::json& config = json["config"];
+		config["messages"] = messagesPerThread * threadCount;
+		config["threads"] = threadCount;
+		config["asyncCapacity"] = Log::DEFAULT_ASYNC_CAPACITY;
+
+		for(const LoggingMode& mode : modes) {
+			nlohmann::json& stage = json["stages"][mode.name];
+			writeStats(stage, mode.samples);
+			stage["totalMs"] = mode.totalMs;
+			stage["dropped"] = mode.dropped;
+		}
+
+		if(Files::exists(binaryFile)) {
+			json["binaryLogBytes"] = std::filesystem::file_size(binaryFile);
+		}
+
+		return json.dump(4);
+	}
+
+	static uint32_t parseUInt(const char* option, const char* value) {
+		if(value == nullptr) throw MILO_RUNTIME_EXCEPTION(str("Missing value for ") + option);
+		char* end = nullptr;
+		unsigned long result = strtoul(value, &end, 10);
+		if(end == value || *end != '\0') throw MILO_RUNTIME_EXCEPTION(str("Invalid value for ") + option + ": " + value);
+		return (uint32_t) result;
+	}
+
+	BenchmarkConfig MiloBenchmark::parseArguments(int argc, char** argv) {
+
+		BenchmarkConfig config;
+
+		for(int i = 1;i < argc;++i) {
+			const char* option = argv[i];
+			const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+
+			if(strcmp(option, "--profile") == 0) {
+				config.profile = true;
+				continue;
+			}
+
+			if(strcmp(option, "--log") == 0) {
+				config.logging = true;
+				continue;
+			}
+
+			if(strcmp(option, "--entities") == 0) config.entities = parseUInt(option, value);
+			else if(strcmp(option, "--lights") == 0) config.pointLights = parseUInt(option, value);
+			else if(strcmp(option, "--depth") == 0) config.hierarchyDepth = parseUInt(option, value);
+			else if(strcmp(option, "--materials") == 0) config.materials = parseUInt(option, value);
+			else if(strcmp(option, "--meshes") == 0) config.meshes = parseUInt(option, value);
+			else if(strcmp(option, "--warmup") == 0) config.warmupIterations = parseUInt(option, value);
+			else if(strcmp(option, "--iterations") == 0) config.iterations = parseUInt(option, value);
+			else if(strcmp(option, "--seed") == 0) config.seed = parseUInt(option, value);
+			else if(strcmp(option, "--log-messages") == 0) config.logMessages = parseUInt(option, value);
+			else if(strcmp(option, "--log-threads") == 0) config.logThreads = parseUInt(option, value);
+			else if(strcmp(option, "--model") == 0) {
+				if(value == nullptr) throw MILO_RUNTIME_EXCEPTION("Missing value for --model");
+				config.model = value;
+			}
+			else if(strcmp(option, "--output") == 0) {
+				if(value == nullptr) throw MILO_RUNTIME_EXCEPTION("Missing value for --output");
+				config.output = value;
+			}
+			else throw MILO_RUNTIME_EXCEPTION(str("Unknown option ") + option);
+
+			++i;
+		}
+
+		return config;
+	}
+
+	int MiloBenchmark::launch(int argc, char** argv) {
+
+		BenchmarkConfig config;
+
+		try {
+			config = parseArguments(argc, argv);
+		} catch(const Exception& e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Usage: milo_bench [--entities N] [--lights N] [--depth N] [--materials N] [--meshes N] "
+						 "[--warmup N] [--iterations N] [--seed N] [--model file.gltf] [--log] [--log-messages N] [--log-threads N] "
+						 "[--output file.json] [--profile]" << std::endl;
+			return 1;
+		}
+
+		MiloSubSystemManager::initHeadless();
+
+		String results;
+		{
+			MiloBenchmark benchmark(config);
+			results = benchmark.run();
+		}
+
+		if(config.output.empty()) {
+			std::cout << results << std::endl;
+		} else {
+			Files::writeAllText(config.output, results);
+			Log::info("Benchmark results written to {}", config.output);
+		}
+
+		MiloSubSystemManager::shutdownHeadless();
+
+		return 0;
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "milo/Milo.h"
+#include "milo/core/MiloSubSystemManager.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
+#include "milo/time/Profiler.h"
+
+namespace milo {
+
+	struct BenchmarkConfig {
+		uint32_t entities = 10000;
+		uint32_t pointLights = 64;
+		// Length of the parent chains. 1 means a flat scene
+		uint32_t hierarchyDepth = 1;
+		uint32_t materials = 16;
+		uint32_t meshes = 8;
+		uint32_t warmupIterations = 16;
+		uint32_t iterations = 256;
+		uint32_t seed = 1234;
+		bool profile = false;
+		// If set, compares the import of this model file with Assimp and with the native glTF loader instead.
+		// The bounding volumes of the meshes are checked and their fitting is timed too
+		String model;
+		// If set, measures the latency of Log calls on the calling threads instead, synchronous against asynchronous logging
+		bool logging = false;
+		uint32_t logMessages = 100000;
+		uint32_t logThreads = 4;
+		// Empty means stdout
+		String output;
+	};
+
+	struct BenchmarkStage {
+		String name;
+		ArrayList<double> samples;
+	};
+
+	// Runs the CPU side of the renderer (everything that happens before recording command buffers)
+	// over a synthetic scene, without window nor graphics context, and reports per stage timings as JSON
+	class MiloBenchmark {
+	private:
+		enum StageIndex {
+			CameraStage,
+			LightEnvironmentStage,
+			ShadowCascadesStage,
+			TransformsStage,
+			CullingStage,
+			CollectDrawCommandsStage,
+			SortDrawCommandsStage,
+			PrepareFrameStage,
+			StageCount
+		};
+	private:
+		BenchmarkConfig m_Config;
+		Scene* m_Scene{nullptr};
+		ArrayList<Mesh*> m_Meshes;
+		ArrayList<Material*> m_Materials;
+		ArrayList<Matrix4> m_ModelMatrices;
+		ArrayList<Mesh*> m_ModelMeshes;
+		FrameRenderData m_FrameData{};
+		Array<BenchmarkStage, StageCount> m_Stages{};
+		uint64_t m_VisibleCount{0};
+	public:
+		explicit MiloBenchmark(BenchmarkConfig config);
+		~MiloBenchmark();
+		MiloBenchmark(const MiloBenchmark&) = delete;
+		MiloBenchmark& operator=(const MiloBenchmark&) = delete;
+		String run();
+	private:
+		void createScene();
+		void destroyScene();
+		void runIteration(bool record);
+		String results() const;
+		// CPU side of the import (parsing and mesh conversion). Textures are decoded by the same code in both loaders
+		String runModelImport();
+		// Messages are written to a file, so the console is not flooded
+		String runLogging();
+		// AABB::of over fixed meshes with known bounds. Throws if any of them is wrong
+		static void checkAxisAlignedBoundingBoxes();
+	public:
+		static int launch(int argc, char** argv);
+		static BenchmarkConfig parseArguments(int argc, char** argv);
+	};
+}
@@ -0,0 +1,7 @@
+#include "MiloBenchmark.h"
+
+using namespace milo;
+
+int main(int argc, char** argv) {
+	return MiloBenchmark::launch(argc, argv);
+}
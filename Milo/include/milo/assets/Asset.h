@@ -1,7 +1,7 @@
 #pragma once
 
 #include "milo/common/Common.h"
-#include "milo/graphics/textures/Texture.h"
+#include "milo/assets/textures/Icon.h"
 
 namespace milo {
 
@@ -10,14 +10,14 @@ namespace milo {
 	protected:
 		String m_Name;
 		String m_Filename;
-		Ref<Texture2D> m_Icon;
 	public:
 		Asset() = default;
 		Asset(String name, String filename) : m_Name(std::move(name)), m_Filename(filename) {};
 		virtual ~Asset() = default;
 		inline const String& name() const {return m_Name;}
 		inline const String& filename() const {return m_Filename;}
-		inline const Ref<Texture2D> icon() const {return m_Icon;}
+		// Requests the icon to be baked if it was not yet, so only call it when the icon is going to be shown
+		Icon icon() const;
 	};
 
 }
\ No newline at end of file
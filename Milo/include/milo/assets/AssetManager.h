@@ -27,6 +27,7 @@ namespace milo {
 		static ModelManager& models();
 		static ShaderManager& shaders();
 		static SkyboxManager& skybox();
+		static bool initialized();
 	private:
 		static void init();
 		static void shutdown();
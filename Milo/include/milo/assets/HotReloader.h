@@ -0,0 +1,61 @@
+#pragma once
+
+#include "milo/assets/AssetManager.h"
+#include <condition_variable>
+
+namespace milo {
+
+	// Reloads the shaders, materials and textures whose files change while the application runs. Shaders are compiled,
+	// materials parsed and images decoded on a background thread, and update() swaps the new versions in between frames.
+	// If a reload fails the error is logged and the previous version stays in use.
+	//
+	// A shader replaces the old one in the ShaderManager and every graphics and compute pipeline that uses it is rebuilt.
+	// A material is updated in place. A texture is uploaded again and the materials that sampled the old one are
+	// pointed to the new one, while the old one is kept alive until the frames in flight are done with it
+	class HotReloader {
+		friend class MiloSubSystemManager;
+		friend class MiloEngine;
+	private:
+		struct Job {
+			enum class Type {Shader, Material, Texture};
+			Type type{Type::Shader};
+			// Absolute path of the changed file
+			String path;
+			// Name the shader was loaded with, see ShaderManager
+			String shaderFilename;
+			TextureManager::TextureFileInfo textureInfo{};
+			// Results
+			Shader* shader{nullptr};
+			MaterialManager::MaterialFile material{};
+			Image* image{nullptr};
+			bool succeeded{false};
+			String error;
+		};
+	private:
+		static Thread s_Thread;
+		static bool s_Running;
+		static Queue<Job*> s_PendingJobs;
+		static ArrayList<Job*> s_FinishedJobs;
+		static Mutex s_Mutex;
+		static std::condition_variable s_JobAdded;
+		// Replaced textures and the updates left before they are released
+		static ArrayList<std::pair<Ref<Texture2D>, uint32_t>> s_RetiredTextures;
+	public:
+		static bool enabled();
+	private:
+		static void init();
+		static void shutdown();
+		// Called between frames, by the thread that simulates the scene. Waits for the pipelined frames before applying
+		static void update();
+		static void enqueue(const String& path);
+		static void run();
+		static void execute(Job& job);
+		static void apply(Job& job);
+		static void applyShader(Job& job);
+		static void applyMaterial(Job& job);
+		static void applyTexture(Job& job);
+		static void releaseRetiredTextures();
+	public:
+		HotReloader() = delete;
+	};
+}
\ No newline at end of file
@@ -31,7 +31,13 @@ namespace milo {
 		static Image* createWhite(PixelFormat format, uint32_t width = 1, uint32_t height = 1);
 		static Image* createBlack(PixelFormat format, uint32_t width = 1, uint32_t height = 1);
 		static Image* loadImage(const String& path, PixelFormat format, bool flipY = false);
+		// Decodes an encoded image (png, jpg...) already in memory, like the ones embedded in model files
+		static Image* decode(const byte_t* data, size_t size, PixelFormat format, bool flipY = false);
 		static Image* create(void* pixels, PixelFormat format, uint32_t width = 1, uint32_t height = 1);
 		static Image* create(PixelFormat format, uint32_t width = 1, uint32_t height = 1, uint32_t value = 0);
+		// Rows are expected top to bottom. Both throw if the file cannot be written
+		static void writePNG(const String& path, uint32_t width, uint32_t height, const uint8_t* rgbaPixels);
+		// Uncompressed scanlines of 32 bit float channels, which any OpenEXR reader supports
+		static void writeEXR(const String& path, uint32_t width, uint32_t height, const float* rgbaPixels);
 	};
 }
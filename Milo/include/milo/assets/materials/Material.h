@@ -10,6 +10,9 @@ namespace milo {
 		friend class MaterialResourcePool;
 		friend class VulkanMaterialResourcePool;
 		friend class AssimpModelLoader;
+		friend class GltfModelLoader;
+		friend class MiloBenchmark;
+		friend class HotReloader;
 	public:
 		struct Data {
 			Color albedo{Colors::WHITE};
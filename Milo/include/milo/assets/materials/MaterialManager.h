@@ -9,8 +9,21 @@ namespace milo {
 		friend class AssetManager;
 		friend class AssimpModelLoader;
 		friend class MiloEngine;
+		friend class HotReloader;
+		friend class WorldRenderer;
+	private:
+		// Contents of a .mat file, with the texture paths resolved against the material file
+		struct MaterialFile {
+			Material::Data data{};
+			String albedoMap;
+			String normalMap;
+			String metallicMap;
+			String roughnessMap;
+			String occlusionMap;
+		};
 	private:
 		HashMap<String, Material*> m_Materials;
+		// Guards m_Materials and the resource pool, which are used by the simulation and the render threads
 		Mutex m_Mutex;
 		MaterialResourcePool* m_ResourcePool{nullptr};
 	private:
@@ -27,9 +40,23 @@ namespace milo {
 		MaterialResourcePool& resourcePool() const;
 	private:
 		void addMaterial(const String& name, Material* material);
+		// Both expect m_Mutex to be locked
+		void registerMaterial(const String& name, Material* material);
+		void destroyMaterial(const String& name);
 		bool load(const String& name, const String& filename, Material*& material);
-		Ref<Texture2D> loadTexture2D(void* pJson, const String& textureName, const String& materialFile);
-		void update();
+		// Only reads the file, so it can be called from any thread
+		static bool parse(const String& filename, MaterialFile& file);
+		// Loads the textures of the file and marks the material dirty
+		void apply(Material* material, const MaterialFile& file);
+		// Applies the file to a registered material and bakes its icon again
+		void reload(Material* material, const MaterialFile& file);
+		static String texturePathOf(void* pJson, const String& textureName, const String& materialFile);
+		Ref<Texture2D> loadTexture2D(const String& texturePath);
+		// Takes a snapshot of the materials changed since the last call. Called by the thread that edits the materials
+		void collectUpdates(ArrayList<MaterialSnapshot>& updates);
+		// Applies the snapshots of a frame to the resource pool. Called by the thread that renders the frame
+		void applyUpdates(const ArrayList<MaterialSnapshot>& updates);
+		void beginFrame();
 	};
 
 }
\ No newline at end of file
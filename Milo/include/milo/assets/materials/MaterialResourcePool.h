@@ -4,12 +4,28 @@
 
 namespace milo {
 
+	// Parameters and textures of a material when it was changed. Taken on the thread that edits the materials,
+	// so the resource pool never reads a Material while it is being modified
+	struct MaterialSnapshot {
+		Material* material{nullptr};
+		// Material version the snapshot was taken at, so frames rendered again do not apply older snapshots
+		uint32_t version{0};
+		Material::Data data{};
+		// Same order as the bindings of the material descriptor sets
+		Array<Ref<Texture2D>, Material::TEXTURE_COUNT> textures{};
+
+		static MaterialSnapshot of(Material* material);
+	};
+
 	class MaterialResourcePool {
 	public:
 		virtual ~MaterialResourcePool() = default;
 		virtual void allocateMaterialResources(Material* material) = 0;
-		virtual void updateMaterial(Material* material) = 0;
+		virtual void updateMaterial(const MaterialSnapshot& snapshot) = 0;
 		virtual void freeMaterialResources(Material* material) = 0;
+		// Called once per frame, after the GPU has finished with the previous use of the frame being recorded.
+		// Material updates are applied to the GPU copies here, so updateMaterial never has to wait for the GPU
+		virtual void beginFrame() = 0;
 	public:
 		static MaterialResourcePool* create();
 	};
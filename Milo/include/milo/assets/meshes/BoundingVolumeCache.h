@@ -0,0 +1,23 @@
+#pragma once
+
+#include "milo/common/Common.h"
+
+namespace milo {
+
+	class Mesh;
+
+	// On disk cache of the bounding volumes fitted to large meshes, so they are only computed the first time the
+	// mesh is imported. Entries are keyed by the content hash of the mesh and the type of the volume.
+	// Everything here may be called from any thread.
+	class BoundingVolumeCache {
+	public:
+		// Meshes with fewer vertices are fitted faster than their entry is read
+		static const size_t MIN_VERTEX_COUNT;
+	public:
+		static uint64_t keyOf(const Mesh* mesh, BoundingVolume::Type type);
+		static String filenameOf(uint64_t key);
+		// Returns a new volume of the given type, or nullptr if there is no valid entry
+		static BoundingVolume* load(uint64_t key, BoundingVolume::Type type);
+		static void save(uint64_t key, const BoundingVolume& volume);
+	};
+}
\ No newline at end of file
@@ -12,7 +12,10 @@ namespace milo {
 		friend class MeshManager;
 		friend class ObjMeshLoader;
 		friend class AssimpLoader;
+		friend class ModelLoader;
 		friend class AssimpModelLoader;
+		friend class GltfModelLoader;
+		friend class MiloBenchmark;
 	public:
 		class GraphicsBuffers { // Implemented by the APIs
 			friend class Mesh;
@@ -28,6 +31,8 @@ namespace milo {
 		GraphicsBuffers* m_Buffers{nullptr};
 		BoundingVolume* m_BoundingVolume{nullptr};
 		bool m_CanBeCulled{true};
+		// Hash of the vertices and indices, used to share meshes with the same geometry
+		uint64_t m_ContentHash{0};
 	private:
 		explicit Mesh(String filename);
 		~Mesh() override;
@@ -38,6 +43,10 @@ namespace milo {
 		const BoundingVolume& boundingVolume() const;
 		bool canBeCulled() const;
 		void setCanBeCulled(bool value);
+		uint64_t contentHash() const;
+		bool sameContentAs(const Mesh& other) const;
+	public:
+		static uint64_t contentHashOf(const ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices);
 	};
 
 	class VertexList {
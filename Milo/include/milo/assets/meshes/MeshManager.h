@@ -8,9 +8,11 @@ namespace milo {
 
 	class MeshManager {
 		friend class AssetManager;
-		friend class AssimpModelLoader;
+		friend class ModelLoader;
 	private:
 		HashMap<String, Mesh*> m_Meshes;
+		// Meshes by content hash. Lists because different geometry may have the same hash
+		HashMap<uint64_t, ArrayList<Mesh*>> m_MeshesByContent;
 		Mutex m_Mutex;
 	private:
 		MeshManager();
@@ -26,9 +28,14 @@ namespace milo {
 		Mesh* load(const String& name, const String& filename);
 		bool exists(const String& name);
 		Mesh* find(const String& name);
+		// Returns a loaded mesh with the same vertices and indices, if any
+		Mesh* findByContent(const Mesh* mesh);
 		void destroy(const String& name);
 	private:
+		// Creates the bounding volume too, unless the mesh already has one
 		void addMesh(const String& name, Mesh* mesh);
+		void indexContent(Mesh* mesh);
+		void unindexContent(Mesh* mesh);
 	private:
 		static Ref<MeshLoader> getMeshLoaderOf(const String& filename);
 		static void createGraphicsBuffers(const String& filename, Mesh* mesh);
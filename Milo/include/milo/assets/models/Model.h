@@ -9,64 +9,79 @@ namespace milo {
 		friend class ModelManager;
 		friend class ModelLoader;
 		friend class AssimpModelLoader;
+		friend class GltfModelLoader;
 	public:
-		struct Node {
-			friend class Model;
-
-			Model* model{nullptr};
-			uint32_t index{UINT32_MAX};
-			String name;
-			Matrix4 transform = Matrix4(1.0f);
-			Mesh* mesh{nullptr};
-			Material* material{nullptr};
-			ArrayList<uint32_t> children;
-			int32_t parent{-1};
-
-		private:
-			Node() = default;
-		};
-	public:
-		inline static const Node Empty{nullptr, UINT32_MAX, "", Matrix4(1.0f), nullptr, nullptr, {}};
+		using NodeIndex = int32_t;
+		static const NodeIndex NO_NODE = -1;
+		static const NodeIndex ROOT = 0;
 	private:
-		ArrayList<Node*> m_Nodes;
+		// Node tree stored in flat arrays indexed by NodeIndex. Nodes are in depth first order,
+		// so a node always comes after its parent and the nodes of a subtree are contiguous
+		ArrayList<String> m_NodeNames;
+		ArrayList<NodeIndex> m_Parents;
+		ArrayList<NodeIndex> m_FirstChildren;
+		ArrayList<NodeIndex> m_NextSiblings;
+		ArrayList<Matrix4> m_LocalTransforms;
+		ArrayList<Mesh*> m_NodeMeshes;
+		ArrayList<Material*> m_NodeMaterials;
 	private:
 		Model() = default;
-		~Model() override {
-			for(auto node : m_Nodes) {
-				DELETE_PTR(node);
-			}
-		}
+		~Model() override = default;
 	public:
 		Model(const Model& other) = delete;
 		Model& operator=(const Model& other) = delete;
-		inline const Node* root() const {return m_Nodes[0];}
-		inline const Node* get(uint32_t index) const {return m_Nodes[index];}
-		inline const Node* get(const String& name) const {
-			for(uint32_t i = 0;i < size();++i) {
-				if(m_Nodes[i]->name == name) return m_Nodes[i];
-			}
-			return &Empty;
-		}
-		inline const Node* operator[](uint32_t index) const {
-			return m_Nodes[index];
-		}
-		inline const ArrayList<Node*>& nodes() const {return m_Nodes;}
-		inline uint32_t size() const {return m_Nodes.size();}
+		inline uint32_t size() const {return m_Parents.size();}
+		inline const String& nodeName(NodeIndex node) const {return m_NodeNames[node];}
+		inline NodeIndex parent(NodeIndex node) const {return m_Parents[node];}
+		inline NodeIndex firstChild(NodeIndex node) const {return m_FirstChildren[node];}
+		inline NodeIndex nextSibling(NodeIndex node) const {return m_NextSiblings[node];}
+		inline const Matrix4& localTransform(NodeIndex node) const {return m_LocalTransforms[node];}
+		inline void setLocalTransform(NodeIndex node, const Matrix4& transform) {m_LocalTransforms[node] = transform;}
+		inline Mesh* mesh(NodeIndex node) const {return m_NodeMeshes[node];}
+		inline Material* material(NodeIndex node) const {return m_NodeMaterials[node];}
+		inline const ArrayList<Matrix4>& localTransforms() const {return m_LocalTransforms;}
 
-		inline Node* createNode() {
-			Node* node = new Node();
-			node->model = this;
-			node->index = m_Nodes.size();
-			m_Nodes.push_back(node);
-			return node;
+		inline NodeIndex find(const String& name) const {
+			for(NodeIndex i = 0;i < (NodeIndex)size();++i) {
+				if(m_NodeNames[i] == name) return i;
+			}
+			return NO_NODE;
 		}
 
 		inline void setCanBeCulled(bool value) {
-			for(Node* node : m_Nodes) {
-				if(node->mesh != nullptr) {
-					node->mesh->setCanBeCulled(value);
+			for(Mesh* mesh : m_NodeMeshes) {
+				if(mesh != nullptr) {
+					mesh->setCanBeCulled(value);
 				}
 			}
 		}
+	private:
+		inline void reserve(uint32_t count) {
+			m_NodeNames.reserve(count);
+			m_Parents.reserve(count);
+			m_FirstChildren.reserve(count);
+			m_NextSiblings.reserve(count);
+			m_LocalTransforms.reserve(count);
+			m_NodeMeshes.reserve(count);
+			m_NodeMaterials.reserve(count);
+		}
+
+		// Nodes must be created in depth first order. previousSibling is the last child created for the same parent
+		inline NodeIndex createNode(NodeIndex parent, NodeIndex previousSibling, String name, const Matrix4& transform) {
+			const NodeIndex node = (NodeIndex)size();
+			m_NodeNames.push_back(std::move(name));
+			m_Parents.push_back(parent);
+			m_FirstChildren.push_back(NO_NODE);
+			m_NextSiblings.push_back(NO_NODE);
+			m_LocalTransforms.push_back(transform);
+			m_NodeMeshes.push_back(nullptr);
+			m_NodeMaterials.push_back(nullptr);
+			if(previousSibling != NO_NODE) {
+				m_NextSiblings[previousSibling] = node;
+			} else if(parent != NO_NODE) {
+				m_FirstChildren[parent] = node;
+			}
+			return node;
+		}
 	};
 }
\ No newline at end of file
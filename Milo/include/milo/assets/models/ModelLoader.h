@@ -8,6 +8,12 @@ namespace milo {
 	public:
 		virtual ~ModelLoader() = default;
 		virtual Model* load(const String& filename) = 0;
+	protected:
+		// Replaces the meshes with the same geometry as an already loaded mesh, or as a previous mesh of the list, by that
+		// mesh, deleting them. The remaining ones get their bounding volumes and are added to the mesh manager with the
+		// given names (made unique if taken by a different geometry). Must be called from the thread owning the graphics API
+		static void shareMeshes(const String& filename, ArrayList<Mesh*>& meshes, const ArrayList<String>& names);
+		static void setNodeMesh(Model* model, Model::NodeIndex node, Mesh* mesh, Material* material);
 	};
 
 }
\ No newline at end of file
@@ -7,5 +7,6 @@
 namespace milo::ModelUtils {
 
 	Entity createModelEntityTree(Scene* scene, Model* model);
-	void createEntityModelTree(Scene* scene, Model* model, const Model::Node* node, Entity entity);
+	// Creates the entities of the subtree of the given node. The node itself is mapped to the given entity
+	void createEntityModelTree(Scene* scene, Model* model, Model::NodeIndex node, Entity entity);
 }
\ No newline at end of file
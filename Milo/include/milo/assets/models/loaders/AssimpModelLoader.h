@@ -11,21 +11,32 @@ namespace milo {
 	using HashSet = std::unordered_set<T>;
 
 	class AssimpModelLoader : public ModelLoader {
+		friend class MiloBenchmark;
 	private:
 		String m_File;
 		String m_Dir;
 		HashSet<String> m_LoadedTextureNames;
+		ArrayList<String> m_DirectoryImages;
+		// By aiMesh index. Meshes with the same geometry are shared, even with other models
+		ArrayList<Mesh*> m_Meshes;
+		// By aiMaterial index
+		ArrayList<Material*> m_Materials;
 	public:
 		Model* load(const String& filename) override;
 	private:
-		void processScene(const aiScene* scene, Model* outModel);
-		void processNode(const aiScene* scene, const aiNode* node, Model::Node* outNode);
-		void processMesh(const aiScene* scene, const aiMesh* mesh, Mesh* outMesh);
+		void processMeshes(const aiScene* aiScene);
+		void decodeMeshes(const aiScene* aiScene);
+		void processMaterials(const aiScene* aiScene);
+		void processNodes(const aiScene* aiScene, Model* outModel);
+		void processMesh(const aiMesh* aiMesh, Mesh* outMesh);
 		void processIndices(const aiMesh* aiMesh, Mesh* outMesh);
 		void processMaterial(const aiScene* scene, const aiMaterial* aiMaterial, Material* outMaterial);
+		void preloadTextures(const aiScene* aiScene);
+		String getTextureFile(const aiMaterial* aiMaterial, aiTextureType type) const;
 		Ref<Texture2D> getTexture(const aiScene* aiScene, const aiMaterial* aiMaterial, aiTextureType type, PixelFormat format, bool* present = nullptr);
-
-		void processNodeMeshes(const aiScene* aiScene, const aiNode* aiNode, Model::Node* outNode);
+		void setNodeMesh(const aiScene* aiScene, uint32_t meshIndex, Model::NodeIndex node, Model* outModel);
+		// Imports the file and converts its meshes without registering them nor touching the GPU. The caller owns the meshes
+		ArrayList<Mesh*> importMeshes(const String& filename);
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "milo/assets/models/ModelLoader.h"
+#include "milo/io/MappedFile.h"
+
+namespace milo {
+
+	// Native glTF 2.0 loader for .gltf and .glb files. Buffers are memory mapped (or point into the binary chunk of the .glb)
+	// and accessors are read from them straight into the vertices and indices of the meshes, without an intermediate scene.
+	// Each primitive becomes a Mesh. Nodes with several primitives get one child per primitive, like with Assimp
+	class GltfModelLoader : public ModelLoader {
+		friend class MiloBenchmark;
+	private:
+		struct Document;
+
+		// count elements of components values each, stride bytes apart. No data means every value is zero
+		struct AccessorView {
+			const byte_t* data{nullptr};
+			uint32_t count{0};
+			uint32_t componentType{0};
+			uint32_t components{0};
+			uint32_t stride{0};
+			bool normalized{false};
+		};
+
+		struct Primitive {
+			uint32_t mesh{0};
+			uint32_t index{0};
+			int32_t material{-1};
+		};
+	private:
+		String m_File;
+		String m_Dir;
+		// Triangle primitives of every mesh, in order. The ones of mesh i go from m_FirstPrimitives[i] to m_FirstPrimitives[i + 1]
+		ArrayList<Primitive> m_Primitives;
+		ArrayList<uint32_t> m_FirstPrimitives;
+		// By primitive
+		ArrayList<Mesh*> m_Meshes;
+		// By glTF material index
+		ArrayList<Material*> m_Materials;
+		// By glTF texture index. Null if no material uses it
+		ArrayList<Ref<Texture2D>> m_Textures;
+	public:
+		Model* load(const String& filename) override;
+	private:
+		void reset(const String& filename);
+		void readDocument(Document& document) const;
+		void readBuffers(Document& document) const;
+		void collectPrimitives(const Document& document);
+		void decodeMeshes(const Document& document);
+		void processMeshes(const Document& document);
+		void processTextures(const Document& document);
+		void processMaterials(const Document& document);
+		void processNodes(const Document& document, Model* outModel);
+		void processPrimitive(const Document& document, const Primitive& primitive, Mesh* outMesh) const;
+		void processMaterial(const Document& document, uint32_t materialIndex, Material* outMaterial) const;
+		AccessorView accessor(const Document& document, uint32_t index) const;
+		// Parses the file and decodes its meshes without registering them nor touching the GPU. The caller owns the meshes
+		ArrayList<Mesh*> importMeshes(const String& filename);
+	};
+}
\ No newline at end of file
@@ -21,12 +21,13 @@ namespace milo {
 		size_t length() const;
 	};
 
+	// Every thread compiles with its own shaderc compiler and options, so shaders can be compiled in parallel
 	class SPIRVCompiler {
-	private:
-		shaderc_compiler_t m_Compiler = nullptr;
 	public:
-		SPIRVCompiler();
-		~SPIRVCompiler();
+		SPIRVCompiler() = default;
+		~SPIRVCompiler() = default;
 		SPIRV compile(const String& filename, Shader::Type type);
+		// The filename is only used in error messages
+		SPIRV compile(const String& filename, const String& source, Shader::Type type);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "Shader.h"
+
+namespace milo {
+
+	// On disk cache of compiled SPIR-V, one file per shader under resources/cache/shaders, filled at runtime and by the
+	// milo_shaderc tool. Entries are keyed by the source code and type of the shader, so editing the source makes the
+	// entry outdated. Everything here may be called from any thread
+	class ShaderCache {
+	public:
+		static uint64_t keyOf(const String& source, Shader::Type type);
+		static String filenameOf(const String& shaderFilename);
+		static bool load(const String& shaderFilename, uint64_t key, ArrayList<int8>& spirv);
+		static void save(const String& shaderFilename, uint64_t key, const byte_t* spirv, size_t length);
+	};
+}
\ No newline at end of file
@@ -4,27 +4,47 @@
 
 namespace milo {
 
+	// Shaders are loaded by name: the filename of their source, optionally followed by the preprocessor macros defined
+	// when compiling it, each one after a '#'. For example, "pbr.frag#BINDLESS_MATERIALS" is pbr.frag compiled with
+	// BINDLESS_MATERIALS defined. Each name is a separate shader, compiled, cached and hot reloaded on its own
 	class ShaderManager {
 		friend class AssetManager;
+		friend class HotReloader;
 	private:
 		HashMap<String, Shader*> m_Shaders;
-		SPIRVCompiler m_SPIRVCompiler;
 		Mutex m_Mutex;
 	private:
 		ShaderManager();
 		~ShaderManager();
 	public:
 		Shader* load(const String& filename);
+		// Compiles the shaders that are not loaded yet in parallel and registers them, so the pipelines created
+		// afterwards find them ready. Shaders that fail are skipped, loading them later reports the error
+		void compileAll(const ArrayList<String>& filenames);
 		bool exists(const String& filename) const;
 		Shader* find(const String& filename) const;
 		void destroy(const String& filename);
+		// Names of the loaded shaders compiled from the file at the given absolute path
+		ArrayList<String> namesOf(const String& path) const;
 	private:
+		// Compiles the shader without registering it, so it can be called from any thread
+		Shader* compile(const String& filename);
+		// Registers the shader in place of the previous version, which is destroyed
+		void replace(const String& filename, Shader* shader);
 		Shader* createShader(const String& filename);
-		Shader* loadCache(const String& originalFilename, const String& cacheFilename);
-		void loadCachedShaders();
-		void createShaderCache(const String& filename, Shader* shader);
+	public:
+		// SPIR-V of the shader, read from the ShaderCache if its source did not change, otherwise compiled and cached.
+		// May be called from any thread
+		static ArrayList<int8> compileSPIRV(const String& filename, bool useCache = true, bool* cached = nullptr);
+		// Source file of the shader with the given name
+		static String sourceFilenameOf(const String& name);
+		// Shader files under the directory, recursively
+		static ArrayList<String> findShaders(const String& directory);
+		static bool isShaderFile(const String& filename);
 		static Shader::Type getShaderTypeByFilename(const String& filename);
-		static String getFilenameFromCache(const String& cacheFilename);
+	private:
+		// Defines the macros of the shader name right after the #version directive of the source
+		static String preprocess(const String& name, const String& source);
 	};
 
 }
\ No newline at end of file
@@ -14,10 +14,12 @@ namespace milo {
 		Cubemap* m_EnvironmentMap{nullptr};
 		Cubemap* m_IrradianceMap{nullptr};
 		Cubemap* m_PrefilterMap{nullptr};
+		// Shared by every skybox, owned by the SkyboxFactory
 		Texture2D* m_BRDFMap{nullptr};
 		float m_MaxPrefilterLOD{4.0f};
 		float m_PrefilterLODBias{-1.0f};
 		uint32_t m_Modifications{1};
+		bool m_Ready{true};
 	protected:
 		Skybox(String name, String filename);
 		virtual ~Skybox();
@@ -32,6 +34,28 @@ namespace milo {
 		float prefilterLODBias() const;
 		void prefilterLODBias(float value);
 		uint32_t modifications() const;
+		// False while its maps are still being generated in the background
+		bool ready() const;
+	};
+
+	enum class PreethamSkyUpdateMode {
+		// Every map is regenerated as soon as the sky changes
+		Immediate,
+		// Regeneration is spread over several frames into a second set of maps, which are swapped in when complete.
+		// Meant for skies that change every frame, like a day/night cycle
+		Incremental
+	};
+
+	class PreethamSky;
+
+	// Parameters of a PreethamSky when it changed. Captured with the frame data, so the maps are regenerated
+	// by the thread that owns the GPU while the simulation keeps changing the sky
+	struct PreethamSkyUpdateRequest {
+		PreethamSky* sky{nullptr};
+		float turbidity{0};
+		float azimuth{0};
+		float inclination{0};
+		PreethamSkyUpdateMode updateMode{PreethamSkyUpdateMode::Immediate};
 	};
 
 	class PreethamSky : public Skybox {
@@ -43,6 +67,14 @@ namespace milo {
 		float m_Azimuth{0};
 		float m_Inclination{0};
 		bool m_Dirty{true};
+		PreethamSkyUpdateMode m_UpdateMode{PreethamSkyUpdateMode::Immediate};
+		// Incremental mode only. Faces generated per frame, counting every map and mip level
+		uint32_t m_FacesPerFrame{2};
+		// Incremental mode only. Smaller sun movements (in radians) do not regenerate the maps
+		float m_MinSunAngleDelta{0.005f};
+		// Incremental mode only. Size of the maps, relative to the original ones, while the sky keeps changing.
+		// The full size maps are generated once the sky stops changing
+		float m_AnimationResolutionScale{0.25f};
 	private:
 		PreethamSky(const String& name);
 		~PreethamSky() override;
@@ -53,7 +85,21 @@ namespace milo {
 		PreethamSky* azimuth(float value);
 		float inclination() const;
 		PreethamSky* inclination(float value);
+		Vector3 sunDirection() const;
 		bool dirty() const;
+		// Regenerates the maps right away. Only for the thread that owns the GPU, see takeUpdateRequest
 		void update();
+		// Returns false if the sky did not change since the last request. Otherwise it is no longer dirty
+		bool takeUpdateRequest(PreethamSkyUpdateRequest& request);
+		PreethamSkyUpdateMode updateMode() const;
+		PreethamSky* updateMode(PreethamSkyUpdateMode mode);
+		uint32_t facesPerFrame() const;
+		PreethamSky* facesPerFrame(uint32_t value);
+		float minSunAngleDelta() const;
+		PreethamSky* minSunAngleDelta(float value);
+		float animationResolutionScale() const;
+		PreethamSky* animationResolutionScale(float value);
+	public:
+		static Vector3 sunDirection(float azimuth, float inclination);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "SkyboxFactory.h"
+#include "milo/assets/images/Image.h"
+
+namespace milo {
+
+	// Raw contents of a texture, every layer of mip level 0 first, then level 1 and so on
+	struct SkyboxCacheImage {
+		PixelFormat format{PixelFormat::Undefined};
+		uint32_t width{0};
+		uint32_t height{0};
+		uint32_t layers{1};
+		uint32_t mipLevels{1};
+		ArrayList<int8> data;
+	};
+
+	struct SkyboxCacheData {
+		SkyboxCacheImage environmentMap;
+		SkyboxCacheImage irradianceMap;
+		SkyboxCacheImage prefilterMap;
+		// Small copy of the equirectangular image, so the skybox icon does not need the source file
+		SkyboxCacheImage thumbnail;
+	};
+
+	// On disk cache of the precomputed image based lighting maps of a skybox.
+	// Entries are keyed by the contents of the source image and the SkyboxLoadInfo they were generated with, so
+	// modifying or replacing the image creates a new entry. Everything here may be called from any thread.
+	class SkyboxCache {
+	public:
+		static uint64_t keyOf(const String& imageFile, const SkyboxLoadInfo& loadInfo);
+		static String filenameOf(uint64_t key);
+		static bool load(uint64_t key, SkyboxCacheData& data);
+		static void save(uint64_t key, const SkyboxCacheData& data);
+		static SkyboxCacheImage createThumbnail(const Image& image, uint32_t width = 256);
+	};
+}
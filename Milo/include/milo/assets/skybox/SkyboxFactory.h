@@ -19,8 +19,15 @@ namespace milo {
 	public:
 		virtual ~SkyboxFactory() = default;
 		virtual Skybox* create(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo = DEFAULT_SKYBOX_LOAD_INFO) = 0;
+		// Returns immediately. The skybox is not ready until its maps are loaded from the cache or generated
+		virtual Skybox* createAsync(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo = DEFAULT_SKYBOX_LOAD_INFO) = 0;
+		// Blocks until the skybox has no work pending on the GPU. Must be called before destroying it
+		virtual void await(Skybox* skybox) = 0;
+		// Advances the skyboxes being created asynchronously. Called once per frame
+		virtual void update() = 0;
 		virtual PreethamSky* createPreethamSky(const String& name, const SkyboxLoadInfo& loadInfo, float turbidity, float azimuth, float inclination) = 0;
-		virtual void updatePreethamSky(PreethamSky* sky) = 0;
+		// Regenerates the maps right away or starts an incremental update, depending on the update mode of the sky
+		virtual void updatePreethamSky(const PreethamSkyUpdateRequest& request) = 0;
 	public:
 		static SkyboxFactory* create();
 	};
@@ -17,18 +17,15 @@ namespace milo {
 		PreethamSky* getPreethamSky() const;
 		Skybox* getIndoorSkybox() const;
 		Skybox* load(const String& name, const String& filename);
+		// Same as load, but the skybox is not ready until its maps are generated. See Skybox::ready
+		Skybox* loadAsync(const String& name, const String& filename);
 		bool exists(const String& name) const;
 		Skybox* find(const String& name) const;
 		void destroy(const String& name);
-		void updatePreethamSky(PreethamSky* sky);
+		void updatePreethamSky(const PreethamSkyUpdateRequest& request);
+		void update();
 	private:
 		void createPreethamSky();
-		Skybox* createSkybox(const String& name, const String& filename);
-		Skybox* loadCache(const String& originalFilename, const String& cacheFilename);
-		void loadCachedSkyboxes();
-		void createSkyboxCache(const String& filename, Skybox* shader);
-		static String getFilenameFromCache(const String& cacheFilename);
-		static String getNameFromFilename(const String& cacheFilename);
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "milo/graphics/textures/Texture.h"
+
+namespace milo {
+
+	// A whole texture, or the region of an atlas shared by several icons
+	struct Icon {
+		Ref<Texture2D> texture;
+		Vector2 uv0{0, 0};
+		Vector2 uv1{1, 1};
+		Size size{};
+
+		explicit operator bool() const {return texture != nullptr;}
+	};
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "milo/common/Common.h"
+
+namespace milo {
+
+	class Mesh;
+	class Material;
+
+	// On disk cache of the baked asset icons, so each of them is only rendered once.
+	// Entries are keyed by the contents of the mesh and material they show, the modification time and size of the
+	// texture files of the material and the icon size, so editing any of them creates a new entry.
+	// Everything here may be called from any thread.
+	class IconCache {
+	public:
+		// textureFiles are the absolute source files of the textures of the material, see TextureManager::sourceFilesOf.
+		// Returns false if one of the files cannot be read, the icon must not be cached then
+		static bool keyOf(const Mesh* mesh, const Material* material, const Size& size, const ArrayList<String>& textureFiles, uint64_t& key);
+		static String filenameOf(uint64_t key);
+		// RGBA8 pixels of the icon
+		static bool load(uint64_t key, const Size& size, ArrayList<int8>& pixels);
+		static void save(uint64_t key, const Size& size, const ArrayList<int8>& pixels);
+	};
+}
\ No newline at end of file
@@ -1,26 +1,58 @@
 #pragma once
 
 #include "milo/graphics/textures/Texture.h"
+#include "milo/assets/textures/Icon.h"
+#include "milo/common/Concurrency.h"
 
 namespace milo {
 
 	static const Size DEFAULT_ICON_SIZE = {64, 64};
+	static const Size ICON_ATLAS_SIZE = {1024, 1024};
 
 	class Mesh;
 	class Material;
+	class Image;
+
+	// An image file already in memory, like the ones embedded in model files
+	struct EncodedImage {
+		// Cache key and name of the texture
+		String name;
+		const byte_t* data{nullptr};
+		size_t size{0};
+	};
+
+	struct IconBakeInfo {
+		Mesh* mesh{nullptr};
+		Material* material{nullptr};
+		// Top left corner of the icon in the atlas
+		uint32_t x{0};
+		uint32_t y{0};
+		// RGBA8. Uploaded as is if present, otherwise the icon is rendered and its pixels are read back here
+		ArrayList<int8> pixels;
+	};
 
 	class IconFactory {
 		friend class TextureManager;
 	protected:
 		virtual ~IconFactory() = default;
 	public:
-		virtual Texture2D* createIcon(Mesh* mesh, Material* material, const Size& size = DEFAULT_ICON_SIZE) = 0;
+		virtual Texture2D* createAtlas(const Size& size) = 0;
+		// Uploads and renders all the icons of the same atlas with a single submission
+		virtual void bakeIcons(Texture2D* atlas, const Size& iconSize, ArrayList<IconBakeInfo>& icons) = 0;
 	};
 
 	class TextureManager {
 		friend class AssetManager;
 		friend class Texture2D;
 		friend class Cubemap;
+		friend class HotReloader;
+	private:
+		// How a texture was loaded from its file, to load it the same way when the file changes
+		struct TextureFileInfo {
+			PixelFormat format{PixelFormat::RGBA8};
+			bool flipY{false};
+			uint32_t mipLevels{AUTO_MIP_LEVELS};
+		};
 	private:
 		AtomicUInt m_TextureIdProvider{0};
 		Ref<Texture2D> m_WhiteTexture;
@@ -30,8 +62,23 @@ namespace milo {
 		Ref<Texture2D> m_BRDF;
 		IconFactory* m_IconFactory{nullptr};
 		HashMap<String, Ref<Texture2D>> m_Cache;
-		HashMap<String, Ref<Texture2D>> m_Icons;
-		HashMap<uint64_t, uint64_t> m_IconHandles;
+		HashMap<String, TextureFileInfo> m_FileInfos;
+		// Icons are baked the first time they are requested, so the ones never shown are never rendered
+		struct IconSource {
+			Mesh* mesh{nullptr};
+			Material* material{nullptr};
+			String fallback;
+			bool requested{false};
+		};
+		HashMap<String, Icon> m_Icons;
+		HashMap<String, IconSource> m_IconSources;
+		ArrayList<String> m_IconRequests;
+		ArrayList<Ref<Texture2D>> m_IconAtlases;
+		HashMap<String, uint32_t> m_IconSlots;
+		ArrayList<uint32_t> m_FreeIconSlots;
+		uint32_t m_NextIconSlot{0};
+		ArrayList<Future<void>> m_IconCacheWrites;
+		Mutex m_IconMutex;
 	private:
 		TextureManager();
 		~TextureManager();
@@ -44,17 +91,32 @@ namespace milo {
 		Ref<Texture2D> createTexture2D();
 		Ref<Cubemap> createCubemap();
 		Ref<Texture2D> load(const String& filename, PixelFormat format = PixelFormat::RGBA8, bool flipY = false, uint32_t mipLevels = AUTO_MIP_LEVELS);
-		Ref<Texture2D> getIcon(const String& name) const;
+		// Decodes the images that are not cached yet in parallel, then uploads them. Returns the textures in the same order
+		ArrayList<Ref<Texture2D>> load(const ArrayList<String>& filenames, PixelFormat format = PixelFormat::RGBA8, bool flipY = false, uint32_t mipLevels = AUTO_MIP_LEVELS);
+		// Same as above for images in memory. Their data is only read during the call
+		ArrayList<Ref<Texture2D>> load(const ArrayList<EncodedImage>& images, PixelFormat format = PixelFormat::RGBA8, bool flipY = false, uint32_t mipLevels = AUTO_MIP_LEVELS);
+		// Returns the fallback icon while the requested one is not baked yet
+		Icon getIcon(const String& name);
 		void addIcon(const String& name, Ref<Texture2D> texture);
+		void addIcon(const String& name, const Icon& icon);
 		void removeIcon(const String& name);
-		Ref<Texture2D> createIcon(const String& name, Mesh* mesh, Material* material);
+		void registerIcon(const String& name, Mesh* mesh, Material* material, const String& fallback);
+		// Bakes the icons requested since the last call
+		void update();
 	private:
 		uint32_t nextTextureId();
+		Ref<Texture2D> createTexture(const String& filename, Image* image, uint32_t mipLevels);
+		ArrayList<Ref<Texture2D>> decodeAll(const ArrayList<String>& names, const Function<Image*, size_t>& decode, uint32_t mipLevels);
 		void registerTexture(const Texture2D& texture);
 		void unregisterTexture(const Texture2D& texture);
 		void registerTexture(const Cubemap& texture);
 		void unregisterTexture(const Cubemap& texture);
 		void createDefaultIcons();
+		uint32_t allocateIconSlot(const String& name);
+		void freeIconSlot(const String& name);
+		// Absolute files the textures of the material were loaded from, empty for the white and black textures.
+		// Returns false if one of them was not loaded from a file
+		bool sourceFilesOf(const Material* material, ArrayList<String>& files) const;
 	private:
 		static Texture2D* createWhiteTexture();
 		static Texture2D* createBlackTexture();
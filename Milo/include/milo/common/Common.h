@@ -5,6 +5,7 @@
 #include "Collections.h"
 #include "Strings.h"
 #include "Memory.h"
+#include "FrameAllocator.h"
 #include "Exceptions.h"
 #include "Concurrency.h"
 #include "milo/math/Math.h"
@@ -27,6 +28,23 @@ namespace milo {
 		return std::hash<T>{}(value);
 	}
 
+	static const uint64_t STABLE_HASH_SEED = 14695981039346656037ULL;
+
+	// FNV-1a. Unlike hashcodeOf, the result is the same between runs and platforms, so it can be persisted
+	inline uint64_t stableHash(const void* data, size_t size, uint64_t hash = STABLE_HASH_SEED) {
+		const auto* bytes = (const uint8_t*)data;
+		for(size_t i = 0;i < size;++i) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	template<typename T>
+	inline uint64_t stableHashValue(const T& value, uint64_t hash = STABLE_HASH_SEED) {
+		return stableHash(&value, sizeof(T), hash);
+	}
+
 	using TypeHash = size_t;
 
 	template<typename T>
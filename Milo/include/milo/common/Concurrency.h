@@ -2,6 +2,7 @@
 
 #include <thread>
 #include <mutex>
+#include <future>
 
 namespace milo {
 
@@ -11,6 +12,9 @@ namespace milo {
 
 	using Mutex = std::mutex;
 
+	template<typename T>
+	using Future = std::future<T>;
+
 	template<typename T>
 	using Atomic = std::atomic<T>;
 
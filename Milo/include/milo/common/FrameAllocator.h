@@ -0,0 +1,115 @@
+#pragma once
+
+#include "Memory.h"
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+namespace milo {
+
+	// One arena per frame that can still be referenced by the CPU. Matches MAX_SWAPCHAIN_IMAGE_COUNT
+	const uint32_t FRAME_ARENA_BUFFER_COUNT = 3;
+	const size_t FRAME_ARENA_DEFAULT_CAPACITY = 8 * 1024 * 1024;
+
+	class LinearArena {
+	private:
+		struct OverflowBlock {
+			OverflowBlock* next;
+			size_t size;
+		};
+	private:
+		int8_t* m_Data{nullptr};
+		size_t m_Capacity{0};
+		Atomic<size_t> m_Offset{0};
+		size_t m_HighWaterMark{0};
+		Mutex m_OverflowMutex;
+		OverflowBlock* m_OverflowBlocks{nullptr};
+		size_t m_OverflowSize{0};
+	public:
+		explicit LinearArena(size_t capacity);
+		~LinearArena();
+		LinearArena(const LinearArena&) = delete;
+		LinearArena& operator=(const LinearArena&) = delete;
+		void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		// Invalidates every allocation made from this arena. If the last use overflowed, the arena grows to fit it
+		void reset();
+		size_t capacity() const;
+		size_t used() const;
+		size_t highWaterMark() const;
+		bool overflowed() const;
+	private:
+		void* allocateOverflow(size_t size, size_t alignment);
+		void releaseOverflowBlocks();
+	};
+
+	// Bump allocator for data that only lives during a frame. Memory handed out in frame N stays valid
+	// until the same arena is reused, FRAME_ARENA_BUFFER_COUNT frames later. Nothing is ever freed individually.
+	class FrameArena {
+		friend class MiloSubSystemManager;
+		friend class MiloEngine;
+		friend class MiloBenchmark;
+	private:
+		static Array<LinearArena*, FRAME_ARENA_BUFFER_COUNT> s_Arenas;
+		// Read by the render thread when rendering is pipelined
+		static AtomicUInt s_CurrentIndex;
+		static size_t s_Frame;
+	public:
+		static void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+		static LinearArena& current();
+		static uint32_t currentIndex();
+		static size_t frame();
+		// True once every arena has been cycled at least once, so steady state capacities are known
+		static bool warmedUp();
+	private:
+		static void beginFrame();
+		static void init();
+		static void shutdown();
+	public:
+		FrameArena() = delete;
+	};
+
+	template<typename T>
+	struct FrameAllocator {
+
+		using value_type = T;
+		using is_always_equal = std::true_type;
+		using propagate_on_container_copy_assignment = std::true_type;
+		using propagate_on_container_move_assignment = std::true_type;
+		using propagate_on_container_swap = std::true_type;
+
+		FrameAllocator() noexcept = default;
+
+		template<typename U>
+		FrameAllocator(const FrameAllocator<U>&) noexcept {}
+
+		inline T* allocate(size_t n) {
+			return static_cast<T*>(FrameArena::allocate(n * sizeof(T), alignof(T)));
+		}
+
+		inline void deallocate(T* ptr, size_t n) noexcept {}
+
+		template<typename U>
+		inline bool operator==(const FrameAllocator<U>&) const noexcept { return true; }
+
+		template<typename U>
+		inline bool operator!=(const FrameAllocator<U>&) const noexcept { return false; }
+	};
+
+	// Must be rebound (assigned a fresh list) every frame before being used, since its storage is recycled with the arena
+	template<typename T>
+	using FrameArrayList = std::vector<T, FrameAllocator<T>>;
+
+	// Scratch objects are never destroyed, so only trivially destructible types are allowed
+	template<typename T, typename ...Args>
+	inline T* newFrameObject(Args&&... args) {
+		static_assert(std::is_trivially_destructible_v<T>, "Frame objects must be trivially destructible");
+		return new(FrameArena::allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template<typename T>
+	inline FrameArrayList<T> newFrameArrayList(size_t capacity) {
+		FrameArrayList<T> list;
+		list.reserve(capacity);
+		return list;
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Collections.h"
+#include "Concurrency.h"
+#include <condition_variable>
+#include <exception>
+#include <functional>
+
+namespace milo {
+
+	// Fixed pool of worker threads for data parallel work. The thread that submits the work runs chunks too,
+	// so nested or single threaded use never deadlocks.
+	class JobSystem {
+		friend class MiloSubSystemManager;
+	private:
+		struct ParallelBatch {
+			const std::function<void(size_t, size_t, size_t)>* func{nullptr};
+			size_t count{0};
+			size_t chunkSize{0};
+			size_t chunkCount{0};
+			AtomicULong nextChunk{0};
+			AtomicULong pendingChunks{0};
+			// Workers that took the batch from the queue. Guarded by s_Mutex
+			uint32_t activeWorkers{0};
+			// Set once a chunk threw. The chunks left are still counted, but not run
+			AtomicBool failed{false};
+			// First exception thrown by a chunk, rethrown by parallelFor. Guarded by s_Mutex
+			std::exception_ptr error;
+		};
+	private:
+		static ArrayList<Thread> s_Workers;
+		static ArrayList<ParallelBatch*> s_Batches;
+		static Mutex s_Mutex;
+		static std::condition_variable s_WorkAvailable;
+		static std::condition_variable s_BatchFinished;
+		static bool s_Running;
+	public:
+		static uint32_t workerCount();
+		// Splits [0, count) in chunks of at least minChunkSize elements and calls func(chunkIndex, begin, end) for
+		// each of them, in parallel. Returns when every chunk is done. Chunk indices go from 0 to chunkCount(...) - 1.
+		// If func throws, the chunks not started yet are skipped and the first exception is rethrown here
+		static void parallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t, size_t, size_t)>& func);
+		static size_t chunkCount(size_t count, size_t minChunkSize);
+	private:
+		static void init();
+		static void shutdown();
+		static void workerMain();
+		static bool runChunk(ParallelBatch* batch);
+	public:
+		JobSystem() = delete;
+	};
+}
\ No newline at end of file
@@ -20,8 +20,18 @@
 
 void* operator new(size_t size);
 void* operator new[](size_t size);
-void operator delete(void* ptr);
-void operator delete[](void* ptr);
+void operator delete(void* ptr) noexcept;
+void operator delete[](void* ptr) noexcept;
+
+#define MILO_CONCAT_IMPL(a, b) a##b
+#define MILO_CONCAT(a, b) MILO_CONCAT_IMPL(a, b)
+#define MILO_MEMORY_TAG(tag) milo::MemoryTagScope MILO_CONCAT(_memoryTagScope, __LINE__)(tag)
+#define MILO_FORBID_HEAP_ALLOCATIONS(enabled) milo::HeapAllocationGuard MILO_CONCAT(_heapAllocationGuard, __LINE__)(enabled)
+
+#else
+
+#define MILO_MEMORY_TAG(tag)
+#define MILO_FORBID_HEAP_ALLOCATIONS(enabled)
 
 #endif
 
@@ -30,24 +40,102 @@ namespace milo {
 	template<typename T>
 	using Ref = std::shared_ptr<T>;
 
-	// TODO: make this thread safe
+	enum class MemoryTag : uint8_t {
+		General,
+		Assets,
+		Renderer,
+		ECS,
+		Editor,
+		UI,
+		MaxEnum
+	};
+
+	const size_t MEMORY_TAG_COUNT = static_cast<size_t>(MemoryTag::MaxEnum);
+
+	const char* memoryTagName(MemoryTag tag);
+
+	struct MemoryTagStats {
+		int64_t allocatedBytes{0};
+		int64_t peakBytes{0};
+		int64_t aliveAllocations{0};
+		uint64_t totalAllocations{0};
+	};
+
+	struct MemoryCallSite {
+		String location;
+		MemoryTag tag{MemoryTag::General};
+		uint64_t samples{0};
+		uint64_t sampledBytes{0};
+	};
+
+	struct MemoryReport {
+		Array<MemoryTagStats, MEMORY_TAG_COUNT> tags{};
+		MemoryTagStats total{};
+		ArrayList<MemoryCallSite> callSites;
+
+		String str() const;
+	};
+
+	// Allocations are accounted in per thread counters that are merged into the global ones every few
+	// operations (or when flush() is called), so the hot path never takes a lock. Peaks are computed on merge.
 	class MemoryTracker {
 		friend class MiloSubSystemManager;
+		friend class MemoryTagScope;
+	private:
+		struct CallSiteEntry {
+			StackTrace stacktrace;
+			MemoryTag tag;
+			uint64_t samples;
+			uint64_t sampledBytes;
+		};
 	private:
 		static AtomicBool s_Active;
-		static HashMap<uint64_t, size_t>* s_Allocations;
-		static AtomicULong s_TotalAllocations;
-		static AtomicULong s_TotalAllocationSize;
+		static AtomicUInt s_SamplingRate;
+		static Mutex s_CallSitesMutex;
+		static HashMap<size_t, CallSiteEntry>* s_CallSites;
 	public:
-		static void add(uint64_t address, size_t size);
-		static void remove(uint64_t address);
+		static void add(size_t size, MemoryTag tag);
+		static void remove(size_t size, MemoryTag tag);
+		static void flush();
+		static MemoryTag currentTag();
 		static uint64_t aliveAllocationsCount();
 		static uint64_t totalAllocations();
 		static uint64_t totalAllocationSize();
+		static uint64_t peakAllocationSize();
 		static String totalAllocationSizeStr();
+		static MemoryTagStats stats(MemoryTag tag);
+		static MemoryTagStats totalStats();
+		static MemoryReport report();
+		static uint32_t samplingRate();
+		// Captures the call stack of one out of every 'rate' allocations. 0 disables sampling
+		static void setSamplingRate(uint32_t rate);
+		static void resetPeaks();
 	private:
+		static void sample(size_t size, MemoryTag tag);
 		static void init();
 		static void shutdown();
-		static HashMap<uint64_t, size_t>& allocations();
 	};
-}
\ No newline at end of file
+
+	class MemoryTagScope {
+	private:
+		MemoryTag m_LastTag;
+	public:
+		explicit MemoryTagScope(MemoryTag tag);
+		~MemoryTagScope();
+		MemoryTagScope(const MemoryTagScope&) = delete;
+		MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+	};
+
+	// In debug builds, any global operator new performed by this thread while the guard is enabled is reported as an error
+	class HeapAllocationGuard {
+	private:
+		bool m_LastValue;
+	public:
+		explicit HeapAllocationGuard(bool enabled = true);
+		~HeapAllocationGuard();
+		HeapAllocationGuard(const HeapAllocationGuard&) = delete;
+		HeapAllocationGuard& operator=(const HeapAllocationGuard&) = delete;
+	public:
+		static bool heapAllocationsForbidden();
+	};
+}
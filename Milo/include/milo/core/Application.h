@@ -2,12 +2,43 @@
 
 #include "milo/common/Common.h"
 #include "milo/graphics/GraphicsAPI.h"
+#include "milo/logging/Log.h"
 
 namespace milo {
 
+	enum class HeadlessImageFormat {
+		None,
+		PNG,
+		EXR
+	};
+
+	// Renders without a window nor a swapchain, into offscreen framebuffers whose color attachment is read back and
+	// written to disk as an image sequence (see VulkanFrameReadback). Meant for batch and server side rendering
+	struct HeadlessConfiguration {
+		bool enabled = false;
+		Size size = {1280, 720};
+		// Frames to render before the application exits. 0 renders until Application::exit()
+		uint32_t frames = 0;
+		// Images are written as <outputDirectory>/frame_<number>.<png|exr>
+		String outputDirectory = "frames";
+		// PNG stores the 8 bit color a window would show, EXR the linear 32 bit float one. None only measures rendering throughput
+		HeadlessImageFormat imageFormat = HeadlessImageFormat::PNG;
+	};
+
 	struct AppConfiguration {
 
 		String applicationName = "Milo Application";
+		// Records the commands of a frame on a render thread while the next one is simulated. Only applies
+		// to SimulationState::Play, the editor always renders on the main thread (see FramePipeline)
+		bool pipelinedRendering = false;
+		// Reloads the shaders, materials and textures whose files change while the application runs (see HotReloader)
+		bool hotReload = true;
+		// Formats and writes log messages on a logging thread, so callers never wait for I/O (see Log::startAsync)
+		bool asyncLogging = true;
+		Log::OverflowPolicy logOverflowPolicy = Log::OverflowPolicy::Drop;
+		// If set, log messages are also written to this binary structured log. Expand it with milo_logdecode
+		String binaryLogFile;
+		HeadlessConfiguration headless;
 		// TODO
 	};
 
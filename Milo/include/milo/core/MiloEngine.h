@@ -11,6 +11,8 @@
 
 namespace milo {
 
+	struct FrameRenderData;
+
 	struct MiloExitResult {
 		int32_t exitCode;
 		String message;
@@ -18,19 +20,34 @@ namespace milo {
 		 inline bool success() const noexcept {return exitCode == MILO_SUCCESS;}
 	};
 
+	struct FrameStats {
+		size_t ups{0};
+		size_t fps{0};
+		float deltaTime{0};
+		float frameTime{0};
+		MemoryTagStats memory{};
+		Array<MemoryTagStats, MEMORY_TAG_COUNT> memoryByTag{};
+	};
+
 	class MiloEngine {
 	private:
 		static AtomicBool s_AlreadyLaunched;
+		static FrameStats s_FrameStats;
 	public:
 		static MiloExitResult launch(Application& application);
+		static const FrameStats& frameStats();
 	private:
 		Application& m_Application;
 	public:
 		MiloEngine() = delete;
 	private:
 		static void run();
-		static void update(float& updateDelay, float& lastUpdate);
+		static void runHeadless();
+		static void update(float& updateDelay, float& lastUpdate, bool pipelined);
+		static void simulate();
+		static void lateUpdate(bool pipelined);
 		static void render();
+		static void renderPipelined(const FrameRenderData& frame);
 		static void init();
 		static void shutdown();
 		static void showDebugInfo(float& debugTime);
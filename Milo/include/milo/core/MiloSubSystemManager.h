@@ -9,11 +9,18 @@ namespace milo {
 
 	class MiloSubSystemManager {
 		friend class MiloEngine;
+		friend class MiloBenchmark;
+		friend class ShaderCooker;
 	private:
 		// TODO: subsystems in order
 	private:
 		static void init();
 		static void shutdown();
+		// Applies the logging options of the application configuration
+		static void initLogging();
+		// Only the subsystems that need neither a window nor a graphics context
+		static void initHeadless();
+		static void shutdownHeadless();
 	public:
 		MiloSubSystemManager() = delete;
 	};
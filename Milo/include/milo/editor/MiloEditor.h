@@ -29,12 +29,16 @@ namespace milo {
 		static void update();
 		static void render();
 		static EditorCamera& camera();
+		static EntityId selectedEntity();
 	private:
 		static void renderSceneViewport();
+		// Selects the entity clicked in the scene viewport, through the entity ID map
+		static void pickEntities(const Texture2D& viewportTexture);
 		static void setupDockSpace();
 		static void init();
 		static void shutdown();
 		static void setupMenuBar();
+		static void renderStatistics();
 
 		static void setupDockSpace(const char* dockSpaceWindowName, const char* dockSpaceName, bool& firstTime);
 	};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "milo/scenes/Scene.h"
+#include <unordered_set>
+#include <set>
+
+namespace milo {
+
+	// The entity tree of a scene flattened into the rows the hierarchy panel shows, in display order: each entity is
+	// followed by the subtrees of its children if it is expanded. It follows the scene through its hierarchy changes
+	// (see Scene::consumeHierarchyChanges), so keeping it up to date costs what changed and not the size of the scene.
+	//
+	// Entity names are indexed by the start of each of their words, so a search is a range lookup in the index
+	class SceneHierarchyCache {
+	public:
+		struct Row {
+			EntityId entity;
+			uint32_t depth;
+		};
+		// Past this many changes in a frame (a model import, a scene reload) reading the whole tree again is cheaper
+		static const size_t MAX_INCREMENTAL_CHANGES = 1024;
+	private:
+		Scene* m_Scene{nullptr};
+		ArrayList<Row> m_Rows;
+		std::unordered_set<EntityId> m_Expanded;
+		ArrayList<SceneHierarchyChange> m_Changes;
+		// Lower case name from the start of each word, and the entity it belongs to
+		std::set<Pair<String, EntityId>> m_NameIndex;
+		HashMap<EntityId, String> m_IndexedNames;
+		// Incremented every time the rows or the name index change
+		uint64_t m_Version{0};
+	public:
+		// Applies the hierarchy changes of scene since the last update
+		void update(Scene* scene);
+		const ArrayList<Row>& rows() const;
+		uint64_t version() const;
+		bool expanded(EntityId entityId) const;
+		// Shows or hides the children of the entity of the row
+		void setExpanded(size_t row, bool expanded);
+		// Entities with a word whose start matches query, ignoring case
+		void search(const String& query, ArrayList<EntityId>& results) const;
+	private:
+		void rebuild();
+		void relocate(EntityId entityId);
+		void remove(EntityId entityId);
+		void refreshChildren(size_t row);
+		void appendSubtree(EntityId entityId, uint32_t depth, ArrayList<Row>& rows) const;
+		size_t findRow(EntityId entityId) const;
+		size_t subtreeEnd(size_t row) const;
+		void indexName(EntityId entityId);
+		void unindexName(EntityId entityId);
+	};
+}
\ No newline at end of file
@@ -4,15 +4,22 @@
 #include "milo/scenes/Scene.h"
 #include "milo/scenes/Entity.h"
 #include "milo/assets/AssetManager.h"
+#include "milo/editor/SceneHierarchyCache.h"
 
 namespace milo {
 
 	using EntitySelectedCallback = Function<void, Entity>;
 	using EntityDeletedCallback = Function<void, Entity>;
 
+	// Only the rows inside the window are drawn, out of the flattened tree kept by SceneHierarchyCache,
+	// so the cost of the panel depends on its height and not on the number of entities of the scene
 	class SceneHierarchyPanel {
 	private:
 		Entity m_SelectedEntity = {NULL_ENTITY, nullptr};
+		SceneHierarchyCache m_Cache;
+		char m_SearchQuery[128]{};
+		ArrayList<EntityId> m_SearchResults;
+		uint64_t m_SearchVersion{UINT64_MAX};
 		ArrayList<EntitySelectedCallback> m_SelectedCallbacks;
 		ArrayList<EntityDeletedCallback> m_DeletedCallbacks;
 	public:
@@ -26,7 +33,12 @@ namespace milo {
 		void addSelectedCallback(EntitySelectedCallback callback);
 		void addDeletedCallback(EntityDeletedCallback callback);
 	private:
-		void drawEntityNode(Entity& entity, const EntityBasicInfo& info);
+		void drawSearchBox();
+		void drawHierarchy(Scene* scene);
+		void drawSearchResults(Scene* scene);
+		// Returns whether the node is open. Sets deleted if the user chose to delete the entity
+		bool drawEntityNode(Entity& entity, ImGuiTreeNodeFlags flags, bool& deleted);
+		void deleteEntity(Entity entity);
 		void handleDragDrop(const ImRect& windowRect);
 		void handlePopupMenu(Scene* scene);
 		void createEntityWithMesh(Scene* scene, const String& name, Mesh* mesh);
@@ -2,6 +2,7 @@
 
 #include "milo/common/Common.h"
 #include "milo/graphics/textures/Texture.h"
+#include "milo/assets/textures/Icon.h"
 #include <imgui/imgui.h>
 
 namespace milo {
@@ -34,6 +35,8 @@ namespace milo {
 		void image(const Texture2D& texture, const Size& size = {0, 0}, const ImVec2& uv0 = ImVec2(0, 0), const ImVec2& uv1 = ImVec2(1,1),
 				   const ImVec4& tint_col = ImVec4(1,1,1,1), const ImVec4& border_col = ImVec4(0,0,0,0));
 
+		void icon(const Icon& icon, const Size& size = {0, 0});
+
 		void imageButton(const String& title, const Texture2D& texture, const Size& size = {0, 0});
 
 		void beginGrid(uint32_t columns = 2);
@@ -14,9 +14,15 @@ namespace milo {
 	private:
 		static GraphicsAPI s_GraphicsAPI;
 		static GraphicsContext* s_GraphicsContext;
+		static bool s_Headless;
+		static Size s_OffscreenSize;
 	public:
 		static GraphicsAPI graphicsAPI();
 		static GraphicsContext* graphicsContext();
+		// True if the application renders without a window (see HeadlessConfiguration)
+		static bool headless();
+		// Size of the main window, or of the offscreen frames when there is no window
+		static Size renderTargetSize();
 	private:
 		static void init();
 		static void shutdown();
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "FrameGraphBuilder.h"
+
+namespace milo {
+
+	struct FrameGraphBarrier {
+		FrameGraphResourceId resource{0};
+		FrameGraphAccess srcAccess{FrameGraphAccess::None};
+		FrameGraphAccess dstAccess{FrameGraphAccess::None};
+		FrameGraphQueue srcQueue{FrameGraphQueue::Graphics};
+		FrameGraphQueue dstQueue{FrameGraphQueue::Graphics};
+		// Previous contents are not needed (first use of a transient), so the layout transition starts from undefined
+		bool discard{false};
+	};
+
+	struct CompiledFrameGraphPass {
+		RenderPass* pass{nullptr};
+		FrameGraphQueue queue{FrameGraphQueue::Graphics};
+		// Executed on the queue of the pass right before it: layout transitions and queue ownership acquires
+		ArrayList<FrameGraphBarrier> barriers;
+		// Executed on the queue of the pass right after it: queue ownership releases to the next user
+		ArrayList<FrameGraphBarrier> releases;
+		// Accesses of the pass, so the backend knows the state it leaves the resources in
+		ArrayList<FrameGraphResourceUse> uses;
+	};
+
+	struct FrameGraphTransientTexture {
+		FrameGraphResourceId resource{0};
+		String name;
+		FrameGraphTextureDescription description{};
+		uint32_t firstPass{0};
+		uint32_t lastPass{0};
+		// Transients with the same slot share their memory
+		uint32_t aliasSlot{0};
+	};
+
+	struct CompiledFrameGraph {
+		// Execution order, without the culled passes
+		ArrayList<CompiledFrameGraphPass> passes;
+		ArrayList<FrameGraphTransientTexture> transientTextures;
+		uint32_t aliasSlotCount{0};
+		uint32_t culledPassCount{0};
+		size_t topologyHash{0};
+		// Increases every time the graph is rebuilt
+		uint32_t version{0};
+	};
+}
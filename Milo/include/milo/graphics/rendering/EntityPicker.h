@@ -0,0 +1,45 @@
+#pragma once
+
+#include "milo/common/Common.h"
+#include "milo/scenes/EntityComponentSystem.h"
+
+namespace milo {
+
+	// Rectangle of the entity ID map, in texels from its first row
+	struct EntityPickRegion {
+		uint32_t x{0};
+		uint32_t y{0};
+		uint32_t width{1};
+		uint32_t height{1};
+	};
+
+	struct EntityPickResult {
+		EntityPickRegion region{};
+		// Distinct entities drawn in the region, the one covering more texels first. They may not exist anymore
+		ArrayList<EntityId> entities;
+	};
+
+	// Finds the entities under a region of the viewport without testing them one by one on the CPU.
+	//
+	// The pre-depth pass writes the id of the entity of each draw to an R32_UINT attachment. A request copies its region
+	// into a small staging buffer after the frame it was taken in, which is read once the presenter has waited that
+	// frame's fence, so results arrive a frame later and neither the CPU nor the GPU ever wait for them
+	class EntityPicker {
+	public:
+		// Larger requests are clamped, so the readback stays a few kilobytes
+		static const uint32_t MAX_REGION_SIZE = 64;
+	private:
+		Mutex m_Mutex;
+		Optional<EntityPickRegion> m_Request;
+		Optional<EntityPickResult> m_Result;
+	public:
+		// Replaces the pending request, if any
+		void pick(uint32_t x, uint32_t y, uint32_t width = 1, uint32_t height = 1);
+		// Moves the result of the last request into result, once. Returns false while it is not ready
+		bool poll(EntityPickResult& result);
+		// Render side. Takes the pending request to be copied this frame
+		bool takeRequest(EntityPickRegion& region);
+		// Render side. ids are the width * height texels of the region, row by row
+		void resolve(const EntityPickRegion& region, const uint32_t* ids);
+	};
+}
\ No newline at end of file
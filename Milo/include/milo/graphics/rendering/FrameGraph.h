@@ -3,18 +3,30 @@
 #include <milo/graphics/rendering/descriptions/ResourceDescriptions.h>
 #include "milo/graphics/textures/Texture.h"
 #include "milo/graphics/rendering/passes/RenderPass.h"
+#include "milo/graphics/rendering/CompiledFrameGraph.h"
+#include "milo/graphics/rendering/GPUProfiler.h"
 #include "milo/logging/Log.h"
 #include "milo/time/Time.h"
 
 namespace milo {
 
+	// Passes are pushed every frame in setup and declare the resources they read and write (RenderPass::declareResources).
+	// From those declarations the graph derives the execution order, culls the passes whose results nobody uses,
+	// computes the barriers and queue ownership transfers between passes and assigns memory to transient textures,
+	// letting transients whose lifetimes do not overlap share it. The compiled graph is only rebuilt when the
+	// declarations change (passes added or removed, a transient resized...).
 	class FrameGraph {
 		friend class WorldRenderer;
 	protected:
 		ArrayList<RenderPass*> m_RenderPasses;
-		ArrayList<RenderPass*> m_RenderPassExecutionList;
+		HashMap<RenderPassId, RenderPass*> m_RenderPassesById;
+		FrameArrayList<RenderPass*> m_RenderPassExecutionList;
 		HashMap<RenderPassId, uint32_t> m_RenderPassUnusedCount;
 		FrameGraphResourcePool* m_ResourcePool = nullptr;
+		GPUProfiler* m_GPUProfiler = nullptr;
+		HashMap<FrameGraphResourceId, FrameGraphResource> m_Resources;
+		ArrayList<FrameGraphPassDeclaration> m_Declarations;
+		CompiledFrameGraph m_CompiledGraph;
 	protected:
 		FrameGraph();
 		~FrameGraph();
@@ -23,6 +35,8 @@ namespace milo {
 		virtual void setup(Scene* scene);
 		virtual void compile(Scene* scene);
 		virtual void execute(Scene* scene);
+		GPUProfiler& gpuProfiler() const;
+		const CompiledFrameGraph& compiledGraph() const;
 	protected:
 
 #define RENDER_PASS_NAME(T) #T
@@ -42,20 +56,15 @@ namespace milo {
 				Log::debug("{} created after {} ms", name, ms);
 #endif
 				m_RenderPasses.push_back(renderPass);
+				m_RenderPassesById[T::id()] = renderPass;
 			}
 			m_RenderPassExecutionList.push_back(renderPass);
 		}
 
 		template<typename T>
 		T* get() {
-			const RenderPassId id = T::id();
-			for(RenderPass* renderPass : m_RenderPasses) {
-				RenderPassId otherId = renderPass->getId();
-				if(otherId == id) {
-					return dynamic_cast<T*>(renderPass);
-				}
-			}
-			return nullptr;
+			auto it = m_RenderPassesById.find(T::id());
+			return it == m_RenderPassesById.end() ? nullptr : static_cast<T*>(it->second);
 		}
 
 		template<typename T>
@@ -64,6 +73,13 @@ namespace milo {
 		}
 
 		void deleteUnusedRenderPasses();
+	private:
+		size_t declarePasses();
+		void build(size_t topologyHash);
+		void sortPasses(ArrayList<uint32_t>& order) const;
+		void cullPasses(const ArrayList<uint32_t>& order, ArrayList<bool>& alive);
+		void computeBarriers();
+		void assignTransientMemory();
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "milo/common/Common.h"
+#include "milo/assets/images/PixelFormat.h"
+#include "milo/graphics/textures/Texture.h"
+
+namespace milo {
+
+	using FrameGraphResourceId = Handle;
+
+	class RenderPass;
+
+	enum class FrameGraphQueue {
+		Graphics, Compute
+	};
+
+	// How a pass uses a resource. Each backend maps them to layouts, pipeline stages and access masks
+	enum class FrameGraphAccess {
+		None,
+		ColorAttachment,
+		DepthAttachment,
+		SampledFragment,
+		SampledDepthFragment,
+		SampledCompute,
+		StorageReadFragment,
+		StorageReadCompute,
+		StorageWriteCompute
+	};
+
+	bool isWriteAccess(FrameGraphAccess access);
+
+	struct FrameGraphTextureDescription {
+		PixelFormat format{PixelFormat::RGBA32F};
+		Size size{};
+		uint32_t layers{1};
+		TextureUsageFlags usage{TEXTURE_USAGE_UNDEFINED_BIT};
+
+		bool operator==(const FrameGraphTextureDescription& other) const;
+		bool operator!=(const FrameGraphTextureDescription& other) const;
+		uint64_t sizeInBytes() const;
+	};
+
+	struct FrameGraphResourceUse {
+		FrameGraphResourceId resource{0};
+		FrameGraphAccess access{FrameGraphAccess::None};
+	};
+
+	enum class FrameGraphResourceKind {
+		// Owned by the graph. Only alive between its first and last use, so its memory may be shared with other transients
+		Transient,
+		// Owned by a pass or the resource pool. The graph inserts barriers for it
+		Imported,
+		// Owned and synchronized outside the graph (e.g. the default framebuffers). Only used for ordering and culling
+		External
+	};
+
+	struct FrameGraphResource {
+		FrameGraphResourceId id{0};
+		String name;
+		FrameGraphResourceKind kind{FrameGraphResourceKind::Imported};
+		FrameGraphTextureDescription description{};
+		// Consumed outside the graph (editor viewport, presentation...), so its writers are never culled
+		bool exported{false};
+	};
+
+	struct FrameGraphPassDeclaration {
+		RenderPass* pass{nullptr};
+		FrameGraphQueue queue{FrameGraphQueue::Graphics};
+		bool sideEffects{false};
+		ArrayList<FrameGraphResourceUse> reads;
+		ArrayList<FrameGraphResourceUse> writes;
+
+		void clear();
+	};
+
+	// Given to RenderPass::declareResources to describe what a pass reads and writes.
+	// A resource written by several passes is modified by them in the order they were pushed.
+	// Reads always see the result of every write, no matter the order in which the passes were pushed.
+	class FrameGraphBuilder {
+		friend class FrameGraph;
+	private:
+		FrameGraphPassDeclaration& m_Pass;
+		HashMap<FrameGraphResourceId, FrameGraphResource>& m_Resources;
+	private:
+		FrameGraphBuilder(FrameGraphPassDeclaration& pass, HashMap<FrameGraphResourceId, FrameGraphResource>& resources);
+	public:
+		FrameGraphBuilder(const FrameGraphBuilder& other) = delete;
+		FrameGraphBuilder& operator=(const FrameGraphBuilder& other) = delete;
+		void setQueue(FrameGraphQueue queue);
+		// The pass is never culled, even if nobody reads what it writes
+		void setSideEffects();
+		FrameGraphResourceId createTexture(const String& name, const FrameGraphTextureDescription& description);
+		FrameGraphResourceId importResource(const String& name, bool exported = false);
+		FrameGraphResourceId importResource(FrameGraphResourceId id, const String& name, bool exported = false);
+		FrameGraphResourceId externalResource(const String& name, bool exported = false);
+		void read(FrameGraphResourceId resource, FrameGraphAccess access);
+		void write(FrameGraphResourceId resource, FrameGraphAccess access);
+	private:
+		FrameGraphResource& declare(FrameGraphResourceId id, const String& name, FrameGraphResourceKind kind);
+	public:
+		static FrameGraphResourceId resourceId(const String& name);
+	};
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "WorldRenderer.h"
+#include <condition_variable>
+#include <exception>
+
+namespace milo {
+
+	// Hands the frame data built by the simulation thread to a dedicated render thread, so the commands of frame N
+	// are recorded while the simulation advances to frame N + 1. Pushed frame data is never modified again.
+	//
+	// While frames are in flight the render thread owns the GPU: the simulation thread must call flush() before
+	// creating or updating graphics resources (loading assets, replacing the scene...). The editor UI reads and edits
+	// the live scene while it is drawn, so MiloEngine only pipelines SimulationState::Play frames.
+	class FramePipeline {
+		friend class MiloEngine;
+	public:
+		// One frame queued, one being recorded and one being built live in different frame arenas,
+		// so none of them is recycled while it is still in use
+		static const uint32_t MAX_QUEUED_FRAMES = FRAME_ARENA_BUFFER_COUNT - 2;
+	private:
+		static Thread s_RenderThread;
+		static Function<void, const FrameRenderData&> s_RenderFunction;
+		static Queue<const FrameRenderData*> s_Queue;
+		static Mutex s_Mutex;
+		static std::condition_variable s_FramePushed;
+		static std::condition_variable s_FrameConsumed;
+		static bool s_Running;
+		static bool s_Rendering;
+		static std::exception_ptr s_Error;
+	public:
+		static bool running();
+		// Blocks until every pushed frame has been rendered. Rethrows the error of the render thread, if any
+		static void flush();
+	private:
+		static void start(Function<void, const FrameRenderData&> renderFunction);
+		static void stop();
+		// Blocks while the queue is full
+		static void push(const FrameRenderData& frame);
+		static void renderThreadMain();
+		static void rethrowRenderError();
+	public:
+		FramePipeline() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "milo/common/Common.h"
+#include "milo/time/Time.h"
+
+namespace milo {
+
+	const uint32_t MAX_GPU_PROFILED_PASSES = 32;
+	// Pipeline statistics queries are opened once per recorded command buffer, so a pass may use more than one
+	const uint32_t MAX_GPU_STATISTICS_QUERIES = 64;
+
+	struct GPUPipelineStatistics {
+		uint64_t inputAssemblyVertices{0};
+		uint64_t inputAssemblyPrimitives{0};
+		uint64_t vertexShaderInvocations{0};
+		uint64_t clippingPrimitives{0};
+		uint64_t fragmentShaderInvocations{0};
+		uint64_t computeShaderInvocations{0};
+	};
+
+	struct GPUPassTiming {
+		String name;
+		// Relative to the beginning of the frame on the GPU
+		double startMs{0};
+		double durationMs{0};
+		// In the CPU profiler clock
+		TimePoint startTime;
+		TimePoint endTime;
+		bool hasStatistics{false};
+		GPUPipelineStatistics statistics{};
+	};
+
+	struct GPUFrameTimings {
+		size_t frame{0};
+		double totalMs{0};
+		// If false, GPU times are aligned to the CPU submission of the frame, which is only a lower bound
+		bool calibrated{false};
+		ArrayList<GPUPassTiming> passes;
+	};
+
+	// Measures how long each FrameGraph pass takes on the GPU. Results are read back once the frame
+	// that produced them is no longer in flight, so they lag a few frames behind
+	class GPUProfiler {
+	protected:
+		bool m_Enabled{true};
+		bool m_PipelineStatisticsEnabled{false};
+		GPUFrameTimings m_LastFrame{};
+	public:
+		virtual ~GPUProfiler() = default;
+		virtual void beginFrame() = 0;
+		virtual void beginPass(const String& name) = 0;
+		virtual void endPass() = 0;
+		virtual void endFrame() = 0;
+		virtual bool timestampsSupported() const = 0;
+		virtual bool pipelineStatisticsSupported() const = 0;
+		virtual bool calibratedTimestampsSupported() const = 0;
+		inline bool enabled() const {return m_Enabled;}
+		inline void setEnabled(bool enabled) {m_Enabled = enabled;}
+		inline bool pipelineStatisticsEnabled() const {return m_PipelineStatisticsEnabled;}
+		inline void setPipelineStatisticsEnabled(bool enabled) {m_PipelineStatisticsEnabled = enabled;}
+		inline const GPUFrameTimings& lastFrame() const {return m_LastFrame;}
+	public:
+		static GPUProfiler* create();
+	};
+}
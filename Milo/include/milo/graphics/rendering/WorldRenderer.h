@@ -3,6 +3,8 @@
 #include "FrameGraph.h"
 #include "milo/scenes/Scene.h"
 #include "milo/graphics/rendering/GraphicsPresenter.h"
+#include "milo/graphics/rendering/EntityPicker.h"
+#include "milo/assets/materials/MaterialResourcePool.h"
 
 
 namespace milo {
@@ -12,6 +14,8 @@ namespace milo {
 		Matrix4 transform{Matrix4(1.0f)};
 		Mesh* mesh{nullptr};
 		Material* material{nullptr};
+		// Written to the entity ID map for picking
+		EntityId entity{NULL_ENTITY};
 
 		inline uint64_t hash() const noexcept {
 			// TODO: use handles
@@ -28,7 +32,7 @@ namespace milo {
 	struct LightEnvironment {
 		Skybox* skybox{nullptr};
 		Optional<DirectionalLight> dirLight{};
-		ArrayList<PointLight> pointLights;
+		FrameArrayList<PointLight> pointLights;
 		Color ambientColor{0.2f, 0.2f, 0.2f, 1.0f};
 	};
 
@@ -47,6 +51,31 @@ namespace milo {
 		float aspect{0};
 	};
 
+	// CPU side data built from the scene before any command is recorded. It is never modified once built, and render passes
+	// read it instead of the scene, so it can be recorded while the simulation builds the next one (see FramePipeline)
+	struct FrameRenderData {
+		FrameArrayList<DrawCommand> drawCommands;
+		FrameArrayList<DrawCommand> shadowDrawCommands;
+		CameraInfo camera{};
+		LightEnvironment lights{};
+		Array<ShadowCascade, 4> shadowCascades{};
+		// Skybox of the scene SkyboxView, drawn as background
+		Skybox* background{nullptr};
+		// Set if the dynamic sky of the scene changed. Applied by the thread that renders the frame
+		PreethamSkyUpdateRequest skyUpdate{};
+		// Materials changed since the last frame was built. Applied by the thread that renders the frame
+		ArrayList<MaterialSnapshot> materialUpdates;
+		Viewport viewport{};
+		SimulationState simulationState{SimulationState::Editor};
+		Scene* scene{nullptr};
+		// Entity selected in the editor, outlined if entity IDs are rendered
+		EntityId selectedEntity{NULL_ENTITY};
+		// Frame in which the lists were allocated. They stay valid for FRAME_ARENA_BUFFER_COUNT frames
+		size_t frame{0};
+
+		Size viewportSize() const;
+	};
+
 	class WorldRenderer {
 		friend class MiloEngine;
 		friend class MiloSubSystemManager;
@@ -62,20 +91,25 @@ namespace milo {
 		bool m_ShadowCascadeFading{false};
 		float m_CascadeFading{1};
 		bool m_UseMultithreading{true};
-		ArrayList<DrawCommand> m_DrawCommands;
-		ArrayList<DrawCommand> m_ShadowDrawCommands;
-		CameraInfo m_Camera{};
-		LightEnvironment m_LightEnvironment{};
+		bool m_EntityIdsEnabled{true};
+		EntityPicker m_EntityPicker;
+		// One per frame arena, so the frame data of a frame is not overwritten while its lists are still alive
+		Array<FrameRenderData, FRAME_ARENA_BUFFER_COUNT> m_Frames{};
+		// Last frame data built from the scene
+		FrameRenderData* m_LastFrame{nullptr};
+		// Frame data being recorded, or recorded by the last render call
+		const FrameRenderData* m_RenderFrame{nullptr};
 		float m_ShadowsMaxDistance{200};
 		Size m_ShadowsMapSize{4096, 4096};
-		Array<ShadowCascade, 4> m_ShadowCascades{};
 	private:
 		WorldRenderer();
 		~WorldRenderer();
-		void render(Scene* scene);
+		void render(const FrameRenderData& frame);
 	public:
 		FrameGraphResourcePool& resources() const;
+		const FrameGraph& frameGraph() const;
 		Framebuffer& getFramebuffer() const;
+		GPUProfiler& gpuProfiler() const;
 		bool showGrid() const;
 		void setShowGrid(bool show);
 		bool shadowsEnabled() const;
@@ -92,9 +126,13 @@ namespace milo {
 		void setShadowCascadeFadingValue(float value);
 		bool useMultithreading() const;
 		void setUseMultithreading(bool useMultithreading);
-		void submit(DrawCommand drawCommand, bool castShadows);
-		const ArrayList<DrawCommand>& drawCommands() const;
-		const ArrayList<DrawCommand>& shadowsDrawCommands() const;
+		bool entityIdsEnabled() const;
+		void setEntityIdsEnabled(bool enabled);
+		// Whether this frame writes the entity ID map. Only the editor needs it, and only if enabled
+		bool renderEntityIds() const;
+		EntityPicker& entityPicker();
+		const FrameArrayList<DrawCommand>& drawCommands() const;
+		const FrameArrayList<DrawCommand>& shadowsDrawCommands() const;
 		const CameraInfo& camera() const;
 		const LightEnvironment& lights() const;
 		float shadowsMaxDistance() const;
@@ -102,19 +140,30 @@ namespace milo {
 		const Size& shadowsMapSize() const;
 		void setShadowsMapSize(const Size& size);
 		const Array<ShadowCascade, 4>& shadowCascades() const;
+		const FrameRenderData& frameData() const;
 	private:
 		static WorldRenderer* s_Instance;
+		// Rendered instead of a skybox whose maps are still being generated
+		static String s_LastReadySkybox;
 	public:
 		static WorldRenderer& get();
+		// Render preparation stages. They only read the scene and write the given frame data,
+		// so they can run without a graphics context (see milo_bench)
+		static void prepareFrame(Scene* scene, FrameRenderData& frame);
+		static void getCameraInfo(Scene* scene, CameraInfo& camera);
+		static void generateLightEnvironment(Scene* scene, FrameRenderData& frame);
+		static void calculateShadowCascades(FrameRenderData& frame);
+		static void collectDrawCommands(Scene* scene, FrameRenderData& frame);
+		static void sortDrawCommands(FrameRenderData& frame);
 	private:
 		static void render();
 		static void update();
-		static void generateDrawCommands(Scene* scene);
+		static FrameRenderData& buildFrame(Scene* scene);
+		// Uploads the material changes and regenerates the maps of the dynamic sky if it changed. Only for the thread that owns the GPU
+		static void updateAssets(const FrameRenderData& frame);
+		static Skybox* readySkybox(Skybox* skybox);
 		static void init();
 		static void shutdown();
-		static void getCameraInfo(Scene* scene);
-		static void generateLightEnvironment(Scene* scene);
-		static void calculateShadowCascades(Scene* scene);
 	};
 
 }
\ No newline at end of file
@@ -6,11 +6,15 @@
 #include "milo/graphics/textures/Texture.h"
 #include "milo/scenes/Scene.h"
 #include "milo/graphics/rendering/Framebuffer.h"
+#include "milo/graphics/rendering/CompiledFrameGraph.h"
 
 namespace milo {
 
 	class FrameGraphResourcePool {
 		friend class WorldRenderer;
+	public:
+		// Frame graph name of the default framebuffers. Their layouts are handled by the passes that use them
+		static const String DEFAULT_FRAMEBUFFER;
 	protected:
 		ArrayList<Framebuffer*> m_DefaultFramebuffers;
 		HashMap<Handle, Ref<Framebuffer>> m_Framebuffers;
@@ -36,6 +40,11 @@ namespace milo {
 		Ref<Cubemap> getCubemap(Handle handle) const;
 		void putCubemap(Handle handle, Ref<Cubemap> cubemap);
 		void removeCubemap(Handle handle);
+		// Called by the frame graph every time it is rebuilt, to create the transient resources it declares
+		virtual void realize(const CompiledFrameGraph& graph) = 0;
+		// Called by the frame graph around the execution of a compiled pass, to run the barriers derived for it
+		virtual void beginPass(const CompiledFrameGraph& graph, uint32_t passIndex) = 0;
+		virtual void endPass(const CompiledFrameGraph& graph, uint32_t passIndex) = 0;
 	protected:
 		virtual uint32_t currentFramebufferIndex() const = 0;
 		virtual uint32_t maxDefaultFramebuffersCount() const = 0;
@@ -9,3 +9,4 @@
 #include "BoundingVolumeRenderPass.h"
 #include "LightCullingPass.h"
 #include "ShadowMapRenderPass.h"
+#include "SelectionOutlineRenderPass.h"
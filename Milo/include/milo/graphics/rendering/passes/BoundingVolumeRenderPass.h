@@ -10,6 +10,7 @@ namespace milo {
 		virtual ~BoundingVolumeRenderPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
 		static BoundingVolumeRenderPass* create();
 		static size_t id();
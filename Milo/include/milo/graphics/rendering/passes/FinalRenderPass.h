@@ -9,6 +9,7 @@ namespace milo {
 		virtual ~FinalRenderPass() = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
 		static FinalRenderPass* create();
 		static size_t id();
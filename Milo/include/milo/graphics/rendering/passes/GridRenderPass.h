@@ -10,6 +10,7 @@ namespace milo {
 		virtual ~GridRenderPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
 		static GridRenderPass* create();
 		static size_t id();
@@ -17,7 +17,10 @@ namespace milo {
 		virtual ~LightCullingPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
+		// Frame graph resources
+		static const String VISIBLE_LIGHTS;
 		static LightCullingPass* create();
 		static size_t id();
 		static Handle getVisibleLightsBufferHandle(uint32_t index = UINT32_MAX);
@@ -13,6 +13,7 @@ namespace milo {
 		virtual ~PBRForwardRenderPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
 		static PBRForwardRenderPass* create();
 		static size_t id();
@@ -10,7 +10,15 @@ namespace milo {
 		virtual ~PreDepthRenderPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
+		// Frame graph resources
+		static const String DEPTH_MAP;
+		static const String DEBUG_DEPTH_MAP;
+		static const String DEPTH_BUFFER;
+		// R32_UINT id of the entity drawn at each pixel, NULL_ENTITY where there is none. Only written if
+		// WorldRenderer::renderEntityIds()
+		static const String ENTITY_ID_MAP;
 		static PreDepthRenderPass* create();
 		static size_t id();
 		static Handle getFramebufferHandle(uint32_t index = UINT32_MAX);
@@ -27,6 +27,9 @@ namespace milo {
 	public:
 		virtual ~RenderPass() = default;
 		virtual RenderPassId getId() const = 0;
+		// Resources the pass reads and writes this frame. Passes that declare nothing keep their position in the
+		// list they were pushed to and are never culled
+		virtual void declareResources(FrameGraphBuilder& builder) const {}
 		virtual bool shouldCompile(Scene* scene) const = 0;
 		virtual void compile(Scene* scene, FrameGraphResourcePool* resourcePool) = 0;
 		virtual void execute(Scene* scene) = 0;
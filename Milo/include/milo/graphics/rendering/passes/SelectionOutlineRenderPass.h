@@ -0,0 +1,19 @@
+#pragma once
+
+#include "RenderPass.h"
+
+namespace milo {
+
+	// Outlines the selected entity of the editor from the entity ID map of the pre-depth pass
+	class SelectionOutlineRenderPass : public RenderPass {
+	public:
+		SelectionOutlineRenderPass() = default;
+		virtual ~SelectionOutlineRenderPass() override = default;
+		RenderPassId getId() const override;
+		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
+	public:
+		static SelectionOutlineRenderPass* create();
+		static size_t id();
+	};
+}
\ No newline at end of file
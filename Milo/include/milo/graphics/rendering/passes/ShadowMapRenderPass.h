@@ -5,6 +5,7 @@
 namespace milo {
 
 	constexpr uint32_t MAX_SHADOW_CASCADES = 4;
+	constexpr uint32_t SHADOW_MAP_RESOLUTION = 4096;
 
 	class ShadowMapRenderPass : public RenderPass {
 	public:
@@ -12,7 +13,10 @@ namespace milo {
 		virtual ~ShadowMapRenderPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
+		// Frame graph resources
+		static const String SHADOW_MAP;
 		static ShadowMapRenderPass* create();
 		static size_t id();
 		static Handle getDepthMap(uint32_t cascadeIndex, uint32_t index = UINT32_MAX);
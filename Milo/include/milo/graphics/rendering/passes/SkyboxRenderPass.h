@@ -12,6 +12,7 @@ namespace milo {
 		virtual ~SkyboxRenderPass() override = default;
 		RenderPassId getId() const override;
 		const String& name() const override;
+		void declareResources(FrameGraphBuilder& builder) const override;
 	public:
 		static SkyboxRenderPass* create();
 		static size_t id();
@@ -26,6 +26,11 @@ namespace milo {
 
 		void allocateImage(const VkImageCreateInfo& imageInfo, const VmaAllocationCreateInfo& allocInfo, VkImage& vkImage, VmaAllocation& vmaAllocation);
 		void freeImage(VkImage vkImage, VmaAllocation vmaAllocation);
+
+		// Raw memory, for resources that share their memory (see VulkanFrameGraphResourcePool)
+		void allocateMemory(const VkMemoryRequirements& requirements, const VmaAllocationCreateInfo& allocInfo, VmaAllocation& vmaAllocation);
+		void bindImageMemory(VmaAllocation vmaAllocation, VkImage vkImage);
+		void freeMemory(VmaAllocation vmaAllocation);
 	public:
 		static VulkanAllocator* get();
 	};
@@ -31,18 +31,24 @@ namespace milo {
 		VkInstance vkInstance() const;
 		VulkanDevice* device() const;
 		VulkanWindowSurface* windowSurface() const;
+		// Null when headless
 		VulkanSwapchain* swapchain() const;
+		// True if there is no window to present to. Frames are rendered offscreen and read back by the presenter
+		bool headless() const;
+		// Format of the swapchain images, or the one offscreen frames would have if presented
+		VkFormat presentationFormat() const;
 		VulkanAllocator* allocator() const;
 		GraphicsPresenter* presenter() const override;
 		VulkanPresenter* vulkanPresenter() const;
 		VulkanSamplerMap* samplerMap() const;
 	protected:
+		// A null window initializes the context in headless mode
 		void init(Window* mainWindow) override;
 	private:
-		void createVkInstance();
+		void createVkInstance(bool presentation);
 		void createDebugMessenger();
 		void createWindowSurface(Window* mainWindow);
-		void createMainVulkanDevice();
+		void createMainVulkanDevice(bool presentation);
 		void createSwapchain();
 		void createAllocator();
 		void createPresenter();
@@ -19,6 +19,7 @@ namespace milo {
 		ArrayList<VkQueueFamilyProperties> queueFamilyProperties() const;
 		VkPhysicalDeviceLimits limits() const;
 		ArrayList<VkExtensionProperties> extensions() const;
+		bool supportsExtension(const char* name) const;
 		ArrayList<VkLayerProperties> layers() const;
 		uint32_t uniformBufferAlignment() const;
 		uint32_t storageBufferAlignment() const;
@@ -59,6 +60,8 @@ namespace milo {
 		uint32_t m_Index = UINT32_MAX;
 		ArrayList<VkSemaphore> m_LastSignalSemaphores;
 		VkFence m_LastFence{VK_NULL_HANDLE};
+		// Queues of different types may be the same VkQueue, which must not be submitted to from two threads at once
+		static Mutex s_SubmitMutex;
 	private:
 		VulkanQueue() = default;
 		inline void init(VulkanDevice* device, String name, VkQueueFlags type) {
@@ -85,6 +88,8 @@ namespace milo {
 		inline void setFence(VkFence fence) {m_LastFence = fence;}
 
 		void submit(const VkSubmitInfo& submitInfo, VkFence fence);
+		// Submits work that is not part of the chain of passes, so the wait semaphores and fence of the queue are kept
+		void submitDetached(const VkSubmitInfo& submitInfo, VkFence fence);
 		void awaitTermination();
 		void waitForFences();
 		void clear();
@@ -117,6 +122,8 @@ namespace milo {
 		VulkanCommandPool* m_GraphicsCommandPool;
 		VulkanCommandPool* m_ComputeCommandPool;
 		VulkanCommandPool* m_TransferCommandPool;
+		ArrayList<String> m_EnabledExtensions;
+		bool m_DescriptorIndexingSupported{false};
 	private:
 		explicit VulkanDevice(VulkanContext* context);
 		void init(const VulkanDevice::Info& info);
@@ -138,6 +145,9 @@ namespace milo {
 		VulkanCommandPool* graphicsCommandPool() const;
 		VulkanCommandPool* computeCommandPool() const;
 		VulkanCommandPool* transferCommandPool() const;
+		bool extensionEnabled(const String& name) const;
+		// True if VK_EXT_descriptor_indexing was enabled along with the features the bindless materials need
+		bool descriptorIndexingSupported() const;
 
 		bool operator==(const VulkanDevice& rhs) const;
 		bool operator!=(const VulkanDevice& rhs) const;
@@ -147,6 +157,8 @@ namespace milo {
 		void tryGetQueue(VkQueueFlagBits queueType, const Info &info, const ArrayList<VkQueueFamilyProperties> &queueFamilies, ArrayList<VkDeviceQueueCreateInfo> &queues);
 		void tryGetPresentationQueue(const Info &info, const ArrayList<VkQueueFamilyProperties> &queueFamilies, ArrayList<VkDeviceQueueCreateInfo> &queues);
 		void getQueues();
+		bool queryDescriptorIndexingFeatures(VkPhysicalDeviceDescriptorIndexingFeatures& features) const;
+		static bool hasExtension(const Info& info, const char* name);
 	public:
 		static ArrayList<VkPhysicalDevice> listAllPhysicalDevices(VkInstance vkInstance);
 		static ArrayList<RankedDevice> rankAllPhysicalDevices(VkInstance vkInstance);
@@ -6,8 +6,11 @@
 namespace milo {
 
 	namespace VulkanExtensions {
-		ArrayList<const char*> getInstanceExtensions();
+		// Without presentation, as in headless mode, neither GLFW nor the surface extensions are requested
+		ArrayList<const char*> getInstanceExtensions(bool presentation);
 		ArrayList<const char*> getDeviceExtensions(DeviceUsageFlags usageFlags);
+		// Enabled only if the physical device supports them
+		ArrayList<const char*> getOptionalDeviceExtensions(DeviceUsageFlags usageFlags);
 	}
 
 	namespace VulkanLayers {
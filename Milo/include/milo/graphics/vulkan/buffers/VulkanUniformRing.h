@@ -0,0 +1,69 @@
+#pragma once
+
+#include "VulkanBuffer.h"
+#include "milo/graphics/vulkan/VulkanAPI.h"
+
+namespace milo {
+
+	// A single persistently mapped uniform buffer split into one region per swapchain image. Every allocation
+	// is a bump of the region head, aligned to minUniformBufferOffsetAlignment, and is meant to be bound as a
+	// dynamic uniform buffer with the returned offset. Regions are reset in beginFrame, once the GPU is done with them.
+	//
+	// If a frame needs more than the region capacity, the allocations that do not fit are bump allocated from an
+	// overflow block at the end of the region and the buffer grows on the next beginFrame. Running out of overflow
+	// space too is a hard error. Growing creates a new VkBuffer, so descriptors pointing to the ring must be rewritten whenever
+	// generation() changes.
+	class VulkanUniformRing {
+	public:
+		static const uint64_t DEFAULT_REGION_SIZE = 256 * 1024;
+		struct Allocation {
+			void* data{nullptr};
+			uint32_t offset{0};
+		};
+		struct Stats {
+			uint64_t capacity{0};
+			uint64_t used{0};
+			uint64_t highWaterMark{0};
+			uint32_t allocations{0};
+			uint32_t overflows{0};
+			uint32_t resizes{0};
+		};
+	private:
+		VulkanDevice* m_Device{nullptr};
+		VulkanBuffer* m_Buffer{nullptr};
+		byte_t* m_MappedMemory{nullptr};
+		uint64_t m_Alignment{0};
+		uint64_t m_RegionSize{0};
+		uint64_t m_OverflowBlockSize{0};
+		uint32_t m_CurrentRegion{0};
+		uint64_t m_Head{0};
+		uint64_t m_OverflowHead{0};
+		uint32_t m_Generation{1};
+		Stats m_Stats{};
+	public:
+		explicit VulkanUniformRing(VulkanDevice* device, uint64_t regionSize = DEFAULT_REGION_SIZE);
+		~VulkanUniformRing();
+		VulkanUniformRing(const VulkanUniformRing& other) = delete;
+		VulkanUniformRing& operator=(const VulkanUniformRing& other) = delete;
+		void beginFrame(uint32_t imageIndex);
+		Allocation allocate(uint64_t size);
+		template<typename T>
+		uint32_t push(const T& value) {
+			Allocation allocation = allocate(sizeof(T));
+			memcpy(allocation.data, &value, sizeof(T));
+			return allocation.offset;
+		}
+		VkBuffer vkBuffer() const;
+		// Descriptor for a block of type T. The actual location is given by the dynamic offset at bind time
+		template<typename T>
+		VkDescriptorBufferInfo descriptorInfo() const {
+			return {vkBuffer(), 0, sizeof(T)};
+		}
+		// Increases every time the underlying VkBuffer changes
+		uint32_t generation() const;
+		const Stats& stats() const;
+	private:
+		void createBuffer();
+		void grow(uint64_t requiredSize);
+	};
+}
@@ -3,37 +3,113 @@
 #include "milo/assets/materials/MaterialResourcePool.h"
 #include "milo/graphics/vulkan/buffers/VulkanShaderBuffer.h"
 #include "milo/graphics/vulkan/descriptors/VulkanDescriptorPool.h"
+#include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
 
 namespace milo {
 
-	// TODO: make this scalable
-
+	// Material parameters and descriptor sets are versioned per frame in flight: updates are queued and written
+	// into the copy of a frame once the GPU has finished with it, so editing a material never waits for the device.
+	// Materials are exposed to shaders in two ways:
+	// - One descriptor set per material (set 2), with a dynamic uniform buffer and one combined image sampler per texture.
+	//   Always available, and used by the editor renderers and the passes that have not moved to the bindless layout.
+	// - Bindless (if the device supports descriptor indexing): a single descriptor set with the parameters of every material
+	//   in a storage buffer and every texture in one partially bound array. Draws select the material by index,
+	//   so switching materials does not rebind anything.
 	class VulkanMaterialResourcePool : public MaterialResourcePool {
 		friend class MaterialManager;
 		friend class MaterialResourcePool;
+	public:
+		// Must match the BindlessMaterial struct of pbr.frag (std430)
+		struct BindlessMaterial {
+			Color albedo{};
+			Color emissiveColor{};
+			float alpha{1.0f};
+			float metallic{1.0f};
+			float roughness{1.0f};
+			float occlusion{1.0f};
+			float fresnel0{0.04f};
+			float normalScale{1.0f};
+			uint32_t useNormalMap{0};
+			uint32_t useCombinedMetallicRoughness{0};
+			uint32_t textures[Material::TEXTURE_COUNT]{};
+			uint32_t _padding{0};
+		};
+		// Texture slot 0 is always the white texture, so null textures sample white
+		static const uint32_t NULL_TEXTURE_SLOT = 0;
+	private:
+		// Per material descriptor sets (one per frame in flight) are allocated in chunks as materials are created
+		static const uint32_t MATERIALS_PER_DESCRIPTOR_POOL = 64;
+		static const uint32_t MAX_BINDLESS_TEXTURES = 16384;
+		struct TextureSlot {
+			uint32_t index{NULL_TEXTURE_SLOT};
+			uint32_t references{0};
+		};
+		struct RetiredTextureSlot {
+			uint32_t index;
+			size_t frame;
+		};
+		// What has been written into the copy of a material for a given frame in flight
+		struct FrameCopy {
+			Array<Texture2D*, Material::TEXTURE_COUNT> textures{};
+			bool texturesWritten{false};
+			bool pending{false};
+		};
 	private:
 		VulkanDevice* m_Device{nullptr};
 		VulkanUniformBuffer<Material::Data>* m_UniformBuffer{nullptr};
 		uint64_t m_MaxMaterialCount{0};
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
-		VulkanDescriptorPool* m_DescriptorPool{nullptr};
+		mvk::DescriptorSet::CreateInfo m_DescriptorSetInfo{};
+		ArrayList<VulkanDescriptorPool*> m_DescriptorPools;
 		Queue<uint32_t> m_FreeIndices;
 		uint32_t m_MaterialCount{0};
 		HashMap<String, uint32_t> m_MaterialIndices;
+		// Last snapshot of each material. Free indices have a null material
+		ArrayList<MaterialSnapshot> m_Materials;
+		ArrayList<Array<FrameCopy, MAX_FRAMES_IN_FLIGHT>> m_FrameCopies;
+		Array<ArrayList<uint32_t>, MAX_FRAMES_IN_FLIGHT> m_PendingUpdates;
+		size_t m_FrameCount{0};
+		// Bindless
+		bool m_BindlessSupported{false};
+		uint32_t m_MaxBindlessTextures{0};
+		VulkanBuffer* m_BindlessMaterialBuffer{nullptr};
+		VkDescriptorSetLayout m_BindlessDescriptorSetLayout{VK_NULL_HANDLE};
+		VulkanDescriptorPool* m_BindlessDescriptorPool{nullptr};
+		HashMap<VulkanTexture2D*, TextureSlot> m_TextureSlots;
+		ArrayList<VulkanTexture2D*> m_TexturesBySlot;
+		Queue<uint32_t> m_FreeTextureSlots;
+		Queue<RetiredTextureSlot> m_RetiredTextureSlots;
+		ArrayList<Array<uint32_t, Material::TEXTURE_COUNT>> m_MaterialTextureSlots;
 	private:
 		VulkanMaterialResourcePool();
 		~VulkanMaterialResourcePool();
 	public:
 		void allocateMaterialResources(Material* material) override;
-		void updateMaterial(Material* material) override;
+		void updateMaterial(const MaterialSnapshot& snapshot) override;
 		void freeMaterialResources(Material* material) override;
+		void beginFrame() override;
+		// Descriptor set of the material for the frame being recorded
 		VkDescriptorSet descriptorSetOf(Material* material, uint32_t& dynamicOffset) const;
 		VkDescriptorSetLayout materialDescriptorSetLayout() const;
+		bool bindlessSupported() const;
+		// Index of the material in the bindless material buffer, for the frame being recorded
+		uint32_t indexOf(Material* material) const;
+		VkDescriptorSet bindlessDescriptorSet() const;
+		VkDescriptorSetLayout bindlessDescriptorSetLayout() const;
 	private:
 		void createUniformBuffer();
-		void createDescriptorSetLayoutAndPool();
-		void createDescriptorSets();
-		void updateTextures(Material* material);
+		void createDescriptorSetLayout();
+		void ensureDescriptorPool(uint32_t index);
+		VkDescriptorSet descriptorSetAt(uint32_t frame, uint32_t index) const;
+		uint32_t currentFrame() const;
+		void writeFrameCopy(uint32_t frame, uint32_t index);
+		void updateTextures(const MaterialSnapshot& material, uint32_t frame, uint32_t index);
+		void createBindlessResources();
+		void updateTextureSlots(const MaterialSnapshot& material, uint32_t index);
+		void writeBindlessMaterial(const MaterialSnapshot& material, uint32_t frame, uint32_t index);
+		uint32_t acquireTextureSlot(const Ref<Texture2D>& texture);
+		void releaseTextureSlot(uint32_t slot);
+		void writeTextureSlot(uint32_t slot, VulkanTexture2D* texture);
 	};
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
+#include "milo/graphics/vulkan/buffers/VulkanBuffer.h"
+#include "milo/graphics/vulkan/commands/VulkanCommandPool.h"
+#include "milo/core/Application.h"
+#include <condition_variable>
+
+namespace milo {
+
+	// Reads back the final color attachment of the offscreen frames of headless mode and writes it to disk.
+	//
+	// The copy to a host visible staging buffer is recorded at the end of each frame, and the buffer is handed to a
+	// writer thread once the fence of that frame signals, so neither the GPU nor the render loop wait for the images
+	// to be encoded. The staging buffers form a ring: rendering only stalls if every buffer is still queued for writing
+	class VulkanFrameReadback {
+	public:
+		// One for each frame in flight, plus the ones the writer thread may fall behind by
+		static const uint32_t STAGING_BUFFER_COUNT = MAX_FRAMES_IN_FLIGHT + 2;
+	private:
+		static const uint32_t NO_STAGING_BUFFER = UINT32_MAX;
+
+		struct StagingBuffer {
+			VulkanBuffer* buffer{nullptr};
+			const float* pixels{nullptr};
+			uint32_t width{0};
+			uint32_t height{0};
+			uint64_t frameNumber{0};
+		};
+	private:
+		VulkanDevice* m_Device{nullptr};
+		String m_OutputDirectory;
+		HeadlessImageFormat m_ImageFormat{HeadlessImageFormat::None};
+		VulkanCommandPool* m_CommandPool{nullptr};
+		Array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> m_CommandBuffers{};
+		Array<StagingBuffer, STAGING_BUFFER_COUNT> m_StagingBuffers{};
+		// Staging buffer the copy of each frame in flight writes to
+		Array<uint32_t, MAX_FRAMES_IN_FLIGHT> m_InFlightBuffers{};
+		ArrayList<uint32_t> m_FreeBuffers;
+		Queue<uint32_t> m_WriteQueue;
+		uint64_t m_FrameCount{0};
+		uint64_t m_FramesWritten{0};
+		// Writer thread only, reused between frames
+		ArrayList<uint8_t> m_EncodedPixels;
+		Mutex m_Mutex;
+		std::condition_variable m_BufferQueued;
+		std::condition_variable m_BufferFreed;
+		bool m_Running{false};
+		Thread m_Thread;
+	public:
+		VulkanFrameReadback(VulkanDevice* device, const HeadlessConfiguration& config);
+		~VulkanFrameReadback();
+		VulkanFrameReadback(const VulkanFrameReadback&) = delete;
+		VulkanFrameReadback& operator=(const VulkanFrameReadback&) = delete;
+		// Records the copy of colorAttachment into the command buffer of frame, to be submitted after the rest of the frame.
+		// Blocks while every staging buffer is waiting to be written
+		VkCommandBuffer record(uint32_t frame, VulkanTexture2D& colorAttachment);
+		// Must be called once the fence of frame signaled. Hands its staging buffer to the writer thread
+		void complete(uint32_t frame);
+	private:
+		uint32_t acquireStagingBuffer(uint32_t width, uint32_t height, uint64_t size);
+		void run();
+		void write(const StagingBuffer& staging);
+	};
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
 #include "milo/graphics/vulkan/commands/VulkanCommandPool.h"
 #include "VulkanSwapchain.h"
+#include "VulkanFrameReadback.h"
 
 namespace milo {
 
@@ -12,7 +13,9 @@ namespace milo {
 		friend class VulkanContext;
 	private:
 		VulkanDevice* m_Device;
+		// Null in headless mode, where frames are rendered offscreen and read back instead of presented
 		VulkanSwapchain* m_Swapchain;
+		VulkanFrameReadback* m_Readback = nullptr;
 		// Queues
 		VkQueue m_GraphicsQueue = VK_NULL_HANDLE;
 		VkQueue m_PresentationQueue = VK_NULL_HANDLE;
@@ -41,6 +44,8 @@ namespace milo {
 		VkSemaphore imageAvailableSemaphore() const;
 		VkSemaphore renderFinishedSemaphore() const;
 	private:
+		bool beginOffscreen();
+		void endOffscreen();
 		void waitForPreviousFrameToComplete();
 		bool tryGetNextSwapchainImage();
 		void setCurrentFrameInFlight();
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "milo/graphics/vulkan/VulkanDevice.h"
+
+namespace milo {
+
+	// Compute pipeline made of a single shader. The pipeline layout belongs to the owner.
+	// Pipelines are recreated when their shader is hot reloaded, so vkPipeline() must be queried every time it is bound
+	class VulkanComputePipeline {
+	private:
+		static ArrayList<VulkanComputePipeline*> s_Pipelines;
+		static Mutex s_Mutex;
+	private:
+		String m_Name;
+		VulkanDevice* m_Device{nullptr};
+		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
+		String m_ShaderFilename;
+		VkPipelineCreateFlags m_Flags{0};
+		VkPipeline m_Pipeline{VK_NULL_HANDLE};
+	public:
+		VulkanComputePipeline(String name, VulkanDevice* device, VkPipelineLayout pipelineLayout, String shaderFilename, VkPipelineCreateFlags flags = 0);
+		~VulkanComputePipeline();
+		VulkanComputePipeline(const VulkanComputePipeline&) = delete;
+		VulkanComputePipeline& operator=(const VulkanComputePipeline&) = delete;
+		VulkanDevice* device() const;
+		VkPipelineLayout pipelineLayout() const;
+		VkPipeline vkPipeline() const;
+		const String& shaderFilename() const;
+	private:
+		VkPipeline createPipeline() const;
+	public:
+		// Recreates every pipeline that uses the shader. The device must be idle. Pipelines that fail keep the old version
+		static void rebuildPipelinesUsing(const String& shaderFilename);
+	};
+}
\ No newline at end of file
@@ -4,17 +4,103 @@
 #include "milo/graphics/vulkan/VulkanAPI.h"
 #include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
 #include "milo/graphics/vulkan/buffers/VulkanFramebuffer.h"
+#include "milo/graphics/vulkan/buffers/VulkanUniformRing.h"
+#include "milo/graphics/vulkan/commands/VulkanCommandPool.h"
+#include "milo/graphics/rendering/passes/ShadowMapRenderPass.h"
+#include "milo/scenes/components/Light.h"
 
 namespace milo {
 
+	// ===================================== SHARED PER FRAME UNIFORM BLOCKS (std140)
+
+	struct CameraUniformData {
+		Matrix4 projectionMatrix{};
+		Matrix4 viewMatrix{};
+		Matrix4 viewProjectionMatrix{};
+		Vector4 position{};
+	};
+
+	struct PointLightsUniformData {
+		PointLight pointLights[MAX_POINT_LIGHTS]{};
+		uint32_t pointLightsCount{0};
+	};
+
+	struct ShadowCascadesUniformData {
+		Matrix4 viewProjectionMatrix[MAX_SHADOW_CASCADES]{};
+	};
+
+	// Dynamic offsets of the shared blocks of the current frame in the uniform ring
+	struct FrameUniformOffsets {
+		uint32_t camera{0};
+		uint32_t pointLights{0};
+		uint32_t shadowCascades{0};
+	};
+
+	// =============================================
+
+	// Besides the shared resources, executes the compiled frame graph on the Vulkan side:
+	// - Transient textures are created without memory. Each alias slot of the graph gets one allocation as large as
+	//   its biggest texture, and every texture in the slot is bound to it.
+	// - Barriers are recorded into small command buffers submitted to the queue of each pass, before and after it.
+	//   Those that cross queues wait on and replace the semaphores that chain the passes together, so queue ownership
+	//   releases always run before the matching acquires.
 	class VulkanFrameGraphResourcePool : public FrameGraphResourcePool {
 		friend class FrameGraphResourcePool;
+	private:
+		struct BoundResource {
+			Array<VulkanTexture*, MAX_SWAPCHAIN_IMAGE_COUNT> textures{};
+			Array<VulkanBuffer*, MAX_SWAPCHAIN_IMAGE_COUNT> buffers{};
+		};
+		struct PassBarriers {
+			VulkanCommandPool* commandPool{nullptr};
+			Array<VkCommandBuffer, MAX_SWAPCHAIN_IMAGE_COUNT> barrierCommandBuffers{};
+			Array<VkCommandBuffer, MAX_SWAPCHAIN_IMAGE_COUNT> releaseCommandBuffers{};
+			Array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> barrierSemaphores{};
+			Array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> releaseSemaphores{};
+		};
+	private:
+		VulkanDevice* m_Device{nullptr};
+		VulkanUniformRing* m_UniformRing{nullptr};
+		FrameUniformOffsets m_FrameUniforms{};
+		// Frame graph
+		HashMap<FrameGraphResourceId, BoundResource> m_BoundResources;
+		ArrayList<FrameGraphTransientTexture> m_RealizedTransients;
+		ArrayList<Ref<Texture2D>> m_TransientTextures;
+		ArrayList<VmaAllocation> m_TransientMemory;
+		uint64_t m_TransientMemorySize{0};
+		uint64_t m_TransientMemorySizeWithoutAliasing{0};
+		ArrayList<PassBarriers> m_PassBarriers;
+		ArrayList<VkImageMemoryBarrier> m_ImageBarriers;
+		ArrayList<VkBufferMemoryBarrier> m_BufferBarriers;
 	private:
 		VulkanFrameGraphResourcePool();
 		~VulkanFrameGraphResourcePool() override;
+	public:
+		// Resets the uniform ring region of the current swapchain image and writes the shared blocks
+		void compile(Scene* scene) override;
+		VulkanUniformRing& uniformRing() const;
+		const FrameUniformOffsets& frameUniforms() const;
+		void realize(const CompiledFrameGraph& graph) override;
+		void beginPass(const CompiledFrameGraph& graph, uint32_t passIndex) override;
+		void endPass(const CompiledFrameGraph& graph, uint32_t passIndex) override;
+		// Concrete resource behind an imported frame graph resource. UINT32_MAX binds it for every swapchain image
+		void bindTexture(FrameGraphResourceId id, VulkanTexture* texture, uint32_t imageIndex = UINT32_MAX);
+		void bindBuffer(FrameGraphResourceId id, VulkanBuffer* buffer, uint32_t imageIndex = UINT32_MAX);
+		uint64_t transientMemorySize() const;
+		uint64_t transientMemorySizeWithoutAliasing() const;
 	protected:
 		uint32_t currentFramebufferIndex() const override;
 		uint32_t maxDefaultFramebuffersCount() const override;
+	private:
+		void writeFrameUniforms();
+		void createTransientTextures(const CompiledFrameGraph& graph);
+		void destroyTransientTextures();
+		void createPassBarriers(const CompiledFrameGraph& graph);
+		void destroyPassBarriers();
+		void recordBarriers(VkCommandBuffer commandBuffer, const ArrayList<FrameGraphBarrier>& barriers, bool release, uint32_t imageIndex);
+		void submitBarriers(VulkanQueue* queue, VkCommandBuffer commandBuffer, VkSemaphore signalSemaphore);
+		VulkanQueue* queueOf(FrameGraphQueue queue) const;
+		bool requiresOwnershipTransfer(const FrameGraphBarrier& barrier) const;
 	};
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "milo/graphics/rendering/GPUProfiler.h"
+#include "milo/graphics/vulkan/VulkanDevice.h"
+
+namespace milo {
+
+	// Timestamps are written by small marker command buffers submitted to the graphics queue between passes,
+	// so render passes do not need to know about them. A BOTTOM_OF_PIPE timestamp waits for all the work
+	// submitted before it, so the time of pass i is the difference between markers i and i + 1.
+	// The markers of a frame are followed by a fence, waited for before its queries and command buffers are reused.
+	// Pipeline statistics can only be queried inside the recorded command buffers, see beginStatistics.
+	class VulkanGPUProfiler : public GPUProfiler {
+		friend class GPUProfiler;
+	private:
+		struct CalibrationSample {
+			uint64_t gpuTicks{0};
+			TimePoint time;
+			bool calibrated{false};
+		};
+		struct FrameQueries {
+			VkQueryPool timestampPool{VK_NULL_HANDLE};
+			VkQueryPool statisticsPool{VK_NULL_HANDLE};
+			Array<VkCommandBuffer, MAX_GPU_PROFILED_PASSES + 1> markerCommandBuffers{};
+			// Signaled once the markers of the frame have executed
+			VkFence fence{VK_NULL_HANDLE};
+			bool fenceSubmitted{false};
+			Array<String, MAX_GPU_PROFILED_PASSES> passNames{};
+			Array<uint32_t, MAX_GPU_STATISTICS_QUERIES> statisticsOwners{};
+			uint32_t passCount{0};
+			uint32_t statisticsCount{0};
+			size_t frame{0};
+			bool pending{false};
+			CalibrationSample calibration{};
+		};
+	private:
+		VulkanDevice* m_Device{nullptr};
+		Array<FrameQueries, MAX_FRAMES_IN_FLIGHT> m_Frames{};
+		FrameQueries* m_CurrentFrame{nullptr};
+		int32_t m_CurrentPass{-1};
+		uint32_t m_OpenStatisticsQuery{UINT32_MAX};
+		bool m_TimestampsSupported{false};
+		bool m_PipelineStatisticsSupported{false};
+		bool m_CalibratedTimestampsSupported{false};
+		// Nanoseconds per tick
+		double m_TimestampPeriod{1.0};
+		uint64_t m_TimestampMask{UINT64_MAX};
+		VkTimeDomainEXT m_HostTimeDomain{VK_TIME_DOMAIN_DEVICE_EXT};
+		PFN_vkGetCalibratedTimestampsEXT m_vkGetCalibratedTimestamps{nullptr};
+	private:
+		VulkanGPUProfiler();
+	public:
+		~VulkanGPUProfiler() override;
+		void beginFrame() override;
+		void beginPass(const String& name) override;
+		void endPass() override;
+		void endFrame() override;
+		bool timestampsSupported() const override;
+		bool pipelineStatisticsSupported() const override;
+		bool calibratedTimestampsSupported() const override;
+		// Must be called outside of a render pass instance, and paired with endStatistics in the same command buffer.
+		// Does nothing unless a pass is being profiled. Only valid for command buffers recorded every frame.
+		void beginStatistics(VkCommandBuffer commandBuffer);
+		void endStatistics(VkCommandBuffer commandBuffer);
+	private:
+		void createQueryPools();
+		void destroyQueryPools();
+		void queryCalibratedTimestampsSupport();
+		void writeMarker(uint32_t markerIndex);
+		void calibrate(CalibrationSample& sample);
+		void resolve(FrameQueries& frame);
+		TimePoint toCPUTime(const CalibrationSample& calibration, uint64_t ticks) const;
+	private:
+		static VulkanGPUProfiler* s_Instance;
+	public:
+		// Null if no Vulkan GPU profiler has been created
+		static VulkanGPUProfiler* get();
+	};
+}
@@ -25,7 +25,12 @@ namespace milo {
 			ArrayList<VkPushConstantRange> pushConstantRanges;
 			ArrayList<VkDescriptorSetLayout> setLayouts;
 			VkPipelineCache vkPipelineCache = VK_NULL_HANDLE;
+			// Shared with other pipelines and not owned. If null, a layout is created from setLayouts and pushConstantRanges
+			VkPipelineLayout vkPipelineLayout = VK_NULL_HANDLE;
 			ArrayList<VulkanShaderInfo> shaders;
+			// Applied to every stage. Constants a stage does not declare are ignored
+			ArrayList<VkSpecializationMapEntry> specializationEntries;
+			ArrayList<byte_t> specializationData;
 			VulkanVertexInputInfo vertexInputInfo = {};
 			VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
 			VkPipelineDepthStencilStateCreateInfo depthStencil = {};
@@ -52,8 +57,15 @@ namespace milo {
 			void initColorBlendState();
 		};
 	private:
+		static ArrayList<VulkanGraphicsPipeline*> s_Pipelines;
+		static Mutex s_Mutex;
+	private:
+		String m_Name;
 		VulkanDevice* m_Device{nullptr};
+		// Kept to recreate the pipeline when one of its shaders is hot reloaded
+		CreateInfo m_Info;
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
+		bool m_OwnsPipelineLayout{true};
 		VkPipeline m_Pipeline{VK_NULL_HANDLE};
 		VkPipelineCache m_PipelineCache{VK_NULL_HANDLE};
 	public:
@@ -61,8 +73,15 @@ namespace milo {
 		~VulkanGraphicsPipeline();
 		VulkanDevice* device() const;
 		VkPipelineLayout pipelineLayout() const;
+		// Changes when the pipeline is rebuilt, so it must be queried every time it is bound
 		VkPipeline vkPipeline() const;
 		VkPipelineCache pipelineCache() const;
+		bool usesShader(const String& filename) const;
+	private:
+		VkPipeline createPipeline() const;
+	public:
+		// Recreates every pipeline that uses the shader. The device must be idle. Pipelines that fail keep the old version
+		static void rebuildPipelinesUsing(const String& shaderFilename);
 	private:
 		static ArrayList<VkPipelineShaderStageCreateInfo> createShaderPipelineStages(const ArrayList<VulkanShaderInfo>& shaderInfos, const ArrayList<VkShaderModule>& shaderModules);
 		static VkShaderModule createShaderModule(VkDevice device, const VulkanShaderInfo& shaderInfo);
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "VulkanGraphicsPipeline.h"
+
+namespace milo {
+
+	// Enabled keywords of a shader variant, bit i being the keyword with constant_id i
+	using ShaderVariantKey = uint32_t;
+
+	// Pipelines of a shader that declares feature keywords, one for each combination of keywords in use.
+	// Keywords are boolean specialization constants whose constant_id is their index in the keyword list:
+	//
+	//     layout(constant_id = 0) const bool MY_FEATURE = true;
+	//
+	// so the driver removes the code of the disabled features instead of branching on them for every pixel.
+	// Variants are created the first time they are requested and share the same pipeline layout, so descriptor sets
+	// and push constants stay bound when switching between them. Their pipeline cache is persisted on disk, which makes
+	// creating a variant that was already used in a previous run much cheaper
+	class VulkanShaderVariants {
+	public:
+		static const uint32_t MAX_KEYWORDS = 32;
+	private:
+		String m_Name;
+		VulkanDevice* m_Device{nullptr};
+		VulkanGraphicsPipeline::CreateInfo m_Info;
+		ArrayList<String> m_Keywords;
+		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
+		VkPipelineCache m_PipelineCache{VK_NULL_HANDLE};
+		HashMap<ShaderVariantKey, VulkanGraphicsPipeline*> m_Variants;
+		bool m_PipelineCacheModified{false};
+	public:
+		VulkanShaderVariants(String name, VulkanDevice* device, const VulkanGraphicsPipeline::CreateInfo& info, ArrayList<String> keywords);
+		~VulkanShaderVariants();
+		VulkanShaderVariants(const VulkanShaderVariants&) = delete;
+		VulkanShaderVariants& operator=(const VulkanShaderVariants&) = delete;
+		const String& name() const;
+		VkPipelineLayout pipelineLayout() const;
+		const ArrayList<String>& keywords() const;
+		size_t variantCount() const;
+		// Creates the variant the first time it is requested
+		VulkanGraphicsPipeline* get(ShaderVariantKey key);
+		// Writes the pipeline cache to disk if variants were created since it was loaded or last saved
+		void savePipelineCache();
+	private:
+		void loadPipelineCache();
+		String pipelineCacheFilename() const;
+		String variantName(ShaderVariantKey key) const;
+	};
+}
\ No newline at end of file
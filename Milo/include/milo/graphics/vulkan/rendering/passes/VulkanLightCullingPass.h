@@ -6,41 +6,34 @@
 #include "milo/graphics/rendering/Framebuffer.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/graphics/vulkan/buffers/VulkanShaderBuffer.h"
+#include "milo/graphics/vulkan/rendering/VulkanComputePipeline.h"
 
 namespace milo {
 
 	class VulkanLightCullingPass : public LightCullingPass {
 		friend class LightCullingPass;
 	private:
-		struct CameraUniformBuffer {
-			Matrix4 projectionMatrix;
-			Matrix4 viewMatrix;
-			Matrix4 viewProjectionMatrix;
-		};
-		struct PointLightsUniformBuffer {
-			PointLight pointLights[MAX_POINT_LIGHTS];
-			uint32_t pointLightsCount;
-		};
 		struct PushConstants {
 			Size screenSize;
 		};
 	private:
 		VulkanDevice* m_Device{nullptr};
 
-		VulkanUniformBuffer<CameraUniformBuffer>* m_CameraUniformBuffer{nullptr};
-		VulkanUniformBuffer<PointLightsUniformBuffer>* m_PointLightsUniformBuffer{nullptr};
 		Ref<VulkanStorageBuffer<VisibleLightsBuffer>> m_VisibleLightsStorageBuffer{nullptr};
 
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool = nullptr;
 
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
-		VkPipeline m_ComputePipeline{VK_NULL_HANDLE};
+		VulkanComputePipeline* m_ComputePipeline{nullptr};
 
 		Array<VkCommandBuffer, MAX_SWAPCHAIN_IMAGE_COUNT> m_CommandBuffers{};
 		Array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> m_SignalSemaphores{};
 
 		Size m_LastViewportSize{};
+
+		// Uniform ring generation each descriptor set was last written with
+		Array<uint32_t, MAX_SWAPCHAIN_IMAGE_COUNT> m_UniformRingGenerations{};
 	private:
 		VulkanLightCullingPass();
 		~VulkanLightCullingPass();
@@ -53,10 +46,9 @@ namespace milo {
 		void updateUniforms(uint32_t imageIndex, Scene* scene);
 		void createDescriptorSetLayout();
 		void createDescriptorPool();
-		void createCameraUniformBuffer();
-		void createPointLightsUniformBuffer();
 		void createVisibleLightIndicesStorageBuffer();
 		void createDescriptorSets();
+		void updateBufferDescriptors(uint32_t imageIndex);
 		void createComputePipeline();
 		void createCommandBuffers();
 		void createSemaphores();
@@ -4,7 +4,7 @@
 #include "milo/graphics/rendering/passes/PBRForwardRenderPass.h"
 #include "milo/graphics/vulkan/descriptors/VulkanDescriptorPool.h"
 #include "milo/graphics/vulkan/buffers/VulkanShaderBuffer.h"
-#include "milo/graphics/vulkan/rendering/VulkanGraphicsPipeline.h"
+#include "milo/graphics/vulkan/rendering/VulkanShaderVariants.h"
 #include <concurrent_queue.h>
 
 namespace milo {
@@ -13,12 +13,7 @@ namespace milo {
 		friend class PBRForwardRenderPass;
 	private:
 		// ===================================== SET 0: SCENE
-
-		struct CameraData {
-			Matrix4 viewProjection{};
-			Matrix4 view{};
-			Vector4 position{};
-		};
+		// Camera and point lights are the shared blocks of VulkanFrameGraphResourcePool
 
 		struct EnvironmentData {
 			DirectionalLight dirLight{};
@@ -28,11 +23,6 @@ namespace milo {
 			bool skyboxPresent[4]{false};
 		};
 
-		struct PointLightsData {
-			PointLight pointLights[MAX_POINT_LIGHTS]{};
-			uint32_t u_PointLightsCount{0};
-		};
-
 		// =============================================
 
 		struct ShadowDetails {
@@ -56,24 +46,31 @@ namespace milo {
 			Matrix4 modelMatrix;
 		};
 
+		// =============================================
+
+		// Keywords of pbr.frag, in constant_id order
+		enum Keyword : ShaderVariantKey {
+			KEYWORD_DIR_LIGHT = 1 << 0,
+			KEYWORD_SKYBOX = 1 << 1,
+			KEYWORD_SHADOWS = 1 << 2,
+			KEYWORD_SOFT_SHADOWS = 1 << 3,
+			KEYWORD_CASCADE_FADING = 1 << 4,
+			KEYWORD_NORMAL_MAP = 1 << 5,
+			KEYWORD_COMBINED_METALLIC_ROUGHNESS = 1 << 6
+		};
+
 	private:
 		VulkanDevice* m_Device = nullptr;
 
 		VkRenderPass m_RenderPass = VK_NULL_HANDLE;
 
-		VulkanUniformBuffer<CameraData>* m_CameraUniformBuffer = nullptr;
-		VulkanUniformBuffer<EnvironmentData>* m_EnvironmentUniformBuffer = nullptr;
-		VulkanUniformBuffer<PointLightsData>* m_PointLightsUniformBuffer = nullptr;
-
 		VkDescriptorSetLayout m_SceneDescriptorSetLayout = VK_NULL_HANDLE;
 		VulkanDescriptorPool* m_SceneDescriptorPool = nullptr;
 
-		VulkanUniformBuffer<ShadowDetails>* m_ShadowsUniformBuffer = nullptr;
-
 		VkDescriptorSetLayout m_ShadowsDescriptorSetLayout = VK_NULL_HANDLE;
 		VulkanDescriptorPool* m_ShadowsDescriptorPool = nullptr;
 
-		VulkanGraphicsPipeline* m_GraphicsPipeline = nullptr;
+		VulkanShaderVariants* m_ShaderVariants = nullptr;
 
 		Array<VkCommandBuffer, MAX_SWAPCHAIN_IMAGE_COUNT> m_CommandBuffers{};
 
@@ -81,6 +78,12 @@ namespace milo {
 
 		Array<uint32_t, MAX_SWAPCHAIN_IMAGE_COUNT> m_LastSkyboxModificationCount{0};
 
+		// Uniform ring offsets of the blocks owned by this pass, for the frame being recorded
+		uint32_t m_EnvironmentOffset{0};
+		uint32_t m_ShadowsOffset{0};
+		// Uniform ring generation each descriptor set was last written with
+		Array<uint32_t, MAX_SWAPCHAIN_IMAGE_COUNT> m_UniformRingGenerations{};
+
 	public:
 		VulkanPBRForwardRenderPass();
 		~VulkanPBRForwardRenderPass() override;
@@ -96,6 +99,10 @@ namespace milo {
 		void pushConstants(VkCommandBuffer commandBuffer, const Matrix4& transform) const;
 		void bindMesh(VkCommandBuffer commandBuffer, const Mesh* mesh) const;
 		void bindMaterial(VkCommandBuffer commandBuffer, const VulkanMaterialResourcePool& materialResources, Material* material) const;
+		void pushMaterialIndex(VkCommandBuffer commandBuffer, uint32_t materialIndex) const;
+
+		ShaderVariantKey sceneVariantKey() const;
+		static ShaderVariantKey materialVariantKey(const Material* material);
 
 		void updateSceneUniformData(uint32_t imageIndex);
 		void setSkyboxUniformData(uint32_t imageIndex, Skybox* skybox);
@@ -104,13 +111,11 @@ namespace milo {
 		void updateShadowsUniformData(uint32_t imageIndex, uint32_t viewportWidth);
 
 		void bindDescriptorSets(uint32_t imageIndex, VkCommandBuffer commandBuffer);
+		void updateBufferDescriptors(uint32_t imageIndex);
 
 		void createRenderPass();
 
-		void createSceneUniformBuffers();
 		void createSceneDescriptorSetLayoutAndPool();
-
-		void createShadowsUniformBuffer();
 		void createShadowsDescriptorSetLayoutAndPool();
 
 		void createGraphicsPipeline();
@@ -4,27 +4,31 @@
 #include "milo/graphics/vulkan/VulkanContext.h"
 #include "milo/graphics/vulkan/descriptors/VulkanDescriptorPool.h"
 #include "milo/graphics/vulkan/rendering/VulkanGraphicsPipeline.h"
-#include "milo/graphics/vulkan/buffers/VulkanShaderBuffer.h"
 #include "milo/graphics/vulkan/buffers/VulkanFramebuffer.h"
+#include "milo/graphics/vulkan/buffers/VulkanBuffer.h"
+#include "milo/graphics/rendering/EntityPicker.h"
 
 namespace milo {
 
 	class VulkanPreDepthRenderPass : public PreDepthRenderPass {
 		friend class PreDepthRenderPass;
 	private:
-		struct UniformBuffer {
-			Matrix4 projMatrix;
-			Matrix4 viewMatrix;
-			Matrix4 projViewMatrix;
+		struct PushConstants {
+			Matrix4 modelMatrix;
+			uint32_t entityId;
 		};
 	private:
 		VulkanDevice* m_Device{nullptr};
 
+		// Whether the render pass, pipeline and framebuffers have the entity ID attachment
+		bool m_EntityIds{false};
+
 		VkRenderPass m_RenderPass{VK_NULL_HANDLE};
 
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
-		VulkanUniformBuffer<UniformBuffer>* m_UniformBuffer{nullptr};
+		// Uniform ring generation each descriptor set was last written with
+		Array<uint32_t, MAX_SWAPCHAIN_IMAGE_COUNT> m_UniformRingGenerations{};
 
 		VulkanGraphicsPipeline* m_GraphicsPipeline = nullptr;
 
@@ -32,10 +36,20 @@ namespace milo {
 
 		Array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> m_SignalSemaphores{};
 
+		// Own the depth map color attachments only. The depth buffer is a frame graph transient
 		Array<Ref<VulkanFramebuffer>, MAX_SWAPCHAIN_IMAGE_COUNT> m_Framebuffers{};
+		Array<VkFramebuffer, MAX_SWAPCHAIN_IMAGE_COUNT> m_VkFramebuffers{};
+		VkImageView m_DepthBufferView{VK_NULL_HANDLE};
 
 		Size m_LastFramebufferSize{};
 
+		// Entity picking readback, one per frame in flight. A region stays in its slot until the frame is reused,
+		// at which point the presenter has already waited for its fence
+		Array<VkCommandBuffer, MAX_FRAMES_IN_FLIGHT> m_PickCommandBuffers{};
+		Array<VulkanBuffer*, MAX_FRAMES_IN_FLIGHT> m_PickBuffers{};
+		Array<const uint32_t*, MAX_FRAMES_IN_FLIGHT> m_PickedIds{};
+		Array<Optional<EntityPickRegion>, MAX_FRAMES_IN_FLIGHT> m_PickRegions{};
+
 	private:
 		VulkanPreDepthRenderPass();
 		~VulkanPreDepthRenderPass();
@@ -46,13 +60,16 @@ namespace milo {
 	private:
 		void buildCommandBuffers(uint32_t imageIndex, VkCommandBuffer commandBuffer, Scene* scene);
 		void renderMeshViews(uint32_t imageIndex, VkCommandBuffer commandBuffer, Scene* scene);
+		void resolvePick(uint32_t frame);
+		bool recordPick(uint32_t imageIndex, uint32_t frame);
 		void createRenderPass();
 		void createDescriptorSetLayout();
 		void createDescriptorPool();
-		void createUniformBuffer();
 		void createDescriptorSets();
+		void updateDescriptorSet(uint32_t imageIndex);
 		void createGraphicsPipeline();
 		void createSemaphores();
 		void createFramebuffers(const Size& size, FrameGraphResourcePool* resourcePool);
+		void destroyVkFramebuffers();
 	};
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "milo/graphics/rendering/passes/SelectionOutlineRenderPass.h"
+#include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/graphics/vulkan/descriptors/VulkanDescriptorPool.h"
+#include "milo/graphics/vulkan/rendering/VulkanGraphicsPipeline.h"
+
+namespace milo {
+
+	class VulkanSelectionOutlineRenderPass : public SelectionOutlineRenderPass {
+	private:
+		struct PushConstants {
+			Color color;
+			uint32_t entityId;
+			int32_t thickness;
+		};
+	private:
+		VulkanDevice* m_Device{nullptr};
+		VkRenderPass m_RenderPass{VK_NULL_HANDLE};
+		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
+		VulkanDescriptorPool* m_DescriptorPool{nullptr};
+		VulkanGraphicsPipeline* m_GraphicsPipeline = nullptr;
+		Array<VkCommandBuffer, MAX_SWAPCHAIN_IMAGE_COUNT> m_CommandBuffers{};
+		Array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> m_SignalSemaphores{};
+	public:
+		VulkanSelectionOutlineRenderPass();
+		~VulkanSelectionOutlineRenderPass();
+		bool shouldCompile(Scene* scene) const override;
+		void compile(Scene* scene, FrameGraphResourcePool* resourcePool) override;
+		void execute(Scene* scene) override;
+	private:
+		void updateDescriptorSet(uint32_t imageIndex);
+		void buildCommandBuffer(uint32_t imageIndex, VkCommandBuffer commandBuffer);
+		void createRenderPass();
+		void createDescriptorSetLayout();
+		void createDescriptorPool();
+		void createGraphicsPipeline();
+	};
+}
\ No newline at end of file
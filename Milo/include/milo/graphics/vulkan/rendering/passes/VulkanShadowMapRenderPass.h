@@ -13,19 +13,13 @@
 namespace milo {
 
 	struct VulkanShadowCascade {
-		VkImageView imageView;
-		VkFramebuffer framebuffer;
-
-		~VulkanShadowCascade();
+		VkImageView imageView{VK_NULL_HANDLE};
+		VkFramebuffer framebuffer{VK_NULL_HANDLE};
 	};
 
 	class VulkanShadowMapRenderPass : public ShadowMapRenderPass {
 		friend class ShadowMapRenderPass;
 	private:
-		struct ShadowData {
-			Matrix4 viewProjectionMatrix[MAX_SHADOW_CASCADES];
-		};
-
 		struct PushConstants {
 			Matrix4 modelMatrix;
 			uint32_t cascadeIndex;
@@ -37,7 +31,8 @@ namespace milo {
 
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
-		VulkanUniformBuffer<ShadowData>* m_UniformBuffer{nullptr};
+		// Uniform ring generation each descriptor set was last written with
+		Array<uint32_t, MAX_SWAPCHAIN_IMAGE_COUNT> m_UniformRingGenerations{};
 
 		VulkanGraphicsPipeline* m_GraphicsPipeline = nullptr;
 
@@ -45,7 +40,8 @@ namespace milo {
 
 		Array<VkSemaphore, MAX_SWAPCHAIN_IMAGE_COUNT> m_SignalSemaphores{};
 
-		Ref<VulkanTexture2DArray> m_DepthTexture;
+		// Frame graph transient the cascade framebuffers were created for
+		VkImage m_ShadowMapImage{VK_NULL_HANDLE};
 
 		Array<VulkanShadowCascade, MAX_SHADOW_CASCADES> m_ShadowCascades{};
 
@@ -67,10 +63,11 @@ namespace milo {
 		void bindDescriptorSets(uint32_t imageIndex, VkCommandBuffer commandBuffer);
 		void createRenderPass();
 		void createDescriptorSetLayoutAndPool();
-		void createUniformBuffer();
 		void createDescriptorSets();
+		void updateDescriptorSet(uint32_t imageIndex);
 		void createGraphicsPipeline();
-		void createShadowCascades();
+		void createShadowCascades(VulkanTexture2DArray* shadowMap);
+		void destroyShadowCascades();
 		void createSemaphores();
 	};
 }
\ No newline at end of file
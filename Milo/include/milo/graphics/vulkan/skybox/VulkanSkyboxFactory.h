@@ -1,11 +1,13 @@
 #pragma once
 
 #include "milo/assets/skybox/SkyboxFactory.h"
+#include "milo/assets/skybox/SkyboxCache.h"
 #include "milo/io/Files.h"
 #include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
 #include "milo/graphics/vulkan/textures/VulkanCubemap.h"
 #include "milo/graphics/vulkan/commands/VulkanCommandPool.h"
 #include "milo/graphics/vulkan/descriptors/VulkanDescriptorPool.h"
+#include "milo/graphics/vulkan/rendering/VulkanComputePipeline.h"
 
 namespace milo {
 
@@ -20,6 +22,12 @@ namespace milo {
 		float azimuth;
 		float inclination;
 		VkCommandBuffer commandBuffer;
+		// Subset of the work to record, so regeneration can be spread over several frames.
+		// Faces are applied to each of the selected mip levels
+		uint32_t firstFace{0};
+		uint32_t faceCount{6};
+		uint32_t firstMipLevel{0};
+		uint32_t mipLevelCount{UINT32_MAX};
 	};
 
 	class VulkanEnvironmentMapPass {
@@ -28,11 +36,13 @@ namespace milo {
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
-		VkPipeline m_ComputePipeline{VK_NULL_HANDLE};
+		VulkanComputePipeline* m_ComputePipeline{nullptr};
 	public:
 		explicit VulkanEnvironmentMapPass(VulkanDevice* device);
 		~VulkanEnvironmentMapPass();
 		void execute(const VulkanSkyboxPassExecuteInfo& execInfo);
+		// Allocates the map as execute does, for maps whose contents come from somewhere else
+		void allocate(VulkanCubemap* environmentMap, const SkyboxLoadInfo& loadInfo);
 	private:
 		void updateDescriptorSet(const VulkanSkyboxPassExecuteInfo& execInfo);
 		void createDescriptorSetLayout();
@@ -47,11 +57,13 @@ namespace milo {
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
-		VkPipeline m_ComputePipeline{VK_NULL_HANDLE};
+		VulkanComputePipeline* m_ComputePipeline{nullptr};
 	public:
 		explicit VulkanIrradianceMapPass(VulkanDevice* device);
 		~VulkanIrradianceMapPass();
 		void execute(const VulkanSkyboxPassExecuteInfo& execInfo);
+		// Allocates the map as execute does, for maps whose contents come from somewhere else
+		void allocate(VulkanCubemap* irradianceMap, const SkyboxLoadInfo& loadInfo);
 	private:
 		void updateDescriptorSet(const VulkanSkyboxPassExecuteInfo& execInfo);
 		void createDescriptorSetLayout();
@@ -73,11 +85,13 @@ namespace milo {
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
-		VkPipeline m_ComputePipeline{VK_NULL_HANDLE};
+		VulkanComputePipeline* m_ComputePipeline{nullptr};
 	public:
 		explicit VulkanPrefilterMapPass(VulkanDevice* device);
 		~VulkanPrefilterMapPass();
 		void execute(const VulkanSkyboxPassExecuteInfo& execInfo);
+		// Allocates the map as execute does, for maps whose contents come from somewhere else
+		void allocate(VulkanCubemap* prefilterMap, const SkyboxLoadInfo& loadInfo);
 	private:
 		void updateDescriptorSet(const VulkanSkyboxPassExecuteInfo& execInfo);
 		void createDescriptorSetLayoutAndPool();
@@ -91,7 +105,7 @@ namespace milo {
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
-		VkPipeline m_ComputePipeline{VK_NULL_HANDLE};
+		VulkanComputePipeline* m_ComputePipeline{nullptr};
 	public:
 		explicit VulkanBRDFMapPass(VulkanDevice* device);
 		~VulkanBRDFMapPass();
@@ -110,7 +124,7 @@ namespace milo {
 		VkDescriptorSetLayout m_DescriptorSetLayout{VK_NULL_HANDLE};
 		VulkanDescriptorPool* m_DescriptorPool{nullptr};
 		VkPipelineLayout m_PipelineLayout{VK_NULL_HANDLE};
-		VkPipeline m_ComputePipeline{VK_NULL_HANDLE};
+		VulkanComputePipeline* m_ComputePipeline{nullptr};
 	public:
 		VulkanPreethamSkyEnvironmentPass(VulkanDevice* device);
 		~VulkanPreethamSkyEnvironmentPass();
@@ -124,6 +138,57 @@ namespace milo {
 		void createComputePipeline();
 	};
 
+	// A skybox whose maps are being loaded from the cache or generated
+	struct VulkanSkyboxJob {
+		Skybox* skybox{nullptr};
+		String imageFile;
+		SkyboxLoadInfo loadInfo{};
+		// Hashes the source image, then reads the cache entry or decodes the image. Runs on a worker thread
+		Future<void> sourceLoad;
+		uint64_t cacheKey{0};
+		bool cacheHit{false};
+		SkyboxCacheData cache;
+		Image* image{nullptr};
+		// GPU side. Filled by submit
+		VulkanTexture2D* equirectangularTexture{nullptr};
+		ArrayList<VulkanBuffer*> stagingBuffers;
+		Array<VulkanBuffer*, 3> readbackBuffers{};
+		VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+		VkFence fence{VK_NULL_HANDLE};
+	};
+
+	// Incremental regeneration of a PreethamSky. The maps of the sky are never written while they may be in use:
+	// the next ones are generated a few faces per frame into a second set of maps, swapped with the current ones when complete
+	struct VulkanPreethamSkyUpdate {
+		PreethamSky* sky{nullptr};
+		// Sizes of the maps of the sky when the incremental mode was first used
+		SkyboxLoadInfo fullLoadInfo{};
+		// Sizes of the maps being generated
+		SkyboxLoadInfo loadInfo{};
+		// Parameters of the maps being generated, or of the last ones if idle
+		float turbidity{0};
+		float azimuth{0};
+		float inclination{0};
+		VulkanCubemap* environmentMap{nullptr};
+		VulkanCubemap* irradianceMap{nullptr};
+		VulkanCubemap* prefilterMap{nullptr};
+		// Next face to generate, counting the faces of every map and mip level. UINT32_MAX when idle
+		uint32_t step{UINT32_MAX};
+		uint32_t facesPerStep{6};
+		// Last parameters requested for the sky
+		PreethamSkyUpdateRequest request{};
+		// The sky changed since the last update started
+		bool requested{false};
+		// The sky changed again before the previous maps were done, so the next ones are generated at low resolution
+		bool animating{false};
+		uint32_t framesSinceSwap{UINT32_MAX};
+		VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+		VkFence fence{VK_NULL_HANDLE};
+	};
+
+	// Image based lighting maps are generated once per source image and SkyboxLoadInfo and then loaded from the
+	// SkyboxCache. Only one job runs on the GPU at a time, since the passes share their descriptor sets.
+	// The BRDF integration map does not depend on the skybox, so every skybox uses the same one.
 	class VulkanSkyboxFactory : public SkyboxFactory {
 		friend class SkyboxFactory;
 	private:
@@ -133,14 +198,49 @@ namespace milo {
 		VulkanPrefilterMapPass* m_PrefilterPass{nullptr};
 		VulkanBRDFMapPass* m_BRDFPass{nullptr};
 		VulkanPreethamSkyEnvironmentPass* m_PreethamSkyPass{nullptr};
+		// Shared BRDF maps, by size
+		HashMap<uint32_t, VulkanTexture2D*> m_BRDFMaps;
+		ArrayList<VulkanSkyboxJob*> m_PendingJobs;
+		VulkanSkyboxJob* m_RunningJob{nullptr};
+		ArrayList<Future<void>> m_CacheWrites;
+		HashMap<PreethamSky*, VulkanPreethamSkyUpdate*> m_SkyUpdates;
+		// Sky update whose last step is still running on the GPU
+		VulkanPreethamSkyUpdate* m_RunningSkyUpdate{nullptr};
+		// Skyboxes are created by the simulation thread while the render thread updates the jobs and skies
+		Mutex m_Mutex;
 	private:
 		VulkanSkyboxFactory();
 		~VulkanSkyboxFactory() override;
 	public:
 		Skybox* create(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo = DEFAULT_SKYBOX_LOAD_INFO) override;
+		Skybox* createAsync(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo = DEFAULT_SKYBOX_LOAD_INFO) override;
+		void await(Skybox* skybox) override;
+		void update() override;
 		PreethamSky* createPreethamSky(const String& name, const SkyboxLoadInfo& loadInfo, float turbidity, float azimuth, float inclination) override;
-		void updatePreethamSky(PreethamSky* sky) override;
+		void updatePreethamSky(const PreethamSkyUpdateRequest& request) override;
 	private:
-		VulkanTexture2D* createEquirectangularTexture(const String& imageFile);
+		VulkanSkyboxJob* createJob(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo);
+		static void loadSource(VulkanSkyboxJob* job);
+		static void decodeSource(VulkanSkyboxJob* job);
+		// Returns false if the cache entry of the job is stale. Its image is then decoded again on a worker thread,
+		// and the job has to be submitted once that is done
+		bool submit(VulkanSkyboxJob* job);
+		void submitAndWait(VulkanSkyboxJob* job);
+		void createMaps(VulkanSkyboxJob* job);
+		bool validateCache(VulkanSkyboxJob* job);
+		void recordCacheUpload(VulkanSkyboxJob* job, VkCommandBuffer commandBuffer);
+		void recordGeneration(VulkanSkyboxJob* job, VkCommandBuffer commandBuffer);
+		void finish(VulkanSkyboxJob* job);
+		void awaitRunningJob();
+		void requestIncrementalUpdate(const PreethamSkyUpdateRequest& request);
+		void updateSkies();
+		void startSkyUpdate(VulkanPreethamSkyUpdate* update);
+		void recordSkyUpdateStep(VulkanPreethamSkyUpdate* update);
+		void finishSkyUpdateStep(VulkanPreethamSkyUpdate* update);
+		void awaitRunningSkyUpdate();
+		void destroySkyUpdate(VulkanPreethamSkyUpdate* update);
+		VulkanTexture2D* getBRDFMap(uint32_t size, bool& created);
+		VulkanTexture2D* createEquirectangularTexture(const Image& image, VkCommandBuffer commandBuffer, ArrayList<VulkanBuffer*>& stagingBuffers);
+		VulkanTexture2D* createThumbnailTexture(const SkyboxCacheImage& thumbnail);
 	};
 }
\ No newline at end of file
@@ -19,14 +19,20 @@ namespace milo {
 		VulkanIconFactory();
 		~VulkanIconFactory() override;
 	public:
-		Texture2D* createIcon(Mesh* mesh, Material* material, const Size& size) override;
+		Texture2D* createAtlas(const Size& size) override;
+		void bakeIcons(Texture2D* atlas, const Size& iconSize, ArrayList<IconBakeInfo>& icons) override;
 	private:
 		// Called once
 		void createRenderPass();
 		void createDepthTexture(const Size& size);
 		void createGraphicsPipeline();
-		// Called every time
-		static VulkanTexture2D* createTexture2D(const Size& size);
-		VkFramebuffer createFramebuffer(VulkanTexture2D* colorAttachment, const Size& size);
+		// Called every batch
+		VkFramebuffer createFramebuffer(VulkanTexture2D* colorAttachment);
+		void uploadIcons(VkCommandBuffer commandBuffer, VulkanTexture2D* atlas, const Size& iconSize,
+						 const ArrayList<IconBakeInfo>& icons, VulkanBuffer* stagingBuffer);
+		void renderIcons(VkCommandBuffer commandBuffer, VulkanTexture2D* atlas, VkFramebuffer framebuffer, const Size& iconSize,
+						 const ArrayList<IconBakeInfo>& icons);
+		void readbackIcons(VkCommandBuffer commandBuffer, VulkanTexture2D* atlas, const Size& iconSize,
+						   const ArrayList<IconBakeInfo>& icons, VulkanBuffer* readbackBuffer);
 	};
 }
\ No newline at end of file
@@ -24,6 +24,19 @@ namespace milo {
 			VkPipelineStageFlags srcStage{0};
 			VkPipelineStageFlags dstStage{0};
 		};
+
+		// What the last recorded barrier of a subresource left it as: its layout and the accesses later barriers must wait for
+		struct SubresourceState {
+			VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+			VkAccessFlags access{0};
+			VkPipelineStageFlags stages{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+
+			bool operator==(const SubresourceState& other) const;
+			bool operator!=(const SubresourceState& other) const;
+		};
+	private:
+		static ArrayList<VulkanTexture*> s_PendingTextures;
+		static Mutex s_PendingMutex;
 	protected:
 		VulkanDevice* m_Device;
 
@@ -36,7 +49,10 @@ namespace milo {
 		VkSampler m_VkSampler = VK_NULL_HANDLE;
 		VmaAllocation m_Allocation = VK_NULL_HANDLE;
 
-		VkImageLayout m_ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		// One per mip level of every layer, indexed by layer * mipLevels + level
+		ArrayList<SubresourceState> m_Subresources;
+		// Target states of the transitions requested and not flushed yet. Empty if there are none
+		ArrayList<SubresourceState> m_PendingSubresources;
 		VmaMemoryUsage m_Usage = VMA_MEMORY_USAGE_UNKNOWN;
 
 		VulkanTexture::CreateInfo m_CreateInfo;
@@ -56,7 +72,9 @@ namespace milo {
 		VkSampler vkSampler() const;
 		void vkSampler(VkSampler sampler);
 		VmaAllocation allocation() const;
+		// Layout of the first subresource. For images whose subresources are transitioned together
 		VkImageLayout layout() const;
+		VkImageLayout layout(uint32_t mipLevel, uint32_t arrayLayer) const;
 		VmaMemoryUsage memoryUsage() const;
 		void setDebugName(const String& name);
 
@@ -69,17 +87,49 @@ namespace milo {
 
 		void transitionLayout(VkCommandBuffer commandBuffer, const VkImageMemoryBarrier& barrier, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage);
 
-		void setLayout(VkImageLayout newLayout, VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-		void setLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		// Blocking transition: records it into a one time command buffer and waits for it. Only meant for load time code
+		void setLayoutImmediate(VkImageLayout newLayout, VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 		void setLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 		void setLayout(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		// Queues a transition of the whole image (or of the given subresources) to be recorded by the next call to
+		// flushPendingBarriers, which batches every pending transition into a single barrier of the command buffer of
+		// the pass that consumes them. Requesting again before the flush replaces the target state
+		void requestLayout(VkImageLayout newLayout, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+		void requestLayout(const VkImageSubresourceRange& range, VkImageLayout newLayout, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask);
+		bool hasPendingLayout() const;
+		// Records a layout change made outside of this class, like the final layout of a render pass or a frame graph barrier.
+		// It supersedes any pending transition of the image
+		void setCurrentLayout(VkImageLayout layout, VkAccessFlags access = VK_ACCESS_MEMORY_WRITE_BIT, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		// Two step allocation for images whose memory is owned by someone else, like the aliased transients of the
+		// frame graph. That memory is not freed with the image
+		void createImage(uint32_t width, uint32_t height, PixelFormat format, uint32_t mipLevels);
+		VkMemoryRequirements memoryRequirements() const;
+		virtual void bindMemory(VmaAllocation memory);
+
+		// Tightly packed size of the first mipLevels levels of every layer, laid out as copyMipLevelsToBuffer writes them
+		uint64_t mipLevelsSize(uint32_t mipLevels) const;
+		// The image must be in TRANSFER_SRC_OPTIMAL / TRANSFER_DST_OPTIMAL layout when the commands execute
+		void copyMipLevelsToBuffer(VkCommandBuffer commandBuffer, VulkanBuffer& buffer, uint32_t mipLevels) const;
+		void copyMipLevelsFromBuffer(VkCommandBuffer commandBuffer, VulkanBuffer& buffer, uint32_t mipLevels);
 
 	protected:
 		void allocate(uint32_t width, uint32_t height, PixelFormat format, uint32_t mipLevels);
+		void setImageInfo(uint32_t width, uint32_t height, PixelFormat format, uint32_t mipLevels);
+		void createImageView();
 		void copyFromBuffer(VkCommandBuffer commandBuffer, VulkanBuffer& buffer);
+		ArrayList<VkBufferImageCopy> mipLevelCopyRegions(uint32_t mipLevels) const;
+		void resetSubresources();
+		uint32_t subresourceIndex(uint32_t mipLevel, uint32_t arrayLayer) const;
+		void cancelPendingLayout();
+		void recordPendingBarriers(ArrayList<VkImageMemoryBarrier>& barriers, VkPipelineStageFlags& srcStages, VkPipelineStageFlags& dstStages);
 
 		virtual void destroy();
 
 		void create(const CreateInfo& createInfo);
+	public:
+		// Records every pending transition into commandBuffer with one vkCmdPipelineBarrier. Must be called outside of
+		// a render pass instance, before the commands that need the new layouts
+		static void flushPendingBarriers(VkCommandBuffer commandBuffer);
 	};
 }
\ No newline at end of file
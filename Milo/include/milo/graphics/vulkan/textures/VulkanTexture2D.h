@@ -37,10 +37,13 @@ namespace milo {
 		explicit VulkanTexture2DArray(const CreateInfo& createInfo);
 		explicit VulkanTexture2DArray(const VulkanTexture2D& other) = delete;
 	public:
+		~VulkanTexture2DArray() override;
 		uint32_t numLayers() const;
 		VkImageView getLayer(uint32_t index) const;
 		void allocate(const Texture2D::AllocInfo& allocInfo) override;
+		void bindMemory(VmaAllocation memory) override;
 	protected:
+		void createLayerViews();
 		void destroy() override;
 	public:
 		static VulkanTexture2DArray* create(TextureUsageFlags usage, uint32_t numLayers);
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "milo/common/Common.h"
+
+namespace milo {
+
+	// Reports the files modified inside a set of directories, with inotify on Linux (elsewhere nothing is reported).
+	// A background thread collects the changes, and poll() hands out the files that have not been written for a while,
+	// since editors usually save a file in several steps
+	class FileWatcher {
+		friend class MiloSubSystemManager;
+	private:
+		static Thread s_Thread;
+		static AtomicBool s_Running;
+		static int32_t s_Handle;
+		// Watch descriptor to watched directory
+		static HashMap<int32_t, String> s_Directories;
+		// Absolute path to the time of its last change
+		static HashMap<String, float> s_Changes;
+		static Mutex s_Mutex;
+	public:
+		static bool supported();
+		// Subdirectories are watched too, including the ones created later
+		static void watch(const String& directory);
+		// Absolute paths of the files that have settled since the last call
+		static ArrayList<String> poll();
+	private:
+		static void init();
+		static void shutdown();
+		static void run();
+		static void addWatch(const String& directory);
+	public:
+		FileWatcher() = delete;
+	};
+}
\ No newline at end of file
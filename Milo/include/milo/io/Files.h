@@ -37,5 +37,8 @@ namespace milo {
 		static void writeAllBytes(const String& filename, const int8* bytes, uint32 size);
 		static void writeAllText(const String& filename, const String& str);
 		static void writeAllLines(const String& filename, const ArrayList<String>& lines);
+		// Writes to a temporary file and renames it over filename, so a crash never leaves a truncated file behind.
+		// Failures are logged; returns whether filename now holds the new contents
+		static bool writeAtomically(const String& filename, const Function<void, OutputStream&>& write);
 	};
 }
\ No newline at end of file
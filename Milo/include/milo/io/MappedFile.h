@@ -0,0 +1,29 @@
+#pragma once
+
+#include "milo/common/Common.h"
+
+namespace milo {
+
+	// Read only view of a whole file mapped into memory. Pages are loaded by the OS as they are touched
+	class MappedFile {
+	private:
+		const byte_t* m_Data{nullptr};
+		uint64_t m_Size{0};
+#ifdef _WIN32
+		void* m_File{nullptr};
+		void* m_Mapping{nullptr};
+#else
+		int m_File{-1};
+#endif
+	public:
+		explicit MappedFile(const String& filename);
+		~MappedFile();
+		MappedFile(const MappedFile& other) = delete;
+		MappedFile& operator=(const MappedFile& other) = delete;
+		inline bool valid() const {return m_Data != nullptr;}
+		inline const byte_t* data() const {return m_Data;}
+		inline uint64_t size() const {return m_Size;}
+	private:
+		void unmap();
+	};
+}
\ No newline at end of file
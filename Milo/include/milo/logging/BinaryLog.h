@@ -0,0 +1,55 @@
+#pragma once
+
+#include "LogRecord.h"
+#include "milo/io/Files.h"
+
+namespace milo {
+
+	// Binary structured logs store each format string once and then only its id and the raw arguments of every message,
+	// which is much smaller and cheaper to write than text. They are expanded to text by milo_logdecode.
+	//
+	// File layout: magic, version, then a sequence of entries starting with a BinaryLogEntry tag
+	//   Format:  id (u32), length (u32), characters
+	//   Message: time in ns (i64), level (u8), thread (u32), format id (u32), argument count (u8),
+	//            then for each argument its LogArgumentType (u8) and its value (strings as length (u32) and characters)
+	enum class BinaryLogEntry : uint8_t {
+		Format,
+		Message
+	};
+
+	class BinaryLogSink {
+	public:
+		static constexpr uint32_t MAGIC = 0x474F4C4D; // MLOG
+		static constexpr uint32_t VERSION = 1;
+	private:
+		String m_Filename;
+		OutputStream m_Output;
+		HashMap<const char*, uint32_t> m_FormatIds;
+		ArrayList<byte_t> m_Buffer;
+	public:
+		explicit BinaryLogSink(String filename);
+		~BinaryLogSink();
+		BinaryLogSink(const BinaryLogSink&) = delete;
+		BinaryLogSink& operator=(const BinaryLogSink&) = delete;
+		const String& filename() const;
+		bool isOpen() const;
+		void write(const LogRecord& record);
+		void flush();
+	private:
+		uint32_t formatIdOf(fmt::string_view format);
+	};
+
+	struct DecodedLogMessage {
+		int64_t time{0};
+		spdlog::level::level_enum level{spdlog::level::info};
+		uint32_t threadId{0};
+		String message;
+	};
+
+	class BinaryLogReader {
+	public:
+		// Calls the callback for each message of the file, in the order they were logged. Throws if the file is not a binary log.
+		// A truncated last message, as left by a crash, is ignored
+		static void read(const String& filename, const Function<void, const DecodedLogMessage&>& callback);
+	};
+}
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "milo/common/Common.h"
+#include "LogRingBuffer.h"
 #include <spdlog/spdlog.h>
+#include <condition_variable>
 
 #ifdef _DEBUG
 #define LOG_DEBUG(message) milo::Log::debug(MILO_DETAILED_MESSAGE((message))
@@ -14,8 +16,22 @@
 
 namespace milo {
 
+	class BinaryLogSink;
+
 	class Log {
 		friend class MiloSubSystemManager;
+		friend class MiloBenchmark;
+
+	public:
+		// What a caller does when the ring buffer of the asynchronous mode is full
+		enum class OverflowPolicy {
+			// The message is discarded and counted, the caller never waits
+			Drop,
+			// The caller waits until the logging thread makes room
+			Block
+		};
+
+		static constexpr size_t DEFAULT_ASYNC_CAPACITY = 8192;
 
 	public:
 		enum class Level {
@@ -36,7 +52,7 @@ namespace milo {
 		template<typename... Args>
 		static void debug(fmt::format_string<Args...> fmt, Args &&...args)
 		{
-			s_Logger->debug(fmt, std::forward<Args>(args)...);
+			submit(spdlog::level::debug, fmt, std::forward<Args>(args)...);
 		}
 #else
 		inline static void debug(const String& message) {}
@@ -48,30 +64,122 @@ namespace milo {
 		template<typename... Args>
 		static void info(fmt::format_string<Args...> fmt, Args &&...args)
 		{
-			s_Logger->info(fmt, std::forward<Args>(args)...);
+			submit(spdlog::level::info, fmt, std::forward<Args>(args)...);
 		}
 
 		static void warn(const String& message);
 		template<typename... Args>
 		static void warn(fmt::format_string<Args...> fmt, Args &&...args)
 		{
-			s_Logger->warn(fmt, std::forward<Args>(args)...);
+			submit(spdlog::level::warn, fmt, std::forward<Args>(args)...);
 		}
 
 		static void error(const String& message);
 		template<typename... Args>
 		static void error(fmt::format_string<Args...> fmt, Args &&...args)
 		{
-			s_Logger->error(fmt, std::forward<Args>(args)...);
+			submit(spdlog::level::err, fmt, std::forward<Args>(args)...);
 		}
 
+		// Moves formatting and output to a logging thread. Callers only capture their arguments into a lock free ring buffer.
+		// Must not be called while other threads are logging, like at startup
+		static void startAsync(size_t capacity = DEFAULT_ASYNC_CAPACITY, OverflowPolicy policy = OverflowPolicy::Drop);
+		// Writes the pending messages and goes back to logging on the calling thread
+		static void stopAsync();
+		static bool async();
+		// Messages discarded because the ring buffer was full
+		static uint64_t droppedCount();
+		// Writes every message to a binary structured log as well (see BinaryLog.h)
+		static bool openBinaryLog(const String& filename);
+		static void closeBinaryLog();
+		// Waits until the pending messages are written and flushes the sinks
+		static void flush();
+
 	private:
 		static void init();
 		static void shutdown();
 
+		template<typename... Args>
+		static void submit(spdlog::level::level_enum level, fmt::format_string<Args...> fmt, Args&&... args) {
+
+			if(!s_Logger->should_log(level)) return;
+
+			if(!s_Deferred.load(std::memory_order_acquire)) {
+				s_Logger->log(level, fmt, std::forward<Args>(args)...);
+				return;
+			}
+
+			const fmt::string_view format = fmt;
+
+			auto capture = [&](LogRecord& record) {
+				record.time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+				record.threadId = threadId();
+				record.level = level;
+				record.capture(format, std::forward<Args>(args)...);
+			};
+
+			if(tryPushAsync(capture)) return;
+
+			// Synchronous, but the binary log needs the captured arguments
+			LogRecord record;
+			capture(record);
+			process(record);
+			record.destroy();
+		}
+
+		// Returns false if the asynchronous mode is off. Counted as a ring buffer user until the push is done,
+		// so stopAsync() never frees the ring buffer under it
+		template<typename Writer>
+		static bool tryPushAsync(Writer& capture) {
+
+			s_RingBufferUsers.fetch_add(1);
+			LogRingBuffer* ringBuffer = s_RingBuffer.load();
+
+			if(ringBuffer != nullptr) {
+				if(ringBuffer->tryPush(capture)) {
+					notifyLoggingThread();
+				} else if(s_OverflowPolicy == OverflowPolicy::Drop) {
+					s_DroppedCount.fetch_add(1, std::memory_order_relaxed);
+				} else {
+					while(!ringBuffer->tryPush(capture)) {
+						std::this_thread::yield();
+					}
+					notifyLoggingThread();
+				}
+			}
+
+			s_RingBufferUsers.fetch_sub(1, std::memory_order_release);
+
+			return ringBuffer != nullptr;
+		}
+
+		inline static void notifyLoggingThread() {
+			// Pairs with the fence in run(): either the logging thread sees the record or this sees it asleep
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(s_LoggingThreadSleeping.load(std::memory_order_relaxed)) wakeLoggingThread();
+		}
+
+		static uint32_t threadId();
+		static void process(const LogRecord& record);
+		static void wakeLoggingThread();
+		static void run(LogRingBuffer* ringBuffer);
+
 	private:
 		static Ref<spdlog::logger> s_Logger;
 		static Level s_Level;
+		static AtomicBool s_Deferred;
+		static Atomic<LogRingBuffer*> s_RingBuffer;
+		// Threads between loading s_RingBuffer and their last access to it
+		static AtomicUInt s_RingBufferUsers;
+		static OverflowPolicy s_OverflowPolicy;
+		static Atomic<uint64_t> s_DroppedCount;
+		static AtomicBool s_Running;
+		static AtomicBool s_LoggingThreadSleeping;
+		static Mutex s_LoggingThreadMutex;
+		static std::condition_variable s_MessagePushed;
+		static Thread s_Thread;
+		static BinaryLogSink* s_BinaryLog;
+		static Mutex s_BinaryLogMutex;
 	};
 
 }
\ No newline at end of file
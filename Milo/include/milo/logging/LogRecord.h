@@ -0,0 +1,135 @@
+#pragma once
+
+#include "milo/common/Common.h"
+#include <spdlog/spdlog.h>
+#include <tuple>
+#include <cstddef>
+
+namespace milo {
+
+	// Tag of each argument of a binary log record (see BinaryLogSink)
+	enum class LogArgumentType : uint8_t {
+		Int,
+		UInt,
+		Float,
+		Double,
+		Bool,
+		Char,
+		String
+	};
+
+	// Appends the tagged arguments of a record to a binary buffer
+	class LogArgumentWriter {
+	private:
+		ArrayList<byte_t>& m_Buffer;
+	public:
+		explicit LogArgumentWriter(ArrayList<byte_t>& buffer);
+		void write(const void* data, size_t size);
+		void writeInt(int64_t value);
+		void writeUInt(uint64_t value);
+		void writeFloat(float value);
+		void writeDouble(double value);
+		void writeBool(bool value);
+		void writeChar(char value);
+		void writeString(fmt::string_view value);
+	};
+
+	// How an argument is stored until the record is processed. Strings are copied, the caller's ones may not live that long
+	template<typename T>
+	struct LogCapture {
+		using Type = std::decay_t<T>;
+	};
+
+	template<>
+	struct LogCapture<const char*> {
+		using Type = String;
+	};
+
+	template<>
+	struct LogCapture<char*> {
+		using Type = String;
+	};
+
+	template<>
+	struct LogCapture<std::string_view> {
+		using Type = String;
+	};
+
+	template<typename T>
+	using LogCaptureType = typename LogCapture<std::decay_t<T>>::Type;
+
+	template<typename T>
+	void serializeLogArgument(LogArgumentWriter& writer, const T& value) {
+		if constexpr(std::is_same_v<T, bool>) writer.writeBool(value);
+		else if constexpr(std::is_same_v<T, char>) writer.writeChar(value);
+		else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>) writer.writeInt(value);
+		else if constexpr(std::is_integral_v<T>) writer.writeUInt(value);
+		else if constexpr(std::is_same_v<T, float>) writer.writeFloat(value);
+		else if constexpr(std::is_floating_point_v<T>) writer.writeDouble((double)value);
+		else if constexpr(std::is_same_v<T, String>) writer.writeString(value);
+		// Anything else is formatted on the logging thread and stored as text
+		else writer.writeString(fmt::format("{}", value));
+	}
+
+	// A log message whose arguments are captured by value and formatted later, on the logging thread.
+	// The arguments live in the record itself, so capturing a message never allocates unless it has string arguments
+	struct LogRecord {
+
+		static const size_t STORAGE_SIZE = 192;
+
+		using FormatFunction = void(*)(const LogRecord& record, fmt::memory_buffer& output);
+		using SerializeFunction = void(*)(const LogRecord& record, LogArgumentWriter& writer);
+		using DestroyFunction = void(*)(LogRecord& record);
+
+		// Nanoseconds since the epoch of the system clock
+		int64_t time{0};
+		uint32_t threadId{0};
+		spdlog::level::level_enum level{spdlog::level::info};
+		// Always a string literal, its address identifies the format in binary logs
+		fmt::string_view format;
+		FormatFunction formatFunction{nullptr};
+		SerializeFunction serializeFunction{nullptr};
+		DestroyFunction destroyFunction{nullptr};
+		uint8_t argumentCount{0};
+		alignas(std::max_align_t) byte_t storage[STORAGE_SIZE];
+
+		template<typename... Args>
+		void capture(fmt::string_view formatString, Args&&... args) {
+
+			using Arguments = std::tuple<LogCaptureType<Args>...>;
+
+			if constexpr(sizeof(Arguments) <= STORAGE_SIZE && alignof(Arguments) <= alignof(std::max_align_t)) {
+
+				new(storage) Arguments(std::forward<Args>(args)...);
+
+				format = formatString;
+				argumentCount = (uint8_t)sizeof...(Args);
+
+				formatFunction = [](const LogRecord& record, fmt::memory_buffer& output) {
+					std::apply([&](const auto&... values) {
+						fmt::vformat_to(fmt::appender(output), record.format, fmt::make_format_args(values...));
+					}, *reinterpret_cast<const Arguments*>(record.storage));
+				};
+
+				serializeFunction = [](const LogRecord& record, LogArgumentWriter& writer) {
+					std::apply([&](const auto&... values) {
+						(serializeLogArgument(writer, values), ...);
+					}, *reinterpret_cast<const Arguments*>(record.storage));
+				};
+
+				destroyFunction = [](LogRecord& record) {
+					reinterpret_cast<Arguments*>(record.storage)->~Arguments();
+				};
+
+			} else {
+				// Too large to be kept in the record, formatted now instead
+				String message = fmt::vformat(formatString, fmt::make_format_args(args...));
+				capture(fmt::string_view("{}"), std::move(message));
+			}
+		}
+
+		void formatTo(fmt::memory_buffer& output) const;
+		void serialize(LogArgumentWriter& writer) const;
+		void destroy();
+	};
+}
\ No newline at end of file
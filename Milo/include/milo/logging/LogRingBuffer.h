@@ -0,0 +1,74 @@
+#pragma once
+
+#include "LogRecord.h"
+
+namespace milo {
+
+	// Bounded multi producer single consumer queue of log records. Producers claim a slot with a compare and swap on the
+	// write position and publish it through the sequence number of the slot, so they never take a lock nor wait for each other.
+	// The capacity is rounded up to a power of two
+	class LogRingBuffer {
+	private:
+		struct Slot {
+			Atomic<size_t> sequence{0};
+			LogRecord record;
+		};
+	private:
+		Slot* m_Slots{nullptr};
+		size_t m_Mask{0};
+		alignas(64) Atomic<size_t> m_WritePosition{0};
+		alignas(64) Atomic<size_t> m_ReadPosition{0};
+	public:
+		explicit LogRingBuffer(size_t capacity);
+		~LogRingBuffer();
+		LogRingBuffer(const LogRingBuffer&) = delete;
+		LogRingBuffer& operator=(const LogRingBuffer&) = delete;
+		size_t capacity() const;
+		// Calls write(LogRecord&) on a free slot. Returns false without calling it if the buffer is full
+		template<typename Writer>
+		bool tryPush(Writer&& write) {
+
+			size_t position = m_WritePosition.load(std::memory_order_relaxed);
+			Slot* slot;
+
+			while(true) {
+				slot = &m_Slots[position & m_Mask];
+				const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+				const auto difference = (intptr_t)sequence - (intptr_t)position;
+
+				if(difference == 0) {
+					if(m_WritePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+				} else if(difference < 0) {
+					return false;
+				} else {
+					position = m_WritePosition.load(std::memory_order_relaxed);
+				}
+			}
+
+			write(slot->record);
+			slot->sequence.store(position + 1, std::memory_order_release);
+
+			return true;
+		}
+		// Consumer only. Calls read(const LogRecord&) on the oldest record and releases it. Returns false if the buffer is empty
+		template<typename Reader>
+		bool tryPop(Reader&& read) {
+
+			const size_t position = m_ReadPosition.load(std::memory_order_relaxed);
+			Slot& slot = m_Slots[position & m_Mask];
+			const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+			if(sequence != position + 1) return false;
+
+			read((const LogRecord&)slot.record);
+			slot.record.destroy();
+
+			slot.sequence.store(position + m_Mask + 1, std::memory_order_release);
+			m_ReadPosition.store(position + 1, std::memory_order_release);
+
+			return true;
+		}
+		// True once every record pushed so far has been popped
+		bool empty() const;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "milo/common/Collections.h"
+#include "milo/graphics/Vertex.h"
+
+namespace milo {
+
+	// Positions of the vertices of a mesh, one array per component, so that passes over them can be vectorized.
+	// Vertices that no index references are left out
+	struct PositionStream {
+
+		ArrayList<float> x;
+		ArrayList<float> y;
+		ArrayList<float> z;
+
+		inline size_t size() const {return x.size();}
+		inline Vector3 operator[](size_t index) const {return {x[index], y[index], z[index]};}
+
+		static PositionStream of(const ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices);
+	};
+
+	// Bounding volume fitting over a PositionStream. Passes over large streams are split in chunks run by the
+	// JobSystem, and the candidate axes of the oriented box are evaluated in parallel
+	class BoundingVolumeFitting {
+	public:
+		static BoundingSphere sphere(const PositionStream& positions);
+		static AxisAlignedBoundingBox aabb(const PositionStream& positions);
+		static OrientedBoundingBox obb(const PositionStream& positions);
+	public:
+		BoundingVolumeFitting() = delete;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "milo/scenes/EntityComponentSystem.h"
+
+namespace milo {
+
+	class Scene;
+
+	// Structural changes (create, destroy, add or remove components) recorded while scripts run in parallel.
+	// The scene applies them on the main thread once every script has finished, in the order they were recorded.
+	class EntityCommandBuffer {
+		friend class Scene;
+	private:
+		ArrayList<Function<void, Scene*, ECSRegistry&>> m_Commands;
+	public:
+		void createEntity(const String& name = "Unnamed", Function<void, Scene*, EntityId> onCreated = {});
+		void destroyEntity(EntityId entityId);
+
+		template<typename T, typename ...Args>
+		void addComponent(EntityId entityId, Args&& ...args) {
+			m_Commands.push_back([entityId, component = T(std::forward<Args>(args)...)](Scene*, ECSRegistry& registry) {
+				if(registry.valid(entityId)) registry.emplace_or_replace<T>(entityId, component);
+			});
+		}
+
+		template<typename T>
+		void removeComponent(EntityId entityId) {
+			m_Commands.push_back([entityId](Scene*, ECSRegistry& registry) {
+				if(registry.valid(entityId)) registry.remove<T>(entityId);
+			});
+		}
+
+		bool empty() const;
+	private:
+		void apply(Scene* scene, ECSRegistry& registry);
+	};
+}
\ No newline at end of file
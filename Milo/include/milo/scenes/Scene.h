@@ -1,15 +1,39 @@
 #pragma once
 
 #include "EntityComponentSystem.h"
+#include "EntityCommandBuffer.h"
 #include "milo/scenes/Components.h"
 #include "milo/assets/skybox/Skybox.h"
 
 namespace milo {
 
+	enum class ScriptSchedulingMode {
+		// Every script runs on the main thread, one after the other
+		Serial,
+		// Scripts that declare their ScriptAccess are grouped by it and run in parallel chunks over the JobSystem.
+		// Exclusive scripts still run on the main thread, before the rest
+		Parallel
+	};
+
+	// A structural change of the entity tree, recorded so tools like the editor hierarchy can follow the scene
+	// without walking every entity each frame. The entity may not exist anymore when the change is read
+	struct SceneHierarchyChange {
+		enum class Type : uint8_t {
+			// Created and Reparented entities must be placed under their current parent
+			Created,
+			Reparented,
+			Renamed,
+			Destroyed
+		};
+		Type type;
+		EntityId entity;
+	};
+
 	class Scene {
 		friend class SceneManager;
 		friend class Entity;
 		friend class MiloEditor;
+		friend class SceneSnapshot;
 	private:
 		const String m_Name;
 		ECSRegistry m_Registry;
@@ -17,6 +41,12 @@ namespace milo {
 		EntityId m_SkyEntity = NULL_ENTITY;
 		Viewport m_Viewport{};
 		bool m_Focused = false;
+		ScriptSchedulingMode m_ScriptSchedulingMode{ScriptSchedulingMode::Serial};
+		EntityCommandBuffer m_Commands;
+		ArrayList<EntityCommandBuffer> m_ChunkCommands;
+		ArrayList<SceneHierarchyChange> m_HierarchyChanges;
+		// Nobody has read the hierarchy of a new scene yet, so changes are not recorded until the first consume
+		bool m_HierarchyChangesLost{true};
 	private:
 		explicit Scene(const String& name);
 		explicit Scene(String&& name);
@@ -36,6 +66,13 @@ namespace milo {
 		const Viewport& viewport() const noexcept;
 		Size viewportSize() const noexcept;
 		bool focused() const;
+		ScriptSchedulingMode scriptSchedulingMode() const;
+		void setScriptSchedulingMode(ScriptSchedulingMode mode);
+		// Where scripts record structural changes. They are applied once every script of the current phase has finished
+		EntityCommandBuffer& commands();
+		// Moves the hierarchy changes recorded since the last call into changes, in order. Returns false if there were
+		// too many to keep, in which case the whole hierarchy must be read again
+		bool consumeHierarchyChanges(ArrayList<SceneHierarchyChange>& changes);
 
 		template<typename Component>
 		ECSComponentView<Component> view() {
@@ -53,5 +90,9 @@ namespace milo {
 		void update();
 		void lateUpdate();
 		void setFocused(bool focused);
+		void runScripts(bool lateUpdate);
+		void runScriptsInParallel(ArrayList<std::pair<EntityId, NativeScript*>>& scripts, bool lateUpdate);
+		void applyCommands();
+		void recordHierarchyChange(SceneHierarchyChange::Type type, EntityId entityId);
 	};
 }
\ No newline at end of file
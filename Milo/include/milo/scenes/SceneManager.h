@@ -9,9 +9,13 @@ namespace milo {
 		friend class MiloSubSystemManager;
 	private:
 		static Scene* s_ActiveScene;
+		static ArrayList<Future<bool>> s_PendingSaves;
 	public:
 		static Scene* activeScene();
-		// TODO: load and save scenes
+		// Replaces the active scene with the one stored in the snapshot. Call it between frames
+		static bool load(const String& filename);
+		// The scene is copied right away, but encoded and written in the background
+		static void save(const String& filename);
 	private:
 		static void update();
 		static void lateUpdate();
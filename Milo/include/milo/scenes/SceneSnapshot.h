@@ -0,0 +1,144 @@
+#pragma once
+
+#include "milo/scenes/Scene.h"
+
+namespace milo {
+
+	enum class SceneAssetType : uint32_t {
+		Mesh, Material, Skybox, PreethamSky
+	};
+
+	// Compact binary copy of a scene. Each component type is stored as a contiguous array and assets are referenced
+	// by a stable id (a hash of their type and name), so loading a snapshot is a handful of bulk registry inserts.
+	// Only the entity hierarchy, transforms, mesh views, cameras, lights and skybox views are stored.
+	class SceneSnapshot {
+	public:
+		static const uint32_t MAGIC = 0x4E43534D; // MSCN
+		static const uint32_t VERSION = 1;
+		static const uint32_t NO_ENTITY = UINT32_MAX;
+
+		enum class Section : uint32_t {
+			Strings,
+			Assets,
+			Entities,
+			Children,
+			Transforms,
+			MeshViews,
+			Cameras,
+			DirectionalLights,
+			PointLights,
+			SkyLights,
+			SkyboxViews
+		};
+
+		static const uint32_t SECTION_COUNT = (uint32_t)Section::SkyboxViews + 1;
+
+		// Slice of the strings section
+		struct StringRef {
+			uint32_t offset{0};
+			uint32_t length{0};
+		};
+
+		struct SectionInfo {
+			uint64_t offset{0};
+			uint64_t size{0};
+		};
+
+		struct Header {
+			uint32_t magic{MAGIC};
+			uint32_t version{VERSION};
+			uint32_t entityCount{0};
+			uint32_t mainCamera{NO_ENTITY};
+			uint32_t skyEntity{NO_ENTITY};
+			uint32_t sectionCount{SECTION_COUNT};
+			StringRef name{};
+			SectionInfo sections[SECTION_COUNT]{};
+		};
+
+		struct AssetRecord {
+			uint64_t id{0};
+			SceneAssetType type{SceneAssetType::Mesh};
+			StringRef name{};
+			StringRef filename{};
+		};
+
+		// Entities are referenced by their index in the entities section
+		struct EntityRecord {
+			uint32_t parent{NO_ENTITY};
+			// Range of the children section
+			uint32_t firstChild{0};
+			uint32_t childCount{0};
+			StringRef name{};
+		};
+
+		struct TransformRecord {
+			Vector3 translation;
+			Vector3 scale;
+			Quaternion rotation;
+		};
+
+		struct MeshViewRecord {
+			uint64_t mesh{0};
+			uint64_t material{0};
+			uint32_t entity{NO_ENTITY};
+			uint32_t opaque{1};
+			uint32_t castShadows{1};
+		};
+
+		struct CameraRecord {
+			uint32_t entity{NO_ENTITY};
+			Camera camera{};
+		};
+
+		struct DirectionalLightRecord {
+			uint32_t entity{NO_ENTITY};
+			DirectionalLight light{};
+		};
+
+		struct PointLightRecord {
+			uint32_t entity{NO_ENTITY};
+			PointLight light{};
+		};
+
+		struct SkyLightRecord {
+			uint64_t sky{0};
+			uint32_t entity{NO_ENTITY};
+			DirectionalLight light{};
+		};
+
+		struct SkyboxViewRecord {
+			uint64_t skybox{0};
+			uint32_t entity{NO_ENTITY};
+			SkyType type{SkyType::Static};
+			uint32_t enabled{1};
+		};
+
+	private:
+		Header m_Header{};
+		String m_Strings;
+		ArrayList<AssetRecord> m_Assets;
+		ArrayList<EntityRecord> m_Entities;
+		ArrayList<uint32_t> m_Children;
+		ArrayList<TransformRecord> m_Transforms;
+		ArrayList<MeshViewRecord> m_MeshViews;
+		ArrayList<CameraRecord> m_Cameras;
+		ArrayList<DirectionalLightRecord> m_DirectionalLights;
+		ArrayList<PointLightRecord> m_PointLights;
+		ArrayList<SkyLightRecord> m_SkyLights;
+		ArrayList<SkyboxViewRecord> m_SkyboxViews;
+		HashMap<uint64_t, uint32_t> m_AssetIndices;
+	public:
+		SceneSnapshot() = default;
+		// Copies the components of the scene. Must be called from the thread that updates the scene
+		explicit SceneSnapshot(Scene* scene);
+		uint32_t entityCount() const;
+		// Encodes the snapshot and writes it. Safe to call from any thread
+		bool write(const String& filename) const;
+		// Creates a scene from the file. Returns null if the file is missing or invalid
+		static Scene* load(const String& filename);
+		static uint64_t assetIdOf(SceneAssetType type, const String& name);
+	private:
+		StringRef addString(const String& str);
+		uint64_t addAsset(SceneAssetType type, const Asset* asset);
+	};
+}
\ No newline at end of file
@@ -109,13 +109,17 @@ namespace milo {
 			return milo::lookAt(position, position + m_Forward, m_Up);
 		}
 
+		// Uses the main window when there is one, the camera viewport otherwise (headless tools)
+		inline float aspectRatio() const {
+			if(Window::get() != nullptr) return Window::get()->aspectRatio();
+			return m_Viewport.w == 0 ? 1.0f : m_Viewport.z / m_Viewport.w;
+		}
+
 		inline const Matrix4 projectionMatrix() const {
 
 			updateOrientation();
 
-			//float aspect = m_Viewport.w == 0 ? 0 : m_Viewport.z / m_Viewport.w;
-
-			float aspect = Window::get()->aspectRatio();
+			float aspect = aspectRatio();
 
 			if(m_ProjectionType == ProjectionType::Perspective) {
 				return perspective(m_Fov, aspect, m_NearPlane, m_FarPlane);
@@ -6,6 +6,7 @@ namespace milo {
 
 	class EntityBasicInfo {
 		friend class Entity;
+		friend class SceneSnapshot;
 	private:
 		String m_Name{"Unnamed"};
 		EntityId m_ParentId{NULL_ENTITY};
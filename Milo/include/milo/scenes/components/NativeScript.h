@@ -1,14 +1,72 @@
 #pragma once
 
 #include "milo/scenes/EntityComponentSystem.h"
+#include <bitset>
 
 namespace milo {
 
 	class Entity;
 
+	const uint32_t MAX_SCRIPT_COMPONENT_TYPES = 64;
+
+	// Components a script touches from onUpdate and onLateUpdate, so the scene knows which scripts may run at the same time.
+	// Writes are only allowed on the components of the entity the script belongs to, while reads may target any entity.
+	// Structural changes must go through Scene::commands(). Scripts are exclusive unless they declare their access.
+	class ScriptAccess {
+	private:
+		std::bitset<MAX_SCRIPT_COMPONENT_TYPES> m_Reads;
+		std::bitset<MAX_SCRIPT_COMPONENT_TYPES> m_Writes;
+		bool m_Exclusive{true};
+	public:
+		ScriptAccess() = default;
+
+		// Reading a component of its own entity is implied by writing it
+		template<typename ...Components>
+		ScriptAccess& read() {
+			m_Exclusive = false;
+			(m_Reads.set(componentIndex<Components>()), ...);
+			return *this;
+		}
+
+		template<typename ...Components>
+		ScriptAccess& write() {
+			m_Exclusive = false;
+			(m_Writes.set(componentIndex<Components>()), ...);
+			return *this;
+		}
+
+		inline bool exclusive() const {return m_Exclusive;}
+
+		inline bool conflicts(const ScriptAccess& other) const {
+			if(m_Exclusive || other.m_Exclusive) return true;
+			return (m_Writes & other.m_Reads).any() || (other.m_Writes & m_Reads).any();
+		}
+
+		inline bool operator==(const ScriptAccess& other) const {
+			return m_Exclusive == other.m_Exclusive && m_Reads == other.m_Reads && m_Writes == other.m_Writes;
+		}
+
+		inline bool operator!=(const ScriptAccess& other) const {
+			return !(*this == other);
+		}
+
+	private:
+		static uint32_t nextComponentIndex();
+
+		template<typename Component>
+		static uint32_t componentIndex() {
+			static const uint32_t index = nextComponentIndex();
+			return index;
+		}
+	};
+
 	class NativeScript {
 		friend class Scene;
 		friend class NativeScriptView;
+	public:
+		virtual ~NativeScript() = default;
+		// Only used by scenes in ScriptSchedulingMode::Parallel
+		virtual ScriptAccess access() const {return {};}
 	protected:
 		virtual void onCreate(EntityId entityId) {};
 		virtual void onUpdate(EntityId entityId) {};
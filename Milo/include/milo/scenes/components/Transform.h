@@ -9,6 +9,7 @@ namespace milo {
 	class Transform {
 		friend class Scene;
 		friend class Entity;
+		friend class SceneSnapshot;
 	private:
 		EntityId m_EntityId{};
 		Vector3 m_Translation{0.0f, 0.0f, 0.0f};
@@ -15,6 +15,8 @@ namespace milo {
 		TimePoint startTime;
 		TimePoint endTime;
 		size_t threadId;
+		// GPU results are written as a separate process so they show up as their own track
+		bool gpu{false};
 	};
 
 	class Profiler {
@@ -40,8 +42,14 @@ namespace milo {
 		void writeProfile(Session* session, const ProfileResult& result);
 	private:
 		static Profiler* s_Profiler;
+		static AtomicBool s_Enabled;
 	public:
 		static Profiler& get();
+		static bool enabled();
+		// When disabled, timers are not written to the session files. Useful when measuring the profiled code itself
+		static void setEnabled(bool enabled);
+		// Records a result measured elsewhere (e.g. GPU timestamps converted to the CPU clock)
+		static void submit(const ProfileResult& result, const String& session = DEFAULT_PROFILER_SESSION_NAME);
 	private:
 		static void init();
 		static void shutdown();
@@ -1,13 +1,30 @@
 #version 450 core
 
+// Loaded as pbr.frag#BINDLESS_MATERIALS when the device supports descriptor indexing: set 2 is then the bindless set of
+// every material instead of the set of one material. A macro and not a keyword, since the two declare different sets
+#ifdef BINDLESS_MATERIALS
+#extension GL_EXT_nonuniform_qualifier : require
+#endif
+
 #define PI 3.1415926536
 
+// Feature keywords (see VulkanShaderVariants). The code of a disabled feature is removed from the variant,
+// while enabled features still check their uniforms, so the default variant behaves as before
+layout(constant_id = 0) const bool DIR_LIGHT = true;
+layout(constant_id = 1) const bool SKYBOX = true;
+layout(constant_id = 2) const bool SHADOWS = true;
+layout(constant_id = 3) const bool SOFT_SHADOWS = true;
+layout(constant_id = 4) const bool CASCADE_FADING = true;
+layout(constant_id = 5) const bool NORMAL_MAP = true;
+layout(constant_id = 6) const bool COMBINED_METALLIC_ROUGHNESS = true;
+
 const ivec2 TILE_SIZE = ivec2(16, 16);
 const uint MAX_POINT_LIGHTS = 256;
 
 layout(std140, set = 0, binding = 0) uniform CameraData {
-    mat4 viewProjectionMatrix;
+    mat4 projectionMatrix;
     mat4 viewMatrix;
+    mat4 viewProjectionMatrix;
     vec4 position;
 } u_Camera;
 
@@ -69,7 +86,7 @@ layout(set = 1, binding = 1) uniform sampler2DArray u_ShadowMap;
 
 // ========================================================
 
-layout(std140, set = 2, binding = 0) uniform Material {
+struct MaterialData {
 
     vec4 albedo;
     vec4 emissiveColor;
@@ -83,8 +100,53 @@ layout(std140, set = 2, binding = 0) uniform Material {
 
     bool useNormalMap;
     bool useCombinedMetallicRoughnessMap;
+};
+
+// Index of each map in BindlessMaterial::textures and of the arguments of sampleMaterialMap
+const uint ALBEDO_MAP = 0;
+const uint EMISSIVE_MAP = 1;
+const uint NORMAL_MAP_TEXTURE = 2;
+const uint METALLIC_MAP = 3;
+const uint ROUGHNESS_MAP = 4;
+const uint METALLIC_ROUGHNESS_MAP = 5;
+const uint OCCLUSION_MAP = 6;
+
+#ifdef BINDLESS_MATERIALS
 
-} u_Material;
+// Every material is stored in the same buffer and its textures are indices into u_Textures.
+// Must match VulkanMaterialResourcePool::BindlessMaterial
+
+struct BindlessMaterial {
+    MaterialData data;
+    uint textures[7];
+    uint _padding;
+};
+
+layout(std430, set = 2, binding = 0) readonly buffer BindlessMaterials {
+    BindlessMaterial u_BindlessMaterials[];
+};
+
+// Partially bound, with as many textures as the layout of the resource pool declares.
+// The material index is the same for the whole draw, so no nonuniformEXT is needed
+layout(set = 2, binding = 1) uniform sampler2D u_Textures[];
+
+layout(push_constant) uniform MaterialPushConstants {
+    layout(offset = 64) uint u_MaterialIndex;
+};
+
+MaterialData fetchMaterial() {
+    return u_BindlessMaterials[u_MaterialIndex].data;
+}
+
+vec4 sampleMaterialMap(uint map, vec2 uv) {
+    return texture(u_Textures[u_BindlessMaterials[u_MaterialIndex].textures[map]], uv);
+}
+
+#else
+
+layout(std140, set = 2, binding = 0) uniform Material {
+    MaterialData u_MaterialUniform;
+};
 
 layout(set = 2, binding = 1) uniform sampler2D u_AlbedoMap;
 layout(set = 2, binding = 2) uniform sampler2D u_EmissiveMap;
@@ -94,6 +156,26 @@ layout(set = 2, binding = 5) uniform sampler2D u_RoughnessMap;
 layout(set = 2, binding = 6) uniform sampler2D u_MetallicRoughnessMap;
 layout(set = 2, binding = 7) uniform sampler2D u_OcclusionMap;
 
+MaterialData fetchMaterial() {
+    return u_MaterialUniform;
+}
+
+vec4 sampleMaterialMap(uint map, vec2 uv) {
+    switch(map) {
+        case ALBEDO_MAP: return texture(u_AlbedoMap, uv);
+        case EMISSIVE_MAP: return texture(u_EmissiveMap, uv);
+        case NORMAL_MAP_TEXTURE: return texture(u_NormalMap, uv);
+        case METALLIC_MAP: return texture(u_MetallicMap, uv);
+        case ROUGHNESS_MAP: return texture(u_RoughnessMap, uv);
+        case METALLIC_ROUGHNESS_MAP: return texture(u_MetallicRoughnessMap, uv);
+        default: return texture(u_OcclusionMap, uv);
+    }
+}
+
+#endif
+
+MaterialData g_Material;
+
 // ============================
 
 struct PBRInfo {
@@ -251,7 +333,7 @@ vec3 calculateLighting(vec3 lightColor, vec3 L, vec3 H, float attenuation) {
 
 vec3 computeDirLights() {
 
-    if(!u_DirLightPresent) return vec3(0.0);
+    if(!DIR_LIGHT || !u_DirLightPresent) return vec3(0.0);
 
     vec3 L = normalize(u_DirLight.direction.xyz);
     vec3 H = normalize(g_PBR.viewDir + L);
@@ -505,7 +587,7 @@ float computeCascadeShadows() {
     ShadowFade = clamp(1.0 - ShadowFade, 0.0, 1.0);
     float shadowAmount = 1.0;
 
-    bool fadeCascades = u_CascadeFading;
+    bool fadeCascades = CASCADE_FADING && u_CascadeFading;
     if (fadeCascades) {
         float cascadeTransitionFade = u_CascadeTransitionFade;
 
@@ -515,36 +597,36 @@ float computeCascadeShadows() {
         if (c0 > 0.0 && c0 < 1.0) {
             // Sample 0 & 1
             vec3 shadowMapCoords = (fragment.shadowMapCoords[0].xyz / fragment.shadowMapCoords[0].w);
-            float shadowAmount0 = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 0, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 0, shadowMapCoords);
+            float shadowAmount0 = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 0, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 0, shadowMapCoords);
             shadowMapCoords = (fragment.shadowMapCoords[1].xyz / fragment.shadowMapCoords[1].w);
-            float shadowAmount1 = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 1, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 1, shadowMapCoords);
+            float shadowAmount1 = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 1, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 1, shadowMapCoords);
 
             shadowAmount = mix(shadowAmount0, shadowAmount1, c0);
 
         } else if (c1 > 0.0 && c1 < 1.0) {
             // Sample 1 & 2
             vec3 shadowMapCoords = (fragment.shadowMapCoords[1].xyz / fragment.shadowMapCoords[1].w);
-            float shadowAmount1 = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 1, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 1, shadowMapCoords);
+            float shadowAmount1 = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 1, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 1, shadowMapCoords);
             shadowMapCoords = (fragment.shadowMapCoords[2].xyz / fragment.shadowMapCoords[2].w);
-            float shadowAmount2 = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 2, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 2, shadowMapCoords);
+            float shadowAmount2 = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 2, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 2, shadowMapCoords);
 
             shadowAmount = mix(shadowAmount1, shadowAmount2, c1);
 
         }  else if (c2 > 0.0 && c2 < 1.0) {
             // Sample 2 & 3
             vec3 shadowMapCoords = (fragment.shadowMapCoords[2].xyz / fragment.shadowMapCoords[2].w);
-            float shadowAmount2 = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 2, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 2, shadowMapCoords);
+            float shadowAmount2 = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 2, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 2, shadowMapCoords);
             shadowMapCoords = (fragment.shadowMapCoords[3].xyz / fragment.shadowMapCoords[3].w);
-            float shadowAmount3 = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 3, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 3, shadowMapCoords);
+            float shadowAmount3 = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, 3, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, 3, shadowMapCoords);
 
             shadowAmount = mix(shadowAmount2, shadowAmount3, c2);
         }  else {
             vec3 shadowMapCoords = (fragment.shadowMapCoords[cascadeIndex].xyz / fragment.shadowMapCoords[cascadeIndex].w);
-            shadowAmount = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords);
+            shadowAmount = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords);
         }
     }  else {
         vec3 shadowMapCoords = (fragment.shadowMapCoords[cascadeIndex].xyz / fragment.shadowMapCoords[cascadeIndex].w);
-        shadowAmount = u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords);
+        shadowAmount = SOFT_SHADOWS && u_SoftShadows ? PCSS_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords, u_LightSize) : HardShadows_DirectionalLight(u_ShadowMap, cascadeIndex, shadowMapCoords);
     }
 
     return shadowAmount;
@@ -554,7 +636,7 @@ vec3 reflectanceEquation() {
     vec3 dirLighting = computeDirLights();
     vec3 pointLighting = computePointLights();
 
-    if(u_ShadowsEnabled) {
+    if(DIR_LIGHT && SHADOWS && u_ShadowsEnabled) {
         dirLighting *= computeCascadeShadows();
     }
 
@@ -574,7 +656,7 @@ vec3 getSpecularIBL(vec3 F, float angle) {
 
 vec3 getNormal(vec2 uv, vec3 position, vec3 normal) {
 
-    vec3 tangentNormal = texture(u_NormalMap, uv).xyz * 2.0 - 1.0;
+    vec3 tangentNormal = sampleMaterialMap(NORMAL_MAP_TEXTURE, uv).xyz * 2.0 - 1.0;
 
     vec3 Q1 = dFdx(position);
     vec3 Q2 = dFdy(position);
@@ -590,29 +672,29 @@ vec3 getNormal(vec2 uv, vec3 position, vec3 normal) {
 }
 
 vec4 getAlbedo(vec2 uv) {
-    return u_Material.albedo * texture(u_AlbedoMap, uv);
+    return g_Material.albedo * sampleMaterialMap(ALBEDO_MAP, uv);
 }
 
 float getMetallic(vec2 uv) {
-    if(u_Material.useCombinedMetallicRoughnessMap) {
-        return texture(u_MetallicRoughnessMap, uv).b * u_Material.metallic;
+    if(COMBINED_METALLIC_ROUGHNESS && g_Material.useCombinedMetallicRoughnessMap) {
+        return sampleMaterialMap(METALLIC_ROUGHNESS_MAP, uv).b * g_Material.metallic;
     }
-    return texture(u_MetallicMap, uv).r * u_Material.metallic;
+    return sampleMaterialMap(METALLIC_MAP, uv).r * g_Material.metallic;
 }
 
 float getRoughness(vec2 uv) {
-    if(u_Material.useCombinedMetallicRoughnessMap) {
-        return texture(u_MetallicRoughnessMap, uv).g * u_Material.roughness;
+    if(COMBINED_METALLIC_ROUGHNESS && g_Material.useCombinedMetallicRoughnessMap) {
+        return sampleMaterialMap(METALLIC_ROUGHNESS_MAP, uv).g * g_Material.roughness;
     }
-    return texture(u_RoughnessMap, uv).r * u_Material.roughness;
+    return sampleMaterialMap(ROUGHNESS_MAP, uv).r * g_Material.roughness;
 }
 
 float getOcclusion(vec2 uv) {
-    return texture(u_OcclusionMap, uv).r * u_Material.occlusion;
+    return sampleMaterialMap(OCCLUSION_MAP, uv).r * g_Material.occlusion;
 }
 
 vec3 getF0(vec3 albedo, float metallic) {
-    return mix(vec3(u_Material.fresnel0), albedo, metallic);
+    return mix(vec3(g_Material.fresnel0), albedo, metallic);
 }
 
 vec4 computeLighting() {
@@ -623,7 +705,7 @@ vec4 computeLighting() {
     g_PBR.metallic = getMetallic(texCoords);
     g_PBR.roughness = max(getRoughness(texCoords), 0.05);
     g_PBR.occlusion = getOcclusion(texCoords);
-    g_PBR.normal = u_Material.useNormalMap ? getNormal(texCoords, fragment.position, fragment.normal) : fragment.normal;
+    g_PBR.normal = NORMAL_MAP && g_Material.useNormalMap ? getNormal(texCoords, fragment.position, fragment.normal) : fragment.normal;
     g_PBR.F0 = getF0(g_PBR.albedo, g_PBR.metallic);
 
     g_PBR.viewDir = normalize(u_Camera.position.xyz - fragment.position);
@@ -640,7 +722,7 @@ vec4 computeLighting() {
 
     vec3 ambient = vec3(0);
 
-    if(u_SkyboxPresent) {
+    if(SKYBOX && u_SkyboxPresent) {
         // If skybox is present, then apply Image Based Lighting (IBL)
         ambient = (kD * getDiffuseIBL() + getSpecularIBL(F, angle)) * g_PBR.occlusion;
     } else {
@@ -675,8 +757,10 @@ vec3 ACESTonemap(vec3 color) {
 
 void main() {
 
+    g_Material = fetchMaterial();
+
     vec4 color = computeLighting();
-    vec4 emissive = u_Material.emissiveColor * texture(u_EmissiveMap, fragment.texCoords);
+    vec4 emissive = g_Material.emissiveColor * sampleMaterialMap(EMISSIVE_MAP, fragment.texCoords);
     out_FragColor = color + emissive;
 
     // HDR tonemapping
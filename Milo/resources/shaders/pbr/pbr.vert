@@ -1,8 +1,9 @@
 #version 450 core
 
 layout(std140, set = 0, binding = 0) uniform CameraData {
-	mat4 viewProjectionMatrix;
+	mat4 projectionMatrix;
 	mat4 viewMatrix;
+	mat4 viewProjectionMatrix;
 	vec4 position;
 } u_Camera;
 
@@ -1,15 +1,24 @@
 #version 450 core
 
+// Writes the entity ID map used for editor picking and selection outlines
+layout(constant_id = 0) const bool ENTITY_IDS = false;
+
 layout(std140, binding = 0) uniform Camera {
     mat4 u_ProjMatrix;
     mat4 u_ViewMatrix;
     mat4 u_ProjViewMatrix;
+    vec4 u_CameraPosition;
+};
+
+layout(push_constant) uniform PushConstants {
+    layout(offset = 64) uint u_EntityId;
 };
 
 layout(location = 0) in float in_LinearDepth;
 
 layout(location = 0) out vec4 out_FragColor;
 layout(location = 1) out vec4 out_DebugFragColor;
+layout(location = 2) out uint out_EntityId;
 
 float zNear = u_ProjMatrix[3][2];
 float zFar = u_ProjMatrix[2][2];
@@ -21,4 +30,5 @@ float linearizeDepth(float depth) {
 void main() {
     out_FragColor = vec4(vec3(gl_FragCoord.z), 1.0);
     out_DebugFragColor = vec4(vec3(linearizeDepth(gl_FragCoord.z) / zFar), 1.0);
+    if(ENTITY_IDS) out_EntityId = u_EntityId;
 }
\ No newline at end of file
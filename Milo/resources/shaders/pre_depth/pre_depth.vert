@@ -8,6 +8,7 @@ layout(std140, binding = 0) uniform Camera {
     mat4 u_ProjMatrix;
     mat4 u_ViewMatrix;
     mat4 u_ProjViewMatrix;
+    vec4 u_CameraPosition;
 };
 
 layout(push_constant) uniform PushConstants {
@@ -0,0 +1,34 @@
+#version 450 core
+
+layout(set = 0, binding = 0) uniform usampler2D u_EntityIdMap;
+
+layout(push_constant) uniform PushConstants {
+    vec4 u_Color;
+    uint u_EntityId;
+    int u_Thickness;
+};
+
+layout(location = 0) in vec2 frag_TexCoords;
+
+layout(location = 0) out vec4 out_FragColor;
+
+void main() {
+
+    ivec2 size = textureSize(u_EntityIdMap, 0);
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+
+    // Only the pixels around the selected entity are outlined, not the entity itself
+    if(texelFetch(u_EntityIdMap, texel, 0).r == u_EntityId) discard;
+
+    for(int y = -u_Thickness;y <= u_Thickness;++y) {
+        for(int x = -u_Thickness;x <= u_Thickness;++x) {
+            ivec2 neighbor = clamp(texel + ivec2(x, y), ivec2(0), size - 1);
+            if(texelFetch(u_EntityIdMap, neighbor, 0).r == u_EntityId) {
+                out_FragColor = u_Color;
+                return;
+            }
+        }
+    }
+
+    discard;
+}
\ No newline at end of file
@@ -3,11 +3,19 @@
 
 using namespace milo;
 
-int main() {
+int main(int argc, char** argv) {
 
 	AppConfiguration config;
 	config.applicationName = "My Application";
 
+	// Usage: milo --headless [frames] [png|exr|none]. Renders offscreen and writes the frames to ./frames
+	if(argc > 1 && strcmp(argv[1], "--headless") == 0) {
+		config.headless.enabled = true;
+		config.headless.frames = argc > 2 ? (uint32_t)strtoul(argv[2], nullptr, 10) : 300;
+		if(argc > 3 && strcmp(argv[3], "exr") == 0) config.headless.imageFormat = HeadlessImageFormat::EXR;
+		else if(argc > 3 && strcmp(argv[3], "none") == 0) config.headless.imageFormat = HeadlessImageFormat::None;
+	}
+
 	MyApplication app(config);
 
 	MiloExitResult exitResult = MiloEngine::launch(app);
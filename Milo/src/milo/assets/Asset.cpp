@@ -0,0 +1,9 @@
+#include "milo/assets/Asset.h"
+#include "milo/assets/AssetManager.h"
+
+namespace milo {
+
+	Icon Asset::icon() const {
+		return Assets::textures().getIcon(m_Name);
+	}
+}
\ No newline at end of file
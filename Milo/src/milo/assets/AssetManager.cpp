@@ -9,6 +9,10 @@ namespace milo {
 	ShaderManager* AssetManager::s_ShaderManager = nullptr;
 	SkyboxManager* AssetManager::s_SkyboxManager = nullptr;
 
+	bool AssetManager::initialized() {
+		return s_TextureManager != nullptr;
+	}
+
 	MeshManager& AssetManager::meshes() {
 		return *s_MeshManager;
 	}
@@ -34,6 +38,8 @@ namespace milo {
 	}
 
 	void AssetManager::init() {
+		MILO_MEMORY_TAG(MemoryTag::Assets);
+
 		s_TextureManager = new TextureManager();
 		s_MaterialManager = new MaterialManager();
 		s_MeshManager = new MeshManager();
@@ -41,6 +47,9 @@ namespace milo {
 		s_ShaderManager = new ShaderManager();
 		s_SkyboxManager = new SkyboxManager();
 
+		// Every shader is compiled (or read from the shader cache) at once, before any pipeline asks for them one by one
+		s_ShaderManager->compileAll(ShaderManager::findShaders(Files::resource("shaders")));
+
 		s_TextureManager->init();
 		s_MaterialManager->init();
 		s_MeshManager->init();
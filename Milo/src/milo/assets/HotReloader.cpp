@@ -0,0 +1,262 @@
+#include "milo/assets/HotReloader.h"
+#include "milo/assets/images/Image.h"
+#include "milo/core/Application.h"
+#include "milo/io/FileWatcher.h"
+#include "milo/graphics/Graphics.h"
+#include "milo/graphics/rendering/FramePipeline.h"
+#include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/graphics/vulkan/rendering/VulkanGraphicsPipeline.h"
+#include "milo/graphics/vulkan/rendering/VulkanComputePipeline.h"
+
+namespace milo {
+
+	// Updates a replaced texture is kept alive. update() runs at most once per simulated frame, and pipelined frames are
+	// rendered up to MAX_QUEUED_FRAMES + 1 frames later, so this outlasts the frames queued and in flight
+	static const uint32_t RETIRED_TEXTURE_UPDATES = MAX_FRAMES_IN_FLIGHT + FramePipeline::MAX_QUEUED_FRAMES + 2;
+
+	Thread HotReloader::s_Thread;
+	bool HotReloader::s_Running{false};
+	Queue<HotReloader::Job*> HotReloader::s_PendingJobs;
+	ArrayList<HotReloader::Job*> HotReloader::s_FinishedJobs;
+	Mutex HotReloader::s_Mutex;
+	std::condition_variable HotReloader::s_JobAdded;
+	ArrayList<std::pair<Ref<Texture2D>, uint32_t>> HotReloader::s_RetiredTextures;
+
+	bool HotReloader::enabled() {
+		return s_Running;
+	}
+
+	void HotReloader::init() {
+
+		if(!Application::get().configuration().hotReload) return;
+
+		if(!FileWatcher::supported()) {
+			Log::info("Hot reload is disabled: file watching is not supported on this platform");
+			return;
+		}
+
+		s_Running = true;
+		s_Thread = Thread(&HotReloader::run);
+
+		FileWatcher::watch(Files::resource(""));
+	}
+
+	void HotReloader::shutdown() {
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_Running = false;
+		}
+		s_JobAdded.notify_all();
+		if(s_Thread.joinable()) s_Thread.join();
+
+		while(!s_PendingJobs.empty()) {
+			DELETE_PTR(s_PendingJobs.front());
+			s_PendingJobs.pop();
+		}
+		for(Job* job : s_FinishedJobs) {
+			DELETE_PTR(job->shader);
+			DELETE_PTR(job->image);
+			DELETE_PTR(job);
+		}
+		s_FinishedJobs.clear();
+		s_RetiredTextures.clear();
+	}
+
+	void HotReloader::update() {
+
+		if(!s_Running) return;
+
+		for(const String& path : FileWatcher::poll()) {
+			enqueue(path);
+		}
+
+		ArrayList<Job*> finishedJobs;
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			finishedJobs.swap(s_FinishedJobs);
+		}
+
+		// Reloads create graphics resources and modify the materials that the frames being rendered use
+		if(!finishedJobs.empty()) FramePipeline::flush();
+
+		for(Job* job : finishedJobs) {
+			apply(*job);
+			DELETE_PTR(job);
+		}
+
+		releaseRetiredTextures();
+	}
+
+	void HotReloader::enqueue(const String& path) {
+
+		ArrayList<Job*> jobs;
+
+		// The dependencies are resolved here, on the thread that owns the assets. Every shader compiled from the
+		// file is reloaded, one for each set of macros it was loaded with
+		for(const String& shaderName : Assets::shaders().namesOf(path)) {
+			Job* job = new Job();
+			job->path = path;
+			job->type = Job::Type::Shader;
+			job->shaderFilename = shaderName;
+			jobs.push_back(job);
+		}
+
+		if(jobs.empty()) {
+			Job* job = new Job();
+			job->path = path;
+			if(Files::extension(path) == ".mat") {
+				job->type = Job::Type::Material;
+			} else if(auto info = Assets::textures().m_FileInfos.find(path); info != Assets::textures().m_FileInfos.end()) {
+				job->type = Job::Type::Texture;
+				job->textureInfo = info->second;
+			} else {
+				DELETE_PTR(job);
+				return;
+			}
+			jobs.push_back(job);
+		}
+
+		Log::debug("{} changed, reloading...", path);
+
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			for(Job* job : jobs) s_PendingJobs.push(job);
+		}
+		s_JobAdded.notify_one();
+	}
+
+	void HotReloader::run() {
+		while(true) {
+
+			Job* job;
+			{
+				std::unique_lock<Mutex> lock(s_Mutex);
+				s_JobAdded.wait(lock, [] {return !s_Running || !s_PendingJobs.empty();});
+				if(!s_Running) return;
+				job = s_PendingJobs.front();
+				s_PendingJobs.pop();
+			}
+
+			execute(*job);
+
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_FinishedJobs.push_back(job);
+		}
+	}
+
+	void HotReloader::execute(Job& job) {
+		try {
+			switch(job.type) {
+				case Job::Type::Shader:
+					job.shader = Assets::shaders().compile(job.shaderFilename);
+					job.succeeded = true;
+					break;
+				case Job::Type::Material:
+					job.succeeded = MaterialManager::parse(job.path, job.material);
+					break;
+				case Job::Type::Texture:
+					job.image = Image::loadImage(job.path, job.textureInfo.format, job.textureInfo.flipY);
+					job.succeeded = job.image != nullptr;
+					break;
+			}
+		} catch(const Exception& e) {
+			job.error = e.what();
+		} catch(ANY_EXCEPTION) {
+			job.error = "unknown error";
+		}
+	}
+
+	void HotReloader::apply(Job& job) {
+
+		if(!job.succeeded) {
+			Log::error("Failed to reload {}, keeping the previous version: {}", job.path, job.error);
+			return;
+		}
+
+		try {
+			switch(job.type) {
+				case Job::Type::Shader: applyShader(job); break;
+				case Job::Type::Material: applyMaterial(job); break;
+				case Job::Type::Texture: applyTexture(job); break;
+			}
+			Log::info("{} reloaded", job.path);
+		} catch(const Exception& e) {
+			Log::error("Failed to reload {}, keeping the previous version: {}", job.path, e.what());
+		}
+
+		DELETE_PTR(job.shader);
+		DELETE_PTR(job.image);
+	}
+
+	void HotReloader::applyShader(Job& job) {
+
+		Assets::shaders().replace(job.shaderFilename, job.shader);
+		job.shader = nullptr;
+
+		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
+			// Pipelines are swapped while no command buffer that binds them is pending
+			VulkanContext::get()->device()->awaitTermination();
+			VulkanGraphicsPipeline::rebuildPipelinesUsing(job.shaderFilename);
+			VulkanComputePipeline::rebuildPipelinesUsing(job.shaderFilename);
+		}
+	}
+
+	void HotReloader::applyMaterial(Job& job) {
+
+		MaterialManager& materials = Assets::materials();
+
+		std::lock_guard<Mutex> lock(materials.m_Mutex);
+
+		for(auto& [name, material] : materials.m_Materials) {
+			if(Files::toAbsolutePath(material->filename()) == job.path) {
+				materials.reload(material, job.material);
+			}
+		}
+	}
+
+	static bool retarget(Ref<Texture2D>& map, const Ref<Texture2D>& oldTexture, const Ref<Texture2D>& newTexture) {
+		if(map != oldTexture) return false;
+		map = newTexture;
+		return true;
+	}
+
+	void HotReloader::applyTexture(Job& job) {
+
+		TextureManager& textures = Assets::textures();
+
+		auto cached = textures.m_Cache.find(job.path);
+		if(cached == textures.m_Cache.end()) return;
+
+		Ref<Texture2D> oldTexture = cached->second;
+		Ref<Texture2D> newTexture = textures.createTexture(job.path, job.image, job.textureInfo.mipLevels);
+		job.image = nullptr;
+
+		MaterialManager& materials = Assets::materials();
+
+		std::lock_guard<Mutex> lock(materials.m_Mutex);
+
+		for(auto& [name, material] : materials.m_Materials) {
+			bool changed = false;
+			changed |= retarget(material->m_AlbedoMap, oldTexture, newTexture);
+			changed |= retarget(material->m_MetallicMap, oldTexture, newTexture);
+			changed |= retarget(material->m_RoughnessMap, oldTexture, newTexture);
+			changed |= retarget(material->m_MetallicRoughnessMap, oldTexture, newTexture);
+			changed |= retarget(material->m_OcclusionMap, oldTexture, newTexture);
+			changed |= retarget(material->m_EmissiveMap, oldTexture, newTexture);
+			changed |= retarget(material->m_NormalMap, oldTexture, newTexture);
+			if(changed) material->m_Dirty = true;
+		}
+
+		s_RetiredTextures.emplace_back(oldTexture, RETIRED_TEXTURE_UPDATES);
+	}
+
+	void HotReloader::releaseRetiredTextures() {
+		for(auto it = s_RetiredTextures.begin();it != s_RetiredTextures.end();) {
+			if(--it->second == 0) {
+				it = s_RetiredTextures.erase(it);
+			} else {
+				++it;
+			}
+		}
+	}
+}
\ No newline at end of file
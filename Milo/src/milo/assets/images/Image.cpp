@@ -64,25 +64,32 @@ namespace milo {
 
 	Image* Image::loadImage(const String &path, PixelFormat format, bool flipY) {
 
+		const auto fileContents = Files::readAllBytes(path);
+
+		if(fileContents.empty()) {
+			throw MILO_RUNTIME_EXCEPTION(String("Could not read fileContents ").append(path));
+		}
+
+		return decode(fileContents.data(), fileContents.size(), format, flipY);
+	}
+
+	Image* Image::decode(const byte_t* data, size_t size, PixelFormat format, bool flipY) {
+
 		int32_t width;
 		int32_t height;
 		int32_t channels;
 		int32_t desiredChannels = format == PixelFormat::Undefined ? STBI_default : PixelFormats::channels(format);
 		void* pixels;
 
-		const auto fileContents = Files::readAllBytes(path);
-		const auto* rawData = reinterpret_cast<const stbi_uc*>(fileContents.data());
+		const auto* rawData = reinterpret_cast<const stbi_uc*>(data);
 
-		if(rawData == nullptr) {
-			throw MILO_RUNTIME_EXCEPTION(String("Could not read fileContents ").append(path));
-		}
-
-		stbi_set_flip_vertically_on_load(flipY);
+		// Per thread, since images are decoded in parallel
+		stbi_set_flip_vertically_on_load_thread(flipY);
 
 		if(format != PixelFormat::Undefined && PixelFormats::floatingPoint(format))
-			pixels = stbi_loadf_from_memory(rawData, (int32_t)fileContents.size(), &width, &height, &channels, desiredChannels);
+			pixels = stbi_loadf_from_memory(rawData, (int32_t)size, &width, &height, &channels, desiredChannels);
 		else
-			pixels = stbi_load_from_memory(rawData, (int32_t)fileContents.size(), &width, &height, &channels, desiredChannels);
+			pixels = stbi_load_from_memory(rawData, (int32_t)size, &width, &height, &channels, desiredChannels);
 
 		if(pixels == nullptr)
 			throw MILO_RUNTIME_EXCEPTION(String("Failed to create image from file: ").append(stbi_failure_reason()));
@@ -91,4 +98,91 @@ namespace milo {
 
 		return new Image(width, height, format, pixels, stbi_image_free);
 	}
+
+	void Image::writePNG(const String& path, uint32_t width, uint32_t height, const uint8_t* rgbaPixels) {
+		if(!stbi_write_png(path.c_str(), (int32_t)width, (int32_t)height, 4, rgbaPixels, (int32_t)width * 4)) {
+			throw MILO_RUNTIME_EXCEPTION("Failed to write image " + path);
+		}
+	}
+
+	template<typename T>
+	static void writeEXRValue(OutputStream& output, const T& value) {
+		output.write((const char*)&value, sizeof(T));
+	}
+
+	static void writeEXRAttribute(OutputStream& output, const char* name, const char* type, uint32_t size) {
+		output.write(name, (std::streamsize)strlen(name) + 1);
+		output.write(type, (std::streamsize)strlen(type) + 1);
+		writeEXRValue(output, size);
+	}
+
+	void Image::writeEXR(const String& path, uint32_t width, uint32_t height, const float* rgbaPixels) {
+
+		// Channels are stored in alphabetical order
+		static const char* const channelNames[] = {"A", "B", "G", "R"};
+		static const uint32_t channelOffsets[] = {3, 2, 1, 0};
+		const int32_t FLOAT_PIXEL_TYPE = 2;
+
+		OutputStream output(path, std::ios::binary | std::ios::trunc);
+		if(!output) throw MILO_RUNTIME_EXCEPTION("Failed to write image " + path);
+
+		writeEXRValue(output, (uint32_t)20000630); // Magic number
+		writeEXRValue(output, (uint32_t)2); // Version 2, single part scanline file
+
+		writeEXRAttribute(output, "channels", "chlist", 4 * (2 + 16) + 1);
+		for(const char* channel : channelNames) {
+			output.write(channel, 2);
+			writeEXRValue(output, FLOAT_PIXEL_TYPE);
+			writeEXRValue(output, (uint32_t)0); // pLinear and reserved
+			writeEXRValue(output, (int32_t)1); // x sampling
+			writeEXRValue(output, (int32_t)1); // y sampling
+		}
+		output.put('\0');
+
+		writeEXRAttribute(output, "compression", "compression", 1);
+		output.put('\0'); // NO_COMPRESSION
+
+		const int32_t window[4] = {0, 0, (int32_t)width - 1, (int32_t)height - 1};
+		writeEXRAttribute(output, "dataWindow", "box2i", sizeof(window));
+		writeEXRValue(output, window);
+		writeEXRAttribute(output, "displayWindow", "box2i", sizeof(window));
+		writeEXRValue(output, window);
+
+		writeEXRAttribute(output, "lineOrder", "lineOrder", 1);
+		output.put('\0'); // INCREASING_Y
+
+		writeEXRAttribute(output, "pixelAspectRatio", "float", 4);
+		writeEXRValue(output, 1.0f);
+
+		const float screenWindowCenter[2] = {0, 0};
+		writeEXRAttribute(output, "screenWindowCenter", "v2f", sizeof(screenWindowCenter));
+		writeEXRValue(output, screenWindowCenter);
+
+		writeEXRAttribute(output, "screenWindowWidth", "float", 4);
+		writeEXRValue(output, 1.0f);
+
+		output.put('\0'); // End of header
+
+		// Uncompressed files store one scanline per chunk: its y, its size and then every channel of the row
+		const uint32_t lineSize = width * 4 * sizeof(float);
+		const uint64_t firstLineOffset = (uint64_t)output.tellp() + height * sizeof(uint64_t);
+		for(uint32_t y = 0;y < height;++y) {
+			writeEXRValue(output, firstLineOffset + y * (uint64_t)(2 * sizeof(int32_t) + lineSize));
+		}
+
+		ArrayList<float> line(width);
+		for(uint32_t y = 0;y < height;++y) {
+			writeEXRValue(output, (int32_t)y);
+			writeEXRValue(output, lineSize);
+			const float* row = rgbaPixels + (size_t)y * width * 4;
+			for(uint32_t channelOffset : channelOffsets) {
+				for(uint32_t x = 0;x < width;++x) {
+					line[x] = row[x * 4 + channelOffset];
+				}
+				output.write((const char*)line.data(), (std::streamsize)(width * sizeof(float)));
+			}
+		}
+
+		if(!output) throw MILO_RUNTIME_EXCEPTION("Failed to write image " + path);
+	}
 }
\ No newline at end of file
@@ -4,6 +4,8 @@
 namespace milo {
 
 	Material::Material(String name, String filename) : Asset(name, filename) {
+		// Headless tools create materials without loading any texture
+		if(!Assets::initialized()) return;
 		m_AlbedoMap = Assets::textures().whiteTexture();
 		m_EmissiveMap = Assets::textures().blackTexture();
 		m_NormalMap = Assets::textures().whiteTexture();
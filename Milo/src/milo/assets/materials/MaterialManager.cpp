@@ -4,6 +4,7 @@
 #define JSON_USE_IMPLICIT_CONVERSIONS 0
 #include <json.hpp>
 #include "milo/assets/AssetManager.h"
+#include "milo/graphics/rendering/FramePipeline.h"
 
 #define DEFAULT_MATERIAL_NAME "M_DefaultMaterial"
 
@@ -32,6 +33,12 @@ namespace milo {
 	}
 
 	Material* MaterialManager::create(const String& name, const String& filename) {
+
+		// Creating the material resources must not overlap the frames being rendered
+		FramePipeline::flush();
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
 		if(exists(name)) return find(name);
 
 		String file = filename;
@@ -42,39 +49,30 @@ namespace milo {
 
 		Material* material = new Material(name, file);
 
-		m_Materials[name] = material;
-		m_ResourcePool->allocateMaterialResources(material);
-		if(name == DEFAULT_MATERIAL_NAME) {
-			material->m_Icon = Assets::textures().getIcon("DefaultMaterialIcon");
-		} else {
-			material->m_Icon = Assets::textures().createIcon(name, Assets::meshes().getSphere(), material);
-		}
+		registerMaterial(name, material);
 
 		return material;
 	}
 
 	Material* MaterialManager::load(const String& name, const String& filename, bool replace) {
+		MILO_MEMORY_TAG(MemoryTag::Assets);
+
+		FramePipeline::flush();
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
 		Material* material = nullptr;
-		m_Mutex.lock();
-		{
-			if(exists(name)) {
-				material = find(name);
-				if(replace) {
-					load(name, filename, material);
-				}
-			} else {
-				if(load(name, filename, material)) {
-					m_Materials[name] = material;
-					m_ResourcePool->allocateMaterialResources(material);
-					if(name == DEFAULT_MATERIAL_NAME) {
-						material->m_Icon = Assets::textures().getIcon("DefaultMaterialIcon");
-					} else {
-						material->m_Icon = Assets::textures().createIcon(name, Assets::meshes().getSphere(), material);
-					}
-				}
+
+		if(exists(name)) {
+			material = find(name);
+			MaterialFile file;
+			if(replace && parse(filename, file)) {
+				reload(material, file);
 			}
+		} else if(load(name, filename, material)) {
+			registerMaterial(name, material);
 		}
-		m_Mutex.unlock();
+
 		return material;
 	}
 
@@ -87,24 +85,36 @@ namespace milo {
 	}
 
 	void MaterialManager::destroy(const String& name) {
-		if(!exists(name)) return;
-		m_Mutex.lock();
-		{
-			Material* material = m_Materials[name];
-			DELETE_PTR(material);
-			m_Materials.erase(name);
-			m_ResourcePool->freeMaterialResources(material);
-		}
-		m_Mutex.unlock();
+		FramePipeline::flush();
+		std::lock_guard<Mutex> lock(m_Mutex);
+		destroyMaterial(name);
 	}
 
 	void MaterialManager::addMaterial(const String& name, Material* material) {
-		if(exists(name)) {
-			destroy(name);
-		}
+		FramePipeline::flush();
+		std::lock_guard<Mutex> lock(m_Mutex);
+		destroyMaterial(name);
+		registerMaterial(name, material);
+	}
+
+	void MaterialManager::registerMaterial(const String& name, Material* material) {
 		m_Materials[name] = material;
 		m_ResourcePool->allocateMaterialResources(material);
-		material->m_Icon = Assets::textures().createIcon(name, Assets::meshes().getSphere(), material);
+		if(name == DEFAULT_MATERIAL_NAME) {
+			Assets::textures().addIcon(name, Assets::textures().getIcon("DefaultMaterialIcon"));
+		} else {
+			Assets::textures().registerIcon(name, Assets::meshes().getSphere(), material, "DefaultMaterialIcon");
+		}
+	}
+
+	void MaterialManager::destroyMaterial(const String& name) {
+		auto it = m_Materials.find(name);
+		if(it == m_Materials.end()) return;
+		Material* material = it->second;
+		m_ResourcePool->freeMaterialResources(material);
+		Assets::textures().removeIcon(name);
+		m_Materials.erase(it);
+		DELETE_PTR(material);
 	}
 
 	MaterialResourcePool& MaterialManager::resourcePool() const {
@@ -112,10 +122,19 @@ namespace milo {
 	}
 
 	bool MaterialManager::load(const String& name, const String& filename, Material*& material) {
-		if(!Files::exists(filename)) return false;
-		if(Files::isDirectory(filename)) return false;
+
+		MaterialFile file;
+		if(!parse(filename, file)) return false;
 
 		material = new Material(name, filename);
+		apply(material, file);
+
+		return true;
+	}
+
+	bool MaterialManager::parse(const String& filename, MaterialFile& file) {
+		if(!Files::exists(filename)) return false;
+		if(Files::isDirectory(filename)) return false;
 
 		try {
 			nlohmann::json json;
@@ -127,65 +146,109 @@ namespace milo {
 			if(json.contains("albedo")) {
 				float color[4];
 				json["albedo"].get_to(color);
-				material->m_Data.albedo = {color[0], color[1], color[2], color[3]};
+				file.data.albedo = {color[0], color[1], color[2], color[3]};
 			}
 
 			if(json.contains("metallic")) {
-				material->m_Data.metallic = json["metallic"].get<float>();
+				file.data.metallic = json["metallic"].get<float>();
 			}
 
 			if(json.contains("roughness")) {
-				material->m_Data.roughness = json["roughness"].get<float>();
+				file.data.roughness = json["roughness"].get<float>();
 			}
 
 			if(json.contains("emissive")) {
 				float color[4];
 				json["emissive"].get_to(color);
-				material->m_Data.emissiveColor = {color[0], color[1], color[2], color[3]};
+				file.data.emissiveColor = {color[0], color[1], color[2], color[3]};
 			}
 
-			material->m_AlbedoMap = loadTexture2D(&json, "albedoMap", filename);
-			material->m_NormalMap = loadTexture2D(&json, "normalMap", filename);
-			material->m_MetallicMap = loadTexture2D(&json, "metallicMap", filename);
-			material->m_RoughnessMap = loadTexture2D(&json, "roughnessMap", filename);
-			material->m_OcclusionMap = loadTexture2D(&json, "occlusionMap", filename);
-
-			material->useNormalMap(material->m_NormalMap != nullptr);
+			file.albedoMap = texturePathOf(&json, "albedoMap", filename);
+			file.normalMap = texturePathOf(&json, "normalMap", filename);
+			file.metallicMap = texturePathOf(&json, "metallicMap", filename);
+			file.roughnessMap = texturePathOf(&json, "roughnessMap", filename);
+			file.occlusionMap = texturePathOf(&json, "occlusionMap", filename);
 		} catch(...) {
-			Log::error("Failed to parse material {}", material->name());
+			Log::error("Failed to parse material {}", filename);
 			return false;
 		}
 
 		return true;
 	}
 
-	Ref<Texture2D> MaterialManager::loadTexture2D(void* pJson, const String& textureName, const String& materialFile) {
+	void MaterialManager::apply(Material* material, const MaterialFile& file) {
 
-		nlohmann::json& json = *(nlohmann::json*)pJson;
+		material->m_Data = file.data;
 
-		Ref<Texture2D> texture = Assets::textures().whiteTexture();
+		material->m_AlbedoMap = loadTexture2D(file.albedoMap);
+		material->m_NormalMap = loadTexture2D(file.normalMap);
+		material->m_MetallicMap = loadTexture2D(file.metallicMap);
+		material->m_RoughnessMap = loadTexture2D(file.roughnessMap);
+		material->m_OcclusionMap = loadTexture2D(file.occlusionMap);
 
-		if(json.contains(textureName)) {
+		material->useNormalMap(material->m_NormalMap != nullptr);
+	}
 
-			String texturePath = json[textureName].get<String>();
-			if(!Files::isAbsolute(texturePath)) {
-				texturePath = Files::append(Files::parentOf(materialFile), texturePath);
-			}
+	void MaterialManager::reload(Material* material, const MaterialFile& file) {
+		// Updated in place, since meshes and the resource pool keep pointers to the material
+		apply(material, file);
+		if(material->name() != DEFAULT_MATERIAL_NAME) {
+			Assets::textures().registerIcon(material->name(), Assets::meshes().getSphere(), material, "DefaultMaterialIcon");
+		}
+	}
 
-			texture = Assets::textures().load(texturePath, PixelFormat::RGBA8);
-			texture->generateMipmaps();
+	String MaterialManager::texturePathOf(void* pJson, const String& textureName, const String& materialFile) {
+
+		nlohmann::json& json = *(nlohmann::json*)pJson;
+
+		if(!json.contains(textureName)) return "";
+
+		String texturePath = json[textureName].get<String>();
+		if(!Files::isAbsolute(texturePath)) {
+			texturePath = Files::append(Files::parentOf(materialFile), texturePath);
 		}
 
+		return texturePath;
+	}
+
+	Ref<Texture2D> MaterialManager::loadTexture2D(const String& texturePath) {
+
+		if(texturePath.empty()) return Assets::textures().whiteTexture();
+
+		Ref<Texture2D> texture = Assets::textures().load(texturePath, PixelFormat::RGBA8);
+		texture->generateMipmaps();
+
 		return texture;
 	}
 
-	void MaterialManager::update() {
+	void MaterialManager::collectUpdates(ArrayList<MaterialSnapshot>& updates) {
+
+		updates.clear();
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
 		for(auto& [name, material] : m_Materials) {
 			if(material->dirty()) {
-				m_ResourcePool->updateMaterial(material);
 				material->m_Dirty = false;
 				material->m_Version++;
+				updates.push_back(MaterialSnapshot::of(material));
 			}
 		}
 	}
+
+	void MaterialManager::applyUpdates(const ArrayList<MaterialSnapshot>& updates) {
+
+		if(updates.empty()) return;
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
+		for(const MaterialSnapshot& snapshot : updates) {
+			m_ResourcePool->updateMaterial(snapshot);
+		}
+	}
+
+	void MaterialManager::beginFrame() {
+		std::lock_guard<Mutex> lock(m_Mutex);
+		m_ResourcePool->beginFrame();
+	}
 }
\ No newline at end of file
@@ -4,6 +4,23 @@
 
 namespace milo {
 
+	MaterialSnapshot MaterialSnapshot::of(Material* material) {
+		MaterialSnapshot snapshot;
+		snapshot.material = material;
+		snapshot.version = material->version();
+		snapshot.data = material->data();
+		snapshot.textures = {
+				material->albedoMap(),
+				material->emissiveMap(),
+				material->normalMap(),
+				material->metallicMap(),
+				material->roughnessMap(),
+				material->metallicRoughnessMap(),
+				material->occlusionMap()
+		};
+		return snapshot;
+	}
+
 	MaterialResourcePool* MaterialResourcePool::create() {
 		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
 			return new VulkanMaterialResourcePool();
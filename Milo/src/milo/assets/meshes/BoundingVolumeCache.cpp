@@ -0,0 +1,126 @@
+#include "milo/assets/meshes/BoundingVolumeCache.h"
+#include "milo/assets/meshes/Mesh.h"
+#include "milo/io/Files.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	static const uint32_t BOUNDS_CACHE_MAGIC = 0x4E42424D; // MBBN
+	// Increase when the fitting changes, so volumes are computed again
+	static const uint32_t BOUNDS_CACHE_VERSION = 1;
+	static constexpr uint32_t MAX_BOUNDS_FLOATS = 15;
+
+	const size_t BoundingVolumeCache::MIN_VERTEX_COUNT = 64 * 1024;
+
+	static uint32_t writeVolume(const BoundingVolume& volume, float* data) {
+		switch(volume.type()) {
+			case BoundingVolume::Type::Sphere: {
+				const auto& sphere = (const BoundingSphere&)volume;
+				memcpy(data, &sphere.center, sizeof(Vector3));
+				data[3] = sphere.radius;
+				return 4;
+			}
+			case BoundingVolume::Type::AABB: {
+				const auto& aabb = (const AABB&)volume;
+				memcpy(data, &aabb.center, sizeof(Vector3));
+				memcpy(data + 3, &aabb.size, sizeof(Vector3));
+				return 6;
+			}
+			case BoundingVolume::Type::OBB: {
+				const auto& obb = (const OBB&)volume;
+				memcpy(data, &obb.center, sizeof(Vector3));
+				memcpy(data + 3, &obb.size, sizeof(Vector3));
+				memcpy(data + 6, &obb.xAxis, sizeof(Vector3));
+				memcpy(data + 9, &obb.yAxis, sizeof(Vector3));
+				memcpy(data + 12, &obb.zAxis, sizeof(Vector3));
+				return 15;
+			}
+		}
+		return 0;
+	}
+
+	static BoundingVolume* readVolume(BoundingVolume::Type type, const float* data, uint32_t count) {
+		switch(type) {
+			case BoundingVolume::Type::Sphere: {
+				if(count != 4) return nullptr;
+				auto* sphere = new BoundingSphere();
+				memcpy(&sphere->center, data, sizeof(Vector3));
+				sphere->radius = data[3];
+				return sphere;
+			}
+			case BoundingVolume::Type::AABB: {
+				if(count != 6) return nullptr;
+				auto* aabb = new AABB();
+				memcpy(&aabb->center, data, sizeof(Vector3));
+				memcpy(&aabb->size, data + 3, sizeof(Vector3));
+				return aabb;
+			}
+			case BoundingVolume::Type::OBB: {
+				if(count != 15) return nullptr;
+				auto* obb = new OBB();
+				memcpy(&obb->center, data, sizeof(Vector3));
+				memcpy(&obb->size, data + 3, sizeof(Vector3));
+				memcpy(&obb->xAxis, data + 6, sizeof(Vector3));
+				memcpy(&obb->yAxis, data + 9, sizeof(Vector3));
+				memcpy(&obb->zAxis, data + 12, sizeof(Vector3));
+				return obb;
+			}
+		}
+		return nullptr;
+	}
+
+	uint64_t BoundingVolumeCache::keyOf(const Mesh* mesh, BoundingVolume::Type type) {
+		const uint64_t contentHash = mesh->contentHash() != 0 ? mesh->contentHash() : Mesh::contentHashOf(mesh->vertices(), mesh->indices());
+		return stableHashValue((uint32_t)type, contentHash);
+	}
+
+	String BoundingVolumeCache::filenameOf(uint64_t key) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bounds", (unsigned long long)key);
+		return Files::resource(str("cache/bounds/") + name);
+	}
+
+	BoundingVolume* BoundingVolumeCache::load(uint64_t key, BoundingVolume::Type type) {
+
+		const String filename = filenameOf(key);
+
+		if(!Files::exists(filename)) return nullptr;
+
+		InputStream input(filename, std::ios::binary);
+
+		uint32_t header[4]{};
+		uint64_t storedKey = 0;
+		input.read((char*)header, sizeof(header));
+		input.read((char*)&storedKey, sizeof(storedKey));
+
+		if(!input || header[0] != BOUNDS_CACHE_MAGIC || header[1] != BOUNDS_CACHE_VERSION || storedKey != key
+		   || header[2] != (uint32_t)type || header[3] > MAX_BOUNDS_FLOATS) {
+			Log::warn("Ignoring outdated bounding volume cache {}", filename);
+			return nullptr;
+		}
+
+		float data[MAX_BOUNDS_FLOATS]{};
+		input.read((char*)data, (std::streamsize)(header[3] * sizeof(float)));
+
+		BoundingVolume* volume = input ? readVolume(type, data, header[3]) : nullptr;
+		if(volume == nullptr) {
+			Log::warn("Ignoring corrupted bounding volume cache {}", filename);
+		}
+
+		return volume;
+	}
+
+	void BoundingVolumeCache::save(uint64_t key, const BoundingVolume& volume) {
+
+		Files::writeAtomically(filenameOf(key), [&](OutputStream& output) {
+
+			float data[MAX_BOUNDS_FLOATS]{};
+			const uint32_t count = writeVolume(volume, data);
+
+			const uint32_t header[4] = {BOUNDS_CACHE_MAGIC, BOUNDS_CACHE_VERSION, (uint32_t)volume.type(), count};
+			output.write((const char*)header, sizeof(header));
+			output.write((const char*)&key, sizeof(key));
+			output.write((const char*)data, (std::streamsize)(count * sizeof(float)));
+		});
+	}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "milo/graphics/Graphics.h"
 #include "milo/graphics/vulkan/buffers/VulkanMeshBuffers.h"
 #include <assimp/postprocess.h>
+#include <cstring>
 
 namespace milo {
 
@@ -46,6 +47,22 @@ namespace milo {
 		m_CanBeCulled = value;
 	}
 
+	uint64_t Mesh::contentHash() const {
+		return m_ContentHash;
+	}
+
+	bool Mesh::sameContentAs(const Mesh& other) const {
+		if(m_Vertices.size() != other.m_Vertices.size() || m_Indices.size() != other.m_Indices.size()) return false;
+		return memcmp(m_Vertices.data(), other.m_Vertices.data(), m_Vertices.size() * sizeof(Vertex)) == 0
+			&& memcmp(m_Indices.data(), other.m_Indices.data(), m_Indices.size() * sizeof(uint32_t)) == 0;
+	}
+
+	uint64_t Mesh::contentHashOf(const ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices) {
+		uint64_t hash = stableHashValue(vertices.size());
+		hash = stableHash(vertices.data(), vertices.size() * sizeof(Vertex), hash);
+		return stableHash(indices.data(), indices.size() * sizeof(uint32_t), hash);
+	}
+
 	// ====
 
 	Mesh::GraphicsBuffers* Mesh::GraphicsBuffers::create(const ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices) {
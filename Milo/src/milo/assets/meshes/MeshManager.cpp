@@ -1,9 +1,11 @@
 #include "milo/assets/meshes/MeshManager.h"
 #include "milo/assets/meshes/MeshLoader.h"
+#include "milo/assets/meshes/BoundingVolumeCache.h"
 #include "milo/io/Files.h"
 #include "milo/assets/meshes/loaders/ObjMeshLoader.h"
 #include "milo/assets/meshes/loaders/AssimpLoader.h"
 #include "milo/assets/AssetManager.h"
+#include <algorithm>
 
 #define CUBE_MESH_NAME "SM_Cube"
 #define SPHERE_MESH_NAME "SM_Sphere"
@@ -58,6 +60,7 @@ namespace milo {
 	}
 
 	Mesh* MeshManager::load(const String& name, const String& filename) {
+		MILO_MEMORY_TAG(MemoryTag::Assets);
 		Mesh* mesh = nullptr;
 		m_Mutex.lock();
 		{
@@ -70,8 +73,9 @@ namespace milo {
 					mesh->m_Name = name;
 					createGraphicsBuffers(filename, mesh);
 					createBoundingVolume(filename, mesh);
-					mesh->m_Icon = Assets::textures().createIcon(name, mesh, Assets::materials().getDefault());
+					Assets::textures().registerIcon(name, mesh, Assets::materials().getDefault(), "DefaultMeshIcon");
 					m_Meshes[name] = mesh;
+					indexContent(mesh);
 				}
 			}
 		}
@@ -87,13 +91,25 @@ namespace milo {
 		return exists(name) ? m_Meshes[name] : nullptr;
 	}
 
+	Mesh* MeshManager::findByContent(const Mesh* mesh) {
+		const uint64_t hash = mesh->m_ContentHash != 0 ? mesh->m_ContentHash : Mesh::contentHashOf(mesh->m_Vertices, mesh->m_Indices);
+		auto it = m_MeshesByContent.find(hash);
+		if(it == m_MeshesByContent.end()) return nullptr;
+		for(Mesh* candidate : it->second) {
+			if(candidate->sameContentAs(*mesh)) return candidate;
+		}
+		return nullptr;
+	}
+
 	void MeshManager::destroy(const String& name) {
 		if(!exists(name)) return;
 		m_Mutex.lock();
 		{
 			Mesh* mesh = m_Meshes[name];
+			unindexContent(mesh);
 			DELETE_PTR(mesh);
 			m_Meshes.erase(name);
+			Assets::textures().removeIcon(name);
 		}
 		m_Mutex.unlock();
 	}
@@ -104,8 +120,26 @@ namespace milo {
 		}
 		m_Meshes[name] = mesh;
 		createGraphicsBuffers(mesh->filename(), mesh);
-		createBoundingVolume(mesh->filename(), mesh);
-		mesh->m_Icon = Assets::textures().createIcon(name, mesh, Assets::materials().getDefault());
+		if(mesh->m_BoundingVolume == nullptr) {
+			createBoundingVolume(mesh->filename(), mesh);
+		}
+		Assets::textures().registerIcon(name, mesh, Assets::materials().getDefault(), "DefaultMeshIcon");
+		indexContent(mesh);
+	}
+
+	void MeshManager::indexContent(Mesh* mesh) {
+		if(mesh->m_ContentHash == 0) {
+			mesh->m_ContentHash = Mesh::contentHashOf(mesh->m_Vertices, mesh->m_Indices);
+		}
+		m_MeshesByContent[mesh->m_ContentHash].push_back(mesh);
+	}
+
+	void MeshManager::unindexContent(Mesh* mesh) {
+		auto it = m_MeshesByContent.find(mesh->m_ContentHash);
+		if(it == m_MeshesByContent.end()) return;
+		ArrayList<Mesh*>& meshes = it->second;
+		meshes.erase(std::remove(meshes.begin(), meshes.end(), mesh), meshes.end());
+		if(meshes.empty()) m_MeshesByContent.erase(it);
 	}
 
 	Ref<MeshLoader> MeshManager::getMeshLoaderOf(const String& filename) {
@@ -117,7 +151,22 @@ namespace milo {
 	}
 
 	void MeshManager::createBoundingVolume(const String& filename, Mesh* mesh) {
-		if(mesh->name() == SPHERE_MESH_NAME) {
+
+		const BoundingVolume::Type type = mesh->name() == SPHERE_MESH_NAME ? BoundingVolume::Type::Sphere : BoundingVolume::Type::OBB;
+
+		const bool cached = mesh->m_Vertices.size() >= BoundingVolumeCache::MIN_VERTEX_COUNT;
+		uint64_t key = 0;
+
+		if(cached) {
+			if(mesh->m_ContentHash == 0) {
+				mesh->m_ContentHash = Mesh::contentHashOf(mesh->m_Vertices, mesh->m_Indices);
+			}
+			key = BoundingVolumeCache::keyOf(mesh, type);
+			mesh->m_BoundingVolume = BoundingVolumeCache::load(key, type);
+			if(mesh->m_BoundingVolume != nullptr) return;
+		}
+
+		if(type == BoundingVolume::Type::Sphere) {
 			BoundingSphere* boundingSphere = new BoundingSphere();
 			*boundingSphere = BoundingSphere::of(mesh);
 			mesh->m_BoundingVolume = boundingSphere;
@@ -126,5 +175,9 @@ namespace milo {
 			*obb = OrientedBoundingBox::of(mesh);
 			mesh->m_BoundingVolume = obb;
 		}
+
+		if(cached) {
+			BoundingVolumeCache::save(key, *mesh->m_BoundingVolume);
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "milo/assets/models/ModelLoader.h"
+#include "milo/assets/AssetManager.h"
+#include "milo/common/JobSystem.h"
+
+namespace milo {
+
+	void ModelLoader::shareMeshes(const String& filename, ArrayList<Mesh*>& meshes, const ArrayList<String>& names) {
+
+		JobSystem::parallelFor(meshes.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				meshes[i]->m_ContentHash = Mesh::contentHashOf(meshes[i]->m_Vertices, meshes[i]->m_Indices);
+			}
+		});
+
+		HashMap<uint64_t, ArrayList<uint32_t>> newMeshesByContent;
+		ArrayList<uint32_t> newMeshes;
+
+		for(uint32_t i = 0;i < meshes.size();++i) {
+
+			Mesh* mesh = meshes[i];
+
+			Mesh* existing = Assets::meshes().findByContent(mesh);
+
+			if(existing == nullptr) {
+				for(uint32_t other : newMeshesByContent[mesh->m_ContentHash]) {
+					if(meshes[other]->sameContentAs(*mesh)) {
+						existing = meshes[other];
+						break;
+					}
+				}
+			}
+
+			if(existing != nullptr) {
+				DELETE_PTR(mesh);
+				meshes[i] = existing;
+			} else {
+				newMeshesByContent[mesh->m_ContentHash].push_back(i);
+				newMeshes.push_back(i);
+			}
+		}
+
+		JobSystem::parallelFor(newMeshes.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				MeshManager::createBoundingVolume(filename, meshes[newMeshes[i]]);
+			}
+		});
+
+		// Graphics buffers are created on this thread
+		for(uint32_t i : newMeshes) {
+			Mesh* mesh = meshes[i];
+			String name = names[i];
+			// Different geometry with the same name, from this or another file
+			if(Assets::meshes().exists(name)) {
+				name = fmt::format("{}_{:016x}", name, mesh->m_ContentHash);
+			}
+			mesh->m_Name = name;
+			Assets::meshes().addMesh(name, mesh);
+		}
+	}
+
+	void ModelLoader::setNodeMesh(Model* model, Model::NodeIndex node, Mesh* mesh, Material* material) {
+		model->m_NodeMeshes[node] = mesh;
+		model->m_NodeMaterials[node] = material != nullptr ? material : Assets::materials().getDefault();
+	}
+}
\ No newline at end of file
@@ -1,9 +1,27 @@
 #include "milo/assets/models/ModelManager.h"
 #include "milo/assets/AssetManager.h"
 #include "milo/assets/models/loaders/AssimpModelLoader.h"
+#include "milo/assets/models/loaders/GltfModelLoader.h"
+#include "milo/io/Files.h"
 
 namespace milo {
 
+	static Model* loadModel(const String& filename) {
+
+		const String extension = Files::extension(filename);
+
+		if(extension == ".gltf" || extension == ".glb") {
+			try {
+				return GltfModelLoader().load(filename);
+			} catch(const Exception& e) {
+				// Files using what the native loader does not support (like compressed meshes) may still work with Assimp
+				Log::warn("Could not load {} with the glTF loader, falling back to Assimp: {}", filename, e.what());
+			}
+		}
+
+		return AssimpModelLoader().load(filename);
+	}
+
 	ModelManager::ModelManager() {
 
 	}
@@ -17,7 +35,7 @@ namespace milo {
 	void ModelManager::init() {
 		// TODO
 		//Model* sponza = load("Sponza", "resources/models/Sponza/Sponza.gltf");
-		//sponza->m_Nodes[0]->transform = scale(Matrix4(1.0), {0.1f, 0.1f, 0.1f});
+		//sponza->setLocalTransform(Model::ROOT, scale(Matrix4(1.0), {0.1f, 0.1f, 0.1f}));
 		//sponza->setCanBeCulled(false);
 		Model* damagedHelmet = load("DamagedHelmet", "resources/models/DamagedHelmet/DamagedHelmet.gltf");
 		damagedHelmet->setCanBeCulled(true);
@@ -32,15 +50,15 @@ namespace milo {
 	}
 
 	Model* ModelManager::load(const String& name, const String& filename) {
+		MILO_MEMORY_TAG(MemoryTag::Assets);
 		if(exists(name)) return m_Models[name];
 		Log::debug("Loading model {}...", name);
 		float start = Time::millis();
-		Model* model = AssimpModelLoader().load(filename);
+		Model* model = loadModel(filename);
 		Log::debug("Model {} loaded in {} ms", name, Time::millis() - start);
 		if(model != nullptr) {
 			model->m_Name = name;
 			model->m_Filename = filename;
-			// model->m_Icon = Assets::textures().createIcon(name, model); TODO
 			m_Models[name] = model;
 		}
 		return model;
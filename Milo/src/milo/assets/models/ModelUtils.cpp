@@ -4,26 +4,41 @@ namespace milo {
 
 	Entity ModelUtils::createModelEntityTree(Scene* scene, Model* model) {
 		Entity entity = scene->createEntity(model->name());
-		createEntityModelTree(scene, model, model->root(), entity);
+		createEntityModelTree(scene, model, Model::ROOT, entity);
 		return entity;
 	}
 
-	void ModelUtils::createEntityModelTree(Scene* scene, Model* model, const Model::Node* node, Entity entity) {
+	static void setupNodeEntity(Model* model, Model::NodeIndex node, Entity entity) {
 
 		Transform& transform = entity.getComponent<Transform>();
-		transform.setMatrix(node->transform);
+		transform.setMatrix(model->localTransform(node));
 
-		if(node->mesh != nullptr) {
+		if(model->mesh(node) != nullptr) {
 			MeshView& meshView = entity.addComponent<MeshView>();
-			meshView.mesh = node->mesh;
-			meshView.material = node->material;
+			meshView.mesh = model->mesh(node);
+			meshView.material = model->material(node);
 		}
+	}
+
+	void ModelUtils::createEntityModelTree(Scene* scene, Model* model, Model::NodeIndex node, Entity entity) {
+
+		setupNodeEntity(model, node, entity);
+
+		// Subtrees are contiguous and parents come before their children, so entities can be created in a single pass
+		ArrayList<Entity> entities;
+		entities.push_back(entity);
+
+		for(Model::NodeIndex i = node + 1;i < (Model::NodeIndex)model->size();++i) {
+
+			const Model::NodeIndex parent = model->parent(i);
+			// First node after the subtree
+			if(parent < node) break;
+
+			Entity childEntity = scene->createEntity(model->nodeName(i));
+			entities[parent - node].addChild(childEntity.id());
+			setupNodeEntity(model, i, childEntity);
 
-		for(uint32_t i = 0;i < node->children.size();++i) {
-			const Model::Node* childNode = model->get(node->children[i]);
-			Entity childEntity = scene->createEntity(childNode->name);
-			entity.addChild(childEntity.id());
-			createEntityModelTree(scene, model, childNode, childEntity);
+			entities.push_back(childEntity);
 		}
 	}
 }
\ No newline at end of file
@@ -1,15 +1,26 @@
 #include "milo/assets/models/loaders/AssimpModelLoader.h"
 #include "milo/assets/AssetManager.h"
 #include "milo/io/Files.h"
+#include "milo/common/JobSystem.h"
 #include <assimp/postprocess.h>
 
 namespace milo {
 
+	static const aiTextureType MATERIAL_TEXTURE_TYPES[] = {
+		aiTextureType_DIFFUSE, aiTextureType_EMISSIVE, aiTextureType_NORMALS,
+		aiTextureType_METALNESS, aiTextureType_DIFFUSE_ROUGHNESS, aiTextureType_AMBIENT_OCCLUSION
+	};
+
+	static const HashSet<String> IMAGE_EXTENSIONS = {".PNG", ".png", ".jpg", ".JPG", ".jpeg", ".JPEG", ".tga", ".TGA", ".gif", ".GIF", ".bmp", ".BMP"};
+
 	Model* AssimpModelLoader::load(const String& filename) {
 
 		m_File = filename;
 		m_Dir = Files::parentOf(filename);
 		m_LoadedTextureNames.clear();
+		m_DirectoryImages.clear();
+		m_Meshes.clear();
+		m_Materials.clear();
 
 		Assimp::Importer importer;
 
@@ -21,80 +32,185 @@ namespace milo {
 
 		Model* model = new Model();
 
-		processScene(scene, model);
+		processMeshes(scene);
+		processMaterials(scene);
+		processNodes(scene, model);
 
 		return model;
 	}
 
-	void AssimpModelLoader::processScene(const aiScene* aiScene, Model* outModel) {
-		const aiNode* aiNode = aiScene->mRootNode;
-		Model::Node* node = outModel->createNode();
-		processNode(aiScene, aiNode, node);
-	}
+	ArrayList<Mesh*> AssimpModelLoader::importMeshes(const String& filename) {
+
+		m_File = filename;
+		m_Meshes.clear();
 
-	void AssimpModelLoader::processNode(const aiScene* aiScene, const aiNode* aiNode, Model::Node* outNode) {
+		Assimp::Importer importer;
 
-		outNode->name = aiNode->mName.C_Str();
+		const aiScene* scene = importer.ReadFile(filename.c_str(), ASSIMP_FLAGS);
 
-		memcpy(&outNode->transform, &aiNode->mTransformation, sizeof(Matrix4));
+		if(scene == nullptr || scene->mRootNode == nullptr) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("Failed to import file {}: {}", filename, importer.GetErrorString()));
+		}
 
-		//if(outNode->parent >= 0) {
-		//	const Model::Node* parent = outNode->model->get(outNode->parent);
-		//	outNode->transform = parent->transform * outNode->transform;
-		//}
+		decodeMeshes(scene);
 
-		for(uint32_t i = 0;i < aiNode->mNumMeshes;++i) {
-			processNodeMeshes(aiScene, aiNode, outNode);
+		ArrayList<Mesh*> meshes = std::move(m_Meshes);
+		m_Meshes.clear();
+		return meshes;
+	}
+
+	void AssimpModelLoader::processMeshes(const aiScene* aiScene) {
+
+		decodeMeshes(aiScene);
+
+		ArrayList<String> names(m_Meshes.size());
+		for(uint32_t i = 0;i < names.size();++i) {
+			const aiMesh* aiMesh = aiScene->mMeshes[i];
+			names[i] = aiMesh->mName.length > 0 ? aiMesh->mName.C_Str() : fmt::format("{}[{}]", Files::getName(m_File, true), i);
 		}
 
-		// Children
-		for(uint32_t i = 0;i < aiNode->mNumChildren;++i) {
-			const auto* aiChild = aiNode->mChildren[i];
-			Model::Node* child = outNode->model->createNode();
-			outNode->children.push_back(child->index);
-			child->parent = outNode->index;
-			processNode(aiScene, aiChild, child);
+		shareMeshes(m_File, m_Meshes, names);
+	}
+
+	void AssimpModelLoader::decodeMeshes(const aiScene* aiScene) {
+
+		m_Meshes.resize(aiScene->mNumMeshes, nullptr);
+
+		JobSystem::parallelFor(m_Meshes.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				Mesh* mesh = new Mesh(m_File);
+				processMesh(aiScene->mMeshes[i], mesh);
+				m_Meshes[i] = mesh;
+			}
+		});
+	}
+
+	void AssimpModelLoader::processMaterials(const aiScene* aiScene) {
+
+		preloadTextures(aiScene);
+
+		const String modelName = Files::getName(m_File, true);
+		HashSet<String> names;
+
+		m_Materials.resize(aiScene->mNumMaterials, nullptr);
+
+		for(uint32_t i = 0;i < aiScene->mNumMaterials;++i) {
+
+			const aiMaterial* aiMaterial = aiScene->mMaterials[i];
+
+			String materialName = fmt::format("M_{}_{}", modelName, aiMaterial->GetName().C_Str());
+			if(!names.insert(materialName).second) {
+				materialName += "_" + str(i);
+				names.insert(materialName);
+			}
+
+			Material* material = Assets::materials().find(materialName);
+
+			if(material == nullptr) {
+				material = new Material(materialName, m_File);
+				processMaterial(aiScene, aiMaterial, material);
+				Assets::materials().addMaterial(material->name(), material);
+			}
+
+			m_Materials[i] = material;
 		}
 	}
 
-	void AssimpModelLoader::processNodeMeshes(const aiScene* aiScene, const aiNode* aiNode, Model::Node* outNode) {
+	void AssimpModelLoader::preloadTextures(const aiScene* aiScene) {
+
+		ArrayList<String> textureFiles;
+
+		for(uint32_t i = 0;i < aiScene->mNumMaterials;++i) {
+			for(aiTextureType type : MATERIAL_TEXTURE_TYPES) {
+				String textureFile = getTextureFile(aiScene->mMaterials[i], type);
+				if(!textureFile.empty()) textureFiles.push_back(std::move(textureFile));
+			}
+		}
+
+		// Candidates for the maps that are not referenced by the materials (see processMaterial)
+		if(aiScene->mNumMaterials > 0) {
+			for(const String& file : Files::listFiles(m_Dir)) {
+				if(IMAGE_EXTENSIONS.find(Files::extension(file)) == IMAGE_EXTENSIONS.end()) continue;
+				m_DirectoryImages.push_back(file);
+				textureFiles.push_back(file);
+			}
+		}
 
-		for(uint32_t i = 0;i < aiNode->mNumMeshes;++i) {
+		Assets::textures().load(textureFiles, PixelFormat::RGBA8);
+	}
 
-			Model::Node* node = outNode->model->createNode();
-			outNode->children.push_back(node->index);
-			node->transform = outNode->transform;
+	void AssimpModelLoader::processNodes(const aiScene* aiScene, Model* outModel) {
 
-			const aiMesh* aiMesh = aiScene->mMeshes[aiNode->mMeshes[i]];
-			Mesh* mesh = Assets::meshes().find(aiMesh->mName.C_Str());
+		struct PendingNode {
+			const aiNode* node;
+			Model::NodeIndex parent;
+		};
 
-			node->name = outNode->name + "[" + str(i) + "]";
+		ArrayList<PendingNode> stack;
 
-			if(mesh == nullptr) {
-				mesh = new Mesh(m_File);
-				mesh->m_Name = aiMesh->mName.C_Str();
-				processMesh(aiScene, aiMesh, mesh);
-				Assets::meshes().addMesh(mesh->name(), mesh);
+		uint32_t nodeCount = 0;
+		stack.push_back({aiScene->mRootNode, Model::NO_NODE});
+		while(!stack.empty()) {
+			const aiNode* aiNode = stack.back().node;
+			stack.pop_back();
+			nodeCount += 1 + (aiNode->mNumMeshes > 1 ? aiNode->mNumMeshes : 0);
+			for(uint32_t i = 0;i < aiNode->mNumChildren;++i) {
+				stack.push_back({aiNode->mChildren[i], Model::NO_NODE});
 			}
-			node->mesh = mesh;
-
-			Material* material = Assets::materials().getDefault();
-			if(aiMesh->mMaterialIndex >= 0) {
-				const aiMaterial* aiMaterial = aiScene->mMaterials[aiMesh->mMaterialIndex];
-				String materialName = str("M_") + node->name + str(i);
-				material = Assets::materials().find(materialName);
-
-				if(material == nullptr) {
-					material = new Material(materialName, m_File);
-					processMaterial(aiScene, aiMaterial, material);
-					Assets::materials().addMaterial(material->name(), material);
+		}
+
+		outModel->reserve(nodeCount);
+
+		// Last child created for each node, to link the next one as its sibling
+		ArrayList<Model::NodeIndex> lastChildren;
+		lastChildren.reserve(nodeCount);
+
+		auto createNode = [&](Model::NodeIndex parent, String name, const Matrix4& transform) {
+			const Model::NodeIndex previousSibling = parent != Model::NO_NODE ? lastChildren[parent] : Model::NO_NODE;
+			const Model::NodeIndex node = outModel->createNode(parent, previousSibling, std::move(name), transform);
+			lastChildren.push_back(Model::NO_NODE);
+			if(parent != Model::NO_NODE) lastChildren[parent] = node;
+			return node;
+		};
+
+		stack.push_back({aiScene->mRootNode, Model::NO_NODE});
+
+		while(!stack.empty()) {
+
+			const PendingNode pending = stack.back();
+			stack.pop_back();
+
+			const aiNode* aiNode = pending.node;
+
+			Matrix4 transform;
+			memcpy(&transform, &aiNode->mTransformation, sizeof(Matrix4));
+
+			const Model::NodeIndex node = createNode(pending.parent, aiNode->mName.C_Str(), transform);
+
+			// A single mesh goes in the node itself. Several meshes go in one child each, relative to the node
+			if(aiNode->mNumMeshes == 1) {
+				setNodeMesh(aiScene, aiNode->mMeshes[0], node, outModel);
+			} else {
+				for(uint32_t i = 0;i < aiNode->mNumMeshes;++i) {
+					const Model::NodeIndex child = createNode(node, outModel->nodeName(node) + "[" + str(i) + "]", Matrix4(1.0f));
+					setNodeMesh(aiScene, aiNode->mMeshes[i], child, outModel);
 				}
 			}
-			node->material = material;
+
+			// Pushed in reverse, so children are created in order
+			for(uint32_t i = aiNode->mNumChildren;i > 0;--i) {
+				stack.push_back({aiNode->mChildren[i - 1], node});
+			}
 		}
 	}
 
-	void AssimpModelLoader::processMesh(const aiScene* aiScene, const aiMesh* aiMesh, Mesh* outMesh) {
+	void AssimpModelLoader::setNodeMesh(const aiScene* aiScene, uint32_t meshIndex, Model::NodeIndex node, Model* outModel) {
+		const uint32_t materialIndex = aiScene->mMeshes[meshIndex]->mMaterialIndex;
+		ModelLoader::setNodeMesh(outModel, node, m_Meshes[meshIndex], materialIndex < m_Materials.size() ? m_Materials[materialIndex] : nullptr);
+	}
+
+	// Runs on worker threads, so it only touches the given mesh
+	void AssimpModelLoader::processMesh(const aiMesh* aiMesh, Mesh* outMesh) {
 
 		outMesh->m_Vertices.reserve(aiMesh->mNumVertices);
 
@@ -147,10 +263,28 @@ namespace milo {
 		outFloat = aiFloat;
 	}
 
+	String AssimpModelLoader::getTextureFile(const aiMaterial* aiMaterial, aiTextureType type) const {
+
+		if(aiMaterial->GetTextureCount(type) == 0) return "";
+
+		aiString path;
+		aiMaterial->GetTexture(type, 0, &path);
+
+		String textureFile = path.C_Str();
+
+		if(!Files::isAbsolute(textureFile)) {
+			textureFile = Files::append(m_Dir, textureFile);
+		}
+
+		return textureFile;
+	}
+
 	Ref<Texture2D> AssimpModelLoader::getTexture(const aiScene* aiScene, const aiMaterial* aiMaterial,
 												 aiTextureType type, PixelFormat format, bool* present) {
 
-		if(aiMaterial->GetTextureCount(type) == 0) {
+		const String textureFile = getTextureFile(aiMaterial, type);
+
+		if(textureFile.empty()) {
 			if(present != nullptr) {
 				*present = false;
 			}
@@ -161,12 +295,6 @@ namespace milo {
 		aiString path;
 		aiMaterial->GetTexture(type, 0, &path);
 
-		String textureFile = path.C_Str();
-
-		if(!Files::isAbsolute(textureFile)) {
-			textureFile = Files::append(m_Dir, textureFile);
-		}
-
 		auto texture =  Assets::textures().load(textureFile, format);
 
 		texture->setName(path.C_Str());
@@ -213,16 +341,12 @@ namespace milo {
 		outMaterial->m_RoughnessMap = getTexture(aiScene, aiMaterial, aiTextureType_DIFFUSE_ROUGHNESS, PixelFormat::RGBA8, &hasRoughnessMap);
 		outMaterial->m_OcclusionMap = getTexture(aiScene, aiMaterial, aiTextureType_AMBIENT_OCCLUSION, PixelFormat::RGBA8, &hasOcclusionMap);
 
-		static const HashSet<String> imageExtensions = {".PNG", ".png", ".jpg", ".JPG", ".jpeg", ".JPEG", ".tga", ".TGA", ".gif", ".GIF", ".bmp", ".BMP"};
 		static const HashSet<String> metRoughKeys = {"met", "rough", "Rough", "Met"};
 		static const HashSet<String> occlusionKeys = {"occlusion", "AO", "ao"};
 
-		for(const String& file : Files::listFiles(m_Dir)) {
+		for(const String& file : m_DirectoryImages) {
 
 			String filename = Files::getName(file);
-			String extension = Files::extension(filename);
-
-			if(imageExtensions.find(extension) == imageExtensions.end()) continue;
 
 			if(std::find(m_LoadedTextureNames.begin(), m_LoadedTextureNames.end(), filename) != m_LoadedTextureNames.end()) {
 				continue;
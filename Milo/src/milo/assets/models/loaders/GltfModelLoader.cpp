@@ -0,0 +1,950 @@
+#include "milo/assets/models/loaders/GltfModelLoader.h"
+#include "milo/assets/AssetManager.h"
+#include "milo/io/Files.h"
+#include "milo/common/JobSystem.h"
+#define JSON_USE_IMPLICIT_CONVERSIONS 0
+#include <json.hpp>
+#include <unordered_set>
+
+namespace milo {
+
+	using Json = nlohmann::json;
+
+	static const uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	static const uint32_t GLB_CHUNK_JSON = 0x4E4F534A;
+	static const uint32_t GLB_CHUNK_BIN = 0x004E4942;
+
+	static const uint32_t COMPONENT_BYTE = 5120;
+	static const uint32_t COMPONENT_UNSIGNED_BYTE = 5121;
+	static const uint32_t COMPONENT_SHORT = 5122;
+	static const uint32_t COMPONENT_UNSIGNED_SHORT = 5123;
+	static const uint32_t COMPONENT_UNSIGNED_INT = 5125;
+	static const uint32_t COMPONENT_FLOAT = 5126;
+
+	static const uint32_t MODE_TRIANGLES = 4;
+	static const uint32_t MODE_TRIANGLE_STRIP = 5;
+	static const uint32_t MODE_TRIANGLE_FAN = 6;
+
+	// Required extensions that need nothing else from the loader
+	static const std::unordered_set<String> SUPPORTED_EXTENSIONS = {"KHR_mesh_quantization"};
+
+	static const Json EMPTY_ARRAY = Json::array();
+	static const Json EMPTY_OBJECT = Json::object();
+
+	struct GltfModelLoader::Document {
+
+		struct Buffer {
+			const byte_t* data{nullptr};
+			uint64_t size{0};
+		};
+
+		Json json;
+		Ref<MappedFile> file;
+		Buffer binaryChunk;
+		// Keep the memory the buffers point to alive
+		ArrayList<Ref<MappedFile>> bufferFiles;
+		ArrayList<ArrayList<byte_t>> decodedBuffers;
+		// By glTF buffer index
+		ArrayList<Buffer> buffers;
+	};
+
+	inline static uint32_t readUInt32(const byte_t* data) {
+		uint32_t value;
+		memcpy(&value, data, sizeof(uint32_t));
+		return value;
+	}
+
+	static uint32_t componentSizeOf(uint32_t componentType) {
+		switch(componentType) {
+			case COMPONENT_BYTE:
+			case COMPONENT_UNSIGNED_BYTE:
+				return 1;
+			case COMPONENT_SHORT:
+			case COMPONENT_UNSIGNED_SHORT:
+				return 2;
+			case COMPONENT_UNSIGNED_INT:
+			case COMPONENT_FLOAT:
+				return 4;
+			default:
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("Unknown glTF component type {}", componentType));
+		}
+	}
+
+	static uint32_t componentCountOf(const String& type) {
+		if(type == "SCALAR") return 1;
+		if(type == "VEC2") return 2;
+		if(type == "VEC3") return 3;
+		if(type == "VEC4") return 4;
+		if(type == "MAT2") return 4;
+		if(type == "MAT3") return 9;
+		if(type == "MAT4") return 16;
+		throw MILO_RUNTIME_EXCEPTION(fmt::format("Unknown glTF accessor type {}", type));
+	}
+
+	static bool decodeBase64(const String& text, size_t begin, ArrayList<byte_t>& out) {
+
+		static const auto valueOf = [](char c) -> int32_t {
+			if(c >= 'A' && c <= 'Z') return c - 'A';
+			if(c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if(c >= '0' && c <= '9') return c - '0' + 52;
+			if(c == '+' || c == '-') return 62;
+			if(c == '/' || c == '_') return 63;
+			return -1;
+		};
+
+		out.reserve((text.size() - begin) / 4 * 3);
+
+		uint32_t bits = 0;
+		int32_t bitCount = 0;
+
+		for(size_t i = begin;i < text.size() && text[i] != '=';++i) {
+			const int32_t value = valueOf(text[i]);
+			if(value < 0) return false;
+			bits = (bits << 6) | (uint32_t)value;
+			bitCount += 6;
+			if(bitCount >= 8) {
+				bitCount -= 8;
+				out.push_back((byte_t)((bits >> bitCount) & 0xFF));
+			}
+		}
+
+		return true;
+	}
+
+	// Relative URIs may have percent encoded characters, like spaces
+	static String decodeUri(const String& uri) {
+
+		String result;
+		result.reserve(uri.size());
+
+		for(size_t i = 0;i < uri.size();++i) {
+			if(uri[i] == '%' && i + 2 < uri.size() && isxdigit((unsigned char)uri[i + 1]) && isxdigit((unsigned char)uri[i + 2])) {
+				result.push_back((char)std::stoi(uri.substr(i + 1, 2), nullptr, 16));
+				i += 2;
+			} else {
+				result.push_back(uri[i]);
+			}
+		}
+
+		return result;
+	}
+
+	inline static bool isDataUri(const String& uri) {
+		return uri.rfind("data:", 0) == 0;
+	}
+
+	static ArrayList<byte_t> decodeDataUri(const String& uri) {
+
+		const size_t base64 = uri.find(";base64,");
+		ArrayList<byte_t> data;
+
+		if(base64 == String::npos || !decodeBase64(uri, base64 + 8, data)) {
+			throw MILO_RUNTIME_EXCEPTION("Unsupported glTF data URI, only base64 is allowed");
+		}
+
+		return data;
+	}
+
+	static void readFloats(const Json& json, const char* key, float* out, size_t count) {
+		auto it = json.find(key);
+		if(it == json.end()) return;
+		for(size_t i = 0;i < count && i < it->size();++i) {
+			out[i] = (*it)[i].get<float>();
+		}
+	}
+
+	template<typename T>
+	inline static float readComponent(const byte_t* element, uint32_t component, bool normalized, float maxValue) {
+		T value;
+		memcpy(&value, element + component * sizeof(T), sizeof(T));
+		return normalized ? std::max((float)value / maxValue, -1.0f) : (float)value;
+	}
+
+	template<uint32_t N, typename AccessorView>
+	static void readElement(const AccessorView& view, uint32_t index, float* out) {
+
+		if(view.data == nullptr) {
+			for(uint32_t c = 0;c < N;++c) out[c] = 0;
+			return;
+		}
+
+		const byte_t* element = view.data + (size_t)index * view.stride;
+		const uint32_t count = std::min(N, view.components);
+
+		if(view.componentType == COMPONENT_FLOAT) {
+			memcpy(out, element, count * sizeof(float));
+		} else {
+			for(uint32_t c = 0;c < count;++c) {
+				switch(view.componentType) {
+					case COMPONENT_BYTE: out[c] = readComponent<int8_t>(element, c, view.normalized, 127.0f); break;
+					case COMPONENT_UNSIGNED_BYTE: out[c] = readComponent<uint8_t>(element, c, view.normalized, 255.0f); break;
+					case COMPONENT_SHORT: out[c] = readComponent<int16_t>(element, c, view.normalized, 32767.0f); break;
+					case COMPONENT_UNSIGNED_SHORT: out[c] = readComponent<uint16_t>(element, c, view.normalized, 65535.0f); break;
+					case COMPONENT_UNSIGNED_INT: out[c] = readComponent<uint32_t>(element, c, false, 1.0f); break;
+				}
+			}
+		}
+
+		for(uint32_t c = count;c < N;++c) out[c] = 0;
+	}
+
+	// Reads an attribute straight into its field of every vertex
+	template<uint32_t N, typename AccessorView, typename T>
+	static void readAttribute(const AccessorView& view, ArrayList<Vertex>& vertices, T Vertex::* attribute) {
+		if(view.count < vertices.size()) {
+			throw MILO_RUNTIME_EXCEPTION("glTF vertex attribute with less elements than positions");
+		}
+		for(uint32_t i = 0;i < vertices.size();++i) {
+			readElement<N>(view, i, value_ptr(vertices[i].*attribute));
+		}
+	}
+
+	template<typename T, typename AccessorView>
+	static void readIndices(const AccessorView& view, ArrayList<uint32_t>& indices) {
+		if(view.data == nullptr) {
+			std::fill(indices.begin(), indices.end(), 0);
+			return;
+		}
+		if(sizeof(T) == sizeof(uint32_t) && view.stride == sizeof(uint32_t)) {
+			memcpy(indices.data(), view.data, view.count * sizeof(uint32_t));
+			return;
+		}
+		for(uint32_t i = 0;i < view.count;++i) {
+			T index;
+			memcpy(&index, view.data + (size_t)i * view.stride, sizeof(T));
+			indices[i] = index;
+		}
+	}
+
+	static void toTriangleList(uint32_t mode, ArrayList<uint32_t>& indices) {
+
+		ArrayList<uint32_t> triangles;
+		triangles.reserve(indices.size() < 3 ? 0 : (indices.size() - 2) * 3);
+
+		for(size_t i = 2;i < indices.size();++i) {
+			if(mode == MODE_TRIANGLE_FAN) {
+				triangles.insert(triangles.end(), {indices[0], indices[i - 1], indices[i]});
+			} else if(i % 2 == 0) {
+				triangles.insert(triangles.end(), {indices[i - 2], indices[i - 1], indices[i]});
+			} else {
+				triangles.insert(triangles.end(), {indices[i - 1], indices[i - 2], indices[i]});
+			}
+		}
+
+		indices = std::move(triangles);
+	}
+
+	// Smooth normals weighted by the area of the triangles. Unindexed geometry ends up with flat normals
+	static void generateNormals(ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices) {
+
+		const VertexList triangles(vertices, indices);
+		const auto indexOf = [&](size_t i) {return indices.empty() ? (uint32_t)i : indices[i];};
+
+		for(size_t i = 0;i + 2 < triangles.size();i += 3) {
+			const Vector3 normal = cross(triangles[i + 1].position - triangles[i].position, triangles[i + 2].position - triangles[i].position);
+			for(size_t v = i;v < i + 3;++v) {
+				vertices[indexOf(v)].normal += normal;
+			}
+		}
+
+		for(Vertex& vertex : vertices) {
+			const float length = glm::length(vertex.normal);
+			vertex.normal = length > 0 ? vertex.normal / length : Vector3(0, 1, 0);
+		}
+	}
+
+	static void generateTangents(ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices) {
+
+		const VertexList triangles(vertices, indices);
+		const auto indexOf = [&](size_t i) {return indices.empty() ? (uint32_t)i : indices[i];};
+
+		for(size_t i = 0;i + 2 < triangles.size();i += 3) {
+
+			const Vertex& v0 = triangles[i];
+			const Vertex& v1 = triangles[i + 1];
+			const Vertex& v2 = triangles[i + 2];
+
+			const Vector3 edge1 = v1.position - v0.position;
+			const Vector3 edge2 = v2.position - v0.position;
+			const Vector2 deltaUV1 = v1.texCoords - v0.texCoords;
+			const Vector2 deltaUV2 = v2.texCoords - v0.texCoords;
+
+			const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+			if(std::abs(determinant) < 1e-12f) continue;
+
+			const float f = 1.0f / determinant;
+			const Vector3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) * f;
+			const Vector3 biTangent = (edge2 * deltaUV1.x - edge1 * deltaUV2.x) * f;
+
+			for(size_t v = i;v < i + 3;++v) {
+				Vertex& vertex = vertices[indexOf(v)];
+				vertex.tangent += tangent;
+				vertex.biTangent += biTangent;
+			}
+		}
+
+		for(Vertex& vertex : vertices) {
+			const Vector3& n = vertex.normal;
+			Vector3 t = vertex.tangent - n * dot(n, vertex.tangent);
+			if(dot(t, t) < 1e-12f) {
+				t = cross(n, std::abs(n.x) < 0.9f ? Vector3(1, 0, 0) : Vector3(0, 1, 0));
+			}
+			t = normalize(t);
+			const float handedness = dot(cross(n, t), vertex.biTangent) < 0.0f ? -1.0f : 1.0f;
+			vertex.tangent = t;
+			vertex.biTangent = cross(n, t) * handedness;
+		}
+	}
+
+	static Matrix4 nodeTransform(const Json& node) {
+
+		if(node.contains("matrix")) {
+			// Column major, like glm
+			float values[16]{};
+			readFloats(node, "matrix", values, 16);
+			Matrix4 matrix;
+			memcpy(&matrix, values, sizeof(Matrix4));
+			return matrix;
+		}
+
+		float t[3]{0, 0, 0};
+		float r[4]{0, 0, 0, 1};
+		float s[3]{1, 1, 1};
+		readFloats(node, "translation", t, 3);
+		readFloats(node, "rotation", r, 4);
+		readFloats(node, "scale", s, 3);
+
+		return translate(Matrix4(1.0f), Vector3(t[0], t[1], t[2]))
+			* mat4_cast(Quaternion(r[3], r[0], r[1], r[2]))
+			* glm::scale(Matrix4(1.0f), Vector3(s[0], s[1], s[2]));
+	}
+
+	Model* GltfModelLoader::load(const String& filename) {
+
+		reset(filename);
+
+		Document document;
+		readDocument(document);
+
+		collectPrimitives(document);
+		processMeshes(document);
+		processTextures(document);
+		processMaterials(document);
+
+		Model* model = new Model();
+
+		processNodes(document, model);
+
+		return model;
+	}
+
+	ArrayList<Mesh*> GltfModelLoader::importMeshes(const String& filename) {
+
+		reset(filename);
+
+		Document document;
+		readDocument(document);
+
+		collectPrimitives(document);
+		decodeMeshes(document);
+
+		ArrayList<Mesh*> meshes = std::move(m_Meshes);
+		m_Meshes.clear();
+		return meshes;
+	}
+
+	void GltfModelLoader::reset(const String& filename) {
+		m_File = filename;
+		m_Dir = Files::parentOf(filename);
+		m_Primitives.clear();
+		m_FirstPrimitives.clear();
+		m_Meshes.clear();
+		m_Materials.clear();
+		m_Textures.clear();
+	}
+
+	void GltfModelLoader::readDocument(Document& document) const {
+
+		document.file = Ref<MappedFile>(new MappedFile(m_File));
+
+		if(!document.file->valid()) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("Failed to open {}", m_File));
+		}
+
+		const byte_t* data = document.file->data();
+		const uint64_t size = document.file->size();
+
+		const byte_t* jsonBegin = data;
+		const byte_t* jsonEnd = data + size;
+
+		if(size >= 12 && readUInt32(data) == GLB_MAGIC) {
+
+			if(readUInt32(data + 4) != 2) {
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("Unsupported GLB version {} in {}", readUInt32(data + 4), m_File));
+			}
+
+			const uint64_t length = std::min((uint64_t)readUInt32(data + 8), size);
+
+			jsonBegin = jsonEnd = nullptr;
+
+			for(uint64_t offset = 12;offset + 8 <= length;) {
+
+				const uint32_t chunkLength = readUInt32(data + offset);
+				const uint32_t chunkType = readUInt32(data + offset + 4);
+				const byte_t* chunk = data + offset + 8;
+
+				if(offset + 8 + chunkLength > length) {
+					throw MILO_RUNTIME_EXCEPTION(fmt::format("Truncated GLB chunk in {}", m_File));
+				}
+
+				if(chunkType == GLB_CHUNK_JSON && jsonBegin == nullptr) {
+					jsonBegin = chunk;
+					jsonEnd = chunk + chunkLength;
+				} else if(chunkType == GLB_CHUNK_BIN && document.binaryChunk.data == nullptr) {
+					document.binaryChunk = {chunk, chunkLength};
+				}
+
+				offset += 8 + chunkLength;
+			}
+
+			if(jsonBegin == nullptr) {
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("GLB file {} has no JSON chunk", m_File));
+			}
+		}
+
+		try {
+			document.json = Json::parse((const char*)jsonBegin, (const char*)jsonEnd);
+		} catch(const Json::exception& e) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("Failed to parse {}: {}", m_File, e.what()));
+		}
+
+		const String version = document.json.contains("asset") ? document.json["asset"].value("version", "") : "";
+		if(version.rfind("2.", 0) != 0) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("{} is not a glTF 2.0 file (version {})", m_File, version));
+		}
+
+		if(document.json.contains("extensionsRequired")) {
+			for(const Json& extension : document.json["extensionsRequired"]) {
+				const String name = extension.get<String>();
+				if(SUPPORTED_EXTENSIONS.find(name) == SUPPORTED_EXTENSIONS.end()) {
+					throw MILO_RUNTIME_EXCEPTION(fmt::format("{} requires the unsupported extension {}", m_File, name));
+				}
+			}
+		}
+
+		readBuffers(document);
+	}
+
+	void GltfModelLoader::readBuffers(Document& document) const {
+
+		if(!document.json.contains("buffers")) return;
+
+		for(const Json& buffer : document.json["buffers"]) {
+
+			const uint64_t byteLength = buffer.at("byteLength").get<uint64_t>();
+			Document::Buffer range;
+
+			if(!buffer.contains("uri")) {
+				// Only the first buffer of a .glb may refer to the binary chunk
+				range = document.binaryChunk;
+			} else {
+				const String uri = buffer["uri"].get<String>();
+				if(isDataUri(uri)) {
+					document.decodedBuffers.push_back(decodeDataUri(uri));
+					const ArrayList<byte_t>& decoded = document.decodedBuffers.back();
+					range = {decoded.data(), decoded.size()};
+				} else {
+					const String file = Files::append(m_Dir, decodeUri(uri));
+					auto mappedFile = Ref<MappedFile>(new MappedFile(file));
+					if(!mappedFile->valid()) {
+						throw MILO_RUNTIME_EXCEPTION(fmt::format("Failed to open glTF buffer {}", file));
+					}
+					range = {mappedFile->data(), mappedFile->size()};
+					document.bufferFiles.push_back(std::move(mappedFile));
+				}
+			}
+
+			if(range.data == nullptr || range.size < byteLength) {
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("glTF buffer {} of {} is missing or too small", document.buffers.size(), m_File));
+			}
+
+			range.size = byteLength;
+			document.buffers.push_back(range);
+		}
+	}
+
+	GltfModelLoader::AccessorView GltfModelLoader::accessor(const Document& document, uint32_t index) const {
+
+		const Json& accessor = document.json.at("accessors").at(index);
+
+		AccessorView view;
+		view.count = accessor.at("count").get<uint32_t>();
+		view.componentType = accessor.at("componentType").get<uint32_t>();
+		view.components = componentCountOf(accessor.at("type").get<String>());
+		view.normalized = accessor.value("normalized", false);
+
+		if(accessor.contains("sparse")) {
+			Log::warn("Sparse glTF accessors are not supported, {} will use the values before substitution", m_File);
+		}
+
+		if(!accessor.contains("bufferView")) return view;
+
+		const Json& bufferView = document.json.at("bufferViews").at(accessor["bufferView"].get<uint32_t>());
+		const Document::Buffer& buffer = document.buffers.at(bufferView.at("buffer").get<uint32_t>());
+
+		const uint32_t elementSize = componentSizeOf(view.componentType) * view.components;
+		const uint64_t viewOffset = bufferView.value("byteOffset", (uint64_t)0);
+		const uint64_t viewLength = bufferView.at("byteLength").get<uint64_t>();
+		const uint64_t offset = accessor.value("byteOffset", (uint64_t)0);
+
+		view.stride = bufferView.value("byteStride", elementSize);
+		if(view.stride == 0) view.stride = elementSize;
+
+		const uint64_t end = view.count == 0 ? offset : offset + (uint64_t)view.stride * (view.count - 1) + elementSize;
+		if(viewOffset + viewLength > buffer.size || end > viewLength) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("glTF accessor {} of {} is out of bounds", index, m_File));
+		}
+
+		view.data = buffer.data + viewOffset + offset;
+
+		return view;
+	}
+
+	void GltfModelLoader::collectPrimitives(const Document& document) {
+
+		const Json& meshes = document.json.contains("meshes") ? document.json["meshes"] : EMPTY_ARRAY;
+
+		m_FirstPrimitives.reserve(meshes.size() + 1);
+
+		for(uint32_t i = 0;i < meshes.size();++i) {
+
+			m_FirstPrimitives.push_back(m_Primitives.size());
+
+			const Json& primitives = meshes[i].at("primitives");
+
+			for(uint32_t j = 0;j < primitives.size();++j) {
+
+				const uint32_t mode = primitives[j].value("mode", MODE_TRIANGLES);
+
+				if(mode != MODE_TRIANGLES && mode != MODE_TRIANGLE_STRIP && mode != MODE_TRIANGLE_FAN) {
+					Log::warn("Skipping primitive {} of mesh {} in {}: only triangles are supported", j, i, m_File);
+					continue;
+				}
+
+				if(!primitives[j].at("attributes").contains("POSITION")) {
+					Log::warn("Skipping primitive {} of mesh {} in {}: it has no positions", j, i, m_File);
+					continue;
+				}
+
+				Primitive primitive;
+				primitive.mesh = i;
+				primitive.index = j;
+				primitive.material = primitives[j].value("material", -1);
+				m_Primitives.push_back(primitive);
+			}
+		}
+
+		m_FirstPrimitives.push_back(m_Primitives.size());
+	}
+
+	void GltfModelLoader::decodeMeshes(const Document& document) {
+
+		m_Meshes.resize(m_Primitives.size(), nullptr);
+
+		std::exception_ptr error = nullptr;
+		Mutex errorMutex;
+
+		JobSystem::parallelFor(m_Primitives.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				try {
+					Mesh* mesh = new Mesh(m_File);
+					m_Meshes[i] = mesh;
+					processPrimitive(document, m_Primitives[i], mesh);
+				} catch(ANY_EXCEPTION) {
+					std::lock_guard<Mutex> lock(errorMutex);
+					if(error == nullptr) error = std::current_exception();
+				}
+			}
+		});
+
+		if(error != nullptr) {
+			for(Mesh* mesh : m_Meshes) {
+				DELETE_PTR(mesh);
+			}
+			m_Meshes.clear();
+			std::rethrow_exception(error);
+		}
+	}
+
+	void GltfModelLoader::processMeshes(const Document& document) {
+
+		decodeMeshes(document);
+
+		const Json& meshes = document.json["meshes"];
+		ArrayList<String> names(m_Primitives.size());
+
+		for(uint32_t i = 0;i < m_Primitives.size();++i) {
+			const Primitive& primitive = m_Primitives[i];
+			const Json& mesh = meshes[primitive.mesh];
+			String name = mesh.contains("name") ? mesh["name"].get<String>() : fmt::format("{}[{}]", Files::getName(m_File, true), primitive.mesh);
+			if(mesh["primitives"].size() > 1) name += "[" + str(primitive.index) + "]";
+			names[i] = std::move(name);
+		}
+
+		shareMeshes(m_File, m_Meshes, names);
+	}
+
+	// Runs on worker threads, so it only touches the given mesh
+	void GltfModelLoader::processPrimitive(const Document& document, const Primitive& primitive, Mesh* outMesh) const {
+
+		const Json& gltfPrimitive = document.json["meshes"][primitive.mesh]["primitives"][primitive.index];
+		const Json& attributes = gltfPrimitive["attributes"];
+
+		ArrayList<Vertex>& vertices = outMesh->m_Vertices;
+		ArrayList<uint32_t>& indices = outMesh->m_Indices;
+
+		const AccessorView positions = accessor(document, attributes["POSITION"].get<uint32_t>());
+		vertices.resize(positions.count);
+
+		readAttribute<3>(positions, vertices, &Vertex::position);
+
+		const bool hasNormals = attributes.contains("NORMAL");
+		if(hasNormals) {
+			readAttribute<3>(accessor(document, attributes["NORMAL"].get<uint32_t>()), vertices, &Vertex::normal);
+		}
+
+		const bool hasTexCoords = attributes.contains("TEXCOORD_0");
+		if(hasTexCoords) {
+			readAttribute<2>(accessor(document, attributes["TEXCOORD_0"].get<uint32_t>()), vertices, &Vertex::texCoords);
+			// Same convention as the Assimp importer, which flips them on import
+			for(Vertex& vertex : vertices) {
+				vertex.texCoords.y = 1.0f - vertex.texCoords.y;
+			}
+		}
+
+		if(gltfPrimitive.contains("indices")) {
+
+			const AccessorView view = accessor(document, gltfPrimitive["indices"].get<uint32_t>());
+			indices.resize(view.count);
+
+			switch(view.componentType) {
+				case COMPONENT_UNSIGNED_BYTE: readIndices<uint8_t>(view, indices); break;
+				case COMPONENT_UNSIGNED_SHORT: readIndices<uint16_t>(view, indices); break;
+				case COMPONENT_UNSIGNED_INT: readIndices<uint32_t>(view, indices); break;
+				default: throw MILO_RUNTIME_EXCEPTION(fmt::format("Invalid glTF index component type {}", view.componentType));
+			}
+
+			for(uint32_t index : indices) {
+				if(index >= vertices.size()) {
+					throw MILO_RUNTIME_EXCEPTION(fmt::format("glTF index {} out of range in {}", index, m_File));
+				}
+			}
+		}
+
+		const uint32_t mode = gltfPrimitive.value("mode", MODE_TRIANGLES);
+		if(mode != MODE_TRIANGLES) {
+			if(indices.empty()) {
+				indices.resize(vertices.size());
+				for(uint32_t i = 0;i < indices.size();++i) indices[i] = i;
+			}
+			toTriangleList(mode, indices);
+		}
+
+		if(!hasNormals) {
+			generateNormals(vertices, indices);
+		}
+
+		if(attributes.contains("TANGENT")) {
+			const AccessorView tangents = accessor(document, attributes["TANGENT"].get<uint32_t>());
+			for(uint32_t i = 0;i < vertices.size();++i) {
+				Vector4 tangent;
+				readElement<4>(tangents, i, value_ptr(tangent));
+				Vertex& vertex = vertices[i];
+				vertex.tangent = Vector3(tangent);
+				// w is the handedness of the tangent space
+				vertex.biTangent = cross(vertex.normal, vertex.tangent) * (tangent.w < 0.0f ? -1.0f : 1.0f);
+			}
+		} else if(hasTexCoords) {
+			generateTangents(vertices, indices);
+		}
+	}
+
+	void GltfModelLoader::processTextures(const Document& document) {
+
+		const Json& json = document.json;
+		if(!json.contains("textures") || !json.contains("materials")) return;
+
+		static const char* TEXTURE_KEYS[] = {"normalTexture", "occlusionTexture", "emissiveTexture"};
+		static const char* PBR_TEXTURE_KEYS[] = {"baseColorTexture", "metallicRoughnessTexture"};
+
+		// Only the textures the materials use are loaded
+		std::unordered_set<uint32_t> usedTextures;
+
+		for(const Json& material : json["materials"]) {
+			for(const char* key : TEXTURE_KEYS) {
+				if(material.contains(key)) usedTextures.insert(material[key].at("index").get<uint32_t>());
+			}
+			if(!material.contains("pbrMetallicRoughness")) continue;
+			for(const char* key : PBR_TEXTURE_KEYS) {
+				if(material["pbrMetallicRoughness"].contains(key)) {
+					usedTextures.insert(material["pbrMetallicRoughness"][key].at("index").get<uint32_t>());
+				}
+			}
+		}
+
+		m_Textures.resize(json["textures"].size(), nullptr);
+
+		ArrayList<String> files;
+		ArrayList<String> fileNames;
+		ArrayList<uint32_t> fileTextures;
+		ArrayList<EncodedImage> encodedImages;
+		ArrayList<uint32_t> encodedTextures;
+		// Decoded data URIs, alive until the images are decoded
+		ArrayList<ArrayList<byte_t>> decodedUris;
+		decodedUris.reserve(usedTextures.size());
+
+		for(uint32_t textureIndex : usedTextures) {
+
+			const Json& texture = json["textures"].at(textureIndex);
+			if(!texture.contains("source")) continue;
+
+			const uint32_t imageIndex = texture["source"].get<uint32_t>();
+			const Json& image = json.at("images").at(imageIndex);
+			const String embeddedName = fmt::format("{}#image{}", m_File, imageIndex);
+
+			if(image.contains("uri")) {
+				const String uri = image["uri"].get<String>();
+				if(isDataUri(uri)) {
+					decodedUris.push_back(decodeDataUri(uri));
+					encodedImages.push_back({embeddedName, decodedUris.back().data(), decodedUris.back().size()});
+					encodedTextures.push_back(textureIndex);
+				} else {
+					files.push_back(Files::append(m_Dir, decodeUri(uri)));
+					fileNames.push_back(uri);
+					fileTextures.push_back(textureIndex);
+				}
+			} else if(image.contains("bufferView")) {
+				// Decoded straight from the mapped file
+				const Json& bufferView = json.at("bufferViews").at(image["bufferView"].get<uint32_t>());
+				const Document::Buffer& buffer = document.buffers.at(bufferView.at("buffer").get<uint32_t>());
+				const uint64_t offset = bufferView.value("byteOffset", (uint64_t)0);
+				const uint64_t length = bufferView.at("byteLength").get<uint64_t>();
+				if(offset + length > buffer.size) {
+					throw MILO_RUNTIME_EXCEPTION(fmt::format("glTF image {} of {} is out of bounds", imageIndex, m_File));
+				}
+				encodedImages.push_back({embeddedName, buffer.data + offset, (size_t)length});
+				encodedTextures.push_back(textureIndex);
+			}
+		}
+
+		const ArrayList<Ref<Texture2D>> fileResults = Assets::textures().load(files, PixelFormat::RGBA8);
+		for(size_t i = 0;i < fileResults.size();++i) {
+			fileResults[i]->setName(fileNames[i]);
+			m_Textures[fileTextures[i]] = fileResults[i];
+		}
+
+		const ArrayList<Ref<Texture2D>> encodedResults = Assets::textures().load(encodedImages, PixelFormat::RGBA8);
+		for(size_t i = 0;i < encodedResults.size();++i) {
+			m_Textures[encodedTextures[i]] = encodedResults[i];
+		}
+	}
+
+	void GltfModelLoader::processMaterials(const Document& document) {
+
+		const Json& json = document.json;
+		if(!json.contains("materials")) return;
+
+		const String modelName = Files::getName(m_File, true);
+		std::unordered_set<String> names;
+
+		m_Materials.resize(json["materials"].size(), nullptr);
+
+		for(uint32_t i = 0;i < m_Materials.size();++i) {
+
+			const Json& gltfMaterial = json["materials"][i];
+
+			String materialName = fmt::format("M_{}_{}", modelName, gltfMaterial.value("name", "Material" + str(i)));
+			if(!names.insert(materialName).second) {
+				materialName += "_" + str(i);
+				names.insert(materialName);
+			}
+
+			Material* material = Assets::materials().find(materialName);
+
+			if(material == nullptr) {
+				material = new Material(materialName, m_File);
+				processMaterial(document, i, material);
+				Assets::materials().addMaterial(material->name(), material);
+			}
+
+			m_Materials[i] = material;
+		}
+	}
+
+	void GltfModelLoader::processMaterial(const Document& document, uint32_t materialIndex, Material* outMaterial) const {
+
+		const Json& gltfMaterial = document.json["materials"][materialIndex];
+		const Json& pbr = gltfMaterial.contains("pbrMetallicRoughness") ? gltfMaterial["pbrMetallicRoughness"] : EMPTY_OBJECT;
+
+		const auto getTexture = [&](const Json& parent, const char* key) -> Ref<Texture2D> {
+			if(!parent.contains(key)) return nullptr;
+			const uint32_t index = parent[key].at("index").get<uint32_t>();
+			return index < m_Textures.size() ? m_Textures[index] : nullptr;
+		};
+
+		Material::Data& mat = outMaterial->m_Data;
+
+		float baseColor[4]{1, 1, 1, 1};
+		readFloats(pbr, "baseColorFactor", baseColor, 4);
+		mat.albedo = {baseColor[0], baseColor[1], baseColor[2], baseColor[3]};
+		mat.alpha = baseColor[3];
+
+		float emissive[3]{0, 0, 0};
+		readFloats(gltfMaterial, "emissiveFactor", emissive, 3);
+		mat.emissiveColor = {emissive[0], emissive[1], emissive[2], 1.0f};
+
+		mat.metallic = pbr.value("metallicFactor", 1.0f);
+		mat.roughness = pbr.value("roughnessFactor", 1.0f);
+
+		const Ref<Texture2D> white = Assets::textures().whiteTexture();
+
+		Ref<Texture2D> albedoMap = getTexture(pbr, "baseColorTexture");
+		outMaterial->m_AlbedoMap = albedoMap != nullptr ? albedoMap : white;
+
+		Ref<Texture2D> emissiveMap = getTexture(gltfMaterial, "emissiveTexture");
+		outMaterial->m_EmissiveMap = emissiveMap != nullptr ? emissiveMap : Assets::textures().blackTexture();
+
+		outMaterial->m_MetallicMap = white;
+		outMaterial->m_RoughnessMap = white;
+
+		// Metalness in blue, roughness in green
+		Ref<Texture2D> metallicRoughnessMap = getTexture(pbr, "metallicRoughnessTexture");
+		if(metallicRoughnessMap != nullptr) {
+			outMaterial->m_MetallicRoughnessMap = metallicRoughnessMap;
+			outMaterial->useCombinedMetallicRoughness(true);
+		}
+
+		Ref<Texture2D> normalMap = getTexture(gltfMaterial, "normalTexture");
+		outMaterial->m_NormalMap = normalMap != nullptr ? normalMap : white;
+		mat.useNormalMap = normalMap != nullptr;
+		if(normalMap != nullptr) mat.normalScale = gltfMaterial["normalTexture"].value("scale", 1.0f);
+
+		Ref<Texture2D> occlusionMap = getTexture(gltfMaterial, "occlusionTexture");
+		outMaterial->m_OcclusionMap = occlusionMap != nullptr ? occlusionMap : white;
+		if(occlusionMap != nullptr) mat.occlusion = gltfMaterial["occlusionTexture"].value("strength", 1.0f);
+	}
+
+	void GltfModelLoader::processNodes(const Document& document, Model* outModel) {
+
+		const Json& json = document.json;
+		const Json& nodes = json.contains("nodes") ? json["nodes"] : EMPTY_ARRAY;
+
+		ArrayList<uint32_t> roots;
+
+		if(json.contains("scenes") && !json["scenes"].empty()) {
+			const Json& scene = json["scenes"].at(json.value("scene", 0));
+			if(scene.contains("nodes")) {
+				for(const Json& node : scene["nodes"]) roots.push_back(node.get<uint32_t>());
+			}
+		} else {
+			// No scenes: every node without parent is a root
+			ArrayList<bool> isChild(nodes.size(), false);
+			for(const Json& node : nodes) {
+				if(!node.contains("children")) continue;
+				for(const Json& child : node["children"]) isChild.at(child.get<uint32_t>()) = true;
+			}
+			for(uint32_t i = 0;i < nodes.size();++i) {
+				if(!isChild[i]) roots.push_back(i);
+			}
+		}
+
+		const auto primitiveCountOf = [&](const Json& node) -> uint32_t {
+			if(!node.contains("mesh")) return 0;
+			const uint32_t mesh = node["mesh"].get<uint32_t>();
+			return mesh + 1 < m_FirstPrimitives.size() ? m_FirstPrimitives[mesh + 1] - m_FirstPrimitives[mesh] : 0;
+		};
+
+		// Counts the nodes and checks the hierarchy is a tree, so the traversal below ends
+		ArrayList<bool> visited(nodes.size(), false);
+		ArrayList<uint32_t> stack(roots.rbegin(), roots.rend());
+		uint32_t nodeCount = 1;
+
+		while(!stack.empty()) {
+			const uint32_t index = stack.back();
+			stack.pop_back();
+			if(visited.at(index)) {
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("glTF node {} of {} has several parents", index, m_File));
+			}
+			visited[index] = true;
+			const uint32_t primitives = primitiveCountOf(nodes[index]);
+			nodeCount += 1 + (primitives > 1 ? primitives : 0);
+			if(nodes[index].contains("children")) {
+				for(const Json& child : nodes[index]["children"]) stack.push_back(child.get<uint32_t>());
+			}
+		}
+
+		outModel->reserve(nodeCount);
+
+		// Last child created for each node, to link the next one as its sibling
+		ArrayList<Model::NodeIndex> lastChildren;
+		lastChildren.reserve(nodeCount);
+
+		auto createNode = [&](Model::NodeIndex parent, String name, const Matrix4& transform) {
+			const Model::NodeIndex previousSibling = parent != Model::NO_NODE ? lastChildren[parent] : Model::NO_NODE;
+			const Model::NodeIndex node = outModel->createNode(parent, previousSibling, std::move(name), transform);
+			lastChildren.push_back(Model::NO_NODE);
+			if(parent != Model::NO_NODE) lastChildren[parent] = node;
+			return node;
+		};
+
+		const auto materialOf = [&](const Primitive& primitive) -> Material* {
+			return primitive.material >= 0 && primitive.material < (int32_t)m_Materials.size() ? m_Materials[primitive.material] : nullptr;
+		};
+
+		// The scene may have several roots, so they hang from a node named after the file
+		createNode(Model::NO_NODE, Files::getName(m_File, true), Matrix4(1.0f));
+
+		struct PendingNode {
+			uint32_t index;
+			Model::NodeIndex parent;
+		};
+
+		ArrayList<PendingNode> pending;
+		for(auto it = roots.rbegin();it != roots.rend();++it) {
+			pending.push_back({*it, Model::ROOT});
+		}
+
+		while(!pending.empty()) {
+
+			const PendingNode current = pending.back();
+			pending.pop_back();
+
+			const Json& gltfNode = nodes[current.index];
+
+			String name = gltfNode.contains("name") ? gltfNode["name"].get<String>() : "Node" + str(current.index);
+			const Model::NodeIndex node = createNode(current.parent, std::move(name), nodeTransform(gltfNode));
+
+			// A single primitive goes in the node itself. Several primitives go in one child each, relative to the node
+			const uint32_t primitiveCount = primitiveCountOf(gltfNode);
+			if(primitiveCount > 0) {
+				const uint32_t first = m_FirstPrimitives[gltfNode["mesh"].get<uint32_t>()];
+				if(primitiveCount == 1) {
+					setNodeMesh(outModel, node, m_Meshes[first], materialOf(m_Primitives[first]));
+				} else {
+					for(uint32_t i = 0;i < primitiveCount;++i) {
+						const Model::NodeIndex child = createNode(node, outModel->nodeName(node) + "[" + str(i) + "]", Matrix4(1.0f));
+						setNodeMesh(outModel, child, m_Meshes[first + i], materialOf(m_Primitives[first + i]));
+					}
+				}
+			}
+
+			// Pushed in reverse, so children are created in order
+			if(gltfNode.contains("children")) {
+				const Json& children = gltfNode["children"];
+				for(size_t i = children.size();i > 0;--i) {
+					pending.push_back({children[i - 1].get<uint32_t>(), node});
+				}
+			}
+		}
+	}
+}
\ No newline at end of file
@@ -4,13 +4,26 @@
 
 namespace milo {
 
-	SPIRVCompiler::SPIRVCompiler() {
-		m_Compiler = shaderc_compiler_initialize();
-	}
+	struct ThreadCompiler {
+
+		shaderc_compiler_t compiler{nullptr};
+		shaderc_compile_options_t options{nullptr};
 
-	SPIRVCompiler::~SPIRVCompiler() {
-		shaderc_compiler_release(m_Compiler);
-		m_Compiler = nullptr;
+		ThreadCompiler() {
+			compiler = shaderc_compiler_initialize();
+			options = shaderc_compile_options_initialize();
+			shaderc_compile_options_set_source_language(options, shaderc_source_language_glsl);
+		}
+
+		~ThreadCompiler() {
+			shaderc_compile_options_release(options);
+			shaderc_compiler_release(compiler);
+		}
+	};
+
+	static ThreadCompiler& threadCompiler() {
+		thread_local ThreadCompiler compiler;
+		return compiler;
 	}
 
 	inline static shaderc_shader_kind toShaderKind(Shader::Type type) {
@@ -26,19 +39,21 @@ namespace milo {
 	}
 
 	SPIRV SPIRVCompiler::compile(const String& filename, Shader::Type type) {
+		return compile(filename, Files::readAllText(filename), type);
+	}
 
-		float start = Time::millis();
+	SPIRV SPIRVCompiler::compile(const String& filename, const String& source, Shader::Type type) {
 
-		String srcCode = Files::readAllText(filename);
+		float start = Time::millis();
 
-		shaderc_compile_options_t options = shaderc_compile_options_initialize();
-		shaderc_compile_options_set_source_language(options, shaderc_source_language_glsl);
+		ThreadCompiler& compiler = threadCompiler();
 
-		shaderc_compilation_result_t result = shaderc_compile_into_spv(m_Compiler, srcCode.c_str(), srcCode.size(),
-																	   toShaderKind(type), filename.c_str(), "main", options);
+		shaderc_compilation_result_t result = shaderc_compile_into_spv(compiler.compiler, source.c_str(), source.size(),
+																	   toShaderKind(type), filename.c_str(), "main", compiler.options);
 
 		if(shaderc_result_get_compilation_status(result) != shaderc_compilation_status_success) {
-			const char* errorMessage = shaderc_result_get_error_message(result);
+			const String errorMessage = shaderc_result_get_error_message(result);
+			shaderc_result_release(result);
 			throw MILO_RUNTIME_EXCEPTION(str("Failed to compile shader ") + filename + ": " + errorMessage);
 		}
 
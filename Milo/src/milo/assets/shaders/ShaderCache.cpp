@@ -0,0 +1,77 @@
+#include "milo/assets/shaders/ShaderCache.h"
+#include "milo/io/Files.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	static const uint32_t SHADER_CACHE_MAGIC = 0x5650534D; // MSPV
+	static const uint32_t SHADER_CACHE_VERSION = 1;
+
+	uint64_t ShaderCache::keyOf(const String& source, Shader::Type type) {
+		uint64_t key = stableHash(source.data(), source.size());
+		key = stableHashValue(type, key);
+		return key;
+	}
+
+	String ShaderCache::filenameOf(const String& shaderFilename) {
+
+		const String path = Files::toAbsolutePath(shaderFilename);
+
+		// Shaders under the resources directory keep their relative path, so cooked caches can be shipped with them
+		std::error_code error;
+		String name = std::filesystem::relative(path, Files::toAbsolutePath(Files::resource("")), error).generic_string();
+
+		if(error || name.empty() || name.rfind("..", 0) == 0) {
+			char hash[32];
+			snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)stableHash(path.data(), path.size()));
+			name = str("external/") + hash + Files::extension(path);
+		}
+
+		return Files::resource(str("cache/shaders/") + name + ".spv");
+	}
+
+	bool ShaderCache::load(const String& shaderFilename, uint64_t key, ArrayList<int8>& spirv) {
+
+		const String filename = filenameOf(shaderFilename);
+
+		if(!Files::exists(filename)) return false;
+
+		InputStream input(filename, std::ios::binary);
+
+		uint32_t header[2]{};
+		uint64_t storedKey = 0;
+		uint64_t size = 0;
+		input.read((char*)header, sizeof(header));
+		input.read((char*)&storedKey, sizeof(storedKey));
+		input.read((char*)&size, sizeof(size));
+
+		// Outdated entries are expected after editing a shader, they are simply compiled and written again
+		if(!input || header[0] != SHADER_CACHE_MAGIC || header[1] != SHADER_CACHE_VERSION || storedKey != key) {
+			return false;
+		}
+
+		spirv.resize(size);
+		input.read((char*)spirv.data(), (std::streamsize)size);
+
+		if(!input || size % sizeof(uint32_t) != 0) {
+			Log::warn("Ignoring corrupted shader cache {}", filename);
+			spirv.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	void ShaderCache::save(const String& shaderFilename, uint64_t key, const byte_t* spirv, size_t length) {
+
+		Files::writeAtomically(filenameOf(shaderFilename), [&](OutputStream& output) {
+
+			const uint32_t header[2] = {SHADER_CACHE_MAGIC, SHADER_CACHE_VERSION};
+			const uint64_t size = length;
+			output.write((const char*)header, sizeof(header));
+			output.write((const char*)&key, sizeof(key));
+			output.write((const char*)&size, sizeof(size));
+			output.write((const char*)spirv, (std::streamsize)length);
+		});
+	}
+}
\ No newline at end of file
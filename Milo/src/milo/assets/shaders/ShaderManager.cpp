@@ -1,13 +1,14 @@
 #include "milo/assets/shaders/ShaderManager.h"
 #include "milo/graphics/Graphics.h"
 #include "milo/graphics/vulkan/shaders/VulkanShader.h"
+#include "milo/assets/shaders/ShaderCache.h"
+#include "milo/common/JobSystem.h"
 #include "milo/logging/Log.h"
 
 namespace milo {
 
 	ShaderManager::ShaderManager() {
 		m_Shaders.reserve(64);
-		//loadCachedShaders();
 	}
 
 	ShaderManager::~ShaderManager() {
@@ -23,7 +24,6 @@ namespace milo {
 		{
 			shader = createShader(filename);
 			m_Shaders[filename] = shader;
-			//createShaderCache(filename, shader);
 		}
 		m_Mutex.unlock();
 		return shader;
@@ -49,35 +49,78 @@ namespace milo {
 		m_Mutex.unlock();
 	}
 
-	Shader* ShaderManager::createShader(const String& filename) {
+	ArrayList<String> ShaderManager::namesOf(const String& path) const {
+		ArrayList<String> names;
+		for(const auto& [name, shader] : m_Shaders) {
+			if(Files::toAbsolutePath(sourceFilenameOf(name)) == path) names.push_back(name);
+		}
+		return names;
+	}
 
-		Shader::Type type = getShaderTypeByFilename(filename);
+	Shader* ShaderManager::compile(const String& filename) {
+		return createShader(filename);
+	}
 
-		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
+	void ShaderManager::replace(const String& filename, Shader* shader) {
+		m_Mutex.lock();
+		{
+			auto it = m_Shaders.find(filename);
+			if(it != m_Shaders.end()) DELETE_PTR(it->second);
+			m_Shaders[filename] = shader;
+		}
+		m_Mutex.unlock();
+	}
 
-			SPIRV spirv = m_SPIRVCompiler.compile(filename, type);
+	void ShaderManager::compileAll(const ArrayList<String>& filenames) {
 
-			size_t length = spirv.length();
-			byte_t* bytecode = new byte_t[length];
-			memcpy(bytecode, spirv.code(), length);
+		float start = Time::millis();
 
-			return new VulkanShader(filename, type, bytecode, length);
+		ArrayList<String> pending;
+		for(const String& filename : filenames) {
+			if(!exists(filename)) pending.push_back(filename);
 		}
 
-		throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
+		ArrayList<Shader*> shaders(pending.size(), nullptr);
+
+		JobSystem::parallelFor(pending.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				try {
+					shaders[i] = createShader(pending[i]);
+				} catch(const Exception& e) {
+					Log::warn("Skipping shader {}: {}", pending[i], e.what());
+				}
+			}
+		});
+
+		size_t count = 0;
+		m_Mutex.lock();
+		{
+			for(size_t i = 0;i < pending.size();++i) {
+				if(shaders[i] == nullptr) continue;
+				if(exists(pending[i])) {
+					DELETE_PTR(shaders[i]);
+				} else {
+					m_Shaders[pending[i]] = shaders[i];
+					++count;
+				}
+			}
+		}
+		m_Mutex.unlock();
+
+		Log::debug("{} shaders loaded in {} ms", count, Time::millis() - start);
 	}
 
-	Shader* ShaderManager::loadCache(const String& originalFilename, const String& filename) {
+	Shader* ShaderManager::createShader(const String& filename) {
 
-		Shader::Type type = getShaderTypeByFilename(originalFilename);
+		Shader::Type type = getShaderTypeByFilename(filename);
 
 		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
 
-			const auto& bytes = Files::readAllBytes(filename);
+			ArrayList<int8> spirv = compileSPIRV(filename);
 
-			size_t length = bytes.size();
+			size_t length = spirv.size();
 			byte_t* bytecode = new byte_t[length];
-			memcpy(bytecode, bytes.data(), length);
+			memcpy(bytecode, spirv.data(), length);
 
 			return new VulkanShader(filename, type, bytecode, length);
 		}
@@ -85,38 +128,78 @@ namespace milo {
 		throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
 	}
 
-	void ShaderManager::loadCachedShaders() {
-		static const String CACHE_DIR = Files::resource("cache/shaders");
-		if(!Files::exists(CACHE_DIR)) return;
+	ArrayList<int8> ShaderManager::compileSPIRV(const String& filename, bool useCache, bool* cached) {
 
-		Log::info("Loading shader cache...");
+		const Shader::Type type = getShaderTypeByFilename(filename);
+		const String source = preprocess(filename, Files::readAllText(sourceFilenameOf(filename)));
+		const uint64_t key = ShaderCache::keyOf(source, type);
 
-		ArrayList<String> cacheFiles = Files::listFiles(CACHE_DIR);
+		ArrayList<int8> spirv;
 
-		for(const String& cacheFile : cacheFiles) {
-			const String filename = getFilenameFromCache(cacheFile);
-			auto start = Time::millis();
-			m_Shaders[filename] = loadCache(filename, cacheFile);
-			Log::debug("Shader cache of {} loaded ({} ms)", Files::getName(filename), Time::millis() - start);
+		if(useCache && ShaderCache::load(filename, key, spirv)) {
+			if(cached != nullptr) *cached = true;
+			return spirv;
 		}
+
+		SPIRVCompiler compiler;
+		SPIRV result = compiler.compile(filename, source, type);
+
+		spirv.resize(result.length());
+		memcpy(spirv.data(), result.code(), result.length());
+
+		ShaderCache::save(filename, key, result.code(), result.length());
+
+		if(cached != nullptr) *cached = false;
+		return spirv;
 	}
 
-	void ShaderManager::createShaderCache(const String& filename, Shader* shader) {
-		static const size_t RESOURCE_PREFIX_LENGTH = strlen("resources/");
+	String ShaderManager::sourceFilenameOf(const String& name) {
+		return name.substr(0, name.find('#'));
+	}
 
-		String cacheFile = Files::resource("cache/" + filename.substr(RESOURCE_PREFIX_LENGTH) + ".cache");
+	String ShaderManager::preprocess(const String& name, const String& source) {
 
-		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
-			VulkanShader* vulkanShader = dynamic_cast<VulkanShader*>(shader);
-			Files::writeAllBytes(cacheFile, vulkanShader->m_Bytecode, vulkanShader->m_BytecodeLength);
-		} else {
-			throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
+		size_t separator = name.find('#');
+		if(separator == String::npos) return source;
+
+		String defines;
+		while(separator != String::npos) {
+			const size_t next = name.find('#', separator + 1);
+			defines += str("#define ") + name.substr(separator + 1, next - separator - 1) + "\n";
+			separator = next;
+		}
+
+		// The directive has to stay the first statement of the source
+		const size_t version = source.find("#version");
+		if(version == String::npos) return defines + source;
+
+		const size_t lineEnd = source.find('\n', version);
+		if(lineEnd == String::npos) return source + "\n" + defines;
+
+		// Keeps the line numbers of the compile errors those of the file
+		const size_t nextLine = std::count(source.begin(), source.begin() + lineEnd + 1, '\n') + 1;
+		defines += str("#line ") + std::to_string(nextLine) + "\n";
+
+		return source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1);
+	}
+
+	ArrayList<String> ShaderManager::findShaders(const String& directory) {
+		ArrayList<String> shaders;
+		for(const String& filename : Files::listFiles(directory)) {
+			if(isShaderFile(filename)) shaders.push_back(filename);
 		}
+		return shaders;
+	}
+
+	bool ShaderManager::isShaderFile(const String& filename) {
+		const String extension = Files::extension(filename);
+		return extension == ".vert" || extension == ".frag" || extension == ".geo"
+			|| extension == ".comp" || extension == ".tesc" || extension == ".tese";
 	}
 
 	Shader::Type ShaderManager::getShaderTypeByFilename(const String& filename) {
 
-		const String extension = Files::extension(filename);
+		const String extension = Files::extension(sourceFilenameOf(filename));
 
 		if(extension == ".vert") return Shader::Type::Vertex;
 		if(extension == ".frag") return Shader::Type::Fragment;
@@ -127,11 +210,4 @@ namespace milo {
 
 		throw MILO_RUNTIME_EXCEPTION(fmt::format("Unknown shader extension '{}' of {}", extension, filename));
 	}
-
-	String ShaderManager::getFilenameFromCache(const String& cacheFilename) {
-		static const size_t CACHE_EXTENSION_LENGTH = strlen(".cache");
-		static const Regex REGEX{R"(cache/)"};
-		String filename = cacheFilename.substr(0, cacheFilename.length() - CACHE_EXTENSION_LENGTH);
-		return replace(filename, REGEX, "");
-	}
 }
\ No newline at end of file
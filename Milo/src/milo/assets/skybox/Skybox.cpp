@@ -12,7 +12,6 @@ namespace milo {
 		DELETE_PTR(m_EnvironmentMap);
 		DELETE_PTR(m_PrefilterMap);
 		DELETE_PTR(m_IrradianceMap);
-		DELETE_PTR(m_BRDFMap);
 	}
 
 	Ref<Texture2D> Skybox::equirectangularTexture() const {
@@ -57,6 +56,10 @@ namespace milo {
 		return m_Modifications;
 	}
 
+	bool Skybox::ready() const {
+		return m_Ready;
+	}
+
 	// =======================
 
 	PreethamSky::PreethamSky(const String& name) : Skybox(name, "") {
@@ -100,13 +103,71 @@ namespace milo {
 		return this;
 	}
 
+	Vector3 PreethamSky::sunDirection() const {
+		return sunDirection(m_Azimuth, m_Inclination);
+	}
+
 	bool PreethamSky::dirty() const {
 		return m_Dirty;
 	}
 
 	void PreethamSky::update() {
-		Assets::skybox().updatePreethamSky(this);
-		++m_Modifications;
+		// Regenerated even if nothing changed
+		m_Dirty = true;
+		PreethamSkyUpdateRequest request{};
+		takeUpdateRequest(request);
+		Assets::skybox().updatePreethamSky(request);
+	}
+
+	bool PreethamSky::takeUpdateRequest(PreethamSkyUpdateRequest& request) {
+		if(!m_Dirty) return false;
+		request.sky = this;
+		request.turbidity = m_Turbidity;
+		request.azimuth = m_Azimuth;
+		request.inclination = m_Inclination;
+		request.updateMode = m_UpdateMode;
 		m_Dirty = false;
+		return true;
+	}
+
+	PreethamSkyUpdateMode PreethamSky::updateMode() const {
+		return m_UpdateMode;
+	}
+
+	PreethamSky* PreethamSky::updateMode(PreethamSkyUpdateMode mode) {
+		m_UpdateMode = mode;
+		return this;
+	}
+
+	uint32_t PreethamSky::facesPerFrame() const {
+		return m_FacesPerFrame;
+	}
+
+	PreethamSky* PreethamSky::facesPerFrame(uint32_t value) {
+		m_FacesPerFrame = std::max(value, 1u);
+		return this;
+	}
+
+	float PreethamSky::minSunAngleDelta() const {
+		return m_MinSunAngleDelta;
+	}
+
+	PreethamSky* PreethamSky::minSunAngleDelta(float value) {
+		m_MinSunAngleDelta = std::max(value, 0.0f);
+		return this;
+	}
+
+	float PreethamSky::animationResolutionScale() const {
+		return m_AnimationResolutionScale;
+	}
+
+	PreethamSky* PreethamSky::animationResolutionScale(float value) {
+		m_AnimationResolutionScale = std::clamp(value, 0.0f, 1.0f);
+		return this;
+	}
+
+	Vector3 PreethamSky::sunDirection(float azimuth, float inclination) {
+		// Same as preetham_sky.comp
+		return normalize(Vector3(sin(inclination) * cos(azimuth), cos(inclination), sin(inclination) * sin(azimuth)));
 	}
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "milo/assets/skybox/SkyboxCache.h"
+#include "milo/io/Files.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	static const uint32_t SKYBOX_CACHE_MAGIC = 0x594B534D; // MSKY
+	static const uint32_t SKYBOX_CACHE_VERSION = 1;
+
+	uint64_t SkyboxCache::keyOf(const String& imageFile, const SkyboxLoadInfo& loadInfo) {
+
+		ArrayList<int8> contents = Files::readAllBytes(imageFile);
+
+		uint64_t key = stableHash(contents.data(), contents.size());
+		key = stableHashValue(loadInfo.environmentMapSize, key);
+		key = stableHashValue(loadInfo.irradianceMapSize, key);
+		key = stableHashValue(loadInfo.prefilterMapSize, key);
+		key = stableHashValue(loadInfo.maxLOD, key);
+
+		return key;
+	}
+
+	String SkyboxCache::filenameOf(uint64_t key) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.skybox", (unsigned long long)key);
+		return Files::resource(str("cache/skyboxes/") + name);
+	}
+
+	static void writeImage(OutputStream& output, const SkyboxCacheImage& image) {
+		const uint32_t header[5] = {(uint32_t)image.format, image.width, image.height, image.layers, image.mipLevels};
+		const uint64_t size = image.data.size();
+		output.write((const char*)header, sizeof(header));
+		output.write((const char*)&size, sizeof(size));
+		output.write((const char*)image.data.data(), (std::streamsize)size);
+	}
+
+	static bool readImage(InputStream& input, SkyboxCacheImage& image) {
+		uint32_t header[5]{};
+		uint64_t size = 0;
+		input.read((char*)header, sizeof(header));
+		input.read((char*)&size, sizeof(size));
+		if(!input) return false;
+		image.format = (PixelFormat)header[0];
+		image.width = header[1];
+		image.height = header[2];
+		image.layers = header[3];
+		image.mipLevels = header[4];
+		image.data.resize(size);
+		input.read((char*)image.data.data(), (std::streamsize)size);
+		return (bool)input;
+	}
+
+	bool SkyboxCache::load(uint64_t key, SkyboxCacheData& data) {
+
+		const String filename = filenameOf(key);
+
+		if(!Files::exists(filename)) return false;
+
+		InputStream input(filename, std::ios::binary);
+
+		uint32_t header[2]{};
+		uint64_t storedKey = 0;
+		input.read((char*)header, sizeof(header));
+		input.read((char*)&storedKey, sizeof(storedKey));
+
+		if(!input || header[0] != SKYBOX_CACHE_MAGIC || header[1] != SKYBOX_CACHE_VERSION || storedKey != key) {
+			Log::warn("Ignoring outdated skybox cache {}", filename);
+			return false;
+		}
+
+		if(!readImage(input, data.environmentMap) || !readImage(input, data.irradianceMap)
+		   || !readImage(input, data.prefilterMap) || !readImage(input, data.thumbnail)) {
+			Log::warn("Ignoring corrupted skybox cache {}", filename);
+			return false;
+		}
+
+		return true;
+	}
+
+	void SkyboxCache::save(uint64_t key, const SkyboxCacheData& data) {
+
+		Files::writeAtomically(filenameOf(key), [&](OutputStream& output) {
+
+			const uint32_t header[2] = {SKYBOX_CACHE_MAGIC, SKYBOX_CACHE_VERSION};
+			output.write((const char*)header, sizeof(header));
+			output.write((const char*)&key, sizeof(key));
+
+			writeImage(output, data.environmentMap);
+			writeImage(output, data.irradianceMap);
+			writeImage(output, data.prefilterMap);
+			writeImage(output, data.thumbnail);
+		});
+	}
+
+	SkyboxCacheImage SkyboxCache::createThumbnail(const Image& image, uint32_t width) {
+
+		if(image.format() != PixelFormat::RGBA32F) {
+			throw MILO_RUNTIME_EXCEPTION("Skybox thumbnails can only be created from RGBA32F images");
+		}
+
+		width = std::min(width, image.width());
+		const uint32_t height = std::max(width * image.height() / image.width(), 1u);
+
+		SkyboxCacheImage thumbnail{};
+		thumbnail.format = PixelFormat::RGBA32F;
+		thumbnail.width = width;
+		thumbnail.height = height;
+		thumbnail.data.resize((size_t)width * height * 4 * sizeof(float));
+
+		const auto* src = (const float*)image.pixels();
+		auto* dst = (float*)thumbnail.data.data();
+
+		// Box filter over the source pixels covered by each thumbnail pixel
+		for(uint32_t y = 0;y < height;++y) {
+			const uint32_t y0 = y * image.height() / height;
+			const uint32_t y1 = std::max((y + 1) * image.height() / height, y0 + 1);
+			for(uint32_t x = 0;x < width;++x) {
+				const uint32_t x0 = x * image.width() / width;
+				const uint32_t x1 = std::max((x + 1) * image.width() / width, x0 + 1);
+				float sum[4]{};
+				for(uint32_t sy = y0;sy < y1;++sy) {
+					for(uint32_t sx = x0;sx < x1;++sx) {
+						const float* pixel = src + ((size_t)sy * image.width() + sx) * 4;
+						for(uint32_t c = 0;c < 4;++c) sum[c] += pixel[c];
+					}
+				}
+				const float count = (float)((x1 - x0) * (y1 - y0));
+				float* pixel = dst + ((size_t)y * width + x) * 4;
+				for(uint32_t c = 0;c < 4;++c) pixel[c] = sum[c] / count;
+			}
+		}
+
+		return thumbnail;
+	}
+}
@@ -11,8 +11,10 @@ namespace milo {
 
 	SkyboxManager::~SkyboxManager() {
 		for(auto& [name, skybox] : m_Skyboxes) {
+			m_SkyboxFactory->await(skybox);
 			DELETE_PTR(skybox);
 		}
+		DELETE_PTR(m_SkyboxFactory);
 	}
 
 	void SkyboxManager::init() {
@@ -31,6 +33,8 @@ namespace milo {
 
 	Skybox* SkyboxManager::load(const String& name, const String& filename) {
 
+		MILO_MEMORY_TAG(MemoryTag::Assets);
+
 		if(exists(name)) return m_Skyboxes[name];
 
 		String extension = Files::extension(filename);
@@ -49,6 +53,19 @@ namespace milo {
 		return skybox;
 	}
 
+	Skybox* SkyboxManager::loadAsync(const String& name, const String& filename) {
+
+		MILO_MEMORY_TAG(MemoryTag::Assets);
+
+		if(exists(name)) return m_Skyboxes[name];
+
+		Skybox* skybox = m_SkyboxFactory->createAsync(name, filename);
+
+		m_Skyboxes[name] = skybox;
+
+		return skybox;
+	}
+
 	bool SkyboxManager::exists(const String& name) const {
 		return m_Skyboxes.find(name) != m_Skyboxes.end();
 	}
@@ -60,42 +77,22 @@ namespace milo {
 	void SkyboxManager::destroy(const String& name) {
 		if(!exists(name)) return;
 		Skybox* skybox = m_Skyboxes[name];
+		m_SkyboxFactory->await(skybox);
 		DELETE_PTR(skybox);
 		m_Skyboxes.erase(name);
 	}
 
-	void SkyboxManager::updatePreethamSky(PreethamSky* sky) {
-		if(sky == nullptr) return;
-		m_SkyboxFactory->updatePreethamSky(sky);
+	void SkyboxManager::updatePreethamSky(const PreethamSkyUpdateRequest& request) {
+		if(request.sky == nullptr) return;
+		m_SkyboxFactory->updatePreethamSky(request);
+	}
+
+	void SkyboxManager::update() {
+		m_SkyboxFactory->update();
 	}
 
 	void SkyboxManager::createPreethamSky() {
 		m_Skyboxes[PREETHAM_SKYBOX_NAME] = m_SkyboxFactory->createPreethamSky(PREETHAM_SKYBOX_NAME, SkyboxLoadInfo(), 2, 0, 0);
 		Log::debug("Created Preetham sky");
 	}
-
-	Skybox* SkyboxManager::createSkybox(const String& name, const String& filename) {
-		return nullptr;
-	}
-
-	Skybox* SkyboxManager::loadCache(const String& originalFilename, const String& cacheFilename) {
-		// TODO
-		return nullptr;
-	}
-
-	void SkyboxManager::loadCachedSkyboxes() {
-		// TODO
-	}
-
-	void SkyboxManager::createSkyboxCache(const String& filename, Skybox* skybox) {
-		// TODO
-	}
-
-	String SkyboxManager::getFilenameFromCache(const String& cacheFilename) {
-		return milo::String();
-	}
-
-	String SkyboxManager::getNameFromFilename(const String& cacheFilename) {
-		return milo::String();
-	}
 }
\ No newline at end of file
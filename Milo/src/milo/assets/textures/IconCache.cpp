@@ -0,0 +1,110 @@
+#include "milo/assets/textures/IconCache.h"
+#include "milo/assets/meshes/Mesh.h"
+#include "milo/assets/materials/Material.h"
+#include "milo/io/Files.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	static const uint32_t ICON_CACHE_MAGIC = 0x4F43494D; // MICO
+	static const uint32_t ICON_CACHE_VERSION = 1;
+
+	// Editing the image on disk changes the key. Textures without a file, like the white and black ones, go by their name
+	static bool hashTexture(const Ref<Texture2D>& texture, const String& file, uint64_t& hash) {
+		if(file.empty()) {
+			const String name = texture != nullptr ? texture->name() : "";
+			hash = stableHash(name.data(), name.size(), hash);
+			return true;
+		}
+		hash = stableHash(file.data(), file.size(), hash);
+		std::error_code error;
+		const auto modified = std::filesystem::last_write_time(file, error);
+		if(error) return false;
+		const auto fileSize = std::filesystem::file_size(file, error);
+		if(error) return false;
+		hash = stableHashValue(modified.time_since_epoch().count(), hash);
+		hash = stableHashValue(fileSize, hash);
+		return true;
+	}
+
+	bool IconCache::keyOf(const Mesh* mesh, const Material* material, const Size& size, const ArrayList<String>& textureFiles, uint64_t& key) {
+
+		key = stableHash(mesh->vertices().data(), mesh->vertices().size() * sizeof(Vertex));
+		key = stableHash(mesh->indices().data(), mesh->indices().size() * sizeof(uint32_t), key);
+
+		// Field by field, the padding of Material::Data is not initialized
+		const Material::Data& data = material->data();
+		key = stableHashValue(data.albedo, key);
+		key = stableHashValue(data.emissiveColor, key);
+		key = stableHashValue(data.alpha, key);
+		key = stableHashValue(data.metallic, key);
+		key = stableHashValue(data.roughness, key);
+		key = stableHashValue(data.occlusion, key);
+		key = stableHashValue(data.fresnel0, key);
+		key = stableHashValue(data.normalScale, key);
+		key = stableHashValue(data.useNormalMap, key);
+		key = stableHashValue(data.useCombinedMetallicRoughness, key);
+
+		const Ref<Texture2D> textures[] = {
+				material->albedoMap(), material->emissiveMap(), material->normalMap(), material->metallicMap(),
+				material->roughnessMap(), material->metallicRoughnessMap(), material->occlusionMap()
+		};
+
+		for(size_t i = 0;i < textureFiles.size();++i) {
+			if(!hashTexture(textures[i], textureFiles[i], key)) return false;
+		}
+
+		key = stableHashValue(size.width, key);
+		key = stableHashValue(size.height, key);
+
+		return true;
+	}
+
+	String IconCache::filenameOf(uint64_t key) {
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.icon", (unsigned long long)key);
+		return Files::resource(str("cache/icons/") + name);
+	}
+
+	bool IconCache::load(uint64_t key, const Size& size, ArrayList<int8>& pixels) {
+
+		const String filename = filenameOf(key);
+
+		if(!Files::exists(filename)) return false;
+
+		InputStream input(filename, std::ios::binary);
+
+		uint32_t header[4]{};
+		uint64_t storedKey = 0;
+		input.read((char*)header, sizeof(header));
+		input.read((char*)&storedKey, sizeof(storedKey));
+
+		if(!input || header[0] != ICON_CACHE_MAGIC || header[1] != ICON_CACHE_VERSION || storedKey != key
+		   || header[2] != (uint32_t)size.width || header[3] != (uint32_t)size.height) {
+			Log::warn("Ignoring outdated icon cache {}", filename);
+			return false;
+		}
+
+		pixels.resize((size_t)size.width * size.height * 4);
+		input.read((char*)pixels.data(), (std::streamsize)pixels.size());
+
+		if(!input) {
+			Log::warn("Ignoring corrupted icon cache {}", filename);
+			pixels.clear();
+			return false;
+		}
+
+		return true;
+	}
+
+	void IconCache::save(uint64_t key, const Size& size, const ArrayList<int8>& pixels) {
+
+		Files::writeAtomically(filenameOf(key), [&](OutputStream& output) {
+
+			const uint32_t header[4] = {ICON_CACHE_MAGIC, ICON_CACHE_VERSION, (uint32_t)size.width, (uint32_t)size.height};
+			output.write((const char*)header, sizeof(header));
+			output.write((const char*)&key, sizeof(key));
+			output.write((const char*)pixels.data(), (std::streamsize)pixels.size());
+		});
+	}
+}
\ No newline at end of file
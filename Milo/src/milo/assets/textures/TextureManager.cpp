@@ -1,8 +1,12 @@
 #include "milo/assets/textures/TextureManager.h"
+#include "milo/assets/textures/IconCache.h"
+#include "milo/assets/materials/Material.h"
 #include "milo/graphics/Graphics.h"
 #include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
 #include "milo/graphics/vulkan/textures/VulkanIconFactory.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/common/JobSystem.h"
+#include <unordered_set>
 #include <imgui/imgui.h>
 #include <imgui/imgui_impl_vulkan.h>
 
@@ -12,6 +16,10 @@ namespace milo {
 	}
 
 	TextureManager::~TextureManager() {
+		for(Future<void>& cacheWrite : m_IconCacheWrites) {
+			cacheWrite.wait();
+		}
+		m_IconAtlases.clear();
 		DELETE_PTR(m_IconFactory);
 	}
 
@@ -57,10 +65,98 @@ namespace milo {
 
 	Ref<Texture2D> TextureManager::load(const String& filename, PixelFormat format, bool flipY, uint32_t mipLevels) {
 
-		if(m_Cache.find(filename) != m_Cache.end())
-			return m_Cache.at(filename);
+		MILO_MEMORY_TAG(MemoryTag::Assets);
+
+		const String key = Files::toAbsolutePath(filename);
+
+		auto cached = m_Cache.find(key);
+		if(cached != m_Cache.end()) return cached->second;
+
+		m_FileInfos[key] = {format, flipY, mipLevels};
+
+		return createTexture(filename, Image::loadImage(filename, format, flipY), mipLevels);
+	}
+
+	ArrayList<Ref<Texture2D>> TextureManager::load(const ArrayList<String>& filenames, PixelFormat format, bool flipY, uint32_t mipLevels) {
+		for(const String& filename : filenames) {
+			const String key = Files::toAbsolutePath(filename);
+			if(m_Cache.find(key) == m_Cache.end()) m_FileInfos[key] = {format, flipY, mipLevels};
+		}
+		return decodeAll(filenames, [&](size_t i) {
+			return Image::loadImage(filenames[i], format, flipY);
+		}, mipLevels);
+	}
+
+	ArrayList<Ref<Texture2D>> TextureManager::load(const ArrayList<EncodedImage>& images, PixelFormat format, bool flipY, uint32_t mipLevels) {
+
+		ArrayList<String> names;
+		names.reserve(images.size());
+		for(const EncodedImage& image : images) {
+			names.push_back(image.name);
+		}
+
+		return decodeAll(names, [&](size_t i) {
+			return Image::decode(images[i].data, images[i].size, format, flipY);
+		}, mipLevels);
+	}
+
+	ArrayList<Ref<Texture2D>> TextureManager::decodeAll(const ArrayList<String>& names, const Function<Image*, size_t>& decode, uint32_t mipLevels) {
+
+		MILO_MEMORY_TAG(MemoryTag::Assets);
+
+		ArrayList<String> keys;
+		keys.reserve(names.size());
+		for(const String& name : names) {
+			keys.push_back(Files::toAbsolutePath(name));
+		}
+
+		// Each image is decoded once, even if it is repeated
+		std::unordered_set<String> pendingKeys;
+		ArrayList<size_t> pending;
+		for(size_t i = 0;i < names.size();++i) {
+			if(m_Cache.find(keys[i]) != m_Cache.end()) continue;
+			if(pendingKeys.insert(keys[i]).second) {
+				pending.push_back(i);
+			}
+		}
+
+		ArrayList<Image*> images(pending.size(), nullptr);
+		std::exception_ptr error = nullptr;
+		Mutex errorMutex;
+
+		JobSystem::parallelFor(pending.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				try {
+					images[i] = decode(pending[i]);
+				} catch(ANY_EXCEPTION) {
+					std::lock_guard<Mutex> lock(errorMutex);
+					if(error == nullptr) error = std::current_exception();
+				}
+			}
+		});
+
+		if(error != nullptr) {
+			for(Image* image : images) {
+				DELETE_PTR(image);
+			}
+			std::rethrow_exception(error);
+		}
+
+		// Uploads stay on this thread, in the order of the images
+		for(size_t i = 0;i < pending.size();++i) {
+			createTexture(names[pending[i]], images[i], mipLevels);
+		}
+
+		ArrayList<Ref<Texture2D>> textures;
+		textures.reserve(names.size());
+		for(const String& key : keys) {
+			textures.push_back(m_Cache.at(key));
+		}
 
-		Image* image = Image::loadImage(filename, format, flipY);
+		return textures;
+	}
+
+	Ref<Texture2D> TextureManager::createTexture(const String& filename, Image* image, uint32_t mipLevels) {
 
 		Texture2D* texture = Texture2D::create();
 
@@ -85,22 +181,178 @@ namespace milo {
 		return result;
 	}
 
-	Ref<Texture2D> TextureManager::getIcon(const String &name) const {
-		return m_Icons.find(name) != m_Icons.end() ? m_Icons.at(name) : nullptr;
+	Icon TextureManager::getIcon(const String& name) {
+
+		std::lock_guard<Mutex> lock(m_IconMutex);
+
+		auto it = m_Icons.find(name);
+		if(it != m_Icons.end()) return it->second;
+
+		auto source = m_IconSources.find(name);
+		if(source == m_IconSources.end()) return {};
+
+		if(!source->second.requested) {
+			source->second.requested = true;
+			m_IconRequests.push_back(name);
+		}
+
+		auto fallback = m_Icons.find(source->second.fallback);
+
+		return fallback != m_Icons.end() ? fallback->second : Icon{};
+	}
+
+	void TextureManager::addIcon(const String& name, Ref<Texture2D> texture) {
+		Icon icon{};
+		icon.size = texture->size();
+		icon.texture = std::move(texture);
+		addIcon(name, icon);
 	}
 
-	void TextureManager::addIcon(const String &name, Ref<Texture2D> texture) {
-		m_Icons[name] = texture;
+	void TextureManager::addIcon(const String& name, const Icon& icon) {
+		std::lock_guard<Mutex> lock(m_IconMutex);
+		m_Icons[name] = icon;
 	}
 
 	void TextureManager::removeIcon(const String& name) {
+		std::lock_guard<Mutex> lock(m_IconMutex);
 		m_Icons.erase(name);
+		m_IconSources.erase(name);
+		freeIconSlot(name);
 	}
 
-	Ref<Texture2D> TextureManager::createIcon(const String &name, Mesh *mesh, Material *material) {
-		Ref<Texture2D> icon = Ref<Texture2D>(m_IconFactory->createIcon(mesh, material));
-		addIcon(name, icon);
-		return icon;
+	void TextureManager::registerIcon(const String& name, Mesh* mesh, Material* material, const String& fallback) {
+
+		std::lock_guard<Mutex> lock(m_IconMutex);
+
+		IconSource& source = m_IconSources[name];
+		source.mesh = mesh;
+		source.material = material;
+		source.fallback = fallback;
+
+		// The contents changed, so the icon is baked again the next time it is shown
+		if(m_Icons.erase(name) > 0) {
+			source.requested = false;
+		}
+	}
+
+	void TextureManager::update() {
+
+		std::lock_guard<Mutex> lock(m_IconMutex);
+
+		auto isWritten = [](const Future<void>& future) {
+			return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		};
+		m_IconCacheWrites.erase(std::remove_if(m_IconCacheWrites.begin(), m_IconCacheWrites.end(), isWritten), m_IconCacheWrites.end());
+
+		if(m_IconRequests.empty()) return;
+
+		struct IconBatch {
+			ArrayList<IconBakeInfo> icons;
+			ArrayList<String> names;
+			ArrayList<uint64_t> keys;
+			ArrayList<bool> cached;
+			ArrayList<bool> cacheable;
+		};
+
+		const uint32_t columns = ICON_ATLAS_SIZE.width / DEFAULT_ICON_SIZE.width;
+		const uint32_t iconsPerAtlas = columns * (ICON_ATLAS_SIZE.height / DEFAULT_ICON_SIZE.height);
+
+		HashMap<uint32_t, IconBatch> batches;
+
+		for(const String& name : m_IconRequests) {
+
+			auto source = m_IconSources.find(name);
+			// Removed or registered again after the request
+			if(source == m_IconSources.end() || !source->second.requested) continue;
+
+			const uint32_t slot = allocateIconSlot(name);
+			const uint32_t atlasIndex = slot / iconsPerAtlas;
+			const uint32_t atlasSlot = slot % iconsPerAtlas;
+
+			while(atlasIndex >= m_IconAtlases.size()) {
+				Texture2D* atlas = m_IconFactory->createAtlas(ICON_ATLAS_SIZE);
+				atlas->setName(str("IconAtlas") + str(m_IconAtlases.size()));
+				m_IconAtlases.push_back(Ref<Texture2D>(atlas));
+			}
+
+			IconBakeInfo info{};
+			info.mesh = source->second.mesh;
+			info.material = source->second.material;
+			info.x = (atlasSlot % columns) * DEFAULT_ICON_SIZE.width;
+			info.y = (atlasSlot / columns) * DEFAULT_ICON_SIZE.height;
+
+			// Icons whose textures cannot be checked for changes are baked every time
+			ArrayList<String> textureFiles;
+			uint64_t key = 0;
+			const bool cacheable = sourceFilesOf(info.material, textureFiles)
+					&& IconCache::keyOf(info.mesh, info.material, DEFAULT_ICON_SIZE, textureFiles, key);
+			const bool cached = cacheable && IconCache::load(key, DEFAULT_ICON_SIZE, info.pixels);
+
+			IconBatch& batch = batches[atlasIndex];
+			batch.icons.push_back(std::move(info));
+			batch.names.push_back(name);
+			batch.keys.push_back(key);
+			batch.cached.push_back(cached);
+			batch.cacheable.push_back(cacheable);
+		}
+
+		m_IconRequests.clear();
+
+		for(auto& [atlasIndex, batch] : batches) {
+
+			const Ref<Texture2D>& atlas = m_IconAtlases[atlasIndex];
+
+			m_IconFactory->bakeIcons(atlas.get(), DEFAULT_ICON_SIZE, batch.icons);
+
+			for(size_t i = 0;i < batch.icons.size();++i) {
+
+				IconBakeInfo& info = batch.icons[i];
+
+				Icon icon{};
+				icon.texture = atlas;
+				icon.size = DEFAULT_ICON_SIZE;
+				icon.uv0 = {(float)info.x / (float)ICON_ATLAS_SIZE.width, (float)info.y / (float)ICON_ATLAS_SIZE.height};
+				icon.uv1 = {(float)(info.x + DEFAULT_ICON_SIZE.width) / (float)ICON_ATLAS_SIZE.width,
+							(float)(info.y + DEFAULT_ICON_SIZE.height) / (float)ICON_ATLAS_SIZE.height};
+
+				m_Icons[batch.names[i]] = icon;
+
+				if(batch.cached[i] || !batch.cacheable[i] || info.pixels.empty()) continue;
+
+				m_IconCacheWrites.push_back(std::async(std::launch::async, [key = batch.keys[i], pixels = std::move(info.pixels)]() {
+					IconCache::save(key, DEFAULT_ICON_SIZE, pixels);
+				}));
+			}
+		}
+	}
+
+	bool TextureManager::sourceFilesOf(const Material* material, ArrayList<String>& files) const {
+
+		const Ref<Texture2D> textures[] = {
+				material->albedoMap(), material->emissiveMap(), material->normalMap(), material->metallicMap(),
+				material->roughnessMap(), material->metallicRoughnessMap(), material->occlusionMap()
+		};
+
+		files.clear();
+
+		for(const Ref<Texture2D>& texture : textures) {
+
+			if(texture == nullptr || texture == m_WhiteTexture || texture == m_BlackTexture) {
+				files.emplace_back();
+				continue;
+			}
+
+			// The name of a texture may be anything its loader chose, so the file is the key it is cached by
+			auto it = std::find_if(m_Cache.begin(), m_Cache.end(), [&](const auto& entry) {
+				return entry.second == texture && m_FileInfos.find(entry.first) != m_FileInfos.end();
+			});
+
+			if(it == m_Cache.end()) return false;
+
+			files.push_back(it->first);
+		}
+
+		return true;
 	}
 
 	uint32_t TextureManager::nextTextureId() {
@@ -146,6 +398,31 @@ namespace milo {
 		// TODO
 	}
 
+	uint32_t TextureManager::allocateIconSlot(const String& name) {
+
+		auto it = m_IconSlots.find(name);
+		if(it != m_IconSlots.end()) return it->second;
+
+		uint32_t slot;
+		if(m_FreeIconSlots.empty()) {
+			slot = m_NextIconSlot++;
+		} else {
+			slot = m_FreeIconSlots.back();
+			m_FreeIconSlots.pop_back();
+		}
+
+		m_IconSlots[name] = slot;
+
+		return slot;
+	}
+
+	void TextureManager::freeIconSlot(const String& name) {
+		auto it = m_IconSlots.find(name);
+		if(it == m_IconSlots.end()) return;
+		m_FreeIconSlots.push_back(it->second);
+		m_IconSlots.erase(it);
+	}
+
 	Texture2D* TextureManager::createWhiteTexture() {
 
 		Texture2D* texture = Texture2D::create();
@@ -0,0 +1,148 @@
+#include "milo/common/FrameAllocator.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	static inline size_t alignUp(size_t value, size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	LinearArena::LinearArena(size_t capacity) : m_Capacity(capacity) {
+		m_Data = (int8_t*) malloc(capacity);
+		if(m_Data == nullptr) throw BadAllocationException();
+	}
+
+	LinearArena::~LinearArena() {
+		releaseOverflowBlocks();
+		free(m_Data);
+		m_Data = nullptr;
+	}
+
+	void* LinearArena::allocate(size_t size, size_t alignment) {
+
+		if(size == 0) size = 1;
+
+		size_t offset = m_Offset.load(std::memory_order_relaxed);
+		size_t alignedOffset;
+		size_t newOffset;
+
+		do {
+			alignedOffset = alignUp((size_t)m_Data + offset, alignment) - (size_t)m_Data;
+			newOffset = alignedOffset + size;
+			if(newOffset > m_Capacity) return allocateOverflow(size, alignment);
+		} while(!m_Offset.compare_exchange_weak(offset, newOffset, std::memory_order_relaxed));
+
+		return m_Data + alignedOffset;
+	}
+
+	void LinearArena::reset() {
+
+		size_t used = m_Offset.load() + m_OverflowSize;
+		m_HighWaterMark = std::max(m_HighWaterMark, used);
+
+		if(m_OverflowBlocks != nullptr) {
+			size_t newCapacity = m_Capacity;
+			while(newCapacity < used) newCapacity *= 2;
+
+			Log::warn("Frame arena overflowed by {} bytes, growing it from {} to {} bytes", m_OverflowSize, m_Capacity, newCapacity);
+
+			releaseOverflowBlocks();
+
+			free(m_Data);
+			m_Data = (int8_t*) malloc(newCapacity);
+			if(m_Data == nullptr) throw BadAllocationException();
+			m_Capacity = newCapacity;
+		}
+
+		m_Offset = 0;
+	}
+
+	size_t LinearArena::capacity() const {
+		return m_Capacity;
+	}
+
+	size_t LinearArena::used() const {
+		return m_Offset.load(std::memory_order_relaxed);
+	}
+
+	size_t LinearArena::highWaterMark() const {
+		return m_HighWaterMark;
+	}
+
+	bool LinearArena::overflowed() const {
+		return m_OverflowBlocks != nullptr;
+	}
+
+	void* LinearArena::allocateOverflow(size_t size, size_t alignment) {
+		// Overflow blocks come from malloc, so they do not trip the frame heap allocation guard
+		std::lock_guard<Mutex> lock(m_OverflowMutex);
+		const size_t headerSize = alignUp(sizeof(OverflowBlock), alignof(std::max_align_t));
+		const size_t blockSize = headerSize + size + alignment;
+		auto* block = (OverflowBlock*) malloc(blockSize);
+		if(block == nullptr) throw BadAllocationException();
+		block->next = m_OverflowBlocks;
+		block->size = blockSize;
+		m_OverflowBlocks = block;
+		m_OverflowSize += blockSize;
+		return (void*) alignUp((size_t)block + headerSize, alignment);
+	}
+
+	void LinearArena::releaseOverflowBlocks() {
+		OverflowBlock* block = m_OverflowBlocks;
+		while(block != nullptr) {
+			OverflowBlock* next = block->next;
+			free(block);
+			block = next;
+		}
+		m_OverflowBlocks = nullptr;
+		m_OverflowSize = 0;
+	}
+
+	// =====
+
+	Array<LinearArena*, FRAME_ARENA_BUFFER_COUNT> FrameArena::s_Arenas{};
+	AtomicUInt FrameArena::s_CurrentIndex{0};
+	size_t FrameArena::s_Frame = 0;
+
+	void* FrameArena::allocate(size_t size, size_t alignment) {
+		return s_Arenas[s_CurrentIndex]->allocate(size, alignment);
+	}
+
+	LinearArena& FrameArena::current() {
+		return *s_Arenas[s_CurrentIndex];
+	}
+
+	uint32_t FrameArena::currentIndex() {
+		return s_CurrentIndex;
+	}
+
+	size_t FrameArena::frame() {
+		return s_Frame;
+	}
+
+	bool FrameArena::warmedUp() {
+		return s_Frame > FRAME_ARENA_BUFFER_COUNT;
+	}
+
+	void FrameArena::beginFrame() {
+		// The arena is reset before it becomes current, so other threads never allocate from it during the reset
+		const uint32_t index = (s_CurrentIndex + 1) % FRAME_ARENA_BUFFER_COUNT;
+		s_Arenas[index]->reset();
+		s_CurrentIndex = index;
+		++s_Frame;
+	}
+
+	void FrameArena::init() {
+		for(LinearArena*& arena : s_Arenas) {
+			arena = new LinearArena(FRAME_ARENA_DEFAULT_CAPACITY);
+		}
+		s_CurrentIndex = 0;
+		s_Frame = 0;
+	}
+
+	void FrameArena::shutdown() {
+		for(LinearArena*& arena : s_Arenas) {
+			DELETE_PTR(arena);
+		}
+	}
+}
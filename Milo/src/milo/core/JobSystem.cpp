@@ -0,0 +1,135 @@
+#include "milo/common/JobSystem.h"
+#include <algorithm>
+
+namespace milo {
+
+	ArrayList<Thread> JobSystem::s_Workers;
+	ArrayList<JobSystem::ParallelBatch*> JobSystem::s_Batches;
+	Mutex JobSystem::s_Mutex;
+	std::condition_variable JobSystem::s_WorkAvailable;
+	std::condition_variable JobSystem::s_BatchFinished;
+	bool JobSystem::s_Running = false;
+
+	uint32_t JobSystem::workerCount() {
+		return (uint32_t)s_Workers.size();
+	}
+
+	size_t JobSystem::chunkCount(size_t count, size_t minChunkSize) {
+		if(count == 0) return 0;
+		// A few chunks per thread, so threads that finish early can steal the remaining ones
+		const size_t threads = s_Workers.size() + 1;
+		const size_t chunkSize = std::max(std::max(minChunkSize, (size_t)1), (count + threads * 4 - 1) / (threads * 4));
+		return (count + chunkSize - 1) / chunkSize;
+	}
+
+	void JobSystem::parallelFor(size_t count, size_t minChunkSize, const std::function<void(size_t, size_t, size_t)>& func) {
+
+		const size_t chunks = chunkCount(count, minChunkSize);
+		if(chunks == 0) return;
+
+		if(chunks == 1 || s_Workers.empty()) {
+			const size_t chunkSize = (count + chunks - 1) / chunks;
+			for(size_t chunk = 0;chunk < chunks;++chunk) {
+				func(chunk, chunk * chunkSize, std::min(count, (chunk + 1) * chunkSize));
+			}
+			return;
+		}
+
+		ParallelBatch batch;
+		batch.func = &func;
+		batch.count = count;
+		batch.chunkCount = chunks;
+		batch.chunkSize = (count + chunks - 1) / chunks;
+		batch.pendingChunks = chunks;
+
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_Batches.push_back(&batch);
+		}
+		s_WorkAvailable.notify_all();
+
+		while(runChunk(&batch));
+
+		// The batch lives in this stack frame, so wait until no worker references it anymore
+		std::unique_lock<Mutex> lock(s_Mutex);
+		s_Batches.erase(std::remove(s_Batches.begin(), s_Batches.end(), &batch), s_Batches.end());
+		s_BatchFinished.wait(lock, [&]() {return batch.pendingChunks.load() == 0 && batch.activeWorkers == 0;});
+
+		if(batch.error != nullptr) std::rethrow_exception(batch.error);
+	}
+
+	bool JobSystem::runChunk(ParallelBatch* batch) {
+
+		const size_t chunk = batch->nextChunk.fetch_add(1);
+		if(chunk >= batch->chunkCount) return false;
+
+		const size_t begin = chunk * batch->chunkSize;
+		const size_t end = std::min(batch->count, begin + batch->chunkSize);
+
+		// An exception must not leave a worker thread, nor skip the count the owner of the batch waits on
+		if(!batch->failed.load()) {
+			try {
+				(*batch->func)(chunk, begin, end);
+			} catch(...) {
+				std::lock_guard<Mutex> lock(s_Mutex);
+				if(batch->error == nullptr) batch->error = std::current_exception();
+				batch->failed = true;
+			}
+		}
+
+		if(--batch->pendingChunks == 0) {
+			// Taking the lock makes sure the owner is either not waiting yet or already waiting, so the notify is not lost
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_BatchFinished.notify_all();
+		}
+
+		return true;
+	}
+
+	void JobSystem::workerMain() {
+
+		while(true) {
+
+			ParallelBatch* batch = nullptr;
+			{
+				std::unique_lock<Mutex> lock(s_Mutex);
+				s_WorkAvailable.wait(lock, []() {return !s_Running || !s_Batches.empty();});
+				if(!s_Running) return;
+				batch = s_Batches.front();
+				if(batch->nextChunk.load() >= batch->chunkCount) {
+					s_Batches.erase(s_Batches.begin());
+					continue;
+				}
+				// Taken under the lock, so the owner cannot return while this worker is about to touch the batch
+				++batch->activeWorkers;
+			}
+
+			while(runChunk(batch));
+
+			std::lock_guard<Mutex> lock(s_Mutex);
+			--batch->activeWorkers;
+			s_BatchFinished.notify_all();
+		}
+	}
+
+	void JobSystem::init() {
+		s_Running = true;
+		const uint32_t threads = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+		s_Workers.reserve(threads);
+		for(uint32_t i = 0;i < threads;++i) {
+			s_Workers.emplace_back(&JobSystem::workerMain);
+		}
+	}
+
+	void JobSystem::shutdown() {
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_Running = false;
+		}
+		s_WorkAvailable.notify_all();
+		for(Thread& worker : s_Workers) {
+			worker.join();
+		}
+		s_Workers.clear();
+	}
+}
\ No newline at end of file
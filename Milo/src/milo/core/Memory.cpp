@@ -2,94 +2,348 @@
 #include "milo/common/Exceptions.h"
 #include "milo/logging/Log.h"
 #include <iostream>
+#include <algorithm>
+#include <cstddef>
+#include <cassert>
+
+namespace milo {
+
+	// Every tracked allocation is prefixed with this header, so the size and tag can be recovered on delete
+	// without keeping a global address map
+	struct alignas(alignof(std::max_align_t)) AllocationHeader {
+		size_t size;
+		MemoryTag tag;
+	};
+
+	static constexpr size_t ALLOCATION_HEADER_SIZE = sizeof(AllocationHeader);
+
+	static constexpr int64_t THREAD_COUNTERS_MAX_PENDING_OPS = 256;
+	static constexpr int64_t THREAD_COUNTERS_MAX_PENDING_BYTES = 256 * 1024;
+
+	static Atomic<int64_t> g_AllocatedBytes[MEMORY_TAG_COUNT]{};
+	static Atomic<int64_t> g_PeakBytes[MEMORY_TAG_COUNT]{};
+	static Atomic<int64_t> g_AliveAllocations[MEMORY_TAG_COUNT]{};
+	static Atomic<uint64_t> g_TotalAllocations[MEMORY_TAG_COUNT]{};
+	static Atomic<int64_t> g_TotalAllocatedBytes{0};
+	static Atomic<int64_t> g_TotalPeakBytes{0};
+
+	static void atomicMax(Atomic<int64_t>& target, int64_t value) {
+		int64_t current = target.load(std::memory_order_relaxed);
+		while(current < value && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {}
+	}
+
+	struct ThreadMemoryCounters {
+		int64_t bytes[MEMORY_TAG_COUNT]{};
+		int64_t allocations[MEMORY_TAG_COUNT]{};
+		uint64_t newAllocations[MEMORY_TAG_COUNT]{};
+		int64_t pendingOps{0};
+		int64_t pendingBytes{0};
+		uint32_t sampleCountdown{0};
+		bool sampling{false};
+
+		~ThreadMemoryCounters() {
+			merge();
+		}
+
+		inline void merge() {
+			int64_t totalDelta = 0;
+			for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+				if(bytes[i] == 0 && allocations[i] == 0 && newAllocations[i] == 0) continue;
+				int64_t allocated = g_AllocatedBytes[i].fetch_add(bytes[i], std::memory_order_relaxed) + bytes[i];
+				atomicMax(g_PeakBytes[i], allocated);
+				g_AliveAllocations[i].fetch_add(allocations[i], std::memory_order_relaxed);
+				g_TotalAllocations[i].fetch_add(newAllocations[i], std::memory_order_relaxed);
+				totalDelta += bytes[i];
+				bytes[i] = allocations[i] = 0;
+				newAllocations[i] = 0;
+			}
+			int64_t total = g_TotalAllocatedBytes.fetch_add(totalDelta, std::memory_order_relaxed) + totalDelta;
+			atomicMax(g_TotalPeakBytes, total);
+			pendingOps = pendingBytes = 0;
+		}
+
+		inline void onChange(int64_t size) {
+			pendingBytes += size;
+			if(++pendingOps >= THREAD_COUNTERS_MAX_PENDING_OPS
+			|| pendingBytes >= THREAD_COUNTERS_MAX_PENDING_BYTES
+			|| pendingBytes <= -THREAD_COUNTERS_MAX_PENDING_BYTES) {
+				merge();
+			}
+		}
+	};
+
+	static thread_local ThreadMemoryCounters t_Counters;
+	static thread_local MemoryTag t_CurrentTag = MemoryTag::General;
+	static thread_local bool t_HeapAllocationsForbidden = false;
+}
 
 #ifdef _DEBUG
+
+static void onForbiddenHeapAllocation(size_t size) {
+	milo::t_HeapAllocationsForbidden = false;
+	LOG_ERROR(fmt::format("Heap allocation of {} bytes inside a heap-free scope", size));
+	assert(false && "Heap allocation inside a heap-free scope");
+}
+
+static void* trackedAllocate(size_t size) {
+	if(milo::t_HeapAllocationsForbidden) onForbiddenHeapAllocation(size);
+	void* block = malloc(size + milo::ALLOCATION_HEADER_SIZE);
+	if(block == nullptr) throw std::bad_alloc();
+	auto* header = static_cast<milo::AllocationHeader*>(block);
+	header->size = size;
+	header->tag = milo::t_CurrentTag;
+	milo::MemoryTracker::add(size, header->tag);
+	return static_cast<char*>(block) + milo::ALLOCATION_HEADER_SIZE;
+}
+
+static void trackedFree(void* ptr) {
+	if(ptr == nullptr) return;
+	auto* header = reinterpret_cast<milo::AllocationHeader*>(static_cast<char*>(ptr) - milo::ALLOCATION_HEADER_SIZE);
+	milo::MemoryTracker::remove(header->size, header->tag);
+	free(header);
+}
+
 void *operator new(size_t size) {
-	void* ptr = malloc(size);
-	milo::MemoryTracker::add((uint64_t)(ptr), size);
-	return ptr;
+	return trackedAllocate(size);
 }
 
 void *operator new[](size_t size) {
-	void* ptr = malloc(size);
-	milo::MemoryTracker::add((uint64_t)(ptr), size);
-	return ptr;
+	return trackedAllocate(size);
 }
 
-void operator delete(void *ptr) {
-	milo::MemoryTracker::remove((uint64_t)ptr);
-	free(ptr);
+void operator delete(void *ptr) noexcept {
+	trackedFree(ptr);
 }
 
-void operator delete[](void *ptr) {
-	milo::MemoryTracker::remove((uint64_t)ptr);
-	free(ptr);
+void operator delete[](void *ptr) noexcept {
+	trackedFree(ptr);
 }
 #endif
 
 namespace milo {
 
-	static const size_t KB = 1024;
-	static const size_t MB = 1024 * 1024;
-	static const size_t GB = 1024 * 1024 * 1024;
+	static const int64_t KB = 1024;
+	static const int64_t MB = 1024 * 1024;
+	static const int64_t GB = 1024 * 1024 * 1024;
+
+	static const size_t MAX_CALL_SITES = 1024;
+	static const size_t CALL_SITE_STACK_DEPTH = 8;
 
-	static String memoryStr(size_t bytes) {
+	static String memoryStr(int64_t bytes) {
 		if(bytes < KB) return fmt::format("{} bytes", bytes);
 		if(bytes < MB) return fmt::format("{} KB", bytes / (float)KB);
 		if(bytes < GB) return fmt::format("{} MB", bytes / (float)MB);
 		return fmt::format("{} GB", bytes / (float)GB);
 	}
 
+	const char* memoryTagName(MemoryTag tag) {
+		switch(tag) {
+			case MemoryTag::General: return "General";
+			case MemoryTag::Assets: return "Assets";
+			case MemoryTag::Renderer: return "Renderer";
+			case MemoryTag::ECS: return "ECS";
+			case MemoryTag::Editor: return "Editor";
+			case MemoryTag::UI: return "UI";
+			default: return "Unknown";
+		}
+	}
+
+	String MemoryReport::str() const {
+		StringStream ss;
+		ss << "Memory report:\n";
+		ss << fmt::format("  {:<10} {:>14} {:>14} {:>12} {:>14}\n", "Tag", "Allocated", "Peak", "Alive", "Total allocs");
+		for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+			const MemoryTagStats& s = tags[i];
+			ss << fmt::format("  {:<10} {:>14} {:>14} {:>12} {:>14}\n", memoryTagName((MemoryTag)i),
+							  memoryStr(s.allocatedBytes), memoryStr(s.peakBytes), s.aliveAllocations, s.totalAllocations);
+		}
+		ss << fmt::format("  {:<10} {:>14} {:>14} {:>12} {:>14}\n", "Total",
+						  memoryStr(total.allocatedBytes), memoryStr(total.peakBytes), total.aliveAllocations, total.totalAllocations);
+		if(!callSites.empty()) {
+			ss << "Sampled call sites:\n";
+			for(const MemoryCallSite& callSite : callSites) {
+				ss << fmt::format("  [{}] {} samples, {}\n{}", memoryTagName(callSite.tag), callSite.samples,
+								  memoryStr((int64_t)callSite.sampledBytes), callSite.location);
+			}
+		}
+		return ss.str();
+	}
+
 	AtomicBool MemoryTracker::s_Active = false;
-	HashMap<uint64_t, size_t>* MemoryTracker::s_Allocations = nullptr;
-	AtomicULong MemoryTracker::s_TotalAllocations = 0;
-	AtomicULong MemoryTracker::s_TotalAllocationSize = 0;
-
-	void MemoryTracker::add(uint64_t address, size_t size) {
-		if(!s_Active) return;
-		++s_TotalAllocations;
-		s_TotalAllocationSize += size;
-		s_Active = false;
-		allocations()[address] = size;
-		s_Active = true;
+	AtomicUInt MemoryTracker::s_SamplingRate = 0;
+	Mutex MemoryTracker::s_CallSitesMutex;
+	HashMap<size_t, MemoryTracker::CallSiteEntry>* MemoryTracker::s_CallSites = nullptr;
+
+	void MemoryTracker::add(size_t size, MemoryTag tag) {
+		ThreadMemoryCounters& counters = t_Counters;
+		const size_t index = static_cast<size_t>(tag);
+		counters.bytes[index] += (int64_t)size;
+		++counters.allocations[index];
+		++counters.newAllocations[index];
+		counters.onChange((int64_t)size);
+
+		if(!s_Active || counters.sampling) return;
+		const uint32_t rate = s_SamplingRate.load(std::memory_order_relaxed);
+		if(rate == 0) return;
+		if(counters.sampleCountdown == 0 || counters.sampleCountdown > rate) counters.sampleCountdown = rate;
+		if(--counters.sampleCountdown == 0) {
+			sample(size, tag);
+		}
+	}
+
+	void MemoryTracker::remove(size_t size, MemoryTag tag) {
+		ThreadMemoryCounters& counters = t_Counters;
+		const size_t index = static_cast<size_t>(tag);
+		counters.bytes[index] -= (int64_t)size;
+		--counters.allocations[index];
+		counters.onChange(-(int64_t)size);
 	}
 
-	void MemoryTracker::remove(uint64_t address) {
-		if(!s_Active) return;
-		if(allocations().find(address) == allocations().end()) return;
-		size_t size = allocations()[address];
-		allocations().erase(address);
-		s_TotalAllocationSize -= size;
+	void MemoryTracker::flush() {
+		t_Counters.merge();
+	}
+
+	MemoryTag MemoryTracker::currentTag() {
+		return t_CurrentTag;
+	}
+
+	void MemoryTracker::sample(size_t size, MemoryTag tag) {
+		ThreadMemoryCounters& counters = t_Counters;
+		counters.sampling = true;
+		{
+			StackTrace stacktrace = getStackTrace(0, CALL_SITE_STACK_DEPTH);
+			const size_t hash = boost::stacktrace::hash_value(stacktrace);
+
+			std::lock_guard<Mutex> lock(s_CallSitesMutex);
+			if(s_CallSites != nullptr) {
+				auto it = s_CallSites->find(hash);
+				if(it != s_CallSites->end()) {
+					++it->second.samples;
+					it->second.sampledBytes += size;
+				} else if(s_CallSites->size() < MAX_CALL_SITES) {
+					s_CallSites->emplace(hash, CallSiteEntry{std::move(stacktrace), tag, 1, size});
+				}
+			}
+		}
+		counters.sampling = false;
 	}
 
 	uint64_t MemoryTracker::aliveAllocationsCount() {
-		return s_Allocations->size();
+		return totalStats().aliveAllocations;
 	}
 
 	uint64_t MemoryTracker::totalAllocations() {
-		return s_TotalAllocations;
+		return totalStats().totalAllocations;
 	}
 
 	uint64_t MemoryTracker::totalAllocationSize() {
-		return s_TotalAllocationSize;
+		return std::max<int64_t>(g_TotalAllocatedBytes.load(std::memory_order_relaxed), 0);
+	}
+
+	uint64_t MemoryTracker::peakAllocationSize() {
+		return g_TotalPeakBytes.load(std::memory_order_relaxed);
 	}
 
 	String MemoryTracker::totalAllocationSizeStr() {
-		return memoryStr(totalAllocationSize());
+		return memoryStr((int64_t)totalAllocationSize());
+	}
+
+	MemoryTagStats MemoryTracker::stats(MemoryTag tag) {
+		const size_t index = static_cast<size_t>(tag);
+		MemoryTagStats s{};
+		s.allocatedBytes = g_AllocatedBytes[index].load(std::memory_order_relaxed);
+		s.peakBytes = g_PeakBytes[index].load(std::memory_order_relaxed);
+		s.aliveAllocations = g_AliveAllocations[index].load(std::memory_order_relaxed);
+		s.totalAllocations = g_TotalAllocations[index].load(std::memory_order_relaxed);
+		return s;
+	}
+
+	MemoryTagStats MemoryTracker::totalStats() {
+		MemoryTagStats total{};
+		for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+			MemoryTagStats s = stats((MemoryTag)i);
+			total.aliveAllocations += s.aliveAllocations;
+			total.totalAllocations += s.totalAllocations;
+		}
+		total.allocatedBytes = g_TotalAllocatedBytes.load(std::memory_order_relaxed);
+		total.peakBytes = g_TotalPeakBytes.load(std::memory_order_relaxed);
+		return total;
+	}
+
+	MemoryReport MemoryTracker::report() {
+
+		flush();
+
+		MemoryReport report{};
+		for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+			report.tags[i] = stats((MemoryTag)i);
+		}
+		report.total = totalStats();
+
+		std::lock_guard<Mutex> lock(s_CallSitesMutex);
+		if(s_CallSites != nullptr) {
+			report.callSites.reserve(s_CallSites->size());
+			for(const auto& [hash, entry] : *s_CallSites) {
+				MemoryCallSite callSite;
+				callSite.location = milo::str(entry.stacktrace);
+				callSite.tag = entry.tag;
+				callSite.samples = entry.samples;
+				callSite.sampledBytes = entry.sampledBytes;
+				report.callSites.push_back(std::move(callSite));
+			}
+			std::sort(report.callSites.begin(), report.callSites.end(), [](const auto& a, const auto& b) {
+				return a.sampledBytes > b.sampledBytes;
+			});
+		}
+
+		return report;
+	}
+
+	uint32_t MemoryTracker::samplingRate() {
+		return s_SamplingRate;
+	}
+
+	void MemoryTracker::setSamplingRate(uint32_t rate) {
+		s_SamplingRate = rate;
+	}
+
+	void MemoryTracker::resetPeaks() {
+		flush();
+		for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+			g_PeakBytes[i] = g_AllocatedBytes[i].load();
+		}
+		g_TotalPeakBytes = g_TotalAllocatedBytes.load();
 	}
 
 	void MemoryTracker::init() {
-		s_Allocations = new HashMap<uint64_t, size_t>();
-		s_Allocations->reserve(1024 * 1024);
+		s_CallSites = new HashMap<size_t, CallSiteEntry>();
+		s_CallSites->reserve(MAX_CALL_SITES);
 		s_Active = true;
 	}
 
 	void MemoryTracker::shutdown() {
 		s_Active = false;
-		DELETE_PTR(s_Allocations);
+		std::lock_guard<Mutex> lock(s_CallSitesMutex);
+		DELETE_PTR(s_CallSites);
+	}
+
+	MemoryTagScope::MemoryTagScope(MemoryTag tag) : m_LastTag(t_CurrentTag) {
+		t_CurrentTag = tag;
+	}
+
+	MemoryTagScope::~MemoryTagScope() {
+		t_CurrentTag = m_LastTag;
+	}
+
+	HeapAllocationGuard::HeapAllocationGuard(bool enabled) : m_LastValue(t_HeapAllocationsForbidden) {
+		t_HeapAllocationsForbidden = enabled;
+	}
+
+	HeapAllocationGuard::~HeapAllocationGuard() {
+		t_HeapAllocationsForbidden = m_LastValue;
 	}
 
-	inline HashMap<uint64_t, size_t>& MemoryTracker::allocations() {
-		return *s_Allocations;
+	bool HeapAllocationGuard::heapAllocationsForbidden() {
+		return t_HeapAllocationsForbidden;
 	}
-}
\ No newline at end of file
+}
@@ -5,7 +5,9 @@
 #include "milo/graphics/Graphics.h"
 #include "milo/input/Input.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
+#include "milo/graphics/rendering/FramePipeline.h"
 #include "milo/editor/MiloEditor.h"
+#include "milo/assets/HotReloader.h"
 
 namespace milo {
 
@@ -16,6 +18,7 @@ namespace milo {
 	static Mutex g_LaunchMutex;
 
 	AtomicBool MiloEngine::s_AlreadyLaunched = false;
+	FrameStats MiloEngine::s_FrameStats{};
 
 	MiloExitResult MiloEngine::launch(Application &application) {
 		if(s_AlreadyLaunched) return {MILO_ENGINE_ALREADY_LAUNCHED, "MILO_ENGINE_ALREADY_LAUNCHED"};
@@ -54,18 +57,35 @@ namespace milo {
 		return exitResult;
 	}
 
+	const FrameStats& MiloEngine::frameStats() {
+		return s_FrameStats;
+	}
+
 	void MiloEngine::run() {
 		Application& application = Application::get();
 		application.m_Running = true;
 
-		setSimulationState(SimulationState::Editor);
+		const bool headless = application.configuration().headless.enabled;
+
+		// There is no editor to start the simulation from in headless mode
+		setSimulationState(headless ? SimulationState::Play : SimulationState::Editor);
 
 		application.onInit();
 		init();
 		Log::info("Starting Milo Application...");
-		Window::get()->show();
+		if(!headless) Window::get()->show();
 		application.onStart();
 
+		if(application.configuration().pipelinedRendering) {
+			FramePipeline::start(&MiloEngine::renderPipelined);
+		}
+
+		if(headless) {
+			runHeadless();
+			application.m_Running = false;
+			return;
+		}
+
 		float updateDelay = 0;
 
 		float lastFrame = Time::now();
@@ -78,19 +98,81 @@ namespace milo {
 			Time::s_RawDeltaTime = now - lastFrame;
 			lastFrame = now;
 
-			update(updateDelay, lastUpdate);
+			FrameArena::beginFrame();
+
+			// The editor UI reads and edits the scene while it is drawn, so it never runs along a render thread
+			const bool pipelined = FramePipeline::running() && getSimulationState() == SimulationState::Play;
+
+			update(updateDelay, lastUpdate, pipelined);
 
-			render();
+			if(pipelined) {
+				MILO_MEMORY_TAG(MemoryTag::Renderer);
+				// A frame is pushed every iteration, so the queue paces the simulation like presenting does in serial mode
+				FramePipeline::push(WorldRenderer::buildFrame(SceneManager::activeScene()));
+				++Time::s_Fps;
+			} else {
+				FramePipeline::flush();
+				render();
+			}
 
 			++Time::s_Frame;
 
+			MemoryTracker::flush();
+
 			showDebugInfo(debugTime);
 		}
 
 		application.m_Running = false;
 	}
 
-	inline void MiloEngine::update(float& updateDelay, float& lastUpdate) {
+	// Renders frames as fast as the device and the frame readback allow. Every frame simulates exactly one fixed
+	// update, so the written image sequence does not depend on how long the frames took to render
+	void MiloEngine::runHeadless() {
+		Application& application = Application::get();
+		const HeadlessConfiguration& config = application.configuration().headless;
+
+		const float startTime = Time::now();
+		float lastFrame = startTime;
+		float debugTime = startTime;
+		uint32_t frameCount = 0;
+
+		while(application.running() && (config.frames == 0 || frameCount < config.frames)) {
+
+			const float now = Time::now();
+			Time::s_RawDeltaTime = now - lastFrame;
+			lastFrame = now;
+
+			FrameArena::beginFrame();
+
+			const bool pipelined = FramePipeline::running();
+
+			Time::s_DeltaTime = TARGET_UPDATE_DELAY;
+			simulate();
+			lateUpdate(pipelined);
+
+			if(pipelined) {
+				MILO_MEMORY_TAG(MemoryTag::Renderer);
+				FramePipeline::push(WorldRenderer::buildFrame(SceneManager::activeScene()));
+				++Time::s_Fps;
+			} else {
+				render();
+			}
+
+			++Time::s_Frame;
+			++frameCount;
+
+			MemoryTracker::flush();
+
+			showDebugInfo(debugTime);
+		}
+
+		FramePipeline::flush();
+
+		const float elapsed = Time::now() - startTime;
+		Log::info("Rendered {} headless frames in {:.3f} s ({:.2f} fps)", frameCount, elapsed, elapsed > 0 ? (float)frameCount / elapsed : 0.0f);
+	}
+
+	inline void MiloEngine::update(float& updateDelay, float& lastUpdate, bool pipelined) {
 
 		updateDelay += Time::s_RawDeltaTime;
 		bool wasUpdated = false;
@@ -101,23 +183,58 @@ namespace milo {
 			Time::s_DeltaTime = now - lastUpdate;
 			lastUpdate = now;
 
-			EventSystem::update();
+			simulate();
 
-			Input::update();
+			updateDelay -= TARGET_UPDATE_DELAY;
+			wasUpdated = true;
+		}
 
+		if(wasUpdated) lateUpdate(pipelined);
+	}
+
+	inline void MiloEngine::simulate() {
+
+		EventSystem::update();
+
+		Input::update();
+
+		if(!Graphics::headless()) {
+			MILO_MEMORY_TAG(MemoryTag::Editor);
 			MiloEditor::update();
+		}
 
+		{
+			MILO_MEMORY_TAG(MemoryTag::ECS);
 			SceneManager::update();
-
-			++Time::s_Ups;
-			updateDelay -= TARGET_UPDATE_DELAY;
-			wasUpdated = true;
 		}
 
-		if(wasUpdated) {
+		++Time::s_Ups;
+	}
+
+	inline void MiloEngine::lateUpdate(bool pipelined) {
+		{
+			MILO_MEMORY_TAG(MemoryTag::ECS);
 			SceneManager::lateUpdate();
-			Assets::materials().update();
-			WorldRenderer::update();
+		}
+		{
+			// Reloaded assets are applied where the scene and the materials are edited. Material changes reach the
+			// GPU through the frame data, see MaterialManager::collectUpdates
+			MILO_MEMORY_TAG(MemoryTag::Assets);
+			HotReloader::update();
+		}
+		// Pipelined frames update the GPU side of the assets on the render thread and build their frame data every iteration
+		if(!pipelined) {
+			// The last pipelined frames may still be rendering right after leaving Play mode
+			FramePipeline::flush();
+			{
+				MILO_MEMORY_TAG(MemoryTag::Assets);
+				Assets::skybox().update();
+				Assets::textures().update();
+			}
+			{
+				MILO_MEMORY_TAG(MemoryTag::Renderer);
+				WorldRenderer::update();
+			}
 		}
 	}
 
@@ -127,9 +244,15 @@ namespace milo {
 
 		if(graphicsPresenter->begin()) {
 
-			WorldRenderer::render();
+			{
+				MILO_MEMORY_TAG(MemoryTag::Renderer);
+				WorldRenderer::render();
+			}
 
-			MiloEditor::render();
+			if(!Graphics::headless()) {
+				MILO_MEMORY_TAG(MemoryTag::Editor);
+				MiloEditor::render();
+			}
 
 			graphicsPresenter->end();
 		}
@@ -137,24 +260,51 @@ namespace milo {
 		++Time::s_Fps;
 	}
 
+	void MiloEngine::renderPipelined(const FrameRenderData& frame) {
+
+		{
+			MILO_MEMORY_TAG(MemoryTag::Assets);
+			WorldRenderer::updateAssets(frame);
+			Assets::skybox().update();
+			Assets::textures().update();
+		}
+
+		GraphicsPresenter* graphicsPresenter = GraphicsPresenter::get();
+
+		if(graphicsPresenter->begin()) {
+			{
+				MILO_MEMORY_TAG(MemoryTag::Renderer);
+				WorldRenderer::get().render(frame);
+			}
+			graphicsPresenter->end();
+		}
+	}
+
 	void MiloEngine::init() {
 		MiloSubSystemManager::init();
 		EventSystem::addEventCallback(EventType::WindowClose, [&](const Event& event) {Application::exit();});
 	}
 
 	void MiloEngine::shutdown() {
+		INVOKE_SAFELY(FramePipeline::stop());
 		MiloSubSystemManager::shutdown();
 	}
 
 	inline void MiloEngine::showDebugInfo(float& debugTime) {
 		if(Time::now() - debugTime >= DEBUG_MIN_TIME) {
-#ifdef _DEBUG
-			String message = fmt::format("Ups: {}, Fps: {}, Dt:{}, Ft: {} ms, Mem: {}",Time::ups(), Time::fps(), Time::deltaTime(), Time::rawDeltaTime() * 1000.0f, MemoryTracker::totalAllocationSizeStr());
-#else
-			String message = fmt::format("Ups: {}, Fps: {}, Dt:{}, Ft: {} ms", Time::ups(), Time::fps(), Time::deltaTime(), Time::rawDeltaTime() * 1000.0f);
-#endif
+
+			s_FrameStats.ups = Time::ups();
+			s_FrameStats.fps = Time::fps();
+			s_FrameStats.deltaTime = Time::deltaTime();
+			s_FrameStats.frameTime = Time::rawDeltaTime() * 1000.0f;
+			for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+				s_FrameStats.memoryByTag[i] = MemoryTracker::stats((MemoryTag)i);
+			}
+			s_FrameStats.memory = MemoryTracker::totalStats();
+
+			String message = fmt::format("Ups: {}, Fps: {}, Dt:{}, Ft: {} ms", s_FrameStats.ups, s_FrameStats.fps, s_FrameStats.deltaTime, s_FrameStats.frameTime);
 			Log::info(message);
-			Window::get()->title("Milo Engine  " + std::move(message));
+			if(Window::get() != nullptr) Window::get()->title("Milo Engine  " + std::move(message));
 
 			Time::s_Ups = Time::s_Fps = 0;
 			debugTime = Time::now();
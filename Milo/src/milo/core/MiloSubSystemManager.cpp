@@ -1,13 +1,17 @@
 #pragma once
 
 #include "milo/core/MiloSubSystemManager.h"
+#include "milo/common/JobSystem.h"
 #include "milo/scenes/SceneManager.h"
 #include "milo/graphics/Graphics.h"
 #include "milo/input/Input.h"
 #include "milo/assets/AssetManager.h"
+#include "milo/assets/HotReloader.h"
+#include "milo/io/FileWatcher.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/editor/MiloEditor.h"
 #include "milo/time/Profiler.h"
+#include "milo/core/Application.h"
 
 #define INIT(system) Log::info("Initializing {}...", #system); system::init(); Log::info("{} initialized", #system)
 #define SHUTDOWN(system) Log::info("Terminating {}...", #system); system::shutdown(); Log::info("{} terminated", #system)
@@ -17,25 +21,65 @@ namespace milo {
 	void MiloSubSystemManager::init() {
 		MemoryTracker::init();
 		Log::init();
+		initLogging();
 		INIT(Time);
 		INIT(Profiler);
+		INIT(FrameArena);
+		INIT(JobSystem);
+		INIT(FileWatcher);
 		INIT(EventSystem);
 		INIT(Graphics);
 		INIT(Input);
 		INIT(SceneManager);
 		INIT(AssetManager);
+		INIT(HotReloader);
 		INIT(WorldRenderer);
-		INIT(MiloEditor);
+		// The editor UI needs a window
+		if(!Graphics::headless()) {
+			INIT(MiloEditor);
+		}
 	}
 
 	void MiloSubSystemManager::shutdown() {
-		SHUTDOWN(MiloEditor);
+		if(!Graphics::headless()) {
+			SHUTDOWN(MiloEditor);
+		}
 		SHUTDOWN(WorldRenderer);
+		SHUTDOWN(HotReloader);
 		SHUTDOWN(AssetManager);
 		SHUTDOWN(SceneManager);
 		SHUTDOWN(Input);
 		SHUTDOWN(Graphics);
 		SHUTDOWN(EventSystem);
+		SHUTDOWN(FileWatcher);
+		SHUTDOWN(JobSystem);
+		SHUTDOWN(FrameArena);
+		SHUTDOWN(Profiler);
+		SHUTDOWN(Time);
+		Log::shutdown();
+		MemoryTracker::shutdown();
+	}
+
+	void MiloSubSystemManager::initLogging() {
+		const AppConfiguration& config = Application::get().configuration();
+		if(!config.binaryLogFile.empty()) Log::openBinaryLog(config.binaryLogFile);
+		if(config.asyncLogging) Log::startAsync(Log::DEFAULT_ASYNC_CAPACITY, config.logOverflowPolicy);
+	}
+
+	void MiloSubSystemManager::initHeadless() {
+		MemoryTracker::init();
+		Log::init();
+		INIT(Time);
+		INIT(Profiler);
+		INIT(FrameArena);
+		INIT(JobSystem);
+		INIT(SceneManager);
+	}
+
+	void MiloSubSystemManager::shutdownHeadless() {
+		SHUTDOWN(SceneManager);
+		SHUTDOWN(JobSystem);
+		SHUTDOWN(FrameArena);
 		SHUTDOWN(Profiler);
 		SHUTDOWN(Time);
 		Log::shutdown();
@@ -1,6 +1,7 @@
 #include "milo/editor/MiloEditor.h"
 #include "milo/graphics/Graphics.h"
 #include "milo/graphics/vulkan/ui/VulkanUIRenderer.h"
+#include "milo/graphics/vulkan/rendering/VulkanFrameGraphResourcePool.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/assets/AssetManager.h"
 #include "milo/scenes/SceneManager.h"
@@ -10,6 +11,7 @@
 #include <imgui_node_editor.h>
 #include "milo/time/Profiler.h"
 #include "milo/editor/DockSpaceRenderer.h"
+#include "milo/core/MiloEngine.h"
 
 namespace milo {
 
@@ -62,16 +64,50 @@ namespace milo {
 			texture = WorldRenderer::get().getFramebuffer().colorAttachments()[0];
 		}
 		UI::image(*texture, texture->size());
+		pickEntities(*texture);
 		SceneManager::activeScene()->setFocused(ImGui::IsWindowFocused());
 		ImGui::End();
 	}
 
+	void MiloEditor::pickEntities(const Texture2D& viewportTexture) {
+
+		EntityPicker& picker = WorldRenderer::get().entityPicker();
+
+		EntityPickResult result;
+		if(picker.poll(result)) {
+			Scene* scene = SceneManager::activeScene();
+			// The entity may have been destroyed since the frame that was read back
+			if(!result.entities.empty() && scene->exists(result.entities[0])) {
+				s_SceneHierarchyPanel.selectEntity(scene->find(result.entities[0]));
+			} else {
+				s_SceneHierarchyPanel.unselect();
+			}
+		}
+
+		if(!ImGui::IsItemHovered() || !ImGui::IsMouseClicked(ImGuiMouseButton_Left)) return;
+
+		const ImVec2 imageMin = ImGui::GetItemRectMin();
+		const ImVec2 imageSize = ImGui::GetItemRectSize();
+		const ImVec2 mouse = ImGui::GetMousePos();
+		const Size& size = viewportTexture.size();
+
+		const float u = (mouse.x - imageMin.x) / imageSize.x;
+		const float v = (mouse.y - imageMin.y) / imageSize.y;
+		if(u < 0 || u >= 1 || v < 0 || v >= 1) return;
+
+		// UI::image draws the viewport flipped vertically, so the top of the image is the last row of the texture
+		const auto x = (uint32_t)(u * (float)size.width);
+		const auto y = (uint32_t)((1.0f - v) * (float)size.height);
+		picker.pick(x, std::min(y, (uint32_t)size.height - 1));
+	}
+
 	void MiloEditor::setupMenuBar() {
 
 		if(ImGui::BeginMainMenuBar()) {
 
 			static bool depthBufferOpened = false;
 			static bool settingsPanelOpened = false;
+			static bool statisticsPanelOpened = false;
 
 			if(ImGui::BeginMenu("Options")) {
 
@@ -79,6 +115,10 @@ namespace milo {
 					depthBufferOpened = true;
 				}
 
+				if(ImGui::MenuItem("Statistics")) {
+					statisticsPanelOpened = true;
+				}
+
 				if(ImGui::MenuItem("More...")) {
 					settingsPanelOpened = true;
 				}
@@ -108,6 +148,7 @@ namespace milo {
 					bool shadowsEnabled = WorldRenderer::get().shadowsEnabled();
 					bool showBoundingVolumes = WorldRenderer::get().showBoundingVolumes();
 					bool showGrid = WorldRenderer::get().showGrid();
+					bool entityIds = WorldRenderer::get().entityIdsEnabled();
 					bool showShadowCascades = WorldRenderer::get().showShadowCascades();
 					bool softshadows = WorldRenderer::get().softShadows();
 					bool cascadeFadingEnabled = WorldRenderer::get().shadowCascadeFading();
@@ -121,6 +162,7 @@ namespace milo {
 					ImGui::Checkbox("Show shadow cascades", &showShadowCascades);
 					ImGui::Checkbox("Show bounding volumes", &showBoundingVolumes);
 					ImGui::Checkbox("Show grid", &showGrid);
+					ImGui::Checkbox("Entity picking", &entityIds);
 					ImGui::Checkbox("Soft Shadows", &softshadows);
 					ImGui::Checkbox("Cascade fading enabled", &cascadeFadingEnabled);
 					ImGui::Checkbox("Cascade fading value", &cascadeFadingValue);
@@ -132,6 +174,7 @@ namespace milo {
 					WorldRenderer::get().setShadowsEnabled(shadowsEnabled);
 					WorldRenderer::get().setShowBoundingVolumes(showBoundingVolumes);
 					WorldRenderer::get().setShowGrid(showGrid);
+					WorldRenderer::get().setEntityIdsEnabled(entityIds);
 					WorldRenderer::get().setShowShadowCascades(showShadowCascades);
 					WorldRenderer::get().setSoftShadows(softshadows);
 					WorldRenderer::get().setShadowCascadeFading(cascadeFadingEnabled);
@@ -139,6 +182,18 @@ namespace milo {
 
 					WorldRenderer::get().setShadowsMaxDistance(shadowsMaxDistance);
 
+					Scene* scene = SceneManager::activeScene();
+					bool parallelScripts = scene->scriptSchedulingMode() == ScriptSchedulingMode::Parallel;
+					ImGui::Checkbox("Parallel scripts", &parallelScripts);
+					scene->setScriptSchedulingMode(parallelScripts ? ScriptSchedulingMode::Parallel : ScriptSchedulingMode::Serial);
+
+					ImGui::End();
+				}
+			}
+
+			if(statisticsPanelOpened) {
+				if(ImGui::Begin("Statistics", &statisticsPanelOpened)) {
+					renderStatistics();
 					ImGui::End();
 				}
 			}
@@ -147,10 +202,126 @@ namespace milo {
 		}
 	}
 
+	void MiloEditor::renderStatistics() {
+
+		const FrameStats& stats = MiloEngine::frameStats();
+
+		ImGui::Text("Ups: %zu  Fps: %zu", stats.ups, stats.fps);
+		ImGui::Text("Delta time: %.4f s  Frame time: %.3f ms", stats.deltaTime, stats.frameTime);
+
+		ImGui::Separator();
+
+		const LinearArena& frameArena = FrameArena::current();
+		ImGui::Text("Frame arena: %.2f / %.2f KB (high water mark %.2f KB)", frameArena.used() / 1024.0f,
+					frameArena.capacity() / 1024.0f, frameArena.highWaterMark() / 1024.0f);
+
+		if(auto* resources = dynamic_cast<VulkanFrameGraphResourcePool*>(&WorldRenderer::get().resources())) {
+			const VulkanUniformRing::Stats& ring = resources->uniformRing().stats();
+			ImGui::Text("Uniform ring: %.2f / %.2f KB in %u allocations (high water mark %.2f KB, %u overflows, %u resizes)",
+						ring.used / 1024.0f, ring.capacity / 1024.0f, ring.allocations,
+						ring.highWaterMark / 1024.0f, ring.overflows, ring.resizes);
+
+			const CompiledFrameGraph& graph = WorldRenderer::get().frameGraph().compiledGraph();
+			ImGui::Text("Frame graph: %zu passes (%u culled), transients %.2f MB (%.2f MB without aliasing)",
+						graph.passes.size(), graph.culledPassCount,
+						resources->transientMemorySize() / (1024.0f * 1024.0f),
+						resources->transientMemorySizeWithoutAliasing() / (1024.0f * 1024.0f));
+		}
+
+		ImGui::Text("Memory: %.3f MB (peak %.3f MB), %lld alive allocations",
+					stats.memory.allocatedBytes / (1024.0f * 1024.0f), stats.memory.peakBytes / (1024.0f * 1024.0f),
+					(long long)stats.memory.aliveAllocations);
+
+		if(ImGui::BeginTable("MemoryByTag", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Tag");
+			ImGui::TableSetupColumn("Allocated (KB)");
+			ImGui::TableSetupColumn("Peak (KB)");
+			ImGui::TableSetupColumn("Alive");
+			ImGui::TableHeadersRow();
+			for(size_t i = 0;i < MEMORY_TAG_COUNT;++i) {
+				const MemoryTagStats& tagStats = stats.memoryByTag[i];
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::TextUnformatted(memoryTagName((MemoryTag)i));
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", tagStats.allocatedBytes / 1024.0f);
+				ImGui::TableNextColumn(); ImGui::Text("%.2f", tagStats.peakBytes / 1024.0f);
+				ImGui::TableNextColumn(); ImGui::Text("%lld", (long long)tagStats.aliveAllocations);
+			}
+			ImGui::EndTable();
+		}
+
+		int samplingRate = (int)MemoryTracker::samplingRate();
+		if(ImGui::DragInt("Call site sampling rate", &samplingRate, 1.0f, 0, 1000000)) {
+			MemoryTracker::setSamplingRate((uint32_t)std::max(samplingRate, 0));
+		}
+
+		if(ImGui::Button("Log memory report")) {
+			Log::info(MemoryTracker::report().str());
+		}
+		ImGui::SameLine();
+		if(ImGui::Button("Reset peaks")) {
+			MemoryTracker::resetPeaks();
+		}
+
+		ImGui::Separator();
+
+		GPUProfiler& gpuProfiler = WorldRenderer::get().gpuProfiler();
+
+		if(!gpuProfiler.timestampsSupported()) {
+			ImGui::TextUnformatted("GPU timestamps are not supported by this device");
+			return;
+		}
+
+		bool gpuProfiling = gpuProfiler.enabled();
+		if(ImGui::Checkbox("GPU profiling", &gpuProfiling)) {
+			gpuProfiler.setEnabled(gpuProfiling);
+		}
+
+		if(gpuProfiler.pipelineStatisticsSupported()) {
+			ImGui::SameLine();
+			bool pipelineStatistics = gpuProfiler.pipelineStatisticsEnabled();
+			if(ImGui::Checkbox("Pipeline statistics", &pipelineStatistics)) {
+				gpuProfiler.setPipelineStatisticsEnabled(pipelineStatistics);
+			}
+		}
+
+		const GPUFrameTimings& gpuFrame = gpuProfiler.lastFrame();
+		ImGui::Text("GPU frame %zu: %.3f ms%s", gpuFrame.frame, gpuFrame.totalMs, gpuFrame.calibrated ? "" : " (not calibrated)");
+
+		if(ImGui::BeginTable("GPUPasses", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+			ImGui::TableSetupColumn("Pass");
+			ImGui::TableSetupColumn("Start (ms)");
+			ImGui::TableSetupColumn("Time (ms)");
+			ImGui::TableSetupColumn("Vertices");
+			ImGui::TableSetupColumn("Primitives");
+			ImGui::TableSetupColumn("Fragments");
+			ImGui::TableHeadersRow();
+			for(const GPUPassTiming& pass : gpuFrame.passes) {
+				ImGui::TableNextRow();
+				ImGui::TableNextColumn(); ImGui::TextUnformatted(pass.name.c_str());
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", pass.startMs);
+				ImGui::TableNextColumn(); ImGui::Text("%.3f", pass.durationMs);
+				if(pass.hasStatistics) {
+					ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)pass.statistics.inputAssemblyVertices);
+					ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)pass.statistics.clippingPrimitives);
+					ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)pass.statistics.fragmentShaderInvocations);
+				} else {
+					ImGui::TableNextColumn(); ImGui::TextUnformatted("-");
+					ImGui::TableNextColumn(); ImGui::TextUnformatted("-");
+					ImGui::TableNextColumn(); ImGui::TextUnformatted("-");
+				}
+			}
+			ImGui::EndTable();
+		}
+	}
+
 	EditorCamera &MiloEditor::camera() {
 		return s_Camera;
 	}
 
+	EntityId MiloEditor::selectedEntity() {
+		return s_SceneHierarchyPanel.selectedEntity().id();
+	}
+
 	void MiloEditor::init() {
 		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
 			s_Renderer = new VulkanUIRenderer();
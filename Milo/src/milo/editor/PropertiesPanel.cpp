@@ -180,11 +180,7 @@ namespace milo {
 			Mesh* mesh = meshView.mesh;
 			ImGui::Text("Mesh");
 			if(mesh != nullptr) {
-				if(mesh->icon()) {
-					UI::image(*mesh->icon());
-				} else {
-					UI::image(*Assets::textures().getIcon("DefaultMeshIcon"));
-				}
+				UI::icon(mesh->icon());
 				ImGui::SameLine();
 				ImGui::Text(mesh->name().c_str());
 			}
@@ -202,11 +198,7 @@ namespace milo {
 			Material* material = meshView.material;
 			ImGui::Text("Material");
 			if(material != nullptr) {
-				if(mesh->icon()) {
-					UI::image(*material->icon());
-				} else {
-					UI::image(*Assets::textures().getIcon("DefaultMaterialIcon"));
-				}
+				UI::icon(material->icon());
 				ImGui::SameLine();
 				ImGui::Text(material->name().c_str());
 			}
@@ -261,6 +253,11 @@ namespace milo {
 					skyboxView.skybox->prefilterLODBias(prefilterLodBias);
 				}
 
+				bool incremental = sky->updateMode() == PreethamSkyUpdateMode::Incremental;
+				if(ImGui::Checkbox("Incremental update", &incremental)) {
+					sky->updateMode(incremental ? PreethamSkyUpdateMode::Incremental : PreethamSkyUpdateMode::Immediate);
+				}
+
 				if(ImGui::DragFloat("Turbidity", &turbidity, 0.01f, 0.0f)) {
 					sky->turbidity(turbidity);
 				}
@@ -0,0 +1,214 @@
+#include "milo/editor/SceneHierarchyCache.h"
+#include "milo/scenes/Entity.h"
+#include <cctype>
+
+namespace milo {
+
+	static const size_t NO_ROW = SIZE_MAX;
+
+	static String toLowerCase(const String& str) {
+		String result = str;
+		for(char& c : result) c = (char)std::tolower((unsigned char)c);
+		return result;
+	}
+
+	// "PointLight_02.mesh" starts a word at "Point", "Light", "02" and "mesh"
+	static bool isWordStart(const String& name, size_t i) {
+		const unsigned char c = name[i];
+		if(!std::isalnum(c)) return false;
+		if(i == 0) return true;
+		const unsigned char previous = name[i - 1];
+		if(!std::isalnum(previous)) return true;
+		if(std::isupper(c) && std::islower(previous)) return true;
+		return (bool)std::isdigit(c) != (bool)std::isdigit(previous);
+	}
+
+	void SceneHierarchyCache::update(Scene* scene) {
+
+		if(scene != m_Scene) {
+			m_Scene = scene;
+			m_Expanded.clear();
+		}
+
+		if(m_Scene == nullptr) {
+			if(!m_Rows.empty() || !m_NameIndex.empty()) {
+				m_Rows.clear();
+				m_NameIndex.clear();
+				m_IndexedNames.clear();
+				++m_Version;
+			}
+			return;
+		}
+
+		if(!m_Scene->consumeHierarchyChanges(m_Changes) || m_Changes.size() > MAX_INCREMENTAL_CHANGES) {
+			rebuild();
+			return;
+		}
+
+		if(m_Changes.empty()) return;
+
+		for(const SceneHierarchyChange& change : m_Changes) {
+			switch(change.type) {
+				case SceneHierarchyChange::Type::Created:
+					indexName(change.entity);
+					relocate(change.entity);
+					break;
+				case SceneHierarchyChange::Type::Reparented:
+					relocate(change.entity);
+					break;
+				case SceneHierarchyChange::Type::Renamed:
+					indexName(change.entity);
+					break;
+				case SceneHierarchyChange::Type::Destroyed:
+					remove(change.entity);
+					break;
+			}
+		}
+
+		++m_Version;
+	}
+
+	const ArrayList<SceneHierarchyCache::Row>& SceneHierarchyCache::rows() const {
+		return m_Rows;
+	}
+
+	uint64_t SceneHierarchyCache::version() const {
+		return m_Version;
+	}
+
+	bool SceneHierarchyCache::expanded(EntityId entityId) const {
+		return m_Expanded.find(entityId) != m_Expanded.end();
+	}
+
+	void SceneHierarchyCache::setExpanded(size_t row, bool expanded) {
+		if(row >= m_Rows.size()) return;
+		const EntityId entityId = m_Rows[row].entity;
+		if(expanded == this->expanded(entityId)) return;
+		if(expanded)
+			m_Expanded.insert(entityId);
+		else
+			m_Expanded.erase(entityId);
+		refreshChildren(row);
+		++m_Version;
+	}
+
+	void SceneHierarchyCache::search(const String& query, ArrayList<EntityId>& results) const {
+
+		results.clear();
+
+		const String key = toLowerCase(query);
+		if(key.empty()) return;
+
+		std::unordered_set<EntityId> found;
+		for(auto it = m_NameIndex.lower_bound({key, static_cast<EntityId>(0)});it != m_NameIndex.end();++it) {
+			if(it->first.compare(0, key.size(), key) != 0) break;
+			if(found.insert(it->second).second) results.push_back(it->second);
+		}
+	}
+
+	void SceneHierarchyCache::rebuild() {
+
+		m_Rows.clear();
+		m_NameIndex.clear();
+		m_IndexedNames.clear();
+
+		auto entities = m_Scene->view<EntityBasicInfo>();
+		for(EntityId entityId : entities) {
+			indexName(entityId);
+			if(entities.get<EntityBasicInfo>(entityId).parentId() == NULL_ENTITY) {
+				appendSubtree(entityId, 0, m_Rows);
+			}
+		}
+
+		++m_Version;
+	}
+
+	void SceneHierarchyCache::relocate(EntityId entityId) {
+
+		const size_t row = findRow(entityId);
+		if(row != NO_ROW) m_Rows.erase(m_Rows.begin() + row, m_Rows.begin() + subtreeEnd(row));
+
+		if(!m_Scene->exists(entityId)) return;
+
+		const EntityId parentId = m_Scene->find(entityId).getComponent<EntityBasicInfo>().parentId();
+		if(parentId == NULL_ENTITY) {
+			appendSubtree(entityId, 0, m_Rows);
+			return;
+		}
+
+		// Under a collapsed or hidden parent it has no row until the parent is expanded
+		const size_t parentRow = findRow(parentId);
+		if(parentRow != NO_ROW) refreshChildren(parentRow);
+	}
+
+	void SceneHierarchyCache::remove(EntityId entityId) {
+		const size_t row = findRow(entityId);
+		if(row != NO_ROW) m_Rows.erase(m_Rows.begin() + row, m_Rows.begin() + subtreeEnd(row));
+		m_Expanded.erase(entityId);
+		unindexName(entityId);
+	}
+
+	void SceneHierarchyCache::refreshChildren(size_t row) {
+
+		m_Rows.erase(m_Rows.begin() + row + 1, m_Rows.begin() + subtreeEnd(row));
+
+		const Row& parent = m_Rows[row];
+		if(!expanded(parent.entity) || !m_Scene->exists(parent.entity)) return;
+
+		ArrayList<Row> children;
+		for(EntityId childId : m_Scene->find(parent.entity).children()) {
+			appendSubtree(childId, parent.depth + 1, children);
+		}
+		m_Rows.insert(m_Rows.begin() + row + 1, children.begin(), children.end());
+	}
+
+	void SceneHierarchyCache::appendSubtree(EntityId entityId, uint32_t depth, ArrayList<Row>& rows) const {
+		if(!m_Scene->exists(entityId)) return;
+		rows.push_back({entityId, depth});
+		if(!expanded(entityId)) return;
+		for(EntityId childId : m_Scene->find(entityId).children()) {
+			appendSubtree(childId, depth + 1, rows);
+		}
+	}
+
+	size_t SceneHierarchyCache::findRow(EntityId entityId) const {
+		for(size_t i = 0;i < m_Rows.size();++i) {
+			if(m_Rows[i].entity == entityId) return i;
+		}
+		return NO_ROW;
+	}
+
+	size_t SceneHierarchyCache::subtreeEnd(size_t row) const {
+		const uint32_t depth = m_Rows[row].depth;
+		size_t end = row + 1;
+		while(end < m_Rows.size() && m_Rows[end].depth > depth) ++end;
+		return end;
+	}
+
+	void SceneHierarchyCache::indexName(EntityId entityId) {
+
+		unindexName(entityId);
+
+		if(!m_Scene->exists(entityId)) return;
+
+		const String& name = m_Scene->find(entityId).name();
+		const String lowerCaseName = toLowerCase(name);
+		for(size_t i = 0;i < name.size();++i) {
+			if(isWordStart(name, i)) m_NameIndex.insert({lowerCaseName.substr(i), entityId});
+		}
+		m_IndexedNames[entityId] = name;
+	}
+
+	void SceneHierarchyCache::unindexName(EntityId entityId) {
+
+		auto it = m_IndexedNames.find(entityId);
+		if(it == m_IndexedNames.end()) return;
+
+		const String& name = it->second;
+		const String lowerCaseName = toLowerCase(name);
+		for(size_t i = 0;i < name.size();++i) {
+			if(isWordStart(name, i)) m_NameIndex.erase({lowerCaseName.substr(i), entityId});
+		}
+		m_IndexedNames.erase(it);
+	}
+}
\ No newline at end of file
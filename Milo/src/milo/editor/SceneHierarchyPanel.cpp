@@ -47,16 +47,16 @@ namespace milo {
 
 		Scene* scene = SceneManager::activeScene();
 
+		m_Cache.update(scene);
+
 		ImRect windowRect = { ImGui::GetWindowContentRegionMin(), ImGui::GetWindowContentRegionMax() };
 
-		auto entities = scene->view<EntityBasicInfo>();
-		for(EntityId entityId : entities) {
-			Entity entity = scene->find(entityId);
-			const EntityBasicInfo& info = entities.get<EntityBasicInfo>(entityId);
-			if(info.parentId() == NULL_ENTITY) {
-				drawEntityNode(entity, info);
-			}
-		}
+		drawSearchBox();
+
+		if(m_SearchQuery[0] != '\0')
+			drawSearchResults(scene);
+		else
+			drawHierarchy(scene);
 
 		handleDragDrop(windowRect);
 
@@ -65,6 +65,84 @@ namespace milo {
 		ImGui::End();
 	}
 
+	void SceneHierarchyPanel::drawSearchBox() {
+
+		ImGui::SetNextItemWidth(-1.0f);
+		const bool changed = ImGui::InputTextWithHint("##Search", "Search", m_SearchQuery, sizeof(m_SearchQuery));
+
+		// Looked up again only when the query or the scene changes, not every frame
+		if(changed || m_SearchVersion != m_Cache.version()) {
+			m_Cache.search(m_SearchQuery, m_SearchResults);
+			m_SearchVersion = m_Cache.version();
+		}
+	}
+
+	void SceneHierarchyPanel::drawHierarchy(Scene* scene) {
+
+		const ArrayList<SceneHierarchyCache::Row>& rows = m_Cache.rows();
+		const float indentSpacing = ImGui::GetStyle().IndentSpacing;
+
+		// Expanding or collapsing a node changes the rows, so it is deferred until they are all drawn
+		size_t toggledRow = SIZE_MAX;
+		bool toggledOpen = false;
+		Entity deletedEntity = {NULL_ENTITY, nullptr};
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)rows.size());
+		while(clipper.Step()) {
+			for(int i = clipper.DisplayStart;i < clipper.DisplayEnd;++i) {
+
+				const SceneHierarchyCache::Row& row = rows[i];
+				Entity entity = scene->find(row.entity);
+				const bool leaf = entity.children().empty();
+				const bool expanded = m_Cache.expanded(row.entity);
+
+				ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_NoTreePushOnOpen;
+				if(leaf) flags |= ImGuiTreeNodeFlags_Leaf;
+
+				const float indent = (float)row.depth * indentSpacing;
+				if(indent > 0.0f) ImGui::Indent(indent);
+
+				ImGui::SetNextItemOpen(expanded);
+				bool deleted = false;
+				const bool opened = drawEntityNode(entity, flags, deleted);
+
+				if(indent > 0.0f) ImGui::Unindent(indent);
+
+				if(!leaf && opened != expanded) {
+					toggledRow = i;
+					toggledOpen = opened;
+				}
+				if(deleted) deletedEntity = entity;
+			}
+		}
+		clipper.End();
+
+		if(toggledRow != SIZE_MAX) m_Cache.setExpanded(toggledRow, toggledOpen);
+
+		if(deletedEntity) deleteEntity(deletedEntity);
+	}
+
+	void SceneHierarchyPanel::drawSearchResults(Scene* scene) {
+
+		Entity deletedEntity = {NULL_ENTITY, nullptr};
+
+		ImGuiListClipper clipper;
+		clipper.Begin((int)m_SearchResults.size());
+		while(clipper.Step()) {
+			for(int i = clipper.DisplayStart;i < clipper.DisplayEnd;++i) {
+				if(!scene->exists(m_SearchResults[i])) continue;
+				Entity entity = scene->find(m_SearchResults[i]);
+				bool deleted = false;
+				drawEntityNode(entity, ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen, deleted);
+				if(deleted) deletedEntity = entity;
+			}
+		}
+		clipper.End();
+
+		if(deletedEntity) deleteEntity(deletedEntity);
+	}
+
 	void SceneHierarchyPanel::handlePopupMenu(Scene* scene) {
 
 		if (ImGui::BeginPopupContextWindow(nullptr, 1, false))
@@ -171,18 +249,13 @@ namespace milo {
 		}
 	}
 
-	void SceneHierarchyPanel::drawEntityNode(Entity& entity, const EntityBasicInfo& info) {
-
-		if(!entity.valid()) return;
+	bool SceneHierarchyPanel::drawEntityNode(Entity& entity, ImGuiTreeNodeFlags flags, bool& deleted) {
 
-		const String& name = info.name();
+		const String& name = entity.name();
 
-		ImGuiTreeNodeFlags flags = (entity == m_SelectedEntity ? ImGuiTreeNodeFlags_Selected : 0) | ImGuiTreeNodeFlags_OpenOnArrow;
+		flags |= (entity == m_SelectedEntity ? ImGuiTreeNodeFlags_Selected : 0) | ImGuiTreeNodeFlags_OpenOnArrow;
 		flags |= ImGuiTreeNodeFlags_SpanAvailWidth;
 
-		if (entity.children().empty())
-			flags |= ImGuiTreeNodeFlags_Leaf;
-
 		const bool opened = ImGui::TreeNodeEx((void*)(uint64_t)(uint32_t)entity.id(), flags, name.c_str());
 
 		if (ImGui::IsItemClicked()) {
@@ -193,10 +266,9 @@ namespace milo {
 			MiloEditor::camera().setPosition(entity.getComponent<Transform>().translation());
 		}
 
-		bool entityDeleted = false;
 		if (ImGui::BeginPopupContextItem()) {
 			if (ImGui::MenuItem("Delete"))
-				entityDeleted = true;
+				deleted = true;
 
 			ImGui::EndPopup();
 		}
@@ -218,26 +290,18 @@ namespace milo {
 			ImGui::EndDragDropTarget();
 		}
 
-		if (opened) {
-			for (EntityId child : entity.children()) {
-				Entity e = entity.scene()->find(child);
-				if (e.valid()) drawEntityNode(e, e.getComponent<EntityBasicInfo>());
-			}
+		return opened;
+	}
 
-			ImGui::TreePop();
+	void SceneHierarchyPanel::deleteEntity(Entity entity) {
+		Log::warn("Deleting {}", entity.name());
+		Scene* scene = entity.scene();
+		scene->destroyEntity(entity.id());
+		if(entity.id() == m_SelectedEntity.id()) {
+			unselect();
 		}
-
-		// Defer deletion until end of node UI
-		if (entityDeleted) {
-			Log::warn("Deleting {}", name);
-			Scene* scene = entity.scene();
-			scene->destroyEntity(entity.id());
-			if(entity.id() == m_SelectedEntity.id()) {
-				unselect();
-			}
-			for(auto& callback : m_DeletedCallbacks) {
-				callback(entity);
-			}
+		for(auto& callback : m_DeletedCallbacks) {
+			callback(entity);
 		}
 	}
 }
\ No newline at end of file
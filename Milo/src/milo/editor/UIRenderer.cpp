@@ -23,12 +23,13 @@ namespace milo::UI {
 
 			auto& vkTexture = (VulkanTexture2D&) (texture);
 
+			// The UI renderer flushes the transition before drawing, so the texture is read only by the time it is sampled
 			if (vkTexture.layout() != VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-				vkTexture.setLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+				vkTexture.requestLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 			}
 
 			return ImGui_ImplVulkan_AddTexture(vkTexture.id(), vkTexture.vkSampler(),
-																vkTexture.vkImageView(), vkTexture.layout());
+																vkTexture.vkImageView(), VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 		}
 
 		return nullptr;
@@ -58,6 +59,25 @@ namespace milo::UI {
 		}
 	}
 
+	void icon(const Icon& icon, const Size& size) {
+
+		if(!icon) return;
+
+		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
+
+			ImTextureID textureId = getIconId(*icon.texture);
+
+			const Size& iconSize = size.isZero() ? icon.size : size;
+
+			// Flipped inside its own region, since the region may be part of an atlas
+			ImGui::Image(textureId, {(float)iconSize.width, (float)iconSize.height},
+						 {icon.uv0.x, icon.uv1.y}, {icon.uv1.x, icon.uv0.y});
+
+		} else {
+			throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
+		}
+	}
+
 	void imageButton(const String& title, const Texture2D& texture, const Size& size) {
 
 
@@ -35,12 +35,15 @@ namespace milo {
 
 		VulkanTexture2D* texture = (VulkanTexture2D*) m_Framebuffer->colorAttachments()[0];
 
-		texture->setLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+		// The material renderers replay prebuilt command buffers and wait for them, so this one cannot be batched
+		texture->setLayoutImmediate(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
 
 		m_MaterialPBRRenderer->render(material);
 		m_MaterialSkyboxRenderer->render();
 
-		texture->setLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// Sampled by the UI, which flushes it before drawing
+		texture->setCurrentLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		texture->requestLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 
 		return *texture;
 	}
@@ -1,6 +1,7 @@
 #include "milo/events/EventSystem.h"
 #include <GLFW/glfw3.h>
 #include "milo/time/Profiler.h"
+#include "milo/graphics/Window.h"
 
 #define MAX_EVENT_COUNT (16 * 1024)
 
@@ -38,6 +39,8 @@ namespace milo {
 	}
 
 	void EventSystem::pollEvents() {
+		// GLFW is not even initialized in headless mode
+		if(Window::get() == nullptr) return;
 		glfwPollEvents();
 	}
 
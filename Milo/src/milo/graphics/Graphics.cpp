@@ -1,10 +1,13 @@
 #include "milo/graphics/Graphics.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/core/Application.h"
 
 namespace milo {
 
 	GraphicsAPI Graphics::s_GraphicsAPI = GraphicsAPI::Default;
 	GraphicsContext* Graphics::s_GraphicsContext = nullptr;
+	bool Graphics::s_Headless = false;
+	Size Graphics::s_OffscreenSize = WINDOW_DEFAULT_SIZE;
 
 	GraphicsAPI Graphics::graphicsAPI() {
 		return s_GraphicsAPI;
@@ -17,13 +20,29 @@ namespace milo {
 		return s_GraphicsContext;
 	}
 
+	bool Graphics::headless() {
+		return s_Headless;
+	}
+
+	Size Graphics::renderTargetSize() {
+		if(Window::get() != nullptr) return Window::get()->size();
+		return s_OffscreenSize;
+	}
+
 	void Graphics::init() {
 
-		WindowInfo windowInfo = {};
-		windowInfo.title = "Milo Engine";
-		windowInfo.graphicsAPI = graphicsAPI();
+		const HeadlessConfiguration& headless = Application::get().configuration().headless;
+		s_Headless = headless.enabled;
 
-		Window::s_MainWindow = new Window(windowInfo);
+		if(s_Headless) {
+			s_OffscreenSize = headless.size;
+		} else {
+			WindowInfo windowInfo = {};
+			windowInfo.title = "Milo Engine";
+			windowInfo.graphicsAPI = graphicsAPI();
+
+			Window::s_MainWindow = new Window(windowInfo);
+		}
 
 		if(graphicsAPI() == GraphicsAPI::Vulkan) {
 			s_GraphicsContext = new VulkanContext();
@@ -31,11 +50,13 @@ namespace milo {
 			// TODO
 			throw MILO_RUNTIME_EXCEPTION("Not implemented");
 		}
+		// Null when headless
 		s_GraphicsContext->init(Window::getMainWindow());
 	}
 
 	void Graphics::shutdown() {
 		DELETE_PTR(s_GraphicsContext);
 		DELETE_PTR(Window::s_MainWindow);
+		s_Headless = false;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,54 @@
+#include "milo/graphics/rendering/EntityPicker.h"
+
+namespace milo {
+
+	void EntityPicker::pick(uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+		std::lock_guard<Mutex> lock(m_Mutex);
+		m_Request = EntityPickRegion{x, y, std::clamp(width, 1u, MAX_REGION_SIZE), std::clamp(height, 1u, MAX_REGION_SIZE)};
+	}
+
+	bool EntityPicker::poll(EntityPickResult& result) {
+		std::lock_guard<Mutex> lock(m_Mutex);
+		if(!m_Result.has_value()) return false;
+		result = std::move(m_Result.value());
+		m_Result.reset();
+		return true;
+	}
+
+	bool EntityPicker::takeRequest(EntityPickRegion& region) {
+		std::lock_guard<Mutex> lock(m_Mutex);
+		if(!m_Request.has_value()) return false;
+		region = m_Request.value();
+		m_Request.reset();
+		return true;
+	}
+
+	void EntityPicker::resolve(const EntityPickRegion& region, const uint32_t* ids) {
+
+		ArrayList<Pair<EntityId, uint32_t>> counts;
+
+		const uint32_t texelCount = region.width * region.height;
+		for(uint32_t i = 0;i < texelCount;++i) {
+			const EntityId entity = static_cast<EntityId>(ids[i]);
+			if(entity == NULL_ENTITY) continue;
+			// A region holds a handful of distinct entities at most, a linear search beats hashing
+			auto it = std::find_if(counts.begin(), counts.end(), [&](const auto& count) {return count.first == entity;});
+			if(it == counts.end())
+				counts.emplace_back(entity, 1);
+			else
+				++it->second;
+		}
+
+		std::stable_sort(counts.begin(), counts.end(), [](const auto& a, const auto& b) {return a.second > b.second;});
+
+		EntityPickResult result;
+		result.region = region;
+		result.entities.reserve(counts.size());
+		for(const auto& [entity, count] : counts) {
+			result.entities.push_back(entity);
+		}
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+		m_Result = std::move(result);
+	}
+}
\ No newline at end of file
@@ -2,23 +2,27 @@
 #include "milo/scenes/SceneManager.h"
 #include "milo/graphics/rendering/passes/AllRenderPasses.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
+#include "milo/graphics/Graphics.h"
 #include "milo/time/Profiler.h"
+#include <boost/container_hash/hash.hpp>
 
 namespace milo {
 
 	FrameGraph::FrameGraph() {
 		m_RenderPasses.reserve(16);
-		m_RenderPassExecutionList.reserve(m_RenderPasses.capacity());
+		m_RenderPassesById.reserve(m_RenderPasses.capacity());
 	}
 
 	FrameGraph::~FrameGraph() {
 		for(RenderPass* renderPass : m_RenderPasses) {
 			DELETE_PTR(renderPass);
 		}
+		DELETE_PTR(m_GPUProfiler);
 	}
 
 	void FrameGraph::init(FrameGraphResourcePool* resourcePool) {
 		m_ResourcePool = resourcePool;
+		m_GPUProfiler = GPUProfiler::create();
 	}
 
 	void FrameGraph::setup(Scene* scene) {
@@ -27,6 +31,8 @@ namespace milo {
 
 		const WorldRenderer& renderer = WorldRenderer::get();
 
+		m_RenderPassExecutionList = newFrameArrayList<RenderPass*>(m_RenderPasses.capacity());
+
 		push<PreDepthRenderPass>();
 		push<LightCullingPass>();
 		push<ShadowMapRenderPass>();
@@ -45,20 +51,39 @@ namespace milo {
 			push<GridRenderPass>();
 		}
 
-		if(getSimulationState() != SimulationState::Editor) {
+		// Declared whether or not something is selected, so selecting does not change the topology and rebuild the graph.
+		// The pass skips its draw when nothing is selected
+		if(renderer.renderEntityIds()) {
+			push<SelectionOutlineRenderPass>();
+		}
+
+		// Headless frames have no swapchain image to blit to, the presenter reads back the default framebuffer instead
+		if(renderer.frameData().simulationState != SimulationState::Editor && !Graphics::headless()) {
 			push<FinalRenderPass>();
 		}
 	}
 
 	void FrameGraph::compile(Scene* scene) {
+
 		MILO_PROFILE_FUNCTION;
+
 		m_ResourcePool->compile(scene);
-		for(RenderPass* pass : m_RenderPassExecutionList) {
+
+		const size_t topologyHash = declarePasses();
+
+		if(m_CompiledGraph.version == 0 || topologyHash != m_CompiledGraph.topologyHash) {
+			build(topologyHash);
+			m_ResourcePool->realize(m_CompiledGraph);
+		}
+
+		for(const CompiledFrameGraphPass& compiledPass : m_CompiledGraph.passes) {
+			RenderPass* pass = compiledPass.pass;
 			if(pass->shouldCompile(scene)) {
 				Log::debug("Compiling {}", pass->name());
 				pass->compile(scene, m_ResourcePool);
 			}
 		}
+
 		deleteUnusedRenderPasses();
 	}
 
@@ -66,12 +91,408 @@ namespace milo {
 
 		MILO_PROFILE_FUNCTION;
 
-		for(RenderPass* renderPass : m_RenderPassExecutionList) {
+		m_GPUProfiler->beginFrame();
+		for(uint32_t i = 0;i < m_CompiledGraph.passes.size();++i) {
+			RenderPass* renderPass = m_CompiledGraph.passes[i].pass;
+			m_GPUProfiler->beginPass(renderPass->name());
+			m_ResourcePool->beginPass(m_CompiledGraph, i);
 			renderPass->execute(scene);
+			m_ResourcePool->endPass(m_CompiledGraph, i);
+			m_GPUProfiler->endPass();
 		}
+		m_GPUProfiler->endFrame();
+
 		m_RenderPassExecutionList.clear();
 	}
 
+	GPUProfiler& FrameGraph::gpuProfiler() const {
+		return *m_GPUProfiler;
+	}
+
+	const CompiledFrameGraph& FrameGraph::compiledGraph() const {
+		return m_CompiledGraph;
+	}
+
+	size_t FrameGraph::declarePasses() {
+
+		m_Resources.clear();
+
+		if(m_Declarations.size() < m_RenderPassExecutionList.size()) {
+			m_Declarations.resize(m_RenderPassExecutionList.size());
+		}
+
+		size_t hash = 0;
+
+		for(uint32_t i = 0;i < m_RenderPassExecutionList.size();++i) {
+
+			FrameGraphPassDeclaration& declaration = m_Declarations[i];
+			declaration.clear();
+			declaration.pass = m_RenderPassExecutionList[i];
+
+			FrameGraphBuilder builder(declaration, m_Resources);
+			declaration.pass->declareResources(builder);
+
+			boost::hash_combine(hash, declaration.pass->getId());
+			boost::hash_combine(hash, (uint32_t)declaration.queue);
+			boost::hash_combine(hash, declaration.sideEffects);
+			for(const FrameGraphResourceUse& use : declaration.reads) {
+				boost::hash_combine(hash, use.resource);
+				boost::hash_combine(hash, (uint32_t)use.access);
+			}
+			boost::hash_combine(hash, declaration.reads.size());
+			for(const FrameGraphResourceUse& use : declaration.writes) {
+				boost::hash_combine(hash, use.resource);
+				boost::hash_combine(hash, (uint32_t)use.access);
+			}
+			boost::hash_combine(hash, declaration.writes.size());
+		}
+
+		// Iteration order of the map is unspecified, so resources are combined with an order independent operation
+		size_t resourcesHash = 0;
+		for(const auto& [id, resource] : m_Resources) {
+			size_t resourceHash = id;
+			boost::hash_combine(resourceHash, (uint32_t)resource.kind);
+			boost::hash_combine(resourceHash, resource.exported);
+			boost::hash_combine(resourceHash, (uint32_t)resource.description.format);
+			boost::hash_combine(resourceHash, resource.description.size.width);
+			boost::hash_combine(resourceHash, resource.description.size.height);
+			boost::hash_combine(resourceHash, resource.description.layers);
+			boost::hash_combine(resourceHash, resource.description.usage);
+			resourcesHash ^= resourceHash;
+		}
+		boost::hash_combine(hash, resourcesHash);
+
+		return hash;
+	}
+
+	void FrameGraph::build(size_t topologyHash) {
+
+		MILO_PROFILE_FUNCTION;
+
+		const uint32_t passCount = m_RenderPassExecutionList.size();
+
+		for(uint32_t i = 0;i < passCount;++i) {
+			const FrameGraphPassDeclaration& declaration = m_Declarations[i];
+			for(const auto* uses : {&declaration.reads, &declaration.writes}) {
+				for(const FrameGraphResourceUse& use : *uses) {
+					if(m_Resources.find(use.resource) == m_Resources.end()) {
+						throw MILO_RUNTIME_EXCEPTION(str("Pass ") + declaration.pass->name() + " uses a resource that nobody declared");
+					}
+				}
+			}
+		}
+
+		ArrayList<uint32_t> order;
+		sortPasses(order);
+
+		ArrayList<bool> alive;
+		cullPasses(order, alive);
+
+		m_CompiledGraph.passes.clear();
+		m_CompiledGraph.transientTextures.clear();
+		m_CompiledGraph.culledPassCount = 0;
+
+		for(uint32_t index : order) {
+
+			if(!alive[index]) {
+				++m_CompiledGraph.culledPassCount;
+				continue;
+			}
+
+			const FrameGraphPassDeclaration& declaration = m_Declarations[index];
+
+			CompiledFrameGraphPass& compiledPass = m_CompiledGraph.passes.emplace_back();
+			compiledPass.pass = declaration.pass;
+			compiledPass.queue = declaration.queue;
+
+			// A resource both read and written by the same pass only needs the state of the write
+			for(const FrameGraphResourceUse& write : declaration.writes) {
+				compiledPass.uses.push_back(write);
+			}
+			for(const FrameGraphResourceUse& read : declaration.reads) {
+				bool written = false;
+				for(const FrameGraphResourceUse& use : compiledPass.uses) {
+					if(use.resource == read.resource) {
+						written = true;
+						break;
+					}
+				}
+				if(!written) compiledPass.uses.push_back(read);
+			}
+		}
+
+		assignTransientMemory();
+		computeBarriers();
+
+		m_CompiledGraph.topologyHash = topologyHash;
+		++m_CompiledGraph.version;
+
+		Log::debug("Frame graph built: {} passes ({} culled), {} transient textures in {} memory slots",
+				   m_CompiledGraph.passes.size(), m_CompiledGraph.culledPassCount,
+				   m_CompiledGraph.transientTextures.size(), m_CompiledGraph.aliasSlotCount);
+	}
+
+	void FrameGraph::sortPasses(ArrayList<uint32_t>& order) const {
+
+		const uint32_t passCount = m_RenderPassExecutionList.size();
+
+		ArrayList<ArrayList<uint32_t>> successors(passCount);
+		ArrayList<uint32_t> predecessorsCount(passCount, 0);
+
+		auto addEdge = [&](uint32_t from, uint32_t to) {
+			if(from == to) return;
+			successors[from].push_back(to);
+			++predecessorsCount[to];
+		};
+
+		// Writers of a resource run in the order they were pushed. Readers run after the last writer
+		HashMap<FrameGraphResourceId, uint32_t> lastWriters;
+		for(uint32_t i = 0;i < passCount;++i) {
+			for(const FrameGraphResourceUse& write : m_Declarations[i].writes) {
+				auto it = lastWriters.find(write.resource);
+				if(it != lastWriters.end()) addEdge(it->second, i);
+				lastWriters[write.resource] = i;
+			}
+		}
+
+		for(uint32_t i = 0;i < passCount;++i) {
+			for(const FrameGraphResourceUse& read : m_Declarations[i].reads) {
+				auto it = lastWriters.find(read.resource);
+				if(it != lastWriters.end()) addEdge(it->second, i);
+			}
+		}
+
+		// Passes that do not declare anything keep their place in the list, as before the graph existed
+		for(uint32_t i = 0;i < passCount;++i) {
+			if(!m_Declarations[i].reads.empty() || !m_Declarations[i].writes.empty()) continue;
+			for(uint32_t j = 0;j < passCount;++j) {
+				if(j < i) addEdge(j, i);
+				else if(j > i) addEdge(i, j);
+			}
+		}
+
+		// Kahn's algorithm. Among the passes ready to run, the one pushed first goes first
+		order.clear();
+		order.reserve(passCount);
+		ArrayList<bool> scheduled(passCount, false);
+
+		while(order.size() < passCount) {
+
+			uint32_t next = UINT32_MAX;
+			for(uint32_t i = 0;i < passCount;++i) {
+				if(!scheduled[i] && predecessorsCount[i] == 0) {
+					next = i;
+					break;
+				}
+			}
+
+			if(next == UINT32_MAX) {
+				throw MILO_RUNTIME_EXCEPTION("Frame graph has a dependency cycle");
+			}
+
+			scheduled[next] = true;
+			order.push_back(next);
+
+			for(uint32_t successor : successors[next]) {
+				--predecessorsCount[successor];
+			}
+		}
+	}
+
+	void FrameGraph::cullPasses(const ArrayList<uint32_t>& order, ArrayList<bool>& alive) {
+
+		alive.assign(m_RenderPassExecutionList.size(), false);
+
+		HashMap<FrameGraphResourceId, bool> neededResources;
+
+		// Walk backwards from the passes with observable results, keeping everything they depend on
+		for(auto it = order.rbegin();it != order.rend();++it) {
+
+			const FrameGraphPassDeclaration& declaration = m_Declarations[*it];
+
+			bool needed = declaration.sideEffects || (declaration.reads.empty() && declaration.writes.empty());
+
+			for(const FrameGraphResourceUse& write : declaration.writes) {
+				if(m_Resources.at(write.resource).exported || neededResources.find(write.resource) != neededResources.end()) {
+					needed = true;
+				}
+			}
+
+			if(!needed) continue;
+
+			alive[*it] = true;
+
+			// Every writer of a needed resource contributes to its final contents
+			for(const FrameGraphResourceUse& read : declaration.reads) {
+				neededResources[read.resource] = true;
+			}
+			for(const FrameGraphResourceUse& write : declaration.writes) {
+				neededResources[write.resource] = true;
+			}
+		}
+	}
+
+	struct FrameGraphResourceState {
+		FrameGraphAccess access{FrameGraphAccess::None};
+		FrameGraphQueue queue{FrameGraphQueue::Graphics};
+		uint32_t pass{UINT32_MAX};
+	};
+
+	void FrameGraph::computeBarriers() {
+
+		auto& passes = m_CompiledGraph.passes;
+
+		// State each resource is left in at the end of the frame, which is the state the next frame finds it in
+		HashMap<FrameGraphResourceId, FrameGraphResourceState> lastStates;
+		for(uint32_t i = 0;i < passes.size();++i) {
+			for(const FrameGraphResourceUse& use : passes[i].uses) {
+				lastStates[use.resource] = {use.access, passes[i].queue, i};
+			}
+		}
+
+		// The first use of a transient discards its contents, but must wait for the previous transient in the same memory
+		HashMap<FrameGraphResourceId, FrameGraphResourceState> previousOccupants;
+		for(const FrameGraphTransientTexture& transient : m_CompiledGraph.transientTextures) {
+			const FrameGraphTransientTexture* previous = nullptr;
+			const FrameGraphTransientTexture* last = nullptr;
+			for(const FrameGraphTransientTexture& other : m_CompiledGraph.transientTextures) {
+				if(other.aliasSlot != transient.aliasSlot) continue;
+				if(other.lastPass < transient.firstPass && (previous == nullptr || other.lastPass > previous->lastPass)) {
+					previous = &other;
+				}
+				if(last == nullptr || other.lastPass > last->lastPass) last = &other;
+			}
+			// Nothing before it in this frame: the last occupant of the previous frame
+			if(previous == nullptr) previous = last;
+			previousOccupants[transient.resource] = lastStates[previous->resource];
+		}
+
+		HashMap<FrameGraphResourceId, FrameGraphResourceState> states;
+
+		for(uint32_t i = 0;i < passes.size();++i) {
+
+			CompiledFrameGraphPass& pass = passes[i];
+			pass.barriers.clear();
+			pass.releases.clear();
+
+			for(const FrameGraphResourceUse& use : pass.uses) {
+
+				const FrameGraphResource& resource = m_Resources.at(use.resource);
+				if(resource.kind == FrameGraphResourceKind::External) continue;
+
+				auto it = states.find(use.resource);
+
+				FrameGraphBarrier barrier{};
+				barrier.resource = use.resource;
+				barrier.dstAccess = use.access;
+				barrier.dstQueue = pass.queue;
+
+				if(it == states.end() && resource.kind == FrameGraphResourceKind::Transient) {
+					const FrameGraphResourceState& previous = previousOccupants.at(use.resource);
+					barrier.srcAccess = previous.access;
+					barrier.srcQueue = previous.queue;
+					barrier.discard = true;
+					pass.barriers.push_back(barrier);
+				} else {
+					const FrameGraphResourceState& state = it == states.end() ? lastStates.at(use.resource) : it->second;
+					barrier.srcAccess = state.access;
+					barrier.srcQueue = state.queue;
+					const bool hazard = isWriteAccess(state.access) || isWriteAccess(use.access) || state.access != use.access;
+					if(hazard || state.queue != pass.queue) {
+						pass.barriers.push_back(barrier);
+						// Ownership must be released by the queue that used it last
+						if(state.queue != pass.queue) passes[state.pass].releases.push_back(barrier);
+					}
+				}
+
+				states[use.resource] = {use.access, pass.queue, i};
+			}
+		}
+	}
+
+	void FrameGraph::assignTransientMemory() {
+
+		auto& transients = m_CompiledGraph.transientTextures;
+
+		HashMap<FrameGraphResourceId, uint32_t> indices;
+		ArrayList<bool> usedByCompute;
+
+		for(uint32_t i = 0;i < m_CompiledGraph.passes.size();++i) {
+			const CompiledFrameGraphPass& pass = m_CompiledGraph.passes[i];
+			for(const FrameGraphResourceUse& use : pass.uses) {
+				const FrameGraphResource& resource = m_Resources.at(use.resource);
+				if(resource.kind != FrameGraphResourceKind::Transient) continue;
+				auto it = indices.find(use.resource);
+				if(it == indices.end()) {
+					indices[use.resource] = transients.size();
+					FrameGraphTransientTexture& transient = transients.emplace_back();
+					transient.resource = resource.id;
+					transient.name = resource.name;
+					transient.description = resource.description;
+					transient.firstPass = i;
+					transient.lastPass = i;
+					usedByCompute.push_back(pass.queue != FrameGraphQueue::Graphics);
+				} else {
+					transients[it->second].lastPass = i;
+					usedByCompute[it->second] = usedByCompute[it->second] || pass.queue != FrameGraphQueue::Graphics;
+				}
+			}
+		}
+
+		ArrayList<uint32_t> sorted(transients.size());
+		for(uint32_t i = 0;i < sorted.size();++i) sorted[i] = i;
+		std::sort(sorted.begin(), sorted.end(), [&](uint32_t a, uint32_t b) {
+			return transients[a].firstPass < transients[b].firstPass;
+		});
+
+		struct Slot {
+			uint32_t lastPass;
+			uint64_t size;
+			bool shared;
+		};
+		ArrayList<Slot> slots;
+
+		for(uint32_t index : sorted) {
+
+			FrameGraphTransientTexture& transient = transients[index];
+			const uint64_t size = transient.description.sizeInBytes();
+			// Transients touched by other queues keep their own memory, since aliasing them would need cross queue
+			// dependencies between frames
+			const bool shareable = !usedByCompute[index];
+
+			uint32_t bestSlot = UINT32_MAX;
+			if(shareable) {
+				for(uint32_t i = 0;i < slots.size();++i) {
+					const Slot& slot = slots[i];
+					if(!slot.shared || slot.lastPass >= transient.firstPass) continue;
+					// Prefer the smallest slot that already fits, otherwise the largest one, which grows the least
+					if(bestSlot == UINT32_MAX) {
+						bestSlot = i;
+						continue;
+					}
+					const Slot& best = slots[bestSlot];
+					const bool fits = slot.size >= size;
+					const bool bestFits = best.size >= size;
+					if((fits && (!bestFits || slot.size < best.size)) || (!fits && !bestFits && slot.size > best.size)) {
+						bestSlot = i;
+					}
+				}
+			}
+
+			if(bestSlot == UINT32_MAX) {
+				bestSlot = slots.size();
+				slots.push_back({0, 0, shareable});
+			}
+
+			Slot& slot = slots[bestSlot];
+			slot.lastPass = transient.lastPass;
+			slot.size = std::max(slot.size, size);
+			transient.aliasSlot = bestSlot;
+		}
+
+		m_CompiledGraph.aliasSlotCount = slots.size();
+	}
+
 	static constexpr uint32_t MAX_RENDER_PASS_UNUSED_COUNT = 600;
 
 	inline void FrameGraph::deleteUnusedRenderPasses() {
@@ -89,11 +510,15 @@ namespace milo {
 			}
 
 			if(false) {
-				uint32_t& count = m_RenderPassUnusedCount[renderPass->getId()];
+				const RenderPassId id = renderPass->getId();
+				uint32_t& count = m_RenderPassUnusedCount[id];
 				if(++count >= MAX_RENDER_PASS_UNUSED_COUNT) {
+					m_RenderPassesById.erase(id);
+					m_RenderPassUnusedCount.erase(id);
+					it = m_RenderPasses.erase(it);
 					DELETE_PTR(renderPass);
-					m_RenderPasses.erase(it);
-					m_RenderPassUnusedCount.erase(renderPass->getId());
+				} else {
+					++it;
 				}
 			} else {
 				++it;
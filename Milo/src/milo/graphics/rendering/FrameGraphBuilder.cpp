@@ -0,0 +1,100 @@
+#include "milo/graphics/rendering/FrameGraphBuilder.h"
+
+namespace milo {
+
+	bool isWriteAccess(FrameGraphAccess access) {
+		switch(access) {
+			case FrameGraphAccess::ColorAttachment:
+			case FrameGraphAccess::DepthAttachment:
+			case FrameGraphAccess::StorageWriteCompute:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	bool FrameGraphTextureDescription::operator==(const FrameGraphTextureDescription& other) const {
+		return format == other.format && size == other.size && layers == other.layers && usage == other.usage;
+	}
+
+	bool FrameGraphTextureDescription::operator!=(const FrameGraphTextureDescription& other) const {
+		return !(*this == other);
+	}
+
+	uint64_t FrameGraphTextureDescription::sizeInBytes() const {
+		return (uint64_t)size.width * (uint64_t)size.height * layers * PixelFormats::size(format);
+	}
+
+	void FrameGraphPassDeclaration::clear() {
+		pass = nullptr;
+		queue = FrameGraphQueue::Graphics;
+		sideEffects = false;
+		reads.clear();
+		writes.clear();
+	}
+
+	FrameGraphBuilder::FrameGraphBuilder(FrameGraphPassDeclaration& pass, HashMap<FrameGraphResourceId, FrameGraphResource>& resources)
+		: m_Pass(pass), m_Resources(resources) {
+	}
+
+	void FrameGraphBuilder::setQueue(FrameGraphQueue queue) {
+		m_Pass.queue = queue;
+	}
+
+	void FrameGraphBuilder::setSideEffects() {
+		m_Pass.sideEffects = true;
+	}
+
+	FrameGraphResourceId FrameGraphBuilder::createTexture(const String& name, const FrameGraphTextureDescription& description) {
+		FrameGraphResource& resource = declare(resourceId(name), name, FrameGraphResourceKind::Transient);
+		resource.description = description;
+		return resource.id;
+	}
+
+	FrameGraphResourceId FrameGraphBuilder::importResource(const String& name, bool exported) {
+		return importResource(resourceId(name), name, exported);
+	}
+
+	FrameGraphResourceId FrameGraphBuilder::importResource(FrameGraphResourceId id, const String& name, bool exported) {
+		FrameGraphResource& resource = declare(id, name, FrameGraphResourceKind::Imported);
+		resource.exported |= exported;
+		return resource.id;
+	}
+
+	FrameGraphResourceId FrameGraphBuilder::externalResource(const String& name, bool exported) {
+		FrameGraphResource& resource = declare(resourceId(name), name, FrameGraphResourceKind::External);
+		resource.exported |= exported;
+		return resource.id;
+	}
+
+	void FrameGraphBuilder::read(FrameGraphResourceId resource, FrameGraphAccess access) {
+		m_Pass.reads.push_back({resource, access});
+	}
+
+	void FrameGraphBuilder::write(FrameGraphResourceId resource, FrameGraphAccess access) {
+		m_Pass.writes.push_back({resource, access});
+	}
+
+	FrameGraphResource& FrameGraphBuilder::declare(FrameGraphResourceId id, const String& name, FrameGraphResourceKind kind) {
+
+		auto it = m_Resources.find(id);
+
+		if(it == m_Resources.end()) {
+			FrameGraphResource& resource = m_Resources[id];
+			resource.id = id;
+			resource.name = name;
+			resource.kind = kind;
+			return resource;
+		}
+
+		if(it->second.kind != kind) {
+			throw MILO_RUNTIME_EXCEPTION(str("Frame graph resource ") + name + " declared with different kinds");
+		}
+
+		return it->second;
+	}
+
+	FrameGraphResourceId FrameGraphBuilder::resourceId(const String& name) {
+		return hashcodeOf(name);
+	}
+}
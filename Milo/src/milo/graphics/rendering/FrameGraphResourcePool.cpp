@@ -2,9 +2,12 @@
 #include "milo/graphics/Graphics.h"
 #include "milo/graphics/vulkan/rendering/VulkanFrameGraphResourcePool.h"
 #include "milo/scenes/SceneManager.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
 
 namespace milo {
 
+	const String FrameGraphResourcePool::DEFAULT_FRAMEBUFFER = "DefaultFramebuffer";
+
 	FrameGraphResourcePool::FrameGraphResourcePool() {
 	}
 
@@ -22,7 +25,7 @@ namespace milo {
 
 	void FrameGraphResourcePool::compile(Scene* scene) {
 
-		const Size& sceneSize = scene->viewportSize();
+		const Size sceneSize = WorldRenderer::get().frameData().viewportSize();
 
 		if(sceneSize != m_DefaultFramebuffers[0]->size()) {
 			for(Framebuffer*& framebuffer : m_DefaultFramebuffers) {
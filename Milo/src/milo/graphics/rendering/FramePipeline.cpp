@@ -0,0 +1,99 @@
+#include "milo/graphics/rendering/FramePipeline.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	static_assert(FramePipeline::MAX_QUEUED_FRAMES > 0, "Pipelined rendering needs at least 3 frame arenas");
+
+	Thread FramePipeline::s_RenderThread;
+	Function<void, const FrameRenderData&> FramePipeline::s_RenderFunction;
+	Queue<const FrameRenderData*> FramePipeline::s_Queue;
+	Mutex FramePipeline::s_Mutex;
+	std::condition_variable FramePipeline::s_FramePushed;
+	std::condition_variable FramePipeline::s_FrameConsumed;
+	bool FramePipeline::s_Running = false;
+	bool FramePipeline::s_Rendering = false;
+	std::exception_ptr FramePipeline::s_Error = nullptr;
+
+	bool FramePipeline::running() {
+		return s_Running;
+	}
+
+	void FramePipeline::flush() {
+		if(!s_RenderThread.joinable()) return;
+		std::unique_lock<Mutex> lock(s_Mutex);
+		s_FrameConsumed.wait(lock, []() {return (s_Queue.empty() && !s_Rendering) || s_Error != nullptr;});
+		rethrowRenderError();
+	}
+
+	void FramePipeline::start(Function<void, const FrameRenderData&> renderFunction) {
+		if(s_RenderThread.joinable()) return;
+		s_RenderFunction = std::move(renderFunction);
+		s_Running = true;
+		s_RenderThread = Thread(renderThreadMain);
+		Log::info("Render thread started");
+	}
+
+	void FramePipeline::stop() {
+		if(!s_RenderThread.joinable()) return;
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_Running = false;
+		}
+		s_FramePushed.notify_all();
+		// Frames still in the queue are rendered before the thread exits
+		s_RenderThread.join();
+		s_Queue.clear();
+		s_Error = nullptr;
+		s_RenderFunction = nullptr;
+		Log::info("Render thread stopped");
+	}
+
+	void FramePipeline::push(const FrameRenderData& frame) {
+		{
+			std::unique_lock<Mutex> lock(s_Mutex);
+			s_FrameConsumed.wait(lock, []() {return s_Queue.size() < MAX_QUEUED_FRAMES || s_Error != nullptr;});
+			rethrowRenderError();
+			s_Queue.push_back(&frame);
+		}
+		s_FramePushed.notify_one();
+	}
+
+	void FramePipeline::renderThreadMain() {
+
+		while(true) {
+
+			const FrameRenderData* frame;
+			{
+				std::unique_lock<Mutex> lock(s_Mutex);
+				s_FramePushed.wait(lock, []() {return !s_Queue.empty() || !s_Running;});
+				if(s_Queue.empty()) return;
+				frame = s_Queue.front();
+				s_Queue.pop_front();
+				s_Rendering = true;
+			}
+			s_FrameConsumed.notify_all();
+
+			std::exception_ptr error = nullptr;
+			try {
+				s_RenderFunction(*frame);
+			} catch(ANY_EXCEPTION) {
+				error = std::current_exception();
+			}
+
+			{
+				std::lock_guard<Mutex> lock(s_Mutex);
+				s_Rendering = false;
+				s_Error = error;
+			}
+			s_FrameConsumed.notify_all();
+
+			// The error is kept, so every later push or flush rethrows it on the simulation thread
+			if(error != nullptr) return;
+		}
+	}
+
+	void FramePipeline::rethrowRenderError() {
+		if(s_Error != nullptr) std::rethrow_exception(s_Error);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#include "milo/graphics/rendering/GPUProfiler.h"
+#include "milo/graphics/Graphics.h"
+#include "milo/graphics/vulkan/rendering/VulkanGPUProfiler.h"
+
+namespace milo {
+
+	GPUProfiler* GPUProfiler::create() {
+		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
+			return new VulkanGPUProfiler();
+		}
+		throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
+	}
+}
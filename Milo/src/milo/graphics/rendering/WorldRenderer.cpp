@@ -4,6 +4,8 @@
 #include "milo/editor/MiloEditor.h"
 #include <algorithm>
 #include "milo/time/Profiler.h"
+#include "milo/assets/AssetManager.h"
+#include "milo/graphics/Graphics.h"
 
 namespace milo {
 
@@ -16,11 +18,6 @@ namespace milo {
 
 		m_FrameGraph.init(m_ResourcePool);
 
-		m_DrawCommands.reserve(8192);
-		m_ShadowDrawCommands.reserve(8192);
-
-		m_LightEnvironment.pointLights.reserve(1024);
-
 		//m_ShowGrid = getSimulationState() == SimulationState::Editor;
 	}
 
@@ -29,36 +26,82 @@ namespace milo {
 		DELETE_PTR(m_ResourcePool);
 	}
 
-	void WorldRenderer::render(Scene* scene) {
-		generateDrawCommands(scene);
-		m_FrameGraph.setup(scene);
-		m_FrameGraph.compile(scene);
-		m_FrameGraph.execute(scene);
+	void WorldRenderer::render(const FrameRenderData& frame) {
+		m_RenderFrame = &frame;
+		Assets::materials().beginFrame();
+		m_FrameGraph.setup(frame.scene);
+		m_FrameGraph.compile(frame.scene);
+		m_FrameGraph.execute(frame.scene);
 	}
 
 	void WorldRenderer::render() {
-		s_Instance->render(SceneManager::activeScene());
+		const FrameRenderData* frame = s_Instance->m_LastFrame;
+		// Frames without a simulation step reuse the last frame data, unless its frame arena has already been recycled
+		if(frame == nullptr || FrameArena::frame() - frame->frame >= FRAME_ARENA_BUFFER_COUNT) {
+			frame = &buildFrame(SceneManager::activeScene());
+			updateAssets(*frame);
+		}
+		s_Instance->render(*frame);
 	}
 
 	void WorldRenderer::update() {
-		Scene* scene = SceneManager::activeScene();
-		generateDrawCommands(scene);
+		updateAssets(buildFrame(SceneManager::activeScene()));
+	}
+
+	static const size_t DRAW_COMMANDS_INITIAL_CAPACITY = 8192;
+	static const size_t POINT_LIGHTS_INITIAL_CAPACITY = 1024;
+
+	FrameRenderData& WorldRenderer::buildFrame(Scene* scene) {
+		FrameRenderData& frame = s_Instance->m_Frames[FrameArena::currentIndex()];
+		prepareFrame(scene, frame);
+
+		// Taken here and not in prepareFrame, which must not modify the scene
+		frame.skyUpdate = {};
+		SkyboxView* skyboxView = scene->skyboxView();
+		if(skyboxView != nullptr && skyboxView->type == SkyType::Dynamic && skyboxView->skybox != nullptr) {
+			((PreethamSky*)skyboxView->skybox)->takeUpdateRequest(frame.skyUpdate);
+		}
+		Assets::materials().collectUpdates(frame.materialUpdates);
+
+		s_Instance->m_LastFrame = &frame;
+		return frame;
 	}
 
-	void WorldRenderer::generateDrawCommands(Scene* scene) {
+	void WorldRenderer::updateAssets(const FrameRenderData& frame) {
+		Assets::materials().applyUpdates(frame.materialUpdates);
+		if(frame.skyUpdate.sky == nullptr) return;
+		Assets::skybox().updatePreethamSky(frame.skyUpdate);
+	}
+
+	void WorldRenderer::prepareFrame(Scene* scene, FrameRenderData& frame) {
 
 		MILO_PROFILE_FUNCTION;
 
-		auto& drawCommands = s_Instance->m_DrawCommands;
-		auto& shadowsDrawCommands = s_Instance->m_ShadowDrawCommands;
+		// Once the arenas have been through one full cycle, building the frame data must not touch the global heap
+		MILO_FORBID_HEAP_ALLOCATIONS(FrameArena::warmedUp());
+
+		frame.scene = scene;
+		frame.frame = FrameArena::frame();
+		frame.viewport = scene->viewport();
+		frame.simulationState = getSimulationState();
+		frame.selectedEntity = frame.simulationState == SimulationState::Editor ? MiloEditor::selectedEntity() : NULL_ENTITY;
+
+		getCameraInfo(scene, frame.camera);
+		generateLightEnvironment(scene, frame);
+		collectDrawCommands(scene, frame);
+		sortDrawCommands(frame);
+	}
 
-		drawCommands.clear();
-		shadowsDrawCommands.clear();
+	void WorldRenderer::collectDrawCommands(Scene* scene, FrameRenderData& frame) {
 
-		getCameraInfo(scene);
-		generateLightEnvironment(scene);
+		auto& drawCommands = frame.drawCommands;
+		auto& shadowsDrawCommands = frame.shadowDrawCommands;
 
-		const CameraInfo& camera = s_Instance->camera();
+		// Lists are rebound to the current frame arena. Capacity follows last frame's size to avoid regrowth
+		drawCommands = newFrameArrayList<DrawCommand>(std::max(drawCommands.size(), DRAW_COMMANDS_INITIAL_CAPACITY));
+		shadowsDrawCommands = newFrameArrayList<DrawCommand>(std::max(shadowsDrawCommands.size(), DRAW_COMMANDS_INITIAL_CAPACITY));
+
+		const CameraInfo& camera = frame.camera;
 
 		auto components = scene->group<Transform, MeshView>();
 		for(EntityId entityId : components) {
@@ -77,6 +120,7 @@ namespace milo {
 			drawCommand.transform = modelMatrix;
 			drawCommand.mesh = mesh;
 			drawCommand.material = material;
+			drawCommand.entity = entityId;
 
 			drawCommands.push_back(drawCommand);
 
@@ -84,14 +128,14 @@ namespace milo {
 				shadowsDrawCommands.push_back(drawCommand);
 			}
 		}
-
-		std::sort(drawCommands.begin(), drawCommands.end());
-		std::sort(shadowsDrawCommands.begin(), shadowsDrawCommands.end());
 	}
 
-	void WorldRenderer::getCameraInfo(Scene* scene) {
+	void WorldRenderer::sortDrawCommands(FrameRenderData& frame) {
+		std::sort(frame.drawCommands.begin(), frame.drawCommands.end());
+		std::sort(frame.shadowDrawCommands.begin(), frame.shadowDrawCommands.end());
+	}
 
-		CameraInfo& c = s_Instance->m_Camera;
+	void WorldRenderer::getCameraInfo(Scene* scene, CameraInfo& c) {
 
 		if(getSimulationState() == SimulationState::Editor) {
 			const auto& camera = MiloEditor::camera();
@@ -107,7 +151,7 @@ namespace milo {
 			const auto* camera = scene->camera();
 			float fov, znear, zfar;
 			decomposeProjectionMatrix(camera->projectionMatrix(), fov, znear, zfar);
-			float aspect = camera->viewport().x / camera->viewport().y;
+			float aspect = camera->aspectRatio();
 			Vector3 position = scene->cameraEntity().getComponent<Transform>().translation();
 			Matrix4 viewMatrix = camera->viewMatrix(position);
 			c.proj = camera->projectionMatrix();
@@ -120,10 +164,11 @@ namespace milo {
 
 	}
 
-	void WorldRenderer::generateLightEnvironment(Scene* scene) {
+	void WorldRenderer::generateLightEnvironment(Scene* scene, FrameRenderData& frame) {
 
-		const CameraInfo& camera = s_Instance->camera();
-		LightEnvironment& env = s_Instance->m_LightEnvironment;
+		LightEnvironment& env = frame.lights;
+		env.skybox = nullptr;
+		env.dirLight.reset();
 
 		bool dirLightPresent = false;
 
@@ -144,11 +189,16 @@ namespace milo {
 			if(scene->skyboxView() != nullptr) env.skybox = scene->skyboxView()->skybox;
 		}
 
+		env.skybox = readySkybox(env.skybox);
+
+		SkyboxView* skyboxView = scene->skyboxView();
+		frame.background = skyboxView != nullptr ? readySkybox(skyboxView->skybox) : nullptr;
+
 		if(dirLightPresent) {
-			calculateShadowCascades(scene);
+			calculateShadowCascades(frame);
 		}
 
-		env.pointLights.clear();
+		env.pointLights = newFrameArrayList<PointLight>(std::max(env.pointLights.size(), POINT_LIGHTS_INITIAL_CAPACITY));
 		auto components = scene->view<Transform>() | scene->view<PointLight>();
 		for(EntityId entityId : components) {
 			const Transform& transform = components.get<Transform>(entityId);
@@ -158,19 +208,28 @@ namespace milo {
 		}
 	}
 
-	void WorldRenderer::calculateShadowCascades(Scene* scene) {
+	Skybox* WorldRenderer::readySkybox(Skybox* skybox) {
+		if(skybox == nullptr) return nullptr;
+		if(skybox->ready()) {
+			s_LastReadySkybox = skybox->name();
+			return skybox;
+		}
+		return Assets::skybox().find(s_LastReadySkybox);
+	}
+
+	void WorldRenderer::calculateShadowCascades(FrameRenderData& frame) {
 
 		static const float CascadeNearPlaneOffset = -50.0f;
 		static const float CascadeFarPlaneOffset = 50.0f;
 		static const float CascadeSplitLambda = 0.92f;
 
-		auto viewProjection = s_Instance->camera().projView;
+		auto viewProjection = frame.camera.projView;
 
 		const int SHADOW_MAP_CASCADE_COUNT = 4;
 		float cascadeSplits[SHADOW_MAP_CASCADE_COUNT];
 
 		float fov, zNear, zFar;
-		decomposeProjectionMatrix(s_Instance->camera().proj, fov, zNear, zFar);
+		decomposeProjectionMatrix(frame.camera.proj, fov, zNear, zFar);
 
 		float zRange = zFar - zNear;
 
@@ -180,7 +239,7 @@ namespace milo {
 		float range = maxZ - minZ;
 		float ratio = maxZ / minZ;
 
-		auto& cascades = s_Instance->m_ShadowCascades;
+		auto& cascades = frame.shadowCascades;
 
 		// Based on method presented in https://developer.nvidia.com/gpugems/GPUGems3/gpugems3_ch10.html
 		for (uint32_t i = 0; i < SHADOW_MAP_CASCADE_COUNT; i++) {
@@ -237,7 +296,7 @@ namespace milo {
 			Vector3 maxExtents = Vector3(radius);
 			Vector3 minExtents = -maxExtents;
 
-			Vector3 lightDir = -glm::normalize(s_Instance->m_LightEnvironment.dirLight->direction);
+			Vector3 lightDir = -glm::normalize(frame.lights.dirLight->direction);
 			Matrix4 lightViewMatrix = glm::lookAt(frustumCenter - lightDir * -minExtents.z, frustumCenter, Vector3(0.0f, 0.0f, 1.0f));
 			Matrix4 lightOrthoMatrix = glm::ortho(minExtents.x, maxExtents.x, minExtents.y, maxExtents.y, 0.0f + CascadeNearPlaneOffset, maxExtents.z - minExtents.z + CascadeFarPlaneOffset);
 
@@ -266,10 +325,18 @@ namespace milo {
 		return *m_ResourcePool;
 	}
 
+	const FrameGraph& WorldRenderer::frameGraph() const {
+		return m_FrameGraph;
+	}
+
 	Framebuffer& WorldRenderer::getFramebuffer() const {
 		return *m_ResourcePool->getDefaultFramebuffer();
 	}
 
+	GPUProfiler& WorldRenderer::gpuProfiler() const {
+		return m_FrameGraph.gpuProfiler();
+	}
+
 	bool WorldRenderer::showGrid() const {
 		return m_ShowGrid;
 	}
@@ -334,25 +401,36 @@ namespace milo {
 		m_UseMultithreading = useMultithreading;
 	}
 
-	void WorldRenderer::submit(DrawCommand drawCommand, bool castShadows) {
-		m_DrawCommands.push_back(drawCommand);
-		if(castShadows) m_ShadowDrawCommands.push_back(drawCommand);
+	bool WorldRenderer::entityIdsEnabled() const {
+		return m_EntityIdsEnabled;
+	}
+
+	void WorldRenderer::setEntityIdsEnabled(bool enabled) {
+		m_EntityIdsEnabled = enabled;
+	}
+
+	bool WorldRenderer::renderEntityIds() const {
+		return m_EntityIdsEnabled && frameData().simulationState == SimulationState::Editor && !Graphics::headless();
+	}
+
+	EntityPicker& WorldRenderer::entityPicker() {
+		return m_EntityPicker;
 	}
 
-	const ArrayList<DrawCommand>& WorldRenderer::drawCommands() const {
-		return m_DrawCommands;
+	const FrameArrayList<DrawCommand>& WorldRenderer::drawCommands() const {
+		return m_RenderFrame->drawCommands;
 	}
 
-	const ArrayList<DrawCommand>& WorldRenderer::shadowsDrawCommands() const {
-		return m_ShadowDrawCommands;
+	const FrameArrayList<DrawCommand>& WorldRenderer::shadowsDrawCommands() const {
+		return m_RenderFrame->shadowDrawCommands;
 	}
 
 	const CameraInfo& WorldRenderer::camera() const {
-		return m_Camera;
+		return m_RenderFrame->camera;
 	}
 
 	const LightEnvironment& WorldRenderer::lights() const {
-		return m_LightEnvironment;
+		return m_RenderFrame->lights;
 	}
 
 	float WorldRenderer::shadowsMaxDistance() const {
@@ -372,10 +450,19 @@ namespace milo {
 	}
 
 	const Array<ShadowCascade, 4>& WorldRenderer::shadowCascades() const {
-		return m_ShadowCascades;
+		return m_RenderFrame->shadowCascades;
+	}
+
+	const FrameRenderData& WorldRenderer::frameData() const {
+		return *m_RenderFrame;
+	}
+
+	Size FrameRenderData::viewportSize() const {
+		return {(int32_t)fabs(viewport.width), (int32_t)fabs(viewport.height)};
 	}
 
 	WorldRenderer* WorldRenderer::s_Instance = nullptr;
+	String WorldRenderer::s_LastReadySkybox;
 
 	WorldRenderer& WorldRenderer::get() {
 		return *s_Instance;
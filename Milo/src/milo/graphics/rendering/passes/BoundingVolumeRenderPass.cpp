@@ -24,4 +24,8 @@ namespace milo {
 		DEFINE_RENDER_PASS_ID(BOUNDING_VOLUME_RENDER_PASS_NAME);
 		return id;
 	}
+
+	void BoundingVolumeRenderPass::declareResources(FrameGraphBuilder& builder) const {
+		builder.write(builder.externalResource(FrameGraphResourcePool::DEFAULT_FRAMEBUFFER, true), FrameGraphAccess::ColorAttachment);
+	}
 }
\ No newline at end of file
@@ -23,4 +23,10 @@ namespace milo {
 		DEFINE_RENDER_PASS_ID(FinalRenderPass);
 		return id;
 	}
+
+	void FinalRenderPass::declareResources(FrameGraphBuilder& builder) const {
+		// Presents to the swapchain
+		builder.setSideEffects();
+		builder.read(builder.externalResource(FrameGraphResourcePool::DEFAULT_FRAMEBUFFER, true), FrameGraphAccess::SampledFragment);
+	}
 }
\ No newline at end of file
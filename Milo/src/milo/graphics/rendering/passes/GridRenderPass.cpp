@@ -25,4 +25,8 @@ namespace milo {
 		DEFINE_RENDER_PASS_ID(GRID_RENDER_PASS_NAME);
 		return id;
 	}
+
+	void GridRenderPass::declareResources(FrameGraphBuilder& builder) const {
+		builder.write(builder.externalResource(FrameGraphResourcePool::DEFAULT_FRAMEBUFFER, true), FrameGraphAccess::ColorAttachment);
+	}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "milo/graphics/rendering/passes/LightCullingPass.h"
+#include "milo/graphics/rendering/passes/PreDepthRenderPass.h"
 #include "milo/graphics/vulkan/rendering/passes/VulkanLightCullingPass.h"
 
 namespace milo {
@@ -33,4 +34,11 @@ namespace milo {
 		throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
 	}
 
+	const String LightCullingPass::VISIBLE_LIGHTS = "LightCulling.VisibleLights";
+
+	void LightCullingPass::declareResources(FrameGraphBuilder& builder) const {
+		builder.setQueue(FrameGraphQueue::Compute);
+		builder.read(FrameGraphBuilder::resourceId(PreDepthRenderPass::DEPTH_MAP), FrameGraphAccess::SampledCompute);
+		builder.write(builder.importResource(VISIBLE_LIGHTS), FrameGraphAccess::StorageWriteCompute);
+	}
 }
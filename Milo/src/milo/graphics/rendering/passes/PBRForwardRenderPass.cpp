@@ -1,4 +1,6 @@
 #include "milo/graphics/rendering/passes/PBRForwardRenderPass.h"
+#include "milo/graphics/rendering/passes/LightCullingPass.h"
+#include "milo/graphics/rendering/passes/ShadowMapRenderPass.h"
 #include "milo/graphics/vulkan/rendering/passes/VulkanPBRForwardRenderPass.h"
 
 namespace milo {
@@ -24,4 +26,10 @@ namespace milo {
 		DEFINE_RENDER_PASS_ID(PBR_FORWARD_RENDER_PASS_NAME);
 		return id;
 	}
+
+	void PBRForwardRenderPass::declareResources(FrameGraphBuilder& builder) const {
+		builder.read(FrameGraphBuilder::resourceId(LightCullingPass::VISIBLE_LIGHTS), FrameGraphAccess::StorageReadFragment);
+		builder.read(FrameGraphBuilder::resourceId(ShadowMapRenderPass::SHADOW_MAP), FrameGraphAccess::SampledDepthFragment);
+		builder.write(builder.externalResource(FrameGraphResourcePool::DEFAULT_FRAMEBUFFER, true), FrameGraphAccess::ColorAttachment);
+	}
 }
\ No newline at end of file
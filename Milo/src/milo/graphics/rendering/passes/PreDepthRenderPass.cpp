@@ -1,4 +1,5 @@
 #include "milo/graphics/rendering/passes/PreDepthRenderPass.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/graphics/vulkan/rendering/passes/VulkanPreDepthRenderPass.h"
 
 namespace milo {
@@ -36,4 +37,26 @@ namespace milo {
 	Handle PreDepthRenderPass::createFramebufferHandle(uint32_t index) {
 		return id() + index;
 	}
+
+	const String PreDepthRenderPass::DEPTH_MAP = "PreDepth.DepthMap";
+	const String PreDepthRenderPass::DEBUG_DEPTH_MAP = "PreDepth.DebugDepthMap";
+	const String PreDepthRenderPass::DEPTH_BUFFER = "PreDepth.DepthBuffer";
+	const String PreDepthRenderPass::ENTITY_ID_MAP = "PreDepth.EntityIdMap";
+
+	void PreDepthRenderPass::declareResources(FrameGraphBuilder& builder) const {
+
+		FrameGraphTextureDescription depthBuffer{};
+		depthBuffer.format = PixelFormat::DEPTH32;
+		depthBuffer.size = WorldRenderer::get().getFramebuffer().size();
+		depthBuffer.usage = TEXTURE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+		// The editor shows the debug depth map, so it is always considered in use
+		builder.write(builder.importResource(DEPTH_MAP), FrameGraphAccess::ColorAttachment);
+		builder.write(builder.importResource(DEBUG_DEPTH_MAP, true), FrameGraphAccess::ColorAttachment);
+		builder.write(builder.createTexture(DEPTH_BUFFER, depthBuffer), FrameGraphAccess::DepthAttachment);
+
+		if(WorldRenderer::get().renderEntityIds()) {
+			builder.write(builder.importResource(ENTITY_ID_MAP), FrameGraphAccess::ColorAttachment);
+		}
+	}
 }
\ No newline at end of file
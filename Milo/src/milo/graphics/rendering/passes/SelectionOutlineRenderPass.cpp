@@ -0,0 +1,33 @@
+#include "milo/graphics/rendering/passes/SelectionOutlineRenderPass.h"
+#include "milo/graphics/rendering/passes/PreDepthRenderPass.h"
+#include "milo/graphics/vulkan/rendering/passes/VulkanSelectionOutlineRenderPass.h"
+
+namespace milo {
+
+	static const String SELECTION_OUTLINE_RENDER_PASS_NAME = "SelectionOutlineRenderPass";
+
+	RenderPassId SelectionOutlineRenderPass::getId() const {
+		return id();
+	}
+
+	const String& SelectionOutlineRenderPass::name() const {
+		return SELECTION_OUTLINE_RENDER_PASS_NAME;
+	}
+
+	SelectionOutlineRenderPass* SelectionOutlineRenderPass::create() {
+		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
+			return new VulkanSelectionOutlineRenderPass();
+		}
+		throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
+	}
+
+	size_t SelectionOutlineRenderPass::id() {
+		DEFINE_RENDER_PASS_ID(SELECTION_OUTLINE_RENDER_PASS_NAME);
+		return id;
+	}
+
+	void SelectionOutlineRenderPass::declareResources(FrameGraphBuilder& builder) const {
+		builder.read(FrameGraphBuilder::resourceId(PreDepthRenderPass::ENTITY_ID_MAP), FrameGraphAccess::SampledFragment);
+		builder.write(builder.externalResource(FrameGraphResourcePool::DEFAULT_FRAMEBUFFER, true), FrameGraphAccess::ColorAttachment);
+	}
+}
\ No newline at end of file
@@ -26,10 +26,21 @@ namespace milo {
 	}
 
 	Handle ShadowMapRenderPass::getDepthMap(uint32_t cascadeIndex, uint32_t index) {
-		if(index != UINT32_MAX) return id() + cascadeIndex * 1000;// + index;
-		if(Graphics::graphicsAPI() == GraphicsAPI::Vulkan) {
-			return id() + cascadeIndex * 1000;// + VulkanContext::get()->vulkanPresenter()->currentImageIndex();
-		}
-		throw MILO_RUNTIME_EXCEPTION("Unsupported Graphics API");
+		// Every cascade is a layer of the same frame graph texture
+		return FrameGraphBuilder::resourceId(SHADOW_MAP);
+	}
+
+	const String ShadowMapRenderPass::SHADOW_MAP = "ShadowMap.Cascades";
+
+	void ShadowMapRenderPass::declareResources(FrameGraphBuilder& builder) const {
+
+		// One layer per cascade
+		FrameGraphTextureDescription shadowMap{};
+		shadowMap.format = PixelFormat::DEPTH32;
+		shadowMap.size = {(int32_t)SHADOW_MAP_RESOLUTION, (int32_t)SHADOW_MAP_RESOLUTION};
+		shadowMap.layers = MAX_SHADOW_CASCADES;
+		shadowMap.usage = TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+
+		builder.write(builder.createTexture(SHADOW_MAP, shadowMap), FrameGraphAccess::DepthAttachment);
 	}
 }
\ No newline at end of file
@@ -25,4 +25,8 @@ namespace milo {
 		DEFINE_RENDER_PASS_ID(SKYBOX_RENDER_PASS_NAME);
 		return id;
 	}
+
+	void SkyboxRenderPass::declareResources(FrameGraphBuilder& builder) const {
+		builder.write(builder.externalResource(FrameGraphResourcePool::DEFAULT_FRAMEBUFFER, true), FrameGraphAccess::ColorAttachment);
+	}
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "milo/graphics/vulkan/VulkanContext.h"
 #include "milo/graphics/vulkan/buffers/VulkanFramebuffer.h"
 #include "milo/graphics/vulkan/descriptors/VulkanDescriptorPool.h"
+#include "milo/graphics/vulkan/rendering/VulkanGPUProfiler.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/scenes/SceneManager.h"
 
@@ -110,7 +111,7 @@ namespace milo {
 
 		VkImageCreateInfo ImageCreateInfo::colorAttachment() noexcept {
 			VkImageCreateInfo imageInfo = create(TEXTURE_USAGE_COLOR_ATTACHMENT_BIT);
-			imageInfo.format = VulkanContext::get()->swapchain()->format();
+			imageInfo.format = VulkanContext::get()->presentationFormat();
 			return imageInfo;
 		}
 
@@ -211,7 +212,7 @@ namespace milo {
 
 	VkAttachmentDescription mvk::AttachmentDescription::createPresentSrcAttachment() {
 		VkAttachmentDescription colorAttachment = {};
-		colorAttachment.format = VulkanContext::get()->swapchain()->format();
+		colorAttachment.format = VulkanContext::get()->presentationFormat();
 		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT; // TODO: get samples from context
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
 		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
@@ -435,15 +436,20 @@ namespace milo {
 			for(Texture2D* colorAttachment : vulkanFramebuffer->colorAttachments()) {
 				auto* texture = (VulkanTexture2D*)colorAttachment;
 				if(texture->layout() != VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL) {
-					texture->setLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+					texture->requestLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+										   VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
 				}
 			}
 			for(Texture2D* depthAttachment : vulkanFramebuffer->depthAttachments()) {
 				auto* texture = (VulkanTexture2D*)depthAttachment;
 				if(texture->layout() != VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL) {
-					texture->setLayout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+					texture->requestLayout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+										   VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+										   VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
 				}
 			}
+			// Together with whatever else was requested since the last pass
+			VulkanTexture::flushPendingBarriers(commandBuffer);
 			return vulkanFramebuffer;
 		}
 
@@ -470,7 +476,7 @@ namespace milo {
 			Viewport theViewport{};
 
 			if(info.viewport == nullptr) {
-				theViewport = SceneManager::activeScene()->viewport();
+				theViewport = WorldRenderer::get().frameData().viewport;
 			} else {
 				theViewport = *info.viewport;
 			}
@@ -490,6 +496,9 @@ namespace milo {
 			renderPassInfo.pClearValues = info.clearValues;
 			renderPassInfo.clearValueCount = info.clearValuesCount;
 
+			// Queries cannot begin inside a render pass instance
+			if(VulkanGPUProfiler* profiler = VulkanGPUProfiler::get()) profiler->beginStatistics(commandBuffer);
+
 			VK_CALLV(vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, info.subpassContents));
 
 			VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, info.graphicsPipeline));
@@ -517,6 +526,7 @@ namespace milo {
 
 		void endGraphicsRenderPass(VkCommandBuffer commandBuffer) {
 			VK_CALLV(vkCmdEndRenderPass(commandBuffer));
+			if(VulkanGPUProfiler* profiler = VulkanGPUProfiler::get()) profiler->endStatistics(commandBuffer);
 			VK_CALLV(vkEndCommandBuffer(commandBuffer));
 		}
 	}
@@ -861,7 +871,7 @@ namespace milo {
 			case PixelFormat::DEPTH32:
 				return VK_FORMAT_D32_SFLOAT;
 			case PixelFormat::PresentationFormat:
-				return VulkanContext::get()->swapchain()->format();
+				return VulkanContext::get()->presentationFormat();
 			default:
 				throw MILO_RUNTIME_EXCEPTION("Unsupported pixel format");
 		}
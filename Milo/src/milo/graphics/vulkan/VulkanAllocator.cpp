@@ -79,4 +79,18 @@ namespace milo {
 		g_Allocations.erase(vmaAllocation);
 		VK_CALLV(vmaDestroyImage(m_VmaAllocator, vkImage, vmaAllocation));
 	}
+
+	void VulkanAllocator::allocateMemory(const VkMemoryRequirements& requirements, const VmaAllocationCreateInfo& allocInfo, VmaAllocation& vmaAllocation) {
+		VK_CALL(vmaAllocateMemory(m_VmaAllocator, &requirements, &allocInfo, &vmaAllocation, nullptr));
+		g_Allocations[vmaAllocation] = {"Memory", getStackTrace()};
+	}
+
+	void VulkanAllocator::bindImageMemory(VmaAllocation vmaAllocation, VkImage vkImage) {
+		VK_CALL(vmaBindImageMemory(m_VmaAllocator, vmaAllocation, vkImage));
+	}
+
+	void VulkanAllocator::freeMemory(VmaAllocation vmaAllocation) {
+		g_Allocations.erase(vmaAllocation);
+		VK_CALLV(vmaFreeMemory(m_VmaAllocator, vmaAllocation));
+	}
 }
\ No newline at end of file
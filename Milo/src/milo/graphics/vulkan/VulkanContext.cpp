@@ -4,6 +4,9 @@
 
 namespace milo {
 
+	// The one VulkanWindowSurface prefers for the swapchain
+	static const VkFormat OFFSCREEN_PRESENTATION_FORMAT = VK_FORMAT_B8G8R8A8_UNORM;
+
 	VulkanContext::VulkanContext() {
 		s_Instance = this;
 	}
@@ -48,6 +51,14 @@ namespace milo {
 		return m_Swapchain;
 	}
 
+	bool VulkanContext::headless() const {
+		return m_WindowSurface == nullptr;
+	}
+
+	VkFormat VulkanContext::presentationFormat() const {
+		return m_Swapchain != nullptr ? m_Swapchain->format() : OFFSCREEN_PRESENTATION_FORMAT;
+	}
+
 	VulkanAllocator* VulkanContext::allocator() const {
 		return m_Allocator;
 	}
@@ -67,22 +78,23 @@ namespace milo {
 	void VulkanContext::init(Window* mainWindow) {
 		Log::info("Initializing Vulkan Context...");
 		{
-			createVkInstance();
+			const bool presentation = mainWindow != nullptr;
+			createVkInstance(presentation);
 			createDebugMessenger();
-			createWindowSurface(mainWindow);
-			createMainVulkanDevice();
-			createSwapchain();
+			if(presentation) createWindowSurface(mainWindow);
+			createMainVulkanDevice(presentation);
+			if(presentation) createSwapchain();
 			createAllocator();
 			createSamplerMap();
 			createPresenter();
 		}
-		Log::info("Vulkan Context initialized");
+		Log::info(headless() ? "Vulkan Context initialized in headless mode" : "Vulkan Context initialized");
 	}
 
-	void VulkanContext::createVkInstance() {
+	void VulkanContext::createVkInstance(bool presentation) {
 
 		VkApplicationInfo applicationInfo = getApplicationInfo();
-		ArrayList<const char*> extensions = VulkanExtensions::getInstanceExtensions();
+		ArrayList<const char*> extensions = VulkanExtensions::getInstanceExtensions(presentation);
 		ArrayList<const char*> layers = VulkanLayers::getInstanceLayers();
 
 		VkInstanceCreateInfo createInfo = {};
@@ -109,7 +121,7 @@ namespace milo {
 		m_WindowSurface = new VulkanWindowSurface(s_Instance, std::move(mainWindow));
 	}
 
-	void VulkanContext::createMainVulkanDevice() {
+	void VulkanContext::createMainVulkanDevice(bool presentation) {
 		ArrayList<RankedDevice> physicalDeviceRank = VulkanDevice::rankAllPhysicalDevices(m_VkInstance);
 		if(physicalDeviceRank.empty()) {
 			throw MILO_RUNTIME_EXCEPTION("Failed to find a Vulkan supported device");
@@ -119,8 +131,18 @@ namespace milo {
 
 		VulkanDevice::Info deviceInfo = {};
 		deviceInfo.physicalDevice = bestDevice.physicalDevice;
-		deviceInfo.usageFlags = DeviceUsageAllBit;
+		deviceInfo.usageFlags = presentation ? DeviceUsageAllBit
+				: (DeviceUsageFlags)(DeviceUsageGraphicsBit | DeviceUsageTransferBit | DeviceUsageComputeBit);
 		deviceInfo.extensionNames = VulkanExtensions::getDeviceExtensions(deviceInfo.usageFlags);
+
+		VulkanPhysicalDeviceInfo physicalDeviceInfo(bestDevice.physicalDevice);
+		for(const char* extension : VulkanExtensions::getOptionalDeviceExtensions(deviceInfo.usageFlags)) {
+			if(physicalDeviceInfo.supportsExtension(extension)) {
+				deviceInfo.extensionNames.push_back(extension);
+			} else {
+				Log::debug("Optional device extension {} is not supported", extension);
+			}
+		}
 		deviceInfo.layerNames = VulkanLayers::getDeviceLayers(deviceInfo.usageFlags);
 
 		m_Device = new VulkanDevice(this);
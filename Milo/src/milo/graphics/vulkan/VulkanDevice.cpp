@@ -1,14 +1,18 @@
 #include "milo/graphics/vulkan/VulkanDevice.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
 #include "milo/graphics/vulkan/VulkanFormats.h"
+#include "milo/logging/Log.h"
 #include <algorithm>
+#include <cstring>
 #include <utility>
 
 namespace milo {
 
+	Mutex VulkanQueue::s_SubmitMutex;
+
 	void VulkanQueue::submit(const VkSubmitInfo& submitInfo, VkFence fence) {
 
-		VK_CALL(vkQueueSubmit(m_VkQueue, 1, &submitInfo, fence));
+		submitDetached(submitInfo, fence);
 
 		m_LastSignalSemaphores.clear();
 		for(uint32_t i = 0;i < submitInfo.signalSemaphoreCount;++i) {
@@ -18,6 +22,11 @@ namespace milo {
 		m_LastFence = fence;
 	}
 
+	void VulkanQueue::submitDetached(const VkSubmitInfo& submitInfo, VkFence fence) {
+		std::lock_guard<Mutex> lock(s_SubmitMutex);
+		VK_CALL(vkQueueSubmit(m_VkQueue, 1, &submitInfo, fence));
+	}
+
 	void VulkanQueue::awaitTermination() {
 		m_Device->awaitTermination(m_VkQueue);
 	}
@@ -82,8 +91,18 @@ namespace milo {
 
 		createInfo.pNext = &separateDepthStencilLayoutsFeatures;
 
+		VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures = {};
+		descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		if(hasExtension(info, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME) && queryDescriptorIndexingFeatures(descriptorIndexingFeatures)) {
+			separateDepthStencilLayoutsFeatures.pNext = &descriptorIndexingFeatures;
+			m_DescriptorIndexingSupported = true;
+		}
+
 		VK_CALL(vkCreateDevice(m_Physical, &createInfo, nullptr, &m_Logical));
 
+		m_EnabledExtensions.assign(info.extensionNames.begin(), info.extensionNames.end());
+
 		getQueues();
 
 		m_GraphicsCommandPool = new VulkanCommandPool(&m_GraphicsQueue, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
@@ -160,6 +179,51 @@ namespace milo {
 		return m_TransferCommandPool;
 	}
 
+	bool VulkanDevice::extensionEnabled(const String& name) const {
+		return std::find(m_EnabledExtensions.begin(), m_EnabledExtensions.end(), name) != m_EnabledExtensions.end();
+	}
+
+	bool VulkanDevice::descriptorIndexingSupported() const {
+		return m_DescriptorIndexingSupported;
+	}
+
+	bool VulkanDevice::hasExtension(const Info& info, const char* name) {
+		for(const char* extension : info.extensionNames) {
+			if(strcmp(extension, name) == 0) return true;
+		}
+		return false;
+	}
+
+	bool VulkanDevice::queryDescriptorIndexingFeatures(VkPhysicalDeviceDescriptorIndexingFeatures& features) const {
+
+		VkPhysicalDeviceDescriptorIndexingFeatures supported = {};
+		supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+		VkPhysicalDeviceFeatures2 features2 = {};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.pNext = &supported;
+
+		VK_CALLV(vkGetPhysicalDeviceFeatures2(m_Physical, &features2));
+
+		// Only the features needed by the bindless material path are enabled
+		bool usable = supported.runtimeDescriptorArray
+				&& supported.descriptorBindingPartiallyBound
+				&& supported.descriptorBindingSampledImageUpdateAfterBind
+				&& supported.descriptorBindingUpdateUnusedWhilePending;
+
+		if(!usable) {
+			Log::debug("{} does not support the descriptor indexing features required for bindless materials", name());
+			return false;
+		}
+
+		features.runtimeDescriptorArray = VK_TRUE;
+		features.descriptorBindingPartiallyBound = VK_TRUE;
+		features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+		features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+		return true;
+	}
+
 	ArrayList<VkPhysicalDevice> VulkanDevice::listAllPhysicalDevices(VkInstance vkInstance) {
 		uint32_t count;
 		vkEnumeratePhysicalDevices(vkInstance, &count, nullptr);
@@ -324,7 +388,10 @@ namespace milo {
 		vkGetDeviceQueue(m_Logical, m_GraphicsQueue.m_Family, m_GraphicsQueue.m_Index, &m_GraphicsQueue.m_VkQueue);
 		vkGetDeviceQueue(m_Logical, m_TransferQueue.m_Family, m_TransferQueue.m_Index, &m_TransferQueue.m_VkQueue);
 		vkGetDeviceQueue(m_Logical, m_ComputeQueue.m_Family, m_ComputeQueue.m_Index, &m_ComputeQueue.m_VkQueue);
-		vkGetDeviceQueue(m_Logical, m_PresentationQueue.m_Family, m_PresentationQueue.m_Index, &m_PresentationQueue.m_VkQueue);
+		// Headless devices have no presentation queue
+		if(m_PresentationQueue.m_Family != UINT32_MAX) {
+			vkGetDeviceQueue(m_Logical, m_PresentationQueue.m_Family, m_PresentationQueue.m_Index, &m_PresentationQueue.m_VkQueue);
+		}
 	}
 
 	uint32_t VulkanDevice::findBestQueueFamilyOf(VkQueueFlagBits queueType, const ArrayList<VkQueueFamilyProperties> &queueFamilies) {
@@ -391,6 +458,13 @@ namespace milo {
 		return extensionProperties;
 	}
 
+	bool VulkanPhysicalDeviceInfo::supportsExtension(const char* name) const {
+		for(const VkExtensionProperties& extension : extensions()) {
+			if(strcmp(extension.extensionName, name) == 0) return true;
+		}
+		return false;
+	}
+
 	ArrayList<VkLayerProperties> VulkanPhysicalDeviceInfo::layers() const {
 		uint32_t count;
 		vkEnumerateDeviceLayerProperties(physicalDevice, &count, nullptr);
@@ -4,13 +4,16 @@
 
 namespace milo {
 
-	ArrayList<const char *> VulkanExtensions::getInstanceExtensions() {
-		uint32_t count;
-		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&count);
+	ArrayList<const char *> VulkanExtensions::getInstanceExtensions(bool presentation) {
 
-		ArrayList<const char*> extensions(glfwExtensions, glfwExtensions + count);
+		ArrayList<const char*> extensions;
 
-		extensions.push_back("VK_KHR_surface");
+		if(presentation) {
+			uint32_t count;
+			const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&count);
+			extensions.insert(extensions.end(), glfwExtensions, glfwExtensions + count);
+			extensions.push_back("VK_KHR_surface");
+		}
 
 #ifdef _DEBUG
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -25,6 +28,10 @@ namespace milo {
 		return {};
 	}
 
+	ArrayList<const char *> VulkanExtensions::getOptionalDeviceExtensions(DeviceUsageFlags usageFlags) {
+		return {VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME};
+	}
+
 	ArrayList<const char *> VulkanLayers::getInstanceLayers() {
 #ifdef _DEBUG
 		return {"VK_LAYER_KHRONOS_validation"};
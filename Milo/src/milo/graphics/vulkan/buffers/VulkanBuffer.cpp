@@ -224,7 +224,13 @@ namespace milo {
 	}
 
 	VulkanBuffer* VulkanBuffer::createStagingBuffer(uint64_t size) {
-		return createStagingBuffer(nullptr, 0);
+		VulkanBuffer* stagingBuffer = createStagingBuffer(nullptr, 0);
+		if(size > 0) {
+			AllocInfo allocInfo = {};
+			allocInfo.size = size;
+			stagingBuffer->allocate(allocInfo);
+		}
+		return stagingBuffer;
 	}
 
 	VulkanBuffer* VulkanBuffer::createStagingBuffer(const void* data, uint64_t size) {
@@ -0,0 +1,121 @@
+#include "milo/graphics/vulkan/buffers/VulkanUniformRing.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	// Largest block a single allocation may request. Also the size of the overflow block of each region
+	static const uint64_t MAX_UNIFORM_RING_ALLOCATION_SIZE = 64 * 1024;
+
+	VulkanUniformRing::VulkanUniformRing(VulkanDevice* device, uint64_t regionSize) : m_Device(device) {
+
+		m_Alignment = m_Device->info().uniformBufferAlignment();
+		m_OverflowBlockSize = roundUp2(std::min((uint64_t)m_Device->info().properties().limits.maxUniformBufferRange,
+												MAX_UNIFORM_RING_ALLOCATION_SIZE), m_Alignment);
+		m_RegionSize = roundUp2(regionSize, m_Alignment);
+
+		createBuffer();
+	}
+
+	VulkanUniformRing::~VulkanUniformRing() {
+		DELETE_PTR(m_Buffer);
+	}
+
+	void VulkanUniformRing::beginFrame(uint32_t imageIndex) {
+
+		// m_Head keeps counting past the capacity when the ring overflows, so it is the size the region should have had
+		if(m_Head > m_RegionSize) {
+			grow(m_Head);
+		}
+
+		m_CurrentRegion = imageIndex;
+		m_Head = 0;
+		m_OverflowHead = 0;
+		m_Stats.used = 0;
+		m_Stats.allocations = 0;
+	}
+
+	VulkanUniformRing::Allocation VulkanUniformRing::allocate(uint64_t size) {
+
+		if(size > m_OverflowBlockSize) {
+			throw MILO_RUNTIME_EXCEPTION(str("Uniform ring allocation too large: ") + str(size) + " bytes");
+		}
+
+		const uint64_t regionOffset = m_CurrentRegion * (m_RegionSize + m_OverflowBlockSize);
+		const uint64_t alignedSize = roundUp2(size, m_Alignment);
+
+		Allocation allocation{};
+
+		if(m_Head + alignedSize <= m_RegionSize) {
+			allocation.offset = (uint32_t)(regionOffset + m_Head);
+		} else {
+			if(m_OverflowHead + alignedSize > m_OverflowBlockSize) {
+				throw MILO_RUNTIME_EXCEPTION(str("Uniform ring overflow block exhausted: ") + str(m_Head + alignedSize)
+											 + " bytes requested this frame, region capacity is " + str(m_RegionSize));
+			}
+			// Only the first allocation that does not fit in this frame is reported
+			if(m_OverflowHead == 0) {
+				Log::warn("Uniform ring overflow ({} of {} bytes), it will grow next frame", m_Head + alignedSize, m_RegionSize);
+			}
+			allocation.offset = (uint32_t)(regionOffset + m_RegionSize + m_OverflowHead);
+			m_OverflowHead += alignedSize;
+			++m_Stats.overflows;
+		}
+
+		m_Head += alignedSize;
+
+		++m_Stats.allocations;
+		m_Stats.used = std::min(m_Head, m_RegionSize);
+		m_Stats.highWaterMark = std::max(m_Stats.highWaterMark, m_Head);
+
+		allocation.data = m_MappedMemory + allocation.offset;
+
+		return allocation;
+	}
+
+	VkBuffer VulkanUniformRing::vkBuffer() const {
+		return m_Buffer->vkBuffer();
+	}
+
+	uint32_t VulkanUniformRing::generation() const {
+		return m_Generation;
+	}
+
+	const VulkanUniformRing::Stats& VulkanUniformRing::stats() const {
+		return m_Stats;
+	}
+
+	void VulkanUniformRing::createBuffer() {
+
+		m_Buffer = VulkanBuffer::createUniformBuffer(true);
+		m_Buffer->setName("VulkanUniformRing");
+
+		Buffer::AllocInfo allocInfo{};
+		allocInfo.size = MAX_SWAPCHAIN_IMAGE_COUNT * (m_RegionSize + m_OverflowBlockSize);
+
+		m_Buffer->allocate(allocInfo);
+
+		m_MappedMemory = (byte_t*)m_Buffer->map();
+
+		m_Stats.capacity = m_RegionSize;
+	}
+
+	void VulkanUniformRing::grow(uint64_t requiredSize) {
+
+		uint64_t newRegionSize = m_RegionSize;
+		while(newRegionSize < requiredSize) {
+			newRegionSize *= 2;
+		}
+
+		Log::warn("Growing uniform ring regions from {} to {} bytes", m_RegionSize, newRegionSize);
+
+		// Other regions may still be in use by the GPU
+		m_Device->awaitTermination();
+
+		DELETE_PTR(m_Buffer);
+		m_RegionSize = newRegionSize;
+		createBuffer();
+
+		++m_Generation;
+		++m_Stats.resizes;
+	}
+}
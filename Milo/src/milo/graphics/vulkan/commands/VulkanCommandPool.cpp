@@ -77,7 +77,7 @@ namespace milo {
 
 		if(task.asynchronous) {
 
-			VK_CALL(vkQueueSubmit(m_Queue->vkQueue(), 1, &submitInfo, task.fence));
+			m_Queue->submitDetached(submitInfo, task.fence);
 
 		} else {
 
@@ -93,7 +93,7 @@ namespace milo {
 				shouldDeleteFence = true;
 			}
 
-			VK_CALL(vkQueueSubmit(m_Queue->vkQueue(), 1, &submitInfo, fence));
+			m_Queue->submitDetached(submitInfo, fence);
 
 			VK_CALL(vkWaitForFences(m_Queue->device()->logical(), 1, &fence, VK_TRUE, UINT64_MAX));
 
@@ -1,20 +1,28 @@
 #include "milo/graphics/vulkan/materials/VulkanMaterialResourcePool.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/assets/AssetManager.h"
 
 namespace milo {
 
 	VulkanMaterialResourcePool::VulkanMaterialResourcePool() {
 		m_Device = VulkanContext::get()->device();
 		createUniformBuffer();
-		createDescriptorSetLayoutAndPool();
-		createDescriptorSets();
+		createDescriptorSetLayout();
 		m_MaterialIndices.reserve(m_MaxMaterialCount);
+		if(m_Device->descriptorIndexingSupported()) createBindlessResources();
 	}
 
 	VulkanMaterialResourcePool::~VulkanMaterialResourcePool() {
-		DELETE_PTR(m_DescriptorPool);
+		for(VulkanDescriptorPool* pool : m_DescriptorPools) {
+			DELETE_PTR(pool);
+		}
 		DELETE_PTR(m_UniformBuffer);
 		VK_CALLV(vkDestroyDescriptorSetLayout(m_Device->logical(), m_DescriptorSetLayout, nullptr));
+		if(m_BindlessSupported) {
+			DELETE_PTR(m_BindlessDescriptorPool);
+			DELETE_PTR(m_BindlessMaterialBuffer);
+			VK_CALLV(vkDestroyDescriptorSetLayout(m_Device->logical(), m_BindlessDescriptorSetLayout, nullptr));
+		}
 	}
 
 	inline static VkImageView getImageView(Ref<Texture2D> texture) {
@@ -38,128 +46,389 @@ namespace milo {
 			index = m_MaterialCount++;
 		}
 
+		if(index >= m_MaxMaterialCount) throw MILO_RUNTIME_EXCEPTION(str("Too many materials: ") + str(m_MaxMaterialCount));
+
 		m_MaterialIndices[material->name()] = index;
 
-		m_UniformBuffer->update(index, material->data());
+		if(index >= m_Materials.size()) {
+			m_Materials.resize(index + 1);
+			m_FrameCopies.resize(index + 1);
+			if(m_BindlessSupported) m_MaterialTextureSlots.resize(index + 1);
+		}
 
-		{
-			VkDescriptorSet descriptorSet = m_DescriptorPool->get(index);
+		m_Materials[index] = MaterialSnapshot::of(material);
+		m_FrameCopies[index] = {};
+
+		ensureDescriptorPool(index);
+
+		for(uint32_t frame = 0;frame < MAX_FRAMES_IN_FLIGHT;++frame) {
+			VkDescriptorSet descriptorSet = descriptorSetAt(frame, index);
 			VkDescriptorBufferInfo bufferInfo{};
 			bufferInfo.buffer = m_UniformBuffer->vkBuffer();
-			bufferInfo.offset = 0;
+			// Each frame in flight has its own region of the buffer, the dynamic offset selects the material within it
+			bufferInfo.offset = frame * m_MaxMaterialCount * m_UniformBuffer->elementSize();
 			bufferInfo.range = sizeof(Material::Data);
 			auto descriptorWrite = mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &bufferInfo);
 			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &descriptorWrite, 0, nullptr));
 		}
 
-		updateTextures(material);
+		if(m_BindlessSupported) {
+			m_MaterialTextureSlots[index].fill(NULL_TEXTURE_SLOT);
+			updateTextureSlots(m_Materials[index], index);
+		}
+
+		// A new material is not referenced by any frame in flight yet, so every copy can be written right away
+		for(uint32_t frame = 0;frame < MAX_FRAMES_IN_FLIGHT;++frame) {
+			writeFrameCopy(frame, index);
+		}
 	}
 
-	void VulkanMaterialResourcePool::updateMaterial(Material* material) {
-		m_Device->awaitTermination();
-		uint32_t index = m_MaterialIndices[material->name()];
-		m_UniformBuffer->update(index, material->data());
-		updateTextures(material);
+	void VulkanMaterialResourcePool::updateMaterial(const MaterialSnapshot& snapshot) {
+
+		auto it = m_MaterialIndices.find(snapshot.material->name());
+		// Destroyed after the snapshot was taken
+		if(it == m_MaterialIndices.end() || m_Materials[it->second].material != snapshot.material) return;
+
+		const uint32_t index = it->second;
+		// Already applied, by a frame that is rendered again
+		if(snapshot.version <= m_Materials[index].version) return;
+		m_Materials[index] = snapshot;
+
+		// New texture slots are never in use by a frame in flight, and released ones are retired for a few frames
+		if(m_BindlessSupported) updateTextureSlots(snapshot, index);
+
+		for(uint32_t frame = 0;frame < MAX_FRAMES_IN_FLIGHT;++frame) {
+			FrameCopy& copy = m_FrameCopies[index][frame];
+			if(copy.pending) continue;
+			copy.pending = true;
+			m_PendingUpdates[frame].push_back(index);
+		}
 	}
 
 	void VulkanMaterialResourcePool::freeMaterialResources(Material* material) {
 		uint32_t index = m_MaterialIndices[material->name()];
 		m_MaterialIndices.erase(material->name());
 		m_FreeIndices.push_back(index);
+		m_Materials[index] = {};
+		if(m_BindlessSupported) {
+			for(uint32_t& slot : m_MaterialTextureSlots[index]) {
+				releaseTextureSlot(slot);
+				slot = NULL_TEXTURE_SLOT;
+			}
+		}
+	}
+
+	void VulkanMaterialResourcePool::beginFrame() {
+
+		++m_FrameCount;
+
+		const uint32_t frame = currentFrame();
+
+		for(uint32_t index : m_PendingUpdates[frame]) {
+			// Skip materials destroyed after being queued
+			if(m_Materials[index].material == nullptr || !m_FrameCopies[index][frame].pending) continue;
+			writeFrameCopy(frame, index);
+		}
+
+		m_PendingUpdates[frame].clear();
 	}
 
 	VkDescriptorSet VulkanMaterialResourcePool::descriptorSetOf(Material* material, uint32_t& dynamicOffset) const {
 		uint32_t index = m_MaterialIndices.at(material->name());
 		dynamicOffset = index * m_UniformBuffer->elementSize();
-		return m_DescriptorPool->get(index);
+		return descriptorSetAt(currentFrame(), index);
 	}
 
 	VkDescriptorSetLayout VulkanMaterialResourcePool::materialDescriptorSetLayout() const {
 		return m_DescriptorSetLayout;
 	}
 
+	bool VulkanMaterialResourcePool::bindlessSupported() const {
+		return m_BindlessSupported;
+	}
+
+	uint32_t VulkanMaterialResourcePool::indexOf(Material* material) const {
+		return currentFrame() * m_MaxMaterialCount + m_MaterialIndices.at(material->name());
+	}
+
+	VkDescriptorSet VulkanMaterialResourcePool::bindlessDescriptorSet() const {
+		return m_BindlessDescriptorPool->get(0);
+	}
+
+	VkDescriptorSetLayout VulkanMaterialResourcePool::bindlessDescriptorSetLayout() const {
+		return m_BindlessDescriptorSetLayout;
+	}
+
 	void VulkanMaterialResourcePool::createUniformBuffer() {
 		m_UniformBuffer = VulkanUniformBuffer<Material::Data>::create();
 		m_MaxMaterialCount = std::floor(m_Device->info().uniformBufferMaxSize() / m_UniformBuffer->elementSize());
-		m_UniformBuffer->allocate(m_MaxMaterialCount);
+		m_UniformBuffer->allocate(m_MaxMaterialCount * MAX_FRAMES_IN_FLIGHT);
 		Log::debug("Supporting {} different materials", m_MaxMaterialCount);
 	}
 
-	void VulkanMaterialResourcePool::createDescriptorSetLayoutAndPool() {
+	void VulkanMaterialResourcePool::createDescriptorSetLayout() {
 
-		mvk::DescriptorSet::CreateInfo createInfo{};
-		createInfo.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-		createInfo.numSets = m_MaxMaterialCount;
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
-		createInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		m_DescriptorSetInfo.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		m_DescriptorSetInfo.numSets = MATERIALS_PER_DESCRIPTOR_POOL * MAX_FRAMES_IN_FLIGHT;
+		m_DescriptorSetInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
+		for(uint32_t i = 0;i < Material::TEXTURE_COUNT;++i) {
+			m_DescriptorSetInfo.descriptors.push_back(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+		}
+
+		m_DescriptorSetLayout = mvk::DescriptorSet::Layout::create(m_DescriptorSetInfo);
+	}
 
-		m_DescriptorSetLayout = mvk::DescriptorSet::Layout::create(createInfo);
-		m_DescriptorPool = mvk::DescriptorSet::Pool::create(m_DescriptorSetLayout, createInfo);
+	void VulkanMaterialResourcePool::ensureDescriptorPool(uint32_t index) {
+		while(index >= m_DescriptorPools.size() * MATERIALS_PER_DESCRIPTOR_POOL) {
+			VulkanDescriptorPool* pool = mvk::DescriptorSet::Pool::create(m_DescriptorSetLayout, m_DescriptorSetInfo);
+			pool->allocate(MATERIALS_PER_DESCRIPTOR_POOL * MAX_FRAMES_IN_FLIGHT);
+			m_DescriptorPools.push_back(pool);
+		}
 	}
 
-	void VulkanMaterialResourcePool::createDescriptorSets() {
-		m_DescriptorPool->allocate(m_MaxMaterialCount);
+	VkDescriptorSet VulkanMaterialResourcePool::descriptorSetAt(uint32_t frame, uint32_t index) const {
+		const uint32_t setIndex = (index % MATERIALS_PER_DESCRIPTOR_POOL) * MAX_FRAMES_IN_FLIGHT + frame;
+		return m_DescriptorPools[index / MATERIALS_PER_DESCRIPTOR_POOL]->get(setIndex);
 	}
 
-	void VulkanMaterialResourcePool::updateTextures(Material* material) {
+	uint32_t VulkanMaterialResourcePool::currentFrame() const {
+		return VulkanContext::get()->vulkanPresenter()->currentFrame();
+	}
 
-		uint32_t index = m_MaterialIndices[material->name()];
+	void VulkanMaterialResourcePool::writeFrameCopy(uint32_t frame, uint32_t index) {
+
+		const MaterialSnapshot& material = m_Materials[index];
+
+		m_UniformBuffer->update(frame * m_MaxMaterialCount + index, material.data);
+		updateTextures(material, frame, index);
+		if(m_BindlessSupported) writeBindlessMaterial(material, frame, index);
+
+		m_FrameCopies[index][frame].pending = false;
+	}
+
+	void VulkanMaterialResourcePool::updateTextures(const MaterialSnapshot& material, uint32_t frame, uint32_t index) {
+
+		// Same order as the bindings of the descriptor set
+		Array<Texture2D*, Material::TEXTURE_COUNT> textures{};
+		for(uint32_t i = 0;i < Material::TEXTURE_COUNT;++i) {
+			textures[i] = material.textures[i].get();
+		}
+
+		// Most updates only touch parameters
+		FrameCopy& copy = m_FrameCopies[index][frame];
+		if(copy.texturesWritten && copy.textures == textures) return;
+		copy.textures = textures;
+		copy.texturesWritten = true;
+
+		VkDescriptorSet descriptorSet = descriptorSetAt(frame, index);
+
+		Array<VkDescriptorImageInfo, Material::TEXTURE_COUNT> imageInfos{};
+		Array<VkWriteDescriptorSet, Material::TEXTURE_COUNT> writeDescriptors{};
+
+		for(uint32_t i = 0;i < Material::TEXTURE_COUNT;++i) {
+			imageInfos[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			imageInfos[i].imageView = getImageView(material.textures[i]);
+			imageInfos[i].sampler = getSampler(material.textures[i]);
+			writeDescriptors[i] = mvk::WriteDescriptorSet::createCombineImageSamplerWrite(i + 1, descriptorSet, 1, &imageInfos[i]);
+		}
 
-		VkDescriptorSet descriptorSet = m_DescriptorPool->get(index);
-
-		VkDescriptorImageInfo albedoInfo{};
-		albedoInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		albedoInfo.imageView = getImageView(material->albedoMap());
-		albedoInfo.sampler = getSampler(material->albedoMap());
-
-		VkDescriptorImageInfo emissiveInfo{};
-		emissiveInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		emissiveInfo.imageView = getImageView(material->emissiveMap());
-		emissiveInfo.sampler = getSampler(material->emissiveMap());
-
-		VkDescriptorImageInfo normalInfo{};
-		normalInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		normalInfo.imageView = getImageView(material->normalMap());
-		normalInfo.sampler = getSampler(material->normalMap());
-
-		VkDescriptorImageInfo metallicInfo{};
-		metallicInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		metallicInfo.imageView = getImageView(material->metallicMap());
-		metallicInfo.sampler = getSampler(material->metallicMap());
-
-		VkDescriptorImageInfo roughnessInfo{};
-		roughnessInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		roughnessInfo.imageView = getImageView(material->roughnessMap());
-		roughnessInfo.sampler = getSampler(material->roughnessMap());
-
-		VkDescriptorImageInfo metallicRoughnessInfo{};
-		metallicRoughnessInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		metallicRoughnessInfo.imageView = getImageView(material->metallicRoughnessMap());
-		metallicRoughnessInfo.sampler = getSampler(material->metallicRoughnessMap());
-
-		VkDescriptorImageInfo occlusionInfo{};
-		occlusionInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		occlusionInfo.imageView = getImageView(material->occlusionMap());
-		occlusionInfo.sampler = getSampler(material->occlusionMap());
-
-		using namespace mvk::WriteDescriptorSet;
-
-		VkWriteDescriptorSet writeDescriptors[] = {
-				createCombineImageSamplerWrite(1, descriptorSet, 1, &albedoInfo),
-				createCombineImageSamplerWrite(2, descriptorSet, 1, &emissiveInfo),
-				createCombineImageSamplerWrite(3, descriptorSet, 1, &normalInfo),
-				createCombineImageSamplerWrite(4, descriptorSet, 1, &metallicInfo),
-				createCombineImageSamplerWrite(5, descriptorSet, 1, &roughnessInfo),
-				createCombineImageSamplerWrite(6, descriptorSet, 1, &metallicRoughnessInfo),
-				createCombineImageSamplerWrite(7, descriptorSet, 1, &occlusionInfo),
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), Material::TEXTURE_COUNT, writeDescriptors.data(), 0, nullptr));
+	}
+
+	// ===== Bindless
+
+	void VulkanMaterialResourcePool::createBindlessResources() {
+
+		VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+		indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+
+		VkPhysicalDeviceProperties2 properties{};
+		properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+		properties.pNext = &indexingProperties;
+
+		VK_CALLV(vkGetPhysicalDeviceProperties2(m_Device->physical(), &properties));
+
+		m_MaxBindlessTextures = std::min({MAX_BINDLESS_TEXTURES,
+										  indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages,
+										  indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages});
+
+		// Material parameters and texture indices
+		m_BindlessMaterialBuffer = VulkanBuffer::createStorageBuffer(true);
+		Buffer::AllocInfo allocInfo{};
+		allocInfo.size = m_MaxMaterialCount * MAX_FRAMES_IN_FLIGHT * sizeof(BindlessMaterial);
+		m_BindlessMaterialBuffer->allocate(allocInfo);
+
+		// Layout
+		Array<VkDescriptorSetLayoutBinding, 2> bindings{};
+		bindings[0].binding = 0;
+		bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[0].descriptorCount = 1;
+		bindings[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+		bindings[1].binding = 1;
+		bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		bindings[1].descriptorCount = m_MaxBindlessTextures;
+		bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		// Texture slots are written while other slots may be in use by the frames in flight
+		Array<VkDescriptorBindingFlags, 2> bindingFlags = {
+				0,
+				VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+				| VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+				| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT
 		};
 
-		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), Material::TEXTURE_COUNT, writeDescriptors, 0, nullptr));
+		VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+		bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+		bindingFlagsInfo.bindingCount = bindingFlags.size();
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo{};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.pNext = &bindingFlagsInfo;
+		layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+		layoutInfo.pBindings = bindings.data();
+		layoutInfo.bindingCount = bindings.size();
+
+		VK_CALL(vkCreateDescriptorSetLayout(m_Device->logical(), &layoutInfo, nullptr, &m_BindlessDescriptorSetLayout));
+
+		// Pool with a single descriptor set shared by every material
+		VulkanDescriptorPool::CreateInfo poolInfo{};
+		poolInfo.layout = m_BindlessDescriptorSetLayout;
+		poolInfo.capacity = 1;
+		poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+		poolInfo.poolSizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1});
+		poolInfo.poolSizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_MaxBindlessTextures});
+
+		m_BindlessDescriptorPool = new VulkanDescriptorPool(m_Device, poolInfo);
+
+		m_BindlessDescriptorPool->allocate(1, [&](size_t index, VkDescriptorSet descriptorSet) {
+
+			VkDescriptorBufferInfo bufferInfo{};
+			bufferInfo.buffer = m_BindlessMaterialBuffer->vkBuffer();
+			bufferInfo.offset = 0;
+			bufferInfo.range = VK_WHOLE_SIZE;
+
+			VkWriteDescriptorSet writeDescriptor = mvk::WriteDescriptorSet::createStorageBufferWrite(0, descriptorSet, 1, &bufferInfo);
+
+			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptor, 0, nullptr));
+		});
+
+		m_BindlessSupported = true;
+
+		m_TextureSlots.reserve(m_MaxBindlessTextures);
+		m_TexturesBySlot.reserve(m_MaxBindlessTextures);
+
+		// Slot 0 permanently holds the white texture
+		VulkanTexture2D* whiteTexture = dynamic_cast<VulkanTexture2D*>(Assets::textures().whiteTexture().get());
+		m_TextureSlots[whiteTexture] = {NULL_TEXTURE_SLOT, 1};
+		m_TexturesBySlot.push_back(whiteTexture);
+		writeTextureSlot(NULL_TEXTURE_SLOT, whiteTexture);
+
+		Log::debug("Bindless materials enabled with up to {} textures", m_MaxBindlessTextures);
+	}
+
+	void VulkanMaterialResourcePool::updateTextureSlots(const MaterialSnapshot& material, uint32_t index) {
+
+		Array<uint32_t, Material::TEXTURE_COUNT>& slots = m_MaterialTextureSlots[index];
+
+		// Same order as the textures of the per material descriptor sets
+		const Array<Ref<Texture2D>, Material::TEXTURE_COUNT>& textures = material.textures;
+
+		// Acquire first, so textures shared between the old and new maps keep their slots
+		Array<uint32_t, Material::TEXTURE_COUNT> newSlots{};
+		for(uint32_t i = 0;i < Material::TEXTURE_COUNT;++i) {
+			newSlots[i] = acquireTextureSlot(textures[i]);
+		}
+		for(uint32_t i = 0;i < Material::TEXTURE_COUNT;++i) {
+			releaseTextureSlot(slots[i]);
+		}
+		slots = newSlots;
+	}
+
+	void VulkanMaterialResourcePool::writeBindlessMaterial(const MaterialSnapshot& material, uint32_t frame, uint32_t index) {
+
+		const Array<uint32_t, Material::TEXTURE_COUNT>& slots = m_MaterialTextureSlots[index];
+		const Material::Data& data = material.data;
+
+		BindlessMaterial gpuMaterial{};
+		gpuMaterial.albedo = data.albedo;
+		gpuMaterial.emissiveColor = data.emissiveColor;
+		gpuMaterial.alpha = data.alpha;
+		gpuMaterial.metallic = data.metallic;
+		gpuMaterial.roughness = data.roughness;
+		gpuMaterial.occlusion = data.occlusion;
+		gpuMaterial.fresnel0 = data.fresnel0;
+		gpuMaterial.normalScale = data.normalScale;
+		gpuMaterial.useNormalMap = data.useNormalMap;
+		gpuMaterial.useCombinedMetallicRoughness = data.useCombinedMetallicRoughness;
+		memcpy(gpuMaterial.textures, slots.data(), sizeof(gpuMaterial.textures));
+
+		byte_t* mappedMemory = (byte_t*)m_BindlessMaterialBuffer->map();
+		memcpy(mappedMemory + (frame * m_MaxMaterialCount + index) * sizeof(BindlessMaterial), &gpuMaterial, sizeof(BindlessMaterial));
+	}
+
+	uint32_t VulkanMaterialResourcePool::acquireTextureSlot(const Ref<Texture2D>& texture) {
+
+		if(texture == nullptr) return NULL_TEXTURE_SLOT;
+
+		VulkanTexture2D* vkTexture = dynamic_cast<VulkanTexture2D*>(texture.get());
+
+		auto it = m_TextureSlots.find(vkTexture);
+		if(it != m_TextureSlots.end()) {
+			// The null texture slot is never released, so it is not reference counted
+			if(it->second.index != NULL_TEXTURE_SLOT) ++it->second.references;
+			return it->second.index;
+		}
+
+		// Slots released a few frames ago are no longer referenced by any frame in flight
+		while(!m_RetiredTextureSlots.empty() && m_RetiredTextureSlots.front().frame + MAX_FRAMES_IN_FLIGHT <= m_FrameCount) {
+			m_FreeTextureSlots.push_back(m_RetiredTextureSlots.front().index);
+			m_RetiredTextureSlots.pop_front();
+		}
+
+		uint32_t slot;
+		if(!m_FreeTextureSlots.empty()) {
+			slot = m_FreeTextureSlots.front();
+			m_FreeTextureSlots.pop_front();
+			m_TexturesBySlot[slot] = vkTexture;
+		} else if(m_TexturesBySlot.size() < m_MaxBindlessTextures) {
+			slot = m_TexturesBySlot.size();
+			m_TexturesBySlot.push_back(vkTexture);
+		} else {
+			Log::error("Bindless texture array is full ({} textures), using the null texture instead", m_MaxBindlessTextures);
+			return NULL_TEXTURE_SLOT;
+		}
+
+		m_TextureSlots[vkTexture] = {slot, 1};
+		writeTextureSlot(slot, vkTexture);
+
+		return slot;
+	}
+
+	void VulkanMaterialResourcePool::releaseTextureSlot(uint32_t slot) {
+
+		if(slot == NULL_TEXTURE_SLOT) return;
+
+		VulkanTexture2D* texture = m_TexturesBySlot[slot];
+
+		TextureSlot& textureSlot = m_TextureSlots[texture];
+		if(--textureSlot.references > 0) return;
+
+		m_TextureSlots.erase(texture);
+		m_TexturesBySlot[slot] = nullptr;
+		m_RetiredTextureSlots.push_back({slot, m_FrameCount});
+	}
+
+	void VulkanMaterialResourcePool::writeTextureSlot(uint32_t slot, VulkanTexture2D* texture) {
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = texture->vkImageView();
+		imageInfo.sampler = texture->vkSampler();
+
+		VkWriteDescriptorSet writeDescriptor = mvk::WriteDescriptorSet::createCombineImageSamplerWrite(1, bindlessDescriptorSet(), 1, &imageInfo);
+		writeDescriptor.dstArrayElement = slot;
+
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptor, 0, nullptr));
 	}
-}
\ No newline at end of file
+}
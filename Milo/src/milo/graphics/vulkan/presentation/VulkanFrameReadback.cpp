@@ -0,0 +1,178 @@
+#include "milo/graphics/vulkan/presentation/VulkanFrameReadback.h"
+#include "milo/assets/images/Image.h"
+#include "milo/io/Files.h"
+
+namespace milo {
+
+	VulkanFrameReadback::VulkanFrameReadback(VulkanDevice* device, const HeadlessConfiguration& config)
+		: m_Device(device), m_OutputDirectory(config.outputDirectory), m_ImageFormat(config.imageFormat) {
+
+		m_CommandPool = new VulkanCommandPool(m_Device->graphicsQueue(), VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+		m_CommandPool->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, MAX_FRAMES_IN_FLIGHT, m_CommandBuffers.data());
+
+		m_InFlightBuffers.fill(NO_STAGING_BUFFER);
+
+		if(m_ImageFormat == HeadlessImageFormat::None) return;
+
+		if(!Files::exists(m_OutputDirectory)) Files::createDirectory(m_OutputDirectory);
+
+		m_FreeBuffers.reserve(STAGING_BUFFER_COUNT);
+		for(uint32_t i = 0;i < STAGING_BUFFER_COUNT;++i) {
+			m_FreeBuffers.push_back(i);
+		}
+
+		m_Running = true;
+		m_Thread = Thread(&VulkanFrameReadback::run, this);
+	}
+
+	VulkanFrameReadback::~VulkanFrameReadback() {
+
+		m_Device->awaitTermination();
+
+		// The device finished the frames still in flight, so they are written too
+		for(uint32_t frame = 0;frame < MAX_FRAMES_IN_FLIGHT;++frame) {
+			complete(frame);
+		}
+
+		{
+			std::lock_guard<Mutex> lock(m_Mutex);
+			m_Running = false;
+		}
+		m_BufferQueued.notify_all();
+		if(m_Thread.joinable()) m_Thread.join();
+
+		if(m_FramesWritten > 0) Log::info("{} frames written to {}", m_FramesWritten, Files::toAbsolutePath(m_OutputDirectory));
+
+		for(StagingBuffer& staging : m_StagingBuffers) {
+			if(staging.buffer == nullptr) continue;
+			staging.buffer->unmap();
+			DELETE_PTR(staging.buffer);
+		}
+
+		m_CommandPool->free(MAX_FRAMES_IN_FLIGHT, m_CommandBuffers.data());
+		DELETE_PTR(m_CommandPool);
+	}
+
+	VkCommandBuffer VulkanFrameReadback::record(uint32_t frame, VulkanTexture2D& colorAttachment) {
+
+		VkCommandBuffer commandBuffer = m_CommandBuffers[frame];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+
+		// Without an image format the frame is still submitted, only to signal its fence
+		if(m_ImageFormat != HeadlessImageFormat::None) {
+
+			const VkExtent3D& extent = colorAttachment.vkImageInfo().extent;
+			const uint32_t index = acquireStagingBuffer(extent.width, extent.height, colorAttachment.mipLevelsSize(1));
+			m_InFlightBuffers[frame] = index;
+
+			// The world passes leave it as a color attachment
+			colorAttachment.setCurrentLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+											 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+			colorAttachment.setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+									  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			colorAttachment.copyMipLevelsToBuffer(commandBuffer, *m_StagingBuffers[index].buffer, 1);
+
+			colorAttachment.setLayout(commandBuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+									  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+
+		VK_CALL(vkEndCommandBuffer(commandBuffer));
+
+		return commandBuffer;
+	}
+
+	void VulkanFrameReadback::complete(uint32_t frame) {
+
+		const uint32_t index = m_InFlightBuffers[frame];
+		if(index == NO_STAGING_BUFFER) return;
+		m_InFlightBuffers[frame] = NO_STAGING_BUFFER;
+
+		{
+			std::lock_guard<Mutex> lock(m_Mutex);
+			m_WriteQueue.push_back(index);
+		}
+		m_BufferQueued.notify_one();
+	}
+
+	uint32_t VulkanFrameReadback::acquireStagingBuffer(uint32_t width, uint32_t height, uint64_t size) {
+
+		uint32_t index;
+		{
+			std::unique_lock<Mutex> lock(m_Mutex);
+			m_BufferFreed.wait(lock, [&]() {return !m_FreeBuffers.empty();});
+			index = m_FreeBuffers.back();
+			m_FreeBuffers.pop_back();
+		}
+
+		StagingBuffer& staging = m_StagingBuffers[index];
+
+		// Only happens for the first frames, the offscreen frames are never resized
+		if(staging.buffer == nullptr || staging.buffer->size() != size) {
+			if(staging.buffer != nullptr) staging.buffer->unmap();
+			DELETE_PTR(staging.buffer);
+			staging.buffer = VulkanBuffer::createStagingBuffer(size);
+			staging.buffer->setName("FrameReadbackBuffer[" + str(index) + "]");
+			staging.pixels = (const float*)staging.buffer->map();
+		}
+
+		staging.width = width;
+		staging.height = height;
+		staging.frameNumber = m_FrameCount++;
+
+		return index;
+	}
+
+	void VulkanFrameReadback::run() {
+
+		while(true) {
+
+			uint32_t index;
+			{
+				std::unique_lock<Mutex> lock(m_Mutex);
+				m_BufferQueued.wait(lock, [&]() {return !m_WriteQueue.empty() || !m_Running;});
+				if(m_WriteQueue.empty()) return;
+				index = m_WriteQueue.front();
+				m_WriteQueue.pop_front();
+			}
+
+			write(m_StagingBuffers[index]);
+
+			{
+				std::lock_guard<Mutex> lock(m_Mutex);
+				m_FreeBuffers.push_back(index);
+			}
+			m_BufferFreed.notify_one();
+		}
+	}
+
+	void VulkanFrameReadback::write(const StagingBuffer& staging) {
+
+		const bool exr = m_ImageFormat == HeadlessImageFormat::EXR;
+		const String filename = Files::append(m_OutputDirectory, fmt::format("frame_{:06}.{}", staging.frameNumber, exr ? "exr" : "png"));
+
+		try {
+			if(exr) {
+				Image::writeEXR(filename, staging.width, staging.height, staging.pixels);
+			} else {
+				// What the swapchain shows: the color clamped to [0, 1] and stored in 8 bit unorm channels, fully opaque
+				const size_t count = (size_t)staging.width * staging.height * 4;
+				m_EncodedPixels.resize(count);
+				for(size_t i = 0;i < count;++i) {
+					const float value = (i & 3) == 3 ? 1.0f : std::clamp(staging.pixels[i], 0.0f, 1.0f);
+					m_EncodedPixels[i] = (uint8_t)(value * 255.0f + 0.5f);
+				}
+				Image::writePNG(filename, staging.width, staging.height, m_EncodedPixels.data());
+			}
+			++m_FramesWritten;
+		} catch(const Exception& e) {
+			Log::error("Failed to write headless frame {}: {}", staging.frameNumber, e.what());
+		}
+	}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "milo/graphics/vulkan/presentation/VulkanPresenter.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
 #include "milo/graphics/vulkan/VulkanDevice.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
 
 namespace milo {
 
@@ -10,12 +11,20 @@ namespace milo {
 		m_GraphicsQueue = m_Device->graphicsQueue()->vkQueue();
 		m_PresentationQueue = m_Device->presentationQueue()->vkQueue();
 
-		m_MaxImageCount = m_Swapchain->imageCount();
 		m_CurrentImageIndex = 0;
 		m_CurrentFrame = 0;
 
 		createSyncObjects();
 
+		if(m_Swapchain == nullptr) {
+			// Each frame in flight renders to its own default framebuffer
+			m_MaxImageCount = MAX_FRAMES_IN_FLIGHT;
+			m_Readback = new VulkanFrameReadback(m_Device, Application::get().configuration().headless);
+			return;
+		}
+
+		m_MaxImageCount = m_Swapchain->imageCount();
+
 		m_Swapchain->addSwapchainRecreateCallback([&]() {
 			m_MaxImageCount = m_Swapchain->imageCount();
 			m_CurrentImageIndex = 0;
@@ -27,11 +36,14 @@ namespace milo {
 	}
 
 	VulkanPresenter::~VulkanPresenter() {
+		DELETE_PTR(m_Readback);
 		destroySyncObjects();
 	}
 
 	bool VulkanPresenter::begin() {
 
+		if(m_Swapchain == nullptr) return beginOffscreen();
+
 		if(Window::get()->size().isZero()) return false;
 
 		waitForPreviousFrameToComplete();
@@ -43,6 +55,20 @@ namespace milo {
 		return true;
 	}
 
+	inline bool VulkanPresenter::beginOffscreen() {
+
+		waitForPreviousFrameToComplete();
+
+		// So did the readback of the last frame rendered in this slot
+		m_Readback->complete(m_CurrentFrame);
+
+		m_CurrentImageIndex = m_CurrentFrame;
+
+		setCurrentFrameInFlight();
+
+		return true;
+	}
+
 	inline void VulkanPresenter::waitForPreviousFrameToComplete() {
 		VK_CALL(vkWaitForFences(m_Device->logical(), 1, &m_FramesInFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX));
 	}
@@ -88,6 +114,11 @@ namespace milo {
 
 	void VulkanPresenter::end() {
 
+		if(m_Swapchain == nullptr) {
+			endOffscreen();
+			return;
+		}
+
 		VkSwapchainKHR swapchains = m_Swapchain->vkSwapchain();
 
 		VkPresentInfoKHR presentInfo = {};
@@ -117,6 +148,29 @@ namespace milo {
 		m_CurrentFrame = advanceToNextFrame();
 	}
 
+	void VulkanPresenter::endOffscreen() {
+
+		auto colorAttachment = dynamic_cast<VulkanTexture2D*>(WorldRenderer::get().getFramebuffer().colorAttachments()[0]);
+		VkCommandBuffer commandBuffer = m_Readback->record(m_CurrentFrame, *colorAttachment);
+
+		// The readback waits for every pass of the frame and its submission signals the fence of the frame
+		VulkanQueue* queue = m_Device->graphicsQueue();
+		ArrayList<VkPipelineStageFlags> waitStages(queue->waitSemaphores().size(), VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pWaitSemaphores = queue->waitSemaphores().data();
+		submitInfo.waitSemaphoreCount = queue->waitSemaphores().size();
+		submitInfo.pWaitDstStageMask = waitStages.data();
+
+		queue->submit(submitInfo, m_FramesInFlightFences[m_CurrentFrame]);
+		queue->clear();
+
+		m_CurrentFrame = advanceToNextFrame();
+	}
+
 	uint32_t VulkanPresenter::currentImageIndex() const {
 		return m_CurrentImageIndex;
 	}
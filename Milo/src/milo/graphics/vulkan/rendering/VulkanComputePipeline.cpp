@@ -0,0 +1,99 @@
+#include "milo/graphics/vulkan/rendering/VulkanComputePipeline.h"
+#include "milo/assets/AssetManager.h"
+#include "milo/graphics/vulkan/shaders/VulkanShader.h"
+
+namespace milo {
+
+	ArrayList<VulkanComputePipeline*> VulkanComputePipeline::s_Pipelines;
+	Mutex VulkanComputePipeline::s_Mutex;
+
+	VulkanComputePipeline::VulkanComputePipeline(String name, VulkanDevice* device, VkPipelineLayout pipelineLayout, String shaderFilename, VkPipelineCreateFlags flags)
+		: m_Name(std::move(name)), m_Device(device), m_PipelineLayout(pipelineLayout), m_ShaderFilename(std::move(shaderFilename)), m_Flags(flags) {
+
+		m_Pipeline = createPipeline();
+
+		std::lock_guard<Mutex> lock(s_Mutex);
+		s_Pipelines.push_back(this);
+	}
+
+	VulkanComputePipeline::~VulkanComputePipeline() {
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_Pipelines.erase(std::remove(s_Pipelines.begin(), s_Pipelines.end(), this), s_Pipelines.end());
+		}
+		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_Pipeline, nullptr));
+	}
+
+	VulkanDevice* VulkanComputePipeline::device() const {
+		return m_Device;
+	}
+
+	VkPipelineLayout VulkanComputePipeline::pipelineLayout() const {
+		return m_PipelineLayout;
+	}
+
+	VkPipeline VulkanComputePipeline::vkPipeline() const {
+		return m_Pipeline;
+	}
+
+	const String& VulkanComputePipeline::shaderFilename() const {
+		return m_ShaderFilename;
+	}
+
+	VkPipeline VulkanComputePipeline::createPipeline() const {
+
+		auto* shader = dynamic_cast<VulkanShader*>(Assets::shaders().load(m_ShaderFilename));
+
+		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
+		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		shaderModuleCreateInfo.pCode = (uint32_t*)shader->bytecode();
+		shaderModuleCreateInfo.codeSize = shader->bytecodeLength();
+
+		VkShaderModule shaderModule;
+		VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
+
+		VkPipelineShaderStageCreateInfo shaderStage{};
+		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStage.module = shaderModule;
+		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		shaderStage.pName = "main";
+
+		VkComputePipelineCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		createInfo.layout = m_PipelineLayout;
+		createInfo.stage = shaderStage;
+		createInfo.flags = m_Flags;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		const VkResult result = vkCreateComputePipelines(m_Device->logical(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &pipeline);
+
+		VK_CALLV(vkDestroyShaderModule(m_Device->logical(), shaderModule, nullptr));
+
+		if(result != VK_SUCCESS) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("Failed to create compute pipeline {}: VkResult {}", m_Name, (int32_t)result));
+		}
+
+		return pipeline;
+	}
+
+	void VulkanComputePipeline::rebuildPipelinesUsing(const String& shaderFilename) {
+
+		const String path = Files::toAbsolutePath(shaderFilename);
+
+		std::lock_guard<Mutex> lock(s_Mutex);
+
+		for(VulkanComputePipeline* pipeline : s_Pipelines) {
+
+			if(Files::toAbsolutePath(pipeline->m_ShaderFilename) != path) continue;
+
+			try {
+				VkPipeline newPipeline = pipeline->createPipeline();
+				VK_CALLV(vkDestroyPipeline(pipeline->m_Device->logical(), pipeline->m_Pipeline, nullptr));
+				pipeline->m_Pipeline = newPipeline;
+				Log::info("Compute pipeline {} rebuilt", pipeline->m_Name);
+			} catch(const Exception& e) {
+				Log::error("Failed to rebuild compute pipeline {}, keeping the previous version: {}", pipeline->m_Name, e.what());
+			}
+		}
+	}
+}
\ No newline at end of file
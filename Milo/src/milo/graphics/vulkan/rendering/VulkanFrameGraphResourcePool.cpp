@@ -1,14 +1,164 @@
 #include "milo/graphics/vulkan/rendering/VulkanFrameGraphResourcePool.h"
 #include "milo/graphics/vulkan/presentation/VulkanPresenter.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/scenes/SceneManager.h"
 
 namespace milo {
 
+	struct VulkanAccessInfo {
+		VkImageLayout layout;
+		VkPipelineStageFlags stages;
+		VkAccessFlags access;
+	};
+
+	static VulkanAccessInfo vulkanAccessOf(FrameGraphAccess access) {
+		switch(access) {
+			case FrameGraphAccess::ColorAttachment:
+				return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+						VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT};
+			case FrameGraphAccess::DepthAttachment:
+				return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+						VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+						VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT};
+			case FrameGraphAccess::SampledFragment:
+				return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+			case FrameGraphAccess::SampledDepthFragment:
+				return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+			case FrameGraphAccess::SampledCompute:
+				return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+			case FrameGraphAccess::StorageReadFragment:
+				return {VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+			case FrameGraphAccess::StorageReadCompute:
+				return {VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT};
+			case FrameGraphAccess::StorageWriteCompute:
+				return {VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT};
+			default:
+				return {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0};
+		}
+	}
+
 	VulkanFrameGraphResourcePool::VulkanFrameGraphResourcePool() {
+		m_Device = VulkanContext::get()->device();
+		m_UniformRing = new VulkanUniformRing(m_Device);
 	}
 
 	VulkanFrameGraphResourcePool::~VulkanFrameGraphResourcePool() {
+		m_Device->awaitTermination();
+		destroyPassBarriers();
+		destroyTransientTextures();
+		DELETE_PTR(m_UniformRing);
+	}
+
+	void VulkanFrameGraphResourcePool::compile(Scene* scene) {
+		FrameGraphResourcePool::compile(scene);
+		m_UniformRing->beginFrame(currentFramebufferIndex());
+		writeFrameUniforms();
+	}
+
+	VulkanUniformRing& VulkanFrameGraphResourcePool::uniformRing() const {
+		return *m_UniformRing;
+	}
+
+	const FrameUniformOffsets& VulkanFrameGraphResourcePool::frameUniforms() const {
+		return m_FrameUniforms;
+	}
+
+	void VulkanFrameGraphResourcePool::realize(const CompiledFrameGraph& graph) {
+
+		// The previous graph may still be in flight
+		m_Device->awaitTermination();
+
+		destroyPassBarriers();
+		createPassBarriers(graph);
+
+		bool transientsChanged = m_RealizedTransients.size() != graph.transientTextures.size();
+		for(uint32_t i = 0;!transientsChanged && i < m_RealizedTransients.size();++i) {
+			const FrameGraphTransientTexture& realized = m_RealizedTransients[i];
+			const FrameGraphTransientTexture& transient = graph.transientTextures[i];
+			transientsChanged = realized.resource != transient.resource
+					|| realized.description != transient.description
+					|| realized.aliasSlot != transient.aliasSlot;
+		}
+
+		if(transientsChanged) {
+			destroyTransientTextures();
+			createTransientTextures(graph);
+		}
+	}
+
+	void VulkanFrameGraphResourcePool::beginPass(const CompiledFrameGraph& graph, uint32_t passIndex) {
+
+		const CompiledFrameGraphPass& pass = graph.passes[passIndex];
+		if(pass.barriers.empty()) return;
+
+		const uint32_t imageIndex = currentFramebufferIndex();
+		const PassBarriers& passBarriers = m_PassBarriers[passIndex];
+		VkCommandBuffer commandBuffer = passBarriers.barrierCommandBuffers[imageIndex];
+
+		recordBarriers(commandBuffer, pass.barriers, false, imageIndex);
+
+		bool crossQueue = false;
+		for(const FrameGraphBarrier& barrier : pass.barriers) {
+			crossQueue |= barrier.srcQueue != barrier.dstQueue;
+		}
+
+		// Work from another queue is only visible after waiting for it, so those barriers join the semaphore chain
+		submitBarriers(queueOf(pass.queue), commandBuffer, crossQueue ? passBarriers.barrierSemaphores[imageIndex] : VK_NULL_HANDLE);
+	}
+
+	void VulkanFrameGraphResourcePool::endPass(const CompiledFrameGraph& graph, uint32_t passIndex) {
+
+		const CompiledFrameGraphPass& pass = graph.passes[passIndex];
+		const uint32_t imageIndex = currentFramebufferIndex();
+
+		// Render passes leave their attachments in the layout of the access the pass declared
+		for(const FrameGraphResourceUse& use : pass.uses) {
+			if(!isWriteAccess(use.access)) continue;
+			auto it = m_BoundResources.find(use.resource);
+			if(it == m_BoundResources.end() || it->second.textures[imageIndex] == nullptr) continue;
+			const VulkanAccessInfo info = vulkanAccessOf(use.access);
+			it->second.textures[imageIndex]->setCurrentLayout(info.layout, info.access, info.stages);
+		}
+
+		bool release = false;
+		for(const FrameGraphBarrier& barrier : pass.releases) {
+			release |= requiresOwnershipTransfer(barrier);
+		}
+		if(!release) return;
+
+		const PassBarriers& passBarriers = m_PassBarriers[passIndex];
+		VkCommandBuffer commandBuffer = passBarriers.releaseCommandBuffers[imageIndex];
+
+		recordBarriers(commandBuffer, pass.releases, true, imageIndex);
+
+		submitBarriers(queueOf(pass.queue), commandBuffer, passBarriers.releaseSemaphores[imageIndex]);
+	}
+
+	void VulkanFrameGraphResourcePool::bindTexture(FrameGraphResourceId id, VulkanTexture* texture, uint32_t imageIndex) {
+		BoundResource& resource = m_BoundResources[id];
+		if(imageIndex == UINT32_MAX) {
+			resource.textures.fill(texture);
+		} else {
+			resource.textures[imageIndex] = texture;
+		}
+	}
+
+	void VulkanFrameGraphResourcePool::bindBuffer(FrameGraphResourceId id, VulkanBuffer* buffer, uint32_t imageIndex) {
+		BoundResource& resource = m_BoundResources[id];
+		if(imageIndex == UINT32_MAX) {
+			resource.buffers.fill(buffer);
+		} else {
+			resource.buffers[imageIndex] = buffer;
+		}
+	}
+
+	uint64_t VulkanFrameGraphResourcePool::transientMemorySize() const {
+		return m_TransientMemorySize;
+	}
+
+	uint64_t VulkanFrameGraphResourcePool::transientMemorySizeWithoutAliasing() const {
+		return m_TransientMemorySizeWithoutAliasing;
 	}
 
 	uint32_t VulkanFrameGraphResourcePool::currentFramebufferIndex() const {
@@ -16,6 +166,301 @@ namespace milo {
 	}
 
 	uint32_t VulkanFrameGraphResourcePool::maxDefaultFramebuffersCount() const {
-		return VulkanContext::get()->swapchain()->imageCount();
+		return VulkanContext::get()->vulkanPresenter()->maxImageCount();
+	}
+
+	void VulkanFrameGraphResourcePool::writeFrameUniforms() {
+
+		const WorldRenderer& renderer = WorldRenderer::get();
+
+		// Blocks are written straight into the mapped ring memory. Every pass binds them with these offsets
+		{
+			const CameraInfo& camera = renderer.camera();
+			VulkanUniformRing::Allocation allocation = m_UniformRing->allocate(sizeof(CameraUniformData));
+			auto* cameraData = (CameraUniformData*)allocation.data;
+			cameraData->projectionMatrix = camera.proj;
+			cameraData->viewMatrix = camera.view;
+			cameraData->viewProjectionMatrix = camera.projView;
+			cameraData->position = Vector4(camera.position, 1.0f);
+			m_FrameUniforms.camera = allocation.offset;
+		}
+
+		{
+			const LightEnvironment& lights = renderer.lights();
+			VulkanUniformRing::Allocation allocation = m_UniformRing->allocate(sizeof(PointLightsUniformData));
+			auto* pointLightsData = (PointLightsUniformData*)allocation.data;
+			uint32_t pointLightsCount = std::min(lights.pointLights.size(), (size_t)MAX_POINT_LIGHTS);
+			memcpy(pointLightsData->pointLights, lights.pointLights.data(), pointLightsCount * sizeof(PointLight));
+			pointLightsData->pointLightsCount = pointLightsCount;
+			m_FrameUniforms.pointLights = allocation.offset;
+		}
+
+		{
+			const auto& cascades = renderer.shadowCascades();
+			VulkanUniformRing::Allocation allocation = m_UniformRing->allocate(sizeof(ShadowCascadesUniformData));
+			auto* cascadesData = (ShadowCascadesUniformData*)allocation.data;
+			for(uint32_t i = 0;i < MAX_SHADOW_CASCADES;++i) {
+				cascadesData->viewProjectionMatrix[i] = cascades[i].viewProj;
+			}
+			m_FrameUniforms.shadowCascades = allocation.offset;
+		}
+	}
+
+	void VulkanFrameGraphResourcePool::createTransientTextures(const CompiledFrameGraph& graph) {
+
+		m_RealizedTransients = graph.transientTextures;
+
+		struct Memory {
+			VkMemoryRequirements requirements;
+			uint32_t aliasSlot;
+		};
+		ArrayList<Memory> memories;
+		ArrayList<uint32_t> memoryOfTexture;
+
+		m_TransientMemorySizeWithoutAliasing = 0;
+
+		for(const FrameGraphTransientTexture& transient : m_RealizedTransients) {
+
+			const FrameGraphTextureDescription& description = transient.description;
+
+			VulkanTexture2D* texture = description.layers > 1
+					? VulkanTexture2DArray::create(description.usage, description.layers)
+					: VulkanTexture2D::create(description.usage);
+
+			texture->setName(transient.name);
+			texture->createImage(description.size.width, description.size.height, description.format, 1);
+
+			const VkMemoryRequirements requirements = texture->memoryRequirements();
+			m_TransientMemorySizeWithoutAliasing += requirements.size;
+
+			// Textures of a slot share one allocation, unless their memory types are incompatible
+			uint32_t memoryIndex = UINT32_MAX;
+			for(uint32_t i = 0;i < memories.size();++i) {
+				if(memories[i].aliasSlot == transient.aliasSlot && (memories[i].requirements.memoryTypeBits & requirements.memoryTypeBits) != 0) {
+					memoryIndex = i;
+					break;
+				}
+			}
+
+			if(memoryIndex == UINT32_MAX) {
+				memoryIndex = memories.size();
+				memories.push_back({requirements, transient.aliasSlot});
+			} else {
+				VkMemoryRequirements& memory = memories[memoryIndex].requirements;
+				memory.size = std::max(memory.size, requirements.size);
+				memory.alignment = std::max(memory.alignment, requirements.alignment);
+				memory.memoryTypeBits &= requirements.memoryTypeBits;
+			}
+
+			memoryOfTexture.push_back(memoryIndex);
+			m_TransientTextures.push_back(Ref<Texture2D>(texture));
+		}
+
+		VmaAllocationCreateInfo allocInfo{};
+		allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		allocInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+		m_TransientMemorySize = 0;
+		m_TransientMemory.resize(memories.size(), VK_NULL_HANDLE);
+
+		for(uint32_t i = 0;i < memories.size();++i) {
+			VulkanAllocator::get()->allocateMemory(memories[i].requirements, allocInfo, m_TransientMemory[i]);
+			m_TransientMemorySize += memories[i].requirements.size;
+		}
+
+		for(uint32_t i = 0;i < m_TransientTextures.size();++i) {
+			auto* texture = dynamic_cast<VulkanTexture2D*>(m_TransientTextures[i].get());
+			texture->bindMemory(m_TransientMemory[memoryOfTexture[i]]);
+			putTexture2D(m_RealizedTransients[i].resource, m_TransientTextures[i]);
+			bindTexture(m_RealizedTransients[i].resource, texture);
+		}
+
+		Log::debug("Frame graph transients: {} textures, {} KB in {} allocations ({} KB without aliasing)",
+				   m_TransientTextures.size(), m_TransientMemorySize / 1024, m_TransientMemory.size(),
+				   m_TransientMemorySizeWithoutAliasing / 1024);
+	}
+
+	void VulkanFrameGraphResourcePool::destroyTransientTextures() {
+
+		for(const FrameGraphTransientTexture& transient : m_RealizedTransients) {
+			removeTexture2D(transient.resource);
+			m_BoundResources.erase(transient.resource);
+		}
+		m_RealizedTransients.clear();
+
+		// Images first, they must not outlive the memory they are bound to
+		m_TransientTextures.clear();
+
+		for(VmaAllocation memory : m_TransientMemory) {
+			VulkanAllocator::get()->freeMemory(memory);
+		}
+		m_TransientMemory.clear();
+
+		m_TransientMemorySize = 0;
+		m_TransientMemorySizeWithoutAliasing = 0;
+	}
+
+	void VulkanFrameGraphResourcePool::createPassBarriers(const CompiledFrameGraph& graph) {
+
+		m_PassBarriers.resize(graph.passes.size());
+
+		for(uint32_t i = 0;i < graph.passes.size();++i) {
+
+			PassBarriers& passBarriers = m_PassBarriers[i];
+			passBarriers.commandPool = graph.passes[i].queue == FrameGraphQueue::Compute
+					? m_Device->computeCommandPool()
+					: m_Device->graphicsCommandPool();
+
+			passBarriers.commandPool->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.barrierCommandBuffers.data());
+			passBarriers.commandPool->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.releaseCommandBuffers.data());
+
+			mvk::Semaphore::create(MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.barrierSemaphores.data());
+			mvk::Semaphore::create(MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.releaseSemaphores.data());
+		}
+	}
+
+	void VulkanFrameGraphResourcePool::destroyPassBarriers() {
+
+		for(PassBarriers& passBarriers : m_PassBarriers) {
+			passBarriers.commandPool->free(MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.barrierCommandBuffers.data());
+			passBarriers.commandPool->free(MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.releaseCommandBuffers.data());
+			mvk::Semaphore::destroy(MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.barrierSemaphores.data());
+			mvk::Semaphore::destroy(MAX_SWAPCHAIN_IMAGE_COUNT, passBarriers.releaseSemaphores.data());
+		}
+
+		m_PassBarriers.clear();
+	}
+
+	void VulkanFrameGraphResourcePool::recordBarriers(VkCommandBuffer commandBuffer, const ArrayList<FrameGraphBarrier>& barriers,
+													  bool release, uint32_t imageIndex) {
+
+		m_ImageBarriers.clear();
+		m_BufferBarriers.clear();
+
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+
+		for(const FrameGraphBarrier& barrier : barriers) {
+
+			const bool transfer = requiresOwnershipTransfer(barrier);
+			// Releases only make sense for ownership transfers, the acquire does the rest
+			if(release && !transfer) continue;
+
+			auto it = m_BoundResources.find(barrier.resource);
+			if(it == m_BoundResources.end()) continue;
+
+			VulkanTexture* texture = it->second.textures[imageIndex];
+			VulkanBuffer* buffer = it->second.buffers[imageIndex];
+			if(texture == nullptr && buffer == nullptr) continue;
+
+			const VulkanAccessInfo src = vulkanAccessOf(barrier.srcAccess);
+			const VulkanAccessInfo dst = vulkanAccessOf(barrier.dstAccess);
+
+			VkPipelineStageFlags srcStage = src.stages;
+			VkAccessFlags srcAccess = src.access;
+			VkPipelineStageFlags dstStage = dst.stages;
+			VkAccessFlags dstAccess = dst.access;
+
+			if(release) {
+				dstStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+				dstAccess = 0;
+			} else if(barrier.srcQueue != barrier.dstQueue) {
+				// The other queue's work has been waited with a semaphore, which also made its writes available
+				srcStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+				srcAccess = 0;
+			}
+
+			srcStages |= srcStage;
+			dstStages |= dstStage;
+
+			const uint32_t srcFamily = transfer ? queueOf(barrier.srcQueue)->family() : VK_QUEUE_FAMILY_IGNORED;
+			const uint32_t dstFamily = transfer ? queueOf(barrier.dstQueue)->family() : VK_QUEUE_FAMILY_IGNORED;
+
+			if(texture != nullptr) {
+				VkImageMemoryBarrier imageBarrier{};
+				imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				imageBarrier.srcAccessMask = srcAccess;
+				imageBarrier.dstAccessMask = dstAccess;
+				// Outside of ownership transfers (whose release and acquire must match) trust the tracked layout,
+				// since code outside the graph may have changed it (e.g. the editor viewport)
+				if(barrier.discard || texture->layout() == VK_IMAGE_LAYOUT_UNDEFINED) {
+					imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				} else {
+					imageBarrier.oldLayout = transfer ? src.layout : texture->layout();
+				}
+				imageBarrier.newLayout = dst.layout;
+				imageBarrier.srcQueueFamilyIndex = srcFamily;
+				imageBarrier.dstQueueFamilyIndex = dstFamily;
+				imageBarrier.image = texture->vkImage();
+				imageBarrier.subresourceRange = texture->vkImageViewInfo().subresourceRange;
+				m_ImageBarriers.push_back(imageBarrier);
+				if(!release) texture->setCurrentLayout(dst.layout, dstAccess, dstStage);
+			} else {
+				VkBufferMemoryBarrier bufferBarrier{};
+				bufferBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				bufferBarrier.srcAccessMask = srcAccess;
+				bufferBarrier.dstAccessMask = dstAccess;
+				bufferBarrier.srcQueueFamilyIndex = srcFamily;
+				bufferBarrier.dstQueueFamilyIndex = dstFamily;
+				bufferBarrier.buffer = buffer->vkBuffer();
+				bufferBarrier.offset = 0;
+				bufferBarrier.size = VK_WHOLE_SIZE;
+				m_BufferBarriers.push_back(bufferBarrier);
+			}
+		}
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		{
+			if(!m_ImageBarriers.empty() || !m_BufferBarriers.empty()) {
+				VK_CALLV(vkCmdPipelineBarrier(commandBuffer,
+											  srcStages, dstStages,
+											  0,
+											  0, nullptr,
+											  m_BufferBarriers.size(), m_BufferBarriers.data(),
+											  m_ImageBarriers.size(), m_ImageBarriers.data()));
+			}
+		}
+		VK_CALL(vkEndCommandBuffer(commandBuffer));
+	}
+
+	void VulkanFrameGraphResourcePool::submitBarriers(VulkanQueue* queue, VkCommandBuffer commandBuffer, VkSemaphore signalSemaphore) {
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.commandBufferCount = 1;
+
+		// Passes hand their signal semaphores to the next one through the graphics queue, whatever queue they ran on
+		VulkanQueue* chain = m_Device->graphicsQueue();
+		ArrayList<VkPipelineStageFlags> waitStages;
+
+		if(signalSemaphore != VK_NULL_HANDLE) {
+			waitStages.resize(chain->waitSemaphores().size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+			submitInfo.pWaitSemaphores = chain->waitSemaphores().data();
+			submitInfo.waitSemaphoreCount = chain->waitSemaphores().size();
+			submitInfo.pWaitDstStageMask = waitStages.data();
+			submitInfo.pSignalSemaphores = &signalSemaphore;
+			submitInfo.signalSemaphoreCount = 1;
+		}
+
+		// Detached so the chain is only modified here and not by VulkanQueue::submit
+		queue->submitDetached(submitInfo, VK_NULL_HANDLE);
+
+		if(signalSemaphore != VK_NULL_HANDLE) {
+			chain->setWaitSemaphores(&signalSemaphore, 1);
+		}
+	}
+
+	VulkanQueue* VulkanFrameGraphResourcePool::queueOf(FrameGraphQueue queue) const {
+		return queue == FrameGraphQueue::Compute ? m_Device->computeQueue() : m_Device->graphicsQueue();
+	}
+
+	bool VulkanFrameGraphResourcePool::requiresOwnershipTransfer(const FrameGraphBarrier& barrier) const {
+		if(barrier.discard || barrier.srcQueue == barrier.dstQueue) return false;
+		return queueOf(barrier.srcQueue)->family() != queueOf(barrier.dstQueue)->family();
 	}
-}
\ No newline at end of file
+}
@@ -0,0 +1,436 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "milo/graphics/vulkan/rendering/VulkanGPUProfiler.h"
+#include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/graphics/vulkan/presentation/VulkanPresenter.h"
+#include "milo/graphics/vulkan/commands/VulkanCommandPool.h"
+#include "milo/time/Profiler.h"
+
+namespace milo {
+
+	using namespace std::chrono;
+
+	static const VkQueryPipelineStatisticFlags PIPELINE_STATISTICS_FLAGS =
+			VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT
+			| VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+	// Number of bits set in PIPELINE_STATISTICS_FLAGS. Results are returned in bit order
+	static const uint32_t PIPELINE_STATISTICS_COUNT = 6;
+
+	static const uint32_t TIMESTAMP_QUERY_COUNT = MAX_GPU_PROFILED_PASSES + 1;
+
+#ifdef _WIN32
+	static const VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+	static const VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+	static uint64_t hostTicks() {
+#ifdef _WIN32
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return (uint64_t)counter.QuadPart;
+#else
+		timespec ts{};
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+#endif
+	}
+
+	static double hostTicksToNanos(uint64_t ticks) {
+#ifdef _WIN32
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return (double)ticks * 1e9 / (double)frequency.QuadPart;
+#else
+		return (double)ticks;
+#endif
+	}
+
+	VulkanGPUProfiler* VulkanGPUProfiler::s_Instance = nullptr;
+
+	VulkanGPUProfiler::VulkanGPUProfiler() {
+
+		m_Device = VulkanContext::get()->device();
+
+		VulkanPhysicalDeviceInfo info = m_Device->info();
+
+		const uint32_t validBits = info.queueFamilyProperties()[m_Device->graphicsQueue()->family()].timestampValidBits;
+		m_TimestampsSupported = validBits > 0;
+		m_TimestampMask = validBits >= 64 ? UINT64_MAX : ((uint64_t)1 << validBits) - 1;
+		m_TimestampPeriod = info.limits().timestampPeriod;
+		m_PipelineStatisticsSupported = info.features().pipelineStatisticsQuery == VK_TRUE;
+
+		if(!m_TimestampsSupported) {
+			Log::warn("Graphics queue does not support timestamps, GPU profiling will be disabled");
+		}
+
+		queryCalibratedTimestampsSupport();
+		createQueryPools();
+
+		s_Instance = this;
+	}
+
+	VulkanGPUProfiler::~VulkanGPUProfiler() {
+		m_Device->awaitTermination();
+		destroyQueryPools();
+		if(s_Instance == this) s_Instance = nullptr;
+	}
+
+	void VulkanGPUProfiler::beginFrame() {
+
+		m_CurrentFrame = nullptr;
+		m_CurrentPass = -1;
+		m_OpenStatisticsQuery = UINT32_MAX;
+
+		if(!m_Enabled || !m_TimestampsSupported) return;
+
+		FrameQueries& frame = m_Frames[VulkanContext::get()->vulkanPresenter()->currentFrame()];
+
+		// The frame fence does not cover the markers submitted after the last pass, so they are waited for here
+		if(frame.fenceSubmitted) {
+			VK_CALL(vkWaitForFences(m_Device->logical(), 1, &frame.fence, VK_TRUE, UINT64_MAX));
+			VK_CALL(vkResetFences(m_Device->logical(), 1, &frame.fence));
+			frame.fenceSubmitted = false;
+		}
+
+		if(frame.pending) resolve(frame);
+
+		frame.passCount = 0;
+		frame.statisticsCount = 0;
+		frame.frame = Time::frame();
+		frame.pending = false;
+
+		m_CurrentFrame = &frame;
+
+		calibrate(frame.calibration);
+		writeMarker(0);
+	}
+
+	void VulkanGPUProfiler::beginPass(const String& name) {
+		if(m_CurrentFrame == nullptr) return;
+		if(m_CurrentFrame->passCount >= MAX_GPU_PROFILED_PASSES) return;
+		m_CurrentPass = (int32_t)m_CurrentFrame->passCount;
+		m_CurrentFrame->passNames[m_CurrentPass] = name;
+	}
+
+	void VulkanGPUProfiler::endPass() {
+
+		if(m_CurrentFrame == nullptr || m_CurrentPass < 0) return;
+
+		if(m_OpenStatisticsQuery != UINT32_MAX) {
+			Log::error("{} did not close its pipeline statistics query", m_CurrentFrame->passNames[m_CurrentPass]);
+			m_OpenStatisticsQuery = UINT32_MAX;
+		}
+
+		writeMarker(m_CurrentPass + 1);
+
+		++m_CurrentFrame->passCount;
+		m_CurrentPass = -1;
+	}
+
+	void VulkanGPUProfiler::endFrame() {
+
+		if(m_CurrentFrame == nullptr) return;
+
+		// An empty batch: its fence is signaled once everything submitted to the queue before it has completed
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		m_Device->graphicsQueue()->submitDetached(submitInfo, m_CurrentFrame->fence);
+
+		m_CurrentFrame->fenceSubmitted = true;
+		m_CurrentFrame->pending = m_CurrentFrame->passCount > 0;
+		m_CurrentFrame = nullptr;
+	}
+
+	bool VulkanGPUProfiler::timestampsSupported() const {
+		return m_TimestampsSupported;
+	}
+
+	bool VulkanGPUProfiler::pipelineStatisticsSupported() const {
+		return m_PipelineStatisticsSupported;
+	}
+
+	bool VulkanGPUProfiler::calibratedTimestampsSupported() const {
+		return m_CalibratedTimestampsSupported;
+	}
+
+	void VulkanGPUProfiler::beginStatistics(VkCommandBuffer commandBuffer) {
+
+		if(m_CurrentFrame == nullptr || m_CurrentPass < 0) return;
+		if(!m_PipelineStatisticsEnabled || !m_PipelineStatisticsSupported) return;
+		if(m_OpenStatisticsQuery != UINT32_MAX) return;
+
+		FrameQueries& frame = *m_CurrentFrame;
+		if(frame.statisticsCount >= MAX_GPU_STATISTICS_QUERIES) return;
+
+		const uint32_t query = frame.statisticsCount++;
+		frame.statisticsOwners[query] = (uint32_t)m_CurrentPass;
+
+		VK_CALLV(vkCmdResetQueryPool(commandBuffer, frame.statisticsPool, query, 1));
+		VK_CALLV(vkCmdBeginQuery(commandBuffer, frame.statisticsPool, query, 0));
+
+		m_OpenStatisticsQuery = query;
+	}
+
+	void VulkanGPUProfiler::endStatistics(VkCommandBuffer commandBuffer) {
+		if(m_CurrentFrame == nullptr || m_OpenStatisticsQuery == UINT32_MAX) return;
+		VK_CALLV(vkCmdEndQuery(commandBuffer, m_CurrentFrame->statisticsPool, m_OpenStatisticsQuery));
+		m_OpenStatisticsQuery = UINT32_MAX;
+	}
+
+	void VulkanGPUProfiler::createQueryPools() {
+
+		if(!m_TimestampsSupported) return;
+
+		VkDevice device = m_Device->logical();
+
+		for(FrameQueries& frame : m_Frames) {
+
+			VkQueryPoolCreateInfo timestampPoolInfo{};
+			timestampPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			timestampPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			timestampPoolInfo.queryCount = TIMESTAMP_QUERY_COUNT;
+
+			VK_CALL(vkCreateQueryPool(device, &timestampPoolInfo, nullptr, &frame.timestampPool));
+
+			if(m_PipelineStatisticsSupported) {
+				VkQueryPoolCreateInfo statisticsPoolInfo{};
+				statisticsPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+				statisticsPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+				statisticsPoolInfo.queryCount = MAX_GPU_STATISTICS_QUERIES;
+				statisticsPoolInfo.pipelineStatistics = PIPELINE_STATISTICS_FLAGS;
+
+				VK_CALL(vkCreateQueryPool(device, &statisticsPoolInfo, nullptr, &frame.statisticsPool));
+			}
+
+			m_Device->graphicsCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+													  TIMESTAMP_QUERY_COUNT, frame.markerCommandBuffers.data());
+
+			VkFenceCreateInfo fenceInfo{};
+			fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+			VK_CALL(vkCreateFence(device, &fenceInfo, nullptr, &frame.fence));
+		}
+	}
+
+	void VulkanGPUProfiler::destroyQueryPools() {
+
+		VkDevice device = m_Device->logical();
+
+		for(FrameQueries& frame : m_Frames) {
+			if(frame.timestampPool == VK_NULL_HANDLE) continue;
+
+			VK_CALLV(vkDestroyQueryPool(device, frame.timestampPool, nullptr));
+			frame.timestampPool = VK_NULL_HANDLE;
+
+			if(frame.statisticsPool != VK_NULL_HANDLE) {
+				VK_CALLV(vkDestroyQueryPool(device, frame.statisticsPool, nullptr));
+				frame.statisticsPool = VK_NULL_HANDLE;
+			}
+
+			m_Device->graphicsCommandPool()->free(TIMESTAMP_QUERY_COUNT, frame.markerCommandBuffers.data());
+			frame.markerCommandBuffers.fill(VK_NULL_HANDLE);
+
+			VK_CALLV(vkDestroyFence(device, frame.fence, nullptr));
+			frame.fence = VK_NULL_HANDLE;
+			frame.fenceSubmitted = false;
+		}
+	}
+
+	void VulkanGPUProfiler::queryCalibratedTimestampsSupport() {
+
+		if(!m_Device->extensionEnabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME)) return;
+
+		VkInstance instance = VulkanContext::get()->vkInstance();
+
+		auto getTimeDomains = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+				vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+
+		m_vkGetCalibratedTimestamps = (PFN_vkGetCalibratedTimestampsEXT)
+				vkGetDeviceProcAddr(m_Device->logical(), "vkGetCalibratedTimestampsEXT");
+
+		if(getTimeDomains == nullptr || m_vkGetCalibratedTimestamps == nullptr) return;
+
+		uint32_t count = 0;
+		VK_CALL(getTimeDomains(m_Device->physical(), &count, nullptr));
+		ArrayList<VkTimeDomainEXT> timeDomains(count);
+		VK_CALL(getTimeDomains(m_Device->physical(), &count, timeDomains.data()));
+
+		bool deviceDomain = false;
+		bool hostDomain = false;
+		for(VkTimeDomainEXT timeDomain : timeDomains) {
+			if(timeDomain == VK_TIME_DOMAIN_DEVICE_EXT) deviceDomain = true;
+			if(timeDomain == HOST_TIME_DOMAIN) hostDomain = true;
+		}
+
+		m_HostTimeDomain = HOST_TIME_DOMAIN;
+		m_CalibratedTimestampsSupported = deviceDomain && hostDomain;
+
+		if(m_CalibratedTimestampsSupported) Log::debug("Using calibrated timestamps for GPU profiling");
+	}
+
+	void VulkanGPUProfiler::writeMarker(uint32_t markerIndex) {
+
+		FrameQueries& frame = *m_CurrentFrame;
+		VkCommandBuffer commandBuffer = frame.markerCommandBuffers[markerIndex];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		{
+			if(markerIndex == 0) {
+				VK_CALLV(vkCmdResetQueryPool(commandBuffer, frame.timestampPool, 0, TIMESTAMP_QUERY_COUNT));
+			}
+			VK_CALLV(vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestampPool, markerIndex));
+		}
+		VK_CALL(vkEndCommandBuffer(commandBuffer));
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.commandBufferCount = 1;
+
+		// Detached so the semaphores chaining the passes together are left untouched.
+		// Work submitted to other queues (e.g. async compute) is not ordered with these markers
+		m_Device->graphicsQueue()->submitDetached(submitInfo, VK_NULL_HANDLE);
+	}
+
+	void VulkanGPUProfiler::calibrate(CalibrationSample& sample) {
+
+		sample.calibrated = false;
+
+		if(m_CalibratedTimestampsSupported) {
+
+			VkCalibratedTimestampInfoEXT timestampInfos[2]{};
+			timestampInfos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+			timestampInfos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+			timestampInfos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+			timestampInfos[1].timeDomain = m_HostTimeDomain;
+
+			uint64_t timestamps[2]{};
+			uint64_t maxDeviation = 0;
+
+			if(m_vkGetCalibratedTimestamps(m_Device->logical(), 2, timestampInfos, timestamps, &maxDeviation) == VK_SUCCESS) {
+				// The host domain is not the profiler clock, so sample both back to back to translate between them
+				TimePoint now = high_resolution_clock::now();
+				const uint64_t hostNow = hostTicks();
+				const auto elapsed = (int64_t)hostTicksToNanos(hostNow - timestamps[1]);
+				sample.gpuTicks = timestamps[0] & m_TimestampMask;
+				sample.time = now - duration_cast<TimePoint::duration>(nanoseconds(elapsed));
+				sample.calibrated = true;
+				return;
+			}
+		}
+
+		// The first marker cannot execute before it is submitted. gpuTicks is filled in when the frame is resolved
+		sample.gpuTicks = 0;
+		sample.time = high_resolution_clock::now();
+	}
+
+	void VulkanGPUProfiler::resolve(FrameQueries& frame) {
+
+		frame.pending = false;
+
+		VkDevice device = m_Device->logical();
+
+		const uint32_t timestampCount = frame.passCount + 1;
+		Array<uint64_t, TIMESTAMP_QUERY_COUNT> ticks{};
+
+		VkResult result = VK_CALLR(vkGetQueryPoolResults(device, frame.timestampPool, 0, timestampCount,
+				timestampCount * sizeof(uint64_t), ticks.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+
+		if(result != VK_SUCCESS) {
+			if(result != VK_NOT_READY) Log::error("Failed to read GPU timestamps: {}", mvk::getErrorName(result));
+			return;
+		}
+
+		for(uint32_t i = 0;i < timestampCount;++i) {
+			ticks[i] &= m_TimestampMask;
+		}
+
+		if(!frame.calibration.calibrated) {
+			frame.calibration.gpuTicks = ticks[0];
+		}
+
+		Array<GPUPipelineStatistics, MAX_GPU_PROFILED_PASSES> statistics{};
+		Array<bool, MAX_GPU_PROFILED_PASSES> hasStatistics{};
+
+		if(frame.statisticsCount > 0) {
+
+			const uint32_t stride = PIPELINE_STATISTICS_COUNT * sizeof(uint64_t);
+			Array<uint64_t, MAX_GPU_STATISTICS_QUERIES * PIPELINE_STATISTICS_COUNT> values{};
+
+			result = VK_CALLR(vkGetQueryPoolResults(device, frame.statisticsPool, 0, frame.statisticsCount,
+					frame.statisticsCount * stride, values.data(), stride, VK_QUERY_RESULT_64_BIT));
+
+			if(result == VK_SUCCESS) {
+				for(uint32_t i = 0;i < frame.statisticsCount;++i) {
+					const uint64_t* v = &values[i * PIPELINE_STATISTICS_COUNT];
+					const uint32_t pass = frame.statisticsOwners[i];
+					GPUPipelineStatistics& s = statistics[pass];
+					s.inputAssemblyVertices += v[0];
+					s.inputAssemblyPrimitives += v[1];
+					s.vertexShaderInvocations += v[2];
+					s.clippingPrimitives += v[3];
+					s.fragmentShaderInvocations += v[4];
+					s.computeShaderInvocations += v[5];
+					hasStatistics[pass] = true;
+				}
+			}
+		}
+
+		auto toMillis = [&](uint64_t from, uint64_t to) {
+			return to <= from ? 0.0 : (double)(to - from) * m_TimestampPeriod * 1e-6;
+		};
+
+		m_LastFrame.frame = frame.frame;
+		m_LastFrame.calibrated = frame.calibration.calibrated;
+		m_LastFrame.totalMs = toMillis(ticks[0], ticks[frame.passCount]);
+		m_LastFrame.passes.resize(frame.passCount);
+
+		for(uint32_t i = 0;i < frame.passCount;++i) {
+
+			GPUPassTiming& pass = m_LastFrame.passes[i];
+			pass.name = frame.passNames[i];
+			pass.startMs = toMillis(ticks[0], ticks[i]);
+			pass.durationMs = toMillis(ticks[i], ticks[i + 1]);
+			pass.startTime = toCPUTime(frame.calibration, ticks[i]);
+			pass.endTime = toCPUTime(frame.calibration, ticks[i + 1]);
+			pass.hasStatistics = hasStatistics[i];
+			pass.statistics = statistics[i];
+
+			if(Profiler::enabled()) {
+				ProfileResult profileResult;
+				profileResult.name = pass.name;
+				profileResult.startTime = pass.startTime;
+				profileResult.endTime = pass.endTime;
+				profileResult.threadId = m_Device->graphicsQueue()->family();
+				profileResult.gpu = true;
+				Profiler::submit(profileResult);
+			}
+		}
+	}
+
+	TimePoint VulkanGPUProfiler::toCPUTime(const CalibrationSample& calibration, uint64_t ticks) const {
+		const auto deltaTicks = (int64_t)(ticks - calibration.gpuTicks);
+		const auto nanos = (int64_t)((double)deltaTicks * m_TimestampPeriod);
+		return calibration.time + duration_cast<TimePoint::duration>(nanoseconds(nanos));
+	}
+
+	VulkanGPUProfiler* VulkanGPUProfiler::get() {
+		return s_Instance;
+	}
+}
@@ -1,30 +1,82 @@
 #include "milo/graphics/vulkan/rendering/VulkanGraphicsPipeline.h"
 #include "milo/assets/AssetManager.h"
 #include "milo/graphics/vulkan/shaders/VulkanShader.h"
+#include "milo/graphics/Graphics.h"
 
 namespace milo {
 
-	VulkanGraphicsPipeline::VulkanGraphicsPipeline(const String& name, VulkanDevice* device, const VulkanGraphicsPipeline::CreateInfo& info) {
+	ArrayList<VulkanGraphicsPipeline*> VulkanGraphicsPipeline::s_Pipelines;
+	Mutex VulkanGraphicsPipeline::s_Mutex;
 
-		m_Device = device;
+	VulkanGraphicsPipeline::VulkanGraphicsPipeline(const String& name, VulkanDevice* device, const VulkanGraphicsPipeline::CreateInfo& info)
+		: m_Name(name), m_Device(device), m_Info(info) {
 
 #ifdef _DEBUG
 		if(info.vkRenderPass == VK_NULL_HANDLE) throw MILO_RUNTIME_EXCEPTION("Render Pass has not been set");
 		if(info.shaders.empty()) throw MILO_RUNTIME_EXCEPTION("Graphics Pipeline has no shaders");
 #endif
 
-		VkPipelineLayoutCreateInfo layoutCreateInfo{};
-		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		layoutCreateInfo.pSetLayouts = info.setLayouts.data();
-		layoutCreateInfo.setLayoutCount = info.setLayouts.size();
-		layoutCreateInfo.pPushConstantRanges = info.pushConstantRanges.data();
-		layoutCreateInfo.pushConstantRangeCount = info.pushConstantRanges.size();
+		// The viewport state usually points to the viewport and scissor of the create info itself
+		if(info.viewportState.pViewports == &info.viewport) m_Info.viewportState.pViewports = &m_Info.viewport;
+		if(info.viewportState.pScissors == &info.scissor) m_Info.viewportState.pScissors = &m_Info.scissor;
+
+		if(info.vkPipelineLayout != VK_NULL_HANDLE) {
+			m_PipelineLayout = info.vkPipelineLayout;
+			m_OwnsPipelineLayout = false;
+		} else {
+			VkPipelineLayoutCreateInfo layoutCreateInfo{};
+			layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+			layoutCreateInfo.pSetLayouts = info.setLayouts.data();
+			layoutCreateInfo.setLayoutCount = info.setLayouts.size();
+			layoutCreateInfo.pPushConstantRanges = info.pushConstantRanges.data();
+			layoutCreateInfo.pushConstantRangeCount = info.pushConstantRanges.size();
+
+			VK_CALL(vkCreatePipelineLayout(device->logical(), &layoutCreateInfo, nullptr, &m_PipelineLayout));
+		}
+
+		float start = Time::millis();
+
+		m_Pipeline = createPipeline();
+
+		Log::debug("{} pipeline created after {} ms", name, Time::millis() - start);
+
+		m_PipelineCache = info.vkPipelineCache;
+
+		std::lock_guard<Mutex> lock(s_Mutex);
+		s_Pipelines.push_back(this);
+	}
+
+	VulkanGraphicsPipeline::~VulkanGraphicsPipeline() {
+		{
+			std::lock_guard<Mutex> lock(s_Mutex);
+			s_Pipelines.erase(std::remove(s_Pipelines.begin(), s_Pipelines.end(), this), s_Pipelines.end());
+		}
+
+		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_Pipeline, nullptr));
+
+		if(m_OwnsPipelineLayout) {
+			VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
+		}
+	}
 
-		VK_CALL(vkCreatePipelineLayout(device->logical(), &layoutCreateInfo, nullptr, &m_PipelineLayout));
+	VkPipeline VulkanGraphicsPipeline::createPipeline() const {
 
-		ArrayList<VkShaderModule> shaderModules = toShaderModules(device->logical(), info.shaders);
+		const CreateInfo& info = m_Info;
+
+		ArrayList<VkShaderModule> shaderModules = toShaderModules(m_Device->logical(), info.shaders);
 		ArrayList<VkPipelineShaderStageCreateInfo> shaderStages = createShaderPipelineStages(info.shaders, shaderModules);
 
+		VkSpecializationInfo specializationInfo{};
+		if(!info.specializationEntries.empty()) {
+			specializationInfo.pMapEntries = info.specializationEntries.data();
+			specializationInfo.mapEntryCount = info.specializationEntries.size();
+			specializationInfo.pData = info.specializationData.data();
+			specializationInfo.dataSize = info.specializationData.size();
+			for(VkPipelineShaderStageCreateInfo& shaderStage : shaderStages) {
+				shaderStage.pSpecializationInfo = &specializationInfo;
+			}
+		}
+
 		VkPipelineVertexInputStateCreateInfo vertexInputState = createVertexInputState(info.vertexInputInfo);
 
 		const VkPipelineInputAssemblyStateCreateInfo& assemblyStateInfo = info.inputAssembly;
@@ -63,24 +115,45 @@ namespace milo {
 		pipelineInfo.pDynamicState = &dynamicStateInfo;
 		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-		float start = Time::millis();
-
-		VK_CALL(vkCreateGraphicsPipelines(device->logical(), info.vkPipelineCache, 1, &pipelineInfo, nullptr, &m_Pipeline));
-
-		Log::debug("{} pipeline created after {} ms", name, Time::millis() - start);
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		const VkResult result = vkCreateGraphicsPipelines(m_Device->logical(), info.vkPipelineCache, 1, &pipelineInfo, nullptr, &pipeline);
 
 		for(VkShaderModule shaderModule : shaderModules) {
-			VK_CALLV(vkDestroyShaderModule(device->logical(), shaderModule, nullptr));
+			VK_CALLV(vkDestroyShaderModule(m_Device->logical(), shaderModule, nullptr));
 		}
 
-		m_PipelineCache = info.vkPipelineCache;
+		if(result != VK_SUCCESS) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("Failed to create graphics pipeline {}: VkResult {}", m_Name, (int32_t)result));
+		}
+
+		return pipeline;
 	}
 
-	VulkanGraphicsPipeline::~VulkanGraphicsPipeline() {
+	bool VulkanGraphicsPipeline::usesShader(const String& filename) const {
+		const String path = Files::toAbsolutePath(filename);
+		for(const VulkanShaderInfo& shader : m_Info.shaders) {
+			if(Files::toAbsolutePath(shader.filename) == path) return true;
+		}
+		return false;
+	}
 
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_Pipeline, nullptr));
+	void VulkanGraphicsPipeline::rebuildPipelinesUsing(const String& shaderFilename) {
 
-		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
+		std::lock_guard<Mutex> lock(s_Mutex);
+
+		for(VulkanGraphicsPipeline* pipeline : s_Pipelines) {
+
+			if(!pipeline->usesShader(shaderFilename)) continue;
+
+			try {
+				VkPipeline newPipeline = pipeline->createPipeline();
+				VK_CALLV(vkDestroyPipeline(pipeline->m_Device->logical(), pipeline->m_Pipeline, nullptr));
+				pipeline->m_Pipeline = newPipeline;
+				Log::info("Graphics pipeline {} rebuilt", pipeline->m_Name);
+			} catch(const Exception& e) {
+				Log::error("Failed to rebuild graphics pipeline {}, keeping the previous version: {}", pipeline->m_Name, e.what());
+			}
+		}
 	}
 
 	VulkanDevice* VulkanGraphicsPipeline::device() const {
@@ -241,7 +314,7 @@ namespace milo {
 
 	void VulkanGraphicsPipeline::CreateInfo::initViewportState() {
 
-		const Size windowSize = Window::get()->size();
+		const Size windowSize = Graphics::renderTargetSize();
 
 		viewport.x = 0;
 		viewport.y = 0;
@@ -0,0 +1,162 @@
+#include "milo/graphics/vulkan/rendering/VulkanShaderVariants.h"
+#include "milo/io/Files.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+	// The viewport state of a copied CreateInfo still points to the viewport and scissor of the original one
+	static void fixViewportState(VulkanGraphicsPipeline::CreateInfo& info, const VulkanGraphicsPipeline::CreateInfo& original) {
+		if(original.viewportState.pViewports == &original.viewport) info.viewportState.pViewports = &info.viewport;
+		if(original.viewportState.pScissors == &original.scissor) info.viewportState.pScissors = &info.scissor;
+	}
+
+	VulkanShaderVariants::VulkanShaderVariants(String name, VulkanDevice* device, const VulkanGraphicsPipeline::CreateInfo& info, ArrayList<String> keywords)
+		: m_Name(std::move(name)), m_Device(device), m_Info(info), m_Keywords(std::move(keywords)) {
+
+		if(m_Keywords.size() > MAX_KEYWORDS) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("{} declares {} keywords, the maximum is {}", m_Name, m_Keywords.size(), MAX_KEYWORDS));
+		}
+
+		fixViewportState(m_Info, info);
+
+		VkPipelineLayoutCreateInfo layoutCreateInfo{};
+		layoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		layoutCreateInfo.pSetLayouts = info.setLayouts.data();
+		layoutCreateInfo.setLayoutCount = info.setLayouts.size();
+		layoutCreateInfo.pPushConstantRanges = info.pushConstantRanges.data();
+		layoutCreateInfo.pushConstantRangeCount = info.pushConstantRanges.size();
+
+		VK_CALL(vkCreatePipelineLayout(m_Device->logical(), &layoutCreateInfo, nullptr, &m_PipelineLayout));
+
+		loadPipelineCache();
+
+		m_Info.vkPipelineLayout = m_PipelineLayout;
+		m_Info.vkPipelineCache = m_PipelineCache;
+
+		// One VkBool32 per keyword
+		m_Info.specializationEntries.resize(m_Keywords.size());
+		for(uint32_t i = 0;i < m_Keywords.size();++i) {
+			m_Info.specializationEntries[i].constantID = i;
+			m_Info.specializationEntries[i].offset = i * sizeof(VkBool32);
+			m_Info.specializationEntries[i].size = sizeof(VkBool32);
+		}
+		m_Info.specializationData.resize(m_Keywords.size() * sizeof(VkBool32));
+	}
+
+	VulkanShaderVariants::~VulkanShaderVariants() {
+
+		for(auto& [key, pipeline] : m_Variants) {
+			DELETE_PTR(pipeline);
+		}
+		m_Variants.clear();
+
+		savePipelineCache();
+
+		VK_CALLV(vkDestroyPipelineCache(m_Device->logical(), m_PipelineCache, nullptr));
+		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
+	}
+
+	const String& VulkanShaderVariants::name() const {
+		return m_Name;
+	}
+
+	VkPipelineLayout VulkanShaderVariants::pipelineLayout() const {
+		return m_PipelineLayout;
+	}
+
+	const ArrayList<String>& VulkanShaderVariants::keywords() const {
+		return m_Keywords;
+	}
+
+	size_t VulkanShaderVariants::variantCount() const {
+		return m_Variants.size();
+	}
+
+	VulkanGraphicsPipeline* VulkanShaderVariants::get(ShaderVariantKey key) {
+
+		auto it = m_Variants.find(key);
+		if(it != m_Variants.end()) return it->second;
+
+		VulkanGraphicsPipeline::CreateInfo info = m_Info;
+		fixViewportState(info, m_Info);
+
+		auto* values = (VkBool32*)info.specializationData.data();
+		for(uint32_t i = 0;i < m_Keywords.size();++i) {
+			values[i] = (key >> i) & 1 ? VK_TRUE : VK_FALSE;
+		}
+
+		auto* pipeline = new VulkanGraphicsPipeline(variantName(key), m_Device, info);
+
+		m_Variants[key] = pipeline;
+		m_PipelineCacheModified = true;
+
+		return pipeline;
+	}
+
+	void VulkanShaderVariants::savePipelineCache() {
+
+		if(!m_PipelineCacheModified || m_PipelineCache == VK_NULL_HANDLE) return;
+
+		size_t size = 0;
+		if(vkGetPipelineCacheData(m_Device->logical(), m_PipelineCache, &size, nullptr) != VK_SUCCESS || size == 0) return;
+
+		ArrayList<int8> data(size);
+		if(vkGetPipelineCacheData(m_Device->logical(), m_PipelineCache, &size, data.data()) != VK_SUCCESS) return;
+
+		const bool written = Files::writeAtomically(pipelineCacheFilename(), [&](OutputStream& output) {
+			output.write((const char*)data.data(), (std::streamsize)size);
+		});
+
+		if(written) m_PipelineCacheModified = false;
+	}
+
+	void VulkanShaderVariants::loadPipelineCache() {
+
+		const String filename = pipelineCacheFilename();
+
+		ArrayList<int8> data;
+		if(Files::exists(filename)) {
+			data = Files::readAllBytes(filename);
+		}
+
+		// Data from another driver or device would be ignored anyway, but it is better to know why the cache is cold
+		if(!data.empty()) {
+			VkPhysicalDeviceProperties properties{};
+			vkGetPhysicalDeviceProperties(m_Device->physical(), &properties);
+
+			VkPipelineCacheHeaderVersionOne header{};
+			bool valid = data.size() >= sizeof(header);
+			if(valid) {
+				memcpy(&header, data.data(), sizeof(header));
+				valid = header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+						&& header.vendorID == properties.vendorID
+						&& header.deviceID == properties.deviceID
+						&& memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+			}
+
+			if(!valid) {
+				Log::warn("Ignoring pipeline cache {}, it was created by another device or driver", filename);
+				data.clear();
+			}
+		}
+
+		VkPipelineCacheCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		createInfo.pInitialData = data.data();
+		createInfo.initialDataSize = data.size();
+
+		VK_CALL(vkCreatePipelineCache(m_Device->logical(), &createInfo, nullptr, &m_PipelineCache));
+	}
+
+	String VulkanShaderVariants::pipelineCacheFilename() const {
+		return Files::resource(str("cache/pipelines/") + m_Name + ".cache");
+	}
+
+	String VulkanShaderVariants::variantName(ShaderVariantKey key) const {
+		String name = m_Name;
+		for(uint32_t i = 0;i < m_Keywords.size();++i) {
+			if((key >> i) & 1) name += str(" ") + m_Keywords[i];
+		}
+		return name;
+	}
+}
\ No newline at end of file
@@ -73,21 +73,7 @@ namespace milo {
 
 	void VulkanBoundingVolumeRenderPass::renderMeshViews(uint32_t imageIndex, VkCommandBuffer commandBuffer, Scene* scene) {
 
-		Matrix4 projView;
-
-		if(getSimulationState() == SimulationState::Editor) {
-
-			const EditorCamera& camera = MiloEditor::camera();
-			projView = camera.projMatrix() * camera.viewMatrix();
-
-		} else {
-
-			Entity cameraEntity = scene->cameraEntity();
-			const Camera& camera = cameraEntity.getComponent<Camera>();
-			Matrix4 proj = camera.projectionMatrix();
-			Matrix4 view = camera.viewMatrix(cameraEntity.getComponent<Transform>().translation());
-			projView = proj * view;
-		}
+		const Matrix4& projView = WorldRenderer::get().camera().projView;
 
 		Mesh* cube = Assets::meshes().getCube();
 		Mesh* sphere = Assets::meshes().getSphere();
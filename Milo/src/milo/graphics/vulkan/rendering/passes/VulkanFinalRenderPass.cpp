@@ -174,7 +174,7 @@ namespace milo {
 
 	void VulkanFinalRenderPass::createGraphicsPipeline() {
 
-		const Viewport& viewport = SceneManager::activeScene()->viewport();
+		const Viewport& viewport = WorldRenderer::get().frameData().viewport;
 
 		VulkanGraphicsPipeline::CreateInfo pipelineInfo{};
 		pipelineInfo.vkRenderPass = m_RenderPass;
@@ -103,23 +103,12 @@ namespace milo {
 
 	void VulkanGeometryRenderPass::renderScene(uint32_t imageIndex, VkCommandBuffer commandBuffer, Scene* scene) {
 
-		CameraData cameraData{};
-
-		if(getSimulationState() == SimulationState::Editor) {
-
-			EditorCamera& camera = MiloEditor::camera();
-			cameraData.proj = camera.projMatrix();
-			cameraData.view = camera.viewMatrix();
-			cameraData.projView = cameraData.proj * cameraData.view;
+		const CameraInfo& camera = WorldRenderer::get().camera();
 
-		} else {
-
-			Entity cameraEntity = scene->cameraEntity();
-			Camera& camera = cameraEntity.getComponent<Camera>();
-			cameraData.proj = camera.projectionMatrix();
-			cameraData.view = camera.viewMatrix(cameraEntity.getComponent<Transform>().translation());
-			cameraData.projView = cameraData.proj * cameraData.view;
-		}
+		CameraData cameraData{};
+		cameraData.proj = camera.proj;
+		cameraData.view = camera.view;
+		cameraData.projView = camera.projView;
 
 		m_CameraUniformBuffer->update(imageIndex, cameraData);
 
@@ -55,8 +55,8 @@ namespace milo {
 
 	void VulkanGridRenderPass::execute(Scene* scene) {
 
-		SkyboxView* skyboxView = scene->skyboxView();
-		if(skyboxView == nullptr) return;
+		const FrameRenderData& frame = WorldRenderer::get().frameData();
+		if(frame.background == nullptr) return;
 
 		uint32_t imageIndex = VulkanContext::get()->vulkanPresenter()->currentImageIndex();
 		VkCommandBuffer commandBuffer = m_CommandBuffers[imageIndex];
@@ -64,19 +64,11 @@ namespace milo {
 
 		UniformBuffer uniformBufferData{};
 
-		if(getSimulationState() == SimulationState::Editor) {
-
-			EditorCamera& camera = MiloEditor::camera();
-			Matrix4 modelMatrix = translate(Matrix4(1.0f), camera.position() - Vector3(0, 1, 0)) * scale(Matrix4(1.0f), Vector3(10.0f));
-			uniformBufferData.projViewModel = camera.projMatrix() * camera.viewMatrix() * modelMatrix;
-
+		if(frame.simulationState == SimulationState::Editor) {
+			Matrix4 modelMatrix = translate(Matrix4(1.0f), frame.camera.position - Vector3(0, 1, 0)) * scale(Matrix4(1.0f), Vector3(10.0f));
+			uniformBufferData.projViewModel = frame.camera.projView * modelMatrix;
 		} else {
-
-			Entity cameraEntity = scene->cameraEntity();
-			Camera& camera = cameraEntity.getComponent<Camera>();
-			uniformBufferData.projViewModel = camera.projectionMatrix()
-					* camera.viewMatrix(cameraEntity.getComponent<Transform>().translation())
-					* TRANSFORM;
+			uniformBufferData.projViewModel = frame.camera.projView * TRANSFORM;
 		}
 
 		uniformBufferData.scale = 16;//16.025f;
@@ -182,7 +174,7 @@ namespace milo {
 		m_Device->graphicsCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY,
 												  m_CommandBuffers.size(), m_CommandBuffers.data());
 
-		Scene* scene = SceneManager::activeScene();
+		const FrameRenderData& frame = WorldRenderer::get().frameData();
 
 		Mesh* mesh = Assets::meshes().getPlane();
 
@@ -195,7 +187,7 @@ namespace milo {
 			VkCommandBufferBeginInfo beginInfo{};
 			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-			const Viewport& sceneViewport = scene->viewport();
+			const Viewport& sceneViewport = frame.viewport;
 
 			VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 			{
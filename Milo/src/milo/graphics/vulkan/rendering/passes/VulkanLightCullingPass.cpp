@@ -1,15 +1,14 @@
 #include "milo/graphics/vulkan/rendering/passes/VulkanLightCullingPass.h"
 #include "milo/graphics/rendering/passes/PreDepthRenderPass.h"
-#include "milo/graphics/vulkan/shaders/VulkanShader.h"
 #include "milo/scenes/SceneManager.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
 #include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
+#include "milo/graphics/vulkan/rendering/VulkanFrameGraphResourcePool.h"
 
 namespace milo {
 
 	VulkanLightCullingPass::VulkanLightCullingPass() {
 		m_Device = VulkanContext::get()->device();
-		createCameraUniformBuffer();
-		createPointLightsUniformBuffer();
 		createVisibleLightIndicesStorageBuffer();
 		createDescriptorSetLayout();
 		createDescriptorPool();
@@ -23,15 +22,12 @@ namespace milo {
 
 		VkDevice device = m_Device->logical();
 
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_ComputePipeline, nullptr));
+		DELETE_PTR(m_ComputePipeline);
 		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
 
 		DELETE_PTR(m_DescriptorPool);
 		VK_CALLV(vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr));
 
-		DELETE_PTR(m_CameraUniformBuffer);
-		DELETE_PTR(m_PointLightsUniformBuffer);
-
 		mvk::Semaphore::destroy(m_SignalSemaphores.size(), m_SignalSemaphores.data());
 
 		m_Device->computeCommandPool()->free(m_CommandBuffers.size(), m_CommandBuffers.data());
@@ -80,12 +76,14 @@ namespace milo {
 
 		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 		{
-			VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline));
+			VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->vkPipeline()));
+
+			const auto& frameUniforms = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources()).frameUniforms();
 
 			VkDescriptorSet descriptorSet = m_DescriptorPool->get(imageIndex);
 			uint32_t dynamicOffsets[] = {
-					(uint32_t) (imageIndex * m_CameraUniformBuffer->elementSize()),
-					(uint32_t) (imageIndex * m_PointLightsUniformBuffer->elementSize()),
+					frameUniforms.camera,
+					frameUniforms.pointLights,
 					(uint32_t) (imageIndex * sizeof(VisibleLightsBuffer))};
 
 			VK_CALLV(vkCmdBindDescriptorSets(commandBuffer,
@@ -95,14 +93,14 @@ namespace milo {
 											 3, dynamicOffsets));
 
 			PushConstants pushConstants{};
-			pushConstants.screenSize = scene->viewportSize();
+			pushConstants.screenSize = WorldRenderer::get().frameData().viewportSize();
 
 			VK_CALLV(vkCmdPushConstants(commandBuffer, m_PipelineLayout,
 										VK_SHADER_STAGE_COMPUTE_BIT,
 										0, sizeof(PushConstants),
 										&pushConstants));
 
-			const Size viewport = scene->viewportSize();
+			const Size viewport = pushConstants.screenSize;
 			const uint32_t workGroupsX = (viewport.width + (viewport.width % TILE_SIZE)) / TILE_SIZE;
 			const uint32_t workGroupsY = (viewport.height + (viewport.height % TILE_SIZE)) / TILE_SIZE;
 
@@ -113,26 +111,12 @@ namespace milo {
 
 	void VulkanLightCullingPass::updateUniforms(uint32_t imageIndex, Scene* scene) {
 
-		{
-			const auto& camera = WorldRenderer::get().camera();
-			CameraUniformBuffer cameraData{};
-			cameraData.projectionMatrix = camera.proj;
-			cameraData.viewMatrix = camera.view;
-			cameraData.viewProjectionMatrix = camera.projView;
-			m_CameraUniformBuffer->update(imageIndex, cameraData);
-		}
-
-		{
-			const auto& lights = WorldRenderer::get().lights();
-			PointLightsUniformBuffer pointLightsData{};
-			memcpy(pointLightsData.pointLights, lights.pointLights.data(), lights.pointLights.size() * sizeof(PointLight));
-			pointLightsData.pointLightsCount = lights.pointLights.size();
-			m_PointLightsUniformBuffer->update(imageIndex, pointLightsData);
-		}
+		// Camera and point lights have already been written into the uniform ring by the resource pool
+		updateBufferDescriptors(imageIndex);
 
 		auto framebuffer = WorldRenderer::get().resources().getFramebuffer(PreDepthRenderPass::getFramebufferHandle(imageIndex));
+		// Transitioned to SHADER_READ_ONLY_OPTIMAL by the frame graph before this pass
 		auto* depthMap = (VulkanTexture2D*)framebuffer->colorAttachments()[0];
-		depthMap->setLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
 		VkDescriptorImageInfo imageInfo{};
 		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
@@ -199,16 +183,6 @@ namespace milo {
 		m_DescriptorPool = new VulkanDescriptorPool(m_Device, createInfo);
 	}
 
-	void VulkanLightCullingPass::createCameraUniformBuffer() {
-		m_CameraUniformBuffer = VulkanUniformBuffer<CameraUniformBuffer>::create();
-		m_CameraUniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
-	}
-
-	void VulkanLightCullingPass::createPointLightsUniformBuffer() {
-		m_PointLightsUniformBuffer = VulkanUniformBuffer<PointLightsUniformBuffer>::create();
-		m_PointLightsUniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
-	}
-
 	void VulkanLightCullingPass::createVisibleLightIndicesStorageBuffer() {
 
 		m_VisibleLightsStorageBuffer = Ref<VulkanStorageBuffer<VisibleLightsBuffer>>(
@@ -216,36 +190,42 @@ namespace milo {
 
 		m_VisibleLightsStorageBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
 
-		WorldRenderer::get().resources().putBuffer(LightCullingPass::getVisibleLightsBufferHandle(), m_VisibleLightsStorageBuffer);
+		auto& resources = dynamic_cast<VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
+		resources.putBuffer(LightCullingPass::getVisibleLightsBufferHandle(), m_VisibleLightsStorageBuffer);
+		resources.bindBuffer(FrameGraphBuilder::resourceId(VISIBLE_LIGHTS), m_VisibleLightsStorageBuffer.get());
 	}
 
 	void VulkanLightCullingPass::createDescriptorSets() {
+		// Buffer descriptors are written on first use, see updateBufferDescriptors
+		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
+	}
+
+	void VulkanLightCullingPass::updateBufferDescriptors(uint32_t imageIndex) {
 
-		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT, [this](uint32_t index, VkDescriptorSet descriptorSet) {
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
+		const VulkanUniformRing& uniformRing = resources.uniformRing();
 
-			VkDescriptorBufferInfo cameraBufferInfo = {};
-			cameraBufferInfo.buffer = m_CameraUniformBuffer->vkBuffer();
-			cameraBufferInfo.offset = 0;
-			cameraBufferInfo.range = sizeof(CameraUniformBuffer);
+		if(m_UniformRingGenerations[imageIndex] == uniformRing.generation()) return;
 
-			VkDescriptorBufferInfo pointLightsBufferInfo = {};
-			pointLightsBufferInfo.buffer = m_PointLightsUniformBuffer->vkBuffer();
-			pointLightsBufferInfo.offset = 0;
-			pointLightsBufferInfo.range = sizeof(PointLightsUniformBuffer);
+		VkDescriptorBufferInfo cameraBufferInfo = uniformRing.descriptorInfo<CameraUniformData>();
+		VkDescriptorBufferInfo pointLightsBufferInfo = uniformRing.descriptorInfo<PointLightsUniformData>();
 
-			VkDescriptorBufferInfo visibleIndicesBufferInfo = {};
-			visibleIndicesBufferInfo.buffer = m_VisibleLightsStorageBuffer->vkBuffer();
-			visibleIndicesBufferInfo.offset = 0;
-			visibleIndicesBufferInfo.range = sizeof(VisibleLightsBuffer);
+		VkDescriptorBufferInfo visibleIndicesBufferInfo = {};
+		visibleIndicesBufferInfo.buffer = m_VisibleLightsStorageBuffer->vkBuffer();
+		visibleIndicesBufferInfo.offset = 0;
+		visibleIndicesBufferInfo.range = sizeof(VisibleLightsBuffer);
 
-			VkWriteDescriptorSet writeDescriptorSets[3] = {
-					mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &cameraBufferInfo),
-					mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(1, descriptorSet, 1, &pointLightsBufferInfo),
-					mvk::WriteDescriptorSet::createDynamicStorageBufferWrite(2, descriptorSet, 1, &visibleIndicesBufferInfo)
-			};
+		VkDescriptorSet descriptorSet = m_DescriptorPool->get(imageIndex);
+
+		VkWriteDescriptorSet writeDescriptorSets[3] = {
+				mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &cameraBufferInfo),
+				mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(1, descriptorSet, 1, &pointLightsBufferInfo),
+				mvk::WriteDescriptorSet::createDynamicStorageBufferWrite(2, descriptorSet, 1, &visibleIndicesBufferInfo)
+		};
+
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 3, writeDescriptorSets, 0, nullptr));
 
-			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 3, writeDescriptorSets, 0, nullptr));
-		});
+		m_UniformRingGenerations[imageIndex] = uniformRing.generation();
 	}
 
 	void VulkanLightCullingPass::createComputePipeline() {
@@ -264,33 +244,7 @@ namespace milo {
 
 		VK_CALL(vkCreatePipelineLayout(m_Device->logical(), &layoutCreateInfo, nullptr, &m_PipelineLayout));
 
-		const VulkanShader* shader = (const VulkanShader*)Assets::shaders().load("resources/shaders/culling/light_culling.comp");
-
-		VkShaderModule shaderModule = VK_NULL_HANDLE;
-
-		{
-			VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-			shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-			shaderModuleCreateInfo.codeSize = shader->bytecodeLength();
-			shaderModuleCreateInfo.pCode = (uint32_t*)shader->bytecode();
-
-			VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
-		}
-
-		VkPipelineShaderStageCreateInfo shaderStage{};
-		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		shaderStage.module = shaderModule;
-		shaderStage.pName = "main";
-
-		VkComputePipelineCreateInfo pipelineInfo{};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		pipelineInfo.layout = m_PipelineLayout;
-		pipelineInfo.stage = shaderStage;
-
-		VK_CALL(vkCreateComputePipelines(m_Device->logical(), nullptr, 1, &pipelineInfo, nullptr, &m_ComputePipeline));
-
-		VK_CALLV(vkDestroyShaderModule(m_Device->logical(), shaderModule, nullptr));
+		m_ComputePipeline = new VulkanComputePipeline("VulkanLightCullingPass", m_Device, m_PipelineLayout, "resources/shaders/culling/light_culling.comp");
 	}
 
 	void VulkanLightCullingPass::createCommandBuffers() {
@@ -1,6 +1,7 @@
 #include <milo/graphics/vulkan/buffers/VulkanMeshBuffers.h>
 #include "milo/graphics/vulkan/rendering/passes/VulkanPBRForwardRenderPass.h"
 #include "milo/graphics/vulkan/rendering/VulkanFrameGraphResourcePool.h"
+#include "milo/graphics/vulkan/rendering/VulkanGPUProfiler.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
 #include "milo/assets/AssetManager.h"
 #include "milo/graphics/vulkan/materials/VulkanMaterialResourcePool.h"
@@ -19,10 +20,7 @@ namespace milo {
 
 		createRenderPass();
 
-		createSceneUniformBuffers();
 		createSceneDescriptorSetLayoutAndPool();
-
-		createShadowsUniformBuffer();
 		createShadowsDescriptorSetLayoutAndPool();
 
 		createGraphicsPipeline();
@@ -37,14 +35,12 @@ namespace milo {
 
 		VK_CALLV(vkDestroyRenderPass(device, m_RenderPass, nullptr));
 
-		DELETE_PTR(m_CameraUniformBuffer);
-		DELETE_PTR(m_EnvironmentUniformBuffer);
-		DELETE_PTR(m_PointLightsUniformBuffer);
-		DELETE_PTR(m_ShadowsUniformBuffer);
 		VK_CALLV(vkDestroyDescriptorSetLayout(device, m_SceneDescriptorSetLayout, nullptr));
 		DELETE_PTR(m_SceneDescriptorPool);
+		VK_CALLV(vkDestroyDescriptorSetLayout(device, m_ShadowsDescriptorSetLayout, nullptr));
+		DELETE_PTR(m_ShadowsDescriptorPool);
 
-		DELETE_PTR(m_GraphicsPipeline);
+		DELETE_PTR(m_ShaderVariants);
 
 		for(uint32_t i = 0;i < MAX_SWAPCHAIN_IMAGE_COUNT;++i) {
 			VK_CALLV(vkDestroySemaphore(device, m_SignalSemaphores[i], nullptr));
@@ -92,7 +88,9 @@ namespace milo {
 
 		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 		{
+			if(VulkanGPUProfiler* profiler = VulkanGPUProfiler::get()) profiler->beginStatistics(commandBuffer);
 			renderScene(imageIndex, commandBuffer);
+			if(VulkanGPUProfiler* profiler = VulkanGPUProfiler::get()) profiler->endStatistics(commandBuffer);
 		}
 		VK_CALLV(vkEndCommandBuffer(commandBuffer));
 	}
@@ -103,8 +101,9 @@ namespace milo {
 
 		auto& materialResources = dynamic_cast<VulkanMaterialResourcePool&>(Assets::materials().resourcePool());
 
+		updateBufferDescriptors(imageIndex);
 		updateSceneUniformData(imageIndex);
-		updateShadowsUniformData(imageIndex, SceneManager::activeScene()->viewportSize().width);
+		updateShadowsUniformData(imageIndex, WorldRenderer::get().frameData().viewportSize().width);
 
 		// Multithreading not supported for now
 		renderSceneSingleThread(imageIndex, commandBuffer, materialResources);
@@ -133,8 +132,6 @@ namespace milo {
 
 		VK_CALLV(vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE));
 
-		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->vkPipeline()));
-
 		VkViewport viewport;
 		viewport.x = 0;
 		viewport.y = 0;
@@ -152,6 +149,20 @@ namespace milo {
 
 		bindDescriptorSets(imageIndex, commandBuffer);
 
+		const bool bindless = materialResources.bindlessSupported();
+
+		if(bindless) {
+			// Every material lives in the same descriptor set, only the material index changes between draws
+			VkDescriptorSet materialsDescriptorSet = materialResources.bindlessDescriptorSet();
+			VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+											 m_ShaderVariants->pipelineLayout(),
+											 2, 1, &materialsDescriptorSet, 0, nullptr));
+		}
+
+		// Every variant shares the same layout, so the bound descriptor sets survive pipeline switches
+		const ShaderVariantKey sceneKey = sceneVariantKey();
+		ShaderVariantKey lastKey = UINT32_MAX;
+
 		Mesh* lastMesh = nullptr;
 		Material* lastMaterial = nullptr;
 
@@ -162,7 +173,16 @@ namespace milo {
 			Material* material = drawCommand.material;
 
 			if(lastMaterial != material) {
-				bindMaterial(commandBuffer, materialResources, material);
+				const ShaderVariantKey key = sceneKey | materialVariantKey(material);
+				if(key != lastKey) {
+					VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ShaderVariants->get(key)->vkPipeline()));
+					lastKey = key;
+				}
+				if(bindless) {
+					pushMaterialIndex(commandBuffer, materialResources.indexOf(material));
+				} else {
+					bindMaterial(commandBuffer, materialResources, material);
+				}
 				lastMaterial = material;
 			}
 
@@ -189,11 +209,42 @@ namespace milo {
 
 	void VulkanPBRForwardRenderPass::pushConstants(VkCommandBuffer commandBuffer, const Matrix4& transform) const {
 		PushConstants pushConstants = {transform};
-		VK_CALLV(vkCmdPushConstants(commandBuffer, m_GraphicsPipeline->pipelineLayout(),
+		VK_CALLV(vkCmdPushConstants(commandBuffer, m_ShaderVariants->pipelineLayout(),
 									VK_SHADER_STAGE_VERTEX_BIT,
 									0, sizeof(PushConstants), &pushConstants));
 	}
 
+	void VulkanPBRForwardRenderPass::pushMaterialIndex(VkCommandBuffer commandBuffer, uint32_t materialIndex) const {
+		VK_CALLV(vkCmdPushConstants(commandBuffer, m_ShaderVariants->pipelineLayout(),
+									VK_SHADER_STAGE_FRAGMENT_BIT,
+									sizeof(PushConstants), sizeof(uint32_t), &materialIndex));
+	}
+
+	ShaderVariantKey VulkanPBRForwardRenderPass::sceneVariantKey() const {
+
+		const WorldRenderer& renderer = WorldRenderer::get();
+
+		ShaderVariantKey key = 0;
+
+		if(renderer.lights().dirLight.has_value()) key |= KEYWORD_DIR_LIGHT;
+		if(renderer.lights().skybox != nullptr) key |= KEYWORD_SKYBOX;
+		if(renderer.shadowsEnabled()) key |= KEYWORD_SHADOWS;
+		if(renderer.softShadows()) key |= KEYWORD_SOFT_SHADOWS;
+		if(renderer.shadowCascadeFading()) key |= KEYWORD_CASCADE_FADING;
+
+		return key;
+	}
+
+	ShaderVariantKey VulkanPBRForwardRenderPass::materialVariantKey(const Material* material) {
+
+		ShaderVariantKey key = 0;
+
+		if(material->useNormalMap()) key |= KEYWORD_NORMAL_MAP;
+		if(material->useCombinedMetallicRoughness()) key |= KEYWORD_COMBINED_METALLIC_ROUGHNESS;
+
+		return key;
+	}
+
 	void VulkanPBRForwardRenderPass::bindMesh(VkCommandBuffer commandBuffer, const Mesh* mesh) const {
 		VulkanMeshBuffers* meshBuffers = dynamic_cast<VulkanMeshBuffers*>(mesh->buffers());
 
@@ -215,22 +266,15 @@ namespace milo {
 		VkDescriptorSet descriptorSets[] = {materialDescriptorSet};
 
 		VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-										 m_GraphicsPipeline->pipelineLayout(),
+										 m_ShaderVariants->pipelineLayout(),
 										 2, 1, descriptorSets, 1, &dynamicOffset));
 	}
 
 	inline void VulkanPBRForwardRenderPass::updateSceneUniformData(uint32_t imageIndex) {
 
-		// ==== CAMERA
-		const auto& camera = WorldRenderer::get().camera();
-		{
-			CameraData cameraData;
-			cameraData.viewProjection = camera.projView;
-			cameraData.view = camera.view;
-			cameraData.position = Vector4(camera.position, 1.0f);
+		// Camera and point lights have already been written by the resource pool
 
-			m_CameraUniformBuffer->update(imageIndex, cameraData);
-		}
+		auto& uniformRing = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources()).uniformRing();
 
 		// ======== ENVIRONMENT
 
@@ -251,16 +295,7 @@ namespace milo {
 				env.skyboxPresent[0] = true;
 			}
 
-			m_EnvironmentUniformBuffer->update(imageIndex, env);
-		}
-
-		{
-			PointLightsData pointLightsData{};
-			uint32_t pointLightsCount = std::min(lights.pointLights.size(), (size_t)MAX_POINT_LIGHTS);
-			memcpy(pointLightsData.pointLights, lights.pointLights.data(), sizeof(PointLight) * pointLightsCount);
-			pointLightsData.u_PointLightsCount = pointLightsCount;
-
-			m_PointLightsUniformBuffer->update(imageIndex, pointLightsData);
+			m_EnvironmentOffset = uniformRing.push(env);
 		}
 
 		// ==== SKYBOX TEXTURES
@@ -357,15 +392,15 @@ namespace milo {
 				shadows.u_CascadeSplits[i] = cascades[i].splitDepth;
 			}
 
-			m_ShadowsUniformBuffer->update(imageIndex, shadows);
+			auto& uniformRing = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources()).uniformRing();
+			m_ShadowsOffset = uniformRing.push(shadows);
 		}
 
 		auto& resources = WorldRenderer::get().resources();
 
+		// Transitioned to DEPTH_STENCIL_READ_ONLY_OPTIMAL by the frame graph before this pass
 		VulkanTexture2DArray* shadowMap = (VulkanTexture2DArray*)resources.getTexture2D(ShadowMapRenderPass::getDepthMap(0)).get();
 
-		shadowMap->setLayout(VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL);
-
 		VkDescriptorImageInfo imageInfos[4];
 		VkWriteDescriptorSet writeDescriptors[4];
 
@@ -386,6 +421,8 @@ namespace milo {
 
 	void VulkanPBRForwardRenderPass::bindDescriptorSets(uint32_t imageIndex, VkCommandBuffer commandBuffer) {
 
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
+
 		VkDescriptorSet sceneDescriptorSet = m_SceneDescriptorPool->get(imageIndex);
 		VkDescriptorSet shadowsDescriptorSet = m_ShadowsDescriptorPool->get(imageIndex);
 
@@ -399,18 +436,54 @@ namespace milo {
 						.getBuffer(LightCullingPass::getVisibleLightsBufferHandle()).get();
 
 		uint32_t dynamicOffsets[] = {
-				imageIndex * m_CameraUniformBuffer->elementSize(),
-				imageIndex * m_EnvironmentUniformBuffer->elementSize(),
-				imageIndex * m_PointLightsUniformBuffer->elementSize(),
+				resources.frameUniforms().camera,
+				m_EnvironmentOffset,
+				resources.frameUniforms().pointLights,
 				imageIndex * visibleLightsBuffer->elementSize(),
-				imageIndex * m_ShadowsUniformBuffer->elementSize()
+				m_ShadowsOffset
 		};
 
 		VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-										 m_GraphicsPipeline->pipelineLayout(),
+										 m_ShaderVariants->pipelineLayout(),
 										 0, 2, descriptorSets, 5, dynamicOffsets));
 	}
 
+	void VulkanPBRForwardRenderPass::updateBufferDescriptors(uint32_t imageIndex) {
+
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
+		const VulkanUniformRing& uniformRing = resources.uniformRing();
+
+		if(m_UniformRingGenerations[imageIndex] == uniformRing.generation()) return;
+
+		VkDescriptorBufferInfo cameraInfo = uniformRing.descriptorInfo<CameraUniformData>();
+		VkDescriptorBufferInfo environmentInfo = uniformRing.descriptorInfo<EnvironmentData>();
+		VkDescriptorBufferInfo pointLightsInfo = uniformRing.descriptorInfo<PointLightsUniformData>();
+		VkDescriptorBufferInfo shadowsInfo = uniformRing.descriptorInfo<ShadowDetails>();
+
+		const VulkanStorageBuffer<VisibleLightsBuffer>* visibleLightsBuffer =
+				(const VulkanStorageBuffer<VisibleLightsBuffer>*)resources.getBuffer(LightCullingPass::getVisibleLightsBufferHandle()).get();
+
+		VkDescriptorBufferInfo visibleLightsInfo{};
+		visibleLightsInfo.offset = 0;
+		visibleLightsInfo.range = sizeof(VisibleLightsBuffer);
+		visibleLightsInfo.buffer = visibleLightsBuffer->vkBuffer();
+
+		VkDescriptorSet sceneDescriptorSet = m_SceneDescriptorPool->get(imageIndex);
+		VkDescriptorSet shadowsDescriptorSet = m_ShadowsDescriptorPool->get(imageIndex);
+
+		VkWriteDescriptorSet writeDescriptors[] = {
+				mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, sceneDescriptorSet, 1, &cameraInfo),
+				mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(1, sceneDescriptorSet, 1, &environmentInfo),
+				mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(2, sceneDescriptorSet, 1, &pointLightsInfo),
+				mvk::WriteDescriptorSet::createDynamicStorageBufferWrite(3, sceneDescriptorSet, 1, &visibleLightsInfo),
+				mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, shadowsDescriptorSet, 1, &shadowsInfo)
+		};
+
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 5, writeDescriptors, 0, nullptr));
+
+		m_UniformRingGenerations[imageIndex] = uniformRing.generation();
+	}
+
 	void VulkanPBRForwardRenderPass::createRenderPass() {
 
 		RenderPass::Description desc;
@@ -420,18 +493,6 @@ namespace milo {
 		m_RenderPass = mvk::RenderPass::create(desc);
 	}
 
-	void VulkanPBRForwardRenderPass::createSceneUniformBuffers() {
-
-		m_CameraUniformBuffer = VulkanUniformBuffer<CameraData>::create();
-		m_CameraUniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
-
-		m_EnvironmentUniformBuffer = VulkanUniformBuffer<EnvironmentData>::create();
-		m_EnvironmentUniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
-
-		m_PointLightsUniformBuffer = VulkanUniformBuffer<PointLightsData>::create();
-		m_PointLightsUniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
-	}
-
 	void VulkanPBRForwardRenderPass::createSceneDescriptorSetLayoutAndPool() {
 
 		mvk::DescriptorSet::CreateInfo createInfo{};
@@ -453,46 +514,8 @@ namespace milo {
 		m_SceneDescriptorSetLayout = mvk::DescriptorSet::Layout::create(createInfo);
 		m_SceneDescriptorPool = mvk::DescriptorSet::Pool::create(m_SceneDescriptorSetLayout, createInfo);
 
-		m_SceneDescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT, [&](uint32_t index, VkDescriptorSet descriptorSet) {
-
-			VkDescriptorBufferInfo cameraInfo{};
-			cameraInfo.offset = 0;
-			cameraInfo.range = sizeof(CameraData);
-			cameraInfo.buffer = m_CameraUniformBuffer->vkBuffer();
-
-			VkDescriptorBufferInfo environmentInfo{};
-			environmentInfo.offset = 0;
-			environmentInfo.range = sizeof(EnvironmentData);
-			environmentInfo.buffer = m_EnvironmentUniformBuffer->vkBuffer();
-
-			VkDescriptorBufferInfo pointLightsInfo{};
-			pointLightsInfo.offset = 0;
-			pointLightsInfo.range = sizeof(PointLightsData);
-			pointLightsInfo.buffer = m_PointLightsUniformBuffer->vkBuffer();
-
-			const VulkanStorageBuffer<VisibleLightsBuffer>* visibleLightsBuffer =
-					(const VulkanStorageBuffer<VisibleLightsBuffer>*)WorldRenderer::get().resources()
-							.getBuffer(LightCullingPass::getVisibleLightsBufferHandle()).get();
-
-			VkDescriptorBufferInfo visibleLightsInfo{};
-			visibleLightsInfo.offset = 0;
-			visibleLightsInfo.range = sizeof(VisibleLightsBuffer);
-			visibleLightsInfo.buffer = visibleLightsBuffer->vkBuffer();
-
-			VkWriteDescriptorSet writeDescriptors[] = {
-					mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &cameraInfo),
-					mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(1, descriptorSet, 1, &environmentInfo),
-					mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(2, descriptorSet, 1, &pointLightsInfo),
-					mvk::WriteDescriptorSet::createDynamicStorageBufferWrite(3, descriptorSet, 1, &visibleLightsInfo)
-			};
-
-			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 4, writeDescriptors, 0, nullptr));
-		});
-	}
-
-	void VulkanPBRForwardRenderPass::createShadowsUniformBuffer() {
-		m_ShadowsUniformBuffer = VulkanUniformBuffer<ShadowDetails>::create();
-		m_ShadowsUniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
+		// Buffer descriptors are written on first use, see updateBufferDescriptors
+		m_SceneDescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
 	}
 
 	void VulkanPBRForwardRenderPass::createShadowsDescriptorSetLayoutAndPool() {
@@ -524,19 +547,7 @@ namespace milo {
 
 		m_ShadowsDescriptorPool = new VulkanDescriptorPool(m_Device, poolInfo);
 
-		m_ShadowsDescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT, [&](uint32_t index, VkDescriptorSet descriptorSet) {
-
-			VkDescriptorBufferInfo shadowsInfo{};
-			shadowsInfo.offset = 0;
-			shadowsInfo.range = sizeof(ShadowDetails);
-			shadowsInfo.buffer = m_ShadowsUniformBuffer->vkBuffer();
-
-			VkWriteDescriptorSet writeDescriptors[] = {
-					mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &shadowsInfo)
-			};
-
-			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, writeDescriptors, 0, nullptr));
-		});
+		m_ShadowsDescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
 	}
 
 	void VulkanPBRForwardRenderPass::createGraphicsPipeline() {
@@ -557,17 +568,32 @@ namespace milo {
 
 		pipelineInfo.setLayouts.push_back(m_SceneDescriptorSetLayout);
 		pipelineInfo.setLayouts.push_back(m_ShadowsDescriptorSetLayout);
-		pipelineInfo.setLayouts.push_back(materialResourcePool.materialDescriptorSetLayout());
 
 		pipelineInfo.depthStencil.depthTestEnable = VK_TRUE;
 
 		pipelineInfo.shaders.push_back({"resources/shaders/pbr/pbr.vert", VK_SHADER_STAGE_VERTEX_BIT});
-		pipelineInfo.shaders.push_back({"resources/shaders/pbr/pbr.frag", VK_SHADER_STAGE_FRAGMENT_BIT});
+
+		// Set 2 holds either the material of the draw or every material, see pbr.frag
+		if(materialResourcePool.bindlessSupported()) {
+			// Material index, right after the model matrix
+			VkPushConstantRange materialIndex{};
+			materialIndex.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+			materialIndex.offset = sizeof(PushConstants);
+			materialIndex.size = sizeof(uint32_t);
+			pipelineInfo.pushConstantRanges.push_back(materialIndex);
+			pipelineInfo.setLayouts.push_back(materialResourcePool.bindlessDescriptorSetLayout());
+			pipelineInfo.shaders.push_back({"resources/shaders/pbr/pbr.frag#BINDLESS_MATERIALS", VK_SHADER_STAGE_FRAGMENT_BIT});
+		} else {
+			pipelineInfo.setLayouts.push_back(materialResourcePool.materialDescriptorSetLayout());
+			pipelineInfo.shaders.push_back({"resources/shaders/pbr/pbr.frag", VK_SHADER_STAGE_FRAGMENT_BIT});
+		}
 
 		pipelineInfo.dynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);
 		pipelineInfo.dynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);
 
-		m_GraphicsPipeline = new VulkanGraphicsPipeline("VulkanPBRForwardRenderPass", m_Device, pipelineInfo);
+		m_ShaderVariants = new VulkanShaderVariants("VulkanPBRForwardRenderPass", m_Device, pipelineInfo, {
+				"DIR_LIGHT", "SKYBOX", "SHADOWS", "SOFT_SHADOWS", "CASCADE_FADING", "NORMAL_MAP", "COMBINED_METALLIC_ROUGHNESS"
+		});
 	}
 
 	void VulkanPBRForwardRenderPass::createSemaphores() {
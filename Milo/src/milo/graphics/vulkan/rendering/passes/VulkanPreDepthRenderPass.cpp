@@ -10,17 +10,23 @@ namespace milo {
 	VulkanPreDepthRenderPass::VulkanPreDepthRenderPass() {
 		m_Device = VulkanContext::get()->device();
 		createRenderPass();
-		createUniformBuffer();
 		createDescriptorSetLayout();
 		createDescriptorPool();
 		createDescriptorSets();
 		createSemaphores();
+		m_Device->graphicsCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, m_PickCommandBuffers.size(), m_PickCommandBuffers.data());
 	}
 
 	VulkanPreDepthRenderPass::~VulkanPreDepthRenderPass() {
+		destroyVkFramebuffers();
 		m_Device->graphicsCommandPool()->free(m_CommandBuffers.size(), m_CommandBuffers.data());
+		m_Device->graphicsCommandPool()->free(m_PickCommandBuffers.size(), m_PickCommandBuffers.data());
+		for(VulkanBuffer*& buffer : m_PickBuffers) {
+			if(buffer == nullptr) continue;
+			buffer->unmap();
+			DELETE_PTR(buffer);
+		}
 		DELETE_PTR(m_GraphicsPipeline);
-		DELETE_PTR(m_UniformBuffer);
 		DELETE_PTR(m_DescriptorPool);
 		VK_CALLV(vkDestroyDescriptorSetLayout(m_Device->logical(), m_DescriptorSetLayout, nullptr));
 		VK_CALLV(vkDestroyRenderPass(m_Device->logical(), m_RenderPass, nullptr));
@@ -30,13 +36,26 @@ namespace milo {
 	}
 
 	bool VulkanPreDepthRenderPass::shouldCompile(Scene* scene) const {
-		return WorldRenderer::get().getFramebuffer().size() != m_LastFramebufferSize;
+		if(WorldRenderer::get().getFramebuffer().size() != m_LastFramebufferSize) return true;
+		if(WorldRenderer::get().renderEntityIds() != m_EntityIds) return true;
+		// The depth buffer is recreated every time the frame graph is rebuilt
+		Ref<Texture2D> depthBuffer = WorldRenderer::get().resources().getTexture2D(FrameGraphBuilder::resourceId(DEPTH_BUFFER));
+		return depthBuffer != nullptr && dynamic_cast<VulkanTexture2D*>(depthBuffer.get())->vkImageView() != m_DepthBufferView;
 	}
 
 	void VulkanPreDepthRenderPass::compile(Scene* scene, FrameGraphResourcePool* resourcePool) {
 
 		m_LastFramebufferSize = WorldRenderer::get().getFramebuffer().size();
 
+		// Toggling it changes the declared resources, so the frame graph was rebuilt and the device is idle
+		const bool entityIds = WorldRenderer::get().renderEntityIds();
+		if(entityIds != m_EntityIds) {
+			m_EntityIds = entityIds;
+			destroyVkFramebuffers();
+			VK_CALLV(vkDestroyRenderPass(m_Device->logical(), m_RenderPass, nullptr));
+			createRenderPass();
+		}
+
 		createFramebuffers(m_LastFramebufferSize, resourcePool);
 
 		if(m_GraphicsPipeline != nullptr) {
@@ -52,11 +71,21 @@ namespace milo {
 
 	void VulkanPreDepthRenderPass::execute(Scene* scene) {
 
-		uint32_t imageIndex = VulkanContext::get()->vulkanPresenter()->currentImageIndex();
-		VkCommandBuffer commandBuffer = m_CommandBuffers[imageIndex];
+		VulkanPresenter* presenter = VulkanContext::get()->vulkanPresenter();
+		uint32_t imageIndex = presenter->currentImageIndex();
+		uint32_t frame = presenter->currentFrame();
 		VulkanQueue* queue = m_Device->graphicsQueue();
 
-		buildCommandBuffers(imageIndex, commandBuffer, scene);
+		resolvePick(frame);
+
+		VkCommandBuffer commandBuffers[2] = {m_CommandBuffers[imageIndex], VK_NULL_HANDLE};
+		uint32_t commandBufferCount = 1;
+
+		buildCommandBuffers(imageIndex, commandBuffers[0], scene);
+
+		if(m_EntityIds && recordPick(imageIndex, frame)) {
+			commandBuffers[commandBufferCount++] = m_PickCommandBuffers[frame];
+		}
 
 		VkPipelineStageFlags waitDstStageFlags = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
 
@@ -67,26 +96,110 @@ namespace milo {
 		submitInfo.pWaitDstStageMask = &waitDstStageFlags;
 		submitInfo.pSignalSemaphores = &m_SignalSemaphores[imageIndex];
 		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pCommandBuffers = &commandBuffer;
-		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = commandBuffers;
+		submitInfo.commandBufferCount = commandBufferCount;
 
 		queue->submit(submitInfo, VK_NULL_HANDLE);
 	}
 
+	void VulkanPreDepthRenderPass::resolvePick(uint32_t frame) {
+
+		if(!m_PickRegions[frame].has_value()) return;
+
+		// The presenter waited for the fence of this frame before beginning it, so the copy recorded the last time is done
+		WorldRenderer::get().entityPicker().resolve(m_PickRegions[frame].value(), m_PickedIds[frame]);
+
+		m_PickRegions[frame].reset();
+	}
+
+	bool VulkanPreDepthRenderPass::recordPick(uint32_t imageIndex, uint32_t frame) {
+
+		EntityPicker& picker = WorldRenderer::get().entityPicker();
+
+		EntityPickRegion region;
+		if(!picker.takeRequest(region)) return false;
+
+		const Size& size = m_LastFramebufferSize;
+		if(region.x >= size.width || region.y >= size.height) {
+			// Nothing is drawn out there
+			picker.resolve({region.x, region.y, 0, 0}, nullptr);
+			return false;
+		}
+		region.width = std::min(region.width, size.width - region.x);
+		region.height = std::min(region.height, size.height - region.y);
+
+		if(m_PickBuffers[frame] == nullptr) {
+			const uint32_t maxTexels = EntityPicker::MAX_REGION_SIZE * EntityPicker::MAX_REGION_SIZE;
+			m_PickBuffers[frame] = VulkanBuffer::createStagingBuffer(maxTexels * sizeof(uint32_t));
+			m_PickBuffers[frame]->setName("EntityPickBuffer[" + str(frame) + "]");
+			m_PickedIds[frame] = (const uint32_t*)m_PickBuffers[frame]->map();
+		}
+
+		auto* entityIdMap = dynamic_cast<VulkanTexture2D*>(m_Framebuffers[imageIndex]->colorAttachments()[2]);
+		VkCommandBuffer commandBuffer = m_PickCommandBuffers[frame];
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
+		{
+			// The render pass leaves it as a color attachment, which is also what the frame graph expects after this pass
+			entityIdMap->setCurrentLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+										  VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+			entityIdMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+								   VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			VkBufferImageCopy copy{};
+			copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copy.imageSubresource.layerCount = 1;
+			copy.imageOffset = {(int32_t)region.x, (int32_t)region.y, 0};
+			copy.imageExtent = {region.width, region.height, 1};
+
+			VK_CALLV(vkCmdCopyImageToBuffer(commandBuffer, entityIdMap->vkImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+											m_PickBuffers[frame]->vkBuffer(), 1, &copy));
+
+			entityIdMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+								   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+			VkBufferMemoryBarrier hostBarrier{};
+			hostBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+			hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			hostBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			hostBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			hostBarrier.buffer = m_PickBuffers[frame]->vkBuffer();
+			hostBarrier.size = VK_WHOLE_SIZE;
+
+			VK_CALLV(vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT,
+										  0, 0, nullptr, 1, &hostBarrier, 0, nullptr));
+		}
+		VK_CALL(vkEndCommandBuffer(commandBuffer));
+
+		m_PickRegions[frame] = region;
+
+		return true;
+	}
+
 	void VulkanPreDepthRenderPass::buildCommandBuffers(uint32_t imageIndex, VkCommandBuffer commandBuffer, Scene* scene) {
 
 		mvk::CommandBuffer::BeginGraphicsRenderPassInfo beginInfo{};
 		beginInfo.renderPass = m_RenderPass;
 		beginInfo.graphicsPipeline = m_GraphicsPipeline->vkPipeline();
-		beginInfo.framebuffer = m_Framebuffers[imageIndex].get();
-
-		VkClearValue clearValues[3];
-		clearValues[0].color = {1, 1, 1, 1};
-		clearValues[1].color = {1, 1, 1, 1};
-		clearValues[2].depthStencil = {1, 0};
+		beginInfo.vkFramebuffer = m_VkFramebuffers[imageIndex];
+
+		VkClearValue clearValues[4];
+		uint32_t clearValuesCount = 0;
+		clearValues[clearValuesCount++].color = {1, 1, 1, 1};
+		clearValues[clearValuesCount++].color = {1, 1, 1, 1};
+		if(m_EntityIds) {
+			clearValues[clearValuesCount++].color.uint32[0] = (uint32_t)NULL_ENTITY;
+		}
+		clearValues[clearValuesCount++].depthStencil = {1, 0};
 
 		beginInfo.clearValues = clearValues;
-		beginInfo.clearValuesCount = 3;
+		beginInfo.clearValuesCount = clearValuesCount;
 
 		mvk::CommandBuffer::beginGraphicsRenderPass(commandBuffer, beginInfo);
 		renderMeshViews(imageIndex, commandBuffer, scene);
@@ -95,14 +208,12 @@ namespace milo {
 
 	void VulkanPreDepthRenderPass::renderMeshViews(uint32_t imageIndex, VkCommandBuffer commandBuffer, Scene* scene) {
 
-		{
-			const auto& camera = WorldRenderer::get().camera();
-			UniformBuffer ubo{camera.proj, camera.view, camera.projView};
-			m_UniformBuffer->update(imageIndex, ubo);
-		}
+		updateDescriptorSet(imageIndex);
+
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
 
 		VkDescriptorSet descriptorSet = m_DescriptorPool->get(imageIndex);
-		uint32_t dynamicOffset[1] = {m_UniformBuffer->elementSize() * imageIndex};
+		uint32_t dynamicOffset[1] = {resources.frameUniforms().camera};
 		VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->pipelineLayout(),
 										 0, 1, &descriptorSet, 1, dynamicOffset));
 
@@ -125,9 +236,13 @@ namespace milo {
 				lastMesh = command.mesh;
 			}
 
+			PushConstants pushConstants;
+			pushConstants.modelMatrix = command.transform;
+			pushConstants.entityId = (uint32_t)command.entity;
+
 			VK_CALLV(vkCmdPushConstants(commandBuffer, m_GraphicsPipeline->pipelineLayout(),
-										VK_SHADER_STAGE_VERTEX_BIT,
-										0, sizeof(Matrix4), &command.transform));
+										VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+										0, sizeof(PushConstants), &pushConstants));
 
 			if(command.mesh->indices().empty()) {
 				VK_CALLV(vkCmdDraw(commandBuffer, command.mesh->vertices().size(), 1, 0, 0));
@@ -142,6 +257,9 @@ namespace milo {
 		RenderPass::Description desc;
 		desc.colorAttachments.push_back({PixelFormat::R32F, 1, RenderPass::LoadOp::Clear});
 		desc.colorAttachments.push_back({PixelFormat::RGBA32F, 1, RenderPass::LoadOp::Clear});
+		if(m_EntityIds) {
+			desc.colorAttachments.push_back({PixelFormat::R32UI, 1, RenderPass::LoadOp::Clear});
+		}
 		desc.depthAttachment = {PixelFormat::DEPTH32, 1, RenderPass::LoadOp::Clear};
 
 		m_RenderPass = mvk::RenderPass::create(desc);
@@ -179,24 +297,25 @@ namespace milo {
 		m_DescriptorPool = new VulkanDescriptorPool(m_Device, createInfo);
 	}
 
-	void VulkanPreDepthRenderPass::createUniformBuffer() {
-		m_UniformBuffer = VulkanUniformBuffer<UniformBuffer>::create();
-		m_UniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
+	void VulkanPreDepthRenderPass::createDescriptorSets() {
+		// Written on first use, see updateDescriptorSet
+		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
 	}
 
-	void VulkanPreDepthRenderPass::createDescriptorSets() {
+	void VulkanPreDepthRenderPass::updateDescriptorSet(uint32_t imageIndex) {
 
-		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT, [&](uint32_t index, VkDescriptorSet descriptorSet) {
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
+		const VulkanUniformRing& uniformRing = resources.uniformRing();
 
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = m_UniformBuffer->vkBuffer();
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(UniformBuffer);
+		if(m_UniformRingGenerations[imageIndex] == uniformRing.generation()) return;
 
-			VkWriteDescriptorSet writeDescriptor = mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &bufferInfo);
+		VkDescriptorBufferInfo bufferInfo = uniformRing.descriptorInfo<CameraUniformData>();
 
-			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptor, 0, nullptr));
-		});
+		VkWriteDescriptorSet writeDescriptor = mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, m_DescriptorPool->get(imageIndex), 1, &bufferInfo);
+
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptor, 0, nullptr));
+
+		m_UniformRingGenerations[imageIndex] = uniformRing.generation();
 	}
 
 	void VulkanPreDepthRenderPass::createGraphicsPipeline() {
@@ -210,6 +329,15 @@ namespace milo {
 		pipelineInfo.rasterizationState.depthClampEnable = true;
 
 		pipelineInfo.colorBlendAttachments.push_back(pipelineInfo.colorBlendAttachments[0]);
+		if(m_EntityIds) {
+			pipelineInfo.colorBlendAttachments.push_back(pipelineInfo.colorBlendAttachments[0]);
+		}
+
+		// ENTITY_IDS keyword of pre_depth.frag
+		const VkBool32 entityIds = m_EntityIds;
+		pipelineInfo.specializationEntries.push_back({0, 0, sizeof(VkBool32)});
+		pipelineInfo.specializationData.resize(sizeof(VkBool32));
+		memcpy(pipelineInfo.specializationData.data(), &entityIds, sizeof(VkBool32));
 
 		pipelineInfo.shaders.push_back({"resources/shaders/pre_depth/pre_depth.vert", VK_SHADER_STAGE_VERTEX_BIT});
 		pipelineInfo.shaders.push_back({"resources/shaders/pre_depth/pre_depth.frag", VK_SHADER_STAGE_FRAGMENT_BIT});
@@ -219,8 +347,8 @@ namespace milo {
 
 		VkPushConstantRange pushConstant;
 		pushConstant.offset = 0;
-		pushConstant.size = sizeof(Matrix4);
-		pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+		pushConstant.size = sizeof(PushConstants);
+		pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
 
 		pipelineInfo.pushConstantRanges.push_back(pushConstant);
 
@@ -233,22 +361,70 @@ namespace milo {
 
 	void VulkanPreDepthRenderPass::createFramebuffers(const Size& size, FrameGraphResourcePool* resourcePool) {
 
+		auto* resources = dynamic_cast<VulkanFrameGraphResourcePool*>(resourcePool);
+
+		auto* depthBuffer = dynamic_cast<VulkanTexture2D*>(resourcePool->getTexture2D(FrameGraphBuilder::resourceId(DEPTH_BUFFER)).get());
+		m_DepthBufferView = depthBuffer->vkImageView();
+
 		VulkanFramebuffer::ApiInfo apiInfo = {m_Device};
 
 		Framebuffer::CreateInfo createInfo{};
 		createInfo.size = size;
 		createInfo.colorAttachments.push_back(PixelFormat::R32F);
 		createInfo.colorAttachments.push_back(PixelFormat::RGBA32F);
-		createInfo.depthAttachments.push_back(PixelFormat::DEPTH32);
+		if(m_EntityIds) {
+			createInfo.colorAttachments.push_back(PixelFormat::R32UI);
+		}
 		createInfo.apiInfo = &apiInfo;
 
+		destroyVkFramebuffers();
+
 		for(uint32_t i = 0;i < m_Framebuffers.size();++i) {
+
 			Handle handle = PreDepthRenderPass::createFramebufferHandle(i);
 			if(m_Framebuffers[i] != nullptr) {
 				resourcePool->removeFramebuffer(handle);
 			}
 			m_Framebuffers[i] = std::make_shared<VulkanFramebuffer>(createInfo);
 			resourcePool->putFramebuffer(handle, m_Framebuffers[i]);
+
+			auto* depthMap = dynamic_cast<VulkanTexture2D*>(m_Framebuffers[i]->colorAttachments()[0]);
+			auto* debugDepthMap = dynamic_cast<VulkanTexture2D*>(m_Framebuffers[i]->colorAttachments()[1]);
+
+			resources->bindTexture(FrameGraphBuilder::resourceId(DEPTH_MAP), depthMap, i);
+			resources->bindTexture(FrameGraphBuilder::resourceId(DEBUG_DEPTH_MAP), debugDepthMap, i);
+
+			VkImageView attachments[4];
+			uint32_t attachmentCount = 0;
+			attachments[attachmentCount++] = depthMap->vkImageView();
+			attachments[attachmentCount++] = debugDepthMap->vkImageView();
+
+			if(m_EntityIds) {
+				auto* entityIdMap = dynamic_cast<VulkanTexture2D*>(m_Framebuffers[i]->colorAttachments()[2]);
+				resources->bindTexture(FrameGraphBuilder::resourceId(ENTITY_ID_MAP), entityIdMap, i);
+				attachments[attachmentCount++] = entityIdMap->vkImageView();
+			}
+
+			attachments[attachmentCount++] = m_DepthBufferView;
+
+			VkFramebufferCreateInfo framebufferInfo{};
+			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+			framebufferInfo.renderPass = m_RenderPass;
+			framebufferInfo.pAttachments = attachments;
+			framebufferInfo.attachmentCount = attachmentCount;
+			framebufferInfo.width = size.width;
+			framebufferInfo.height = size.height;
+			framebufferInfo.layers = 1;
+
+			VK_CALL(vkCreateFramebuffer(m_Device->logical(), &framebufferInfo, nullptr, &m_VkFramebuffers[i]));
+		}
+	}
+
+	void VulkanPreDepthRenderPass::destroyVkFramebuffers() {
+		for(VkFramebuffer& framebuffer : m_VkFramebuffers) {
+			if(framebuffer == VK_NULL_HANDLE) continue;
+			VK_CALLV(vkDestroyFramebuffer(m_Device->logical(), framebuffer, nullptr));
+			framebuffer = VK_NULL_HANDLE;
 		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "milo/graphics/vulkan/rendering/passes/VulkanSelectionOutlineRenderPass.h"
+#include "milo/graphics/vulkan/buffers/VulkanMeshBuffers.h"
+#include "milo/graphics/vulkan/textures/VulkanTexture2D.h"
+#include "milo/graphics/rendering/passes/PreDepthRenderPass.h"
+#include "milo/graphics/rendering/WorldRenderer.h"
+#include "milo/assets/AssetManager.h"
+
+namespace milo {
+
+	static const Color OUTLINE_COLOR = {1.0f, 0.55f, 0.0f, 1.0f};
+	static const int32_t OUTLINE_THICKNESS = 2;
+
+	VulkanSelectionOutlineRenderPass::VulkanSelectionOutlineRenderPass() {
+		m_Device = VulkanContext::get()->device();
+		createRenderPass();
+		createDescriptorSetLayout();
+		createDescriptorPool();
+		createGraphicsPipeline();
+		mvk::Semaphore::create(m_SignalSemaphores.size(), m_SignalSemaphores.data());
+		m_Device->graphicsCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, m_CommandBuffers.size(), m_CommandBuffers.data());
+	}
+
+	VulkanSelectionOutlineRenderPass::~VulkanSelectionOutlineRenderPass() {
+		m_Device->graphicsCommandPool()->free(m_CommandBuffers.size(), m_CommandBuffers.data());
+		DELETE_PTR(m_GraphicsPipeline);
+		DELETE_PTR(m_DescriptorPool);
+		VK_CALLV(vkDestroyDescriptorSetLayout(m_Device->logical(), m_DescriptorSetLayout, nullptr));
+		VK_CALLV(vkDestroyRenderPass(m_Device->logical(), m_RenderPass, nullptr));
+		mvk::Semaphore::destroy(m_SignalSemaphores.size(), m_SignalSemaphores.data());
+	}
+
+	bool VulkanSelectionOutlineRenderPass::shouldCompile(Scene* scene) const {
+		return false;
+	}
+
+	void VulkanSelectionOutlineRenderPass::compile(Scene* scene, FrameGraphResourcePool* resourcePool) {
+	}
+
+	void VulkanSelectionOutlineRenderPass::execute(Scene* scene) {
+
+		const uint32_t imageIndex = VulkanContext::get()->vulkanPresenter()->currentImageIndex();
+		VkCommandBuffer commandBuffer = m_CommandBuffers[imageIndex];
+		VulkanQueue* queue = m_Device->graphicsQueue();
+
+		updateDescriptorSet(imageIndex);
+
+		buildCommandBuffer(imageIndex, commandBuffer);
+
+		VkPipelineStageFlags waitStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pWaitSemaphores = queue->waitSemaphores().data();
+		submitInfo.waitSemaphoreCount = queue->waitSemaphores().size();
+		submitInfo.pSignalSemaphores = &m_SignalSemaphores[imageIndex];
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pWaitDstStageMask = &waitStageMask;
+
+		VkFence fence = queue->lastFence();
+		queue->submit(submitInfo, VK_NULL_HANDLE);
+		queue->setFence(fence);
+	}
+
+	void VulkanSelectionOutlineRenderPass::updateDescriptorSet(uint32_t imageIndex) {
+
+		auto framebuffer = WorldRenderer::get().resources().getFramebuffer(PreDepthRenderPass::getFramebufferHandle(imageIndex));
+		// Transitioned to SHADER_READ_ONLY_OPTIMAL by the frame graph before this pass
+		auto* entityIdMap = (VulkanTexture2D*)framebuffer->colorAttachments()[2];
+
+		VkDescriptorImageInfo imageInfo{};
+		imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfo.imageView = entityIdMap->vkImageView();
+		// Only read with texelFetch, so its filtering does not matter
+		imageInfo.sampler = entityIdMap->vkSampler();
+
+		VkWriteDescriptorSet writeDescriptorSet = mvk::WriteDescriptorSet::createCombineImageSamplerWrite(
+				0, m_DescriptorPool->get(imageIndex), 1, &imageInfo);
+
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptorSet, 0, nullptr));
+	}
+
+	void VulkanSelectionOutlineRenderPass::buildCommandBuffer(uint32_t imageIndex, VkCommandBuffer commandBuffer) {
+
+		Mesh* mesh = Assets::meshes().getQuad();
+		auto* meshBuffers = dynamic_cast<VulkanMeshBuffers*>(mesh->buffers());
+
+		mvk::CommandBuffer::BeginGraphicsRenderPassInfo beginInfo{};
+		beginInfo.renderPass = m_RenderPass;
+		beginInfo.graphicsPipeline = m_GraphicsPipeline->vkPipeline();
+
+		VkClearValue clearValues[2];
+		clearValues[0].color = {0, 0, 0, 0};
+		clearValues[1].depthStencil = {1, 0};
+
+		beginInfo.clearValues = clearValues;
+		beginInfo.clearValuesCount = 2;
+
+		const EntityId selectedEntity = WorldRenderer::get().frameData().selectedEntity;
+
+		mvk::CommandBuffer::beginGraphicsRenderPass(commandBuffer, beginInfo);
+		// Still recorded when nothing is selected, so the default framebuffer ends up in the same layout
+		if(selectedEntity != NULL_ENTITY) {
+			VkDescriptorSet descriptorSet = m_DescriptorPool->get(imageIndex);
+
+			VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
+											 m_GraphicsPipeline->pipelineLayout(), 0, 1, &descriptorSet, 0, nullptr));
+
+			PushConstants pushConstants{};
+			pushConstants.color = OUTLINE_COLOR;
+			pushConstants.entityId = (uint32_t)selectedEntity;
+			pushConstants.thickness = OUTLINE_THICKNESS;
+
+			VK_CALLV(vkCmdPushConstants(commandBuffer, m_GraphicsPipeline->pipelineLayout(),
+										VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(PushConstants), &pushConstants));
+
+			VkBuffer vertexBuffers[] = {meshBuffers->vertexBuffer()->vkBuffer()};
+			VkDeviceSize offsets[] = {0};
+			VK_CALLV(vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets));
+
+			if(mesh->indices().empty()) {
+				VK_CALLV(vkCmdDraw(commandBuffer, mesh->vertices().size(), 1, 0, 0));
+			} else {
+				VK_CALLV(vkCmdBindIndexBuffer(commandBuffer, meshBuffers->indexBuffer()->vkBuffer(), 0, VK_INDEX_TYPE_UINT32));
+				VK_CALLV(vkCmdDrawIndexed(commandBuffer, mesh->indices().size(), 1, 0, 0, 0));
+			}
+		}
+		mvk::CommandBuffer::endGraphicsRenderPass(commandBuffer);
+	}
+
+	void VulkanSelectionOutlineRenderPass::createRenderPass() {
+
+		RenderPass::Description desc;
+		desc.colorAttachments.push_back({PixelFormat::RGBA32F, 1, LoadOp::Load});
+		desc.depthAttachment = {PixelFormat::DEPTH, 1, LoadOp::Load};
+
+		m_RenderPass = mvk::RenderPass::create(desc);
+	}
+
+	void VulkanSelectionOutlineRenderPass::createDescriptorSetLayout() {
+
+		VkDescriptorSetLayoutBinding binding{};
+		// Entity ID map
+		binding.binding = 0;
+		binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		binding.descriptorCount = 1;
+		binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		VkDescriptorSetLayoutCreateInfo createInfo{};
+		createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		createInfo.pBindings = &binding;
+		createInfo.bindingCount = 1;
+
+		VK_CALL(vkCreateDescriptorSetLayout(m_Device->logical(), &createInfo, nullptr, &m_DescriptorSetLayout));
+	}
+
+	void VulkanSelectionOutlineRenderPass::createDescriptorPool() {
+
+		VkDescriptorPoolSize poolSize{};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = MAX_SWAPCHAIN_IMAGE_COUNT;
+
+		VulkanDescriptorPool::CreateInfo createInfo{};
+		createInfo.layout = m_DescriptorSetLayout;
+		createInfo.capacity = MAX_SWAPCHAIN_IMAGE_COUNT;
+		createInfo.poolSizes.push_back(poolSize);
+
+		m_DescriptorPool = new VulkanDescriptorPool(m_Device, createInfo);
+		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
+	}
+
+	void VulkanSelectionOutlineRenderPass::createGraphicsPipeline() {
+
+		VulkanGraphicsPipeline::CreateInfo pipelineInfo{};
+		pipelineInfo.vkRenderPass = m_RenderPass;
+
+		pipelineInfo.setLayouts.push_back(m_DescriptorSetLayout);
+
+		pipelineInfo.depthStencil.depthTestEnable = VK_FALSE;
+
+		pipelineInfo.shaders.push_back({"resources/shaders/fullscreen_quad/fullscreen_quad.vert", VK_SHADER_STAGE_VERTEX_BIT});
+		pipelineInfo.shaders.push_back({"resources/shaders/selection_outline/selection_outline.frag", VK_SHADER_STAGE_FRAGMENT_BIT});
+
+		pipelineInfo.dynamicStates.push_back(VK_DYNAMIC_STATE_VIEWPORT);
+		pipelineInfo.dynamicStates.push_back(VK_DYNAMIC_STATE_SCISSOR);
+
+		VkPushConstantRange pushConstants{};
+		pushConstants.offset = 0;
+		pushConstants.size = sizeof(PushConstants);
+		pushConstants.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		pipelineInfo.pushConstantRanges.push_back(pushConstants);
+
+		m_GraphicsPipeline = new VulkanGraphicsPipeline("VulkanSelectionOutlineRenderPass", m_Device, pipelineInfo);
+	}
+}
\ No newline at end of file
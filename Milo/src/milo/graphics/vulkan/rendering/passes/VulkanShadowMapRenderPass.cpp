@@ -1,5 +1,6 @@
 #include "milo/graphics/vulkan/rendering/passes/VulkanShadowMapRenderPass.h"
 #include "milo/graphics/rendering/WorldRenderer.h"
+#include "milo/graphics/vulkan/rendering/VulkanGPUProfiler.h"
 #include "milo/graphics/vulkan/rendering/VulkanFrameGraphResourcePool.h"
 #include "milo/scenes/SceneManager.h"
 #include "milo/scenes/Entity.h"
@@ -13,19 +14,17 @@ namespace milo {
 		m_Device = VulkanContext::get()->device();
 
 		createRenderPass();
-		createUniformBuffer();
 		createDescriptorSetLayoutAndPool();
 		createDescriptorSets();
 		createSemaphores();
-		createShadowCascades();
 		createGraphicsPipeline();
 		m_Device->graphicsCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, m_PrimaryCommandBuffers.size(), m_PrimaryCommandBuffers.data());
 	}
 
 	VulkanShadowMapRenderPass::~VulkanShadowMapRenderPass() {
+		destroyShadowCascades();
 		m_Device->graphicsCommandPool()->free(m_PrimaryCommandBuffers.size(), m_PrimaryCommandBuffers.data());
 		DELETE_PTR(m_GraphicsPipeline);
-		DELETE_PTR(m_UniformBuffer);
 		DELETE_PTR(m_DescriptorPool);
 		VK_CALLV(vkDestroyDescriptorSetLayout(m_Device->logical(), m_DescriptorSetLayout, nullptr));
 		VK_CALLV(vkDestroyRenderPass(m_Device->logical(), m_RenderPass, nullptr));
@@ -35,10 +34,19 @@ namespace milo {
 	}
 
 	bool VulkanShadowMapRenderPass::shouldCompile(Scene* scene) const {
-		return false;
+		// The frame graph recreates its transients when it is rebuilt
+		Ref<Texture2D> shadowMap = WorldRenderer::get().resources().getTexture2D(getDepthMap(0));
+		return shadowMap != nullptr && dynamic_cast<VulkanTexture2DArray*>(shadowMap.get())->vkImage() != m_ShadowMapImage;
 	}
 
 	void VulkanShadowMapRenderPass::compile(Scene* scene, FrameGraphResourcePool* resourcePool) {
+
+		auto* shadowMap = dynamic_cast<VulkanTexture2DArray*>(resourcePool->getTexture2D(getDepthMap(0)).get());
+
+		destroyShadowCascades();
+		createShadowCascades(shadowMap);
+
+		m_ShadowMapImage = shadowMap->vkImage();
 	}
 
 	void VulkanShadowMapRenderPass::execute(Scene* scene) {
@@ -73,7 +81,7 @@ namespace milo {
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 		renderPassInfo.renderPass = m_RenderPass;
 		renderPassInfo.renderArea.offset = {0, 0};
-		renderPassInfo.renderArea.extent = {4096, 4096};
+		renderPassInfo.renderArea.extent = {SHADOW_MAP_RESOLUTION, SHADOW_MAP_RESOLUTION};
 
 		VkClearValue clearValues[1];
 		clearValues[0].depthStencil = {1, 0};
@@ -83,6 +91,8 @@ namespace milo {
 
 		VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 		{
+			if(VulkanGPUProfiler* profiler = VulkanGPUProfiler::get()) profiler->beginStatistics(commandBuffer);
+
 			bindDescriptorSets(imageIndex, commandBuffer);
 
 			VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->vkPipeline()));
@@ -91,6 +101,8 @@ namespace milo {
 			renderShadowCascade(imageIndex, commandBuffer, 1, renderPassInfo);
 			renderShadowCascade(imageIndex, commandBuffer, 2, renderPassInfo);
 			renderShadowCascade(imageIndex, commandBuffer, 3, renderPassInfo);
+
+			if(VulkanGPUProfiler* profiler = VulkanGPUProfiler::get()) profiler->endStatistics(commandBuffer);
 		}
 		VK_CALLV(vkEndCommandBuffer(commandBuffer));
 	}
@@ -110,20 +122,14 @@ namespace milo {
 
 	inline void VulkanShadowMapRenderPass::bindDescriptorSets(uint32_t index, VkCommandBuffer commandBuffer) {
 
-		{
-			const auto& cascades = WorldRenderer::get().shadowCascades();
-			ShadowData shadows = {
-					cascades[0].viewProj,
-					cascades[1].viewProj,
-					cascades[2].viewProj,
-					cascades[3].viewProj
-			};
-			m_UniformBuffer->update(index, shadows);
-		}
+		// Cascade matrices are one of the shared blocks written by the resource pool
+		updateDescriptorSet(index);
+
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
 
 		VkDescriptorSet descriptorSet = m_DescriptorPool->get(index);
 
-		uint32_t dynamicOffset[1] = {m_UniformBuffer->elementSize() * index};
+		uint32_t dynamicOffset[1] = {resources.frameUniforms().shadowCascades};
 		VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
 										 m_GraphicsPipeline->pipelineLayout(),
 										 0, 1, &descriptorSet, 1, dynamicOffset));
@@ -186,8 +192,9 @@ namespace milo {
 		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 		depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 		depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		// The frame graph transitions the shadow map before and after this pass
 		depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+		depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 		VkAttachmentReference depthReference = {};
 		depthReference.attachment = 0;
@@ -240,24 +247,25 @@ namespace milo {
 		m_DescriptorPool = mvk::DescriptorSet::Pool::create(m_DescriptorSetLayout, createInfo);
 	}
 
-	void VulkanShadowMapRenderPass::createUniformBuffer() {
-		m_UniformBuffer = VulkanUniformBuffer<ShadowData>::create();
-		m_UniformBuffer->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
+	void VulkanShadowMapRenderPass::createDescriptorSets() {
+		// Written on first use, see updateDescriptorSet
+		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT);
 	}
 
-	void VulkanShadowMapRenderPass::createDescriptorSets() {
+	void VulkanShadowMapRenderPass::updateDescriptorSet(uint32_t imageIndex) {
+
+		const auto& resources = dynamic_cast<const VulkanFrameGraphResourcePool&>(WorldRenderer::get().resources());
+		const VulkanUniformRing& uniformRing = resources.uniformRing();
+
+		if(m_UniformRingGenerations[imageIndex] == uniformRing.generation()) return;
 
-		m_DescriptorPool->allocate(MAX_SWAPCHAIN_IMAGE_COUNT, [&](uint32_t index, VkDescriptorSet descriptorSet) {
+		VkDescriptorBufferInfo bufferInfo = uniformRing.descriptorInfo<ShadowCascadesUniformData>();
 
-			VkDescriptorBufferInfo bufferInfo{};
-			bufferInfo.buffer = m_UniformBuffer->vkBuffer();
-			bufferInfo.offset = 0;
-			bufferInfo.range = sizeof(ShadowData);
+		auto writeDescriptor = mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, m_DescriptorPool->get(imageIndex), 1, &bufferInfo);
 
-			auto writeDescriptor = mvk::WriteDescriptorSet::createDynamicUniformBufferWrite(0, descriptorSet, 1, &bufferInfo);
+		VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptor, 0, nullptr));
 
-			VK_CALLV(vkUpdateDescriptorSets(m_Device->logical(), 1, &writeDescriptor, 0, nullptr));
-		});
+		m_UniformRingGenerations[imageIndex] = uniformRing.generation();
 	}
 
 	void VulkanShadowMapRenderPass::createGraphicsPipeline() {
@@ -300,20 +308,7 @@ namespace milo {
 		mvk::Semaphore::create(m_SignalSemaphores.size(), m_SignalSemaphores.data());
 	}
 
-	void VulkanShadowMapRenderPass::createShadowCascades() {
-
-		FrameGraphResourcePool& resourcePool = WorldRenderer::get().resources();
-
-		m_DepthTexture = Ref<VulkanTexture2DArray>(VulkanTexture2DArray::create(
-				TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, MAX_SHADOW_CASCADES));
-
-		VulkanTexture2DArray::AllocInfo allocInfo{};
-		allocInfo.format = PixelFormat::DEPTH32;
-		allocInfo.width = 4096;
-		allocInfo.height = 4096;
-		allocInfo.mipLevels = 1;
-
-		m_DepthTexture->allocate(allocInfo);
+	void VulkanShadowMapRenderPass::createShadowCascades(VulkanTexture2DArray* shadowMap) {
 
 		VkSamplerCreateInfo sampler = mvk::SamplerCreateInfo::create();
 		sampler.magFilter = VK_FILTER_LINEAR;
@@ -328,31 +323,34 @@ namespace milo {
 		sampler.maxLod = 1.0f;
 		sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 
-		m_DepthTexture->vkSampler(VulkanContext::get()->samplerMap()->get(sampler));
-
-		resourcePool.putTexture2D(ShadowMapRenderPass::getDepthMap(0), m_DepthTexture); // TODO
+		shadowMap->vkSampler(VulkanContext::get()->samplerMap()->get(sampler));
 
 		for(uint32_t i = 0;i < m_ShadowCascades.size();++i) {
 
 			VulkanShadowCascade& cascade = m_ShadowCascades[i];
 
-			cascade.imageView = m_DepthTexture->getLayer(i);
+			cascade.imageView = shadowMap->getLayer(i);
 
 			VkFramebufferCreateInfo framebufferInfo{};
 			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
 			framebufferInfo.renderPass = m_RenderPass;
 			framebufferInfo.pAttachments = &cascade.imageView;
 			framebufferInfo.attachmentCount = 1;
-			framebufferInfo.width = 4096;
-			framebufferInfo.height = 4096;
+			framebufferInfo.width = SHADOW_MAP_RESOLUTION;
+			framebufferInfo.height = SHADOW_MAP_RESOLUTION;
 			framebufferInfo.layers = 1;
 
 			VK_CALLV(vkCreateFramebuffer(m_Device->logical(), &framebufferInfo, nullptr, &cascade.framebuffer));
 		}
 	}
 
-	VulkanShadowCascade::~VulkanShadowCascade() {
-		VkDevice device = VulkanContext::get()->device()->logical();
-		VK_CALLV(vkDestroyFramebuffer(device, framebuffer, nullptr));
+	void VulkanShadowMapRenderPass::destroyShadowCascades() {
+		for(VulkanShadowCascade& cascade : m_ShadowCascades) {
+			if(cascade.framebuffer == VK_NULL_HANDLE) continue;
+			VK_CALLV(vkDestroyFramebuffer(m_Device->logical(), cascade.framebuffer, nullptr));
+			cascade.framebuffer = VK_NULL_HANDLE;
+			// Layer views are owned by the shadow map texture
+			cascade.imageView = VK_NULL_HANDLE;
+		}
 	}
 }
\ No newline at end of file
@@ -61,31 +61,18 @@ namespace milo {
 
 	void VulkanSkyboxRenderPass::execute(Scene* scene) {
 
-		SkyboxView* skyboxView = scene->skyboxView();
-		if(skyboxView == nullptr) return;
+		const FrameRenderData& frame = WorldRenderer::get().frameData();
 
-		Skybox* skybox = skyboxView->skybox;
+		Skybox* skybox = frame.background;
+		if(skybox == nullptr) return;
 
 		uint32_t imageIndex = VulkanContext::get()->vulkanPresenter()->currentImageIndex();
 		VkCommandBuffer commandBuffer = m_CommandBuffers[imageIndex];
 		VulkanQueue* queue = m_Device->graphicsQueue();
 
 		UniformBuffer uniformBufferData{};
-
-		if(getSimulationState() == SimulationState::Editor) {
-
-			EditorCamera& camera = MiloEditor::camera();
-			uniformBufferData.projMatrix = camera.projMatrix();
-			uniformBufferData.viewMatrix = camera.viewMatrix();
-
-		} else {
-
-			Entity cameraEntity = scene->cameraEntity();
-			Camera& camera = cameraEntity.getComponent<Camera>();
-			uniformBufferData.projMatrix = camera.projectionMatrix();
-			uniformBufferData.viewMatrix = camera.viewMatrix(cameraEntity.getComponent<Transform>().translation());
-		}
-
+		uniformBufferData.projMatrix = frame.camera.proj;
+		uniformBufferData.viewMatrix = frame.camera.view;
 		uniformBufferData.textureLOD = skybox->prefilterLODBias();
 		uniformBufferData.intensity = 1; // TODO
 
@@ -219,13 +206,12 @@ namespace milo {
 		m_Device->graphicsCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY,
 												  m_CommandBuffers.size(), m_CommandBuffers.data());
 
-		Scene* scene = SceneManager::activeScene();
+		const FrameRenderData& frame = WorldRenderer::get().frameData();
 
-		SkyboxView* skyboxView = scene->skyboxView();
-		if(skyboxView == nullptr) return;
-		Skybox* skybox = skyboxView->skybox;
+		Skybox* skybox = frame.background;
+		if(skybox == nullptr) return;
 
-		const auto& camera = WorldRenderer::get().camera();
+		const auto& camera = frame.camera;
 
 		UniformBuffer uniformBufferData{};
 		uniformBufferData.viewMatrix = camera.view;
@@ -244,7 +230,7 @@ namespace milo {
 			VkCommandBufferBeginInfo beginInfo{};
 			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 
-			const Viewport& sceneViewport = scene->viewport();
+			const Viewport& sceneViewport = frame.viewport;
 
 			VK_CALL(vkBeginCommandBuffer(commandBuffer, &beginInfo));
 			{
@@ -15,7 +15,7 @@ namespace milo {
 
 	VulkanBRDFMapPass::~VulkanBRDFMapPass() {
 
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_ComputePipeline, nullptr));
+		DELETE_PTR(m_ComputePipeline);
 		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
 
 		DELETE_PTR(m_DescriptorPool);
@@ -55,7 +55,7 @@ namespace milo {
 			brdfMap->vkSampler(VulkanContext::get()->samplerMap()->get(sampler));
 		}
 
-		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline));
+		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->vkPipeline()));
 
 		brdfMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
 						   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
@@ -158,29 +158,6 @@ namespace milo {
 	}
 
 	void VulkanBRDFMapPass::createComputePipeline() {
-
-		Shader* shader = Assets::shaders().load(Files::resource("shaders/skybox/brdf.comp"));
-		auto* vulkanShader = dynamic_cast<VulkanShader*>(shader);
-
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = (uint32_t*)vulkanShader->bytecode();
-		shaderModuleCreateInfo.codeSize = vulkanShader->bytecodeLength();
-
-		VkShaderModule shaderModule;
-		VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
-
-		VkPipelineShaderStageCreateInfo shaderStage{};
-		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStage.module = shaderModule;
-		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		shaderStage.pName = "main";
-
-		VkComputePipelineCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		createInfo.layout = m_PipelineLayout;
-		createInfo.stage = shaderStage;
-
-		VK_CALL(vkCreateComputePipelines(m_Device->logical(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_ComputePipeline));
+		m_ComputePipeline = new VulkanComputePipeline("VulkanBRDFMapPass", m_Device, m_PipelineLayout, Files::resource("shaders/skybox/brdf.comp"));
 	}
 }
\ No newline at end of file
@@ -14,7 +14,7 @@ namespace milo {
 
 	VulkanEnvironmentMapPass::~VulkanEnvironmentMapPass() {
 
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_ComputePipeline, nullptr));
+		DELETE_PTR(m_ComputePipeline);
 		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
 
 		DELETE_PTR(m_DescriptorPool);
@@ -29,30 +29,10 @@ namespace milo {
 		uint32_t mapSize = execInfo.loadInfo->environmentMapSize;
 
 		if(environmentMap->vkImageView() == VK_NULL_HANDLE) {
-			Cubemap::AllocInfo allocInfo{};
-			allocInfo.width = mapSize;
-			allocInfo.height = mapSize;
-			allocInfo.format = PixelFormat::RGBA32F;
-			allocInfo.mipLevels = 4;
-
-			environmentMap->allocate(allocInfo);
-			environmentMap->generateMipmaps();
-
-			VkSamplerCreateInfo samplerInfo = mvk::SamplerCreateInfo::create();
-			samplerInfo.magFilter = VK_FILTER_LINEAR;
-			samplerInfo.minFilter = VK_FILTER_LINEAR;
-			samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-
-			VkSampler sampler = VulkanContext::get()->samplerMap()->get(samplerInfo);
-
-			environmentMap->vkSampler(sampler);
+			allocate(environmentMap, *execInfo.loadInfo);
 		}
 
-		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline));
+		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->vkPipeline()));
 
 		environmentMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
 								  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
@@ -69,6 +49,33 @@ namespace milo {
 								  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 	}
 
+	void VulkanEnvironmentMapPass::allocate(VulkanCubemap* environmentMap, const SkyboxLoadInfo& loadInfo) {
+
+		uint32_t mapSize = loadInfo.environmentMapSize;
+
+		Cubemap::AllocInfo allocInfo{};
+		allocInfo.width = mapSize;
+		allocInfo.height = mapSize;
+		allocInfo.format = PixelFormat::RGBA32F;
+		allocInfo.mipLevels = 4;
+
+		environmentMap->allocate(allocInfo);
+		environmentMap->generateMipmaps();
+
+		VkSamplerCreateInfo samplerInfo = mvk::SamplerCreateInfo::create();
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+
+		VkSampler sampler = VulkanContext::get()->samplerMap()->get(samplerInfo);
+
+		environmentMap->vkSampler(sampler);
+	}
+
 	void VulkanEnvironmentMapPass::updateDescriptorSet(const VulkanSkyboxPassExecuteInfo& execInfo) {
 
 		using namespace mvk::WriteDescriptorSet;
@@ -147,29 +154,6 @@ namespace milo {
 	}
 
 	void VulkanEnvironmentMapPass::createComputePipeline() {
-
-		Shader* shader = Assets::shaders().load(Files::resource("shaders/skybox/equirectangular_to_cubemap.comp"));
-		auto* vulkanShader = dynamic_cast<VulkanShader*>(shader);
-
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = (uint32_t*)vulkanShader->bytecode();
-		shaderModuleCreateInfo.codeSize = vulkanShader->bytecodeLength();
-
-		VkShaderModule shaderModule;
-		VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
-
-		VkPipelineShaderStageCreateInfo shaderStage{};
-		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStage.module = shaderModule;
-		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		shaderStage.pName = "main";
-
-		VkComputePipelineCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		createInfo.layout = m_PipelineLayout;
-		createInfo.stage = shaderStage;
-
-		VK_CALL(vkCreateComputePipelines(m_Device->logical(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_ComputePipeline));
+		m_ComputePipeline = new VulkanComputePipeline("VulkanEnvironmentMapPass", m_Device, m_PipelineLayout, Files::resource("shaders/skybox/equirectangular_to_cubemap.comp"));
 	}
 }
\ No newline at end of file
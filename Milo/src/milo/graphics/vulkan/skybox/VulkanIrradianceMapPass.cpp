@@ -15,7 +15,7 @@ namespace milo {
 
 	VulkanIrradianceMapPass::~VulkanIrradianceMapPass() {
 
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_ComputePipeline, nullptr));
+		DELETE_PTR(m_ComputePipeline);
 		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
 
 		DELETE_PTR(m_DescriptorPool);
@@ -30,29 +30,10 @@ namespace milo {
 		uint32_t mapSize = execInfo.loadInfo->irradianceMapSize;
 
 		if(irradianceMap->vkImageView() == VK_NULL_HANDLE) {
-			Cubemap::AllocInfo allocInfo{};
-			allocInfo.width = mapSize;
-			allocInfo.height = mapSize;
-			allocInfo.format = PixelFormat::RGBA32F;
-			allocInfo.mipLevels = 4;
-
-			irradianceMap->allocate(allocInfo);
-
-			VkSamplerCreateInfo samplerInfo = mvk::SamplerCreateInfo::create();
-			samplerInfo.magFilter = VK_FILTER_LINEAR;
-			samplerInfo.minFilter = VK_FILTER_LINEAR;
-			samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-
-			VkSampler sampler = VulkanContext::get()->samplerMap()->get(samplerInfo);
-
-			irradianceMap->vkSampler(sampler);
+			allocate(irradianceMap, *execInfo.loadInfo);
 		}
 
-		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline));
+		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->vkPipeline()));
 
 		irradianceMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
 								 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
@@ -66,13 +47,40 @@ namespace milo {
 		uint32_t samples = 64;
 		VK_CALLV(vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(samples), &samples));
 
-		VK_CALLV(vkCmdDispatch(commandBuffer, mapSize / 32, mapSize / 32, 6));
+		const uint32_t groupCount = (mapSize + 31) / 32;
+		VK_CALLV(vkCmdDispatchBase(commandBuffer, 0, 0, execInfo.firstFace, groupCount, groupCount, execInfo.faceCount));
 
 		irradianceMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 								 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
 	}
 
+	void VulkanIrradianceMapPass::allocate(VulkanCubemap* irradianceMap, const SkyboxLoadInfo& loadInfo) {
+
+		uint32_t mapSize = loadInfo.irradianceMapSize;
+
+		Cubemap::AllocInfo allocInfo{};
+		allocInfo.width = mapSize;
+		allocInfo.height = mapSize;
+		allocInfo.format = PixelFormat::RGBA32F;
+		allocInfo.mipLevels = 4;
+
+		irradianceMap->allocate(allocInfo);
+
+		VkSamplerCreateInfo samplerInfo = mvk::SamplerCreateInfo::create();
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+
+		VkSampler sampler = VulkanContext::get()->samplerMap()->get(samplerInfo);
+
+		irradianceMap->vkSampler(sampler);
+	}
+
 	void VulkanIrradianceMapPass::updateDescriptorSet(const VulkanSkyboxPassExecuteInfo& execInfo) {
 
 		using namespace mvk::WriteDescriptorSet;
@@ -159,29 +167,8 @@ namespace milo {
 	}
 
 	void VulkanIrradianceMapPass::createComputePipeline() {
-
-		Shader* shader = Assets::shaders().load(Files::resource("shaders/skybox/irradiance.comp"));
-		auto* vulkanShader = dynamic_cast<VulkanShader*>(shader);
-
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = (uint32_t*)vulkanShader->bytecode();
-		shaderModuleCreateInfo.codeSize = vulkanShader->bytecodeLength();
-
-		VkShaderModule shaderModule;
-		VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
-
-		VkPipelineShaderStageCreateInfo shaderStage{};
-		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStage.module = shaderModule;
-		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		shaderStage.pName = "main";
-
-		VkComputePipelineCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		createInfo.layout = m_PipelineLayout;
-		createInfo.stage = shaderStage;
-
-		VK_CALL(vkCreateComputePipelines(m_Device->logical(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_ComputePipeline));
+		// Faces may be generated separately with vkCmdDispatchBase
+		m_ComputePipeline = new VulkanComputePipeline("VulkanIrradianceMapPass", m_Device, m_PipelineLayout,
+			Files::resource("shaders/skybox/irradiance.comp"), VK_PIPELINE_CREATE_DISPATCH_BASE_BIT);
 	}
 }
\ No newline at end of file
@@ -14,7 +14,7 @@ namespace milo {
 	}
 
 	VulkanPreethamSkyEnvironmentPass::~VulkanPreethamSkyEnvironmentPass() {
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_ComputePipeline, nullptr));
+		DELETE_PTR(m_ComputePipeline);
 		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
 		DELETE_PTR(m_DescriptorPool);
 		VK_CALLV(vkDestroyDescriptorSetLayout(m_Device->logical(), m_DescriptorSetLayout, nullptr));
@@ -51,7 +51,7 @@ namespace milo {
 			environmentMap->vkSampler(sampler);
 		}
 
-		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline));
+		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->vkPipeline()));
 
 		environmentMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
 								  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
@@ -65,7 +65,7 @@ namespace milo {
 		VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout,
 										 0, 1, &descriptorSet, 0, nullptr));
 
-		VK_CALLV(vkCmdDispatch(commandBuffer, mapSize / 32, mapSize / 32, 6));
+		VK_CALLV(vkCmdDispatchBase(commandBuffer, 0, 0, execInfo.firstFace, mapSize / 32, mapSize / 32, execInfo.faceCount));
 
 		environmentMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 								  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
@@ -145,30 +145,9 @@ namespace milo {
 	}
 
 	void VulkanPreethamSkyEnvironmentPass::createComputePipeline() {
-
-		Shader* shader = Assets::shaders().load(Files::resource("shaders/skybox/preetham_sky.comp"));
-		auto* vulkanShader = dynamic_cast<VulkanShader*>(shader);
-
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = (uint32_t*)vulkanShader->bytecode();
-		shaderModuleCreateInfo.codeSize = vulkanShader->bytecodeLength();
-
-		VkShaderModule shaderModule;
-		VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
-
-		VkPipelineShaderStageCreateInfo shaderStage{};
-		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStage.module = shaderModule;
-		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		shaderStage.pName = "main";
-
-		VkComputePipelineCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		createInfo.layout = m_PipelineLayout;
-		createInfo.stage = shaderStage;
-
-		VK_CALL(vkCreateComputePipelines(m_Device->logical(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_ComputePipeline));
+		// Faces may be generated separately with vkCmdDispatchBase
+		m_ComputePipeline = new VulkanComputePipeline("VulkanPreethamSkyEnvironmentPass", m_Device, m_PipelineLayout,
+			Files::resource("shaders/skybox/preetham_sky.comp"), VK_PIPELINE_CREATE_DISPATCH_BASE_BIT);
 	}
 
 }
\ No newline at end of file
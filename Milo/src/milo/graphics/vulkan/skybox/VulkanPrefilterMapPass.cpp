@@ -14,7 +14,7 @@ namespace milo {
 
 	VulkanPrefilterMapPass::~VulkanPrefilterMapPass() {
 
-		VK_CALLV(vkDestroyPipeline(m_Device->logical(), m_ComputePipeline, nullptr));
+		DELETE_PTR(m_ComputePipeline);
 		VK_CALLV(vkDestroyPipelineLayout(m_Device->logical(), m_PipelineLayout, nullptr));
 
 		DELETE_PTR(m_DescriptorPool);
@@ -31,35 +31,10 @@ namespace milo {
 		uint32_t mipLevels = static_cast<uint32_t>(roundf(execInfo.loadInfo->maxLOD) + 1);
 
 		if(prefilterMap->vkImageView() == VK_NULL_HANDLE) {
-			Cubemap::AllocInfo allocInfo{};
-			allocInfo.width = mapSize;
-			allocInfo.height = mapSize;
-			allocInfo.format = PixelFormat::RGBA16F;
-			allocInfo.mipLevels = mipLevels;
-
-			prefilterMap->allocate(allocInfo);
-
-			VkSamplerCreateInfo sampler{};
-			sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-			sampler.magFilter = VK_FILTER_LINEAR;
-			sampler.minFilter = VK_FILTER_LINEAR;
-			sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-			sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-			sampler.minLod = 0.0f;
-			sampler.maxLod = static_cast<float>(allocInfo.mipLevels);
-			sampler.maxAnisotropy = 1.0f;
-			sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
-
-			prefilterMap->vkSampler(VulkanContext::get()->samplerMap()->get(sampler));
-
-			prefilterMap->generateMipmaps();
-
-			prefilterMap->createMipImageViews();
+			allocate(prefilterMap, *execInfo.loadInfo);
 		}
 
-		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline));
+		VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_ComputePipeline->vkPipeline()));
 
 		prefilterMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_GENERAL,
 								VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
@@ -72,9 +47,12 @@ namespace milo {
 
 		int32_t envMapResolution = (int32_t)execInfo.environmentMap->width();
 
-		for(int32_t i = 0;i < mipLevels;++i) {
+		const uint32_t lastMipLevel = std::min(mipLevels, execInfo.firstMipLevel + std::min(execInfo.mipLevelCount, mipLevels));
 
-			uint32_t mipLevelSize = static_cast<uint32_t>(mapSize * powf(0.5f, i));
+		for(int32_t i = (int32_t)execInfo.firstMipLevel;i < lastMipLevel;++i) {
+
+			uint32_t mipLevelSize = std::max(mapSize >> i, 1u);
+			uint32_t groupCount = (mipLevelSize + 31) / 32;
 
 			PushConstants pushConstants{};
 			pushConstants.roughness = 0;//(float)i / (float)(mipLevels - 1);
@@ -84,13 +62,47 @@ namespace milo {
 			VK_CALLV(vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT,
 										0, sizeof(PushConstants), &pushConstants));
 
-			VK_CALLV(vkCmdDispatch(commandBuffer, mipLevelSize / 32, mipLevelSize / 32, 6));
+			VK_CALLV(vkCmdDispatchBase(commandBuffer, 0, 0, execInfo.firstFace, groupCount, groupCount, execInfo.faceCount));
 		}
 
 		prefilterMap->setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 								VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 	}
 
+	void VulkanPrefilterMapPass::allocate(VulkanCubemap* prefilterMap, const SkyboxLoadInfo& loadInfo) {
+
+		uint32_t mapSize = loadInfo.prefilterMapSize;
+
+		uint32_t mipLevels = static_cast<uint32_t>(roundf(loadInfo.maxLOD) + 1);
+
+		Cubemap::AllocInfo allocInfo{};
+		allocInfo.width = mapSize;
+		allocInfo.height = mapSize;
+		allocInfo.format = PixelFormat::RGBA16F;
+		allocInfo.mipLevels = mipLevels;
+
+		prefilterMap->allocate(allocInfo);
+
+		VkSamplerCreateInfo sampler{};
+		sampler.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		sampler.magFilter = VK_FILTER_LINEAR;
+		sampler.minFilter = VK_FILTER_LINEAR;
+		sampler.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		sampler.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		sampler.minLod = 0.0f;
+		sampler.maxLod = static_cast<float>(allocInfo.mipLevels);
+		sampler.maxAnisotropy = 1.0f;
+		sampler.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+		prefilterMap->vkSampler(VulkanContext::get()->samplerMap()->get(sampler));
+
+		prefilterMap->generateMipmaps();
+
+		prefilterMap->createMipImageViews();
+	}
+
 	void VulkanPrefilterMapPass::updateDescriptorSet(const VulkanSkyboxPassExecuteInfo& execInfo) {
 
 		using namespace mvk::WriteDescriptorSet;
@@ -175,29 +187,8 @@ namespace milo {
 	}
 
 	void VulkanPrefilterMapPass::createComputePipeline() {
-
-		Shader* shader = Assets::shaders().load(Files::resource("shaders/skybox/prefilter.comp"));
-		auto* vulkanShader = dynamic_cast<VulkanShader*>(shader);
-
-		VkShaderModuleCreateInfo shaderModuleCreateInfo{};
-		shaderModuleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		shaderModuleCreateInfo.pCode = (uint32_t*)vulkanShader->bytecode();
-		shaderModuleCreateInfo.codeSize = vulkanShader->bytecodeLength();
-
-		VkShaderModule shaderModule;
-		VK_CALL(vkCreateShaderModule(m_Device->logical(), &shaderModuleCreateInfo, nullptr, &shaderModule));
-
-		VkPipelineShaderStageCreateInfo shaderStage{};
-		shaderStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		shaderStage.module = shaderModule;
-		shaderStage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-		shaderStage.pName = "main";
-
-		VkComputePipelineCreateInfo createInfo{};
-		createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-		createInfo.layout = m_PipelineLayout;
-		createInfo.stage = shaderStage;
-
-		VK_CALL(vkCreateComputePipelines(m_Device->logical(), VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_ComputePipeline));
+		// Faces may be generated separately with vkCmdDispatchBase
+		m_ComputePipeline = new VulkanComputePipeline("VulkanPrefilterMapPass", m_Device, m_PipelineLayout,
+			Files::resource("shaders/skybox/prefilter.comp"), VK_PIPELINE_CREATE_DISPATCH_BASE_BIT);
 	}
 }
\ No newline at end of file
@@ -1,8 +1,126 @@
 #include "milo/graphics/vulkan/skybox/VulkanSkyboxFactory.h"
 #include "milo/graphics/vulkan/VulkanContext.h"
+#include "milo/assets/AssetManager.h"
+#include "milo/logging/Log.h"
 
 namespace milo {
 
+	static const TextureUsageFlags SKYBOX_MAP_USAGE = TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT;
+
+	static bool isReady(const Future<void>& future) {
+		return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	static VkSampler linearClampSampler() {
+
+		VkSamplerCreateInfo samplerInfo = mvk::SamplerCreateInfo::create();
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+
+		return VulkanContext::get()->samplerMap()->get(samplerInfo);
+	}
+
+	static bool matches(const SkyboxCacheImage& image, const VulkanTexture& texture, uint32_t mipLevels) {
+		const VkImageCreateInfo& info = texture.vkImageInfo();
+		return image.format == mvk::toPixelFormat(info.format)
+			&& image.width == info.extent.width
+			&& image.height == info.extent.height
+			&& image.layers == info.arrayLayers
+			&& image.mipLevels == mipLevels
+			&& image.data.size() == texture.mipLevelsSize(mipLevels);
+	}
+
+	static VulkanBuffer* recordUpload(VkCommandBuffer commandBuffer, VulkanTexture& texture, const SkyboxCacheImage& image) {
+
+		VulkanBuffer* stagingBuffer = VulkanBuffer::createStagingBuffer(image.data.data(), image.data.size());
+
+		texture.setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						  VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		texture.copyMipLevelsFromBuffer(commandBuffer, *stagingBuffer, image.mipLevels);
+
+		texture.setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		return stagingBuffer;
+	}
+
+	static VulkanBuffer* recordReadback(VkCommandBuffer commandBuffer, VulkanTexture& texture, uint32_t mipLevels) {
+
+		VulkanBuffer* readbackBuffer = VulkanBuffer::createStagingBuffer(texture.mipLevelsSize(mipLevels));
+
+		texture.setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+		texture.copyMipLevelsToBuffer(commandBuffer, *readbackBuffer, mipLevels);
+
+		texture.setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						  VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+		return readbackBuffer;
+	}
+
+	static SkyboxCacheImage readCacheImage(VulkanBuffer* readbackBuffer, const VulkanTexture& texture, uint32_t mipLevels) {
+
+		const VkImageCreateInfo& info = texture.vkImageInfo();
+
+		SkyboxCacheImage image{};
+		image.format = mvk::toPixelFormat(info.format);
+		image.width = info.extent.width;
+		image.height = info.extent.height;
+		image.layers = info.arrayLayers;
+		image.mipLevels = mipLevels;
+		image.data.resize(texture.mipLevelsSize(mipLevels));
+
+		readbackBuffer->mapAndRun([&](void* data) {memcpy(image.data.data(), data, image.data.size());});
+
+		return image;
+	}
+
+	static uint32_t prefilterMipLevels(const SkyboxLoadInfo& loadInfo) {
+		return (uint32_t)roundf(loadInfo.maxLOD) + 1;
+	}
+
+	static const uint32_t SKY_UPDATE_IDLE = UINT32_MAX;
+	// A sky changed again this many frames after its last maps were swapped in is considered to be animated
+	static const uint32_t SKY_ANIMATION_FRAMES = 10;
+
+	static SkyboxLoadInfo loadInfoOf(PreethamSky* sky) {
+		SkyboxLoadInfo loadInfo{};
+		loadInfo.environmentMapSize = sky->environmentMap()->width();
+		loadInfo.irradianceMapSize = sky->irradianceMap()->width();
+		loadInfo.prefilterMapSize = sky->prefilterMap()->width();
+		loadInfo.brdfSize = sky->brdfMap()->width();
+		loadInfo.lodBias = sky->prefilterLODBias();
+		loadInfo.maxLOD = sky->maxPrefilterLOD();
+		return loadInfo;
+	}
+
+	// Multiple of 32, the work group size of the passes
+	static uint32_t scaledMapSize(uint32_t size, float scale) {
+		return std::min(size, std::max((uint32_t)((float)size * scale) & ~31u, 32u));
+	}
+
+	// The 6 faces of the environment map, the 6 of the irradiance map, then 6 per prefilter mip level
+	static uint32_t skyUpdateStepCount(const VulkanPreethamSkyUpdate* update) {
+		return 6 * (2 + prefilterMipLevels(update->loadInfo));
+	}
+
+	// Maps generated at a different resolution are recreated
+	static void recreateIfResized(VulkanCubemap*& map, uint32_t size, const String& name) {
+		if(map != nullptr && map->width() != size) {
+			DELETE_PTR(map);
+		}
+		if(map == nullptr) {
+			map = VulkanCubemap::create(SKYBOX_MAP_USAGE);
+			map->setName(name);
+		}
+	}
+
 	VulkanSkyboxFactory::VulkanSkyboxFactory() {
 		m_Device = VulkanContext::get()->device();
 		m_EnvironmentPass = new VulkanEnvironmentMapPass(m_Device);
@@ -13,84 +131,439 @@ namespace milo {
 	}
 
 	VulkanSkyboxFactory::~VulkanSkyboxFactory() {
+
+		awaitRunningJob();
+		awaitRunningSkyUpdate();
+
+		for(auto& [sky, update] : m_SkyUpdates) {
+			destroySkyUpdate(update);
+		}
+		m_SkyUpdates.clear();
+
+		for(VulkanSkyboxJob* job : m_PendingJobs) {
+			try {
+				job->sourceLoad.get();
+			} catch(...) {
+				// Already failed, nothing to release
+			}
+			DELETE_PTR(job->image);
+			DELETE_PTR(job);
+		}
+		m_PendingJobs.clear();
+
+		for(Future<void>& cacheWrite : m_CacheWrites) {
+			cacheWrite.wait();
+		}
+		m_CacheWrites.clear();
+
+		for(auto& [size, brdfMap] : m_BRDFMaps) {
+			DELETE_PTR(brdfMap);
+		}
+		m_BRDFMaps.clear();
+
 		DELETE_PTR(m_EnvironmentPass);
 		DELETE_PTR(m_IrradiancePass);
 		DELETE_PTR(m_PrefilterPass);
 		DELETE_PTR(m_BRDFPass);
+		DELETE_PTR(m_PreethamSkyPass);
 	}
 
 	Skybox* VulkanSkyboxFactory::create(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo) {
 
-		VulkanTexture2D* equirectangularTexture = createEquirectangularTexture(imageFile);
-		VulkanCubemap* environmentMap = VulkanCubemap::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
-		VulkanCubemap* irradianceMap = VulkanCubemap::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
-		VulkanCubemap* prefilterMap = VulkanCubemap::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
-		VulkanTexture2D* brdfMap = VulkanTexture2D::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
+		std::lock_guard<Mutex> lock(m_Mutex);
 
-		VulkanSkyboxPassExecuteInfo execInfo{};
-		execInfo.equirectangularTexture = equirectangularTexture;
-		execInfo.environmentMap = environmentMap;
-		execInfo.irradianceMap = irradianceMap;
-		execInfo.prefilterMap = prefilterMap;
-		execInfo.brdfMap = brdfMap;
-		execInfo.loadInfo = &loadInfo;
+		awaitRunningJob();
+		awaitRunningSkyUpdate();
 
-		m_Device->computeCommandPool()->execute([&](VkCommandBuffer commandBuffer) {
-			execInfo.commandBuffer = commandBuffer;
-			m_EnvironmentPass->execute(execInfo);
-			m_IrradiancePass->execute(execInfo);
-			m_PrefilterPass->execute(execInfo);
+		VulkanSkyboxJob* job = createJob(name, imageFile, loadInfo);
+		Skybox* skybox = job->skybox;
+
+		loadSource(job);
+		submitAndWait(job);
+
+		return skybox;
+	}
+
+	Skybox* VulkanSkyboxFactory::createAsync(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo) {
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
+		VulkanSkyboxJob* job = createJob(name, imageFile, loadInfo);
+		job->skybox->m_Ready = false;
+		job->sourceLoad = std::async(std::launch::async, &VulkanSkyboxFactory::loadSource, job);
+
+		m_PendingJobs.push_back(job);
+
+		return job->skybox;
+	}
+
+	void VulkanSkyboxFactory::await(Skybox* skybox) {
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
+		// Incremental updates of a sky only matter while the sky is alive, so they are dropped
+		auto* sky = dynamic_cast<PreethamSky*>(skybox);
+		if(sky != nullptr && m_SkyUpdates.find(sky) != m_SkyUpdates.end()) {
+			if(m_RunningSkyUpdate != nullptr && m_RunningSkyUpdate->sky == sky) awaitRunningSkyUpdate();
+			destroySkyUpdate(m_SkyUpdates[sky]);
+			m_SkyUpdates.erase(sky);
+			return;
+		}
+
+		if(m_RunningJob != nullptr && m_RunningJob->skybox == skybox) {
+			awaitRunningJob();
+			return;
+		}
+
+		auto it = std::find_if(m_PendingJobs.begin(), m_PendingJobs.end(),
+							   [&](VulkanSkyboxJob* job) {return job->skybox == skybox;});
+
+		if(it == m_PendingJobs.end()) return;
+
+		VulkanSkyboxJob* job = *it;
+		m_PendingJobs.erase(it);
+
+		try {
+			job->sourceLoad.get();
+		} catch(const std::exception& e) {
+			Log::error("Failed to load skybox {}: {}", skybox->name(), e.what());
+			DELETE_PTR(job->image);
+			DELETE_PTR(job);
+			return;
+		}
+
+		awaitRunningJob();
+		awaitRunningSkyUpdate();
+		submitAndWait(job);
+	}
+
+	void VulkanSkyboxFactory::update() {
+
+		std::lock_guard<Mutex> lock(m_Mutex);
+
+		if(m_RunningJob != nullptr && vkGetFenceStatus(m_Device->logical(), m_RunningJob->fence) == VK_SUCCESS) {
+			finish(m_RunningJob);
+			m_RunningJob = nullptr;
+		}
+
+		if(m_RunningSkyUpdate != nullptr && vkGetFenceStatus(m_Device->logical(), m_RunningSkyUpdate->fence) == VK_SUCCESS) {
+			finishSkyUpdateStep(m_RunningSkyUpdate);
+			m_RunningSkyUpdate = nullptr;
+		}
+
+		if(m_RunningJob == nullptr && m_RunningSkyUpdate == nullptr) {
+
+			for(auto it = m_PendingJobs.begin();it != m_PendingJobs.end();++it) {
+
+				VulkanSkyboxJob* job = *it;
+				if(!isReady(job->sourceLoad)) continue;
+
+				m_PendingJobs.erase(it);
+
+				try {
+					job->sourceLoad.get();
+				} catch(const std::exception& e) {
+					Log::error("Failed to load skybox {}: {}", job->skybox->name(), e.what());
+					DELETE_PTR(job->image);
+					DELETE_PTR(job);
+					break;
+				}
+
+				// A stale cache entry sends the job back to decoding its image
+				if(submit(job))
+					m_RunningJob = job;
+				else
+					m_PendingJobs.push_back(job);
+				break;
+			}
+		}
+
+		updateSkies();
+
+		m_CacheWrites.erase(std::remove_if(m_CacheWrites.begin(), m_CacheWrites.end(), isReady), m_CacheWrites.end());
+	}
+
+	VulkanSkyboxJob* VulkanSkyboxFactory::createJob(const String& name, const String& imageFile, const SkyboxLoadInfo& loadInfo) {
+		VulkanSkyboxJob* job = new VulkanSkyboxJob();
+		job->skybox = new Skybox(name, imageFile);
+		job->imageFile = imageFile;
+		job->loadInfo = loadInfo;
+		return job;
+	}
+
+	void VulkanSkyboxFactory::loadSource(VulkanSkyboxJob* job) {
+
+		job->cacheKey = SkyboxCache::keyOf(job->imageFile, job->loadInfo);
+		job->cacheHit = SkyboxCache::load(job->cacheKey, job->cache);
+
+		if(job->cacheHit) return;
+
+		decodeSource(job);
+	}
+
+	void VulkanSkyboxFactory::decodeSource(VulkanSkyboxJob* job) {
+		job->image = Image::loadImage(job->imageFile, PixelFormat::RGBA32F);
+		job->cache.thumbnail = SkyboxCache::createThumbnail(*job->image);
+	}
+
+	bool VulkanSkyboxFactory::submit(VulkanSkyboxJob* job) {
+
+		// Submitted again after a stale cache entry, the maps and the thumbnail already exist
+		if(job->skybox->m_EnvironmentMap == nullptr) createMaps(job);
+
+		if(job->cacheHit && !validateCache(job)) {
+			Log::warn("Skybox cache entry {} does not match the current maps, regenerating it", SkyboxCache::filenameOf(job->cacheKey));
+			job->cacheHit = false;
+			job->sourceLoad = std::async(std::launch::async, &VulkanSkyboxFactory::decodeSource, job);
+			return false;
+		}
+
+		bool brdfMapCreated = false;
+		VulkanTexture2D* brdfMap = getBRDFMap(job->loadInfo.brdfSize, brdfMapCreated);
+		job->skybox->m_BRDFMap = brdfMap;
+
+		m_Device->computeCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &job->commandBuffer);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CALL(vkBeginCommandBuffer(job->commandBuffer, &beginInfo));
+
+		if(job->cacheHit) {
+			recordCacheUpload(job, job->commandBuffer);
+		} else {
+			recordGeneration(job, job->commandBuffer);
+		}
+
+		if(brdfMapCreated) {
+			VulkanSkyboxPassExecuteInfo execInfo{};
+			execInfo.brdfMap = brdfMap;
+			execInfo.loadInfo = &job->loadInfo;
+			execInfo.commandBuffer = job->commandBuffer;
 			m_BRDFPass->execute(execInfo);
-		});
+		}
 
-		execInfo.irradianceMap->generateMipmaps();
+		VK_CALL(vkEndCommandBuffer(job->commandBuffer));
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VK_CALL(vkCreateFence(m_Device->logical(), &fenceInfo, nullptr, &job->fence));
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &job->commandBuffer;
+
+		// Detached, a regular submit would replace the semaphores the frame passes wait for
+		m_Device->computeQueue()->submitDetached(submitInfo, job->fence);
+
+		return true;
+	}
+
+	void VulkanSkyboxFactory::submitAndWait(VulkanSkyboxJob* job) {
+		if(!submit(job)) {
+			job->sourceLoad.get();
+			submit(job);
+		}
+		m_RunningJob = job;
+		awaitRunningJob();
+	}
+
+	void VulkanSkyboxFactory::createMaps(VulkanSkyboxJob* job) {
+
+		Skybox* skybox = job->skybox;
+
+		VulkanCubemap* environmentMap = VulkanCubemap::create(SKYBOX_MAP_USAGE);
+		VulkanCubemap* irradianceMap = VulkanCubemap::create(SKYBOX_MAP_USAGE);
+		VulkanCubemap* prefilterMap = VulkanCubemap::create(SKYBOX_MAP_USAGE);
 
-		Skybox* skybox = new Skybox(name, imageFile);
-		skybox->m_EquirectangularTexture = Ref<VulkanTexture2D>(equirectangularTexture);
 		skybox->m_EnvironmentMap = environmentMap;
 		skybox->m_IrradianceMap = irradianceMap;
-		skybox->m_BRDFMap = brdfMap;
 		skybox->m_PrefilterMap = prefilterMap;
-		skybox->m_PrefilterLODBias = loadInfo.lodBias;
-		skybox->m_MaxPrefilterLOD = loadInfo.maxLOD;
+		skybox->m_PrefilterLODBias = job->loadInfo.lodBias;
+		skybox->m_MaxPrefilterLOD = job->loadInfo.maxLOD;
 
-		Assets::textures().addIcon(name, skybox->equirectangularTexture());
+		VulkanTexture2D* thumbnail = createThumbnailTexture(job->cache.thumbnail);
+		thumbnail->setName(skybox->name() + "_EquirectangularTexture");
+		skybox->m_EquirectangularTexture = Ref<VulkanTexture2D>(thumbnail);
+		Assets::textures().addIcon(skybox->name(), skybox->equirectangularTexture());
+	}
 
-		equirectangularTexture->setName(name + "_EquirectangularTexture");
-		environmentMap->setName(name + "_EnvironmentMap");
-		irradianceMap->setName(name + "_IrradianceMap");
-		prefilterMap->setName(name + "_PrefilterMap");
-		brdfMap->setName(name + "_BRDFMap");
+	bool VulkanSkyboxFactory::validateCache(VulkanSkyboxJob* job) {
 
-		return skybox;
+		Skybox* skybox = job->skybox;
+		VulkanCubemap* environmentMap = dynamic_cast<VulkanCubemap*>(skybox->m_EnvironmentMap);
+		VulkanCubemap* irradianceMap = dynamic_cast<VulkanCubemap*>(skybox->m_IrradianceMap);
+		VulkanCubemap* prefilterMap = dynamic_cast<VulkanCubemap*>(skybox->m_PrefilterMap);
+
+		m_EnvironmentPass->allocate(environmentMap, job->loadInfo);
+		m_IrradiancePass->allocate(irradianceMap, job->loadInfo);
+		m_PrefilterPass->allocate(prefilterMap, job->loadInfo);
+
+		const SkyboxCacheData& cache = job->cache;
+
+		return matches(cache.environmentMap, *environmentMap, 1)
+			&& matches(cache.irradianceMap, *irradianceMap, 1)
+			&& matches(cache.prefilterMap, *prefilterMap, prefilterMipLevels(job->loadInfo));
+	}
+
+	void VulkanSkyboxFactory::recordCacheUpload(VulkanSkyboxJob* job, VkCommandBuffer commandBuffer) {
+
+		Skybox* skybox = job->skybox;
+		VulkanCubemap* environmentMap = dynamic_cast<VulkanCubemap*>(skybox->m_EnvironmentMap);
+		VulkanCubemap* irradianceMap = dynamic_cast<VulkanCubemap*>(skybox->m_IrradianceMap);
+		VulkanCubemap* prefilterMap = dynamic_cast<VulkanCubemap*>(skybox->m_PrefilterMap);
+		const SkyboxCacheData& cache = job->cache;
+
+		job->stagingBuffers.push_back(recordUpload(commandBuffer, *environmentMap, cache.environmentMap));
+		job->stagingBuffers.push_back(recordUpload(commandBuffer, *irradianceMap, cache.irradianceMap));
+		job->stagingBuffers.push_back(recordUpload(commandBuffer, *prefilterMap, cache.prefilterMap));
+	}
+
+	void VulkanSkyboxFactory::recordGeneration(VulkanSkyboxJob* job, VkCommandBuffer commandBuffer) {
+
+		Skybox* skybox = job->skybox;
+
+		job->equirectangularTexture = createEquirectangularTexture(*job->image, commandBuffer, job->stagingBuffers);
+
+		VulkanSkyboxPassExecuteInfo execInfo{};
+		execInfo.equirectangularTexture = job->equirectangularTexture;
+		execInfo.environmentMap = dynamic_cast<VulkanCubemap*>(skybox->m_EnvironmentMap);
+		execInfo.irradianceMap = dynamic_cast<VulkanCubemap*>(skybox->m_IrradianceMap);
+		execInfo.prefilterMap = dynamic_cast<VulkanCubemap*>(skybox->m_PrefilterMap);
+		execInfo.brdfMap = dynamic_cast<VulkanTexture2D*>(skybox->m_BRDFMap);
+		execInfo.loadInfo = &job->loadInfo;
+		execInfo.commandBuffer = commandBuffer;
+
+		m_EnvironmentPass->execute(execInfo);
+		m_IrradiancePass->execute(execInfo);
+		m_PrefilterPass->execute(execInfo);
+
+		// Environment and irradiance mips are generated again after loading, so only the base level is cached
+		job->readbackBuffers[0] = recordReadback(commandBuffer, *execInfo.environmentMap, 1);
+		job->readbackBuffers[1] = recordReadback(commandBuffer, *execInfo.irradianceMap, 1);
+		job->readbackBuffers[2] = recordReadback(commandBuffer, *execInfo.prefilterMap, prefilterMipLevels(job->loadInfo));
+	}
+
+	void VulkanSkyboxFactory::finish(VulkanSkyboxJob* job) {
+
+		Skybox* skybox = job->skybox;
+
+		VK_CALLV(vkDestroyFence(m_Device->logical(), job->fence, nullptr));
+		m_Device->computeCommandPool()->free(1, &job->commandBuffer);
+
+		for(VulkanBuffer* stagingBuffer : job->stagingBuffers) {
+			DELETE_PTR(stagingBuffer);
+		}
+		DELETE_PTR(job->equirectangularTexture);
+		DELETE_PTR(job->image);
+
+		skybox->m_EnvironmentMap->generateMipmaps();
+		skybox->m_IrradianceMap->generateMipmaps();
+
+		if(!job->cacheHit) {
+
+			SkyboxCacheData& cache = job->cache;
+			cache.environmentMap = readCacheImage(job->readbackBuffers[0], *dynamic_cast<VulkanCubemap*>(skybox->m_EnvironmentMap), 1);
+			cache.irradianceMap = readCacheImage(job->readbackBuffers[1], *dynamic_cast<VulkanCubemap*>(skybox->m_IrradianceMap), 1);
+			cache.prefilterMap = readCacheImage(job->readbackBuffers[2], *dynamic_cast<VulkanCubemap*>(skybox->m_PrefilterMap),
+												prefilterMipLevels(job->loadInfo));
+
+			m_CacheWrites.push_back(std::async(std::launch::async, [key = job->cacheKey, data = std::move(cache)]() {
+				try {
+					SkyboxCache::save(key, data);
+				} catch(const std::exception& e) {
+					Log::error("Failed to write skybox cache entry {}: {}", SkyboxCache::filenameOf(key), e.what());
+				}
+			}));
+		}
+
+		for(VulkanBuffer*& readbackBuffer : job->readbackBuffers) {
+			DELETE_PTR(readbackBuffer);
+		}
+
+		skybox->m_EnvironmentMap->setName(skybox->name() + "_EnvironmentMap");
+		skybox->m_IrradianceMap->setName(skybox->name() + "_IrradianceMap");
+		skybox->m_PrefilterMap->setName(skybox->name() + "_PrefilterMap");
+
+		skybox->m_Ready = true;
+		++skybox->m_Modifications;
+
+		Log::debug("Skybox {} {}", skybox->name(), job->cacheHit ? "loaded from cache" : "generated");
+
+		DELETE_PTR(job);
+	}
+
+	void VulkanSkyboxFactory::awaitRunningJob() {
+
+		if(m_RunningJob == nullptr) return;
+
+		VK_CALL(vkWaitForFences(m_Device->logical(), 1, &m_RunningJob->fence, VK_TRUE, UINT64_MAX));
+
+		finish(m_RunningJob);
+		m_RunningJob = nullptr;
 	}
 
-	VulkanTexture2D* VulkanSkyboxFactory::createEquirectangularTexture(const String& imageFile) {
+	VulkanTexture2D* VulkanSkyboxFactory::getBRDFMap(uint32_t size, bool& created) {
 
-		Image* image = Image::loadImage(imageFile, PixelFormat::RGBA32F);
+		auto it = m_BRDFMaps.find(size);
+		if(it != m_BRDFMaps.end()) {
+			created = false;
+			return it->second;
+		}
+
+		VulkanTexture2D* brdfMap = VulkanTexture2D::create(SKYBOX_MAP_USAGE);
+		brdfMap->setName(str("BRDFMap_") + str(size));
+		m_BRDFMaps[size] = brdfMap;
+
+		created = true;
+		return brdfMap;
+	}
+
+	VulkanTexture2D* VulkanSkyboxFactory::createEquirectangularTexture(const Image& image, VkCommandBuffer commandBuffer,
+																	   ArrayList<VulkanBuffer*>& stagingBuffers) {
 
 		VulkanTexture2D* texture = VulkanTexture2D::create(TEXTURE_USAGE_SAMPLED_BIT);
 
 		Texture2D::AllocInfo allocInfo{};
-		allocInfo.width = image->width();
-		allocInfo.height = image->height();
-		allocInfo.format = image->format();
-		allocInfo.pixels = image->pixels();
+		allocInfo.width = image.width();
+		allocInfo.height = image.height();
+		allocInfo.format = image.format();
 		allocInfo.mipLevels = 1;
 
 		texture->allocate(allocInfo);
+		texture->vkSampler(linearClampSampler());
 
-		VkSamplerCreateInfo samplerInfo = mvk::SamplerCreateInfo::create();
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+		// Uploaded in the same command buffer as the passes, instead of a blocking submit of its own
+		VulkanBuffer* stagingBuffer = VulkanBuffer::createStagingBuffer(image.pixels(), image.size());
+		stagingBuffers.push_back(stagingBuffer);
 
-		texture->vkSampler(VulkanContext::get()->samplerMap()->get(samplerInfo));
+		texture->setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						   VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-		DELETE_PTR(image);
+		texture->copyMipLevelsFromBuffer(commandBuffer, *stagingBuffer, 1);
+
+		texture->setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+		return texture;
+	}
+
+	VulkanTexture2D* VulkanSkyboxFactory::createThumbnailTexture(const SkyboxCacheImage& thumbnail) {
+
+		VulkanTexture2D* texture = VulkanTexture2D::create(TEXTURE_USAGE_SAMPLED_BIT);
+
+		Texture2D::AllocInfo allocInfo{};
+		allocInfo.width = thumbnail.width;
+		allocInfo.height = thumbnail.height;
+		allocInfo.format = thumbnail.format;
+		allocInfo.pixels = thumbnail.data.data();
+		allocInfo.mipLevels = 1;
+
+		texture->allocate(allocInfo);
+		texture->vkSampler(linearClampSampler());
 
 		return texture;
 	}
@@ -98,15 +571,22 @@ namespace milo {
 	PreethamSky* VulkanSkyboxFactory::createPreethamSky(const String& name, const SkyboxLoadInfo& loadInfo,
 														float turbidity, float azimuth, float inclination) {
 
-		VulkanCubemap* environmentMap = VulkanCubemap::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
-		VulkanCubemap* irradianceMap = VulkanCubemap::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
-		VulkanCubemap* prefilterMap = VulkanCubemap::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
-		VulkanTexture2D* brdfMap = VulkanTexture2D::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_STORAGE_BIT);
+		std::lock_guard<Mutex> lock(m_Mutex);
+
+		// The passes share their descriptor sets with the skybox jobs and sky updates
+		awaitRunningJob();
+		awaitRunningSkyUpdate();
+
+		VulkanCubemap* environmentMap = VulkanCubemap::create(SKYBOX_MAP_USAGE);
+		VulkanCubemap* irradianceMap = VulkanCubemap::create(SKYBOX_MAP_USAGE);
+		VulkanCubemap* prefilterMap = VulkanCubemap::create(SKYBOX_MAP_USAGE);
+
+		bool brdfMapCreated = false;
+		VulkanTexture2D* brdfMap = getBRDFMap(loadInfo.brdfSize, brdfMapCreated);
 
 		environmentMap->setName(name + "_EnvironmentMap");
 		irradianceMap->setName(name + "_IrradianceMap");
 		prefilterMap->setName(name + "_PrefilterMap");
-		brdfMap->setName(name + "_BRDFMap");
 
 		VulkanSkyboxPassExecuteInfo execInfo{};
 		execInfo.environmentMap = environmentMap;
@@ -123,7 +603,7 @@ namespace milo {
 			m_PreethamSkyPass->execute(execInfo);
 			m_IrradiancePass->execute(execInfo);
 			m_PrefilterPass->execute(execInfo);
-			m_BRDFPass->execute(execInfo);
+			if(brdfMapCreated) m_BRDFPass->execute(execInfo);
 		});
 
 		irradianceMap->generateMipmaps();
@@ -141,15 +621,30 @@ namespace milo {
 		return sky;
 	}
 
-	void VulkanSkyboxFactory::updatePreethamSky(PreethamSky* sky) {
+	void VulkanSkyboxFactory::updatePreethamSky(const PreethamSkyUpdateRequest& request) {
 
-		SkyboxLoadInfo loadInfo{};
-		loadInfo.environmentMapSize = sky->environmentMap()->width();
-		loadInfo.irradianceMapSize = sky->irradianceMap()->width();
-		loadInfo.prefilterMapSize = sky->prefilterMap()->width();
-		loadInfo.brdfSize = sky->brdfMap()->width();
-		loadInfo.lodBias = sky->m_PrefilterLODBias;
-		loadInfo.maxLOD = sky->m_MaxPrefilterLOD;
+		std::lock_guard<Mutex> lock(m_Mutex);
+
+		if(request.updateMode == PreethamSkyUpdateMode::Incremental) {
+			requestIncrementalUpdate(request);
+			return;
+		}
+
+		PreethamSky* sky = request.sky;
+
+		awaitRunningJob();
+		awaitRunningSkyUpdate();
+
+		// An incremental update started before switching modes would swap in outdated maps
+		auto it = m_SkyUpdates.find(sky);
+		if(it != m_SkyUpdates.end()) {
+			// Its maps may have been the ones of the sky until the last swap
+			m_Device->awaitTermination();
+			destroySkyUpdate(it->second);
+			m_SkyUpdates.erase(it);
+		}
+
+		SkyboxLoadInfo loadInfo = loadInfoOf(sky);
 
 		VulkanSkyboxPassExecuteInfo execInfo{};
 		execInfo.environmentMap = dynamic_cast<VulkanCubemap*>(sky->environmentMap());
@@ -157,20 +652,211 @@ namespace milo {
 		execInfo.prefilterMap = dynamic_cast<VulkanCubemap*>(sky->prefilterMap());
 		execInfo.brdfMap = dynamic_cast<VulkanTexture2D*>(sky->brdfMap());
 		execInfo.loadInfo = &loadInfo;
-		execInfo.turbidity = sky->turbidity();
-		execInfo.azimuth = sky->azimuth();
-		execInfo.inclination = sky->inclination();
+		execInfo.turbidity = request.turbidity;
+		execInfo.azimuth = request.azimuth;
+		execInfo.inclination = request.inclination;
 
+		// The BRDF map does not depend on the sky, so it is never regenerated here
 		m_Device->computeCommandPool()->execute([&](VkCommandBuffer commandBuffer) {
 			execInfo.commandBuffer = commandBuffer;
 			m_PreethamSkyPass->execute(execInfo);
 			m_IrradiancePass->execute(execInfo);
 			m_PrefilterPass->execute(execInfo);
-			m_BRDFPass->execute(execInfo);
 		});
 
 		execInfo.irradianceMap->generateMipmaps();
 
-		sky->m_Dirty = false;
+		++sky->m_Modifications;
+	}
+
+	void VulkanSkyboxFactory::requestIncrementalUpdate(const PreethamSkyUpdateRequest& request) {
+
+		PreethamSky* sky = request.sky;
+
+		auto it = m_SkyUpdates.find(sky);
+
+		if(it == m_SkyUpdates.end()) {
+			auto* update = new VulkanPreethamSkyUpdate();
+			update->sky = sky;
+			update->fullLoadInfo = loadInfoOf(sky);
+			update->request = request;
+			update->requested = true;
+			m_SkyUpdates[sky] = update;
+			return;
+		}
+
+		VulkanPreethamSkyUpdate* update = it->second;
+
+		// Rate limited by how much the sky changed since the last update was started
+		const Vector3 lastSunDirection = PreethamSky::sunDirection(update->azimuth, update->inclination);
+		const Vector3 sunDirection = PreethamSky::sunDirection(request.azimuth, request.inclination);
+		const float sunAngleDelta = acos(std::clamp(dot(sunDirection, lastSunDirection), -1.0f, 1.0f));
+		const bool turbidityChanged = fabs(request.turbidity - update->turbidity) > 0.001f;
+
+		if(sunAngleDelta < sky->minSunAngleDelta() && !turbidityChanged) return;
+
+		// Changed again while the previous maps are being generated, or right after they were swapped in
+		update->animating = update->step != SKY_UPDATE_IDLE || update->framesSinceSwap < SKY_ANIMATION_FRAMES;
+		update->request = request;
+		update->requested = true;
+	}
+
+	void VulkanSkyboxFactory::updateSkies() {
+
+		VulkanPreethamSkyUpdate* next = nullptr;
+
+		for(auto& [sky, update] : m_SkyUpdates) {
+
+			if(update->framesSinceSwap != UINT32_MAX) ++update->framesSinceSwap;
+
+			if(next != nullptr) continue;
+
+			// The previous maps of the sky may still be in use by the frames in flight right after a swap
+			const bool canStart = update->requested && update->framesSinceSwap >= MAX_SWAPCHAIN_IMAGE_COUNT;
+
+			if(update->step != SKY_UPDATE_IDLE || canStart) next = update;
+		}
+
+		if(next == nullptr || m_RunningJob != nullptr || m_RunningSkyUpdate != nullptr) return;
+
+		if(next->step == SKY_UPDATE_IDLE) startSkyUpdate(next);
+
+		recordSkyUpdateStep(next);
+	}
+
+	void VulkanSkyboxFactory::startSkyUpdate(VulkanPreethamSkyUpdate* update) {
+
+		PreethamSky* sky = update->sky;
+
+		update->turbidity = update->request.turbidity;
+		update->azimuth = update->request.azimuth;
+		update->inclination = update->request.inclination;
+		update->requested = false;
+		update->step = 0;
+
+		// Low resolution fast path: a few frames for the whole update instead of a few faces per frame
+		update->loadInfo = update->fullLoadInfo;
+		if(update->animating && sky->animationResolutionScale() < 1.0f) {
+			const float scale = sky->animationResolutionScale();
+			update->loadInfo.environmentMapSize = scaledMapSize(update->fullLoadInfo.environmentMapSize, scale);
+			update->loadInfo.irradianceMapSize = scaledMapSize(update->fullLoadInfo.irradianceMapSize, scale);
+			update->loadInfo.prefilterMapSize = scaledMapSize(update->fullLoadInfo.prefilterMapSize, scale);
+			update->facesPerStep = 6;
+		} else {
+			update->facesPerStep = std::min(sky->facesPerFrame(), 6u);
+		}
+
+		recreateIfResized(update->environmentMap, update->loadInfo.environmentMapSize, sky->name() + "_EnvironmentMap");
+		recreateIfResized(update->irradianceMap, update->loadInfo.irradianceMapSize, sky->name() + "_IrradianceMap");
+		recreateIfResized(update->prefilterMap, update->loadInfo.prefilterMapSize, sky->name() + "_PrefilterMap");
+	}
+
+	void VulkanSkyboxFactory::recordSkyUpdateStep(VulkanPreethamSkyUpdate* update) {
+
+		VulkanSkyboxPassExecuteInfo execInfo{};
+		execInfo.environmentMap = update->environmentMap;
+		execInfo.irradianceMap = update->irradianceMap;
+		execInfo.prefilterMap = update->prefilterMap;
+		execInfo.loadInfo = &update->loadInfo;
+		execInfo.turbidity = update->turbidity;
+		execInfo.azimuth = update->azimuth;
+		execInfo.inclination = update->inclination;
+
+		// A step never crosses maps or mip levels, so every pass is recorded at most once per command buffer
+		const uint32_t map = update->step / 6;
+		execInfo.firstFace = update->step % 6;
+		execInfo.faceCount = std::min(update->facesPerStep, 6 - execInfo.firstFace);
+
+		m_Device->computeCommandPool()->allocate(VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1, &update->commandBuffer);
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+		VK_CALL(vkBeginCommandBuffer(update->commandBuffer, &beginInfo));
+
+		execInfo.commandBuffer = update->commandBuffer;
+
+		if(map == 0) {
+			m_PreethamSkyPass->execute(execInfo);
+		} else if(map == 1) {
+			m_IrradiancePass->execute(execInfo);
+		} else {
+			execInfo.firstMipLevel = map - 2;
+			execInfo.mipLevelCount = 1;
+			m_PrefilterPass->execute(execInfo);
+		}
+
+		VK_CALL(vkEndCommandBuffer(update->commandBuffer));
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		VK_CALL(vkCreateFence(m_Device->logical(), &fenceInfo, nullptr, &update->fence));
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &update->commandBuffer;
+
+		m_Device->computeQueue()->submitDetached(submitInfo, update->fence);
+
+		update->step += execInfo.faceCount;
+		m_RunningSkyUpdate = update;
+	}
+
+	void VulkanSkyboxFactory::finishSkyUpdateStep(VulkanPreethamSkyUpdate* update) {
+
+		VK_CALLV(vkDestroyFence(m_Device->logical(), update->fence, nullptr));
+		m_Device->computeCommandPool()->free(1, &update->commandBuffer);
+		update->fence = VK_NULL_HANDLE;
+		update->commandBuffer = VK_NULL_HANDLE;
+
+		if(update->step < skyUpdateStepCount(update)) return;
+
+		update->irradianceMap->generateMipmaps();
+
+		PreethamSky* sky = update->sky;
+
+		Cubemap* environmentMap = sky->m_EnvironmentMap;
+		Cubemap* irradianceMap = sky->m_IrradianceMap;
+		Cubemap* prefilterMap = sky->m_PrefilterMap;
+
+		sky->m_EnvironmentMap = update->environmentMap;
+		sky->m_IrradianceMap = update->irradianceMap;
+		sky->m_PrefilterMap = update->prefilterMap;
+
+		update->environmentMap = dynamic_cast<VulkanCubemap*>(environmentMap);
+		update->irradianceMap = dynamic_cast<VulkanCubemap*>(irradianceMap);
+		update->prefilterMap = dynamic_cast<VulkanCubemap*>(prefilterMap);
+
+		++sky->m_Modifications;
+
+		update->step = SKY_UPDATE_IDLE;
+		update->framesSinceSwap = 0;
+
+		// The sky stopped changing while low resolution maps were being generated, so generate the full ones
+		const bool lowResolution = update->loadInfo.environmentMapSize != update->fullLoadInfo.environmentMapSize;
+		if(lowResolution && !update->requested) {
+			update->requested = true;
+			update->animating = false;
+		}
+	}
+
+	void VulkanSkyboxFactory::awaitRunningSkyUpdate() {
+
+		if(m_RunningSkyUpdate == nullptr) return;
+
+		VK_CALL(vkWaitForFences(m_Device->logical(), 1, &m_RunningSkyUpdate->fence, VK_TRUE, UINT64_MAX));
+
+		finishSkyUpdateStep(m_RunningSkyUpdate);
+		m_RunningSkyUpdate = nullptr;
+	}
+
+	void VulkanSkyboxFactory::destroySkyUpdate(VulkanPreethamSkyUpdate* update) {
+		DELETE_PTR(update->environmentMap);
+		DELETE_PTR(update->irradianceMap);
+		DELETE_PTR(update->prefilterMap);
+		DELETE_PTR(update);
 	}
 }
\ No newline at end of file
@@ -47,7 +47,7 @@ namespace milo {
 			barrier.image = m_VkImage;
 			barrier.subresourceRange = m_ViewInfo.subresourceRange;
 
-			barrier.oldLayout = m_ImageLayout;
+			barrier.oldLayout = layout();
 			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 			barrier.srcAccessMask = 0;
 			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
@@ -63,7 +63,7 @@ namespace milo {
 
 			transitionLayout(commandBuffer, barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-			m_ImageLayout = barrier.newLayout;
+			setCurrentLayout(barrier.newLayout, 0, VK_PIPELINE_STAGE_TRANSFER_BIT);
 		};
 
 		m_Device->transferCommandPool()->execute(task);
@@ -97,8 +97,8 @@ namespace milo {
 			barrier.subresourceRange = m_ViewInfo.subresourceRange;
 
 			// Transition all levels to DST OPTIMAL
-			if(m_ImageLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-				barrier.oldLayout = m_ImageLayout;
+			if(layout() != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+				barrier.oldLayout = layout();
 				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 				barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
@@ -171,7 +171,7 @@ namespace milo {
 										  0, nullptr,
 										  1, &barrier));
 
-			m_ImageLayout = barrier.newLayout;
+			setCurrentLayout(barrier.newLayout, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 		};
 
 		m_Device->graphicsCommandPool()->execute(task);
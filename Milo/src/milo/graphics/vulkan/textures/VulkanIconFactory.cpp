@@ -8,6 +8,20 @@ namespace milo {
 
 	static const Color CLEAR_COLOR = {0.15f, 0.15f, 0.15f, 1.0f};
 
+	static VkBufferImageCopy iconCopyRegion(const IconBakeInfo& icon, const Size& iconSize, uint64_t bufferOffset) {
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = bufferOffset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = 0;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageOffset = {(int32_t)icon.x, (int32_t)icon.y, 0};
+		region.imageExtent = {(uint32_t)iconSize.width, (uint32_t)iconSize.height, 1};
+
+		return region;
+	}
+
 	VulkanIconFactory::VulkanIconFactory() {
 		m_Device = VulkanContext::get()->device();
 	}
@@ -20,112 +34,235 @@ namespace milo {
 		vkDestroyRenderPass(m_Device->logical(), m_RenderPass, nullptr);
 	}
 
-	Texture2D* VulkanIconFactory::createIcon(Mesh* mesh, Material* material, const Size& size) {
+	Texture2D* VulkanIconFactory::createAtlas(const Size& size) {
 
-		if(m_RenderPass == VK_NULL_HANDLE) {
-			createRenderPass();
-		}
+		VulkanTexture2D* atlas = VulkanTexture2D::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_COLOR_ATTACHMENT_BIT);
 
-		if(m_DepthTexture == nullptr) {
-			createDepthTexture(DEFAULT_ICON_SIZE);
-		} else if(m_DepthTexture->size() != size) {
-			m_DepthTexture->resize(size);
+		Texture2D::AllocInfo allocInfo{};
+		allocInfo.width = size.width;
+		allocInfo.height = size.height;
+		allocInfo.mipLevels = 1;
+		allocInfo.format = PixelFormat::RGBA8;
+
+		atlas->allocate(allocInfo);
+
+		return atlas;
+	}
+
+	void VulkanIconFactory::bakeIcons(Texture2D* atlas, const Size& iconSize, ArrayList<IconBakeInfo>& icons) {
+
+		if(icons.empty()) return;
+
+		auto* vkAtlas = dynamic_cast<VulkanTexture2D*>(atlas);
+
+		const uint64_t iconBytes = (uint64_t)iconSize.width * iconSize.height * 4;
+
+		ArrayList<IconBakeInfo*> renderedIcons;
+		for(IconBakeInfo& icon : icons) {
+			if(icon.pixels.empty()) renderedIcons.push_back(&icon);
 		}
 
-		if(m_GraphicsPipeline == nullptr) {
-			createGraphicsPipeline();
+		VulkanBuffer* stagingBuffer = nullptr;
+		if(renderedIcons.size() < icons.size()) {
+			stagingBuffer = VulkanBuffer::createStagingBuffer(iconBytes * (icons.size() - renderedIcons.size()));
 		}
 
-		VulkanTexture2D* iconTexture = createTexture2D(size);
+		VulkanBuffer* readbackBuffer = nullptr;
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
 
-		VkFramebuffer framebuffer = createFramebuffer(iconTexture, size);
+		if(!renderedIcons.empty()) {
 
+			if(m_RenderPass == VK_NULL_HANDLE) {
+				createRenderPass();
+			}
+
+			if(m_DepthTexture == nullptr) {
+				createDepthTexture(atlas->size());
+			} else if(m_DepthTexture->size() != atlas->size()) {
+				m_DepthTexture->resize(atlas->size());
+			}
+
+			if(m_GraphicsPipeline == nullptr) {
+				createGraphicsPipeline();
+			}
+
+			framebuffer = createFramebuffer(vkAtlas);
+			readbackBuffer = VulkanBuffer::createStagingBuffer(iconBytes * renderedIcons.size());
+		}
+
+		// Cached icons are copied into the atlas and the rest rendered into it, all in the same submission
 		m_Device->graphicsCommandPool()->execute([&](VkCommandBuffer commandBuffer) {
 
-			VkClearValue clearValues[2];
-			clearValues[0].color = {CLEAR_COLOR.r, CLEAR_COLOR.g, CLEAR_COLOR.b, CLEAR_COLOR.a};
-			clearValues[1].depthStencil = {1, 0};
+			if(stagingBuffer != nullptr) {
+				uploadIcons(commandBuffer, vkAtlas, iconSize, icons, stagingBuffer);
+			}
 
-			VkRenderPassBeginInfo renderPassInfo{};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = m_RenderPass;
-			renderPassInfo.framebuffer = framebuffer;
-			renderPassInfo.pClearValues = clearValues;
-			renderPassInfo.clearValueCount = 2;
-			renderPassInfo.renderArea.extent.width = (uint32_t)size.width;
-			renderPassInfo.renderArea.extent.height = (uint32_t)size.height;
+			if(framebuffer != VK_NULL_HANDLE) {
+				renderIcons(commandBuffer, vkAtlas, framebuffer, iconSize, icons);
+				readbackIcons(commandBuffer, vkAtlas, iconSize, icons, readbackBuffer);
+			}
 
-			VK_CALLV(vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE));
-			{
-				VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->vkPipeline()));
+			vkAtlas->setLayout(commandBuffer, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+							   VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		});
 
-				VkViewport viewport{};
-				viewport.x = 0;
-				viewport.y = 0;
-				viewport.width = (float)size.width;
-				viewport.height = (float)size.height;
-				viewport.minDepth = 0;
-				viewport.maxDepth = 1;
+		if(readbackBuffer != nullptr) {
+			readbackBuffer->mapAndRun([&](void* data) {
+				for(size_t i = 0;i < renderedIcons.size();++i) {
+					ArrayList<int8>& pixels = renderedIcons[i]->pixels;
+					pixels.resize(iconBytes);
+					memcpy(pixels.data(), (const int8*)data + i * iconBytes, iconBytes);
+				}
+			});
+		}
 
-				VkRect2D scissor{};
-				scissor.offset = {0, 0};
-				scissor.extent = {(uint32_t)size.width, (uint32_t)size.height};
+		if(framebuffer != VK_NULL_HANDLE) {
+			VK_CALLV(vkDestroyFramebuffer(m_Device->logical(), framebuffer, nullptr));
+		}
 
-				VK_CALLV(vkCmdSetViewport(commandBuffer, 0, 1, &viewport));
-				VK_CALLV(vkCmdSetScissor(commandBuffer, 0, 1, &scissor));
+		DELETE_PTR(stagingBuffer);
+		DELETE_PTR(readbackBuffer);
+	}
+
+	void VulkanIconFactory::uploadIcons(VkCommandBuffer commandBuffer, VulkanTexture2D* atlas, const Size& iconSize,
+										const ArrayList<IconBakeInfo>& icons, VulkanBuffer* stagingBuffer) {
+
+		ArrayList<VkBufferImageCopy> regions;
+
+		stagingBuffer->mapAndRun([&](void* data) {
+			uint64_t offset = 0;
+			for(const IconBakeInfo& icon : icons) {
+				if(icon.pixels.empty()) continue;
+				memcpy((int8*)data + offset, icon.pixels.data(), icon.pixels.size());
+				regions.push_back(iconCopyRegion(icon, iconSize, offset));
+				offset += icon.pixels.size();
+			}
+		});
+
+		atlas->setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+						 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-				static Matrix4 view = milo::lookAt(Vector3(0.0f, 0.0f, 3.0f), Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
-				Matrix4 proj = milo::perspective(radians(45.0f), (float)size.width / (float)size.height, 0.1f, 100.0f);
+		VK_CALLV(vkCmdCopyBufferToImage(commandBuffer, stagingBuffer->vkBuffer(), atlas->vkImage(),
+										VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regions.size(), regions.data()));
+	}
+
+	void VulkanIconFactory::renderIcons(VkCommandBuffer commandBuffer, VulkanTexture2D* atlas, VkFramebuffer framebuffer,
+										const Size& iconSize, const ArrayList<IconBakeInfo>& icons) {
+
+		const Size atlasSize = atlas->size();
+
+		// The render pass loads the atlas, so the icons already in it are kept
+		atlas->setLayout(commandBuffer, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+						 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+
+		VkClearValue clearValues[2];
+		clearValues[0].color = {CLEAR_COLOR.r, CLEAR_COLOR.g, CLEAR_COLOR.b, CLEAR_COLOR.a};
+		clearValues[1].depthStencil = {1, 0};
+
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass = m_RenderPass;
+		renderPassInfo.framebuffer = framebuffer;
+		renderPassInfo.pClearValues = clearValues;
+		renderPassInfo.clearValueCount = 2;
+		renderPassInfo.renderArea.extent.width = (uint32_t)atlasSize.width;
+		renderPassInfo.renderArea.extent.height = (uint32_t)atlasSize.height;
+
+		VK_CALLV(vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE));
+		{
+			VK_CALLV(vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->vkPipeline()));
+
+			static Matrix4 view = milo::lookAt(Vector3(0.0f, 0.0f, 3.0f), Vector3(0.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f));
+			Matrix4 proj = milo::perspective(radians(45.0f), (float)iconSize.width / (float)iconSize.height, 0.1f, 100.0f);
+
+			Matrix4 projView = proj * view;
+
+			Matrix4 modelMatrix(1.0f);
+
+			Matrix4 pushConstants[] = {projView, modelMatrix};
 
-				Matrix4 projView = proj * view;
+			VK_CALLV(vkCmdPushConstants(commandBuffer, m_GraphicsPipeline->pipelineLayout(),
+										VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Matrix4) * 2, pushConstants));
 
-				Matrix4 modelMatrix(1.0f);
+			const auto& materialResources = dynamic_cast<const VulkanMaterialResourcePool&>(Assets::materials().resourcePool());
 
-				Matrix4 pushConstants[] = {projView, modelMatrix};
+			for(const IconBakeInfo& icon : icons) {
 
-				VK_CALLV(vkCmdPushConstants(commandBuffer, m_GraphicsPipeline->pipelineLayout(),
-											VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(Matrix4) * 2, pushConstants));
+				if(!icon.pixels.empty()) continue;
 
-				const auto& materialResources = dynamic_cast<const VulkanMaterialResourcePool&>(Assets::materials().resourcePool());
+				VkClearAttachment clearAttachment{};
+				clearAttachment.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				clearAttachment.colorAttachment = 0;
+				clearAttachment.clearValue = clearValues[0];
+
+				VkClearRect clearRect{};
+				clearRect.rect.offset = {(int32_t)icon.x, (int32_t)icon.y};
+				clearRect.rect.extent = {(uint32_t)iconSize.width, (uint32_t)iconSize.height};
+				clearRect.baseArrayLayer = 0;
+				clearRect.layerCount = 1;
+
+				VK_CALLV(vkCmdClearAttachments(commandBuffer, 1, &clearAttachment, 1, &clearRect));
+
+				VkViewport viewport{};
+				viewport.x = (float)icon.x;
+				viewport.y = (float)icon.y;
+				viewport.width = (float)iconSize.width;
+				viewport.height = (float)iconSize.height;
+				viewport.minDepth = 0;
+				viewport.maxDepth = 1;
+
+				VK_CALLV(vkCmdSetViewport(commandBuffer, 0, 1, &viewport));
+				VK_CALLV(vkCmdSetScissor(commandBuffer, 0, 1, &clearRect.rect));
 
 				uint32_t dynamicOffset;
 
-				VkDescriptorSet descriptorSet = materialResources.descriptorSetOf(material, dynamicOffset);
+				VkDescriptorSet descriptorSet = materialResources.descriptorSetOf(icon.material, dynamicOffset);
 
 				VK_CALLV(vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_GraphicsPipeline->pipelineLayout(),
 												 0, 1, &descriptorSet, 1, &dynamicOffset));
 
+				const Mesh* mesh = icon.mesh;
 				const auto* buffers = dynamic_cast<const VulkanMeshBuffers*>(mesh->buffers());
 
 				VkBuffer buffer[] = {buffers->vertexBuffer()->vkBuffer()};
 				VkDeviceSize offset[] = {0};
 				VK_CALLV(vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffer, offset));
 
-				if(!mesh->indices().empty()) {
-					VK_CALLV(vkCmdBindIndexBuffer(commandBuffer, buffers->indexBuffer()->vkBuffer(), 0, VK_INDEX_TYPE_UINT32));
-				}
-
 				if(mesh->indices().empty()) {
 					VK_CALLV(vkCmdDraw(commandBuffer, mesh->vertices().size(), 1, 0, 0));
 				} else {
+					VK_CALLV(vkCmdBindIndexBuffer(commandBuffer, buffers->indexBuffer()->vkBuffer(), 0, VK_INDEX_TYPE_UINT32));
 					VK_CALLV(vkCmdDrawIndexed(commandBuffer, mesh->indices().size(), 1, 0, 0, 0));
 				}
-
 			}
-			VK_CALLV(vkCmdEndRenderPass(commandBuffer));
-		});
+		}
+		VK_CALLV(vkCmdEndRenderPass(commandBuffer));
 
-		VK_CALLV(vkDestroyFramebuffer(m_Device->logical(), framebuffer, nullptr));
+		atlas->setCurrentLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+	}
+
+	void VulkanIconFactory::readbackIcons(VkCommandBuffer commandBuffer, VulkanTexture2D* atlas, const Size& iconSize,
+										  const ArrayList<IconBakeInfo>& icons, VulkanBuffer* readbackBuffer) {
+
+		const uint64_t iconBytes = (uint64_t)iconSize.width * iconSize.height * 4;
+
+		ArrayList<VkBufferImageCopy> regions;
+		for(const IconBakeInfo& icon : icons) {
+			if(!icon.pixels.empty()) continue;
+			regions.push_back(iconCopyRegion(icon, iconSize, regions.size() * iconBytes));
+		}
 
-		iconTexture->setLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		atlas->setLayout(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+						 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-		return iconTexture;
+		VK_CALLV(vkCmdCopyImageToBuffer(commandBuffer, atlas->vkImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+										readbackBuffer->vkBuffer(), regions.size(), regions.data()));
 	}
 
 	void VulkanIconFactory::createRenderPass() {
 
 		milo::RenderPass::Description desc;
-		desc.colorAttachments.push_back({PixelFormat::RGBA8, 1, RenderPass::LoadOp::Clear});
+		desc.colorAttachments.push_back({PixelFormat::RGBA8, 1, RenderPass::LoadOp::Load});
 		desc.depthAttachment = {PixelFormat::DEPTH, 1, RenderPass::LoadOp::Clear};
 
 		m_RenderPass = mvk::RenderPass::create(desc);
@@ -166,22 +303,9 @@ namespace milo {
 		m_GraphicsPipeline = new VulkanGraphicsPipeline("VulkanIconFactoryGraphicsPipeline", m_Device, createInfo);
 	}
 
-	VulkanTexture2D *VulkanIconFactory::createTexture2D(const Size& size) {
-
-		VulkanTexture2D* texture = VulkanTexture2D::create(TEXTURE_USAGE_SAMPLED_BIT | TEXTURE_USAGE_COLOR_ATTACHMENT_BIT);
-
-		Texture2D::AllocInfo allocInfo{};
-		allocInfo.width = size.width;
-		allocInfo.height = size.height;
-		allocInfo.mipLevels = 1;
-		allocInfo.format = PixelFormat::RGBA8;
-
-		texture->allocate(allocInfo);
-
-		return texture;
-	}
+	VkFramebuffer VulkanIconFactory::createFramebuffer(VulkanTexture2D* colorAttachment) {
 
-	VkFramebuffer VulkanIconFactory::createFramebuffer(VulkanTexture2D* colorAttachment, const Size& size) {
+		const Size size = colorAttachment->size();
 
 		VkImageView attachments[] = {colorAttachment->vkImageView(), m_DepthTexture->vkImageView()};
 
@@ -4,6 +4,38 @@
 
 namespace milo {
 
+	ArrayList<VulkanTexture*> VulkanTexture::s_PendingTextures;
+	Mutex VulkanTexture::s_PendingMutex;
+
+	// Accesses the commands that follow a transition to the given layout will most likely make
+	static VkAccessFlags accessOfLayout(VkImageLayout layout) {
+		switch(layout) {
+			case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+				return VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+				return VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+			case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+				return VK_ACCESS_SHADER_READ_BIT;
+			case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+				return VK_ACCESS_TRANSFER_READ_BIT;
+			case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+				return VK_ACCESS_TRANSFER_WRITE_BIT;
+			case VK_IMAGE_LAYOUT_GENERAL:
+				return VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			default:
+				return 0;
+		}
+	}
+
+	bool VulkanTexture::SubresourceState::operator==(const SubresourceState& other) const {
+		return layout == other.layout && access == other.access && stages == other.stages;
+	}
+
+	bool VulkanTexture::SubresourceState::operator!=(const SubresourceState& other) const {
+		return !(*this == other);
+	}
+
 	VulkanTexture::CreateInfo::CreateInfo() {
 		device = VulkanContext::get()->device();
 	}
@@ -40,6 +72,8 @@ namespace milo {
 
 		m_Device->awaitTermination();
 
+		cancelPendingLayout();
+
 		destroyMipImageViews();
 
 		VulkanAllocator::get()->freeImage(m_VkImage, m_Allocation);
@@ -84,7 +118,11 @@ namespace milo {
 	}
 
 	VkImageLayout VulkanTexture::layout() const {
-		return m_ImageLayout;
+		return m_Subresources.empty() ? VK_IMAGE_LAYOUT_UNDEFINED : m_Subresources[0].layout;
+	}
+
+	VkImageLayout VulkanTexture::layout(uint32_t mipLevel, uint32_t arrayLayer) const {
+		return m_Subresources[subresourceIndex(mipLevel, arrayLayer)].layout;
 	}
 
 	VmaMemoryUsage VulkanTexture::memoryUsage() const {
@@ -132,13 +170,13 @@ namespace milo {
 
 		if(m_VkImage == VK_NULL_HANDLE) return;
 
-		VkImageLayout oldLayout = m_ImageLayout;
+		VkImageLayout oldLayout = layout();
 
 		destroy();
 		create(m_CreateInfo);
 		allocate(size.width, size.height, mvk::toPixelFormat(m_ImageInfo.format), m_ImageInfo.mipLevels);
 		if(oldLayout != VK_IMAGE_LAYOUT_UNDEFINED) {
-			setLayout(oldLayout);
+			requestLayout(oldLayout, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, accessOfLayout(oldLayout));
 		}
 	}
 
@@ -153,24 +191,24 @@ namespace milo {
 									  1, &barrier));
 	}
 
-	void VulkanTexture::setLayout(VkImageLayout newLayout, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask) {
-		setLayout(m_ImageLayout, newLayout, srcStageMask, dstStageMask);
-	}
-
-	void VulkanTexture::setLayout(VkImageLayout oldLayout, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask,
-								  VkPipelineStageFlags dstStageMask) {
+	void VulkanTexture::setLayoutImmediate(VkImageLayout newLayout, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask) {
 		VulkanTask task{};
-		task.run = [&](VkCommandBuffer commandBuffer) { setLayout(commandBuffer, oldLayout, newLayout, srcStageMask, dstStageMask);};
+		task.run = [&](VkCommandBuffer commandBuffer) { setLayout(commandBuffer, newLayout, srcStageMask, dstStageMask);};
 		m_Device->transferCommandPool()->execute(task);
 	}
 
 	void VulkanTexture::setLayout(VkCommandBuffer commandBuffer, VkImageLayout newLayout, VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask) {
-		setLayout(commandBuffer, m_ImageLayout, newLayout, srcStageMask, dstStageMask);
+		setLayout(commandBuffer, layout(), newLayout, srcStageMask, dstStageMask);
 	}
 
 	void VulkanTexture::setLayout(VkCommandBuffer commandBuffer, VkImageLayout oldLayout, VkImageLayout newLayout,
 								  VkPipelineStageFlags srcStageMask, VkPipelineStageFlags dstStageMask) {
 
+		VkAccessFlags srcAccess = 0;
+		for(const SubresourceState& state : m_Subresources) {
+			srcAccess |= state.access;
+		}
+
 		// Create an image barrier object
 		VkImageMemoryBarrier imageMemoryBarrier = {};
 		imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -180,8 +218,8 @@ namespace milo {
 		imageMemoryBarrier.newLayout = newLayout;
 		imageMemoryBarrier.image = m_VkImage;
 		imageMemoryBarrier.subresourceRange = m_ViewInfo.subresourceRange;
-		imageMemoryBarrier.srcAccessMask = 0;
-		imageMemoryBarrier.dstAccessMask = 0;
+		imageMemoryBarrier.srcAccessMask = srcAccess;
+		imageMemoryBarrier.dstAccessMask = accessOfLayout(newLayout);
 
 		// Put barrier inside setup command buffer
 		vkCmdPipelineBarrier(
@@ -193,7 +231,167 @@ namespace milo {
 				0, nullptr,
 				1, &imageMemoryBarrier);
 
-		m_ImageLayout = newLayout;
+		setCurrentLayout(newLayout, imageMemoryBarrier.dstAccessMask, dstStageMask);
+	}
+
+	void VulkanTexture::requestLayout(VkImageLayout newLayout, VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) {
+		requestLayout(m_ViewInfo.subresourceRange, newLayout, dstStageMask, dstAccessMask);
+	}
+
+	void VulkanTexture::requestLayout(const VkImageSubresourceRange& range, VkImageLayout newLayout,
+									  VkPipelineStageFlags dstStageMask, VkAccessFlags dstAccessMask) {
+
+		if(m_VkImage == VK_NULL_HANDLE) return;
+
+		std::lock_guard<Mutex> lock(s_PendingMutex);
+
+		if(m_PendingSubresources.empty()) {
+			m_PendingSubresources = m_Subresources;
+			s_PendingTextures.push_back(this);
+		}
+
+		const uint32_t levelCount = range.levelCount == VK_REMAINING_MIP_LEVELS ? m_ImageInfo.mipLevels - range.baseMipLevel : range.levelCount;
+		const uint32_t layerCount = range.layerCount == VK_REMAINING_ARRAY_LAYERS ? m_ImageInfo.arrayLayers - range.baseArrayLayer : range.layerCount;
+
+		for(uint32_t layer = range.baseArrayLayer;layer < range.baseArrayLayer + layerCount;++layer) {
+			for(uint32_t level = range.baseMipLevel;level < range.baseMipLevel + levelCount;++level) {
+				SubresourceState& state = m_PendingSubresources[subresourceIndex(level, layer)];
+				state.layout = newLayout;
+				state.access = dstAccessMask;
+				state.stages = dstStageMask;
+			}
+		}
+	}
+
+	bool VulkanTexture::hasPendingLayout() const {
+		std::lock_guard<Mutex> lock(s_PendingMutex);
+		return !m_PendingSubresources.empty();
+	}
+
+	void VulkanTexture::setCurrentLayout(VkImageLayout layout, VkAccessFlags access, VkPipelineStageFlags stages) {
+		cancelPendingLayout();
+		for(SubresourceState& state : m_Subresources) {
+			state.layout = layout;
+			state.access = access;
+			state.stages = stages;
+		}
+	}
+
+	void VulkanTexture::resetSubresources() {
+		cancelPendingLayout();
+		m_Subresources.clear();
+		m_Subresources.resize(m_ImageInfo.mipLevels * m_ImageInfo.arrayLayers);
+	}
+
+	uint32_t VulkanTexture::subresourceIndex(uint32_t mipLevel, uint32_t arrayLayer) const {
+		return arrayLayer * m_ImageInfo.mipLevels + mipLevel;
+	}
+
+	void VulkanTexture::cancelPendingLayout() {
+		std::lock_guard<Mutex> lock(s_PendingMutex);
+		if(m_PendingSubresources.empty()) return;
+		m_PendingSubresources.clear();
+		s_PendingTextures.erase(std::find(s_PendingTextures.begin(), s_PendingTextures.end(), this));
+	}
+
+	void VulkanTexture::recordPendingBarriers(ArrayList<VkImageMemoryBarrier>& barriers, VkPipelineStageFlags& srcStages,
+											  VkPipelineStageFlags& dstStages) {
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_VkImage;
+		barrier.subresourceRange.aspectMask = m_ViewInfo.subresourceRange.aspectMask;
+		barrier.subresourceRange.layerCount = 1;
+
+		const uint32_t mipLevels = m_ImageInfo.mipLevels;
+
+		// Consecutive levels of a layer going from and to the same states share a barrier. In the common case of an
+		// image transitioned as a whole that is still one barrier per layer
+		for(uint32_t layer = 0;layer < m_ImageInfo.arrayLayers;++layer) {
+			uint32_t level = 0;
+			while(level < mipLevels) {
+
+				const SubresourceState& current = m_Subresources[subresourceIndex(level, layer)];
+				const SubresourceState& target = m_PendingSubresources[subresourceIndex(level, layer)];
+
+				uint32_t end = level + 1;
+				while(end < mipLevels
+					&& m_Subresources[subresourceIndex(end, layer)] == current
+					&& m_PendingSubresources[subresourceIndex(end, layer)] == target) {
+					++end;
+				}
+
+				if(current.layout != target.layout || (current.access | target.access) != 0) {
+					barrier.oldLayout = current.layout;
+					barrier.newLayout = target.layout;
+					barrier.srcAccessMask = current.access;
+					barrier.dstAccessMask = target.access;
+					barrier.subresourceRange.baseMipLevel = level;
+					barrier.subresourceRange.levelCount = end - level;
+					barrier.subresourceRange.baseArrayLayer = layer;
+					barriers.push_back(barrier);
+					srcStages |= current.stages;
+					dstStages |= target.stages;
+				}
+
+				level = end;
+			}
+		}
+
+		m_Subresources = std::move(m_PendingSubresources);
+		m_PendingSubresources.clear();
+	}
+
+	void VulkanTexture::flushPendingBarriers(VkCommandBuffer commandBuffer) {
+
+		ArrayList<VkImageMemoryBarrier> barriers;
+		VkPipelineStageFlags srcStages = 0;
+		VkPipelineStageFlags dstStages = 0;
+		{
+			std::lock_guard<Mutex> lock(s_PendingMutex);
+			if(s_PendingTextures.empty()) return;
+			for(VulkanTexture* texture : s_PendingTextures) {
+				texture->recordPendingBarriers(barriers, srcStages, dstStages);
+			}
+			s_PendingTextures.clear();
+		}
+
+		if(barriers.empty()) return;
+
+		VK_CALLV(vkCmdPipelineBarrier(commandBuffer,
+									  srcStages, dstStages,
+									  0,
+									  0, nullptr,
+									  0, nullptr,
+									  (uint32_t)barriers.size(), barriers.data()));
+	}
+
+	void VulkanTexture::createImage(uint32_t width, uint32_t height, PixelFormat format, uint32_t mipLevels) {
+
+		if(m_VkImage != VK_NULL_HANDLE) {
+			destroy();
+		}
+
+		setImageInfo(width, height, format, mipLevels);
+
+		VK_CALL(vkCreateImage(m_Device->logical(), &m_ImageInfo, nullptr, &m_VkImage));
+
+		resetSubresources();
+	}
+
+	VkMemoryRequirements VulkanTexture::memoryRequirements() const {
+		VkMemoryRequirements requirements{};
+		VK_CALLV(vkGetImageMemoryRequirements(m_Device->logical(), m_VkImage, &requirements));
+		return requirements;
+	}
+
+	void VulkanTexture::bindMemory(VmaAllocation memory) {
+
+		VulkanAllocator::get()->bindImageMemory(memory, m_VkImage);
+
+		createImageView();
 	}
 
 	void VulkanTexture::allocate(uint32_t width, uint32_t height, PixelFormat format, uint32_t mipLevels) {
@@ -206,6 +404,17 @@ namespace milo {
 		vmaAllocInfo.usage = m_Usage;
 		vmaAllocInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
+		setImageInfo(width, height, format, mipLevels);
+
+		VulkanAllocator::get()->allocateImage(m_ImageInfo, vmaAllocInfo, m_VkImage, m_Allocation);
+
+		createImageView();
+
+		resetSubresources();
+	}
+
+	void VulkanTexture::setImageInfo(uint32_t width, uint32_t height, PixelFormat format, uint32_t mipLevels) {
+
 		m_ImageInfo.extent = {width, height, 1};
 		if(mipLevels == AUTO_MIP_LEVELS) {
 			m_ImageInfo.mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
@@ -217,14 +426,13 @@ namespace milo {
 
 		m_ImageInfo.format = mvk::fromPixelFormat(format);
 		m_ViewInfo.format = m_ImageInfo.format;
+	}
 
-		VulkanAllocator::get()->allocateImage(m_ImageInfo, vmaAllocInfo, m_VkImage, m_Allocation);
+	void VulkanTexture::createImageView() {
 
 		m_ViewInfo.image = m_VkImage;
 		VK_CALL(vkCreateImageView(m_Device->logical(), &m_ViewInfo, nullptr, &m_VkImageView));
 
-		m_ImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-
 		if(m_DebugName != nullptr) {
 			setDebugName(*m_DebugName);
 		}
@@ -246,4 +454,64 @@ namespace milo {
 		VK_CALLV(vkCmdCopyBufferToImage(commandBuffer, buffer.vkBuffer(),
 										m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion));
 	}
+
+	uint64_t VulkanTexture::mipLevelsSize(uint32_t mipLevels) const {
+
+		const uint64_t pixelSize = PixelFormats::size(mvk::toPixelFormat(m_ImageInfo.format));
+
+		uint64_t size = 0;
+		for(uint32_t i = 0;i < std::min(mipLevels, m_ImageInfo.mipLevels);++i) {
+			const uint64_t width = std::max(m_ImageInfo.extent.width >> i, 1u);
+			const uint64_t height = std::max(m_ImageInfo.extent.height >> i, 1u);
+			size += width * height * m_ImageInfo.arrayLayers * pixelSize;
+		}
+
+		return size;
+	}
+
+	void VulkanTexture::copyMipLevelsToBuffer(VkCommandBuffer commandBuffer, VulkanBuffer& buffer, uint32_t mipLevels) const {
+
+		ArrayList<VkBufferImageCopy> regions = mipLevelCopyRegions(mipLevels);
+
+		VK_CALLV(vkCmdCopyImageToBuffer(commandBuffer, m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+										buffer.vkBuffer(), regions.size(), regions.data()));
+	}
+
+	void VulkanTexture::copyMipLevelsFromBuffer(VkCommandBuffer commandBuffer, VulkanBuffer& buffer, uint32_t mipLevels) {
+
+		ArrayList<VkBufferImageCopy> regions = mipLevelCopyRegions(mipLevels);
+
+		VK_CALLV(vkCmdCopyBufferToImage(commandBuffer, buffer.vkBuffer(), m_VkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+										regions.size(), regions.data()));
+	}
+
+	ArrayList<VkBufferImageCopy> VulkanTexture::mipLevelCopyRegions(uint32_t mipLevels) const {
+
+		const uint64_t pixelSize = PixelFormats::size(mvk::toPixelFormat(m_ImageInfo.format));
+
+		ArrayList<VkBufferImageCopy> regions;
+		regions.reserve(mipLevels);
+
+		uint64_t offset = 0;
+
+		for(uint32_t i = 0;i < std::min(mipLevels, m_ImageInfo.mipLevels);++i) {
+
+			const uint32_t width = std::max(m_ImageInfo.extent.width >> i, 1u);
+			const uint32_t height = std::max(m_ImageInfo.extent.height >> i, 1u);
+
+			VkBufferImageCopy region{};
+			region.bufferOffset = offset;
+			region.imageSubresource.aspectMask = m_ViewInfo.subresourceRange.aspectMask;
+			region.imageSubresource.mipLevel = i;
+			region.imageSubresource.baseArrayLayer = 0;
+			region.imageSubresource.layerCount = m_ImageInfo.arrayLayers;
+			region.imageExtent = {width, height, 1};
+
+			regions.push_back(region);
+
+			offset += (uint64_t)width * height * m_ImageInfo.arrayLayers * pixelSize;
+		}
+
+		return regions;
+	}
 }
\ No newline at end of file
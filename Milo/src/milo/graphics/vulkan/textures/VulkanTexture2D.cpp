@@ -57,7 +57,7 @@ namespace milo {
 			barrier.image = m_VkImage;
 			barrier.subresourceRange = m_ViewInfo.subresourceRange;
 
-			barrier.oldLayout = m_ImageLayout;
+			barrier.oldLayout = layout();
 			barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 			barrier.srcAccessMask = 0;
 			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
@@ -73,7 +73,7 @@ namespace milo {
 
 			transitionLayout(commandBuffer, barrier, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-			m_ImageLayout = barrier.newLayout;
+			setCurrentLayout(barrier.newLayout, 0, VK_PIPELINE_STAGE_TRANSFER_BIT);
 		};
 
 		m_Device->transferCommandPool()->execute(task);
@@ -107,8 +107,8 @@ namespace milo {
 			barrier.subresourceRange = m_ViewInfo.subresourceRange;
 
 			// Transition all levels to DST OPTIMAL
-			if(m_ImageLayout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-				barrier.oldLayout = m_ImageLayout;
+			if(layout() != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
+				barrier.oldLayout = layout();
 				barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
 				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
 				barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
@@ -181,7 +181,7 @@ namespace milo {
 								 0, nullptr,
 								 1, &barrier));
 
-			m_ImageLayout = barrier.newLayout;
+			setCurrentLayout(barrier.newLayout, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
 		};
 
 		m_Device->graphicsCommandPool()->execute(task);
@@ -214,6 +214,10 @@ namespace milo {
 		m_ViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
 	}
 
+	VulkanTexture2DArray::~VulkanTexture2DArray() {
+		VulkanTexture2DArray::destroy();
+	}
+
 	uint32_t VulkanTexture2DArray::numLayers() const {
 		return m_Layers.size();
 	}
@@ -226,6 +230,17 @@ namespace milo {
 
 		VulkanTexture2D::allocate(allocInfo);
 
+		createLayerViews();
+	}
+
+	void VulkanTexture2DArray::bindMemory(VmaAllocation memory) {
+
+		VulkanTexture2D::bindMemory(memory);
+
+		createLayerViews();
+	}
+
+	void VulkanTexture2DArray::createLayerViews() {
 		for(uint32_t i = 0;i < m_Layers.size();++i) {
 			VkImageViewCreateInfo layerInfo = m_ViewInfo;
 			layerInfo.subresourceRange.baseArrayLayer = i;
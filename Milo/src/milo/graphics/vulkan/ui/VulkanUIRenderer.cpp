@@ -61,6 +61,8 @@ namespace milo {
 
 	void VulkanUIRenderer::begin() {
 
+		MILO_MEMORY_TAG(MemoryTag::UI);
+
 		VulkanSwapchain* swapchain = VulkanContext::get()->swapchain();
 		Size size = swapchain->size();
 
@@ -75,11 +77,15 @@ namespace milo {
 		//ImGuizmo::BeginFrame();
 
 		auto texture = dynamic_cast<VulkanTexture2D*>(WorldRenderer::get().getFramebuffer().colorAttachments()[0]);
-		texture->setLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		// The world passes leave it as a color attachment. The transition is recorded in end(), with the rest of the UI textures
+		texture->setCurrentLayout(VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		texture->requestLayout(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
 	}
 
 	void VulkanUIRenderer::end() {
 
+		MILO_MEMORY_TAG(MemoryTag::UI);
+
 		ImGui::Render();
 
 		VulkanDevice* device = VulkanContext::get()->device();
@@ -101,6 +107,8 @@ namespace milo {
 
 		VK_CALL(vkBeginCommandBuffer(commandBuffer, &drawCmdBufInfo));
 		{
+			VulkanTexture::flushPendingBarriers(commandBuffer);
+
 			VkRenderPassBeginInfo renderPassBeginInfo = {};
 			renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
 			renderPassBeginInfo.pNext = nullptr;
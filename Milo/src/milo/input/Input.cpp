@@ -68,10 +68,13 @@ namespace milo {
 	}
 
 	CursorMode Input::cursorMode() {
+		if(Window::get() == nullptr) return CursorMode::Normal;
 		return Window::get()->cursorMode();
 	}
 
 	void Input::setCursorMode(CursorMode mode) {
+		// There is no cursor in headless mode
+		if(Window::get() == nullptr) return;
 		Window::get()->cursorMode(mode);
 	}
 
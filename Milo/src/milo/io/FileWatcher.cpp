@@ -0,0 +1,147 @@
+#include "milo/io/FileWatcher.h"
+#include "milo/io/Files.h"
+#include "milo/time/Time.h"
+#include "milo/logging/Log.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace milo {
+
+	// Seconds a file must go without changes before it is reported
+	static const float SETTLE_TIME = 0.15f;
+	// Milliseconds the background thread blocks before checking if it must stop
+	static const int32_t WAIT_TIMEOUT = 100;
+
+	Thread FileWatcher::s_Thread;
+	AtomicBool FileWatcher::s_Running{false};
+	int32_t FileWatcher::s_Handle{-1};
+	HashMap<int32_t, String> FileWatcher::s_Directories;
+	HashMap<String, float> FileWatcher::s_Changes;
+	Mutex FileWatcher::s_Mutex;
+
+	bool FileWatcher::supported() {
+#ifdef __linux__
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	void FileWatcher::watch(const String& directory) {
+
+		if(s_Handle < 0 || !Files::isDirectory(directory)) return;
+
+		std::lock_guard<Mutex> lock(s_Mutex);
+
+		addWatch(Files::toAbsolutePath(directory));
+
+		std::error_code error;
+		for(auto it = std::filesystem::recursive_directory_iterator(directory, error);it != std::filesystem::recursive_directory_iterator();it.increment(error)) {
+			if(error) break;
+			if(it->is_directory()) addWatch(Files::toAbsolutePath(it->path().string()));
+		}
+	}
+
+	ArrayList<String> FileWatcher::poll() {
+
+		ArrayList<String> files;
+
+		std::lock_guard<Mutex> lock(s_Mutex);
+
+		const float now = Time::now();
+
+		for(auto it = s_Changes.begin();it != s_Changes.end();) {
+			if(now - it->second >= SETTLE_TIME) {
+				files.push_back(it->first);
+				it = s_Changes.erase(it);
+			} else {
+				++it;
+			}
+		}
+
+		return files;
+	}
+
+	void FileWatcher::init() {
+#ifdef __linux__
+		s_Handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if(s_Handle < 0) {
+			Log::warn("File watching is not available: inotify_init1 failed with error {}", errno);
+			return;
+		}
+		s_Running = true;
+		s_Thread = Thread(&FileWatcher::run);
+#else
+		Log::info("File watching is not supported on this platform");
+#endif
+	}
+
+	void FileWatcher::shutdown() {
+		s_Running = false;
+		if(s_Thread.joinable()) s_Thread.join();
+#ifdef __linux__
+		if(s_Handle >= 0) close(s_Handle);
+#endif
+		s_Handle = -1;
+		s_Directories.clear();
+		s_Changes.clear();
+	}
+
+	void FileWatcher::run() {
+#ifdef __linux__
+		alignas(struct inotify_event) char buffer[16 * 1024];
+
+		while(s_Running) {
+
+			struct pollfd descriptor{s_Handle, POLLIN, 0};
+			if(::poll(&descriptor, 1, WAIT_TIMEOUT) <= 0) continue;
+
+			const ssize_t length = read(s_Handle, buffer, sizeof(buffer));
+			if(length <= 0) continue;
+
+			std::lock_guard<Mutex> lock(s_Mutex);
+
+			const float now = Time::now();
+
+			for(ssize_t offset = 0;offset < length;) {
+
+				const auto* event = (const struct inotify_event*)(buffer + offset);
+				offset += (ssize_t)(sizeof(struct inotify_event) + event->len);
+
+				if(event->mask & IN_IGNORED) {
+					s_Directories.erase(event->wd);
+					continue;
+				}
+
+				auto directory = s_Directories.find(event->wd);
+				if(directory == s_Directories.end() || event->len == 0) continue;
+
+				const String path = directory->second + "/" + event->name;
+
+				if(event->mask & IN_ISDIR) {
+					if(event->mask & (IN_CREATE | IN_MOVED_TO)) addWatch(path);
+					continue;
+				}
+
+				s_Changes[path] = now;
+			}
+		}
+#endif
+	}
+
+	void FileWatcher::addWatch(const String& directory) {
+#ifdef __linux__
+		// Files replaced by renaming a temporary one over them, as many editors do, report IN_MOVED_TO instead of IN_CLOSE_WRITE
+		const int32_t wd = inotify_add_watch(s_Handle, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if(wd < 0) {
+			Log::warn("Failed to watch directory {}: error {}", directory, errno);
+			return;
+		}
+		s_Directories[wd] = directory;
+#endif
+	}
+}
\ No newline at end of file
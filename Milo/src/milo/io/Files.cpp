@@ -143,4 +143,29 @@ namespace milo {
 			outputStream << line << '\n';
 		}
 	}
+
+	bool Files::writeAtomically(const String& filename, const Function<void, OutputStream&>& write) {
+
+		const String parent = parentOf(filename);
+		if(!parent.empty()) createDirectory(parent);
+
+		const String tmpFilename = filename + ".tmp";
+		{
+			OutputStream output(tmpFilename, std::ios::binary | std::ios::trunc);
+			if(output) write(output);
+			if(!output) {
+				Log::error("Failed to write {}", filename);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tmpFilename, filename, error);
+		if(error) {
+			Log::error("Failed to write {}: {}", filename, error.message());
+			return false;
+		}
+
+		return true;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,98 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "milo/io/MappedFile.h"
+#include "milo/logging/Log.h"
+
+namespace milo {
+
+#ifdef _WIN32
+
+	MappedFile::MappedFile(const String& filename) {
+
+		HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if(file == INVALID_HANDLE_VALUE) {
+			Log::error("Failed to open {}", filename);
+			return;
+		}
+		m_File = file;
+
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+			unmap();
+			return;
+		}
+
+		m_Mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(m_Mapping == nullptr) {
+			Log::error("Failed to map {}", filename);
+			unmap();
+			return;
+		}
+
+		m_Data = (const byte_t*) MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+		m_Size = m_Data != nullptr ? (uint64_t)size.QuadPart : 0;
+	}
+
+	void MappedFile::unmap() {
+		if(m_Data != nullptr) UnmapViewOfFile(m_Data);
+		if(m_Mapping != nullptr) CloseHandle(m_Mapping);
+		if(m_File != nullptr) CloseHandle(m_File);
+		m_Data = nullptr;
+		m_Mapping = nullptr;
+		m_File = nullptr;
+		m_Size = 0;
+	}
+
+#else
+
+	MappedFile::MappedFile(const String& filename) {
+
+		m_File = open(filename.c_str(), O_RDONLY);
+		if(m_File < 0) {
+			Log::error("Failed to open {}", filename);
+			return;
+		}
+
+		struct stat info{};
+		if(fstat(m_File, &info) != 0 || info.st_size == 0) {
+			unmap();
+			return;
+		}
+
+		void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, m_File, 0);
+		if(data == MAP_FAILED) {
+			Log::error("Failed to map {}", filename);
+			unmap();
+			return;
+		}
+
+		// The whole file is going to be read front to back
+		madvise(data, (size_t)info.st_size, MADV_SEQUENTIAL | MADV_WILLNEED);
+
+		m_Data = (const byte_t*) data;
+		m_Size = (uint64_t)info.st_size;
+	}
+
+	void MappedFile::unmap() {
+		if(m_Data != nullptr) munmap((void*)m_Data, (size_t)m_Size);
+		if(m_File >= 0) close(m_File);
+		m_Data = nullptr;
+		m_File = -1;
+		m_Size = 0;
+	}
+
+#endif
+
+	MappedFile::~MappedFile() {
+		unmap();
+	}
+}
\ No newline at end of file
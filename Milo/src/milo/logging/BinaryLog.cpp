@@ -0,0 +1,198 @@
+#include "milo/logging/BinaryLog.h"
+#include <spdlog/fmt/bundled/args.h>
+
+namespace milo {
+
+	template<typename T>
+	static void append(ArrayList<byte_t>& buffer, const T& value) {
+		const auto* bytes = (const byte_t*)&value;
+		buffer.insert(buffer.end(), bytes, bytes + sizeof(T));
+	}
+
+	BinaryLogSink::BinaryLogSink(String filename) : m_Filename(std::move(filename)) {
+
+		const String parent = Files::parentOf(m_Filename);
+		if(!parent.empty()) Files::createDirectory(parent);
+
+		m_Output.open(m_Filename, std::ios::binary | std::ios::trunc);
+
+		const uint32_t header[2] = {MAGIC, VERSION};
+		m_Output.write((const char*)header, sizeof(header));
+
+		m_Buffer.reserve(1024);
+	}
+
+	BinaryLogSink::~BinaryLogSink() {
+		flush();
+	}
+
+	const String& BinaryLogSink::filename() const {
+		return m_Filename;
+	}
+
+	bool BinaryLogSink::isOpen() const {
+		return m_Output.is_open() && m_Output.good();
+	}
+
+	void BinaryLogSink::write(const LogRecord& record) {
+
+		m_Buffer.clear();
+
+		const uint32_t formatId = formatIdOf(record.format);
+
+		append(m_Buffer, BinaryLogEntry::Message);
+		append(m_Buffer, record.time);
+		append(m_Buffer, (uint8_t)record.level);
+		append(m_Buffer, record.threadId);
+		append(m_Buffer, formatId);
+		append(m_Buffer, record.argumentCount);
+
+		LogArgumentWriter writer(m_Buffer);
+		record.serialize(writer);
+
+		m_Output.write((const char*)m_Buffer.data(), (std::streamsize)m_Buffer.size());
+	}
+
+	void BinaryLogSink::flush() {
+		m_Output.flush();
+	}
+
+	uint32_t BinaryLogSink::formatIdOf(fmt::string_view format) {
+
+		auto it = m_FormatIds.find(format.data());
+		if(it != m_FormatIds.end()) return it->second;
+
+		const auto id = (uint32_t)m_FormatIds.size();
+		const auto length = (uint32_t)format.size();
+		m_FormatIds[format.data()] = id;
+
+		// Written before the first message that uses it, so the decoder always knows the format of a message
+		append(m_Buffer, BinaryLogEntry::Format);
+		append(m_Buffer, id);
+		append(m_Buffer, length);
+		m_Buffer.insert(m_Buffer.end(), format.data(), format.data() + format.size());
+
+		return id;
+	}
+
+	template<typename T>
+	static bool readValue(InputStream& input, T& value) {
+		input.read((char*)&value, sizeof(T));
+		return (bool)input;
+	}
+
+	static bool readString(InputStream& input, String& value) {
+		uint32_t length = 0;
+		if(!readValue(input, length)) return false;
+		value.resize(length);
+		input.read(value.data(), length);
+		return (bool)input;
+	}
+
+	static bool readArgument(InputStream& input, fmt::dynamic_format_arg_store<fmt::format_context>& arguments) {
+
+		LogArgumentType type;
+		if(!readValue(input, type)) return false;
+
+		switch(type) {
+			case LogArgumentType::Int: {
+				int64_t value;
+				if(!readValue(input, value)) return false;
+				arguments.push_back(value);
+				return true;
+			}
+			case LogArgumentType::UInt: {
+				uint64_t value;
+				if(!readValue(input, value)) return false;
+				arguments.push_back(value);
+				return true;
+			}
+			case LogArgumentType::Float: {
+				float value;
+				if(!readValue(input, value)) return false;
+				arguments.push_back(value);
+				return true;
+			}
+			case LogArgumentType::Double: {
+				double value;
+				if(!readValue(input, value)) return false;
+				arguments.push_back(value);
+				return true;
+			}
+			case LogArgumentType::Bool: {
+				uint8_t value;
+				if(!readValue(input, value)) return false;
+				arguments.push_back(value != 0);
+				return true;
+			}
+			case LogArgumentType::Char: {
+				char value;
+				if(!readValue(input, value)) return false;
+				arguments.push_back(value);
+				return true;
+			}
+			case LogArgumentType::String: {
+				String value;
+				if(!readString(input, value)) return false;
+				arguments.push_back(std::move(value));
+				return true;
+			}
+		}
+
+		throw MILO_RUNTIME_EXCEPTION(fmt::format("Unknown log argument type {}", (uint32_t)type));
+	}
+
+	void BinaryLogReader::read(const String& filename, const Function<void, const DecodedLogMessage&>& callback) {
+
+		InputStream input(filename, std::ios::binary);
+		if(!input) throw MILO_RUNTIME_EXCEPTION(str("Failed to open ") + filename);
+
+		uint32_t header[2]{};
+		input.read((char*)header, sizeof(header));
+
+		if(!input || header[0] != BinaryLogSink::MAGIC) throw MILO_RUNTIME_EXCEPTION(filename + " is not a binary log");
+		if(header[1] != BinaryLogSink::VERSION) {
+			throw MILO_RUNTIME_EXCEPTION(fmt::format("{} has version {}, expected {}", filename, header[1], BinaryLogSink::VERSION));
+		}
+
+		HashMap<uint32_t, String> formats;
+		DecodedLogMessage message;
+
+		BinaryLogEntry entry;
+		while(readValue(input, entry)) {
+
+			if(entry == BinaryLogEntry::Format) {
+				uint32_t id;
+				String format;
+				if(!readValue(input, id) || !readString(input, format)) return;
+				formats[id] = std::move(format);
+				continue;
+			}
+
+			if(entry != BinaryLogEntry::Message) {
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("Unknown log entry {} in {}", (uint32_t)entry, filename));
+			}
+
+			uint8_t level;
+			uint32_t formatId;
+			uint8_t argumentCount;
+			if(!readValue(input, message.time) || !readValue(input, level) || !readValue(input, message.threadId)
+			   || !readValue(input, formatId) || !readValue(input, argumentCount)) return;
+
+			fmt::dynamic_format_arg_store<fmt::format_context> arguments;
+			for(uint8_t i = 0;i < argumentCount;++i) {
+				if(!readArgument(input, arguments)) return;
+			}
+
+			auto format = formats.find(formatId);
+			if(format == formats.end()) {
+				throw MILO_RUNTIME_EXCEPTION(fmt::format("Message with undefined format {} in {}", formatId, filename));
+			}
+
+			message.level = (spdlog::level::level_enum)level;
+			message.message = fmt::vformat(format->second, arguments);
+
+			callback(message);
+		}
+	}
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "milo/logging/Log.h"
+#include "milo/logging/BinaryLog.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
 namespace milo {
@@ -9,6 +10,18 @@ namespace milo {
 #else
 	Log::Level Log::s_Level = Log::Level::Info;
 #endif
+	AtomicBool Log::s_Deferred{false};
+	Atomic<LogRingBuffer*> Log::s_RingBuffer{nullptr};
+	AtomicUInt Log::s_RingBufferUsers{0};
+	Log::OverflowPolicy Log::s_OverflowPolicy{Log::OverflowPolicy::Drop};
+	Atomic<uint64_t> Log::s_DroppedCount{0};
+	AtomicBool Log::s_Running{false};
+	AtomicBool Log::s_LoggingThreadSleeping{false};
+	Mutex Log::s_LoggingThreadMutex;
+	std::condition_variable Log::s_MessagePushed;
+	Thread Log::s_Thread;
+	BinaryLogSink* Log::s_BinaryLog{nullptr};
+	Mutex Log::s_BinaryLogMutex;
 
 	Log::Level Log::level() {
 		return s_Level;
@@ -20,21 +33,182 @@ namespace milo {
 	}
 
 	void Log::info(const String& message) {
-		milo::Log::s_Logger->info(message);
+		submit(spdlog::level::info, "{}", message);
 	}
 
 #ifdef _DEBUG
 	void Log::debug(const String& message) {
-		milo::Log::s_Logger->debug(message);
+		submit(spdlog::level::debug, "{}", message);
 	}
 #endif
 
 	void Log::warn(const String& message) {
-		milo::Log::s_Logger->warn(message);
+		submit(spdlog::level::warn, "{}", message);
 	}
 
 	void Log::error(const String& message) {
-		milo::Log::s_Logger->error(message);
+		submit(spdlog::level::err, "{}", message);
+	}
+
+	void Log::startAsync(size_t capacity, OverflowPolicy policy) {
+
+		stopAsync();
+
+		auto* ringBuffer = new LogRingBuffer(capacity);
+		s_OverflowPolicy = policy;
+		s_DroppedCount = 0;
+		s_Running = true;
+		s_Thread = Thread(&Log::run, ringBuffer);
+		s_RingBuffer = ringBuffer;
+		s_Deferred = true;
+	}
+
+	void Log::stopAsync() {
+
+		LogRingBuffer* ringBuffer = s_RingBuffer.exchange(nullptr);
+		if(ringBuffer == nullptr) return;
+
+		s_Deferred = s_BinaryLog != nullptr;
+
+		// Callers that loaded the ring buffer before finish their push. The logging thread still makes room for blocked ones
+		while(s_RingBufferUsers.load() != 0) {
+			std::this_thread::yield();
+		}
+
+		s_Running = false;
+		{
+			std::lock_guard<Mutex> lock(s_LoggingThreadMutex);
+			s_LoggingThreadSleeping = false;
+		}
+		s_MessagePushed.notify_one();
+
+		if(s_Thread.joinable()) s_Thread.join();
+
+		DELETE_PTR(ringBuffer);
+	}
+
+	bool Log::async() {
+		return s_RingBuffer.load(std::memory_order_relaxed) != nullptr;
+	}
+
+	uint64_t Log::droppedCount() {
+		return s_DroppedCount.load(std::memory_order_relaxed);
+	}
+
+	bool Log::openBinaryLog(const String& filename) {
+
+		closeBinaryLog();
+
+		auto* sink = new BinaryLogSink(filename);
+		if(!sink->isOpen()) {
+			DELETE_PTR(sink);
+			s_Logger->error("Failed to create binary log {}", filename);
+			return false;
+		}
+
+		{
+			std::lock_guard<Mutex> lock(s_BinaryLogMutex);
+			s_BinaryLog = sink;
+		}
+		s_Deferred = true;
+
+		return true;
+	}
+
+	void Log::closeBinaryLog() {
+
+		flush();
+
+		std::lock_guard<Mutex> lock(s_BinaryLogMutex);
+		DELETE_PTR(s_BinaryLog);
+		s_Deferred = s_RingBuffer.load() != nullptr;
+	}
+
+	void Log::flush() {
+
+		s_RingBufferUsers.fetch_add(1);
+		if(LogRingBuffer* ringBuffer = s_RingBuffer.load()) {
+			while(!ringBuffer->empty()) {
+				std::this_thread::yield();
+			}
+		}
+		s_RingBufferUsers.fetch_sub(1, std::memory_order_release);
+
+		{
+			std::lock_guard<Mutex> lock(s_BinaryLogMutex);
+			if(s_BinaryLog != nullptr) s_BinaryLog->flush();
+		}
+
+		s_Logger->flush();
+	}
+
+	uint32_t Log::threadId() {
+		static AtomicUInt nextThreadId{0};
+		thread_local uint32_t id = nextThreadId++;
+		return id;
+	}
+
+	void Log::process(const LogRecord& record) {
+
+		{
+			std::lock_guard<Mutex> lock(s_BinaryLogMutex);
+			if(s_BinaryLog != nullptr) s_BinaryLog->write(record);
+		}
+
+		fmt::memory_buffer message;
+		try {
+			record.formatTo(message);
+		} catch(const Exception& e) {
+			message.clear();
+			fmt::format_to(fmt::appender(message), "Failed to format \"{}\": {}", record.format, e.what());
+		}
+
+		const auto time = spdlog::log_clock::time_point(
+				std::chrono::duration_cast<spdlog::log_clock::duration>(std::chrono::nanoseconds(record.time)));
+
+		s_Logger->log(time, spdlog::source_loc{}, record.level, spdlog::string_view_t(message.data(), message.size()));
+	}
+
+	void Log::wakeLoggingThread() {
+		{
+			std::lock_guard<Mutex> lock(s_LoggingThreadMutex);
+			s_LoggingThreadSleeping = false;
+		}
+		s_MessagePushed.notify_one();
+	}
+
+	void Log::run(LogRingBuffer* ringBuffer) {
+
+		uint64_t reportedDrops = 0;
+
+		while(true) {
+
+			// Read before draining, so whatever was pushed before stopAsync() is written
+			const bool running = s_Running.load(std::memory_order_acquire);
+
+			size_t count = 0;
+			while(ringBuffer->tryPop(&Log::process)) {
+				++count;
+			}
+
+			if(const uint64_t dropped = s_DroppedCount.load(std::memory_order_relaxed); dropped > reportedDrops) {
+				s_Logger->warn("{} log messages were dropped because the logging thread could not keep up", dropped - reportedDrops);
+				reportedDrops = dropped;
+			}
+
+			if(count > 0) continue;
+			if(!running) return;
+
+			// Sleeps until a producer pushes a record or stopAsync() is called
+			std::unique_lock<Mutex> lock(s_LoggingThreadMutex);
+			s_LoggingThreadSleeping.store(true, std::memory_order_relaxed);
+			// Pairs with the fence in notifyLoggingThread()
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if(ringBuffer->empty() && s_Running.load(std::memory_order_relaxed)) {
+				s_MessagePushed.wait(lock, [] { return !s_LoggingThreadSleeping.load(std::memory_order_relaxed); });
+			}
+			s_LoggingThreadSleeping.store(false, std::memory_order_relaxed);
+		}
 	}
 
 	void Log::init() {
@@ -46,5 +220,7 @@ namespace milo {
 	}
 
 	void Log::shutdown() {
+		stopAsync();
+		closeBinaryLog();
 	}
 }
\ No newline at end of file
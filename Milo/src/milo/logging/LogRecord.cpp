@@ -0,0 +1,72 @@
+#include "milo/logging/LogRecord.h"
+
+namespace milo {
+
+	LogArgumentWriter::LogArgumentWriter(ArrayList<byte_t>& buffer) : m_Buffer(buffer) {
+	}
+
+	void LogArgumentWriter::write(const void* data, size_t size) {
+		const auto* bytes = (const byte_t*)data;
+		m_Buffer.insert(m_Buffer.end(), bytes, bytes + size);
+	}
+
+	void LogArgumentWriter::writeInt(int64_t value) {
+		const auto type = LogArgumentType::Int;
+		write(&type, sizeof(type));
+		write(&value, sizeof(value));
+	}
+
+	void LogArgumentWriter::writeUInt(uint64_t value) {
+		const auto type = LogArgumentType::UInt;
+		write(&type, sizeof(type));
+		write(&value, sizeof(value));
+	}
+
+	void LogArgumentWriter::writeFloat(float value) {
+		const auto type = LogArgumentType::Float;
+		write(&type, sizeof(type));
+		write(&value, sizeof(value));
+	}
+
+	void LogArgumentWriter::writeDouble(double value) {
+		const auto type = LogArgumentType::Double;
+		write(&type, sizeof(type));
+		write(&value, sizeof(value));
+	}
+
+	void LogArgumentWriter::writeBool(bool value) {
+		const auto type = LogArgumentType::Bool;
+		const uint8_t byte = value ? 1 : 0;
+		write(&type, sizeof(type));
+		write(&byte, sizeof(byte));
+	}
+
+	void LogArgumentWriter::writeChar(char value) {
+		const auto type = LogArgumentType::Char;
+		write(&type, sizeof(type));
+		write(&value, sizeof(value));
+	}
+
+	void LogArgumentWriter::writeString(fmt::string_view value) {
+		const auto type = LogArgumentType::String;
+		const auto length = (uint32_t)value.size();
+		write(&type, sizeof(type));
+		write(&length, sizeof(length));
+		write(value.data(), value.size());
+	}
+
+	void LogRecord::formatTo(fmt::memory_buffer& output) const {
+		formatFunction(*this, output);
+	}
+
+	void LogRecord::serialize(LogArgumentWriter& writer) const {
+		serializeFunction(*this, writer);
+	}
+
+	void LogRecord::destroy() {
+		if(destroyFunction != nullptr) destroyFunction(*this);
+		formatFunction = nullptr;
+		serializeFunction = nullptr;
+		destroyFunction = nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "milo/logging/LogRingBuffer.h"
+
+namespace milo {
+
+	static size_t nextPowerOfTwo(size_t value) {
+		size_t result = 2;
+		while(result < value) result <<= 1;
+		return result;
+	}
+
+	LogRingBuffer::LogRingBuffer(size_t capacity) {
+
+		const size_t size = nextPowerOfTwo(capacity);
+
+		m_Slots = new Slot[size];
+		m_Mask = size - 1;
+
+		for(size_t i = 0;i < size;++i) {
+			m_Slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	LogRingBuffer::~LogRingBuffer() {
+		DELETE_ARRAY(m_Slots);
+	}
+
+	size_t LogRingBuffer::capacity() const {
+		return m_Mask + 1;
+	}
+
+	bool LogRingBuffer::empty() const {
+		return m_ReadPosition.load(std::memory_order_acquire) == m_WritePosition.load(std::memory_order_acquire);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,561 @@
+#include "milo/math/BoundingVolumeFitting.h"
+#include "milo/common/JobSystem.h"
+
+// Foundations of Game Engine Development Volume 2: Rendering, pages 240-253.
+// Every pass keeps LANES independent accumulators, written as selects instead of branches, so the compiler can keep
+// them in vector registers. Results are reduced in vertex order, so they do not depend on the number of threads
+namespace milo {
+
+	static constexpr size_t LANES = 8;
+	// Minimum vertices per job. Smaller streams are processed by the calling thread
+	static constexpr size_t CHUNK_SIZE = 32 * 1024;
+
+	// Min and max of the projections of the positions onto a direction, and the first vertices where they are found
+	struct Extent {
+
+		float min{FLT_MAX};
+		float max{-FLT_MAX};
+		uint32_t imin{0};
+		uint32_t imax{0};
+
+		inline void merge(float otherMin, uint32_t otherIMin, float otherMax, uint32_t otherIMax) {
+			if(otherMin < min || (otherMin == min && otherIMin < imin)) {
+				min = otherMin;
+				imin = otherIMin;
+			}
+			if(otherMax > max || (otherMax == max && otherIMax < imax)) {
+				max = otherMax;
+				imax = otherIMax;
+			}
+		}
+	};
+
+	PositionStream PositionStream::of(const ArrayList<Vertex>& vertices, const ArrayList<uint32_t>& indices) {
+
+		PositionStream stream;
+
+		ArrayList<uint8_t> referenced;
+		size_t count = vertices.size();
+
+		if(!indices.empty()) {
+			referenced.resize(vertices.size(), 0);
+			for(uint32_t index : indices) {
+				if(index < vertices.size()) referenced[index] = 1;
+			}
+			count = 0;
+			for(uint8_t r : referenced) count += r;
+		}
+
+		stream.x.resize(count);
+		stream.y.resize(count);
+		stream.z.resize(count);
+
+		size_t j = 0;
+		for(size_t i = 0;i < vertices.size();++i) {
+			if(!referenced.empty() && referenced[i] == 0) continue;
+			const Vector3& position = vertices[i].position;
+			stream.x[j] = position.x;
+			stream.y[j] = position.y;
+			stream.z[j] = position.z;
+			++j;
+		}
+
+		return stream;
+	}
+
+	static void projectExtents(const PositionStream& positions, const Vector3* directions, uint32_t count,
+							   size_t begin, size_t end, Extent* extents) {
+
+		const float* x = positions.x.data();
+		const float* y = positions.y.data();
+		const float* z = positions.z.data();
+
+		for(uint32_t j = 0;j < count;++j) {
+
+			const float dx = directions[j].x;
+			const float dy = directions[j].y;
+			const float dz = directions[j].z;
+
+			float lmin[LANES];
+			float lmax[LANES];
+			uint32_t limin[LANES];
+			uint32_t limax[LANES];
+
+			for(size_t l = 0;l < LANES;++l) {
+				lmin[l] = FLT_MAX;
+				lmax[l] = -FLT_MAX;
+				limin[l] = limax[l] = (uint32_t)begin;
+			}
+
+			size_t i = begin;
+
+			for(;i + LANES <= end;i += LANES) {
+				for(size_t l = 0;l < LANES;++l) {
+					const float d = dx * x[i + l] + dy * y[i + l] + dz * z[i + l];
+					const uint32_t index = (uint32_t)(i + l);
+					const bool less = d < lmin[l];
+					const bool greater = d > lmax[l];
+					lmin[l] = less ? d : lmin[l];
+					limin[l] = less ? index : limin[l];
+					lmax[l] = greater ? d : lmax[l];
+					limax[l] = greater ? index : limax[l];
+				}
+			}
+
+			Extent& extent = extents[j];
+			for(size_t l = 0;l < LANES;++l) {
+				extent.merge(lmin[l], limin[l], lmax[l], limax[l]);
+			}
+
+			for(;i < end;++i) {
+				const float d = dx * x[i] + dy * y[i] + dz * z[i];
+				extent.merge(d, (uint32_t)i, d, (uint32_t)i);
+			}
+		}
+	}
+
+	static void projectRanges(const PositionStream& positions, const Vector3* directions, uint32_t count,
+							  size_t begin, size_t end, Range<float>* ranges) {
+
+		const float* x = positions.x.data();
+		const float* y = positions.y.data();
+		const float* z = positions.z.data();
+
+		for(uint32_t j = 0;j < count;++j) {
+
+			const float dx = directions[j].x;
+			const float dy = directions[j].y;
+			const float dz = directions[j].z;
+
+			float lmin[LANES];
+			float lmax[LANES];
+
+			for(size_t l = 0;l < LANES;++l) {
+				lmin[l] = FLT_MAX;
+				lmax[l] = -FLT_MAX;
+			}
+
+			size_t i = begin;
+
+			for(;i + LANES <= end;i += LANES) {
+				for(size_t l = 0;l < LANES;++l) {
+					const float d = dx * x[i + l] + dy * y[i + l] + dz * z[i + l];
+					lmin[l] = d < lmin[l] ? d : lmin[l];
+					lmax[l] = d > lmax[l] ? d : lmax[l];
+				}
+			}
+
+			for(;i < end;++i) {
+				const float d = dx * x[i] + dy * y[i] + dz * z[i];
+				lmin[0] = d < lmin[0] ? d : lmin[0];
+				lmax[0] = d > lmax[0] ? d : lmax[0];
+			}
+
+			Range<float>& range = ranges[j];
+			for(size_t l = 0;l < LANES;++l) {
+				range.min = std::min(range.min, lmin[l]);
+				range.max = std::max(range.max, lmax[l]);
+			}
+		}
+	}
+
+	// Index of the first position furthest from the line that goes through origin with the given direction
+	static void projectFarthestFromLine(const PositionStream& positions, const Vector3& origin, const Vector3& direction,
+										size_t begin, size_t end, float& distance2, uint32_t& farthest) {
+
+		const float* x = positions.x.data();
+		const float* y = positions.y.data();
+		const float* z = positions.z.data();
+
+		float lmax[LANES];
+		uint32_t limax[LANES];
+
+		for(size_t l = 0;l < LANES;++l) {
+			lmax[l] = -FLT_MAX;
+			limax[l] = (uint32_t)begin;
+		}
+
+		// |cross(q - p, v)|^2 is enough to compare distances to the line
+		auto distanceOf = [&](size_t i) {
+			const float qx = x[i] - origin.x;
+			const float qy = y[i] - origin.y;
+			const float qz = z[i] - origin.z;
+			const float cx = qy * direction.z - qz * direction.y;
+			const float cy = qz * direction.x - qx * direction.z;
+			const float cz = qx * direction.y - qy * direction.x;
+			return cx * cx + cy * cy + cz * cz;
+		};
+
+		size_t i = begin;
+
+		for(;i + LANES <= end;i += LANES) {
+			for(size_t l = 0;l < LANES;++l) {
+				const float d = distanceOf(i + l);
+				const bool greater = d > lmax[l];
+				lmax[l] = greater ? d : lmax[l];
+				limax[l] = greater ? (uint32_t)(i + l) : limax[l];
+			}
+		}
+
+		distance2 = -FLT_MAX;
+		farthest = (uint32_t)begin;
+
+		for(size_t l = 0;l < LANES;++l) {
+			if(lmax[l] > distance2 || (lmax[l] == distance2 && limax[l] < farthest)) {
+				distance2 = lmax[l];
+				farthest = limax[l];
+			}
+		}
+
+		for(;i < end;++i) {
+			const float d = distanceOf(i);
+			if(d > distance2) {
+				distance2 = d;
+				farthest = (uint32_t)i;
+			}
+		}
+	}
+
+	static void findExtents(const PositionStream& positions, const Vector3* directions, uint32_t count, Extent* extents) {
+
+		const size_t chunks = JobSystem::chunkCount(positions.size(), CHUNK_SIZE);
+		ArrayList<Extent> chunkExtents(chunks * count);
+
+		JobSystem::parallelFor(positions.size(), CHUNK_SIZE, [&](size_t chunk, size_t begin, size_t end) {
+			projectExtents(positions, directions, count, begin, end, &chunkExtents[chunk * count]);
+		});
+
+		for(uint32_t j = 0;j < count;++j) {
+			extents[j] = Extent();
+			for(size_t chunk = 0;chunk < chunks;++chunk) {
+				const Extent& e = chunkExtents[chunk * count + j];
+				extents[j].merge(e.min, e.imin, e.max, e.imax);
+			}
+		}
+	}
+
+	static void findRanges(const PositionStream& positions, const Vector3* directions, uint32_t count, Range<float>* ranges) {
+
+		const size_t chunks = JobSystem::chunkCount(positions.size(), CHUNK_SIZE);
+		ArrayList<Range<float>> chunkRanges(chunks * count, {FLT_MAX, -FLT_MAX});
+
+		JobSystem::parallelFor(positions.size(), CHUNK_SIZE, [&](size_t chunk, size_t begin, size_t end) {
+			projectRanges(positions, directions, count, begin, end, &chunkRanges[chunk * count]);
+		});
+
+		for(uint32_t j = 0;j < count;++j) {
+			ranges[j] = {FLT_MAX, -FLT_MAX};
+			for(size_t chunk = 0;chunk < chunks;++chunk) {
+				ranges[j].min = std::min(ranges[j].min, chunkRanges[chunk * count + j].min);
+				ranges[j].max = std::max(ranges[j].max, chunkRanges[chunk * count + j].max);
+			}
+		}
+	}
+
+	static uint32_t findFarthestFromLine(const PositionStream& positions, const Vector3& origin, const Vector3& direction) {
+
+		const size_t chunks = JobSystem::chunkCount(positions.size(), CHUNK_SIZE);
+		ArrayList<float> chunkDistances(chunks);
+		ArrayList<uint32_t> chunkFarthest(chunks);
+
+		JobSystem::parallelFor(positions.size(), CHUNK_SIZE, [&](size_t chunk, size_t begin, size_t end) {
+			projectFarthestFromLine(positions, origin, direction, begin, end, chunkDistances[chunk], chunkFarthest[chunk]);
+		});
+
+		uint32_t farthest = 0;
+		float distance2 = -FLT_MAX;
+		for(size_t chunk = 0;chunk < chunks;++chunk) {
+			if(chunkDistances[chunk] > distance2) {
+				distance2 = chunkDistances[chunk];
+				farthest = chunkFarthest[chunk];
+			}
+		}
+
+		return farthest;
+	}
+
+	static float calculateDiameter(const PositionStream& positions, uint32_t& min, uint32_t& max) {
+
+		constexpr uint32_t kDirectionCount = 13;
+
+		static const Vector3 direction[kDirectionCount] = {
+				{1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+				{1, 1, 0}, {1, 0, 1}, {0, 1, 1},
+				{1, -1, 0}, {1, 0, -1}, {0, 1, -1},
+				{1, 1, 1}, {1, -1, 1}, {1, 1, -1}, {1, -1, -1}
+		};
+
+		// Find min and max dot products for each direction and record vertex indices
+		Extent extents[kDirectionCount];
+		findExtents(positions, direction, kDirectionCount, extents);
+
+		// Find direction for which vertices at min and max extents are furthest apart
+		float d2 = length2(positions[extents[0].imax] - positions[extents[0].imin]);
+		uint32_t k = 0;
+		for(uint32_t j = 1;j < kDirectionCount;++j) {
+			float m2 = length2(positions[extents[j].imax] - positions[extents[j].imin]);
+			if(m2 > d2) {
+				d2 = m2;
+				k = j;
+			}
+		}
+
+		min = extents[k].imin;
+		max = extents[k].imax;
+
+		return d2;
+	}
+
+	static Vector3 makePerpendicularVector(const Vector3& v) {
+		float x = fabs(v.x);
+		float y = fabs(v.y);
+		float z = fabs(v.z);
+		if(z < glm::min(x, y)) return Vector3(v.y, -v.x, 0.0f);
+		if(y < x) return Vector3(-v.z, 0, v.x);
+		return {0, v.z, -v.y};
+	}
+
+	static void calculateSecondaryDiameter(const PositionStream& positions, const Vector3& axis, uint32_t& min, uint32_t& max) {
+
+		constexpr uint32_t kDirectionCount = 4;
+		static const Vector2 direction[kDirectionCount] = {
+				{1, 0}, {0, 1}, {1, 1}, {1, -1}
+		};
+
+		// Create vectors x and y perpendicular to the primary axis
+		Vector3 x = makePerpendicularVector(axis);
+		Vector3 y = cross(axis, x);
+
+		Vector3 directions[kDirectionCount];
+		for(uint32_t j = 0;j < kDirectionCount;++j) {
+			directions[j] = x * direction[j].x + y * direction[j].y;
+		}
+
+		Extent extents[kDirectionCount];
+		findExtents(positions, directions, kDirectionCount, extents);
+
+		// Find diameter in plane perpendicular to primary axis
+		Vector3 dv = positions[extents[0].imax] - positions[extents[0].imin];
+		float d2 = length2(dv - axis * dot(dv, axis));
+		uint32_t k = 0;
+
+		for(uint32_t j = 1;j < kDirectionCount;++j) {
+			dv = positions[extents[j].imax] - positions[extents[j].imin];
+			float m2 = length2(dv - axis * dot(dv, axis));
+			if(m2 > d2) {
+				d2 = m2;
+				k = j;
+			}
+		}
+
+		min = extents[k].imin;
+		max = extents[k].imax;
+	}
+
+	static void findExtremalVertices(const PositionStream& positions, const Vector3& normal, uint32_t& e, uint32_t& f) {
+		Extent extent;
+		findExtents(positions, &normal, 1, &extent);
+		e = extent.imin;
+		f = extent.imax;
+	}
+
+	static void getPrimaryBoxDirections(const PositionStream& positions, uint32_t min, uint32_t max, Vector3 direction[9]) {
+
+		direction[0] = positions[max] - positions[min];
+
+		const uint32_t c = findFarthestFromLine(positions, positions[min], direction[0]);
+
+		direction[1] = positions[c] - positions[min];
+		direction[2] = positions[c] - positions[max];
+
+		uint32_t e, f;
+		findExtremalVertices(positions, cross(direction[0], direction[1]), e, f);
+
+		direction[3] = positions[e] - positions[min];
+		direction[4] = positions[e] - positions[max];
+
+		direction[5] = positions[e] - positions[c];
+		direction[6] = positions[f] - positions[min];
+
+		direction[7] = positions[f] - positions[max];
+		direction[8] = positions[f] - positions[c];
+	}
+
+	static void getSecondaryBoxDirections(const PositionStream& positions, const Vector3& axis, uint32_t min, uint32_t max, Vector3 direction[5]) {
+
+		direction[0] = positions[max] - positions[min];
+
+		uint32_t e, f;
+		findExtremalVertices(positions, cross(axis, direction[0]), e, f);
+
+		direction[1] = positions[e] - positions[min];
+		direction[2] = positions[e] - positions[max];
+
+		direction[3] = positions[f] - positions[min];
+		direction[4] = positions[f] - positions[max];
+
+		for(int32_t j = 0;j < 5;++j) {
+			direction[j] -= axis * dot(direction[j], axis);
+		}
+	}
+
+	struct BoxCandidate {
+		// One-eighth of the surface area
+		float area{FLT_MAX};
+		Vector3 center{0, 0, 0};
+		Vector3 size{0, 0, 0};
+		Vector3 axis[3]{};
+	};
+
+	// Best box among the 5 candidates for the secondary axis, for the given primary axis
+	static BoxCandidate fitBox(const PositionStream& positions, const Vector3& s) {
+
+		uint32_t a, b;
+		Vector3 secondaryDirections[5];
+
+		calculateSecondaryDiameter(positions, s, a, b);
+		getSecondaryBoxDirections(positions, s, a, b, secondaryDirections);
+
+		// The primary axis, then the t and u axes of each candidate
+		Vector3 directions[11];
+		directions[0] = s;
+		for(int32_t j = 0;j < 5;++j) {
+			Vector3 t = normalize(secondaryDirections[j]);
+			directions[1 + j * 2] = t;
+			directions[2 + j * 2] = cross(s, t);
+		}
+
+		Range<float> ranges[11];
+		findRanges(positions, directions, 11, ranges);
+
+		BoxCandidate best;
+
+		for(int32_t j = 0;j < 5;++j) {
+
+			const Vector3& t = directions[1 + j * 2];
+			const Vector3& u = directions[2 + j * 2];
+
+			const Range<float>& rs = ranges[0];
+			const Range<float>& rt = ranges[1 + j * 2];
+			const Range<float>& ru = ranges[2 + j * 2];
+
+			float hx = (rs.max - rs.min) * 0.5f;
+			float hy = (rt.max - rt.min) * 0.5f;
+			float hz = (ru.max - ru.min) * 0.5f;
+
+			float m = hx * hy + hy * hz + hz * hx;
+			if(m < best.area) {
+				best.center = (s * (rs.min + rs.max) + t * (rt.min + rt.max) + u * (ru.min + ru.max)) * 0.5f;
+				best.size = {hx, hy, hz};
+				best.axis[0] = s;
+				best.axis[1] = t;
+				best.axis[2] = u;
+				best.area = m;
+			}
+		}
+
+		return best;
+	}
+
+	BoundingSphere BoundingVolumeFitting::sphere(const PositionStream& positions) {
+
+		BoundingSphere sphere;
+		if(positions.size() == 0) return sphere;
+
+		// Determine initial center and radius
+		uint32_t min, max;
+		float diameter = calculateDiameter(positions, min, max);
+		Vector3 center = (positions[min] + positions[max]) * 0.5f;
+		float radius = sqrt(diameter) * 0.5f;
+
+		// Make pass through vertices and adjust sphere as necessary. Each step depends on the previous one
+		for(size_t i = 0;i < positions.size();++i) {
+
+			Vector3 position = positions[i];
+
+			Vector3 pv = position - center;
+			float m2 = length2(pv);
+			if(m2 > radius * radius) {
+				Vector3 q = center - (pv * (radius / sqrt(m2)));
+				center = (q + position) * 0.5f;
+				radius = length(q - center);
+			}
+		}
+
+		sphere.center = center;
+		sphere.radius = radius;
+
+		return sphere;
+	}
+
+	AxisAlignedBoundingBox BoundingVolumeFitting::aabb(const PositionStream& positions) {
+
+		AABB aabb;
+		aabb.center = {0, 0, 0};
+		aabb.size = {0, 0, 0};
+
+		if(positions.size() == 0) return aabb;
+
+		static const Vector3 axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+
+		Range<float> ranges[3];
+		findRanges(positions, axes, 3, ranges);
+
+		Vector3 vmin = {ranges[0].min, ranges[1].min, ranges[2].min};
+		Vector3 vmax = {ranges[0].max, ranges[1].max, ranges[2].max};
+
+		aabb.center = (vmin + vmax) * 0.5f;
+		aabb.size = (vmax - vmin) * 0.5f;
+
+		return aabb;
+	}
+
+	OrientedBoundingBox BoundingVolumeFitting::obb(const PositionStream& positions) {
+
+		constexpr uint32_t kPrimaryDirectionCount = 9;
+
+		OBB obb;
+		obb.center = {0, 0, 0};
+		obb.size = {0, 0, 0};
+		obb.xAxis = {1, 0, 0};
+		obb.yAxis = {0, 1, 0};
+		obb.zAxis = {0, 0, 1};
+
+		if(positions.size() == 0) return obb;
+
+		uint32_t a, b;
+		Vector3 primaryDirections[kPrimaryDirectionCount];
+
+		calculateDiameter(positions, a, b);
+		getPrimaryBoxDirections(positions, a, b, primaryDirections);
+
+		BoxCandidate candidates[kPrimaryDirectionCount];
+
+		JobSystem::parallelFor(kPrimaryDirectionCount, 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t k = begin;k < end;++k) {
+				candidates[k] = fitBox(positions, normalize(primaryDirections[k]));
+			}
+		});
+
+		const BoxCandidate* best = nullptr;
+		for(const BoxCandidate& candidate : candidates) {
+			if(best == nullptr || candidate.area < best->area) best = &candidate;
+		}
+
+		// Degenerate geometry (a single point or a line) gives no valid axes
+		if(best->area == FLT_MAX) {
+			AABB aabb = BoundingVolumeFitting::aabb(positions);
+			obb.center = aabb.center;
+			obb.size = aabb.size * 2.0f;
+			return obb;
+		}
+
+		obb.center = best->center;
+		obb.size = best->size * 2.0f;
+		obb.xAxis = best->axis[0];
+		obb.yAxis = best->axis[1];
+		obb.zAxis = best->axis[2];
+
+		return obb;
+	}
+}
\ No newline at end of file
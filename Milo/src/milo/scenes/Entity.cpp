@@ -53,6 +53,7 @@ namespace milo {
 
 	void Entity::setName(const String& name) {
 		getComponent<EntityBasicInfo>().m_Name = name;
+		m_Scene->recordHierarchyChange(SceneHierarchyChange::Type::Renamed, m_Id);
 	}
 
 	bool Entity::hasParent() const {
@@ -69,6 +70,7 @@ namespace milo {
 		if(isAncestorOf(parentId) || isDescendantOf(parentId)) return;
 		EntityBasicInfo& relationships = getComponent<EntityBasicInfo>();
 		relationships.m_ParentId = parentId;
+		m_Scene->recordHierarchyChange(SceneHierarchyChange::Type::Reparented, m_Id);
 	}
 
 	const ArrayList<EntityId>& Entity::children() const {
@@ -91,6 +93,7 @@ namespace milo {
 			oldParent.removeChild(childId);
 		}
 		childRelationships.m_ParentId = id();
+		m_Scene->recordHierarchyChange(SceneHierarchyChange::Type::Reparented, childId);
 	}
 
 	void Entity::removeChild(EntityId childId) {
@@ -99,6 +102,7 @@ namespace milo {
 		relationships.m_Children.erase(std::find(relationships.m_Children.begin(), relationships.m_Children.end(), childId));
 		Entity child = {childId, m_Scene};
 		child.getComponent<EntityBasicInfo>().m_ParentId = NULL_ENTITY;
+		m_Scene->recordHierarchyChange(SceneHierarchyChange::Type::Reparented, childId);
 	}
 
 	void Entity::removeAllChildren() {
@@ -106,6 +110,7 @@ namespace milo {
 		for(auto childId : relationships.m_Children) {
 			Entity child = {childId, m_Scene};
 			child.getComponent<EntityBasicInfo>().m_ParentId = NULL_ENTITY;
+			m_Scene->recordHierarchyChange(SceneHierarchyChange::Type::Reparented, childId);
 		}
 		relationships.m_Children.clear();
 	}
@@ -0,0 +1,32 @@
+#include "milo/scenes/EntityCommandBuffer.h"
+#include "milo/scenes/Scene.h"
+#include "milo/scenes/Entity.h"
+
+namespace milo {
+
+	void EntityCommandBuffer::createEntity(const String& name, Function<void, Scene*, EntityId> onCreated) {
+		m_Commands.push_back([name, onCreated = std::move(onCreated)](Scene* scene, ECSRegistry&) {
+			Entity entity = scene->createEntity(name);
+			if(onCreated) onCreated(scene, entity.id());
+		});
+	}
+
+	void EntityCommandBuffer::destroyEntity(EntityId entityId) {
+		m_Commands.push_back([entityId](Scene* scene, ECSRegistry&) {
+			scene->destroyEntity(entityId);
+		});
+	}
+
+	bool EntityCommandBuffer::empty() const {
+		return m_Commands.empty();
+	}
+
+	void EntityCommandBuffer::apply(Scene* scene, ECSRegistry& registry) {
+		// Commands recorded while applying these ones are left for the next time
+		ArrayList<Function<void, Scene*, ECSRegistry&>> commands = std::move(m_Commands);
+		m_Commands.clear();
+		for(auto& command : commands) {
+			command(scene, registry);
+		}
+	}
+}
\ No newline at end of file
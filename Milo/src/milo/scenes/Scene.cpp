@@ -1,17 +1,33 @@
 #include "milo/scenes/Scene.h"
 #include "milo/scenes/SceneManager.h"
 #include "milo/scenes/Entity.h"
-#include "milo/graphics/Window.h"
+#include "milo/graphics/Graphics.h"
+#include "milo/common/JobSystem.h"
+#include "milo/time/Profiler.h"
 
 namespace milo {
 
+	// Scripts are cheap individually, so each chunk runs a fair amount of them
+	static const size_t SCRIPTS_PER_CHUNK = 64;
+
+	// Past this, nobody is reading the changes or they are so many that reading the hierarchy again is as cheap
+	static const size_t MAX_HIERARCHY_CHANGES = 16 * 1024;
+
+	// Command buffer of the chunk the current thread is running, if any
+	static thread_local EntityCommandBuffer* t_ChunkCommands = nullptr;
+
+	// Headless applications and tools (milo_bench) create scenes without a window
+	static Size windowSize() {
+		return Graphics::renderTargetSize();
+	}
+
 	Scene::Scene(const String& name) : m_Name(name) {
-		Size size = Window::get()->size();
+		Size size = windowSize();
 		m_Viewport = {0, 0, (float)size.width, (float)size.height};
 	}
 
 	Scene::Scene(String&& name) : m_Name(std::move(name)) {
-		Size size = Window::get()->size();
+		Size size = windowSize();
 		m_Viewport = {0, 0, (float)size.width, (float)size.height};
 	}
 
@@ -29,6 +45,7 @@ namespace milo {
 		const EntityId newId = m_Registry.create();
 		Entity entity = {newId, this};
 		entity.setName(name);
+		recordHierarchyChange(SceneHierarchyChange::Type::Created, newId);
 		return entity;
 	}
 
@@ -51,6 +68,7 @@ namespace milo {
 		}
 
 		m_Registry.destroy(entityId);
+		recordHierarchyChange(SceneHierarchyChange::Type::Destroyed, entityId);
 	}
 
 	Entity Scene::cameraEntity() noexcept {
@@ -91,39 +109,142 @@ namespace milo {
 
 	void Scene::update() {
 
-		Size size = Window::get()->size();
+		Size size = windowSize();
 		m_Viewport = {0, 0, (float)size.width, (float)size.height};
 
-		if(m_SkyEntity != NULL_ENTITY) {
-			SkyboxView* skyboxView = this->skyboxView();
-			if(skyboxView->type == SkyType::Dynamic) {
-				PreethamSky* sky = (PreethamSky*)skyboxView->skybox;
-				if(sky->dirty()) {
-					sky->update();
-				}
-			}
-		}
-
 		if(getSimulationState() == SimulationState::Editor) return;
 
-		auto nativeScripts = m_Registry.view<NativeScriptView>();
-		for(EntityId entity : nativeScripts) {
-			auto& nativeScriptView = m_Registry.get<NativeScriptView>(entity);
-			nativeScriptView.createIfNotExists(entity);
-			nativeScriptView.script->onUpdate(entity);
-		}
+		runScripts(false);
 	}
 
 	void Scene::lateUpdate() {
 
 		if(getSimulationState() == SimulationState::Editor) return;
 
+		runScripts(true);
+	}
+
+	static void runScript(NativeScript* script, EntityId entity, bool lateUpdate) {
+		if(lateUpdate) {
+			script->onLateUpdate(entity);
+		} else {
+			script->onUpdate(entity);
+		}
+	}
+
+	void Scene::runScripts(bool lateUpdate) {
+
+		MILO_PROFILE_FUNCTION;
+
+		ArrayList<std::pair<EntityId, NativeScript*>> scripts;
+
+		// Created up front on the main thread, since onCreate is free to change the registry
 		const ECSComponentView<NativeScriptView> nativeScripts = m_Registry.view<NativeScriptView>();
 		for(EntityId entity : nativeScripts) {
 			auto& nativeScriptView = m_Registry.get<NativeScriptView>(entity);
 			nativeScriptView.createIfNotExists(entity);
-			nativeScriptView.script->onLateUpdate(entity);
+			scripts.emplace_back(entity, nativeScriptView.script);
+		}
+
+		if(m_ScriptSchedulingMode == ScriptSchedulingMode::Serial) {
+			for(auto& [entity, script] : scripts) {
+				runScript(script, entity, lateUpdate);
+			}
+		} else {
+			runScriptsInParallel(scripts, lateUpdate);
+		}
+
+		applyCommands();
+	}
+
+	void Scene::runScriptsInParallel(ArrayList<std::pair<EntityId, NativeScript*>>& scripts, bool lateUpdate) {
+
+		struct ScriptGroup {
+			ScriptAccess access;
+			ArrayList<std::pair<EntityId, NativeScript*>> scripts;
+		};
+
+		ArrayList<ScriptGroup> groups;
+
+		// Exclusive scripts, and the ones that read what they write, cannot run alongside other instances
+		for(auto& [entity, script] : scripts) {
+
+			const ScriptAccess access = script->access();
+
+			if(access.conflicts(access)) {
+				runScript(script, entity, lateUpdate);
+				continue;
+			}
+
+			auto group = std::find_if(groups.begin(), groups.end(), [&](const ScriptGroup& g) {return g.access == access;});
+			if(group == groups.end()) {
+				groups.push_back({access, {}});
+				group = groups.end() - 1;
+			}
+			group->scripts.emplace_back(entity, script);
+		}
+
+		// The exclusive scripts may have destroyed entities or replaced their scripts
+		for(ScriptGroup& group : groups) {
+			auto removed = std::remove_if(group.scripts.begin(), group.scripts.end(), [&](const std::pair<EntityId, NativeScript*>& entry) {
+				const auto* view = m_Registry.valid(entry.first) ? m_Registry.try_get<NativeScriptView>(entry.first) : nullptr;
+				return view == nullptr || view->script != entry.second;
+			});
+			group.scripts.erase(removed, group.scripts.end());
+		}
+
+		// Groups that do not conflict with each other share a phase. Phases run one after the other
+		ArrayList<ArrayList<uint32_t>> phases;
+		for(uint32_t i = 0;i < groups.size();++i) {
+			auto phase = std::find_if(phases.begin(), phases.end(), [&](const ArrayList<uint32_t>& p) {
+				return std::none_of(p.begin(), p.end(), [&](uint32_t other) {return groups[i].access.conflicts(groups[other].access);});
+			});
+			if(phase == phases.end()) {
+				phases.emplace_back();
+				phase = phases.end() - 1;
+			}
+			phase->push_back(i);
 		}
+
+		for(const ArrayList<uint32_t>& phase : phases) {
+
+			ArrayList<std::pair<EntityId, NativeScript*>> phaseScripts;
+			for(uint32_t group : phase) {
+				phaseScripts.insert(phaseScripts.end(), groups[group].scripts.begin(), groups[group].scripts.end());
+			}
+
+			// Commands are applied later in chunk order, so the result does not depend on which thread ran each chunk
+			const size_t firstChunk = m_ChunkCommands.size();
+			m_ChunkCommands.resize(firstChunk + JobSystem::chunkCount(phaseScripts.size(), SCRIPTS_PER_CHUNK));
+
+			JobSystem::parallelFor(phaseScripts.size(), SCRIPTS_PER_CHUNK, [&](size_t chunk, size_t begin, size_t end) {
+				t_ChunkCommands = &m_ChunkCommands[firstChunk + chunk];
+				for(size_t i = begin;i < end;++i) {
+					runScript(phaseScripts[i].second, phaseScripts[i].first, lateUpdate);
+				}
+				t_ChunkCommands = nullptr;
+			});
+		}
+	}
+
+	void Scene::applyCommands() {
+		m_Commands.apply(this, m_Registry);
+		for(EntityCommandBuffer& commands : m_ChunkCommands) {
+			commands.apply(this, m_Registry);
+		}
+		m_ChunkCommands.clear();
+	}
+
+	EntityCommandBuffer& Scene::commands() {
+		return t_ChunkCommands != nullptr ? *t_ChunkCommands : m_Commands;
+	}
+
+	ScriptSchedulingMode Scene::scriptSchedulingMode() const {
+		return m_ScriptSchedulingMode;
+	}
+
+	void Scene::setScriptSchedulingMode(ScriptSchedulingMode mode) {
+		m_ScriptSchedulingMode = mode;
 	}
 
 	bool Scene::focused() const {
@@ -133,4 +254,22 @@ namespace milo {
 	void Scene::setFocused(bool focused) {
 		m_Focused = focused;
 	}
+
+	bool Scene::consumeHierarchyChanges(ArrayList<SceneHierarchyChange>& changes) {
+		const bool complete = !m_HierarchyChangesLost;
+		changes.clear();
+		std::swap(changes, m_HierarchyChanges);
+		m_HierarchyChangesLost = false;
+		return complete;
+	}
+
+	void Scene::recordHierarchyChange(SceneHierarchyChange::Type type, EntityId entityId) {
+		if(m_HierarchyChangesLost) return;
+		if(m_HierarchyChanges.size() == MAX_HIERARCHY_CHANGES) {
+			m_HierarchyChanges.clear();
+			m_HierarchyChangesLost = true;
+			return;
+		}
+		m_HierarchyChanges.push_back({type, entityId});
+	}
 }
@@ -1,14 +1,48 @@
 #include "milo/scenes/SceneManager.h"
+#include "milo/scenes/SceneSnapshot.h"
+#include "milo/graphics/rendering/FramePipeline.h"
 #include "milo/time/Profiler.h"
 
 namespace milo {
 
 	Scene* SceneManager::s_ActiveScene = nullptr;
+	ArrayList<Future<bool>> SceneManager::s_PendingSaves;
 
 	Scene* SceneManager::activeScene() {
 		return s_ActiveScene;
 	}
 
+	bool SceneManager::load(const String& filename) {
+
+		MILO_PROFILE_FUNCTION;
+
+		// Loading may create graphics resources, and the render thread may still be reading the current scene
+		FramePipeline::flush();
+
+		Scene* scene = SceneSnapshot::load(filename);
+
+		if(scene == nullptr) return false;
+
+		DELETE_PTR(s_ActiveScene);
+		s_ActiveScene = scene;
+
+		return true;
+	}
+
+	void SceneManager::save(const String& filename) {
+
+		MILO_PROFILE_FUNCTION;
+
+		auto isDone = [](const Future<bool>& future) {
+			return future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+		};
+		s_PendingSaves.erase(std::remove_if(s_PendingSaves.begin(), s_PendingSaves.end(), isDone), s_PendingSaves.end());
+
+		s_PendingSaves.push_back(std::async(std::launch::async, [snapshot = SceneSnapshot(s_ActiveScene), filename]() {
+			return snapshot.write(filename);
+		}));
+	}
+
 	void SceneManager::update() {
 		MILO_PROFILE_FUNCTION;
 		s_ActiveScene->update();
@@ -24,6 +58,10 @@ namespace milo {
 	}
 
 	void SceneManager::shutdown() {
+		for(Future<bool>& save : s_PendingSaves) {
+			save.wait();
+		}
+		s_PendingSaves.clear();
 		DELETE_PTR(s_ActiveScene);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,480 @@
+#include "milo/scenes/SceneSnapshot.h"
+#include "milo/scenes/Entity.h"
+#include "milo/assets/AssetManager.h"
+#include "milo/io/Files.h"
+#include "milo/io/MappedFile.h"
+
+namespace milo {
+
+	static_assert(std::is_trivially_copyable_v<Camera>, "Cameras are stored as raw bytes");
+	static_assert(std::is_trivially_copyable_v<DirectionalLight>, "Directional lights are stored as raw bytes");
+	static_assert(std::is_trivially_copyable_v<PointLight>, "Point lights are stored as raw bytes");
+
+	// Sections start at multiples of this, so records can be read in place from the mapped file
+	static const uint64_t SECTION_ALIGNMENT = 16;
+
+	SceneSnapshot::SceneSnapshot(Scene* scene) {
+
+		ECSRegistry& registry = scene->registry();
+
+		m_Header.name = addString(scene->name());
+
+		ArrayList<EntityId> entities;
+		HashMap<EntityId, uint32_t> indices;
+
+		for(EntityId entity : registry.view<EntityBasicInfo>()) {
+			indices[entity] = (uint32_t)entities.size();
+			entities.push_back(entity);
+		}
+
+		auto indexOf = [&](EntityId entity) {
+			auto it = indices.find(entity);
+			return it != indices.end() ? it->second : NO_ENTITY;
+		};
+
+		m_Header.entityCount = (uint32_t)entities.size();
+		m_Header.mainCamera = indexOf(scene->m_MainCameraEntity);
+		m_Header.skyEntity = indexOf(scene->m_SkyEntity);
+
+		m_Entities.reserve(entities.size());
+		m_Transforms.reserve(entities.size());
+
+		for(EntityId entity : entities) {
+
+			const EntityBasicInfo& info = registry.get<EntityBasicInfo>(entity);
+
+			EntityRecord record{};
+			record.parent = indexOf(info.parentId());
+			record.name = addString(info.name());
+			record.firstChild = (uint32_t)m_Children.size();
+			for(EntityId child : info.children()) {
+				const uint32_t childIndex = indexOf(child);
+				if(childIndex != NO_ENTITY) m_Children.push_back(childIndex);
+			}
+			record.childCount = (uint32_t)m_Children.size() - record.firstChild;
+			m_Entities.push_back(record);
+
+			TransformRecord transformRecord{};
+			const Transform* transform = registry.try_get<Transform>(entity);
+			if(transform != nullptr) {
+				transformRecord.translation = transform->translation();
+				transformRecord.scale = transform->scale();
+				transformRecord.rotation = transform->rotation();
+			} else {
+				const Transform defaultTransform{};
+				transformRecord.translation = defaultTransform.translation();
+				transformRecord.scale = defaultTransform.scale();
+				transformRecord.rotation = defaultTransform.rotation();
+			}
+			m_Transforms.push_back(transformRecord);
+		}
+
+		for(EntityId entity : registry.view<MeshView>()) {
+			const MeshView& meshView = registry.get<MeshView>(entity);
+			MeshViewRecord record{};
+			record.entity = indexOf(entity);
+			record.mesh = addAsset(SceneAssetType::Mesh, meshView.mesh);
+			record.material = addAsset(SceneAssetType::Material, meshView.material);
+			record.opaque = meshView.opaque;
+			record.castShadows = meshView.castShadows;
+			if(record.entity != NO_ENTITY) m_MeshViews.push_back(record);
+		}
+
+		for(EntityId entity : registry.view<Camera>()) {
+			CameraRecord record{};
+			record.entity = indexOf(entity);
+			record.camera = registry.get<Camera>(entity);
+			if(record.entity != NO_ENTITY) m_Cameras.push_back(record);
+		}
+
+		for(EntityId entity : registry.view<DirectionalLight>()) {
+			DirectionalLightRecord record{};
+			record.entity = indexOf(entity);
+			record.light = registry.get<DirectionalLight>(entity);
+			if(record.entity != NO_ENTITY) m_DirectionalLights.push_back(record);
+		}
+
+		for(EntityId entity : registry.view<PointLight>()) {
+			PointLightRecord record{};
+			record.entity = indexOf(entity);
+			record.light = registry.get<PointLight>(entity);
+			if(record.entity != NO_ENTITY) m_PointLights.push_back(record);
+		}
+
+		for(EntityId entity : registry.view<SkyLight>()) {
+			const SkyLight& skyLight = registry.get<SkyLight>(entity);
+			SkyLightRecord record{};
+			record.entity = indexOf(entity);
+			record.sky = addAsset(SceneAssetType::PreethamSky, skyLight.sky);
+			record.light = skyLight.light;
+			if(record.entity != NO_ENTITY) m_SkyLights.push_back(record);
+		}
+
+		for(EntityId entity : registry.view<SkyboxView>()) {
+			const SkyboxView& skyboxView = registry.get<SkyboxView>(entity);
+			SkyboxViewRecord record{};
+			record.entity = indexOf(entity);
+			const bool preetham = skyboxView.skybox != nullptr && skyboxView.skybox == Assets::skybox().getPreethamSky();
+			record.skybox = addAsset(preetham ? SceneAssetType::PreethamSky : SceneAssetType::Skybox, skyboxView.skybox);
+			record.type = skyboxView.type;
+			record.enabled = skyboxView.enabled;
+			if(record.entity != NO_ENTITY) m_SkyboxViews.push_back(record);
+		}
+	}
+
+	uint32_t SceneSnapshot::entityCount() const {
+		return m_Header.entityCount;
+	}
+
+	template<typename T>
+	static void appendSection(ArrayList<byte_t>& data, SceneSnapshot::SectionInfo& section, const T* records, size_t count) {
+		data.resize((data.size() + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT);
+		section.offset = data.size();
+		section.size = count * sizeof(T);
+		data.resize(data.size() + section.size);
+		if(section.size > 0) memcpy(data.data() + section.offset, records, section.size);
+	}
+
+	template<typename T>
+	static void appendSection(ArrayList<byte_t>& data, SceneSnapshot::SectionInfo& section, const ArrayList<T>& records) {
+		appendSection(data, section, records.data(), records.size());
+	}
+
+	bool SceneSnapshot::write(const String& filename) const {
+
+		Header header = m_Header;
+
+		ArrayList<byte_t> data(sizeof(Header));
+		appendSection(data, header.sections[(uint32_t)Section::Strings], m_Strings.data(), m_Strings.size());
+		appendSection(data, header.sections[(uint32_t)Section::Assets], m_Assets);
+		appendSection(data, header.sections[(uint32_t)Section::Entities], m_Entities);
+		appendSection(data, header.sections[(uint32_t)Section::Children], m_Children);
+		appendSection(data, header.sections[(uint32_t)Section::Transforms], m_Transforms);
+		appendSection(data, header.sections[(uint32_t)Section::MeshViews], m_MeshViews);
+		appendSection(data, header.sections[(uint32_t)Section::Cameras], m_Cameras);
+		appendSection(data, header.sections[(uint32_t)Section::DirectionalLights], m_DirectionalLights);
+		appendSection(data, header.sections[(uint32_t)Section::PointLights], m_PointLights);
+		appendSection(data, header.sections[(uint32_t)Section::SkyLights], m_SkyLights);
+		appendSection(data, header.sections[(uint32_t)Section::SkyboxViews], m_SkyboxViews);
+		memcpy(data.data(), &header, sizeof(Header));
+
+		return Files::writeAtomically(filename, [&](OutputStream& output) {
+			output.write((const char*)data.data(), (std::streamsize)data.size());
+		});
+	}
+
+	template<typename T>
+	static bool getSection(const MappedFile& file, const SceneSnapshot::Header& header, SceneSnapshot::Section section,
+						   const T*& records, size_t& count) {
+
+		records = nullptr;
+		count = 0;
+
+		// Written by an older version with fewer sections
+		if((uint32_t)section >= header.sectionCount) return true;
+
+		const SceneSnapshot::SectionInfo& info = header.sections[(uint32_t)section];
+		if(info.size == 0) return true;
+
+		if(info.offset > file.size() || info.size > file.size() - info.offset) return false;
+		if(info.offset % alignof(T) != 0 || info.size % sizeof(T) != 0) return false;
+
+		records = reinterpret_cast<const T*>(file.data() + info.offset);
+		count = info.size / sizeof(T);
+
+		return true;
+	}
+
+	static Asset* resolveAsset(SceneAssetType type, const String& name, const String& filename) {
+		switch(type) {
+			case SceneAssetType::Mesh:
+				if(Assets::meshes().exists(name)) return Assets::meshes().find(name);
+				return filename.empty() ? nullptr : Assets::meshes().load(name, filename);
+			case SceneAssetType::Material:
+				if(Assets::materials().exists(name)) return Assets::materials().find(name);
+				return filename.empty() ? nullptr : Assets::materials().load(name, filename);
+			case SceneAssetType::Skybox:
+				if(Assets::skybox().exists(name)) return Assets::skybox().find(name);
+				// Lit with the last ready skybox until its maps are loaded or generated
+				return filename.empty() ? nullptr : Assets::skybox().loadAsync(name, filename);
+			case SceneAssetType::PreethamSky:
+				return Assets::skybox().getPreethamSky();
+		}
+		return nullptr;
+	}
+
+	Scene* SceneSnapshot::load(const String& filename) {
+
+		MappedFile file(filename);
+
+		if(!file.valid() || file.size() < sizeof(Header)) {
+			Log::error("Failed to load scene {}", filename);
+			return nullptr;
+		}
+
+		Header header{};
+		memcpy(&header, file.data(), sizeof(Header));
+
+		if(header.magic != MAGIC || header.version != VERSION) {
+			Log::error("Failed to load scene {}: unsupported format", filename);
+			return nullptr;
+		}
+
+		header.sectionCount = std::min(header.sectionCount, SECTION_COUNT);
+
+		const char* strings; size_t stringsSize;
+		const AssetRecord* assets; size_t assetCount;
+		const EntityRecord* entityRecords; size_t entityRecordCount;
+		const uint32_t* children; size_t childCount;
+		const TransformRecord* transforms; size_t transformCount;
+		const MeshViewRecord* meshViews; size_t meshViewCount;
+		const CameraRecord* cameras; size_t cameraCount;
+		const DirectionalLightRecord* dirLights; size_t dirLightCount;
+		const PointLightRecord* pointLights; size_t pointLightCount;
+		const SkyLightRecord* skyLights; size_t skyLightCount;
+		const SkyboxViewRecord* skyboxViews; size_t skyboxViewCount;
+
+		bool valid = getSection(file, header, Section::Strings, strings, stringsSize)
+				&& getSection(file, header, Section::Assets, assets, assetCount)
+				&& getSection(file, header, Section::Entities, entityRecords, entityRecordCount)
+				&& getSection(file, header, Section::Children, children, childCount)
+				&& getSection(file, header, Section::Transforms, transforms, transformCount)
+				&& getSection(file, header, Section::MeshViews, meshViews, meshViewCount)
+				&& getSection(file, header, Section::Cameras, cameras, cameraCount)
+				&& getSection(file, header, Section::DirectionalLights, dirLights, dirLightCount)
+				&& getSection(file, header, Section::PointLights, pointLights, pointLightCount)
+				&& getSection(file, header, Section::SkyLights, skyLights, skyLightCount)
+				&& getSection(file, header, Section::SkyboxViews, skyboxViews, skyboxViewCount);
+
+		const uint32_t entityCount = header.entityCount;
+
+		valid = valid && entityRecordCount == entityCount && transformCount == entityCount;
+
+		auto validString = [&](const StringRef& ref) {
+			return ref.offset <= stringsSize && ref.length <= stringsSize - ref.offset;
+		};
+		auto validEntity = [&](uint32_t entity, bool optional = false) {
+			return entity < entityCount || (optional && entity == NO_ENTITY);
+		};
+		auto toString = [&](const StringRef& ref) {
+			return String(strings + ref.offset, ref.length);
+		};
+
+		valid = valid && validString(header.name) && validEntity(header.mainCamera, true) && validEntity(header.skyEntity, true);
+
+		for(size_t i = 0;valid && i < entityRecordCount;++i) {
+			const EntityRecord& record = entityRecords[i];
+			valid = validString(record.name) && validEntity(record.parent, true)
+					&& record.firstChild <= childCount && record.childCount <= childCount - record.firstChild;
+		}
+		for(size_t i = 0;valid && i < childCount;++i) valid = validEntity(children[i]);
+
+		// Components cast the resolved assets to the type of their field, so a record must name an asset of that type
+		HashMap<uint64_t, SceneAssetType> assetTypes;
+		for(size_t i = 0;valid && i < assetCount;++i) {
+			valid = validString(assets[i].name) && validString(assets[i].filename)
+					&& (uint32_t)assets[i].type <= (uint32_t)SceneAssetType::PreethamSky;
+			assetTypes[assets[i].id] = assets[i].type;
+		}
+		auto validAsset = [&](uint64_t id, SceneAssetType type, SceneAssetType otherType) {
+			auto it = assetTypes.find(id);
+			return it == assetTypes.end() || it->second == type || it->second == otherType;
+		};
+
+		for(size_t i = 0;valid && i < meshViewCount;++i) {
+			valid = validEntity(meshViews[i].entity)
+					&& validAsset(meshViews[i].mesh, SceneAssetType::Mesh, SceneAssetType::Mesh)
+					&& validAsset(meshViews[i].material, SceneAssetType::Material, SceneAssetType::Material);
+		}
+		for(size_t i = 0;valid && i < cameraCount;++i) valid = validEntity(cameras[i].entity);
+		for(size_t i = 0;valid && i < dirLightCount;++i) valid = validEntity(dirLights[i].entity);
+		for(size_t i = 0;valid && i < pointLightCount;++i) valid = validEntity(pointLights[i].entity);
+		for(size_t i = 0;valid && i < skyLightCount;++i) {
+			valid = validEntity(skyLights[i].entity)
+					&& validAsset(skyLights[i].sky, SceneAssetType::PreethamSky, SceneAssetType::PreethamSky);
+		}
+		for(size_t i = 0;valid && i < skyboxViewCount;++i) {
+			valid = validEntity(skyboxViews[i].entity)
+					&& validAsset(skyboxViews[i].skybox, SceneAssetType::Skybox, SceneAssetType::PreethamSky)
+					&& (uint32_t)skyboxViews[i].type <= (uint32_t)SkyType::Dynamic;
+		}
+
+		// An entity has at most one component of each type, registry.insert would fail on a repeated index
+		ArrayList<bool> seen;
+		auto uniqueEntities = [&](const auto* records, size_t count) {
+			seen.assign(entityCount, false);
+			for(size_t i = 0;i < count;++i) {
+				if(seen[records[i].entity]) return false;
+				seen[records[i].entity] = true;
+			}
+			return true;
+		};
+
+		valid = valid && uniqueEntities(meshViews, meshViewCount)
+				&& uniqueEntities(cameras, cameraCount)
+				&& uniqueEntities(dirLights, dirLightCount)
+				&& uniqueEntities(pointLights, pointLightCount)
+				&& uniqueEntities(skyLights, skyLightCount)
+				&& uniqueEntities(skyboxViews, skyboxViewCount);
+
+		if(!valid) {
+			Log::error("Failed to load scene {}: the file is corrupted", filename);
+			return nullptr;
+		}
+
+		HashMap<uint64_t, Asset*> resolvedAssets;
+		for(size_t i = 0;i < assetCount;++i) {
+			const AssetRecord& record = assets[i];
+			Asset* asset = resolveAsset(record.type, toString(record.name), toString(record.filename));
+			if(asset == nullptr) Log::warn("Scene {} references missing asset {}", filename, toString(record.name));
+			resolvedAssets[record.id] = asset;
+		}
+		auto assetOf = [&](uint64_t id) {
+			auto it = resolvedAssets.find(id);
+			return it != resolvedAssets.end() ? it->second : nullptr;
+		};
+
+		Scene* scene = new Scene(toString(header.name));
+		ECSRegistry& registry = scene->registry();
+
+		ArrayList<EntityId> entities(entityCount);
+		registry.create(entities.begin(), entities.end());
+
+		auto entityOf = [&](uint32_t index) {
+			return index == NO_ENTITY ? NULL_ENTITY : entities[index];
+		};
+
+		{
+			ArrayList<EntityBasicInfo> infos(entityCount);
+			ArrayList<Transform> transformComponents(entityCount);
+
+			for(uint32_t i = 0;i < entityCount;++i) {
+				const EntityRecord& record = entityRecords[i];
+				EntityBasicInfo& info = infos[i];
+				info.m_Name = toString(record.name);
+				info.m_ParentId = entityOf(record.parent);
+				info.m_Children.reserve(record.childCount);
+				for(uint32_t c = 0;c < record.childCount;++c) {
+					info.m_Children.push_back(entities[children[record.firstChild + c]]);
+				}
+
+				Transform& transform = transformComponents[i];
+				transform.m_EntityId = entities[i];
+				transform.m_Translation = transforms[i].translation;
+				transform.m_Scale = transforms[i].scale;
+				transform.m_Rotation = transforms[i].rotation;
+			}
+
+			registry.insert<EntityBasicInfo>(entities.begin(), entities.end(), std::make_move_iterator(infos.begin()));
+			registry.insert<Transform>(entities.begin(), entities.end(), transformComponents.begin());
+		}
+
+		ArrayList<EntityId> owners;
+
+		if(meshViewCount > 0) {
+			owners.clear();
+			ArrayList<MeshView> components(meshViewCount);
+			for(size_t i = 0;i < meshViewCount;++i) {
+				const MeshViewRecord& record = meshViews[i];
+				owners.push_back(entities[record.entity]);
+				if(Asset* mesh = assetOf(record.mesh)) components[i].mesh = static_cast<Mesh*>(mesh);
+				if(Asset* material = assetOf(record.material)) components[i].material = static_cast<Material*>(material);
+				components[i].opaque = record.opaque != 0;
+				components[i].castShadows = record.castShadows != 0;
+			}
+			registry.insert<MeshView>(owners.begin(), owners.end(), components.begin());
+		}
+
+		if(cameraCount > 0) {
+			owners.clear();
+			ArrayList<Camera> components;
+			components.reserve(cameraCount);
+			for(size_t i = 0;i < cameraCount;++i) {
+				owners.push_back(entities[cameras[i].entity]);
+				components.push_back(cameras[i].camera);
+			}
+			registry.insert<Camera>(owners.begin(), owners.end(), components.begin());
+		}
+
+		if(dirLightCount > 0) {
+			owners.clear();
+			ArrayList<DirectionalLight> components;
+			components.reserve(dirLightCount);
+			for(size_t i = 0;i < dirLightCount;++i) {
+				owners.push_back(entities[dirLights[i].entity]);
+				components.push_back(dirLights[i].light);
+			}
+			registry.insert<DirectionalLight>(owners.begin(), owners.end(), components.begin());
+		}
+
+		if(pointLightCount > 0) {
+			owners.clear();
+			ArrayList<PointLight> components;
+			components.reserve(pointLightCount);
+			for(size_t i = 0;i < pointLightCount;++i) {
+				owners.push_back(entities[pointLights[i].entity]);
+				components.push_back(pointLights[i].light);
+			}
+			registry.insert<PointLight>(owners.begin(), owners.end(), components.begin());
+		}
+
+		if(skyLightCount > 0) {
+			owners.clear();
+			ArrayList<SkyLight> components(skyLightCount);
+			for(size_t i = 0;i < skyLightCount;++i) {
+				owners.push_back(entities[skyLights[i].entity]);
+				components[i].sky = static_cast<PreethamSky*>(assetOf(skyLights[i].sky));
+				components[i].light = skyLights[i].light;
+			}
+			registry.insert<SkyLight>(owners.begin(), owners.end(), components.begin());
+		}
+
+		if(skyboxViewCount > 0) {
+			owners.clear();
+			ArrayList<SkyboxView> components(skyboxViewCount);
+			for(size_t i = 0;i < skyboxViewCount;++i) {
+				owners.push_back(entities[skyboxViews[i].entity]);
+				components[i].skybox = static_cast<Skybox*>(assetOf(skyboxViews[i].skybox));
+				components[i].type = skyboxViews[i].type;
+				components[i].enabled = skyboxViews[i].enabled != 0;
+			}
+			registry.insert<SkyboxView>(owners.begin(), owners.end(), components.begin());
+		}
+
+		scene->setMainCamera(entityOf(header.mainCamera));
+		scene->setSkyEntity(entityOf(header.skyEntity));
+
+		return scene;
+	}
+
+	uint64_t SceneSnapshot::assetIdOf(SceneAssetType type, const String& name) {
+		return stableHash(name.data(), name.size(), stableHashValue(type));
+	}
+
+	SceneSnapshot::StringRef SceneSnapshot::addString(const String& str) {
+		StringRef ref{};
+		ref.offset = (uint32_t)m_Strings.size();
+		ref.length = (uint32_t)str.size();
+		m_Strings += str;
+		return ref;
+	}
+
+	uint64_t SceneSnapshot::addAsset(SceneAssetType type, const Asset* asset) {
+
+		if(asset == nullptr) return 0;
+
+		const uint64_t id = assetIdOf(type, asset->name());
+
+		if(m_AssetIndices.find(id) == m_AssetIndices.end()) {
+			AssetRecord record{};
+			record.id = id;
+			record.type = type;
+			record.name = addString(asset->name());
+			record.filename = addString(asset->filename());
+			m_AssetIndices[id] = (uint32_t)m_Assets.size();
+			m_Assets.push_back(record);
+		}
+
+		return id;
+	}
+}
\ No newline at end of file
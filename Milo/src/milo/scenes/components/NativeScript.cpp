@@ -0,0 +1,14 @@
+#include "milo/scenes/components/NativeScript.h"
+
+namespace milo {
+
+	uint32_t ScriptAccess::nextComponentIndex() {
+		static AtomicUInt s_NextIndex{0};
+		const uint32_t index = s_NextIndex++;
+		if(index >= MAX_SCRIPT_COMPONENT_TYPES) {
+			throw MILO_RUNTIME_EXCEPTION(str("Scripts cannot declare more than ") + str(MAX_SCRIPT_COMPONENT_TYPES) + " component types");
+		}
+		return index;
+	}
+
+}
\ No newline at end of file
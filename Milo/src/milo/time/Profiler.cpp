@@ -41,6 +41,9 @@ namespace milo {
 
 	void Profiler::writeHeader(Profiler::Session* session) {
 		session->output << R"({"otherData": {},"traceEvents":[)";
+		session->output << R"({"name":"process_name","ph":"M","pid":0,"args":{"name":"CPU"}},)";
+		session->output << R"({"name":"process_name","ph":"M","pid":1,"args":{"name":"GPU"}})";
+		session->count = 2;
 		session->output.flush();
 	}
 
@@ -61,11 +64,11 @@ namespace milo {
 		std::replace(name.begin(), name.end(), '"', '\'');
 
 		session->output << "{";
-		session->output << R"("cat":"function",)";
+		session->output << (result.gpu ? R"("cat":"gpu",)" : R"("cat":"function",)");
 		session->output << "\"dur\":" << (end - start) << ',';
 		session->output << R"("name":")" << name << "\",";
 		session->output << R"("ph":"X",)";
-		session->output << "\"pid\":0,";
+		session->output << "\"pid\":" << (result.gpu ? 1 : 0) << ',';
 		session->output << "\"tid\":" << result.threadId << ",";
 		session->output << "\"ts\":" << start;
 		session->output << "}";
@@ -74,11 +77,25 @@ namespace milo {
 	}
 
 	Profiler* Profiler::s_Profiler = nullptr;
+	AtomicBool Profiler::s_Enabled{true};
 
 	Profiler& Profiler::get() {
 		return *s_Profiler;
 	}
 
+	bool Profiler::enabled() {
+		return s_Enabled;
+	}
+
+	void Profiler::setEnabled(bool enabled) {
+		s_Enabled = enabled;
+	}
+
+	void Profiler::submit(const ProfileResult& result, const String& session) {
+		if(!s_Enabled || s_Profiler == nullptr) return;
+		s_Profiler->writeProfile(session, result);
+	}
+
 	void Profiler::init() {
 		s_Profiler = new Profiler();
 	}
@@ -93,6 +110,8 @@ namespace milo {
 
 	ProfileTimer::~ProfileTimer() {
 
+		if(!Profiler::enabled()) return;
+
 		ProfileResult result;
 		result.name = std::move(name);
 		result.startTime = start;
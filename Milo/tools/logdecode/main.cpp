@@ -0,0 +1,48 @@
+#include "milo/logging/BinaryLog.h"
+#include <spdlog/fmt/chrono.h>
+#include <iostream>
+#include <ctime>
+
+using namespace milo;
+
+// Expands binary structured logs (see BinaryLog.h) to text, in the same layout as the console output
+static void printMessage(const DecodedLogMessage& message) {
+
+	const auto seconds = (std::time_t)(message.time / 1000000000);
+	const auto millis = (int)((message.time / 1000000) % 1000);
+
+	std::tm time{};
+#ifdef _WIN32
+	localtime_s(&time, &seconds);
+#else
+	localtime_r(&seconds, &time);
+#endif
+
+	const auto level = spdlog::level::to_string_view(message.level);
+
+	std::cout << fmt::format("[{:%D %H:%M:%S}.{:03}][Milo][{}][thread {}]: {}\n",
+							 time, millis, fmt::string_view(level.data(), level.size()), message.threadId, message.message);
+}
+
+int main(int argc, char** argv) {
+
+	if(argc < 2) {
+		std::cerr << "Usage: milo_logdecode file.mlog..." << std::endl;
+		return 1;
+	}
+
+	int result = 0;
+
+	for(int i = 1;i < argc;++i) {
+		try {
+			BinaryLogReader::read(argv[i], printMessage);
+		} catch(const Exception& e) {
+			std::cerr << e.what() << std::endl;
+			result = 1;
+		}
+	}
+
+	std::cout.flush();
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "ShaderCooker.h"
+#include "milo/assets/shaders/ShaderManager.h"
+#include "milo/common/JobSystem.h"
+#include <iostream>
+
+namespace milo {
+
+	ShaderCooker::ShaderCooker(ShaderCookerConfig config) : m_Config(std::move(config)) {
+		if(m_Config.directories.empty()) {
+			m_Config.directories.push_back(Files::resource("shaders"));
+		}
+	}
+
+	size_t ShaderCooker::run() {
+
+		const float start = Time::millis();
+
+		ArrayList<String> shaders;
+		for(const String& directory : m_Config.directories) {
+			if(!Files::isDirectory(directory)) {
+				Log::warn("{} is not a directory", directory);
+				continue;
+			}
+			ArrayList<String> files = ShaderManager::findShaders(directory);
+			shaders.insert(shaders.end(), files.begin(), files.end());
+		}
+
+		AtomicUInt compiled{0};
+		AtomicUInt upToDate{0};
+		ArrayList<String> errors(shaders.size());
+
+		JobSystem::parallelFor(shaders.size(), 1, [&](size_t chunk, size_t begin, size_t end) {
+			for(size_t i = begin;i < end;++i) {
+				try {
+					bool cached = false;
+					ShaderManager::compileSPIRV(shaders[i], !m_Config.force, &cached);
+					if(cached) ++upToDate; else ++compiled;
+				} catch(const Exception& e) {
+					errors[i] = e.what();
+				}
+			}
+		});
+
+		size_t failed = 0;
+		for(const String& error : errors) {
+			if(error.empty()) continue;
+			Log::error("{}", error);
+			++failed;
+		}
+
+		Log::info("{} shaders compiled, {} up to date and {} failed in {} ms",
+				  compiled.load(), upToDate.load(), failed, Time::millis() - start);
+
+		return failed;
+	}
+
+	int ShaderCooker::launch(int argc, char** argv) {
+
+		ShaderCookerConfig config;
+
+		try {
+			config = parseArguments(argc, argv);
+		} catch(const Exception& e) {
+			std::cerr << e.what() << std::endl;
+			std::cerr << "Usage: milo_shaderc [--force] [directory...]" << std::endl;
+			return 1;
+		}
+
+		MiloSubSystemManager::initHeadless();
+
+		size_t failed;
+		{
+			ShaderCooker cooker(config);
+			failed = cooker.run();
+		}
+
+		MiloSubSystemManager::shutdownHeadless();
+
+		return failed == 0 ? 0 : 1;
+	}
+
+	ShaderCookerConfig ShaderCooker::parseArguments(int argc, char** argv) {
+
+		ShaderCookerConfig config;
+
+		for(int i = 1;i < argc;++i) {
+			const char* option = argv[i];
+
+			if(strcmp(option, "--force") == 0) config.force = true;
+			else if(strncmp(option, "--", 2) == 0) throw MILO_RUNTIME_EXCEPTION(str("Unknown option ") + option);
+			else config.directories.emplace_back(option);
+		}
+
+		return config;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "milo/Milo.h"
+#include "milo/core/MiloSubSystemManager.h"
+
+namespace milo {
+
+	struct ShaderCookerConfig {
+		// Directories searched recursively for shaders. Empty means resources/shaders
+		ArrayList<String> directories;
+		// Compiles every shader, even the ones whose cache entry is up to date
+		bool force = false;
+	};
+
+	// Compiles the shaders of a project in parallel into the ShaderCache, without window nor graphics context,
+	// so the engine starts without compiling any of them. Fails if any shader does not compile
+	class ShaderCooker {
+	private:
+		ShaderCookerConfig m_Config;
+	public:
+		explicit ShaderCooker(ShaderCookerConfig config);
+		// Returns the number of shaders that failed to compile
+		size_t run();
+	public:
+		static int launch(int argc, char** argv);
+		static ShaderCookerConfig parseArguments(int argc, char** argv);
+	};
+}
\ No newline at end of file
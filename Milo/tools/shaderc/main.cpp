@@ -0,0 +1,7 @@
+#include "ShaderCooker.h"
+
+using namespace milo;
+
+int main(int argc, char** argv) {
+	return ShaderCooker::launch(argc, argv);
+}
\ No newline at end of file